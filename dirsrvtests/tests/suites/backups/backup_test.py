@@ -23,6 +23,7 @@ from lib389.dbgen import dbgen_users
 from lib389.tasks import BackupTask, RestoreTask
 from lib389.config import BDB_LDBMConfig
 from lib389.idm.nscontainer import nsContainers
+from lib389.idm.user import UserAccounts
 from lib389 import DSEldif
 from lib389.utils import ds_is_older, get_default_db_lib
 from lib389.replica import ReplicationManager
@@ -359,6 +360,79 @@ def test_backup_task_after_failure(mytopo):
     assert exitCode == 0, "Backup failed. Issue #6229 may not be fixed."
 
 
+@pytest.mark.skipif(get_default_db_lib() == "bdb", reason="Not supported over bdb")
+def test_incremental_backup_chain(topo):
+    """Test that a chain of incremental backups is restored
+
+    :id: 0f4c6a2e-7d3b-4e51-9a8c-5b2e1d7f3c90
+    :setup: Standalone Instance
+    :steps:
+        1. Add users and perform a full backup
+        2. Modify the users and perform an incremental backup on the full backup
+        3. Modify the users and perform an incremental backup on the first one
+        4. Perform a compacted and compressed backup
+        5. Perform an incremental backup on the compacted backup
+        6. Perform a compressed incremental backup
+        7. Modify the users and restore the last incremental backup
+        8. Check the users
+    :expectedresults:
+        1. Success
+        2. Success, the backup has a data.mdb.incr file
+        3. Success, the backup has a data.mdb.incr file
+        4. Success, the backup has a data.mdb.gz file
+        5. The backup fails
+        6. The task is rejected, and lib389 refuses the options
+        7. Success
+        8. The users have the values of step 3
+    """
+    inst = topo.standalone
+    bakdir = inst.ds_paths.backup_dir
+    users = UserAccounts(inst, DEFAULT_SUFFIX)
+    accounts = [users.create_test_user(uid=i) for i in range(1000, 1020)]
+
+    def backup(archive, **kwargs):
+        task = inst.backup_online(archive=archive, **kwargs)
+        task.wait(timeout=120)
+        return task.get_exit_code()
+
+    for d in ('full', 'incr1', 'incr2', 'compact', 'incr3', 'incrgz'):
+        shutil.rmtree(f'{bakdir}/{d}', ignore_errors=True)
+
+    assert backup(f'{bakdir}/full') == 0
+    for account in accounts:
+        account.replace('description', 'incr1')
+    assert backup(f'{bakdir}/incr1', incremental_base=f'{bakdir}/full') == 0
+    assert os.path.isfile(f'{bakdir}/incr1/data.mdb.incr')
+    for account in accounts[:10]:
+        account.replace('description', 'incr2')
+    assert backup(f'{bakdir}/incr2', incremental_base=f'{bakdir}/incr1') == 0
+    assert os.path.isfile(f'{bakdir}/incr2/data.mdb.incr')
+    assert os.path.getsize(f'{bakdir}/incr2/data.mdb.incr') < os.path.getsize(f'{bakdir}/full/data.mdb')
+
+    assert backup(f'{bakdir}/compact', compact=True, compress=True) == 0
+    assert os.path.isfile(f'{bakdir}/compact/data.mdb.gz')
+    assert backup(f'{bakdir}/incr3', incremental_base=f'{bakdir}/compact') != 0
+
+    with pytest.raises(ldap.UNWILLING_TO_PERFORM):
+        BackupTask(inst).create(properties={'nsArchiveDir': f'{bakdir}/incrgz',
+                                            'nsArchiveIncrementalBase': f'{bakdir}/incr2',
+                                            'nsArchiveCompress': 'on'})
+    with pytest.raises(ValueError):
+        inst.backup_online(archive=f'{bakdir}/incrgz', incremental_base=f'{bakdir}/incr2', compress=True)
+    assert not os.path.exists(f'{bakdir}/incrgz')
+
+    for account in accounts:
+        account.replace('description', 'after')
+    task = inst.restore_online(f'{bakdir}/incr2')
+    task.wait(timeout=120)
+    assert task.get_exit_code() == 0
+
+    for account in accounts[:10]:
+        assert account.get_attr_val_utf8('description') == 'incr2'
+    for account in accounts[10:]:
+        assert account.get_attr_val_utf8('description') == 'incr1'
+
+
 def load_dse(inst):
     conts = nsContainers(inst, 'cn=config')
     while not event.is_set():
@@ -1096,6 +1096,76 @@ def test_basic_search_lookthroughlimit(topology_st, limit, resp, import_example_
     log.info('test_basic_search_lookthroughlimit: PASSED')
 
 
+@pytest.mark.parametrize('readahead', ('0', '32'))
+def test_basic_search_readahead(topology_st, readahead, import_example_ldif):
+    """
+    Tests that searching entries read ahead from the database returns
+    the same results as searching them from the entry cache.
+
+    :id: 94b06916-ed90-4e01-a707-6029c680f4e3
+    :parametrized: yes
+    :setup: Standalone instance, add example.ldif to the database, search filter (uid=*).
+
+    :steps:
+        1. Set nsslapd-search-readahead.
+        2. Restart the server, so the entry cache is empty.
+        3. Run a search as a low priv user.
+        4. Run the same search again, now from the entry cache.
+        5. Set lookthroughlimit to 50, restart and run the search again.
+        6. Reset lookthroughlimit and nsslapd-search-readahead to original.
+
+    :expectedresults:
+        1. Success
+        2. Success
+        3. Success, 151 entries are returned.
+        4. Success, the entries are the same as the ones of the first search.
+        5. Success, the search returns ldap.ADMINLIMIT_EXCEEDED error.
+        6. Success
+
+    """
+
+    log.info('Running test_basic_search_readahead...')
+
+    inst = topology_st.standalone
+    search_filter = "(uid=*)"
+    ldbm_config = 'cn=config,cn=ldbm database,cn=plugins,cn=config'
+
+    ra_orig = change_conf_attr(topology_st, ldbm_config, 'nsslapd-search-readahead', readahead)
+    ltl_orig = None
+
+    users = UserAccounts(inst, DEFAULT_SUFFIX, rdn=None)
+    user = users.create_test_user()
+    user.replace('userPassword', PASSWORD)
+
+    def search_as_user():
+        conn = UserAccount(inst, user.dn).bind(PASSWORD)
+        searchid = conn.search(DEFAULT_SUFFIX, ldap.SCOPE_SUBTREE, search_filter)
+        rtype, rdata = conn.result(searchid)
+        return sorted((dn.lower(), sorted((a.lower(), sorted(v)) for a, v in attrs.items()))
+                      for dn, attrs in rdata)
+
+    try:
+        inst.restart()
+        cold = search_as_user()
+        assert len(cold) == 151 #151 entries in the imported ldif file using "(uid=*)"
+        warm = search_as_user()
+        assert cold == warm
+
+        ltl_orig = change_conf_attr(topology_st, ldbm_config, 'nsslapd-lookthroughlimit', '50')
+        inst.restart()
+        with pytest.raises(ldap.ADMINLIMIT_EXCEEDED):
+            search_as_user()
+
+    finally:
+        #Cleanup
+        if ltl_orig is not None:
+            change_conf_attr(topology_st, ldbm_config, 'nsslapd-lookthroughlimit', ltl_orig)
+        change_conf_attr(topology_st, ldbm_config, 'nsslapd-search-readahead', ra_orig)
+        user.delete()
+
+    log.info('test_basic_search_readahead: PASSED')
+
+
 @pytest.fixture(scope="module")
 def add_test_entry(topology_st, request):
     # Add test entry
@@ -16,13 +16,14 @@ from lib389.utils import get_default_db_lib
 from test389.topologies import topology_st as topo
 from lib389.backend import Backends
 from lib389.idm.user import UserAccounts
-from lib389.config import BDB_LDBMConfig, LMDB_LDBMConfig
+from lib389.config import LDBMConfig, BDB_LDBMConfig, LMDB_LDBMConfig
 from lib389.tasks import ImportTask
 from lib389.dbgen import dbgen_users
 
 
 from lib389._constants import (
     DN_USERROOT_LDBM,
+    DN_MONITOR_LDBM,
     DEFAULT_SUFFIX
 )
 
@@ -736,6 +737,60 @@ def test_mdb_cache_autotune_after_import(topo):
         f"!= post-restart DN cache ({dncachememsize_after_restart})")
 
 
+def test_cache_autotune_online(topo, request):
+    """Check that the caches are rebalanced online within the autosize budget
+
+    :id: 3b9e6c41-7d2a-4f05-8e1c-5a0d9f27b6e3
+    :setup: Standalone instance
+    :steps:
+        1. Set nsslapd-cache-autotune-interval to 1 and restart
+        2. Search the users many times
+        3. Check the decisions in cn=monitor,cn=ldbm database
+        4. Check the working set estimates of userRoot
+        5. Set nsslapd-cache-autotune-interval to -1
+    :expectedresults:
+        1. Success
+        2. Success
+        3. The controller ran and the caches stay within the budget
+        4. The estimates are reported
+        5. The value is rejected
+    """
+    inst = topo.standalone
+    ldbm_config = LDBMConfig(inst)
+    ldbm_config.replace('nsslapd-cache-autotune-interval', '1')
+    inst.restart()
+
+    users = UserAccounts(inst, DEFAULT_SUFFIX)
+    created = [users.create_test_user(uid=3000 + i) for i in range(10)]
+
+    def fin():
+        for user in created:
+            user.delete()
+        ldbm_config.replace('nsslapd-cache-autotune-interval', '60')
+        inst.restart()
+
+    request.addfinalizer(fin)
+
+    for _ in range(200):
+        users.list()
+    time.sleep(3)
+
+    monitor = DSLdapObject(inst, DN_MONITOR_LDBM)
+    assert int(monitor.get_attr_val_utf8('cacheAutotuneRuns')) > 0
+    budget = int(monitor.get_attr_val_utf8('cacheAutotuneBudget'))
+    allocated = int(monitor.get_attr_val_utf8('cacheAutotuneAllocated'))
+    log.info("Cache autotune budget=%d allocated=%d decision=%s", budget, allocated,
+             monitor.get_attr_val_utf8('cacheAutotuneLastDecision'))
+    assert 0 < allocated <= budget
+
+    be_monitor = Backends(inst).get('userRoot').get_monitor()
+    assert be_monitor.get_attr_val_utf8('entryCacheWorkingSetEstimate') is not None
+    assert be_monitor.get_attr_val_utf8('dnCacheGhostHits') is not None
+
+    with pytest.raises(ldap.UNWILLING_TO_PERFORM):
+        ldbm_config.replace('nsslapd-cache-autotune-interval', '-1')
+
+
 if __name__ == '__main__':
     # Run isolated
     # -s for DEBUG mode
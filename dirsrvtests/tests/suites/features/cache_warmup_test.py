@@ -0,0 +1,94 @@
+# --- BEGIN COPYRIGHT BLOCK ---
+# Copyright (C) 2026 Red Hat, Inc.
+# All rights reserved.
+#
+# License: GPL (version 3 or any later version).
+# See LICENSE for details.
+# --- END COPYRIGHT BLOCK ---
+#
+import os
+import time
+import logging
+import pytest
+from lib389.backend import Backends
+from lib389.config import LDBMConfig
+from lib389.idm.user import UserAccounts
+from lib389._constants import DEFAULT_SUFFIX, DEFAULT_BENAME
+from test389.topologies import topology_st
+
+pytestmark = pytest.mark.tier1
+
+logging.getLogger(__name__).setLevel(logging.DEBUG)
+log = logging.getLogger(__name__)
+
+NB_USERS = 50
+
+
+def _warmup_status(inst):
+    monitor = Backends(inst).get(DEFAULT_BENAME).get_monitor()
+    return (monitor.get_attr_val_utf8('cacheWarmupState'),
+            int(monitor.get_attr_val_utf8('cacheWarmupEntries')),
+            int(monitor.get_attr_val_utf8('cacheWarmupLoaded')))
+
+
+def test_cache_warmup_reload(topology_st, request):
+    """Check that the hot entries are reloaded in the entry cache after a restart
+
+    :id: 8f2c4b17-5a6e-4d93-b0c8-e71a3d95f240
+    :setup: Standalone instance
+    :steps:
+        1. Enable nsslapd-cache-warmup, add users and read them
+        2. Restart the instance
+        3. Wait for the warmup to complete
+        4. Check the entry cache
+        5. Disable nsslapd-cache-warmup and restart the instance
+    :expectedresults:
+        1. Success
+        2. The snapshot of the entry cache is written at shutdown
+        3. The warmup state is done and the users are loaded
+        4. The users are in the entry cache before any search
+        5. No snapshot is loaded
+    """
+    inst = topology_st.standalone
+    snapshot = os.path.join(inst.ds_paths.db_dir, f'{DEFAULT_BENAME}.cachewarmup')
+
+    LDBMConfig(inst).replace('nsslapd-cache-warmup', 'on')
+    users = UserAccounts(inst, DEFAULT_SUFFIX)
+    created = [users.create_test_user(uid=4000 + i) for i in range(NB_USERS)]
+
+    def fin():
+        LDBMConfig(inst).replace('nsslapd-cache-warmup', 'off')
+        for user in created:
+            user.delete()
+
+    request.addfinalizer(fin)
+
+    for user in created:
+        user.get_attr_val_utf8('uid')
+    inst.restart()
+    assert os.path.isfile(snapshot)
+
+    for _ in range(30):
+        state, entries, loaded = _warmup_status(inst)
+        if state != 'loading':
+            break
+        time.sleep(1)
+    log.info("warmup state=%s entries=%d loaded=%d", state, entries, loaded)
+    assert state == 'done'
+    assert entries >= NB_USERS
+    assert loaded == entries
+
+    monitor = Backends(inst).get(DEFAULT_BENAME).get_monitor()
+    assert int(monitor.get_attr_val_utf8('currentEntryCacheCount')) >= NB_USERS
+
+    LDBMConfig(inst).replace('nsslapd-cache-warmup', 'off')
+    inst.restart()
+    monitor = Backends(inst).get(DEFAULT_BENAME).get_monitor()
+    assert monitor.get_attr_val_utf8('cacheWarmupState') is None
+
+
+if __name__ == '__main__':
+    # Run isolated
+    # -s for DEBUG mode
+    CURRENT_FILE = os.path.realpath(__file__)
+    pytest.main(["-s", CURRENT_FILE])
@@ -0,0 +1,93 @@
+# --- BEGIN COPYRIGHT BLOCK ---
+# Copyright (C) 2026 Red Hat, Inc.
+# All rights reserved.
+#
+# License: GPL (version 3 or any later version).
+# See LICENSE for details.
+# --- END COPYRIGHT BLOCK ---
+#
+import os
+import shutil
+import logging
+import pytest
+from lib389.config import LMDB_LDBMConfig
+from lib389.idm.user import UserAccounts
+from lib389.utils import get_default_db_lib
+from lib389._constants import DEFAULT_SUFFIX
+from test389.topologies import topology_st
+
+pytestmark = [
+    pytest.mark.tier1,
+    pytest.mark.skipif(get_default_db_lib() == "bdb", reason="MDB-specific test"),
+]
+
+logging.getLogger(__name__).setLevel(logging.DEBUG)
+log = logging.getLogger(__name__)
+
+
+@pytest.fixture(scope="function")
+def ephemeral(topology_st, request):
+    inst = topology_st.standalone
+    ephemeral_dir = os.path.join(inst.ds_paths.run_dir, f'{inst.serverid}-ephemeral-db')
+    LMDB_LDBMConfig(inst).replace('nsslapd-mdb-ephemeral-dir', ephemeral_dir)
+    inst.restart()
+
+    def fin():
+        LMDB_LDBMConfig(inst).remove_all('nsslapd-mdb-ephemeral-dir')
+        inst.restart()
+        shutil.rmtree(ephemeral_dir, ignore_errors=True)
+
+    request.addfinalizer(fin)
+    return inst, ephemeral_dir
+
+
+def test_ephemeral_db_snapshot(ephemeral):
+    """Check that an ephemeral database is reloaded from its snapshot
+
+    :id: 0d6f3b0e-8a59-4c8e-b6a3-52e1f0c7a9d4
+    :setup: Standalone instance with nsslapd-mdb-ephemeral-dir set
+    :steps:
+        1. Check that the database is in the ephemeral directory
+        2. Add a user and restart the instance
+        3. Stop the instance and remove the ephemeral directory
+        4. Start the instance
+        5. Disable the snapshot, add a user, stop the instance and
+           remove the ephemeral directory
+        6. Start the instance
+    :expectedresults:
+        1. Success
+        2. The user is still there and the snapshot is written
+        3. Success
+        4. The user is reloaded from the snapshot
+        5. Success
+        6. The user added without snapshot is lost
+    """
+    inst, ephemeral_dir = ephemeral
+    assert os.path.isfile(os.path.join(ephemeral_dir, 'data.mdb'))
+
+    users = UserAccounts(inst, DEFAULT_SUFFIX)
+    user = users.create_test_user(uid=1001)
+    inst.restart()
+    assert user.exists()
+    assert os.path.isfile(os.path.join(inst.ds_paths.db_dir, 'data.mdb'))
+
+    inst.stop()
+    shutil.rmtree(ephemeral_dir)
+    inst.start()
+    assert user.exists()
+
+    LMDB_LDBMConfig(inst).replace('nsslapd-mdb-ephemeral-snapshot', 'off')
+    lost = users.create_test_user(uid=1002)
+    inst.stop()
+    shutil.rmtree(ephemeral_dir)
+    inst.start()
+    assert user.exists()
+    assert not lost.exists()
+    LMDB_LDBMConfig(inst).replace('nsslapd-mdb-ephemeral-snapshot', 'on')
+
+
+if __name__ == '__main__':
+    # Run isolated
+    # -s for DEBUG mode
+    CURRENT_FILE = os.path.realpath(__file__)
+    pytest.main(["-s", CURRENT_FILE])
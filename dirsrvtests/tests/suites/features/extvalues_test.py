@@ -0,0 +1,106 @@
+# --- BEGIN COPYRIGHT BLOCK ---
+# Copyright (C) 2026 Red Hat, Inc.
+# All rights reserved.
+#
+# License: GPL (version 3 or any later version).
+# See LICENSE for details.
+# --- END COPYRIGHT BLOCK ---
+#
+import os
+import logging
+import pytest
+from lib389.backend import Backends
+from lib389.idm.group import Groups
+from lib389._constants import DEFAULT_SUFFIX, DEFAULT_BENAME
+from test389.topologies import topology_st
+
+pytestmark = pytest.mark.tier1
+
+logging.getLogger(__name__).setLevel(logging.DEBUG)
+log = logging.getLogger(__name__)
+
+THRESHOLD = 10
+NB_MEMBERS = 50
+
+
+def _member(i):
+    return f'uid=member{i},ou=people,{DEFAULT_SUFFIX}'
+
+
+def _members(group):
+    return sorted(v.lower() for v in group.get_attr_vals_utf8('member'))
+
+
+@pytest.fixture(scope="function")
+def extvalues(topology_st, request):
+    inst = topology_st.standalone
+    be = Backends(inst).get(DEFAULT_BENAME)
+    be.replace('nsslapd-extvalues-threshold', str(THRESHOLD))
+
+    def fin():
+        be.replace('nsslapd-extvalues-threshold', '0')
+
+    request.addfinalizer(fin)
+    return inst
+
+
+def test_extvalues_large_group(extvalues):
+    """Check that a large group stored out of id2entry keeps its members
+
+    :id: 5a0a1f64-3b9e-4d4c-9d4b-2f2b1f0a6e41
+    :setup: Standalone instance, nsslapd-extvalues-threshold set to 10
+    :steps:
+        1. Add a group with 50 members
+        2. Remove some members and add others
+        3. Restart the instance, so the group is read from the database
+        4. Search the group with a filter on a member
+        5. Export the backend
+        6. Shrink the group under the threshold and restart
+    :expectedresults:
+        1. Success
+        2. Success
+        3. The group has the expected members
+        4. The group is found
+        5. The ldif file has every member and not the internal marker
+        6. The group has the expected members
+    """
+    inst = extvalues
+    groups = Groups(inst, DEFAULT_SUFFIX)
+    expected = [_member(i) for i in range(NB_MEMBERS)]
+    group = groups.create(properties={'cn': 'extvalues_group', 'member': expected})
+    assert _members(group) == sorted(m.lower() for m in expected)
+
+    for i in range(0, NB_MEMBERS, 5):
+        group.remove('member', _member(i))
+        expected.remove(_member(i))
+    for i in range(NB_MEMBERS, NB_MEMBERS + 5):
+        group.add('member', _member(i))
+        expected.append(_member(i))
+
+    inst.restart()
+    assert _members(group) == sorted(m.lower() for m in expected)
+
+    found = groups.filter(f'(member={_member(NB_MEMBERS + 1)})')
+    assert [g.dn.lower() for g in found] == [group.dn.lower()]
+
+    ldif_file = os.path.join(inst.get_ldif_dir(), 'extvalues.ldif')
+    inst.stop()
+    assert inst.db2ldif(bename=DEFAULT_BENAME, suffixes=[DEFAULT_SUFFIX], excludeSuffixes=[],
+                        encrypt=False, repl_data=False, outputfile=ldif_file)
+    inst.start()
+    with open(ldif_file, 'r') as f:
+        content = f.read().lower()
+    assert 'extvaluesattr' not in content
+    for m in expected:
+        assert f'member: {m.lower()}' in content
+
+    group.replace('member', expected[:3])
+    inst.restart()
+    assert _members(group) == sorted(m.lower() for m in expected[:3])
+
+
+if __name__ == '__main__':
+    # Run isolated
+    # -s for DEBUG mode
+    CURRENT_FILE = os.path.realpath(__file__)
+    pytest.main(["-s", CURRENT_FILE])
@@ -449,3 +449,30 @@ def test_or_and_eq(topology_st_f):
     _check_filter(topology_st_f, '(|(&(uid=user1)(sn=1))(uid=user0))', 2, [USER0_DN, USER1_DN])
 
 
+
+
+def test_unindexed_mixed(topology_st_f):
+    """Test filter logic when the entries are tested against the whole filter
+
+    :id: 78cebce1-402b-4316-949b-8632cdc63654
+    :setup: Standalone instance with 20 test users added
+            from uid=user0 to uid=user20
+    :steps:
+         1. Search for test users with filter ``(&(homeDirectory=/home/user1*)(!(sn=1))(uid=*))``
+         2. Search for test users with filter ``(|(homeDirectory=*9)(&(homeDirectory=/home/user0)(sn>=0)))``
+         3. Search for test users with filter ``(!(|(homeDirectory=*1*)(homeDirectory=*2*)(!(homeDirectory=*))))``
+         4. Search for test users with filter ``(&(|(homeDirectory=/home/user3)(sn=4))(!(homeDirectory=*4)))``
+    :expectedresults:
+         1. There should be 10 users listed i.e. user10 to user19
+         2. There should be 3 users listed i.e. user0, user9 and user19
+         3. There should be 8 users listed i.e. user0 and user3 to user9
+         4. There should be 1 user listed i.e. user3
+    """
+    _check_filter(topology_st_f, '(&(homeDirectory=/home/user1*)(!(sn=1))(uid=*))', 10,
+                  [USER10_DN, USER11_DN, USER12_DN, USER13_DN, USER14_DN,
+                   USER15_DN, USER16_DN, USER17_DN, USER18_DN, USER19_DN])
+    _check_filter(topology_st_f, '(|(homeDirectory=*9)(&(homeDirectory=/home/user0)(sn>=0)))', 3,
+                  [USER0_DN, USER9_DN, USER19_DN])
+    _check_filter(topology_st_f, '(!(|(homeDirectory=*1*)(homeDirectory=*2*)(!(homeDirectory=*))))', 8,
+                  [USER0_DN, USER3_DN, USER4_DN, USER5_DN, USER6_DN, USER7_DN, USER8_DN, USER9_DN])
+    _check_filter(topology_st_f, '(&(|(homeDirectory=/home/user3)(sn=4))(!(homeDirectory=*4)))', 1, [USER3_DN])
@@ -0,0 +1,106 @@
+# --- BEGIN COPYRIGHT BLOCK ---
+# Copyright (C) 2026 Red Hat, Inc.
+# All rights reserved.
+#
+# License: GPL (version 3 or any later version).
+# See LICENSE for details.
+# --- END COPYRIGHT BLOCK ---
+#
+import os
+import json
+import logging
+import pytest
+from lib389.backend import Backends
+from lib389.index import Index
+from lib389.idm.user import UserAccounts
+from lib389.tasks import DBVerifyTask
+from lib389._constants import DEFAULT_SUFFIX, DEFAULT_BENAME
+from test389.topologies import topology_st
+
+pytestmark = pytest.mark.tier1
+
+logging.getLogger(__name__).setLevel(logging.DEBUG)
+log = logging.getLogger(__name__)
+
+NB_USERS = 20
+
+
+def _dbverify(inst, report, repair=False):
+    task = DBVerifyTask(inst)
+    props = {'nsInstance': DEFAULT_BENAME, 'nsReportFile': report}
+    if repair:
+        props['nsRepair'] = 'true'
+    task.create(properties=props)
+    task.wait()
+    with open(report) as f:
+        lines = [json.loads(line) for line in f]
+    os.remove(report)
+    return task.get_exit_code(), lines
+
+
+def test_dbverify_task_repair(topology_st, request):
+    """Check that the dbverify task reports and repairs the missing index keys
+
+    :id: 6a4f1d52-0c3e-4b8f-9a27-d1e5c8b3f604
+    :setup: Standalone instance
+    :steps:
+        1. Add users with a description
+        2. Add an online description index without reindexing it
+        3. Run the dbverify task
+        4. Run the dbverify task with nsRepair
+        5. Run the dbverify task again
+    :expectedresults:
+        1. Success
+        2. Success
+        3. The description keys of the users are reported missing
+        4. The missing keys are repaired
+        5. No difference is reported
+    """
+    inst = topology_st.standalone
+    report = os.path.join(inst.ds_paths.ldif_dir, 'dbverify_test.json')
+
+    users = UserAccounts(inst, DEFAULT_SUFFIX)
+    created = []
+    for i in range(NB_USERS):
+        user = users.create_test_user(uid=2000 + i)
+        user.replace('description', f'dbverify {i}')
+        created.append(user)
+
+    # A system index is online at once, so the existing entries are not indexed
+    be = Backends(inst).get(DEFAULT_BENAME)
+    index = Index(inst)
+    index.create(properties={'cn': 'description',
+                             'nsSystemIndex': 'true',
+                             'nsIndexType': 'eq'},
+                 basedn="cn=index," + be.dn)
+
+    def fin():
+        index.delete()
+        for user in created:
+            user.delete()
+
+    request.addfinalizer(fin)
+
+    rc, lines = _dbverify(inst, report)
+    missing = [l for l in lines if l.get('index') == 'description' and l.get('status') == 'missing']
+    assert rc != 0
+    assert len(missing) == NB_USERS
+    assert not any(l['repaired'] for l in missing)
+
+    rc, lines = _dbverify(inst, report, repair=True)
+    summary = [l['summary'] for l in lines if l.get('index') == 'description' and 'summary' in l]
+    assert rc == 0
+    assert summary[0]['missing'] == NB_USERS
+    assert summary[0]['repaired'] == NB_USERS
+
+    rc, lines = _dbverify(inst, report)
+    assert rc == 0
+    assert all('summary' in l for l in lines)
+    assert len(users.filter('(description=dbverify 1)')) == 1
+
+
+if __name__ == '__main__':
+    # Run isolated
+    # -s for DEBUG mode
+    CURRENT_FILE = os.path.realpath(__file__)
+    pytest.main(["-s", CURRENT_FILE])
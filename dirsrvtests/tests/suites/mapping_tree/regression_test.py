@@ -18,6 +18,7 @@ from lib389.dbgen import dbgen_users
 from lib389.mappingTree import MappingTrees
 from test389.topologies import topology_st
 from lib389.referral import Referrals, Referral
+from lib389.idm.organizationalunit import OrganizationalUnits
 
 
 try:
@@ -195,6 +196,58 @@ def test_sub_suffixes_errlog(topo):
     assert not inst.searchErrorsLog('id2entry - Could not open id2entry err 0')
 
 
+
+def test_search_fanout_on_sub_suffixes(topo, request):
+    """ Check that the backends of a search are searched in parallel
+    with the same result as when they are searched one after the other
+
+    :id: 6c1f0e52-8b7a-4d0e-9f3a-2e5d7c9b1a84
+    :feature: mapping-tree
+    :setup: Standalone instance with 3 additional backends:
+            dc=parent, dc=child1,dc=parent, dc=childr21,dc=parent
+    :steps:
+        1. Set nsslapd-search-fanout-threads to 0 and restart
+        2. Perform a SUBTREE and a ONE LEVEL search on dc=parent
+        3. Set nsslapd-search-fanout-threads to 4 and restart
+        4. Perform the same searches
+        5. Perform a SUBTREE search on dc=parent with a size limit
+    :expectedresults:
+        1. Success
+        2. Success
+        3. Success
+        4. The same entries are returned
+        5. Size limit exceeded is returned
+    """
+    inst = topo.standalone
+
+    def fin():
+        inst.config.replace('nsslapd-search-fanout-threads', '0')
+        inst.restart()
+
+    request.addfinalizer(fin)
+
+    def search_dns():
+        result = {}
+        for scope in (ldap.SCOPE_SUBTREE, ldap.SCOPE_ONELEVEL):
+            entries = inst.search_s(PARENT_SUFFIX, scope, "(objectClass=*)",
+                                    attrlist=("dn",), escapehatch='i am sure')
+            result[scope] = sorted(entry.dn.lower() for entry in entries)
+        return result
+
+    inst.config.replace('nsslapd-search-fanout-threads', '0')
+    inst.restart()
+    serial = search_dns()
+    assert len(serial[ldap.SCOPE_SUBTREE]) > len(serial[ldap.SCOPE_ONELEVEL]) > 0
+
+    inst.config.replace('nsslapd-search-fanout-threads', '4')
+    inst.restart()
+    assert search_dns() == serial
+
+    with pytest.raises(ldap.SIZELIMIT_EXCEEDED):
+        inst.search_ext_s(PARENT_SUFFIX, ldap.SCOPE_SUBTREE, "(objectClass=*)",
+                          attrlist=("dn",), sizelimit=3)
+
+
 # Parameters for test_referral_subsuffix:
 #   a tuple pair containing:
 #     -  list of referral dn that must be created
@@ -270,3 +323,45 @@ def test_referral_subsuffix(topo, request, parameters):
         assert len(found_refs) == nbref
     ldc.unbind()
 
+
+
+def test_sub_suffix_routing_after_changes(topo):
+    """Check that operations are routed to the right backend while sub suffixes
+    are added and removed
+
+    :id: 2c6a1f4e-9b3d-11f1-8e0c-482ae39447e5
+    :feature: mapping-tree
+    :setup: Standalone instance with 3 additional backends:
+            dc=parent, dc=child1,dc=parent, dc=childr21,dc=parent
+    :steps:
+        1. Add a backend for dc=child3,dc=child1,dc=parent
+        2. Add an entry below dc=child3,dc=child1,dc=parent
+        3. Search dc=child1,dc=parent subtree for that entry
+        4. Delete the dc=child3,dc=child1,dc=parent backend
+        5. Search dc=child3,dc=child1,dc=parent
+        6. Search dc=child1,dc=parent and dc=child2,dc=parent
+    :expectedresults:
+        1. Success
+        2. Success
+        3. The entry is found
+        4. Success
+        5. No such object, the dn is now handled by dc=child1,dc=parent backend
+        6. Success
+    """
+    inst = topo.standalone
+    child3_suffix = f"dc=child3,{CHILD1_SUFFIX}"
+
+    be = Backends(inst).create(properties={'nsslapd-suffix': child3_suffix,
+                                           'name': 'child3',
+                                           'sample_entries': '001004002'})
+    try:
+        OrganizationalUnits(inst, child3_suffix).create(properties={'ou': 'routed'})
+        entries = inst.search_s(CHILD1_SUFFIX, ldap.SCOPE_SUBTREE, "(ou=routed)")
+        assert [e.dn for e in entries] == [f"ou=routed,{child3_suffix}"]
+    finally:
+        be.delete()
+
+    with pytest.raises(ldap.NO_SUCH_OBJECT):
+        inst.search_s(child3_suffix, ldap.SCOPE_BASE, "(objectClass=*)")
+    for suffix in (CHILD1_SUFFIX, CHILD2_SUFFIX):
+        assert len(inst.search_s(suffix, ldap.SCOPE_BASE, "(objectClass=*)")) == 1
@@ -14,6 +14,7 @@ import threading
 import time
 from lib389.monitor import *
 from lib389.backend import Backends, DatabaseConfig
+from lib389.config import LMDB_LDBMConfig
 from lib389._constants import *
 from test389.topologies import topology_st as topo
 from lib389._mapped_object import DSLdapObjects
@@ -21,6 +22,9 @@ from lib389.utils import get_default_db_lib
 from lib389.plugins import MemberOfPlugin
 from lib389.idm.user import UserAccounts
 from lib389.idm.group import Groups
+from lib389.dbgen import dbgen_users
+from lib389.properties import TASK_WAIT
+from lib389.tasks import Tasks
 
 pytestmark = pytest.mark.tier1
 
@@ -282,6 +286,45 @@ def test_monitor_work_queue(topo):
     assert 'maxbusyworkers' in status
 
 
+def test_monitor_event_queue(topo):
+    """Verify event queue metrics are exposed via cn=monitor
+
+    :id: 3c1f7e52-9b4d-4a51-8d0e-6f2a7c9b1e43
+    :setup: Standalone Instance
+    :steps:
+        1. Query cn=monitor for the event queue attributes
+        2. Verify the lateness histogram has one value per bucket
+        3. Wait for the periodic events to be called
+        4. Verify the histogram counted them
+    :expectedresults:
+        1. Success
+        2. Success
+        3. Success
+        4. Success
+    """
+    inst = topo.standalone
+    monitor = Monitor(inst)
+
+    (eventqevents, eventqlateness, eventqmaxlatenessms) = monitor.get_event_queue()
+    assert int(eventqevents[0]) > 0, "The server always has scheduled events"
+    assert int(eventqmaxlatenessms[0]) >= 0
+
+    buckets = {}
+    for value in eventqlateness:
+        tokens = dict(token.split('=', 1) for token in value.split())
+        assert set(tokens) == {'le', 'events'}, f"Unexpected eventqlateness value {value}"
+        buckets[tokens['le']] = int(tokens['events'])
+    assert list(buckets) == ['10ms', '100ms', '1s', '10s', '60s', 'inf']
+    called_before = sum(buckets.values())
+
+    # Some events repeat every few seconds (e.g. the snmp counters update)
+    time.sleep(15)
+    (_, eventqlateness, _) = monitor.get_event_queue()
+    called_after = sum(int(value.split('events=')[1]) for value in eventqlateness)
+    log.info(f"eventqlateness={eventqlateness}")
+    assert called_after > called_before, "Expected the event callbacks to be counted"
+
+
 def test_monitor_busy_workers_concurrent(topo):
     """Verify currentbusyworkers increments under concurrent operations
 
@@ -472,6 +515,76 @@ def test_monitor_memberof(topo):
         monitor.get_status()
 
 
+@pytest.mark.skipif(get_default_db_lib() == "bdb", reason="MDB-specific test")
+def test_monitor_mdb_reader_age(topo, request):
+    """Test that a long search renews its lmdb read txn
+
+    :id: 3e9b7c14-5d2a-4f61-8c0e-a7f4b2d1c958
+    :setup: Single instance
+    :steps:
+        1. Set nsslapd-mdb-max-txn-age to a negative value
+        2. Set nsslapd-mdb-max-txn-age to 1
+        3. Import a backend with many entries
+        4. Run an unindexed search that returns no entry, so that it reads
+           every candidate in a single call, while polling the database
+           monitor
+        5. Get the database monitor
+    :expectedresults:
+        1. The value is rejected
+        2. Success
+        3. Success
+        4. The search lasts longer than the max age, the age of the oldest
+           read txn stays bounded by the max age
+        5. renewROtxn increased and no read txn is older than the max age
+    """
+    inst = topo.standalone
+    max_age = 1
+    suffix = 'dc=readerage,dc=com'
+    config = LMDB_LDBMConfig(inst)
+    with pytest.raises(ldap.UNWILLING_TO_PERFORM):
+        config.replace('nsslapd-mdb-max-txn-age', '-1')
+    config.replace('nsslapd-mdb-max-txn-age', str(max_age))
+
+    be = Backends(inst).create(properties={'nsslapd-suffix': suffix, 'name': 'readerage'})
+    ldif_file = os.path.join(inst.get_ldif_dir(), 'readerage.ldif')
+
+    def fin():
+        be.delete()
+        config.replace('nsslapd-mdb-max-txn-age', '10')
+        if os.path.exists(ldif_file):
+            os.remove(ldif_file)
+
+    request.addfinalizer(fin)
+    dbgen_users(inst, 100000, ldif_file, suffix, generic=True)
+    Tasks(inst).importLDIF(suffix, None, ldif_file, {TASK_WAIT: True})
+
+    monitor = MonitorDatabase(inst)
+    renewed_before = int(monitor.get_status()['renewrotxn'][0])
+    result = {}
+
+    def long_search():
+        start = time.monotonic()
+        result['entries'] = inst.search_s(suffix, ldap.SCOPE_SUBTREE,
+                                          '(&(objectClass=inetOrgPerson)(description=*nomatch*))')
+        result['duration'] = time.monotonic() - start
+
+    search = threading.Thread(target=long_search)
+    search.start()
+    ages = []
+    while search.is_alive():
+        ages.append(int(monitor.get_status()['oldestrotxnage'][0]))
+        time.sleep(0.2)
+    search.join()
+
+    status = monitor.get_status()
+    log.info(f'search lasted {result["duration"]:.1f}s, oldest read txn ages: {ages}, status: {status}')
+    assert result['entries'] == []
+    assert result['duration'] > max_age
+    assert max(ages) <= max_age + 1
+    assert int(status['renewrotxn'][0]) > renewed_before
+    assert int(status['oldrotxn'][0]) == 0
+
+
 if __name__ == '__main__':
     # Run isolated
     # -s for DEBUG mode
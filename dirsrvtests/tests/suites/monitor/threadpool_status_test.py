@@ -524,6 +524,43 @@ def test_monitor_attr_sanitized(topo):
         anon.close()
 
 
+def test_phase_latency(topo):
+    """Operation phase latencies are exported in cn=monitor and the status file
+
+    :id: 8f0d52c4-3a6e-4b8f-9d21-c7e4a5b61f09
+    :setup: Standalone instance
+    :steps:
+        1. Run some searches returning entries.
+        2. Read phaselatency from cn=monitor.
+        3. Wait for a heartbeat and run dsctl -j thread-pool status.
+    :expectedresults:
+        1. The searches succeed.
+        2. There is a value per phase, and the search phases were counted.
+        3. The status file has the same phases, counted as well.
+    """
+    inst = topo.standalone
+    _wait_threadpool_file(inst)
+    for _ in range(10):
+        inst.search_s(DEFAULT_SUFFIX, ldap.SCOPE_SUBTREE, "(objectclass=*)")
+
+    pattern = re.compile(r"^phase=(\w+) count=(\d+)( mean_ns=\d+ p50_ns=\d+ p90_ns=\d+ p99_ns=\d+)?$")
+    counts = {}
+    for value in Monitor(inst).get_phase_latency():
+        match = pattern.match(value)
+        assert match, value
+        counts[match.group(1)] = int(match.group(2))
+    assert set(counts) == {"queue", "preop", "candidates", "fetch", "acl", "encode", "flush"}
+    for phase in ("queue", "candidates", "fetch", "encode", "flush"):
+        assert counts[phase] > 0, f"phase {phase} was not counted"
+
+    time.sleep(2)
+    data = _json_result(_run_dsctl_threadpool(inst, json_output=True))
+    assert set(data["latency"]) == set(counts)
+    for phase in ("queue", "candidates", "fetch", "encode", "flush"):
+        assert data["latency"][phase]["count"] > 0
+        assert data["latency"][phase]["p50_ns"] <= data["latency"][phase]["p99_ns"]
+
+
 def test_feature_disabled_by_config(topo):
     """nsslapd-thread-pool-stats: off disables the diagnostics after a restart
 
@@ -7,6 +7,7 @@
 # --- END COPYRIGHT BLOCK ---
 #
 import logging
+import time
 
 import pytest
 from lib389.tasks import *
@@ -213,6 +214,116 @@ def test_pwd_scheme_no_upgrade_on_bind(topology_st, crypt_scheme, request, no_up
 
     request.addfinalizer(fin)
 
+
+def test_pwverify_cache(topology_st, request):
+    """Check that the password verification cache does not change the
+    result of the simple binds
+
+    :id: 0c3f7a7e-cb54-11f1-9d7e-02fc00000001
+    :setup: Standalone instance
+    :steps:
+        1. Enable nsslapd-pwverify-cache
+        2. Create a user and bind with its password twice
+        3. Bind with a wrong password
+        4. Change the password, bind with the old and the new password
+        5. Enable the account lockout, fail the binds until the account is locked
+        6. Bind with the right password
+    :expectedresults:
+        1. Success
+        2. Success
+        3. Server returns ldap.INVALID_CREDENTIALS
+        4. Old password is rejected, new password is accepted
+        5. Server returns ldap.INVALID_CREDENTIALS then ldap.CONSTRAINT_VIOLATION
+        6. Server returns ldap.CONSTRAINT_VIOLATION, the account is locked
+    """
+
+    standalone = topology_st.standalone
+    standalone.config.replace('nsslapd-pwverify-cache', 'on')
+    users = UserAccounts(standalone, DEFAULT_SUFFIX)
+    user = users.create_test_user(uid=2001)
+    user.set('userpassword', PASSWORD)
+
+    def fin():
+        user.delete()
+        standalone.config.replace_many(('nsslapd-pwverify-cache', 'off'),
+                                       ('passwordLockout', 'off'))
+        standalone.config.remove_all('passwordMaxFailure')
+
+    request.addfinalizer(fin)
+
+    user.bind(PASSWORD)
+    user.bind(PASSWORD)
+    with pytest.raises(ldap.INVALID_CREDENTIALS):
+        user.bind('wrong_password')
+
+    user.replace('userpassword', 'new_password')
+    with pytest.raises(ldap.INVALID_CREDENTIALS):
+        user.bind(PASSWORD)
+    user.bind('new_password')
+
+    standalone.config.replace_many(('passwordLockout', 'on'),
+                                   ('passwordMaxFailure', '2'))
+    with pytest.raises(ldap.INVALID_CREDENTIALS):
+        user.bind('wrong_password')
+    with pytest.raises(ldap.CONSTRAINT_VIOLATION):
+        user.bind('wrong_password')
+    with pytest.raises(ldap.CONSTRAINT_VIOLATION):
+        user.bind('new_password')
+
+
+def test_writebehind_retry_count(topology_st, request):
+    """Check that the buffered retry counters are visible right away,
+    lock the account, and are written at the next flush
+
+    :id: 6f2d41a4-cc1e-11f1-8a3b-02fc00000001
+    :setup: Standalone instance
+    :steps:
+        1. Set nsslapd-writebehind-interval to 5 and enable the account lockout
+        2. Create a user and fail two binds
+        3. Read passwordRetryCount
+        4. Fail the third bind, then bind with the right password
+        5. Reset the password as Directory Manager, wait for the flush
+        6. Bind with the new password and read passwordRetryCount
+    :expectedresults:
+        1. Success
+        2. Server returns ldap.INVALID_CREDENTIALS
+        3. passwordRetryCount is 2
+        4. Server returns ldap.CONSTRAINT_VIOLATION, the account is locked
+        5. Success, the buffered values do not overwrite the reset
+        6. Success, passwordRetryCount is 0
+    """
+
+    standalone = topology_st.standalone
+    standalone.config.replace_many(('nsslapd-writebehind-interval', '5'),
+                                   ('passwordLockout', 'on'),
+                                   ('passwordMaxFailure', '3'))
+    users = UserAccounts(standalone, DEFAULT_SUFFIX)
+    user = users.create_test_user(uid=2002)
+    user.set('userpassword', PASSWORD)
+
+    def fin():
+        user.delete()
+        standalone.config.replace_many(('nsslapd-writebehind-interval', '0'),
+                                       ('passwordLockout', 'off'))
+        standalone.config.remove_all('passwordMaxFailure')
+
+    request.addfinalizer(fin)
+
+    for i in range(2):
+        with pytest.raises(ldap.INVALID_CREDENTIALS):
+            user.bind('wrong_password')
+    assert user.get_attr_val_int('passwordRetryCount') == 2
+
+    with pytest.raises(ldap.CONSTRAINT_VIOLATION):
+        user.bind('wrong_password')
+    with pytest.raises(ldap.CONSTRAINT_VIOLATION):
+        user.bind(PASSWORD)
+
+    user.replace('userpassword', 'new_password')
+    time.sleep(7)
+    user.bind('new_password')
+    assert user.get_attr_val_int('passwordRetryCount') == 0
+
 if __name__ == '__main__':
     # Run isolated
     # -s for DEBUG mode
@@ -196,3 +196,65 @@ def test_dna_interval_with_different_values(topology_st, dna_plugin, attr_value)
 
         # Check that instance did not crashed
         assert topology_st.standalone.status()
+
+
+def test_dna_reserve_size(topology_st, dna_plugin):
+    """Test values are reserved in blocks when dnaReserveSize is set
+
+    :id: d7b1766e-f8dd-4643-ad46-ab0bd34f2d8a
+    :setup: Standalone Instance
+    :steps:
+        1. Set dnaReserveSize to 5
+        2. Create users that trigger DNA to assign a value
+        3. Check dnaNextValue was moved past the whole block
+        4. Add a user with an explicit value just after the block and restart
+        5. Create users that trigger DNA to assign a value
+        6. Check no value was assigned twice
+        7. Add a user with an explicit value inside the reserved block
+        8. Create a user that triggers DNA to assign a value
+    :expectedresults:
+        1. Success
+        2. Values are assigned in order using the interval
+        3. dnaNextValue is 60
+        4. Success
+        5. Unused reserved values are skipped, and the block stops
+           at the explicit value
+        6. Success
+        7. Success
+        8. The block is dropped, the explicit value is not handed out again
+    """
+    inst = topology_st.standalone
+    dna_plugin.replace('dnaReserveSize', '5')
+    users = UserAccounts(inst, DEFAULT_SUFFIX)
+
+    def add_user(name, uid_number='-1'):
+        return users.create(properties={
+            'sn': name,
+            'cn': name,
+            'uid': name,
+            'uidNumber': uid_number,
+            'gidNumber': '444',
+            'homeDirectory': f'/home/{name}'})
+
+    log.info("Check values are handed out from the reserved block")
+    assigned = []
+    for i in range(3):
+        user = add_user(f'reserve{i}')
+        assigned.append(user.get_attr_val_int('uidNumber'))
+    assert assigned == [10, 20, 30]
+    assert dna_plugin.get_attr_val_int('dnaNextValue') == 60
+
+    log.info("Restart and check the unused reserved values are skipped")
+    add_user('reserved_explicit', '70')
+    inst.restart()
+    for i in range(3, 6):
+        user = add_user(f'reserve{i}')
+        assigned.append(user.get_attr_val_int('uidNumber'))
+    assert assigned == [10, 20, 30, 60, 80, 90]
+    assert len(set(assigned)) == len(assigned)
+    assert dna_plugin.get_attr_val_int('dnaNextValue') == 130
+
+    log.info("Check a value assigned by hand inside the block is not reused")
+    add_user('reserved_manual', '100')
+    user = add_user('reserve6')
+    assert user.get_attr_val_int('uidNumber') == 130
@@ -12,6 +12,8 @@ Created on Dec 12, 2019
 @author: tbordaz
 '''
 import logging
+import os
+import time
 import pytest
 from lib389 import Entry
 from lib389.plugins import ReferentialIntegrityPlugin
@@ -142,6 +144,157 @@ def test_invalid_referint_log(topo):
     assert inst.status()
 
 
+def test_referint_coalesced_update(topo):
+    """A user referenced through several membership attributes of the same
+    entry is removed from all of them by a single delete
+
+    :id: 2d3b0c9e-8f41-4a57-9a0e-6c1f4b7d5e21
+    :setup: Standalone Instance
+    :steps:
+        1. Configure the plugin with member, uniquemember and seeAlso
+        2. Create groups referencing the user through all three attributes
+        3. Delete the user
+        4. Check that no group still references the user
+    :expectedresults:
+        1. Success
+        2. Success
+        3. Success
+        4. Success
+    """
+
+    inst = topo.standalone
+
+    plugin = ReferentialIntegrityPlugin(inst)
+    plugin.enable()
+    plugin.set_update_delay('0')
+    plugin.replace('referint-membership-attr', ['member', 'uniquemember', 'seeAlso'])
+    inst.restart()
+
+    users = UserAccounts(inst, DEFAULT_SUFFIX)
+    user = users.create_test_user(uid=2001)
+    other = users.create_test_user(uid=2002)
+
+    groups = Groups(inst, DEFAULT_SUFFIX)
+    members = []
+    for i in range(20):
+        group = groups.create(properties={'cn': 'coalesced_%d' % i})
+        group.add('objectclass', 'extensibleObject')
+        group.add('member', [user.dn, other.dn])
+        group.add('uniquemember', user.dn)
+        group.add('seeAlso', user.dn)
+        members.append(group)
+
+    user.delete()
+
+    for group in members:
+        assert not group.present('member', user.dn)
+        assert group.present('member', other.dn)
+        assert not group.present('uniquemember', user.dn)
+        assert not group.present('seeAlso', user.dn)
+
+
+def test_referint_delayed_queue(topo):
+    """Delayed updates are queued and applied in batches, and a queue written
+    by an older version (text format) is still applied at startup
+
+    :id: 5a7e9c41-0b6d-4f3e-b2a8-91d4c6e0f7a3
+    :setup: Standalone Instance
+    :steps:
+        1. Set the referint update delay and a small batch size
+        2. Add users to a group, then delete them
+        3. Wait for the delay and check the group
+        4. Stop the server and write a legacy text queue
+        5. Start the server, wait for the delay and check the group
+    :expectedresults:
+        1. Success
+        2. Success
+        3. The deleted users are no longer members
+        4. Success
+        5. The user from the legacy queue is no longer a member
+    """
+
+    inst = topo.standalone
+
+    plugin = ReferentialIntegrityPlugin(inst)
+    plugin.enable()
+    plugin.replace('referint-membership-attr', 'member')
+    plugin.set_update_delay('2')
+    plugin.set_batch_size('3')
+    logfile = plugin.get_log_file()
+    inst.restart()
+
+    users = UserAccounts(inst, DEFAULT_SUFFIX)
+    groups = Groups(inst, DEFAULT_SUFFIX)
+    group = groups.create(properties={'cn': 'delayed_group'})
+    deleted = []
+    for i in range(10):
+        user = users.create_test_user(uid=3000 + i)
+        group.add('member', user.dn)
+        deleted.append(user.dn)
+        user.delete()
+
+    time.sleep(6)
+    for dn in deleted:
+        assert not group.present('member', dn)
+    assert not os.path.exists(logfile)
+
+    kept = users.create_test_user(uid=3100)
+    group.add('member', kept.dn)
+    inst.stop()
+    with open(logfile, 'w') as log_fh:
+        log_fh.write("%s\tNULL\tNULL\tNULL\t\n" % kept.dn)
+    inst.start()
+
+    time.sleep(6)
+    assert not group.present('member', kept.dn)
+
+
+def test_referint_delayed_delete_after_modrdn(topo):
+    """A delete of a dn that an entry was moved onto after an earlier delete
+    of the same dn is still applied
+
+    :id: c3e81f52-7d09-4b6a-a5f4-2e9b0d6c18a7
+    :setup: Standalone Instance
+    :steps:
+        1. Set the referint update delay
+        2. Add two users to a group
+        3. Delete the first user, rename the second one to the dn of the
+           first one and delete it too
+        4. Wait for the delay and check the group
+    :expectedresults:
+        1. Success
+        2. Success
+        3. Success
+        4. Neither user is still a member
+    """
+
+    inst = topo.standalone
+
+    plugin = ReferentialIntegrityPlugin(inst)
+    plugin.enable()
+    plugin.replace('referint-membership-attr', 'member')
+    plugin.set_update_delay('2')
+    inst.restart()
+
+    users = UserAccounts(inst, DEFAULT_SUFFIX)
+    groups = Groups(inst, DEFAULT_SUFFIX)
+    group = groups.create(properties={'cn': 'delayed_modrdn_group'})
+    first = users.create_test_user(uid=3200)
+    second = users.create_test_user(uid=3201)
+    first_dn = first.dn
+    second_dn = second.dn
+    group.add('member', [first_dn, second_dn])
+
+    first.delete()
+    second.rename('uid=test_user_3200')
+    assert second.dn.lower() == first_dn.lower()
+    second.delete()
+
+    time.sleep(6)
+    assert not group.present('member', first_dn)
+    assert not group.present('member', second_dn)
+
+
 if __name__ == '__main__':
     # Run isolated
     # -s for DEBUG mode
@@ -68,6 +68,51 @@ def test_psearch(topology_st):
     assert(group.dn == results[0])
 
 
+def test_psearch_shared(topology_st):
+    """Check that identical persistent searches all get the changes
+
+    :id: 1f6a7b3e-2c5d-4f0b-9a8e-7d3c4b2a1e90
+    :setup: Standalone instance
+    :steps:
+        1. Open several connections running the same persistent search
+        2. Abandon the persistent search of one connection
+        3. Create a new group
+        4. Check the results of every connection
+    :expectedresults:
+        1. Operation should be successful
+        2. Operation should be successful
+        3. Group should be successfully created
+        4. Every remaining connection gets the group, the abandoned one does not
+    """
+
+    inst = topology_st.standalone
+    conns = []
+    for i in range(4):
+        conn = inst.clone()
+        conn.open()
+        msg_id = conn.search_ext(base=DEFAULT_SUFFIX, scope=ldap.SCOPE_SUBTREE, attrlist=['*'],
+                                 serverctrls=[PersistentSearchControl()])
+        _run_psearch(conn, msg_id)
+        conns.append((conn, msg_id))
+
+    abandoned_conn, abandoned_msg_id = conns.pop()
+    abandoned_conn.abandon(abandoned_msg_id)
+
+    groups = Groups(inst, DEFAULT_SUFFIX)
+    group = groups.create(properties={'cn': 'group_shared', 'description': 'testgroup'})
+
+    for conn, msg_id in conns:
+        results = _run_psearch(conn, msg_id)
+        assert group.dn in results
+        conn.abandon(msg_id)
+        conn.unbind_s()
+
+    with pytest.raises(ldap.TIMEOUT):
+        abandoned_conn.result4(msgid=abandoned_msg_id, all=0, timeout=1.0)
+    abandoned_conn.unbind_s()
+    group.delete()
+
+
 if __name__ == '__main__':
     # Run isolated
     # -s for DEBUG mode
@@ -0,0 +1,98 @@
+# --- BEGIN COPYRIGHT BLOCK ---
+# Copyright (C) 2026 Red Hat, Inc.
+# All rights reserved.
+#
+# License: GPL (version 3 or any later version).
+# See LICENSE for details.
+# --- END COPYRIGHT BLOCK ---
+
+import logging
+import os
+import ldap
+import pytest
+from test389.topologies import topology_st
+from lib389.plugins import RetroChangelogPlugin
+from lib389._constants import DEFAULT_SUFFIX, RETROCL_SUFFIX
+from lib389.idm.domain import Domain
+from lib389.backend import Backends
+from lib389._mapped_object import DSLdapObjects
+
+pytestmark = pytest.mark.tier1
+
+log = logging.getLogger(__name__)
+
+
+def _changenumbers(inst, filterstr='(changenumber=*)'):
+    changes = DSLdapObjects(inst, basedn=RETROCL_SUFFIX)
+    return sorted(int(c.get_attr_val_utf8('changenumber')) for c in changes.filter(filterstr))
+
+
+def test_retrocl_log_storage(topology_st):
+    """Test the retro changelog kept in the segmented log storage
+
+    :id: 9f2c4a1e-7d3b-4e58-a6c0-1b8e5f2d7c34
+    :setup: Standalone Instance
+    :steps:
+        1. Enable the retro changelog with nsslapd-changelog-storage: log
+        2. Check the changelog LDBM backend was not created
+        3. Do some updates
+        4. Search the changelog with a changenumber range
+        5. Check modifying a change entry is refused
+        6. Restart the instance
+        7. Check the changes and the change numbering survived the restart
+    :expectedresults:
+        1. Success
+        2. Success
+        3. Success
+        4. Only the changes in the range are returned
+        5. Operation is refused with unwilling to perform
+        6. Success
+        7. Success
+    """
+
+    inst = topology_st.standalone
+
+    log.info('Configure retrocl plugin with log storage')
+    rcl = RetroChangelogPlugin(inst)
+    rcl.replace('nsslapd-changelog-storage', 'log')
+    rcl.replace('nsslapd-changelog-segment-size', str(1024 * 1024))
+    rcl.enable()
+    inst.restart()
+
+    for be in Backends(inst).list():
+        assert be.get_attr_val_utf8_l('nsslapd-suffix') != RETROCL_SUFFIX
+    assert os.path.exists(os.path.join(inst.ds_paths.db_dir, 'retrocl', 'changelog.ldif'))
+
+    log.info('Do some updates')
+    suffix = Domain(inst, DEFAULT_SUFFIX)
+    for idx in range(0, 20):
+        suffix.replace('description', str(idx))
+
+    numbers = _changenumbers(inst)
+    assert len(numbers) >= 20
+    first = numbers[0]
+    last = numbers[-1]
+
+    log.info('Search a changenumber range')
+    ranged = _changenumbers(inst, f'(&(changenumber>={first + 5})(changenumber<={first + 9}))')
+    assert ranged == list(range(first + 5, first + 10))
+
+    log.info('Change entries are read only')
+    with pytest.raises(ldap.UNWILLING_TO_PERFORM):
+        inst.modify_s(f'changenumber={first},{RETROCL_SUFFIX}',
+                      [(ldap.MOD_REPLACE, 'changetype', b'add')])
+
+    log.info('Restart and check the log is reloaded')
+    inst.restart()
+    assert _changenumbers(inst) == numbers
+
+    suffix.replace('description', 'after restart')
+    numbers = _changenumbers(inst, f'(changenumber>={last})')
+    assert numbers == [last, last + 1]
+
+
+if __name__ == '__main__':
+    # Run isolated
+    # -s for DEBUG mode
+    CURRENT_FILE = os.path.realpath(__file__)
+    pytest.main("-s %s" % CURRENT_FILE)
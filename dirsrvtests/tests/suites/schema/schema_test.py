@@ -17,7 +17,7 @@ import ldap
 import pytest
 from ldap.cidict import cidict
 from ldap.schema import SubSchema
-from lib389.schema import SchemaLegacy
+from lib389.schema import SchemaLegacy, Schema
 from lib389._constants import *
 from test389.topologies import topology_st, topology_m2 as topo_m2
 from lib389.idm.user import UserAccounts, UserAccount
@@ -627,6 +627,68 @@ def test_definition_with_sharp(topology_st, request):
     assert inst.status()
 
 
+def test_schema_check_objectclass_changes(topology_st, request):
+    """Check that the schema check follows the changes of the objectclasses
+
+    :id: 7d9985d4-7893-4838-a1ca-a253a1389be5
+    :setup: A single instance
+    :steps:
+        1. Add an attribute type and an auxiliary objectclass allowing it
+        2. Add the attribute to a user
+        3. Add the objectclass by oid, and the attribute to the user
+        4. Replace the objectclass oid by its name in mixed case
+        5. Make the attribute required by the objectclass
+        6. Remove the attribute from the user
+        7. Remove the objectclass from the schema, and modify the user
+    :expectedresults:
+        1. Success
+        2. Fails with an objectclass violation
+        3. Success
+        4. Success
+        5. Success
+        6. Fails with an objectclass violation
+        7. Fails with an objectclass violation
+    """
+
+    inst = topology_st.standalone
+    schema = Schema(inst)
+    at = "( 1.2.3.4.5.6.7.8.9.1 NAME 'testIndexAttr' SYNTAX 1.3.6.1.4.1.1466.115.121.1.15 X-ORIGIN 'test' )"
+    oc_may = "( 1.2.3.4.5.6.7.8.9.2 NAME 'testIndexClass' SUP top AUXILIARY MAY testIndexAttr X-ORIGIN 'test' )"
+    oc_must = "( 1.2.3.4.5.6.7.8.9.2 NAME 'testIndexClass' SUP top AUXILIARY MUST testIndexAttr X-ORIGIN 'test' )"
+    users = UserAccounts(inst, DEFAULT_SUFFIX)
+    user = users.create_test_user(uid=5001)
+
+    def fin():
+        user.delete()
+        for oc in (oc_may, oc_must):
+            try:
+                schema.remove('objectClasses', oc)
+            except ldap.LDAPError:
+                pass
+        schema.remove('attributeTypes', at)
+
+    request.addfinalizer(fin)
+
+    schema.add('attributeTypes', at)
+    schema.add('objectClasses', oc_may)
+
+    with pytest.raises(ldap.OBJECT_CLASS_VIOLATION):
+        user.add('testIndexAttr', 'value')
+
+    user.add('objectClass', '1.2.3.4.5.6.7.8.9.2')
+    user.add('testIndexAttr', 'value')
+    inst.modify_s(user.dn, [(ldap.MOD_DELETE, 'objectClass', b'1.2.3.4.5.6.7.8.9.2'),
+                            (ldap.MOD_ADD, 'objectClass', b'TESTindexCLASS')])
+
+    schema.remove('objectClasses', oc_may)
+    schema.add('objectClasses', oc_must)
+    with pytest.raises(ldap.OBJECT_CLASS_VIOLATION):
+        user.remove('testIndexAttr', 'value')
+
+    schema.remove('objectClasses', oc_must)
+    with pytest.raises(ldap.OBJECT_CLASS_VIOLATION):
+        user.replace('description', 'unknown objectclass')
+
 if __name__ == '__main__':
     # Run isolated
     # -s for DEBUG mode
@@ -919,6 +919,44 @@ def test_sync_repl_non_root_persist(topology, request):
 
     request.addfinalizer(fin)
 
+@pytest.mark.skipif(ldap.__version__ < '3.3.1',
+    reason="python ldap versions less that 3.3.1 have bugs in sync repl that will cause this to fail!")
+@pytest.mark.parametrize("index_size", ['0', '2'])
+def test_syncrepl_change_index_size(topology, index_size):
+    """Check the refresh results do not depend on the change index
+
+    :id: 4b8f0e6a-2c1d-4f7e-9a35-d6c2b71e0f84
+    :parametrized: yes
+    :setup: Standalone instance
+    :steps:
+        1. Enable Retro Changelog and Syncrepl
+        2. Disable the change index, or make it smaller than the changes
+           done between two refreshes
+        3. Restart the server
+        4. Run the syncstate test to check refresh, add, delete, mod.
+    :expectedresults:
+        1. Success
+        2. Success
+        3. Success
+        4. Refreshes fall back to the changelog and return the same states
+    """
+    st = topology.standalone
+    rcl = RetroChangelogPlugin(st)
+    rcl.enable()
+    rcl.replace('nsslapd-attribute', 'nsuniqueid:targetUniqueId')
+    csp = ContentSyncPlugin(st)
+    csp.enable()
+    csp.replace('syncrepl-change-index-size', index_size)
+    st.restart()
+
+    try:
+        sync = ISyncRepl(st)
+        syncstate_assert(st, sync)
+    finally:
+        csp.remove_all('syncrepl-change-index-size')
+        st.restart()
+
+
 def test_syncrepl_queue_size(topology):
     """ Test basic that the setting of the queue size
     ranges [100-100000]
@@ -31,6 +31,9 @@ Hewlett-Packard Development Company, L.P.
 static int
 acct_update_login_history(const char *, char *);
 
+/* The login time and history are written with the same flags, so that the write-behind buffer merges them */
+#define ACCT_RECORD_LOGIN_FLAGS (SLAPI_OP_FLAG_NO_ACCESS_CHECK | SLAPI_OP_FLAG_BYPASS_REFERRALS)
+
 /*
  * acct_policy_dn_is_config()
  *
@@ -202,7 +205,6 @@ acct_update_login_history(const char *dn, char *timestr)
     size_t i = 0;
     char **login_hist = NULL;
     Slapi_PBlock *entry_pb = NULL;
-    Slapi_PBlock *mod_pb;
     Slapi_Entry *e = NULL;
     Slapi_DN *sdn = NULL;
     acctPluginCfg *cfg;
@@ -217,10 +219,10 @@ acct_update_login_history(const char *dn, char *timestr)
     plugin_id = get_identity();
     sdn = slapi_sdn_new_normdn_byref(dn);
     slapi_search_get_entry(&entry_pb, sdn, NULL, &e, plugin_id);
-    slapi_sdn_free(&sdn);
 
     /* if the entry doesn't exist, just return */
     if (e == NULL) {
+        slapi_sdn_free(&sdn);
         return (rc);
     }
 
@@ -233,6 +235,7 @@ acct_update_login_history(const char *dn, char *timestr)
     if (slapi_entry_attr_has_syntax_value(e, cfg->login_history_attr, timestr_val)) {
         slapi_search_get_entry_done(&entry_pb);
         slapi_value_free(&timestr_val);
+        slapi_sdn_free(&sdn);
         config_unlock();
         return 0;
     }
@@ -288,18 +291,15 @@ acct_update_login_history(const char *dn, char *timestr)
         list_of_mods[0] = &attribute;
         list_of_mods[1] = NULL;
 
-        mod_pb = slapi_pblock_new();
-        slapi_modify_internal_set_pb(mod_pb, dn, list_of_mods, NULL, NULL, plugin_id,
-                                     SLAPI_OP_FLAG_NO_ACCESS_CHECK |SLAPI_OP_FLAG_BYPASS_REFERRALS);
-        slapi_modify_internal_pb(mod_pb);
-        slapi_pblock_get(mod_pb, SLAPI_PLUGIN_INTOP_RESULT, &rc);
+        /* same flags as the login time, so that both go in one update */
+        rc = slapi_writebehind_modify(sdn, list_of_mods, plugin_id, ACCT_RECORD_LOGIN_FLAGS);
         if (rc != LDAP_SUCCESS) {
             slapi_log_err(SLAPI_LOG_ERR, "acct_update_login_history", "Modify error %d on entry '%s'\n", rc, dn);
         }
-        slapi_pblock_destroy(mod_pb);
     }
 
     config_unlock();
+    slapi_sdn_free(&sdn);
     slapi_ch_array_free(login_hist);
     slapi_search_get_entry_done(&entry_pb);
     slapi_value_free(&timestr_val);
@@ -323,8 +323,7 @@ acct_record_login(const char *dn)
     char *timestr = NULL;
     acctPluginCfg *cfg;
     void *plugin_id;
-    Slapi_PBlock *modpb = NULL;
-    int skip_mod_attrs = 1; /* value doesn't matter as long as not NULL */
+    Slapi_DN *sdn = NULL;
 
     config_rd_lock();
     cfg = get_config();
@@ -351,15 +350,9 @@ acct_record_login(const char *dn)
     mods[0] = &mod;
     mods[1] = NULL;
 
-    modpb = slapi_pblock_new();
-
-    slapi_modify_internal_set_pb(modpb, dn, mods, NULL, NULL,
-                                 plugin_id, SLAPI_OP_FLAG_NO_ACCESS_CHECK |
-                                                SLAPI_OP_FLAG_BYPASS_REFERRALS);
-    slapi_pblock_set(modpb, SLAPI_SKIP_MODIFIED_ATTRS, &skip_mod_attrs);
-    slapi_modify_internal_pb(modpb);
-
-    slapi_pblock_get(modpb, SLAPI_PLUGIN_INTOP_RESULT, &ldrc);
+    /* buffered when nsslapd-writebehind-interval is set */
+    sdn = slapi_sdn_new_dn_byref(dn);
+    ldrc = slapi_writebehind_modify(sdn, mods, plugin_id, ACCT_RECORD_LOGIN_FLAGS);
 
     if (ldrc != LDAP_SUCCESS) {
         slapi_log_err(SLAPI_LOG_ERR, POST_PLUGIN_NAME,
@@ -379,7 +372,7 @@ acct_record_login(const char *dn)
 
 done:
     config_unlock();
-    slapi_pblock_destroy(modpb);
+    slapi_sdn_free(&sdn);
     slapi_ch_free_string(&timestr);
 
     return (rc);
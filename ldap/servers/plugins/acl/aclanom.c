@@ -219,6 +219,7 @@ aclanom_gen_anomProfile(acl_lock_flag_t lock_flag)
                               aci->targetFilterStr, dn);
                 goto cleanup;
             }
+            slapi_filter_compile(a_profile->anom_targetinfo[a_numacl].anom_filter);
         }
 
         i = 0;
@@ -651,6 +651,8 @@ automember_parse_config_entry(Slapi_Entry *e, int apply)
                           "(filter = \"%s\").\n",
                           AUTOMEMBER_FILTER_TYPE, entry->dn, value);
             ret = -1;
+        } else {
+            slapi_filter_compile(entry->filter);
         }
         slapi_ch_free_string(&value);
         if (ret != 0) {
@@ -36,6 +36,7 @@
 /* Default range request timeout */
 /* use the default replication timeout */
 #define DNA_DEFAULT_TIMEOUT 600 * 1000 /* 600 seconds in milliseconds */
+#define DNA_DEFAULT_RESERVE_SIZE 1
 
 /**
  * DNA config types
@@ -81,6 +82,9 @@
 #define DNA_NEXT_RANGE "dnaNextRange"
 #define DNA_RANGE_REQUEST_TIMEOUT "dnaRangeRequestTimeout"
 
+/* Number of values reserved per update of dnaNextValue */
+#define DNA_RESERVE_SIZE "dnaReserveSize"
+
 /* Replication types */
 #define DNA_REPL_BIND_DN "nsds5ReplicaBindDN"
 #define DNA_REPL_BIND_DNGROUP "nsds5ReplicaBindDNGroup"
@@ -139,6 +143,7 @@ struct configEntry
     char *remote_bind_method;
     char *remote_conn_prot;
     PRUint64 timeout;
+    PRUint64 reserve_size;
     /* This lock protects the 5 members below.  All
      * of the above members are safe to read as long
      * as you call dna_read_lock() first. */
@@ -155,6 +160,14 @@ struct configEntry
      * time. */
     Slapi_Mutex *extend_lock;
     int extend_in_progress;
+    /* Values reserved from the range but not handed out yet.
+     * These are only published with the lock held, and are
+     * read and consumed through the slapi_atomic_* functions
+     * so the next value can be taken without the lock.  The
+     * generation is odd while a new block is being published. */
+    uint64_t block_gen;
+    uint64_t block_next;
+    uint64_t block_end;
 };
 
 static PRCList *dna_global_config = NULL;
@@ -231,7 +244,12 @@ static int dna_dn_is_config(char *dn);
 static int dna_get_next_value(struct configEntry *config_entry,
                               char **next_value_ret);
 static int dna_first_free_value(struct configEntry *config_entry,
-                                PRUint64 *newval);
+                                PRUint64 *newval,
+                                PRUint64 *nextused);
+static int dna_use_reserve(struct configEntry *config_entry);
+static int dna_reserve_available(struct configEntry *config_entry);
+static int dna_reserved_value(struct configEntry *config_entry, PRUint64 *value);
+static void dna_publish_reserve(struct configEntry *config_entry, PRUint64 next, PRUint64 end);
 static int dna_fix_maxval(struct configEntry *config_entry,
                           int skip_range_request);
 static void dna_notice_allocation(struct configEntry *config_entry,
@@ -331,6 +349,7 @@ dna_config_copy(void)
             new_entry->remote_binddn = slapi_ch_strdup(config_entry->remote_binddn);
             new_entry->remote_bindpw = slapi_ch_strdup(config_entry->remote_bindpw);
             new_entry->timeout = config_entry->timeout;
+            new_entry->reserve_size = config_entry->reserve_size;
             new_entry->interval = config_entry->interval;
             new_entry->threshold = config_entry->threshold;
             new_entry->nextval = config_entry->nextval;
@@ -1067,6 +1086,7 @@ dna_parse_config_entry(Slapi_PBlock *pb, Slapi_Entry *e, int apply)
             ret = DNA_FAILURE;
             goto bail;
         }
+        slapi_filter_compile(entry->slapi_filter);
     } else {
         slapi_log_err(SLAPI_LOG_ERR, DNA_PLUGIN_SUBSYSTEM,
                       "dna_parse_config_entry - The %s config "
@@ -1297,6 +1317,35 @@ dna_parse_config_entry(Slapi_PBlock *pb, Slapi_Entry *e, int apply)
                   "dna_parse_config_entry - %s [%" PRIu64 "]\n", DNA_RANGE_REQUEST_TIMEOUT,
                   entry->timeout);
 
+    value = slapi_entry_attr_get_charptr(e, DNA_RESERVE_SIZE);
+    if (value) {
+        entry->reserve_size = strtoull(value, 0, 0);
+        slapi_ch_free_string(&value);
+        if (entry->reserve_size == 0) {
+            slapi_log_err(SLAPI_LOG_ERR, DNA_PLUGIN_SUBSYSTEM,
+                          "dna_parse_config_entry - %s too low for range %s, "
+                          "setting to [%d]\n",
+                          DNA_RESERVE_SIZE, entry->dn, DNA_DEFAULT_RESERVE_SIZE);
+            entry->reserve_size = DNA_DEFAULT_RESERVE_SIZE;
+        }
+    } else {
+        entry->reserve_size = DNA_DEFAULT_RESERVE_SIZE;
+    }
+
+    /* Values can only be reserved when we can find a run of free
+     * values with a single sorted search. */
+    if ((entry->reserve_size > 1) && (entry->prefix || dna_is_multitype_range(entry))) {
+        slapi_log_err(SLAPI_LOG_PLUGIN, DNA_PLUGIN_SUBSYSTEM,
+                      "dna_parse_config_entry - %s is ignored for range %s "
+                      "as it uses a prefix or multiple types.\n",
+                      DNA_RESERVE_SIZE, entry->dn);
+        entry->reserve_size = DNA_DEFAULT_RESERVE_SIZE;
+    }
+
+    slapi_log_err(SLAPI_LOG_CONFIG, DNA_PLUGIN_SUBSYSTEM,
+                  "dna_parse_config_entry - %s [%" PRIu64 "]\n", DNA_RESERVE_SIZE,
+                  entry->reserve_size);
+
     value = slapi_entry_attr_get_charptr(e, DNA_NEXT_RANGE);
     if (value) {
         char *p = NULL;
@@ -2362,10 +2411,16 @@ dna_build_sort_control(const char *attr)
  * server to sort them, then we check the first free spot and
  * use it as newval.  If we go past the end of the range, we
  * return LDAP_OPERATIONS_ERROR and set newval to be > the
- * maximum configured value for this range. */
+ * maximum configured value for this range.
+ *
+ * If nextused is not NULL, it is set to the first value above
+ * newval that is known to be taken, or 0 if there is none up to
+ * the end of the range.  This is only computed for single-type
+ * ranges without a prefix. */
 static int
 dna_first_free_value(struct configEntry *config_entry,
-                     PRUint64 *newval)
+                     PRUint64 *newval,
+                     PRUint64 *nextused)
 {
     Slapi_Entry **entries = NULL;
     Slapi_PBlock *pb = NULL;
@@ -2377,6 +2432,10 @@ dna_first_free_value(struct configEntry *config_entry,
     PRUint64 tmpval, sval, i;
     char *strval = NULL;
 
+    if (nextused) {
+        *nextused = 0;
+    }
+
     /* check if the config is already out of range */
     if (config_entry->nextval > config_entry->maxval) {
         *newval = config_entry->nextval;
@@ -2509,8 +2568,14 @@ dna_first_free_value(struct configEntry *config_entry,
             }
             slapi_ch_free_string(&strval);
 
-            if (tmpval != sval)
+            if (tmpval != sval) {
+                if (nextused) {
+                    /* Duplicate values leave us unsure of what
+                     * follows, so only claim the free value. */
+                    *nextused = (sval > tmpval) ? sval : tmpval + 1;
+                }
                 break;
+            }
 
             if (config_entry->maxval < sval)
                 break;
@@ -2540,9 +2605,163 @@ cleanup:
     return status;
 }
 
+/*
+ * dna_use_reserve()
+ *
+ * Returns 1 if values are reserved in blocks for this range.
+ */
+static int
+dna_use_reserve(struct configEntry *config_entry)
+{
+    return config_entry->reserve_size > 1;
+}
+
+/*
+ * dna_reserve_available()
+ *
+ * Returns 1 if the reserved block looks like it still has
+ * values left.  This is only a hint, as other threads may
+ * consume the remaining values at any time.
+ */
+static int
+dna_reserve_available(struct configEntry *config_entry)
+{
+    uint64_t gen;
+
+    if (!dna_use_reserve(config_entry)) {
+        return 0;
+    }
+
+    gen = slapi_atomic_load_64(&config_entry->block_gen, __ATOMIC_SEQ_CST);
+    if (gen & 1) {
+        return 0;
+    }
+
+    return slapi_atomic_load_64(&config_entry->block_next, __ATOMIC_SEQ_CST) <
+           slapi_atomic_load_64(&config_entry->block_end, __ATOMIC_SEQ_CST);
+}
+
+/*
+ * dna_reserved_value()
+ *
+ * Takes the next value from the reserved block without
+ * obtaining the lock for configEntry.  Returns 1 and sets
+ * value if one was available, or 0 if the caller needs to
+ * reserve a new block.
+ *
+ * Values are handed out by advancing block_next by the
+ * interval.  If a new block was published while we did that,
+ * the value we got may belong to either block, so we drop it.
+ * This can leave a gap in the range, but never hands out the
+ * same value twice.
+ */
+static int
+dna_reserved_value(struct configEntry *config_entry, PRUint64 *value)
+{
+    uint64_t gen;
+    uint64_t end;
+    uint64_t val;
+
+    gen = slapi_atomic_load_64(&config_entry->block_gen, __ATOMIC_SEQ_CST);
+    if (gen & 1) {
+        return 0;
+    }
+
+    end = slapi_atomic_load_64(&config_entry->block_end, __ATOMIC_SEQ_CST);
+    if (slapi_atomic_load_64(&config_entry->block_next, __ATOMIC_SEQ_CST) >= end) {
+        /* Don't push block_next further past the end */
+        return 0;
+    }
+
+    val = slapi_atomic_add_64(&config_entry->block_next, config_entry->interval,
+                              __ATOMIC_SEQ_CST) -
+          config_entry->interval;
+    if (val >= end) {
+        return 0;
+    }
+
+    if (slapi_atomic_load_64(&config_entry->block_gen, __ATOMIC_SEQ_CST) != gen) {
+        return 0;
+    }
+
+    *value = val;
+    return 1;
+}
+
+/*
+ * dna_publish_reserve()
+ *
+ * Makes the values in [next, end) available to
+ * dna_reserved_value().  Passing 0 for both drops
+ * any values left in the current block.
+ *
+ * The lock for configEntry should be obtained
+ * before calling this function.
+ */
+static void
+dna_publish_reserve(struct configEntry *config_entry, PRUint64 next, PRUint64 end)
+{
+    slapi_atomic_incr_64(&config_entry->block_gen, __ATOMIC_SEQ_CST);
+    slapi_atomic_store_64(&config_entry->block_next, next, __ATOMIC_SEQ_CST);
+    slapi_atomic_store_64(&config_entry->block_end, end, __ATOMIC_SEQ_CST);
+    slapi_atomic_incr_64(&config_entry->block_gen, __ATOMIC_SEQ_CST);
+}
+
+/*
+ * dna_reserve_check_value()
+ *
+ * The values of the reserved block were found free by a search,
+ * but a client can still assign one of them by hand before it is
+ * handed out.  If value falls in the block, the rest of the block
+ * is dropped so that the next add searches for a free value again.
+ */
+static void
+dna_reserve_check_value(struct configEntry *config_entry, const char *value, size_t len)
+{
+    char buf[22] = {0};
+    PRUint64 val;
+    char *endp = NULL;
+
+    if (!dna_use_reserve(config_entry) || value == NULL ||
+        len == 0 || len >= sizeof(buf)) {
+        return;
+    }
+
+    memcpy(buf, value, len);
+    errno = 0;
+    val = strtoull(buf, &endp, 0);
+    if (errno || endp == buf) {
+        return;
+    }
+
+    /* Most values given by hand are outside of the block: only take
+     * the range lock to drop it */
+    if (val < slapi_atomic_load_64(&config_entry->block_next, __ATOMIC_SEQ_CST) ||
+        val >= slapi_atomic_load_64(&config_entry->block_end, __ATOMIC_SEQ_CST)) {
+        return;
+    }
+
+    slapi_lock_mutex(config_entry->lock);
+    if (val >= slapi_atomic_load_64(&config_entry->block_next, __ATOMIC_SEQ_CST) &&
+        val < slapi_atomic_load_64(&config_entry->block_end, __ATOMIC_SEQ_CST)) {
+        slapi_log_err(SLAPI_LOG_PLUGIN, DNA_PLUGIN_SUBSYSTEM,
+                      "dna_reserve_check_value - %s is assigned in the reserved block of %s, "
+                      "dropping the block\n",
+                      buf, config_entry->dn);
+        dna_publish_reserve(config_entry, 0, 0);
+    }
+    slapi_unlock_mutex(config_entry->lock);
+}
+
 /*
  * Perform ldap operationally atomic increment
  * Return the next value to be assigned
+ *
+ * If the range reserves values in blocks, the next value is
+ * normally taken from the current block without the lock.
+ * Once the block is used up, a new run of free values is
+ * found and dnaNextValue is moved past all of them with a
+ * single modify.
  */
 static int
 dna_get_next_value(struct configEntry *config_entry,
@@ -2556,17 +2775,34 @@ dna_get_next_value(struct configEntry *config_entry,
     char next_value[22] = {0};
     PRUint64 setval = 0;
     PRUint64 nextval = 0;
+    PRUint64 nextused = 0;
+    PRUint64 count = 0;
+    int reserve = dna_use_reserve(config_entry);
+    int locked = 0;
     int ret;
 
     slapi_log_err(SLAPI_LOG_TRACE, DNA_PLUGIN_SUBSYSTEM,
                   "--> dna_get_next_value\n");
 
+    if (reserve && dna_reserved_value(config_entry, &setval)) {
+        ret = LDAP_SUCCESS;
+        goto found;
+    }
+
     /* get the lock to prevent contention with other threads over
      * the next new value for this range. */
     slapi_lock_mutex(config_entry->lock);
+    locked = 1;
+
+    /* Another thread may have reserved a new block while
+     * we were waiting for the lock. */
+    if (reserve && dna_reserved_value(config_entry, &setval)) {
+        ret = LDAP_SUCCESS;
+        goto found;
+    }
 
     /* get the first value */
-    ret = dna_first_free_value(config_entry, &setval);
+    ret = dna_first_free_value(config_entry, &setval, reserve ? &nextused : NULL);
     if (LDAP_SUCCESS != ret) {
         /* check if we overflowed the configured range */
         if (setval > config_entry->maxval) {
@@ -2583,7 +2819,7 @@ dna_get_next_value(struct configEntry *config_entry,
             }
 
             /* get the first value from our newly extended range */
-            ret = dna_first_free_value(config_entry, &setval);
+            ret = dna_first_free_value(config_entry, &setval, reserve ? &nextused : NULL);
             if (LDAP_SUCCESS != ret)
                 goto done;
         } else {
@@ -2595,6 +2831,19 @@ dna_get_next_value(struct configEntry *config_entry,
     }
 
     nextval = setval + config_entry->interval;
+    if (reserve) {
+        /* Reserve the run of free values starting at setval, up
+         * to the next used value or the end of the range. */
+        count = config_entry->reserve_size;
+        if (nextused > setval) {
+            count = PR_MIN(count, (nextused - setval + config_entry->interval - 1) /
+                                      config_entry->interval);
+        }
+        if ((config_entry->maxval - setval) / config_entry->interval < count) {
+            count = (config_entry->maxval - setval) / config_entry->interval + 1;
+        }
+        nextval = setval + (count * config_entry->interval);
+    }
     /* update nextval if we have not reached the end
      * of our current range */
     if ((config_entry->maxval == -1) ||
@@ -2625,20 +2874,34 @@ dna_get_next_value(struct configEntry *config_entry,
         slapi_pblock_get(pb, SLAPI_PLUGIN_INTOP_RESULT, &ret);
     }
 
+    if (LDAP_SUCCESS == ret) {
+        if (reserve) {
+            /* Hand out the rest of the block to other threads
+             * before we possibly move on to the next range. */
+            dna_publish_reserve(config_entry, setval + config_entry->interval, nextval);
+            slapi_log_err(SLAPI_LOG_PLUGIN, DNA_PLUGIN_SUBSYSTEM,
+                          "dna_get_next_value - Reserved %" PRIu64 " values from %" PRIu64
+                          " for range %s\n",
+                          count, setval, config_entry->dn);
+        }
+
+        /* update our cached config */
+        dna_notice_allocation(config_entry, nextval, setval);
+    }
+
+found:
     if (LDAP_SUCCESS == ret) {
         slapi_ch_free_string(next_value_ret);
         *next_value_ret = slapi_ch_smprintf("%" PRIu64, setval);
         if (NULL == *next_value_ret) {
             ret = LDAP_OPERATIONS_ERROR;
-            goto done;
         }
-
-        /* update our cached config */
-        dna_notice_allocation(config_entry, nextval, setval);
     }
 
 done:
-    slapi_unlock_mutex(config_entry->lock);
+    if (locked) {
+        slapi_unlock_mutex(config_entry->lock);
+    }
 
     if (pb) {
         slapi_pblock_destroy(pb);
@@ -3589,6 +3852,8 @@ _dna_pre_op_add(Slapi_PBlock *pb, Slapi_Entry *e, char **errstr)
                 if ((config_entry->generate == NULL) || (0 == value) ||
                     (value && !slapi_UTF8CASECMP(config_entry->generate, value))) {
                     slapi_ch_array_add(&types_to_generate, slapi_ch_strdup(config_entry->types[0]));
+                } else {
+                    dna_reserve_check_value(config_entry, value, strlen(value));
                 }
                 slapi_ch_free_string(&value);
             }
@@ -3628,12 +3893,18 @@ _dna_pre_op_add(Slapi_PBlock *pb, Slapi_Entry *e, char **errstr)
                 slapi_ch_array_free(types_to_generate);
                 types_to_generate = NULL;
 
+                /* The be txn preop will take its value from the
+                 * reserved block, so there is nothing to check. */
+                if (dna_reserve_available(config_entry)) {
+                    goto next;
+                }
+
                 /*
                  *  Now grab the next value and see if we need to get the next range
                  */
                 slapi_lock_mutex(config_entry->lock);
 
-                ret = dna_first_free_value(config_entry, &setval);
+                ret = dna_first_free_value(config_entry, &setval, NULL);
                 slapi_log_err(SLAPI_LOG_PLUGIN, DNA_PLUGIN_SUBSYSTEM, "_dna_pre_op_add - retrieved value %" PRIu64 " ret %d\n", setval, ret);
                 if (LDAP_SUCCESS != ret) {
                     /* check if we overflowed the configured range */
@@ -3652,7 +3923,7 @@ _dna_pre_op_add(Slapi_PBlock *pb, Slapi_Entry *e, char **errstr)
                         }
 
                         /* Make sure dna_first_free_value() doesn't error out */
-                        ret = dna_first_free_value(config_entry, &setval);
+                        ret = dna_first_free_value(config_entry, &setval, NULL);
                         if (LDAP_SUCCESS != ret) {
                             slapi_log_err(SLAPI_LOG_ERR, DNA_PLUGIN_SUBSYSTEM,
                                           "_dna_pre_op_add - Failed to allocate a new ID 1\n");
@@ -3830,10 +4101,11 @@ _dna_pre_op_modify(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_Mods *smods, char **e
                                 slapi_ch_array_add(&types_to_generate, slapi_ch_strdup(type));
                             } else {
                                 len = strlen(config_entry->generate);
-                                if (len == bv->bv_len) {
-                                    if (!slapi_UTF8NCASECMP(bv->bv_val, config_entry->generate, len)) {
-                                        slapi_ch_array_add(&types_to_generate, slapi_ch_strdup(type));
-                                    }
+                                if (len == bv->bv_len &&
+                                    !slapi_UTF8NCASECMP(bv->bv_val, config_entry->generate, len)) {
+                                    slapi_ch_array_add(&types_to_generate, slapi_ch_strdup(type));
+                                } else {
+                                    dna_reserve_check_value(config_entry, bv->bv_val, bv->bv_len);
                                 }
                             }
                         } else if (!dna_is_multitype_range(config_entry)) {
@@ -3899,12 +4171,18 @@ _dna_pre_op_modify(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_Mods *smods, char **e
                 slapi_ch_array_free(types_to_generate);
                 types_to_generate = NULL;
 
+                /* The be txn preop will take its value from the
+                 * reserved block, so there is nothing to check. */
+                if (dna_reserve_available(config_entry)) {
+                    goto next;
+                }
+
                 /*
                  *  Now grab the next value and see if we need to get the next range
                  */
                 slapi_lock_mutex(config_entry->lock);
 
-                ret = dna_first_free_value(config_entry, &setval);
+                ret = dna_first_free_value(config_entry, &setval, NULL);
                 if (LDAP_SUCCESS != ret) {
                     /* check if we overflowed the configured range */
                     if (setval > config_entry->maxval) {
@@ -3922,7 +4200,7 @@ _dna_pre_op_modify(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_Mods *smods, char **e
                         }
 
                         /* Make sure dna_first_free_value() doesn't error out */
-                        ret = dna_first_free_value(config_entry, &setval);
+                        ret = dna_first_free_value(config_entry, &setval, NULL);
                         if (LDAP_SUCCESS != ret) {
                             slapi_log_err(SLAPI_LOG_ERR, DNA_PLUGIN_SUBSYSTEM,
                                           "_dna_pre_op_modify - Failed to allocate a new ID\n");
@@ -737,6 +737,8 @@ memberof_apply_config(Slapi_PBlock *pb __attribute__((unused)),
                           "plug-in will not operate on changes to groups.  Please check "
                           "your %s configuration settings. (filter: %s)\n",
                           MEMBEROF_GROUP_ATTR, filter_str);
+        } else {
+            slapi_filter_compile(theConfig.group_filter);
         }
 
         slapi_ch_free_string(&filter_str);
@@ -828,6 +830,7 @@ memberof_apply_config(Slapi_PBlock *pb __attribute__((unused)),
         theConfig.specificGroupFilter = (Slapi_Filter **)slapi_ch_calloc(sizeof(Slapi_Filter *), num_vals + 1);
         for (size_t i = 0; i < num_vals; i++) {
             theConfig.specificGroupFilter[i] = slapi_str2filter(specificGroupFilter[i]);
+            slapi_filter_compile(theConfig.specificGroupFilter[i]);
         }
         theConfig.specificGroupFilterCount = num_vals; /* shortcut for config copy */
     }
@@ -838,6 +841,7 @@ memberof_apply_config(Slapi_PBlock *pb __attribute__((unused)),
         theConfig.excludeSpecificGroupFilter = (Slapi_Filter **)slapi_ch_calloc(sizeof(Slapi_Filter *), num_vals + 1);
         for (size_t i = 0; i < num_vals; i++) {
             theConfig.excludeSpecificGroupFilter[i] = slapi_str2filter(excludeSpecificGroupFilter[i]);
+            slapi_filter_compile(theConfig.excludeSpecificGroupFilter[i]);
         }
         theConfig.excludeSpecificGroupFilterCount = num_vals; /* shortcut for config copy */
     }
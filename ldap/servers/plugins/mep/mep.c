@@ -543,6 +543,8 @@ mep_parse_config_entry(Slapi_Entry *e, int apply)
                           "(filter = \"%s\").\n",
                           MEP_FILTER_TYPE, slapi_sdn_get_dn(entry->sdn), value);
             ret = -1;
+        } else {
+            slapi_filter_compile(entry->origin_filter);
         }
         slapi_ch_free_string(&value);
         if (ret != 0) {
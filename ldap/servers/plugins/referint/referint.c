@@ -29,18 +29,62 @@
 #define REFERINT_ATTR_DELAY       "referint-update-delay"
 #define REFERINT_ATTR_LOGFILE     "referint-logfile"
 #define REFERINT_ATTR_MEMBERSHIP  "referint-membership-attr"
-#define MAX_LINE     2048
-#define READ_BUFSIZE 4096
-#define MY_EOF  0
+#define REFERINT_ATTR_BATCH_SIZE  "referint-batch-size"
+#define REFERINT_DEFAULT_BATCH_SIZE 1000
+#define REFERINT_MAX_MODS_PER_OP  256
 #define STARTUP 2
 
+/*
+ * Delayed updates are queued in a binary file (referint-logfile):
+ *
+ *   magic (REFERINT_QUEUE_MAGIC)
+ *   record*
+ *
+ * each record being
+ *
+ *   uint32 payload length | uint32 payload checksum | payload
+ *
+ * and the payload the four fields of a referint_update, each encoded as
+ * uint32 length (REFERINT_QUEUE_NULL_FIELD for NULL) followed by the bytes.
+ * Integers are stored in network byte order.  A record torn by a crash is
+ * detected through its length/checksum and dropped.
+ *
+ * The batch thread renames the queue to <logfile>.work before applying it
+ * so writers are never blocked by the updates themselves, and removes the
+ * work file once every update was applied.  A work file left over after a
+ * restart is replayed first.
+ *
+ * A non-empty queue without the magic was written in the text format of
+ * older versions.  Before the first binary record is appended to it, it is
+ * moved to <logfile>.legacy, which the batch thread replays before the
+ * current queue.
+ */
+#define REFERINT_QUEUE_MAGIC       "RIQ\001"
+#define REFERINT_QUEUE_MAGIC_LEN   4
+#define REFERINT_QUEUE_NULL_FIELD  0xffffffffU
+#define REFERINT_QUEUE_NFIELDS     4
+#define REFERINT_QUEUE_WORK_SUFFIX ".work"
+#define REFERINT_QUEUE_LEGACY_SUFFIX ".legacy"
+
 typedef struct referint_config
 {
     int delay;
+    int batch_size;
     char *logfile;
     char **attrs;
 } referint_config;
 
+/*
+ * A delete or modrdn whose references still have to be updated.
+ */
+typedef struct referint_update
+{
+    Slapi_DN *sdn;         /* entry that was deleted or renamed */
+    char *newrdn;          /* new RDN, NULL for a delete */
+    Slapi_DN *newsuperior; /* new superior, NULL if unchanged */
+    char *requestor;       /* bind DN of the original operation */
+} referint_update;
+
 Slapi_RWLock *config_rwlock = NULL;
 
 /* function prototypes */
@@ -50,12 +94,11 @@ int referint_postop_modrdn(Slapi_PBlock *pb);
 int referint_postop_start(Slapi_PBlock *pb);
 int referint_postop_close(Slapi_PBlock *pb);
 int update_integrity(Slapi_DN *sDN, char *newrDN, Slapi_DN *newsuperior, Slapi_PBlock *pb);
-int GetNextLine(char *dest, int size_dest, PRFileDesc *stream);
-int my_fgetc(PRFileDesc *stream);
 void referint_thread_func(void *arg);
 void writeintegritylog(Slapi_PBlock *pb, char *logfilename, Slapi_DN *sdn, char *newrdn, Slapi_DN *newsuperior, Slapi_DN *requestorsdn);
 int load_config(Slapi_PBlock *pb, Slapi_Entry *config_entry, int apply);
 int referint_get_delay(void);
+int referint_get_batch_size(void);
 char *referint_get_logfile(void);
 char **referint_get_attrs(void);
 int referint_postop_modify(Slapi_PBlock *pb);
@@ -90,12 +133,14 @@ static int use_txn = 0;
 static int premodfn = SLAPI_PLUGIN_PRE_MODIFY_FN;
 
 
+/*
+ * Protects the delayed update queue file.  It is only held while a record
+ * is appended or while the batch thread takes ownership of the queue, never
+ * while the updates are applied, so it is safe to take from a betxn.
+ */
 static void
 referint_lock(void)
 {
-    if (use_txn) { /* no lock if betxn is enabled */
-        return;
-    }
     if (NULL == referint_mutex) {
         referint_mutex = PR_NewLock();
     }
@@ -107,9 +152,6 @@ referint_lock(void)
 static void
 referint_unlock(void)
 {
-    if (use_txn) { /* no lock if betxn is enabled */
-        return;
-    }
     if (referint_mutex) {
         PR_Unlock(referint_mutex);
     }
@@ -274,6 +316,7 @@ referint_postop_init(Slapi_PBlock *pb)
  * referint-membership-attr: uniquemember
  * referint-membership-attr: owner
  * referint-membership-attr: seeAlso
+ * referint-batch-size: 1000
  *
  *
  * Need to lock this!
@@ -309,6 +352,7 @@ load_config(Slapi_PBlock *pb, Slapi_Entry *config_entry, int apply)
     } else {
         /* set this for config validation */
         tmp_config->delay = -2;
+        tmp_config->batch_size = REFERINT_DEFAULT_BATCH_SIZE;
     }
 
 
@@ -323,6 +367,16 @@ load_config(Slapi_PBlock *pb, Slapi_Entry *config_entry, int apply)
         }
         new_config_present = 1;
     }
+    if ((value = (char *)slapi_entry_attr_get_ref(config_entry, REFERINT_ATTR_BATCH_SIZE))) {
+        char *endptr = NULL;
+        tmp_config->batch_size = strtol(value, &endptr, 10);
+        if (*endptr || tmp_config->batch_size < 1) {
+            slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM, "load_config - invalid value \"%s\" for %s; should be > 0\n",
+                          value, REFERINT_ATTR_BATCH_SIZE);
+            rc = SLAPI_PLUGIN_FAILURE;
+            goto done;
+        }
+    }
     if ((value = slapi_entry_attr_get_charptr(config_entry, REFERINT_ATTR_LOGFILE))) {
         tmp_config->logfile = value;
         new_config_present = 1;
@@ -492,6 +546,18 @@ referint_get_delay(void)
     return delay;
 }
 
+int
+referint_get_batch_size(void)
+{
+    int batch_size;
+
+    slapi_rwlock_rdlock(config_rwlock);
+    batch_size = config->batch_size;
+    slapi_rwlock_unlock(config_rwlock);
+
+    return batch_size;
+}
+
 char *
 referint_get_logfile(void)
 {
@@ -785,335 +851,353 @@ _do_modify(Slapi_PBlock *mod_pb, Slapi_DN *entrySDN, LDAPMod **mods)
 }
 
 /*
- * update one attribute value per _do_modify
+ * Submit the mods built for one referencing entry as a single internal
+ * modify.  If it is rejected because one of the values was already added
+ * or removed (e.g. by a replicated update), fall back to _do_modify which
+ * applies the mods one at a time and tolerates those errors.
  */
 static int
-_update_one_per_mod(Slapi_DN *entrySDN, /* DN of the searched entry */
-                    Slapi_Attr *attr,   /* referred attribute */
-                    char *attrName,
-                    Slapi_DN *origDN,        /* original DN that was modified */
-                    char *newRDN,            /* new RDN from modrdn */
-                    const char *newsuperior, /* new superior from modrdn */
-                    Slapi_PBlock *mod_pb)
+_do_modify_coalesced(Slapi_PBlock *mod_pb, Slapi_DN *entrySDN, LDAPMod **mods)
 {
-    LDAPMod attribute1, attribute2;
-    LDAPMod *list_of_mods[3];
-    char *values_del[2];
-    char *values_add[2];
-    char *newDN = NULL;
-    char **dnParts = NULL;
-    char *sval = NULL;
-    char *newvalue = NULL;
-    char *p = NULL;
-    size_t dnlen = 0;
     int rc = 0;
+    int op_flags = allow_repl ? OP_FLAG_REPLICATED : 0;
 
-    if (NULL == newRDN && NULL == newsuperior) {
-        /* in delete mode */
-        /* delete old dn so set that up */
-        values_del[0] = (char *)slapi_sdn_get_dn(origDN);
-        values_del[1] = NULL;
-        attribute1.mod_type = attrName;
-        attribute1.mod_op = LDAP_MOD_DELETE;
-        attribute1.mod_values = values_del;
-        list_of_mods[0] = &attribute1;
-        /* terminate list of mods. */
-        list_of_mods[1] = NULL;
-        rc = _do_modify(mod_pb, entrySDN, list_of_mods);
-        if (rc) {
-            slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
-                          "_update_one_per_mod - Entry %s: deleting \"%s: %s\" failed (%d)"
-                          "\n",
-                          slapi_sdn_get_dn(entrySDN), attrName, slapi_sdn_get_dn(origDN), rc);
-        }
-    } else {
-        /* in modrdn mode */
-        const char *superior = NULL;
-        int nval = 0;
-        Slapi_Value *v = NULL;
+    slapi_pblock_init(mod_pb);
+    slapi_modify_internal_set_pb_ext(mod_pb, entrySDN, mods,
+                                     NULL, NULL,
+                                     referint_plugin_identity,
+                                     op_flags);
+    slapi_modify_internal_pb(mod_pb);
+    slapi_pblock_get(mod_pb, SLAPI_PLUGIN_INTOP_RESULT, &rc);
+
+    if (rc == LDAP_TYPE_OR_VALUE_EXISTS || rc == LDAP_NO_SUCH_ATTRIBUTE) {
+        slapi_log_err(SLAPI_LOG_PLUGIN, REFERINT_PLUGIN_SUBSYSTEM,
+                      "_do_modify_coalesced - Entry %s: coalesced update failed (%d), "
+                      "retrying one mod at a time\n",
+                      slapi_sdn_get_dn(entrySDN), rc);
+        rc = _do_modify(mod_pb, entrySDN, mods);
+    }
 
-        if (NULL == origDN) {
-            slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
-                          "_update_one_per_mod - NULL dn was passed\n");
-            goto bail;
-        }
-        /* need to put together rdn into a dn */
-        dnParts = slapi_ldap_explode_dn(slapi_sdn_get_dn(origDN), 0);
-        if (NULL == dnParts) {
-            slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
-                          "_update_one_per_mod - Failed to explode dn %s\n",
-                          slapi_sdn_get_dn(origDN));
-            goto bail;
-        }
-        if (NULL == newRDN) {
-            newRDN = dnParts[0];
-        }
-        if (newsuperior) {
-            superior = newsuperior;
-        } else {
-            /* do not free superior */
-            superior = slapi_dn_find_parent(slapi_sdn_get_dn(origDN));
-        }
-        /* newRDN and superior are already normalized. */
-        newDN = slapi_ch_smprintf("%s,%s", newRDN, superior);
-        slapi_dn_ignore_case(newDN);
-        /*
-         * Compare the modified dn with the value of
-         * the target attribute of referint to find out
-         * the modified dn is the ancestor (case 2) or
-         * the value itself (case 1).
-         *
-         * E.g.,
-         * (case 1)
-         * modrdn: uid=A,ou=B,o=C --> uid=A',ou=B',o=C
-         *            (origDN)             (newDN)
-         * member: uid=A,ou=B,ou=C --> uid=A',ou=B',ou=C
-         *            (sval)               (newDN)
-         *
-         * (case 2)
-         * modrdn: ou=B,o=C --> ou=B',o=C
-         *         (origDN)      (newDN)
-         * member: uid=A,ou=B,ou=C --> uid=A,ou=B',ou=C
-         *         (sval)              (sval' + newDN)
-         */
-        for (nval = slapi_attr_first_value(attr, &v); nval != -1;
-             nval = slapi_attr_next_value(attr, nval, &v)) {
-            int normalize_rc;
-            p = NULL;
-            dnlen = 0;
-
-            /* DN syntax, which should be a string */
-            sval = slapi_ch_strdup(slapi_value_get_string(v));
-            normalize_rc = slapi_dn_normalize_case_ext(sval, 0, &p, &dnlen);
-            if (normalize_rc == 0) { /* sval is passed in; not terminated */
-                *(p + dnlen) = '\0';
-                sval = p;
-            } else if (normalize_rc > 0) {
-                slapi_ch_free_string(&sval);
-                sval = p;
-            }
-            /* else: (normalize_rc < 0) Ignore the DN normalization error for now. */
-
-            p = PL_strstr(sval, slapi_sdn_get_ndn(origDN));
-            if (p == sval) {
-                /* (case 1) */
-                values_del[0] = sval;
-                values_del[1] = NULL;
-                attribute1.mod_type = attrName;
-                attribute1.mod_op = LDAP_MOD_DELETE;
-                attribute1.mod_values = values_del;
-                list_of_mods[0] = &attribute1;
-
-                values_add[0] = newDN;
-                values_add[1] = NULL;
-                attribute2.mod_type = attrName;
-                attribute2.mod_op = LDAP_MOD_ADD;
-                attribute2.mod_values = values_add;
-                list_of_mods[1] = &attribute2;
-                list_of_mods[2] = NULL;
-                rc = _do_modify(mod_pb, entrySDN, list_of_mods);
-                if (rc) {
-                    slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
-                                  "_update_one_per_mod - Entry %s: replacing \"%s: %s\" "
-                                  "with \"%s: %s\" failed (%d)\n",
-                                  slapi_sdn_get_dn(entrySDN), attrName,
-                                  slapi_sdn_get_dn(origDN), attrName, newDN, rc);
-                }
-            } else if (p) {
-                char bak;
-                /* (case 2) */
-                values_del[0] = sval;
-                values_del[1] = NULL;
-                attribute1.mod_type = attrName;
-                attribute1.mod_op = LDAP_MOD_DELETE;
-                attribute1.mod_values = values_del;
-                list_of_mods[0] = &attribute1;
-
-                bak = *p;
-                *p = '\0';
-                /* newRDN and superior are already normalized. */
-                newvalue = slapi_ch_smprintf("%s%s", sval, newDN);
-                *p = bak;
-                values_add[0] = newvalue;
-                values_add[1] = NULL;
-                attribute2.mod_type = attrName;
-                attribute2.mod_op = LDAP_MOD_ADD;
-                attribute2.mod_values = values_add;
-                list_of_mods[1] = &attribute2;
-                list_of_mods[2] = NULL;
-                rc = _do_modify(mod_pb, entrySDN, list_of_mods);
-                if (rc) {
-                    slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
-                                  "_update_one_per_mod - Entry %s: replacing \"%s: %s\" "
-                                  "with \"%s: %s\" failed (%d)\n",
-                                  slapi_sdn_get_dn(entrySDN), attrName, sval, attrName, newvalue, rc);
-                }
-                slapi_ch_free_string(&newvalue);
-            }
-            /* else: value does not include the modified DN.  Ignore it. */
-            slapi_ch_free_string(&sval);
-        }
+    return rc;
+}
 
-        /* cleanup memory allocated for dnParts and newDN */
-        if (dnParts) {
-            slapi_ldap_value_free(dnParts);
-            dnParts = NULL;
+/*
+ * Apply all the mods needed on one referencing entry.
+ *
+ * If an entry holds thousands of values which need to be updated (e.g. a
+ * subtree rename and a group containing 1000s of members of that subtree),
+ * we want to avoid allocating too many mods in one "modify" call, so the
+ * list is submitted in chunks of at most REFERINT_MAX_MODS_PER_OP mods.
+ * A DEL+ADD pair is never split across two chunks.
+ */
+static int
+_update_entry(Slapi_PBlock *mod_pb, Slapi_DN *entrySDN, Slapi_Mods *smods)
+{
+    LDAPMod **mods = slapi_mods_get_ldapmods_byref(smods);
+    size_t nmods = (size_t)slapi_mods_get_num_mods(smods);
+    size_t start = 0;
+    int rc = LDAP_SUCCESS;
+
+    while (start < nmods && rc == LDAP_SUCCESS) {
+        size_t end = start + REFERINT_MAX_MODS_PER_OP;
+        LDAPMod *saved;
+
+        if (end >= nmods) {
+            end = nmods;
+        } else if (_is_del_add_pair(mods, end - 1)) {
+            end++;
         }
-        slapi_ch_free_string(&newDN);
+        /* terminate the list at the end of this chunk */
+        saved = mods[end];
+        mods[end] = NULL;
+        rc = _do_modify_coalesced(mod_pb, entrySDN, &mods[start]);
+        mods[end] = saved;
+        start = end;
     }
-bail:
+
     return rc;
 }
 
 /*
- * update multiple attribute values per _do_modify
+ * Build the DN an entry is renamed to by a modrdn.
+ * Returns NULL if origDN can't be parsed; the caller must free the result.
  */
-static int
-_update_all_per_mod(Slapi_DN *entrySDN, /* DN of the searched entry */
-                    Slapi_Attr *attr,   /* referred attribute */
-                    char *attrName,
-                    Slapi_DN *origDN,        /* original DN that was modified */
-                    char *newRDN,            /* new RDN from modrdn */
-                    const char *newsuperior, /* new superior from modrdn */
-                    Slapi_PBlock *mod_pb)
+static char *
+_referint_new_dn(Slapi_DN *origDN, char *newRDN, const char *newsuperior)
 {
-    Slapi_Mods *smods = NULL;
-    char *newDN = NULL;
+    const char *superior = NULL;
     char **dnParts = NULL;
+    char *newDN = NULL;
+
+    if (NULL == origDN) {
+        slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
+                      "_referint_new_dn - NULL dn was passed\n");
+        return NULL;
+    }
+    /* need to put together rdn into a dn */
+    dnParts = slapi_ldap_explode_dn(slapi_sdn_get_dn(origDN), 0);
+    if (NULL == dnParts) {
+        slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
+                      "_referint_new_dn - Failed to explode dn %s\n",
+                      slapi_sdn_get_dn(origDN));
+        return NULL;
+    }
+    if (NULL == newRDN) {
+        newRDN = dnParts[0];
+    }
+    if (newsuperior) {
+        superior = newsuperior;
+    } else {
+        /* do not free superior */
+        superior = slapi_dn_find_parent(slapi_sdn_get_dn(origDN));
+    }
+    /* newRDN and superior are already normalized. */
+    newDN = slapi_ch_smprintf("%s,%s", newRDN, superior);
+    slapi_dn_ignore_case(newDN);
+    slapi_ldap_value_free(dnParts);
+
+    return newDN;
+}
+
+/*
+ * Add to smods the changes needed on one membership attribute of a
+ * referencing entry.  newDN is NULL in delete mode.
+ */
+static void
+_referint_add_mods(Slapi_Mods *smods,
+                   Slapi_Attr *attr,   /* referred attribute */
+                   const char *attrName,
+                   Slapi_DN *origDN,   /* original DN that was modified */
+                   const char *newDN)  /* new DN from modrdn */
+{
+    Slapi_Value *v = NULL;
     char *sval = NULL;
     char *newvalue = NULL;
     char *p = NULL;
     size_t dnlen = 0;
-    int rc = 0;
+    int nval = 0;
 
-    if (NULL == newRDN && NULL == newsuperior) {
+    if (NULL == newDN) {
         /* in delete mode */
-        LDAPMod *mods[2];
-        char *values_del[2];
-        LDAPMod attribute1;
-
-        /* delete old dn so set that up */
-        values_del[0] = (char *)slapi_sdn_get_dn(origDN);
-        values_del[1] = NULL;
-        attribute1.mod_type = attrName;
-        attribute1.mod_op = LDAP_MOD_DELETE;
-        attribute1.mod_values = values_del;
-        mods[0] = &attribute1;
-        /* terminate list of mods. */
-        mods[1] = NULL;
-        rc = _do_modify(mod_pb, entrySDN, mods);
-        if (rc) {
-            slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
-                          "_update_all_per_mod - Entry %s: deleting \"%s: %s\" failed (%d)"
-                          "\n",
-                          slapi_sdn_get_dn(entrySDN), attrName, slapi_sdn_get_dn(origDN), rc);
-        }
-    } else {
-        /* in modrdn mode */
-        const char *superior = NULL;
-        int nval = 0;
-        Slapi_Value *v = NULL;
+        struct berval bv;
 
-        if (NULL == origDN) {
-            slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
-                          "_update_all_per_mod - NULL dn was passed\n");
-            goto bail;
+        /*
+         * The entry was found through any of the membership attributes,
+         * only delete the old dn from the ones actually holding it.
+         */
+        bv.bv_val = (char *)slapi_sdn_get_dn(origDN);
+        bv.bv_len = strlen(bv.bv_val);
+        if (slapi_attr_value_find(attr, &bv) == 0) {
+            slapi_mods_add_string(smods, LDAP_MOD_DELETE, attrName, bv.bv_val);
         }
-        /* need to put together rdn into a dn */
-        dnParts = slapi_ldap_explode_dn(slapi_sdn_get_dn(origDN), 0);
-        if (NULL == dnParts) {
-            slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
-                          "_update_all_per_mod - Failed to explode dn %s\n",
-                          slapi_sdn_get_dn(origDN));
-            goto bail;
+        return;
+    }
+
+    /*
+     * in modrdn mode
+     *
+     * Compare the modified dn with the value of
+     * the target attribute of referint to find out
+     * the modified dn is the ancestor (case 2) or
+     * the value itself (case 1).
+     *
+     * E.g.,
+     * (case 1)
+     * modrdn: uid=A,ou=B,o=C --> uid=A',ou=B',o=C
+     *            (origDN)             (newDN)
+     * member: uid=A,ou=B,ou=C --> uid=A',ou=B',ou=C
+     *            (sval)               (newDN)
+     *
+     * (case 2)
+     * modrdn: ou=B,o=C --> ou=B',o=C
+     *         (origDN)      (newDN)
+     * member: uid=A,ou=B,ou=C --> uid=A,ou=B',ou=C
+     *         (sval)              (sval' + newDN)
+     */
+    for (nval = slapi_attr_first_value(attr, &v);
+         nval != -1;
+         nval = slapi_attr_next_value(attr, nval, &v)) {
+        int normalize_rc;
+        p = NULL;
+        dnlen = 0;
+
+        /* DN syntax, which should be a string */
+        sval = slapi_ch_strdup(slapi_value_get_string(v));
+        normalize_rc = slapi_dn_normalize_case_ext(sval, 0, &p, &dnlen);
+        if (normalize_rc == 0) { /* sval is passed in; not terminated */
+            *(p + dnlen) = '\0';
+            sval = p;
+        } else if (normalize_rc > 0) {
+            slapi_ch_free_string(&sval);
+            sval = p;
         }
-        if (NULL == newRDN) {
-            newRDN = dnParts[0];
+        /* else: normalize_rc < 0) Ignore the DN normalization error for now. */
+
+        p = PL_strstr(sval, slapi_sdn_get_ndn(origDN));
+        if (p == sval) {
+            /* (case 1) */
+            slapi_mods_add_string(smods, LDAP_MOD_DELETE, attrName, sval);
+            slapi_mods_add_string(smods, LDAP_MOD_ADD, attrName, newDN);
+        } else if (p) {
+            /* (case 2) */
+            slapi_mods_add_string(smods, LDAP_MOD_DELETE, attrName, sval);
+            *p = '\0';
+            newvalue = slapi_ch_smprintf("%s%s", sval, newDN);
+            slapi_mods_add_string(smods, LDAP_MOD_ADD, attrName, newvalue);
+            slapi_ch_free_string(&newvalue);
         }
-        if (newsuperior) {
-            superior = newsuperior;
+        /* else: value does not include the modified DN.  Ignore it. */
+        slapi_ch_free_string(&sval);
+    }
+}
+
+/*
+ * Build a single filter matching origDN in any of the membership
+ * attributes, e.g. (|(member=dn)(uniquemember=dn)), so the backend
+ * resolves all the attribute indexes in one search.
+ */
+static char *
+_referint_build_filter(char **membership_attrs, const char *origDN, int subtree)
+{
+    char *filter = NULL;
+    char *tmp = NULL;
+    char *f = NULL;
+    size_t nattrs = 0;
+
+    for (size_t i = 0; membership_attrs[i] != NULL; i++) {
+        if (subtree) {
+            /* we need to check the children of the old dn, so use a wildcard */
+            f = slapi_filter_sprintf("(%s=*%s%s)", membership_attrs[i], ESC_NEXT_VAL, origDN);
         } else {
-            /* do not free superior */
-            superior = slapi_dn_find_parent(slapi_sdn_get_dn(origDN));
+            f = slapi_filter_sprintf("(%s=%s%s)", membership_attrs[i], ESC_NEXT_VAL, origDN);
         }
-        /* newRDN and superior are already normalized. */
-        newDN = slapi_ch_smprintf("%s,%s", newRDN, superior);
-        slapi_dn_ignore_case(newDN);
-        /*
-         * Compare the modified dn with the value of
-         * the target attribute of referint to find out
-         * the modified dn is the ancestor (case 2) or
-         * the value itself (case 1).
-         *
-         * E.g.,
-         * (case 1)
-         * modrdn: uid=A,ou=B,o=C --> uid=A',ou=B',o=C
-         *            (origDN)             (newDN)
-         * member: uid=A,ou=B,ou=C --> uid=A',ou=B',ou=C
-         *            (sval)               (newDN)
-         *
-         * (case 2)
-         * modrdn: ou=B,o=C --> ou=B',o=C
-         *         (origDN)      (newDN)
-         * member: uid=A,ou=B,ou=C --> uid=A,ou=B',ou=C
-         *         (sval)              (sval' + newDN)
-         */
-        slapi_attr_get_numvalues(attr, &nval);
-        smods = slapi_mods_new();
-        slapi_mods_init(smods, 2 * nval + 1);
-
-        for (nval = slapi_attr_first_value(attr, &v);
-             nval != -1;
-             nval = slapi_attr_next_value(attr, nval, &v)) {
-            int normalize_rc;
-            p = NULL;
-            dnlen = 0;
-
-            /* DN syntax, which should be a string */
-            sval = slapi_ch_strdup(slapi_value_get_string(v));
-            normalize_rc = slapi_dn_normalize_case_ext(sval, 0, &p, &dnlen);
-            if (normalize_rc == 0) { /* sval is passed in; not terminated */
-                *(p + dnlen) = '\0';
-                sval = p;
-            } else if (normalize_rc > 0) {
-                slapi_ch_free_string(&sval);
-                sval = p;
+        if (f == NULL) {
+            continue;
+        }
+        tmp = filter;
+        filter = slapi_ch_smprintf("%s%s", tmp ? tmp : "", f);
+        slapi_ch_free_string(&tmp);
+        slapi_ch_free_string(&f);
+        nattrs++;
+    }
+    if (nattrs > 1) {
+        tmp = filter;
+        filter = slapi_ch_smprintf("(|%s)", tmp);
+        slapi_ch_free_string(&tmp);
+    }
+
+    return filter;
+}
+
+/*
+ * Update the references to origSDN held by the entries below search_base.
+ *
+ * All the membership attributes are looked up in one search, and all the
+ * changes needed on a referencing entry (one value per attribute in delete
+ * mode, a DEL+ADD pair per value in modrdn mode) are coalesced into one
+ * modify of that entry.  *updated is incremented for each modified entry.
+ */
+static int
+_update_integrity_be(Slapi_Backend *be,
+                     const char *search_base,
+                     char **membership_attrs,
+                     Slapi_DN *origSDN,
+                     char *newrDN,
+                     const char *newDN,
+                     Slapi_PBlock *search_result_pb,
+                     Slapi_PBlock *mod_pb,
+                     Slapi_PBlock *pb,
+                     size_t *updated)
+{
+    Slapi_Entry **search_entries = NULL;
+    Slapi_Attr *attr = NULL;
+    char *attrName = NULL;
+    char *filter = NULL;
+    int search_result;
+    int rc = SLAPI_PLUGIN_SUCCESS;
+
+    filter = _referint_build_filter(membership_attrs, slapi_sdn_get_dn(origSDN), newrDN != NULL);
+    if (filter == NULL) {
+        return rc;
+    }
+
+    /* Need only the membership attributes and their subtypes */
+    slapi_pblock_init(search_result_pb);
+    slapi_pblock_set(search_result_pb, SLAPI_BACKEND, be);
+    slapi_search_internal_set_pb(search_result_pb, search_base,
+                                 LDAP_SCOPE_SUBTREE, filter, membership_attrs, 0 /* attrs only */,
+                                 NULL, NULL, referint_plugin_identity, 0);
+    slapi_search_internal_pb(search_result_pb);
+
+    slapi_pblock_get(search_result_pb, SLAPI_PLUGIN_INTOP_RESULT, &search_result);
+
+    /* if search successfull then do integrity update */
+    if (search_result == LDAP_SUCCESS) {
+        slapi_pblock_get(search_result_pb, SLAPI_PLUGIN_INTOP_SEARCH_ENTRIES,
+                         &search_entries);
+
+        for (size_t j = 0; search_entries && search_entries[j] != NULL; j++) {
+            Slapi_Mods smods;
+
+            slapi_mods_init(&smods, 0);
+            /*
+             *  Loop over all the attributes of the entry and collect
+             *  the changes for the integrity attributes and their subtypes
+             */
+            for (slapi_entry_first_attr(search_entries[j], &attr); attr;
+                 slapi_entry_next_attr(search_entries[j], attr, &attr)) {
+                slapi_attr_get_type(attr, &attrName);
+                for (size_t i = 0; membership_attrs[i] != NULL; i++) {
+                    if (slapi_attr_type_cmp(membership_attrs[i], attrName,
+                                            SLAPI_TYPE_CMP_SUBTYPE) == 0) {
+                        _referint_add_mods(&smods, attr, attrName, origSDN, newDN);
+                        break;
+                    }
+                }
             }
-            /* else: normalize_rc < 0) Ignore the DN normalization error for now. */
-
-            p = PL_strstr(sval, slapi_sdn_get_ndn(origDN));
-            if (p == sval) {
-                /* (case 1) */
-                slapi_mods_add_string(smods, LDAP_MOD_DELETE, attrName, sval);
-                slapi_mods_add_string(smods, LDAP_MOD_ADD, attrName, newDN);
-            } else if (p) {
-                /* (case 2) */
-                slapi_mods_add_string(smods, LDAP_MOD_DELETE, attrName, sval);
-                *p = '\0';
-                newvalue = slapi_ch_smprintf("%s%s", sval, newDN);
-                slapi_mods_add_string(smods, LDAP_MOD_ADD, attrName, newvalue);
-                slapi_ch_free_string(&newvalue);
+
+            if (slapi_mods_get_num_mods(&smods) > 0) {
+                rc = _update_entry(mod_pb, slapi_entry_get_sdn(search_entries[j]), &smods);
+                if (rc) {
+                    slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
+                                  "_update_integrity_be - Entry %s: updating references to \"%s\" failed (%d)\n",
+                                  slapi_entry_get_dn_const(search_entries[j]),
+                                  slapi_sdn_get_dn(origSDN), rc);
+                    if (use_txn) {
+                        /*
+                         * We're using backend transactions,
+                         * so we need to stop on failure.
+                         */
+                        if (pb) {
+                            /* Set the error code of the failure */
+                            slapi_pblock_set(pb, SLAPI_RESULT_CODE, &rc);
+                        }
+                        rc = SLAPI_PLUGIN_FAILURE;
+                        slapi_mods_done(&smods);
+                        break;
+                    } else {
+                        rc = SLAPI_PLUGIN_SUCCESS;
+                    }
+                } else if (updated) {
+                    (*updated)++;
+                }
             }
-            /* else: value does not include the modified DN.  Ignore it. */
-            slapi_ch_free_string(&sval);
-        }
-        rc = _do_modify(mod_pb, entrySDN, slapi_mods_get_ldapmods_byref(smods));
-        if (rc) {
-            slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
-                          "_update_all_per_mod - Entry %s failed (%d)\n",
-                          slapi_sdn_get_dn(entrySDN), rc);
+            slapi_mods_done(&smods);
         }
-
-        /* cleanup memory allocated for dnParts and newDN */
-        if (dnParts) {
-            slapi_ldap_value_free(dnParts);
-            dnParts = NULL;
+    } else if (isFatalSearchError(search_result)) {
+        slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
+                      "_update_integrity_be - Search (base=%s filter=%s) returned "
+                      "error %d\n",
+                      search_base, filter, search_result);
+        if (pb) {
+            slapi_pblock_set(pb, SLAPI_RESULT_CODE, &search_result);
         }
-        slapi_ch_free_string(&newDN);
-        slapi_mods_free(&smods);
+        rc = SLAPI_PLUGIN_FAILURE;
     }
 
-bail:
+    slapi_free_search_results_internal(search_result_pb);
+    slapi_ch_free_string(&filter);
+
     return rc;
 }
 
@@ -1124,28 +1208,24 @@ update_integrity(Slapi_DN *origSDN,
                  Slapi_PBlock *pb)
 {
     Slapi_PBlock *search_result_pb = NULL;
-    Slapi_PBlock *mod_pb = slapi_pblock_new();
-    Slapi_Entry **search_entries = NULL;
+    Slapi_PBlock *mod_pb = NULL;
     Slapi_DN *sdn = NULL;
-    Slapi_Attr *attr = NULL;
     void *node = NULL;
-    const char *origDN = slapi_sdn_get_dn(origSDN);
-    const char *search_base = NULL;
-    char *attrName = NULL;
-    char *filter = NULL;
-    char *attrs[2];
     char **membership_attrs = NULL;
-    int search_result;
-    int nval = 0;
-    int i, j;
+    char *newDN = NULL;
     int rc = SLAPI_PLUGIN_SUCCESS;
 
+    if (newrDN || newsuperior) {
+        /* in modrdn mode */
+        newDN = _referint_new_dn(origSDN, newrDN, slapi_sdn_get_dn(newsuperior));
+        if (newDN == NULL) {
+            return rc;
+        }
+    }
+
     membership_attrs = referint_get_attrs();
-    /*
-     *  For now, just putting attributes to keep integrity on in conf file,
-     *  until resolve the other timing mode issue
-     */
     search_result_pb = slapi_pblock_new();
+    mod_pb = slapi_pblock_new();
 
     /* Search each namingContext in turn
      * or use the defined scope(s)
@@ -1156,115 +1236,11 @@ update_integrity(Slapi_DN *origSDN,
         sdn = slapi_get_first_suffix(&node, 0);
     }
     while (sdn) {
-        Slapi_Backend *be = slapi_be_select(sdn);
-        search_base = slapi_sdn_get_dn(sdn);
-
-        for (i = 0; membership_attrs[i] != NULL; i++) {
-            if (newrDN) {
-                /* we need to check the children of the old dn, so use a wildcard */
-                filter = slapi_filter_sprintf("(%s=*%s%s)", membership_attrs[i], ESC_NEXT_VAL, origDN);
-            } else {
-                filter = slapi_filter_sprintf("(%s=%s%s)", membership_attrs[i], ESC_NEXT_VAL, origDN);
-            }
-            if (filter) {
-                /* Need only the current attribute and its subtypes */
-                attrs[0] = membership_attrs[i];
-                attrs[1] = NULL;
-
-                /* Use new search API */
-                slapi_pblock_init(search_result_pb);
-                slapi_pblock_set(search_result_pb, SLAPI_BACKEND, be);
-                slapi_search_internal_set_pb(search_result_pb, search_base,
-                                             LDAP_SCOPE_SUBTREE, filter, attrs, 0 /* attrs only */,
-                                             NULL, NULL, referint_plugin_identity, 0);
-                slapi_search_internal_pb(search_result_pb);
-
-                slapi_pblock_get(search_result_pb, SLAPI_PLUGIN_INTOP_RESULT, &search_result);
-
-                /* if search successfull then do integrity update */
-                if (search_result == LDAP_SUCCESS) {
-                    slapi_pblock_get(search_result_pb, SLAPI_PLUGIN_INTOP_SEARCH_ENTRIES,
-                                     &search_entries);
-
-                    for (j = 0; search_entries[j] != NULL; j++) {
-                        attr = NULL;
-                        attrName = NULL;
-                        /*
-                         *  Loop over all the attributes of the entry and search
-                         *  for the integrity attribute and its subtypes
-                         */
-                        for (slapi_entry_first_attr(search_entries[j], &attr); attr;
-                             slapi_entry_next_attr(search_entries[j], attr, &attr)) {
-                            /*
-                             *  Take into account only the subtypes of the attribute
-                             *  in argv[i] having the necessary value  - origDN
-                             */
-                            slapi_attr_get_type(attr, &attrName);
-                            if (slapi_attr_type_cmp(membership_attrs[i], attrName,
-                                                    SLAPI_TYPE_CMP_SUBTYPE) == 0) {
-                                nval = 0;
-                                slapi_attr_get_numvalues(attr, &nval);
-                                /*
-                                 * We want to reduce the "modify" call as much as
-                                 * possible. But if an entry contains 1000s of
-                                 * attributes which need to be updated by the
-                                 * referint plugin (e.g., a group containing 1000s
-                                 * of members), we want to avoid to allocate too
-                                 * many mods * in one "modify" call.
-                                 * This is a compromise: If an attribute type has
-                                 * more than 128 values, we update the attribute
-                                 * value one by one. Otherwise, update all values
-                                 * in one "modify" call.
-                                 */
-                                if (nval > 128) {
-                                    rc = _update_one_per_mod(
-                                        slapi_entry_get_sdn(search_entries[j]),
-                                        attr, attrName, origSDN, newrDN,
-                                        slapi_sdn_get_dn(newsuperior),
-                                        mod_pb);
-                                } else {
-                                    rc = _update_all_per_mod(
-                                        slapi_entry_get_sdn(search_entries[j]),
-                                        attr, attrName, origSDN, newrDN,
-                                        slapi_sdn_get_dn(newsuperior),
-                                        mod_pb);
-                                }
-                                if (rc) {
-                                    if (use_txn) {
-                                        /*
-                                         * We're using backend transactions,
-                                         * so we need to stop on failure.
-                                         */
-                                        if (pb) {
-                                            /* Set the error code of the failure */
-                                            slapi_pblock_set(pb, SLAPI_RESULT_CODE, &rc);
-                                        }
-                                        rc = SLAPI_PLUGIN_FAILURE;
-                                        goto free_and_return;
-                                    } else {
-                                        rc = SLAPI_PLUGIN_SUCCESS;
-                                    }
-                                }
-                            }
-                        }
-                    }
-                } else {
-                    if (isFatalSearchError(search_result)) {
-                        slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
-                                      "update_integrity - Search (base=%s filter=%s) returned "
-                                      "error %d\n",
-                                      search_base, filter, search_result);
-                        slapi_free_search_results_internal(search_result_pb);
-                        if (pb) {
-                            slapi_pblock_set(pb, SLAPI_RESULT_CODE, &search_result);
-                        }
-                        rc = SLAPI_PLUGIN_FAILURE;
-                        goto free_and_return;
-                    }
-                }
-                slapi_ch_free_string(&filter);
-                slapi_free_search_results_internal(search_result_pb);
-            }
+        rc = _update_integrity_be(slapi_be_select(sdn), slapi_sdn_get_dn(sdn),
+                                  membership_attrs, origSDN, newrDN, newDN,
+                                  search_result_pb, mod_pb, pb, NULL);
+        if (rc != SLAPI_PLUGIN_SUCCESS) {
+            break;
         }
         if (plugin_ContainerScope) {
             /* at the moment only a single scope is supported
@@ -1276,14 +1252,11 @@ update_integrity(Slapi_DN *origSDN,
         }
     }
 
-
-free_and_return:
-    /* free filter and search_results_pb */
-    slapi_ch_free_string(&filter);
+    slapi_ch_free_string(&newDN);
     slapi_ch_array_free(membership_attrs);
-
     slapi_pblock_destroy(mod_pb);
     slapi_pblock_destroy(search_result_pb);
+
     return (rc);
 }
 
@@ -1358,7 +1331,7 @@ referint_postop_start(Slapi_PBlock *pb)
         pthread_condattr_t condAttr;
 
         /* initialize the cv and lock */
-        if (!use_txn && (NULL == referint_mutex)) {
+        if (NULL == referint_mutex) {
             referint_mutex = PR_NewLock();
         }
         if ((rc = pthread_mutex_init(&keeprunning_mutex, NULL)) != 0) {
@@ -1446,153 +1419,508 @@ referint_postop_close(Slapi_PBlock *pb __attribute__((unused)))
     return (0);
 }
 
-void
-referint_thread_func(void *arg __attribute__((unused)))
+static int
+referint_keeprunning(void)
 {
-    slapi_set_thread_name("referint");
-    PRFileDesc *prfd = NULL;
-    char *logfilename = NULL;
-    char thisline[MAX_LINE];
-    char delimiter[] = "\t\n";
-    char *ptoken;
-    char *tmprdn;
-    char *iter = NULL;
-    Slapi_DN *sdn = NULL;
-    Slapi_DN *tmpsuperior = NULL;
-    struct timespec current_time = {0};
-    int delay;
-    int no_changes;
+    int running;
 
-    slapi_atomic_store_64(&batch_thread_running, 1, __ATOMIC_RELEASE);
+    pthread_mutex_lock(&keeprunning_mutex);
+    running = keeprunning;
+    pthread_mutex_unlock(&keeprunning_mutex);
 
-    /*
-     * keep running this thread until plugin is signaled to close
-     */
-    while (1) {
-        /*
-         * In case of shutdown, plugin close function (referint_postop_close)
-         * is waiting for the end of that thread to do the cleanup
-         */
-        pthread_mutex_lock(&keeprunning_mutex);
-        if (keeprunning == 0) {
-            pthread_mutex_unlock(&keeprunning_mutex);
-            break;
-        }
-        pthread_mutex_unlock(&keeprunning_mutex);
+    return running;
+}
 
-        /* refresh the config */
-        slapi_ch_free_string(&logfilename);
-        referint_get_config(&delay, &logfilename);
+static void
+referint_updates_free(referint_update **updates, size_t *nupdates)
+{
+    for (size_t i = 0; *updates && i < *nupdates; i++) {
+        slapi_sdn_free(&(*updates)[i].sdn);
+        slapi_ch_free_string(&(*updates)[i].newrdn);
+        slapi_sdn_free(&(*updates)[i].newsuperior);
+        slapi_ch_free_string(&(*updates)[i].requestor);
+    }
+    slapi_ch_free((void **)updates);
+    *nupdates = 0;
+}
+
+/*
+ * Append an update to the array, fields are passed in.  Repeated deletes of
+ * the same entry are collapsed: applying the first one removes every
+ * reference, so the following ones would not find anything to update.
+ * A modrdn moving an entry onto a deleted dn ends that run: the references
+ * it creates must be removed by the next delete of that dn.
+ */
+static void
+referint_updates_add(referint_update **updates, size_t *nupdates, size_t *size,
+                     PLHashTable *deleted, char *dn, char *newrdn, char *newsuperior, char *requestor)
+{
+    referint_update *u;
 
-        no_changes = 1;
-        while (no_changes) {
+    if (newrdn == NULL && newsuperior == NULL) {
+        Slapi_DN *sdn = slapi_sdn_new_dn_byref(dn);
+        const char *ndn = slapi_sdn_get_ndn(sdn);
 
-            pthread_mutex_lock(&keeprunning_mutex);
-            if (keeprunning == 0) {
-                pthread_mutex_unlock(&keeprunning_mutex);
-                break;
-            }
-            pthread_mutex_unlock(&keeprunning_mutex);
-
-            referint_lock();
-            if ((prfd = PR_Open(logfilename, PR_RDONLY, REFERINT_DEFAULT_FILE_MODE)) == NULL) {
-                referint_unlock();
-                /* go back to sleep and wait for this file */
-                pthread_mutex_lock(&keeprunning_mutex);
-                clock_gettime(CLOCK_MONOTONIC, &current_time);
-                current_time.tv_sec += delay;
-                pthread_cond_timedwait(&keeprunning_cv, &keeprunning_mutex, &current_time);
-                pthread_mutex_unlock(&keeprunning_mutex);
-            } else {
-                no_changes = 0;
-            }
+        if (ndn && PL_HashTableLookupConst(deleted, ndn)) {
+            slapi_sdn_free(&sdn);
+            slapi_ch_free_string(&dn);
+            slapi_ch_free_string(&requestor);
+            return;
         }
-        /*
-         *  Check keep running here, because after break out of no
-         *  changes loop on shutdown, also need to break out of this
-         *  loop before trying to do the changes. The server
-         *  will pick them up on next startup as file still exists
-         */
-        pthread_mutex_lock(&keeprunning_mutex);
-        if (keeprunning == 0) {
-            pthread_mutex_unlock(&keeprunning_mutex);
-            break;
+        if (ndn) {
+            char *key = slapi_ch_strdup(ndn);
+            PL_HashTableAdd(deleted, key, key);
         }
-        pthread_mutex_unlock(&keeprunning_mutex);
+        slapi_sdn_free(&sdn);
+    } else {
+        Slapi_DN *sdn = slapi_sdn_new_dn_byref(dn);
+        Slapi_DN *newsdn = NULL;
+        char *newdn = _referint_new_dn(sdn, newrdn, newsuperior);
+        char *key = NULL;
+
+        if (newdn) {
+            newsdn = slapi_sdn_new_dn_passin(newdn);
+            key = (char *)PL_HashTableLookup(deleted, slapi_sdn_get_ndn(newsdn));
+            if (key) {
+                PL_HashTableRemove(deleted, key);
+                slapi_ch_free_string(&key);
+            }
+            slapi_sdn_free(&newsdn);
+        }
+        slapi_sdn_free(&sdn);
+    }
 
-        while (GetNextLine(thisline, MAX_LINE, prfd)) {
-            ptoken = ldap_utf8strtok_r(thisline, delimiter, &iter);
-            sdn = slapi_sdn_new_normdn_byref(ptoken);
-            ptoken = ldap_utf8strtok_r(NULL, delimiter, &iter);
+    if (*nupdates == *size) {
+        *size = *size ? *size * 2 : 64;
+        *updates = (referint_update *)slapi_ch_realloc((char *)*updates, *size * sizeof(referint_update));
+    }
+    u = &(*updates)[(*nupdates)++];
+    u->sdn = slapi_sdn_new_normdn_passin(dn);
+    u->newrdn = newrdn;
+    u->newsuperior = newsuperior ? slapi_sdn_new_normdn_passin(newsuperior) : NULL;
+    u->requestor = requestor;
+}
 
-            if (ptoken == NULL) {
-                /* Invalid line in referint log, skip it */
-                slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
-                        "Skipping invalid referint log line: (%s)\n", thisline);
-                slapi_sdn_free(&sdn);
-                continue;
-            }
-            if (!strcasecmp(ptoken, "NULL")) {
-                tmprdn = NULL;
-            } else {
-                tmprdn = slapi_ch_smprintf("%s", ptoken);
-            }
+static PRIntn
+referint_free_hash_key(PLHashEntry *he, PRIntn index __attribute__((unused)), void *arg __attribute__((unused)))
+{
+    slapi_ch_free((void **)&he->key);
+    return HT_ENUMERATE_REMOVE;
+}
 
-            ptoken = ldap_utf8strtok_r(NULL, delimiter, &iter);
-            if (ptoken == NULL) {
-                /* Invalid line in referint log, skip it */
-                slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
-                        "Skipping invalid referint log line: (%s)\n", thisline);
-                slapi_sdn_free(&sdn);
-                continue;
-            }
+static uint32_t
+referint_queue_get32(const unsigned char *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
 
-            slapi_sdn_free(&tmpsuperior);
-            if (!strcasecmp(ptoken, "NULL")) {
-                tmpsuperior = NULL;
-            } else {
-                tmpsuperior = slapi_sdn_new_normdn_byref(ptoken);
+static void
+referint_queue_put32(unsigned char *p, uint32_t v)
+{
+    p[0] = (v >> 24) & 0xff;
+    p[1] = (v >> 16) & 0xff;
+    p[2] = (v >> 8) & 0xff;
+    p[3] = v & 0xff;
+}
+
+/* FNV-1a, only used to detect torn or corrupted records */
+static uint32_t
+referint_queue_checksum(const unsigned char *p, size_t len)
+{
+    uint32_t h = 2166136261U;
+
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 16777619U;
+    }
+    return h;
+}
+
+/*
+ * Parse the records of a binary queue.  Parsing stops at the first record
+ * that is truncated or doesn't match its checksum, the valid records read
+ * so far are kept.
+ */
+static void
+referint_queue_parse(const char *filename, const unsigned char *buf, size_t len,
+                     referint_update **updates, size_t *nupdates, PLHashTable *deleted)
+{
+    size_t size = 0;
+    size_t pos = REFERINT_QUEUE_MAGIC_LEN;
+
+    while (pos < len) {
+        char *fields[REFERINT_QUEUE_NFIELDS] = {0};
+        const unsigned char *payload;
+        uint32_t paylen;
+        size_t fpos = 0;
+        int bad = 0;
+
+        if (len - pos < 8) {
+            bad = 1;
+        } else {
+            paylen = referint_queue_get32(buf + pos);
+            payload = buf + pos + 8;
+            if (len - pos - 8 < paylen ||
+                referint_queue_checksum(payload, paylen) != referint_queue_get32(buf + pos + 4)) {
+                bad = 1;
             }
+        }
+        for (size_t i = 0; !bad && i < REFERINT_QUEUE_NFIELDS; i++) {
+            uint32_t flen;
 
-            ptoken = ldap_utf8strtok_r(NULL, delimiter, &iter);
-            if (ptoken == NULL) {
-                /* Invalid line in referint log, skip it */
-                slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
-                        "Skipping invalid referint log line: (%s)\n", thisline);
-                slapi_sdn_free(&sdn);
+            if (paylen - fpos < 4) {
+                bad = 1;
+                break;
+            }
+            flen = referint_queue_get32(payload + fpos);
+            fpos += 4;
+            if (flen == REFERINT_QUEUE_NULL_FIELD) {
                 continue;
             }
-            if (strcasecmp(ptoken, "NULL") != 0) {
-                /* Set the bind DN in the thread data */
-                if (slapi_td_set_dn(slapi_ch_strdup(ptoken))) {
-                    slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM, "referint_thread_func - "
-                                                                            "Failed to set thread data\n");
-                }
+            if (paylen - fpos < flen) {
+                bad = 1;
+                break;
             }
+            fields[i] = slapi_ch_malloc(flen + 1);
+            memcpy(fields[i], payload + fpos, flen);
+            fields[i][flen] = '\0';
+            fpos += flen;
+        }
+        if (bad || fields[0] == NULL) {
+            slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
+                          "referint_queue_parse - Skipping invalid data at offset %lu of \"%s\"\n",
+                          (unsigned long)pos, filename);
+            for (size_t i = 0; i < REFERINT_QUEUE_NFIELDS; i++) {
+                slapi_ch_free_string(&fields[i]);
+            }
+            break;
+        }
+        referint_updates_add(updates, nupdates, &size, deleted,
+                             fields[0], fields[1], fields[2], fields[3]);
+        pos += 8 + paylen;
+    }
+}
 
-            update_integrity(sdn, tmprdn, tmpsuperior, NULL);
+/*
+ * Parse a queue written by an older version of the plugin: one update per
+ * line, "dn\tnewrdn\tnewsuperior\trequestor\t", missing values set to "NULL".
+ */
+static void
+referint_queue_parse_legacy(const char *filename, char *buf,
+                            referint_update **updates, size_t *nupdates, PLHashTable *deleted)
+{
+    char delimiter[] = "\t\n";
+    char *line_iter = NULL;
+    char *iter = NULL;
+    char *line;
+    size_t size = 0;
 
-            slapi_sdn_free(&sdn);
-            slapi_ch_free_string(&tmprdn);
-            slapi_sdn_free(&tmpsuperior);
+    for (line = ldap_utf8strtok_r(buf, "\n", &line_iter); line;
+         line = ldap_utf8strtok_r(NULL, "\n", &line_iter)) {
+        char *fields[REFERINT_QUEUE_NFIELDS] = {0};
+        size_t i;
+
+        fields[0] = ldap_utf8strtok_r(line, delimiter, &iter);
+        for (i = 1; fields[i - 1] && i < REFERINT_QUEUE_NFIELDS; i++) {
+            fields[i] = ldap_utf8strtok_r(NULL, delimiter, &iter);
+        }
+        if (fields[REFERINT_QUEUE_NFIELDS - 1] == NULL) {
+            /* Invalid line in referint log, skip it */
+            slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
+                          "Skipping invalid referint log line in \"%s\": (%s)\n", filename, line);
+            continue;
+        }
+        for (i = 0; i < REFERINT_QUEUE_NFIELDS; i++) {
+            fields[i] = (i > 0 && !strcasecmp(fields[i], "NULL")) ? NULL : slapi_ch_strdup(fields[i]);
+        }
+        referint_updates_add(updates, nupdates, &size, deleted,
+                             fields[0], fields[1], fields[2], fields[3]);
+    }
+}
+
+/*
+ * Read all the updates queued in filename.  Returns 0 on success.
+ */
+static int
+referint_queue_load(const char *filename, referint_update **updates, size_t *nupdates)
+{
+    PRFileDesc *prfd = NULL;
+    PRFileInfo64 info;
+    PLHashTable *deleted = NULL;
+    char *buf = NULL;
+    PRInt32 nread = 0;
+    int rc = 0;
+
+    *updates = NULL;
+    *nupdates = 0;
+
+    if ((prfd = PR_Open(filename, PR_RDONLY, REFERINT_DEFAULT_FILE_MODE)) == NULL ||
+        PR_GetOpenFileInfo64(prfd, &info) != PR_SUCCESS || info.size > PR_INT32_MAX) {
+        slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
+                      "referint_queue_load - Could not read \"%s\" " SLAPI_COMPONENT_NAME_NSPR " %d (%s)\n",
+                      filename, PR_GetError(), slapd_pr_strerror(PR_GetError()));
+        rc = -1;
+        goto done;
+    }
+
+    buf = slapi_ch_malloc(info.size + 1);
+    while (nread < info.size) {
+        PRInt32 n = PR_Read(prfd, buf + nread, (PRInt32)(info.size - nread));
+        if (n <= 0) {
+            break;
         }
+        nread += n;
+    }
+    buf[nread] = '\0';
 
+    deleted = PL_NewHashTable(0, PL_HashString, PL_CompareStrings, PL_CompareValues, NULL, NULL);
+    if (nread >= REFERINT_QUEUE_MAGIC_LEN && memcmp(buf, REFERINT_QUEUE_MAGIC, REFERINT_QUEUE_MAGIC_LEN) == 0) {
+        referint_queue_parse(filename, (unsigned char *)buf, (size_t)nread, updates, nupdates, deleted);
+    } else {
+        referint_queue_parse_legacy(filename, buf, updates, nupdates, deleted);
+    }
+    PL_HashTableEnumerateEntries(deleted, referint_free_hash_key, NULL);
+    PL_HashTableDestroy(deleted);
+
+done:
+    if (prfd) {
         PR_Close(prfd);
+    }
+    slapi_ch_free_string(&buf);
+
+    return rc;
+}
+
+/*
+ * Apply one queued update to the referencing entries below search_base.
+ */
+static int
+referint_apply_update(referint_update *u, Slapi_Backend *be, const char *search_base,
+                      char **membership_attrs, Slapi_PBlock *search_pb, Slapi_PBlock *mod_pb,
+                      size_t *updated)
+{
+    char *newDN = NULL;
+    int rc;
+
+    if (u->requestor) {
+        /* Set the bind DN in the thread data */
+        if (slapi_td_set_dn(slapi_ch_strdup(u->requestor))) {
+            slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM, "referint_apply_update - "
+                                                                    "Failed to set thread data\n");
+        }
+    }
+    if (u->newrdn || u->newsuperior) {
+        newDN = _referint_new_dn(u->sdn, u->newrdn, slapi_sdn_get_dn(u->newsuperior));
+        if (newDN == NULL) {
+            return SLAPI_PLUGIN_SUCCESS;
+        }
+    }
+    rc = _update_integrity_be(be, search_base, membership_attrs, u->sdn, u->newrdn, newDN,
+                              search_pb, mod_pb, NULL, updated);
+    slapi_ch_free_string(&newDN);
+
+    return rc;
+}
+
+/*
+ * Apply the queued updates to one suffix.
+ *
+ * When the plugin is a betxn plugin the modifies are grouped into backend
+ * transactions covering up to batch_size referencing entries, instead of
+ * committing each one separately.  If a grouped transaction fails it is
+ * aborted and its updates are replayed one at a time, so that one entry
+ * that can't be updated doesn't hold back the rest of the batch.
+ *
+ * Returns -1 if the server is shutting down before all the updates were
+ * applied.
+ */
+static int
+referint_apply_updates_be(referint_update *updates, size_t nupdates, int batch_size,
+                          Slapi_DN *suffix, char **membership_attrs)
+{
+    Slapi_Backend *be = slapi_be_select(suffix);
+    const char *search_base = slapi_sdn_get_dn(suffix);
+    Slapi_PBlock *search_pb = slapi_pblock_new();
+    Slapi_PBlock *mod_pb = slapi_pblock_new();
+    Slapi_PBlock *txn_pb = NULL;
+    size_t first = 0;
+    size_t updated = 0;
+    int rc = 0;
 
-        /* remove the original file */
-        if (PR_SUCCESS != PR_Delete(logfilename)) {
+    for (size_t i = 0; i < nupdates; i++) {
+        if (!referint_keeprunning()) {
+            rc = -1;
+            break;
+        }
+        if (use_txn && txn_pb == NULL) {
+            txn_pb = slapi_pblock_new();
+            slapi_pblock_set(txn_pb, SLAPI_BACKEND, be);
+            if (slapi_back_transaction_begin(txn_pb) != LDAP_SUCCESS) {
+                slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
+                              "referint_apply_updates_be - Failed to start transaction on %s\n",
+                              search_base);
+                slapi_pblock_destroy(txn_pb);
+                txn_pb = NULL;
+            }
+            first = i;
+            updated = 0;
+        }
+
+        if (referint_apply_update(&updates[i], be, search_base, membership_attrs,
+                                  search_pb, mod_pb, &updated) != SLAPI_PLUGIN_SUCCESS && txn_pb) {
             slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
-                          "referint_thread_func - Could not delete \"%s\"\n", logfilename);
+                          "referint_apply_updates_be - Batch of %lu updates failed on %s, "
+                          "applying them one by one\n",
+                          (unsigned long)(i - first + 1), search_base);
+            slapi_back_transaction_abort(txn_pb);
+            slapi_pblock_destroy(txn_pb);
+            txn_pb = NULL;
+            for (size_t j = first; j <= i; j++) {
+                referint_apply_update(&updates[j], be, search_base, membership_attrs,
+                                      search_pb, mod_pb, NULL);
+            }
+            continue;
+        }
+
+        if (txn_pb && updated >= (size_t)batch_size) {
+            slapi_back_transaction_commit(txn_pb);
+            slapi_pblock_destroy(txn_pb);
+            txn_pb = NULL;
+        }
+    }
+    if (txn_pb) {
+        slapi_back_transaction_commit(txn_pb);
+        slapi_pblock_destroy(txn_pb);
+        txn_pb = NULL;
+    }
+
+    slapi_pblock_destroy(mod_pb);
+    slapi_pblock_destroy(search_pb);
+
+    return rc;
+}
+
+static int
+referint_apply_updates(referint_update *updates, size_t nupdates, int batch_size)
+{
+    char **membership_attrs = referint_get_attrs();
+    Slapi_DN *sdn = NULL;
+    void *node = NULL;
+    int rc = 0;
+
+    /* Search each namingContext in turn
+     * or use the defined scope(s)
+     */
+    if (plugin_ContainerScope) {
+        sdn = plugin_ContainerScope;
+    } else {
+        sdn = slapi_get_first_suffix(&node, 0);
+    }
+    while (sdn && rc == 0) {
+        rc = referint_apply_updates_be(updates, nupdates, batch_size, sdn, membership_attrs);
+        if (plugin_ContainerScope) {
+            /* at the moment only a single scope is supported */
+            sdn = NULL;
+        } else {
+            sdn = slapi_get_next_suffix(&node, 0);
+        }
+    }
+    slapi_ch_array_free(membership_attrs);
+
+    return rc;
+}
+
+/*
+ * Apply the updates queued in filename and remove it.  Returns -1 if the
+ * file must be kept, because the server is shutting down.
+ */
+static int
+referint_replay_file(const char *filename, int batch_size)
+{
+    referint_update *updates = NULL;
+    size_t nupdates = 0;
+    int rc = 0;
+
+    if (PR_Access(filename, PR_ACCESS_EXISTS) != PR_SUCCESS ||
+        referint_queue_load(filename, &updates, &nupdates) != 0) {
+        return 0;
+    }
+    /*
+     * On shutdown the file is kept, the server
+     * will pick the updates up on next startup
+     */
+    rc = referint_apply_updates(updates, nupdates, batch_size);
+    if (rc == 0 && PR_SUCCESS != PR_Delete(filename)) {
+        slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
+                      "referint_replay_file - Could not delete \"%s\"\n", filename);
+    }
+    referint_updates_free(&updates, &nupdates);
+
+    return rc;
+}
+
+void
+referint_thread_func(void *arg __attribute__((unused)))
+{
+    slapi_set_thread_name("referint");
+    char *logfilename = NULL;
+    char *workfilename = NULL;
+    char *legacyfilename = NULL;
+    struct timespec current_time = {0};
+    int batch_size;
+    int delay;
+
+    slapi_atomic_store_64(&batch_thread_running, 1, __ATOMIC_RELEASE);
+
+    /*
+     * keep running this thread until plugin is signaled to close
+     */
+    while (1) {
+        /*
+         * In case of shutdown, plugin close function (referint_postop_close)
+         * is waiting for the end of that thread to do the cleanup
+         */
+        if (!referint_keeprunning()) {
+            break;
+        }
+
+        /* refresh the config */
+        slapi_ch_free_string(&logfilename);
+        slapi_ch_free_string(&workfilename);
+        slapi_ch_free_string(&legacyfilename);
+        referint_get_config(&delay, &logfilename);
+        batch_size = referint_get_batch_size();
+        workfilename = slapi_ch_smprintf("%s%s", logfilename, REFERINT_QUEUE_WORK_SUFFIX);
+        legacyfilename = slapi_ch_smprintf("%s%s", logfilename, REFERINT_QUEUE_LEGACY_SUFFIX);
+
+        /* Updates queued in the text format are older than any other */
+        if (referint_replay_file(legacyfilename, batch_size) != 0) {
+            continue;
         }
 
-        /* unlock and let other writers back at the file */
+        /*
+         * Take ownership of the queued updates, unless a work file was left
+         * over by a previous run: it is replayed first.
+         */
+        referint_lock();
+        if (PR_Access(workfilename, PR_ACCESS_EXISTS) != PR_SUCCESS &&
+            PR_Access(logfilename, PR_ACCESS_EXISTS) == PR_SUCCESS &&
+            PR_Rename(logfilename, workfilename) != PR_SUCCESS) {
+            slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
+                          "referint_thread_func - Could not rename \"%s\" " SLAPI_COMPONENT_NAME_NSPR " %d (%s)\n",
+                          logfilename, PR_GetError(), slapd_pr_strerror(PR_GetError()));
+        }
         referint_unlock();
 
+        referint_replay_file(workfilename, batch_size);
+
         /* wait on condition here */
         pthread_mutex_lock(&keeprunning_mutex);
-        clock_gettime(CLOCK_MONOTONIC, &current_time);
-        current_time.tv_sec += delay;
-        pthread_cond_timedwait(&keeprunning_cv, &keeprunning_mutex, &current_time);
+        if (keeprunning) {
+            clock_gettime(CLOCK_MONOTONIC, &current_time);
+            current_time.tv_sec += delay;
+            pthread_cond_timedwait(&keeprunning_cv, &keeprunning_mutex, &current_time);
+        }
         pthread_mutex_unlock(&keeprunning_mutex);
     }
 
@@ -1602,97 +1930,158 @@ referint_thread_func(void *arg __attribute__((unused)))
     pthread_mutex_destroy(&keeprunning_mutex);
     pthread_cond_destroy(&keeprunning_cv);
     slapi_ch_free_string(&logfilename);
+    slapi_ch_free_string(&workfilename);
+    slapi_ch_free_string(&legacyfilename);
 }
 
-int
-my_fgetc(PRFileDesc *stream)
+/*
+ * Move a queue written in the text format of older versions out of the
+ * way, so that binary records are never appended to text.  Its updates
+ * are added to <logfile>.legacy, replayed by the batch thread.
+ * Must be called with the referint lock held.  Returns -1 if the text queue
+ * is still in place.
+ */
+static int
+referint_queue_set_aside_legacy(const char *logfilename)
 {
-    /* This is equivalent to memset of 0, but statically defined. */
-    static char buf[READ_BUFSIZE] = {0};
-    static int position = READ_BUFSIZE;
-    int retval;
-    int err;
-
-    /* check if we need to load the buffer */
-    if (READ_BUFSIZE == position) {
-        if ((err = PR_Read(stream, buf, READ_BUFSIZE)) >= 0) {
-            /* it read some data */;
-            position = 0;
-        } else {
-            /* an error occurred */
-            return err;
-        }
-    }
-
-    /* try to read some data */
-    if ('\0' == buf[position]) {
-        /* out of data, return eof */
-        retval = MY_EOF;
-        position = READ_BUFSIZE;
-    } else {
-        retval = buf[position];
-        position++;
-    }
-
-    return retval;
-}
+    PRFileDesc *prfd = NULL;
+    PRFileDesc *legacyfd = NULL;
+    char *legacyfilename = NULL;
+    char buf[BUFSIZ];
+    PRInt32 n;
 
-int
-GetNextLine(char *dest, int size_dest, PRFileDesc *stream)
-{
+    int rc = 0;
 
-    char nextchar = '\0';
-    int done = 0;
-    int i = 0;
+    if ((prfd = PR_Open(logfilename, PR_RDONLY, REFERINT_DEFAULT_FILE_MODE)) == NULL) {
+        return 0;
+    }
+    n = PR_Read(prfd, buf, REFERINT_QUEUE_MAGIC_LEN);
+    if (n <= 0 || memcmp(buf, REFERINT_QUEUE_MAGIC, n) == 0) {
+        /* empty, or already a binary queue */
+        PR_Close(prfd);
+        return 0;
+    }
 
-    while (!done) {
-        if ((nextchar = my_fgetc(stream)) != 0) {
-            if (i < (size_dest - 1)) {
-                dest[i] = nextchar;
-                i++;
-                if (nextchar == '\n') {
-                    /* end of line reached */
-                    done = 1;
-                }
-            } else {
-                /* no more room in buffer */
-                done = 1;
-            }
-        } else {
-            /* error or end of file */
-            done = 1;
+    legacyfilename = slapi_ch_smprintf("%s%s", logfilename, REFERINT_QUEUE_LEGACY_SUFFIX);
+    slapi_log_err(SLAPI_LOG_PLUGIN, REFERINT_PLUGIN_SUBSYSTEM,
+                  "referint_queue_set_aside_legacy - Moving the updates queued in the text format "
+                  "in \"%s\" to \"%s\"\n",
+                  logfilename, legacyfilename);
+    if (PR_Access(legacyfilename, PR_ACCESS_EXISTS) != PR_SUCCESS) {
+        PR_Close(prfd);
+        if (PR_Rename(logfilename, legacyfilename) != PR_SUCCESS) {
+            slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
+                          "referint_queue_set_aside_legacy - Could not rename \"%s\" " SLAPI_COMPONENT_NAME_NSPR " %d (%s)\n",
+                          logfilename, PR_GetError(), slapd_pr_strerror(PR_GetError()));
+            rc = -1;
         }
+        slapi_ch_free_string(&legacyfilename);
+        return rc;
     }
-    dest[i] = '\0';
 
-    /* return size of string read */
-    return i;
+    /* The previous legacy queue is still pending, add these lines to it */
+    if ((legacyfd = PR_Open(legacyfilename, PR_WRONLY | PR_APPEND, REFERINT_DEFAULT_FILE_MODE)) == NULL ||
+        PR_Seek(prfd, 0, PR_SEEK_SET) != 0) {
+        goto error;
+    }
+    while ((n = PR_Read(prfd, buf, sizeof(buf))) > 0) {
+        if (PR_Write(legacyfd, buf, n) != n) {
+            goto error;
+        }
+    }
+    if (n < 0 || PR_Sync(legacyfd) != PR_SUCCESS) {
+        goto error;
+    }
+    PR_Close(legacyfd);
+    PR_Close(prfd);
+    PR_Delete(logfilename);
+    slapi_ch_free_string(&legacyfilename);
+    return 0;
+
+error:
+    /* leave the text queue in place, the batch thread still reads it */
+    slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
+                  "referint_queue_set_aside_legacy - Could not append \"%s\" to \"%s\" " SLAPI_COMPONENT_NAME_NSPR " %d (%s)\n",
+                  logfilename, legacyfilename, PR_GetError(), slapd_pr_strerror(PR_GetError()));
+    if (legacyfd) {
+        PR_Close(legacyfd);
+    }
+    PR_Close(prfd);
+    slapi_ch_free_string(&legacyfilename);
+    return -1;
 }
 
 /*
- *  Write this record to the log file
+ *  Append this update to the queue file
  */
 void
 writeintegritylog(Slapi_PBlock *pb, char *logfilename, Slapi_DN *sdn, char *newrdn, Slapi_DN *newsuperior, Slapi_DN *requestorsdn)
 {
     PRFileDesc *prfd;
-    char buffer[MAX_LINE];
-    int len_to_write = 0;
+    PRFileInfo64 info;
+    const char *fields[REFERINT_QUEUE_NFIELDS];
+    unsigned char *record = NULL;
+    size_t reclen = 8;
+    size_t pos = 8;
     int rc;
     const char *requestordn = NULL;
     const char *newsuperiordn = NULL;
-    size_t reqdn_len = 0;
 
     if (!(referint_sdn_in_entry_scope(sdn) ||
           (newsuperior && referint_sdn_in_entry_scope(newsuperior)))) {
         return;
     }
+
+    newsuperiordn = slapi_sdn_get_dn(newsuperior);
+    if (newsuperiordn &&
+        !referint_sdn_in_entry_scope(newsuperior)) {
+        /* this is a modrdn which moves the entry out of scope, handle like a delete */
+        newsuperiordn = NULL;
+        newrdn = NULL;
+    }
+    slapi_pblock_get(pb, SLAPI_REQUESTOR_DN, &requestordn);
+    if (requestorsdn) {
+        requestordn = slapi_sdn_get_udn(requestorsdn);
+    }
+    if (requestordn && *requestordn == '\0') {
+        requestordn = NULL;
+    }
+
+    fields[0] = slapi_sdn_get_dn(sdn);
+    fields[1] = newrdn;
+    fields[2] = newsuperiordn;
+    fields[3] = requestordn;
+    for (size_t i = 0; i < REFERINT_QUEUE_NFIELDS; i++) {
+        reclen += 4 + (fields[i] ? strlen(fields[i]) : 0);
+    }
+    record = (unsigned char *)slapi_ch_malloc(reclen);
+    for (size_t i = 0; i < REFERINT_QUEUE_NFIELDS; i++) {
+        size_t flen = fields[i] ? strlen(fields[i]) : 0;
+
+        referint_queue_put32(record + pos, fields[i] ? (uint32_t)flen : REFERINT_QUEUE_NULL_FIELD);
+        pos += 4;
+        if (flen) {
+            memcpy(record + pos, fields[i], flen);
+            pos += flen;
+        }
+    }
+    referint_queue_put32(record, (uint32_t)(reclen - 8));
+    referint_queue_put32(record + 4, referint_queue_checksum(record + 8, reclen - 8));
+
     /*
-     * Use this lock to protect file data when update integrity is occuring.
-     * If betxn is enabled, this mutex is ignored; transaction itself takes
-     * the role.
+     * Use this lock to protect file data while the batch thread takes
+     * ownership of the queue.
      */
     referint_lock();
+    if (referint_queue_set_aside_legacy(logfilename) != 0) {
+        slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
+                      "writeintegritylog - Could not queue the update of \"%s\", "
+                      "\"%s\" is in the text format of an older version\n",
+                      slapi_sdn_get_dn(sdn), logfilename);
+        referint_unlock();
+        slapi_ch_free((void **)&record);
+        return;
+    }
     if ((prfd = PR_Open(logfilename, PR_WRONLY | PR_CREATE_FILE | PR_APPEND,
                         REFERINT_DEFAULT_FILE_MODE)) == NULL) {
         slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
@@ -1700,59 +2089,21 @@ writeintegritylog(Slapi_PBlock *pb, char *logfilename, Slapi_DN *sdn, char *newr
                       logfilename, PR_GetError(), slapd_pr_strerror(PR_GetError()));
 
         referint_unlock();
+        slapi_ch_free((void **)&record);
         return;
     }
-    /*
-     *  Make sure we have enough room in our buffer before trying to write it.
-     *  add length of dn +  5(three tabs, a newline, and terminating \0)
-     */
-    len_to_write = slapi_sdn_get_ndn_len(sdn) + 5;
-
-    newsuperiordn = slapi_sdn_get_dn(newsuperior);
-    if (newsuperiordn &&
-        !referint_sdn_in_entry_scope(newsuperior)) {
-        /* this is a modrdn which moves the entry out of scope, handle like a delete */
-        newsuperiordn = NULL;
-        newrdn = NULL;
-    }
-    if (newrdn == NULL) {
-        /* add the length of "NULL" */
-        len_to_write += 4;
-    } else {
-        /* add the length of the newrdn */
-        len_to_write += strlen(newrdn);
-    }
-    if (NULL == newsuperiordn) {
-        /* add the length of "NULL" */
-        len_to_write += 4;
-    } else {
-        /* add the length of the newsuperior */
-        len_to_write += slapi_sdn_get_ndn_len(newsuperior);
-    }
-    slapi_pblock_get(pb, SLAPI_REQUESTOR_DN, &requestordn);
-    if (requestorsdn && (requestordn = slapi_sdn_get_udn(requestorsdn)) &&
-        (reqdn_len = strlen(requestordn))) {
-        len_to_write += reqdn_len;
-    } else {
-        len_to_write += 4; /* "NULL" */
-    }
 
-    if (len_to_write > MAX_LINE) {
+    if (PR_GetOpenFileInfo64(prfd, &info) == PR_SUCCESS && info.size == 0 &&
+        PR_Write(prfd, REFERINT_QUEUE_MAGIC, REFERINT_QUEUE_MAGIC_LEN) < 0) {
         slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
-                      "writeintegritylog - Could not write integrity log:"
-                      " line length exceeded. It will not be able"
-                      " to update references to this entry.\n");
-    } else {
-        PR_snprintf(buffer, MAX_LINE, "%s\t%s\t%s\t%s\t\n", slapi_sdn_get_dn(sdn),
-                    (newrdn != NULL) ? newrdn : "NULL",
-                    (newsuperiordn != NULL) ? newsuperiordn : "NULL",
-                    requestordn ? requestordn : "NULL");
-        if (PR_Write(prfd, buffer, strlen(buffer)) < 0) {
-            slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
-                          " writeintegritylog - PR_Write failed : The disk"
-                          " may be full or the file is unwritable :: NSPR error - %d\n",
-                          PR_GetError());
-        }
+                      " writeintegritylog - PR_Write failed : The disk"
+                      " may be full or the file is unwritable :: NSPR error - %d\n",
+                      PR_GetError());
+    } else if (PR_Write(prfd, record, (PRInt32)reclen) < 0 || PR_Sync(prfd) != PR_SUCCESS) {
+        slapi_log_err(SLAPI_LOG_ERR, REFERINT_PLUGIN_SUBSYSTEM,
+                      " writeintegritylog - PR_Write failed : The disk"
+                      " may be full or the file is unwritable :: NSPR error - %d\n",
+                      PR_GetError());
     }
 
     /* If file descriptor is closed successfully, PR_SUCCESS */
@@ -1763,6 +2114,7 @@ writeintegritylog(Slapi_PBlock *pb, char *logfilename, Slapi_DN *sdn, char *newr
                       PR_GetError());
     }
     referint_unlock();
+    slapi_ch_free((void **)&record);
 }
 
 static int
@@ -43,6 +43,7 @@ int retrocl_nattributes = 0;
 char **retrocl_attributes = NULL;
 char **retrocl_aliases = NULL;
 int retrocl_log_deleted = 0;
+int retrocl_use_log = 0;
 int retrocl_nexclude_attrs = 0;
 static int legacy_initialised = 0;
 
@@ -213,6 +214,19 @@ retrocl_select_backend(void)
     Slapi_Operation *op = NULL;
     char errbuf[SLAPI_DSE_RETURNTEXT_SIZE];
 
+    if (retrocl_use_log) {
+        err = retrocl_be_init();
+        if (err == LDAP_SUCCESS) {
+            return retrocl_get_changenumbers();
+        }
+        retrocl_be_stop();
+        if (err != LDAP_UNWILLING_TO_PERFORM) {
+            return err;
+        }
+        /* an ldbm changelog is in the way, keep using it */
+        retrocl_use_log = 0;
+    }
+
     pb = slapi_pblock_new();
 
     slapi_pblock_set(pb, SLAPI_PLUGIN_IDENTITY, g_plg_identity[PLUGIN_RETROCL]);
@@ -641,6 +655,9 @@ retrocl_stop(Slapi_PBlock *pb __attribute__((unused)))
     slapi_ch_free((void **)&retrocl_includes);
 
     retrocl_stop_trimming();
+    if (retrocl_use_log) {
+        retrocl_be_stop();
+    }
     retrocl_be_changelog = NULL;
     retrocl_forget_changenumbers();
     PR_DestroyLock(retrocl_internal_lock);
@@ -675,6 +692,7 @@ retrocl_plugin_init(Slapi_PBlock *pb)
     Slapi_Entry *plugin_entry = NULL;
     int is_betxn = 0;
     const char *plugintype = "postoperation";
+    const char *storage = NULL;
 
     slapi_pblock_get(pb, SLAPI_PLUGIN_IDENTITY, &identity);
     PR_ASSERT(identity);
@@ -685,6 +703,18 @@ retrocl_plugin_init(Slapi_PBlock *pb)
     if ((slapi_pblock_get(pb, SLAPI_PLUGIN_CONFIG_ENTRY, &plugin_entry) == 0) &&
         plugin_entry) {
         is_betxn = slapi_entry_attr_get_bool(plugin_entry, "nsslapd-pluginbetxn");
+        retrocl_use_log = (storage = slapi_entry_attr_get_ref(plugin_entry, CONFIG_CHANGELOG_STORAGE_ATTRIBUTE)) &&
+                          strcasecmp(storage, RETROCL_STORAGE_LOG) == 0;
+    }
+    if (retrocl_use_log && is_betxn) {
+        /*
+         * The log is not part of the backend transaction: append the change
+         * once it is committed so that aborted operations are not logged.
+         */
+        slapi_log_err(SLAPI_LOG_NOTICE, RETROCL_PLUGIN_NAME,
+                      "retrocl_plugin_init - %s is %s, ignoring nsslapd-pluginbetxn\n",
+                      CONFIG_CHANGELOG_STORAGE_ATTRIBUTE, RETROCL_STORAGE_LOG);
+        is_betxn = 0;
     }
 
     if (!legacy_initialised) {
@@ -800,6 +830,36 @@ retrocl_config_modify(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_Entry *entryAfter,
                         *returncode = LDAP_UNWILLING_TO_PERFORM;
                         goto done;
                     }
+                } else if (strcasecmp(config_attr, CONFIG_CHANGELOG_STORAGE_ATTRIBUTE) == 0) {
+                    if (config_attr_value == NULL ||
+                        (strcasecmp(config_attr_value, RETROCL_STORAGE_LDBM) != 0 &&
+                         strcasecmp(config_attr_value, RETROCL_STORAGE_LOG) != 0)) {
+                        if (returntext) {
+                            PR_snprintf(returntext, SLAPI_DSE_RETURNTEXT_SIZE,
+                                        "%s: invalid value \"%s\", %s must be \"%s\" or \"%s\"",
+                                        CONFIG_CHANGELOG_STORAGE_ATTRIBUTE, config_attr_value ? config_attr_value : "null",
+                                        CONFIG_CHANGELOG_STORAGE_ATTRIBUTE, RETROCL_STORAGE_LDBM, RETROCL_STORAGE_LOG);
+                        }
+                        *returncode = LDAP_UNWILLING_TO_PERFORM;
+                        goto done;
+                    }
+                } else if (strcasecmp(config_attr, CONFIG_CHANGELOG_SEGMENT_SIZE) == 0) {
+                    char *endp = NULL;
+                    unsigned long long size;
+
+                    errno = 0;
+                    size = config_attr_value ? strtoull(config_attr_value, &endp, 10) : 0;
+                    if (config_attr_value == NULL || errno != 0 || endp == config_attr_value ||
+                        *endp != '\0' || size < RETROCL_MIN_SEGMENT_SIZE) {
+                        if (returntext) {
+                            PR_snprintf(returntext, SLAPI_DSE_RETURNTEXT_SIZE,
+                                        "%s: invalid value \"%s\", %s must be a number of bytes of at least %d",
+                                        CONFIG_CHANGELOG_SEGMENT_SIZE, config_attr_value ? config_attr_value : "null",
+                                        CONFIG_CHANGELOG_SEGMENT_SIZE, RETROCL_MIN_SEGMENT_SIZE);
+                        }
+                        *returncode = LDAP_UNWILLING_TO_PERFORM;
+                        goto done;
+                    }
                 }
             }
         }
@@ -71,6 +71,20 @@ typedef struct _cnumRet
 #define CONFIG_CHANGELOG_INCLUDE_SUFFIX      "nsslapd-include-suffix"
 #define CONFIG_CHANGELOG_EXCLUDE_SUFFIX      "nsslapd-exclude-suffix"
 #define CONFIG_CHANGELOG_EXCLUDE_ATTRS       "nsslapd-exclude-attrs"
+#define CONFIG_CHANGELOG_STORAGE_ATTRIBUTE   "nsslapd-changelog-storage"
+#define CONFIG_CHANGELOG_SEGMENT_SIZE        "nsslapd-changelog-segment-size"
+
+/*
+ * Changelog storage.  "ldbm" keeps every change as an entry in the changelog
+ * ldbm instance; "log" appends them to segment files that are exposed through
+ * a read-only virtual backend (see retrocl_log.c and retrocl_be.c).
+ */
+#define RETROCL_STORAGE_LDBM "ldbm"
+#define RETROCL_STORAGE_LOG  "log"
+#define RETROCL_DEFAULT_SEGMENT_SIZE (64 * 1024 * 1024)
+#define RETROCL_MIN_SEGMENT_SIZE     (1024 * 1024)
+#define RETROCL_BE_TYPE "retrocl"
+#define RETROCL_BE_NAME "changelog"
 
 #define RETROCL_CHANGELOG_DN   "cn=changelog"
 #define RETROCL_MAPPINGTREE_DN "cn=\"cn=changelog\",cn=mapping tree,cn=config"
@@ -92,6 +106,7 @@ enum
 extern void *g_plg_identity[PLUGIN_MAX];
 extern Slapi_Backend *retrocl_be_changelog;
 extern int retrocl_log_deleted;
+extern int retrocl_use_log;
 extern int retrocl_nattributes;
 extern char **retrocl_attributes;
 extern char **retrocl_aliases;
@@ -148,4 +163,24 @@ extern char *retrocl_get_config_str(const char *attrt);
 int retrocl_entry_in_scope(Slapi_Entry *e);
 int retrocl_attr_in_exclude_attrs(char *attr, int attrlen);
 
+/* retrocl_log.c */
+typedef struct _retrocl_log_cursor retrocl_log_cursor;
+
+extern int retrocl_log_open(const char *dir, PRUint64 segment_size);
+extern void retrocl_log_close(void);
+extern void retrocl_log_set_max_age(time_t max_age);
+extern int retrocl_log_append(changeNumber cnum, time_t changetime, Slapi_Entry *e);
+extern void retrocl_log_get_range(changeNumber *first, changeNumber *last);
+extern time_t retrocl_log_get_time(int type);
+extern int retrocl_log_trimmable(time_t max_age, time_t now);
+extern int retrocl_log_trim(time_t max_age, time_t now, changeNumber *first);
+extern retrocl_log_cursor *retrocl_log_cursor_new(changeNumber from, changeNumber to);
+extern Slapi_Entry *retrocl_log_cursor_next(retrocl_log_cursor *cur);
+extern void retrocl_log_cursor_free(retrocl_log_cursor **cur);
+extern Slapi_Entry *retrocl_log_get_entry(changeNumber cnum);
+
+/* retrocl_be.c */
+extern int retrocl_be_init(void);
+extern void retrocl_be_stop(void);
+
 #endif /* _H_RETROCL */
@@ -0,0 +1,764 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * Virtual backend serving cn=changelog when the changes are kept in the
+ * segmented log (nsslapd-changelog-storage: log).
+ *
+ * The backend is named "changelog" like the ldbm instance it replaces, so the
+ * existing mapping tree node keeps routing to it.  Change entries are read
+ * from the log on demand; searches narrow the range of changes to read from
+ * the changenumber assertions of the filter and skip the log altogether when
+ * the filter cannot match a change entry (acl, roles or cos discovery).
+ * The cn=changelog entry itself lives in changelog.ldif next to the
+ * segments, so that its aci can still be managed with modify operations.
+ */
+
+#include "retrocl.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define RETROCL_BE_BASE_FILE "changelog.ldif"
+#define RETROCL_LDBM_CONFIG_DN "cn=config,cn=ldbm database,cn=plugins,cn=config"
+
+#define RETROCL_TARGET_NONE   0
+#define RETROCL_TARGET_BASE   1
+#define RETROCL_TARGET_CHANGE 2
+
+typedef struct _retrocl_be_search_set
+{
+    Slapi_Entry *rs_pending;        /* entry to return before reading the log */
+    retrocl_log_cursor *rs_cursor;  /* NULL if the log does not need to be read */
+    Slapi_Entry *rs_current;        /* last entry returned, owned by the set */
+    int rs_reuse;                   /* set by prev_search_results */
+} retrocl_be_search_set;
+
+static struct slapdplugin retrocl_be_plugin = {0};
+static Slapi_Backend *retrocl_be = NULL;
+static Slapi_DN retrocl_be_suffix;
+static Slapi_Entry *retrocl_be_base = NULL;
+static char *retrocl_be_base_path = NULL;
+static PRLock *retrocl_be_base_lock = NULL;
+
+static int
+retrocl_be_unwillingtoperform(Slapi_PBlock *pb)
+{
+    slapi_send_ldap_result(pb, LDAP_UNWILLING_TO_PERFORM, NULL, "Retro changelog entries are read only", 0, NULL);
+    return -1;
+}
+
+static int
+retrocl_be_unbind(Slapi_PBlock *pb __attribute__((unused)))
+{
+    return 0;
+}
+
+static int
+retrocl_be_cleanup(Slapi_PBlock *pb __attribute__((unused)))
+{
+    return 0;
+}
+
+/*
+ * Where the segments go: nsslapd-changelogdir if set, else a retrocl
+ * directory below the ldbm database directory.
+ */
+static char *
+retrocl_be_get_dir(void)
+{
+    Slapi_PBlock *pb = NULL;
+    Slapi_Entry **entries = NULL;
+    char *attrs[] = {"nsslapd-directory", NULL};
+    char *dbdir = NULL;
+    char *dir;
+    int rc = 0;
+
+    dir = retrocl_get_config_str(CONFIG_CHANGELOG_DIRECTORY_ATTRIBUTE);
+    if (dir && *dir) {
+        return dir;
+    }
+    slapi_ch_free_string(&dir);
+
+    pb = slapi_pblock_new();
+    slapi_search_internal_set_pb(pb, RETROCL_LDBM_CONFIG_DN, LDAP_SCOPE_BASE, "objectclass=*", attrs, 0,
+                                 NULL, NULL, g_plg_identity[PLUGIN_RETROCL], 0);
+    slapi_search_internal_pb(pb);
+    slapi_pblock_get(pb, SLAPI_PLUGIN_INTOP_RESULT, &rc);
+    if (rc == LDAP_SUCCESS) {
+        slapi_pblock_get(pb, SLAPI_PLUGIN_INTOP_SEARCH_ENTRIES, &entries);
+        if (entries && entries[0]) {
+            dbdir = slapi_entry_attr_get_charptr(entries[0], "nsslapd-directory");
+        }
+    }
+    slapi_free_search_results_internal(pb);
+    slapi_pblock_destroy(pb);
+
+    if (dbdir && *dbdir) {
+        dir = slapi_ch_smprintf("%s/retrocl", dbdir);
+    }
+    slapi_ch_free_string(&dbdir);
+    return dir;
+}
+
+static PRUint64
+retrocl_be_get_segment_size(void)
+{
+    PRUint64 size = RETROCL_DEFAULT_SEGMENT_SIZE;
+    char *value = retrocl_get_config_str(CONFIG_CHANGELOG_SEGMENT_SIZE);
+
+    if (value) {
+        char *end = NULL;
+        unsigned long long v;
+
+        errno = 0;
+        v = strtoull(value, &end, 10);
+        if (errno || end == value || *end != '\0' || v < RETROCL_MIN_SEGMENT_SIZE) {
+            slapi_log_err(SLAPI_LOG_ERR, RETROCL_PLUGIN_NAME,
+                          "retrocl_be_get_segment_size - Ignoring invalid %s value %s; "
+                          "using the default %d\n",
+                          CONFIG_CHANGELOG_SEGMENT_SIZE, value, RETROCL_DEFAULT_SEGMENT_SIZE);
+        } else {
+            size = (PRUint64)v;
+        }
+        slapi_ch_free_string(&value);
+    }
+    return size;
+}
+
+/* Write the cn=changelog entry to a temporary file and rename it in place */
+static int
+retrocl_be_base_write(Slapi_Entry *e)
+{
+    char *tmp = slapi_ch_smprintf("%s.tmp", retrocl_be_base_path);
+    char *ldif = NULL;
+    int len = 0;
+    int fd = -1;
+    int rc = -1;
+
+    if ((ldif = slapi_entry2str(e, &len)) == NULL) {
+        goto done;
+    }
+    if ((fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0600)) < 0) {
+        goto done;
+    }
+    if (write(fd, ldif, len) != len || fsync(fd) != 0) {
+        goto done;
+    }
+    close(fd);
+    fd = -1;
+    if (rename(tmp, retrocl_be_base_path) != 0) {
+        goto done;
+    }
+    rc = 0;
+
+done:
+    if (rc) {
+        slapi_log_err(SLAPI_LOG_ERR, RETROCL_PLUGIN_NAME,
+                      "retrocl_be_base_write - Unable to write %s (%d)\n", retrocl_be_base_path, errno);
+        if (fd >= 0) {
+            close(fd);
+        }
+        unlink(tmp);
+    }
+    slapi_ch_free_string(&ldif);
+    slapi_ch_free_string(&tmp);
+    return rc;
+}
+
+/* Load cn=changelog from its file, creating the default entry the first time */
+static int
+retrocl_be_base_load(void)
+{
+    struct stat st;
+    char *buf = NULL;
+    int fd;
+
+    if ((fd = open(retrocl_be_base_path, O_RDONLY)) >= 0) {
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            buf = slapi_ch_malloc(st.st_size + 1);
+            if (read(fd, buf, st.st_size) == st.st_size) {
+                buf[st.st_size] = '\0';
+                retrocl_be_base = slapi_str2entry(buf, SLAPI_STR2ENTRY_NO_ENTRYDN);
+            }
+            slapi_ch_free_string(&buf);
+        }
+        close(fd);
+        if (retrocl_be_base == NULL) {
+            slapi_log_err(SLAPI_LOG_ERR, RETROCL_PLUGIN_NAME,
+                          "retrocl_be_base_load - Unable to read %s, recreating the default entry\n",
+                          retrocl_be_base_path);
+        }
+    }
+    if (retrocl_be_base == NULL) {
+        retrocl_be_base = slapi_entry_alloc();
+        slapi_entry_init(retrocl_be_base, slapi_ch_strdup(RETROCL_CHANGELOG_DN), NULL);
+        slapi_entry_add_string(retrocl_be_base, "objectclass", "top");
+        slapi_entry_add_string(retrocl_be_base, "objectclass", "nsContainer");
+        slapi_entry_add_string(retrocl_be_base, "cn", "changelog");
+        return retrocl_be_base_write(retrocl_be_base);
+    }
+    return 0;
+}
+
+static Slapi_Entry *
+retrocl_be_base_dup(void)
+{
+    Slapi_Entry *e;
+
+    PR_Lock(retrocl_be_base_lock);
+    e = slapi_entry_dup(retrocl_be_base);
+    PR_Unlock(retrocl_be_base_lock);
+    return e;
+}
+
+/* Is sdn cn=changelog, changenumber=N,cn=changelog or neither? */
+static int
+retrocl_be_target(const Slapi_DN *sdn, changeNumber *cnum)
+{
+    Slapi_DN parent;
+    int rc = RETROCL_TARGET_NONE;
+
+    if (slapi_sdn_compare(sdn, &retrocl_be_suffix) == 0) {
+        return RETROCL_TARGET_BASE;
+    }
+    slapi_sdn_init(&parent);
+    slapi_sdn_get_parent(sdn, &parent);
+    if (slapi_sdn_compare(&parent, &retrocl_be_suffix) == 0) {
+        Slapi_RDN *rdn = slapi_rdn_new_sdn(sdn);
+        char *type = NULL;
+        char *value = NULL;
+
+        if (slapi_rdn_get_first(rdn, &type, &value) != -1 && type && value &&
+            strcasecmp(type, retrocl_changenumber) == 0) {
+            char *end = NULL;
+
+            errno = 0;
+            *cnum = strtoul(value, &end, 10);
+            if (errno == 0 && end != value && *end == '\0' && *cnum > 0) {
+                rc = RETROCL_TARGET_CHANGE;
+            }
+        }
+        slapi_rdn_free(&rdn);
+    }
+    slapi_sdn_done(&parent);
+    return rc;
+}
+
+static Slapi_Entry *
+retrocl_be_get_entry(const Slapi_DN *sdn)
+{
+    changeNumber cnum = 0;
+
+    switch (retrocl_be_target(sdn, &cnum)) {
+    case RETROCL_TARGET_BASE:
+        return retrocl_be_base_dup();
+    case RETROCL_TARGET_CHANGE:
+        return retrocl_log_get_entry(cnum);
+    default:
+        return NULL;
+    }
+}
+
+static int
+bv_equals(const struct berval *bv, const char *s)
+{
+    size_t len = strlen(s);
+
+    return bv && bv->bv_val && bv->bv_len == len && strncasecmp(bv->bv_val, s, len) == 0;
+}
+
+/* Can a change entry hold an attribute of this type? */
+static int
+retrocl_be_attr_in_change(const char *type)
+{
+    const char *attrs[] = {retrocl_objectclass, retrocl_changenumber, retrocl_targetdn,
+                           retrocl_changetype, retrocl_changes, retrocl_newrdn,
+                           retrocl_deleteoldrdn, retrocl_newsuperior, retrocl_changetime, NULL};
+
+    for (size_t i = 0; attrs[i]; i++) {
+        if (slapi_attr_type_cmp(type, attrs[i], SLAPI_TYPE_CMP_BASE) == 0) {
+            return 1;
+        }
+    }
+    for (size_t i = 0; i < retrocl_nattributes; i++) {
+        const char *name = retrocl_aliases[i] ? retrocl_aliases[i] : retrocl_attributes[i];
+        if (slapi_attr_type_cmp(type, name, SLAPI_TYPE_CMP_BASE) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Returns 0 if no change entry can match the filter, which spares reading
+ * the log for the many internal searches looking for something else.
+ */
+static int
+retrocl_be_filter_may_match(Slapi_Filter *f)
+{
+    Slapi_Filter *sub;
+    struct berval *bval = NULL;
+    char *type = NULL;
+
+    switch (slapi_filter_get_choice(f)) {
+    case LDAP_FILTER_AND:
+        for (sub = slapi_filter_list_first(f); sub; sub = slapi_filter_list_next(f, sub)) {
+            if (!retrocl_be_filter_may_match(sub)) {
+                return 0;
+            }
+        }
+        return 1;
+    case LDAP_FILTER_OR:
+        for (sub = slapi_filter_list_first(f); sub; sub = slapi_filter_list_next(f, sub)) {
+            if (retrocl_be_filter_may_match(sub)) {
+                return 1;
+            }
+        }
+        return 0;
+    case LDAP_FILTER_NOT:
+        return 1;
+    case LDAP_FILTER_EQUALITY:
+        if (slapi_filter_get_ava(f, &type, &bval) == 0 && type &&
+            strcasecmp(type, retrocl_objectclass) == 0) {
+            return bv_equals(bval, "top") || bv_equals(bval, "changelogentry") ||
+                   bv_equals(bval, "extensibleObject");
+        }
+        /* fall through */
+    default:
+        if (slapi_filter_get_attribute_type(f, &type) != 0 || type == NULL) {
+            return 1;
+        }
+        return retrocl_be_attr_in_change(type);
+    }
+}
+
+/* Narrow [lo, hi] with the changenumber assertions ANDed in the filter */
+static void
+retrocl_be_filter_range(Slapi_Filter *f, changeNumber *lo, changeNumber *hi)
+{
+    Slapi_Filter *sub;
+    struct berval *bval = NULL;
+    char *type = NULL;
+    changeNumber v = 0;
+    int choice = slapi_filter_get_choice(f);
+
+    switch (choice) {
+    case LDAP_FILTER_AND:
+        for (sub = slapi_filter_list_first(f); sub; sub = slapi_filter_list_next(f, sub)) {
+            retrocl_be_filter_range(sub, lo, hi);
+        }
+        break;
+    case LDAP_FILTER_EQUALITY:
+    case LDAP_FILTER_GE:
+    case LDAP_FILTER_LE:
+        if (slapi_filter_get_ava(f, &type, &bval) != 0 || type == NULL || bval == NULL ||
+            bval->bv_val == NULL || bval->bv_len == 0 || bval->bv_len >= CNUMSTR_LEN ||
+            strcasecmp(type, retrocl_changenumber) != 0) {
+            break;
+        }
+        for (size_t i = 0; i < bval->bv_len; i++) {
+            if (!isdigit((unsigned char)bval->bv_val[i])) {
+                return;
+            }
+        }
+        v = strntoul(bval->bv_val, bval->bv_len, 10);
+        if (choice != LDAP_FILTER_LE && v > *lo) {
+            *lo = v;
+        }
+        if (choice != LDAP_FILTER_GE && v < *hi) {
+            *hi = v;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void
+retrocl_be_search_set_release(void **vrs)
+{
+    retrocl_be_search_set *rs = *vrs;
+
+    if (rs) {
+        slapi_entry_free(rs->rs_pending);
+        slapi_entry_free(rs->rs_current);
+        retrocl_log_cursor_free(&rs->rs_cursor);
+        slapi_ch_free(vrs);
+    }
+}
+
+/* Backend callback (search operation: set up the search set) */
+static int
+retrocl_be_search(Slapi_PBlock *pb)
+{
+    retrocl_be_search_set *rs = NULL;
+    Slapi_Filter *filter = NULL;
+    Slapi_DN *basesdn = NULL;
+    Slapi_Entry *e = NULL;
+    changeNumber cnum = 0, first = 0, last = 0;
+    changeNumber lo = 1, hi = ULONG_MAX;
+    int estimate = 0;
+    int scope = 0;
+    int target;
+
+    if (slapi_pblock_get(pb, SLAPI_SEARCH_TARGET_SDN, &basesdn) < 0 ||
+        slapi_pblock_get(pb, SLAPI_SEARCH_SCOPE, &scope) < 0 ||
+        slapi_pblock_get(pb, SLAPI_SEARCH_FILTER, &filter) < 0) {
+        slapi_send_ldap_result(pb, LDAP_OPERATIONS_ERROR, NULL, NULL, 0, NULL);
+        return -1;
+    }
+
+    target = retrocl_be_target(basesdn, &cnum);
+    if (target == RETROCL_TARGET_CHANGE) {
+        e = retrocl_log_get_entry(cnum);
+    }
+    if (target == RETROCL_TARGET_NONE || (target == RETROCL_TARGET_CHANGE && e == NULL)) {
+        slapi_send_ldap_result(pb, LDAP_NO_SUCH_OBJECT, (char *)slapi_sdn_get_dn(&retrocl_be_suffix),
+                               NULL, 0, NULL);
+        return -1;
+    }
+
+    rs = (retrocl_be_search_set *)slapi_ch_calloc(1, sizeof(retrocl_be_search_set));
+    if (target == RETROCL_TARGET_CHANGE) {
+        /* change entries have no children */
+        if (scope != LDAP_SCOPE_ONELEVEL) {
+            rs->rs_pending = e;
+            e = NULL;
+            estimate = 1;
+        }
+        slapi_entry_free(e);
+    } else {
+        if (scope != LDAP_SCOPE_ONELEVEL) {
+            rs->rs_pending = retrocl_be_base_dup();
+            estimate = 1;
+        }
+        if (scope != LDAP_SCOPE_BASE && retrocl_be_filter_may_match(filter)) {
+            retrocl_be_filter_range(filter, &lo, &hi);
+            retrocl_log_get_range(&first, &last);
+            if (lo < first) {
+                lo = first;
+            }
+            if (hi > last) {
+                hi = last;
+            }
+            if (first && lo <= hi) {
+                rs->rs_cursor = retrocl_log_cursor_new(lo, hi);
+                estimate += (hi - lo + 1 > INT_MAX - 1) ? INT_MAX - 1 : (int)(hi - lo + 1);
+            }
+        }
+    }
+
+    slapi_pblock_set(pb, SLAPI_SEARCH_RESULT_SET, rs);
+    slapi_pblock_set(pb, SLAPI_SEARCH_RESULT_SET_SIZE_ESTIMATE, &estimate);
+    return 0;
+}
+
+/* Backend callback (get next search entry from the search set) */
+static int
+retrocl_be_next_search_entry(Slapi_PBlock *pb)
+{
+    retrocl_be_search_set *rs = NULL;
+    Slapi_Filter *filter = NULL;
+    Slapi_Entry *e = NULL;
+    int slimit = -1;
+    int nentries = 0;
+
+    slapi_pblock_get(pb, SLAPI_SEARCH_RESULT_SET, &rs);
+    if (rs == NULL) {
+        slapi_pblock_set(pb, SLAPI_SEARCH_RESULT_ENTRY, NULL);
+        return 0;
+    }
+    if (rs->rs_reuse) {
+        rs->rs_reuse = 0;
+        slapi_pblock_set(pb, SLAPI_SEARCH_RESULT_ENTRY, rs->rs_current);
+        return 0;
+    }
+    slapi_entry_free(rs->rs_current);
+    rs->rs_current = NULL;
+
+    slapi_pblock_get(pb, SLAPI_SEARCH_FILTER, &filter);
+    slapi_pblock_get(pb, SLAPI_SEARCH_SIZELIMIT, &slimit);
+    slapi_pblock_get(pb, SLAPI_NENTRIES, &nentries);
+
+    while (1) {
+        if (slapi_op_abandoned(pb)) {
+            slapi_entry_free(e);
+            retrocl_be_search_set_release((void **)&rs);
+            slapi_pblock_set(pb, SLAPI_SEARCH_RESULT_SET, NULL);
+            slapi_pblock_set(pb, SLAPI_SEARCH_RESULT_ENTRY, NULL);
+            return SLAPI_FAIL_GENERAL;
+        }
+        if (rs->rs_pending) {
+            e = rs->rs_pending;
+            rs->rs_pending = NULL;
+        } else if (rs->rs_cursor) {
+            e = retrocl_log_cursor_next(rs->rs_cursor);
+        }
+        if (e == NULL || slapi_vattr_filter_test(pb, e, filter, PR_TRUE) == 0) {
+            break;
+        }
+        slapi_entry_free(e);
+        e = NULL;
+    }
+
+    if (e && slimit >= 0) {
+        if (--slimit < 0) {
+            slapi_entry_free(e);
+            retrocl_be_search_set_release((void **)&rs);
+            slapi_pblock_set(pb, SLAPI_SEARCH_RESULT_SET, NULL);
+            slapi_pblock_set(pb, SLAPI_SEARCH_RESULT_ENTRY, NULL);
+            slapi_send_ldap_result(pb, LDAP_SIZELIMIT_EXCEEDED, NULL, NULL, nentries, NULL);
+            return SLAPI_FAIL_GENERAL;
+        }
+        slapi_pblock_set(pb, SLAPI_SEARCH_SIZELIMIT, &slimit);
+    }
+
+    rs->rs_current = e;
+    slapi_pblock_set(pb, SLAPI_SEARCH_RESULT_ENTRY, e);
+    if (e == NULL) {
+        /* we reached the end of the changes */
+        pagedresults_set_search_result_pb(pb, NULL, 0);
+        retrocl_be_search_set_release((void **)&rs);
+        slapi_pblock_set(pb, SLAPI_SEARCH_RESULT_SET, NULL);
+    }
+    return 0;
+}
+
+/* Backend callback (return the last entry again on the next call) */
+static void
+retrocl_be_prev_search_results(void *vp)
+{
+    Slapi_PBlock *pb = (Slapi_PBlock *)vp;
+    retrocl_be_search_set *rs = NULL;
+
+    slapi_pblock_get(pb, SLAPI_SEARCH_RESULT_SET, &rs);
+    if (rs && rs->rs_current) {
+        rs->rs_reuse = 1;
+    }
+}
+
+static int
+retrocl_be_compare(Slapi_PBlock *pb)
+{
+    Slapi_Value compare_value = {0};
+    struct berval *bval = NULL;
+    Slapi_Entry *e = NULL;
+    Slapi_DN *sdn = NULL;
+    char *type = NULL;
+    int result = 0;
+    int err;
+
+    slapi_pblock_get(pb, SLAPI_COMPARE_TARGET_SDN, &sdn);
+    slapi_pblock_get(pb, SLAPI_COMPARE_TYPE, &type);
+    slapi_pblock_get(pb, SLAPI_COMPARE_VALUE, &bval);
+
+    if ((e = retrocl_be_get_entry(sdn)) == NULL) {
+        slapi_send_ldap_result(pb, LDAP_NO_SUCH_OBJECT, NULL, NULL, 0, NULL);
+        return -1;
+    }
+    if ((err = slapi_access_allowed(pb, e, type, bval, SLAPI_ACL_COMPARE)) != LDAP_SUCCESS) {
+        slapi_entry_free(e);
+        slapi_send_ldap_result(pb, err, NULL, NULL, 0, NULL);
+        return -1;
+    }
+
+    slapi_value_init_berval(&compare_value, bval);
+    err = slapi_vattr_value_compare(e, type, &compare_value, &result, 0);
+    slapi_entry_free(e);
+    value_done(&compare_value);
+
+    if (err != LDAP_SUCCESS) {
+        slapi_send_ldap_result(pb, SLAPI_VIRTUALATTRS_NOT_FOUND == err ? LDAP_NO_SUCH_ATTRIBUTE : LDAP_OPERATIONS_ERROR,
+                               NULL, NULL, 0, NULL);
+        return -1;
+    }
+    slapi_send_ldap_result(pb, result ? LDAP_COMPARE_TRUE : LDAP_COMPARE_FALSE, NULL, NULL, 0, NULL);
+    return 0;
+}
+
+/* Backend callback (modify operation), only cn=changelog can be modified */
+static int
+retrocl_be_modify(Slapi_PBlock *pb)
+{
+    Slapi_DN *sdn = NULL;
+    LDAPMod **mods = NULL;
+    Slapi_Entry *ec = NULL;
+    char *errbuf = NULL;
+    changeNumber cnum = 0;
+    int rc;
+
+    slapi_pblock_get(pb, SLAPI_MODIFY_TARGET_SDN, &sdn);
+    slapi_pblock_get(pb, SLAPI_MODIFY_MODS, &mods);
+
+    switch (retrocl_be_target(sdn, &cnum)) {
+    case RETROCL_TARGET_BASE:
+        break;
+    case RETROCL_TARGET_CHANGE:
+        return retrocl_be_unwillingtoperform(pb);
+    default:
+        slapi_send_ldap_result(pb, LDAP_NO_SUCH_OBJECT, NULL, NULL, 0, NULL);
+        return -1;
+    }
+
+    PR_Lock(retrocl_be_base_lock);
+    ec = slapi_entry_dup(retrocl_be_base);
+    if ((rc = slapi_acl_check_mods(pb, ec, mods, &errbuf)) != LDAP_SUCCESS) {
+        goto done;
+    }
+    slapi_pblock_set(pb, SLAPI_ENTRY_PRE_OP, slapi_entry_dup(ec));
+    if ((rc = slapi_entry_apply_mods(ec, mods)) != LDAP_SUCCESS) {
+        goto done;
+    }
+    if (slapi_entry_schema_check(pb, ec) != 0) {
+        rc = LDAP_OBJECT_CLASS_VIOLATION;
+        goto done;
+    }
+    if (retrocl_be_base_write(ec) != 0) {
+        rc = LDAP_OPERATIONS_ERROR;
+        goto done;
+    }
+    slapi_entry_free(retrocl_be_base);
+    retrocl_be_base = ec;
+    ec = NULL;
+    slapi_pblock_set(pb, SLAPI_ENTRY_POST_OP, slapi_entry_dup(retrocl_be_base));
+
+done:
+    PR_Unlock(retrocl_be_base_lock);
+    slapi_entry_free(ec);
+    slapi_send_ldap_result(pb, rc, NULL, errbuf, 0, NULL);
+    slapi_ch_free_string(&errbuf);
+    return rc == LDAP_SUCCESS ? 0 : -1;
+}
+
+/* Backend callback (add operation), changes are only written by the plugin */
+static int
+retrocl_be_add(Slapi_PBlock *pb)
+{
+    Slapi_DN *sdn = NULL;
+    changeNumber cnum = 0;
+
+    slapi_pblock_get(pb, SLAPI_ADD_TARGET_SDN, &sdn);
+    if (retrocl_be_target(sdn, &cnum) == RETROCL_TARGET_BASE) {
+        slapi_send_ldap_result(pb, LDAP_ALREADY_EXISTS, NULL, NULL, 0, NULL);
+        return -1;
+    }
+    return retrocl_be_unwillingtoperform(pb);
+}
+
+/*
+ * Function: retrocl_be_init
+ *
+ * Returns: LDAP_SUCCESS, or an error if the log storage can not be used
+ *
+ * Arguments: none
+ *
+ * Description: opens the log and routes cn=changelog to the virtual backend.
+ * An ldbm instance already named "changelog" has to be removed first.
+ */
+int
+retrocl_be_init(void)
+{
+    Slapi_Backend *be = slapi_be_select_by_instance_name(RETROCL_BE_NAME);
+    char *dir = NULL;
+    int rc;
+
+    if (be && strcasecmp(slapi_be_gettype(be), RETROCL_BE_TYPE) != 0) {
+        slapi_log_err(SLAPI_LOG_ERR, RETROCL_PLUGIN_NAME,
+                      "retrocl_be_init - The retro changelog is stored in the \"%s\" %s backend; "
+                      "remove it to use %s: %s\n",
+                      RETROCL_BE_NAME, slapi_be_gettype(be),
+                      CONFIG_CHANGELOG_STORAGE_ATTRIBUTE, RETROCL_STORAGE_LOG);
+        return LDAP_UNWILLING_TO_PERFORM;
+    }
+
+    if ((dir = retrocl_be_get_dir()) == NULL) {
+        slapi_log_err(SLAPI_LOG_ERR, RETROCL_PLUGIN_NAME,
+                      "retrocl_be_init - Unable to determine the changelog directory, set %s\n",
+                      CONFIG_CHANGELOG_DIRECTORY_ATTRIBUTE);
+        return LDAP_OPERATIONS_ERROR;
+    }
+    if (retrocl_log_open(dir, retrocl_be_get_segment_size()) != 0) {
+        slapi_ch_free_string(&dir);
+        return LDAP_OPERATIONS_ERROR;
+    }
+
+    if (retrocl_be_base_lock == NULL && (retrocl_be_base_lock = PR_NewLock()) == NULL) {
+        slapi_ch_free_string(&dir);
+        return LDAP_OPERATIONS_ERROR;
+    }
+    retrocl_be_base_path = slapi_ch_smprintf("%s/%s", dir, RETROCL_BE_BASE_FILE);
+    slapi_ch_free_string(&dir);
+    if (retrocl_be_base_load() != 0) {
+        return LDAP_OPERATIONS_ERROR;
+    }
+
+    if (be == NULL) {
+        be = slapi_be_new(RETROCL_BE_TYPE, RETROCL_BE_NAME, 0 /* Public */, 0 /* Do Not Log Changes */);
+        be->be_database = &retrocl_be_plugin;
+        be->be_database->plg_bind = &retrocl_be_unwillingtoperform;
+        be->be_database->plg_unbind = &retrocl_be_unbind;
+        be->be_database->plg_search = &retrocl_be_search;
+        be->be_database->plg_next_search_entry = &retrocl_be_next_search_entry;
+        be->be_database->plg_search_results_release = &retrocl_be_search_set_release;
+        be->be_database->plg_prev_search_results = &retrocl_be_prev_search_results;
+        be->be_database->plg_compare = &retrocl_be_compare;
+        be->be_database->plg_add = &retrocl_be_add;
+        be->be_database->plg_modify = &retrocl_be_modify;
+        be->be_database->plg_modrdn = &retrocl_be_unwillingtoperform;
+        be->be_database->plg_delete = &retrocl_be_unwillingtoperform;
+        be->be_database->plg_abandon = &retrocl_be_unwillingtoperform;
+        be->be_database->plg_cleanup = &retrocl_be_cleanup;
+        /* All the other function pointers default to NULL */
+
+        slapi_sdn_init_dn_byref(&retrocl_be_suffix, RETROCL_CHANGELOG_DN);
+        slapi_be_addsuffix(be, &retrocl_be_suffix);
+    }
+    be->be_state = BE_STATE_STARTED;
+    retrocl_be = be;
+    retrocl_be_changelog = be;
+
+    /* Add the mapping tree node if this is a new changelog */
+    if ((rc = retrocl_create_config()) != LDAP_SUCCESS) {
+        return rc;
+    }
+    slapi_mtn_be_started(be);
+
+    slapi_log_err(SLAPI_LOG_INFO, RETROCL_PLUGIN_NAME,
+                  "retrocl_be_init - Retro changelog stored in %s\n", retrocl_be_base_path);
+    return LDAP_SUCCESS;
+}
+
+/*
+ * Function: retrocl_be_stop
+ *
+ * Description: stops routing operations to the backend and closes the log.
+ * The backend itself is freed with the others at shutdown, or picked up
+ * again by retrocl_be_init if the plugin is restarted.
+ */
+void
+retrocl_be_stop(void)
+{
+    if (retrocl_be) {
+        slapi_mtn_be_disable(retrocl_be);
+        retrocl_be->be_state = BE_STATE_STOPPED;
+        retrocl_be = NULL;
+    }
+    retrocl_log_close();
+    if (retrocl_be_base_lock) {
+        PR_Lock(retrocl_be_base_lock);
+        slapi_entry_free(retrocl_be_base);
+        retrocl_be_base = NULL;
+        slapi_ch_free_string(&retrocl_be_base_path);
+        PR_Unlock(retrocl_be_base_lock);
+    }
+}
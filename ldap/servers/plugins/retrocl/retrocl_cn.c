@@ -130,6 +130,20 @@ retrocl_get_changenumbers(void)
     if (retrocl_be_changelog == NULL)
         return -1;
 
+    if (retrocl_use_log) {
+        changeNumber first, last;
+
+        retrocl_log_get_range(&first, &last);
+        slapi_rwlock_wrlock(retrocl_cn_lock);
+        retrocl_first_cn = first;
+        retrocl_internal_cn = last;
+        slapi_log_err(SLAPI_LOG_PLUGIN, "retrocl", "Got changenumbers %lu and %lu\n",
+                      retrocl_first_cn,
+                      retrocl_internal_cn);
+        slapi_rwlock_unlock(retrocl_cn_lock);
+        return 0;
+    }
+
     cr.cr_cnum = 0;
     cr.cr_time = 0;
 
@@ -184,6 +198,12 @@ retrocl_getchangetime(int type, int *err)
         }
         return NO_TIME;
     }
+    if (retrocl_use_log) {
+        if (err != NULL) {
+            *err = LDAP_SUCCESS;
+        }
+        return retrocl_log_get_time(type);
+    }
     slapi_seq_callback(RETROCL_CHANGELOG_DN, type,
                        (char *)retrocl_changenumber, /* cast away const */
                        NULL,
@@ -349,6 +369,15 @@ retrocl_update_lastchangenumber(void)
     if (retrocl_be_changelog == NULL)
         return -1;
 
+    if (retrocl_use_log) {
+        changeNumber first;
+
+        retrocl_log_get_range(&first, &retrocl_internal_cn);
+        slapi_log_err(SLAPI_LOG_PLUGIN, "retrocl", "Refetched last changenumber =  %lu \n",
+                      retrocl_internal_cn);
+        return 0;
+    }
+
     slapi_rwlock_unlock(retrocl_cn_lock);
     cr.cr_cnum = 0;
     cr.cr_time = 0;
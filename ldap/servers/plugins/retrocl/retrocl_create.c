@@ -177,7 +177,8 @@ retrocl_create_be(const char *bedir)
  *
  * Description:
  * This function is called if there was no mapping tree node or backend for
- * cn=changelog.
+ * cn=changelog.  With the log storage the backend is the virtual one set up
+ * by retrocl_be_init and only the mapping tree node may be missing.
  */
 int
 retrocl_create_config(void)
@@ -192,7 +193,9 @@ retrocl_create_config(void)
     vals[0] = &val;
     vals[1] = NULL;
 
-    retrocl_be_changelog = slapi_be_select_by_instance_name("changelog");
+    if (!retrocl_use_log) {
+        retrocl_be_changelog = slapi_be_select_by_instance_name("changelog");
+    }
 
     if (retrocl_be_changelog == NULL) {
         /* This is not the nsslapd-changelogdir from cn=changelog4,cn=config */
@@ -0,0 +1,921 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * Log structured storage for the retro changelog.
+ *
+ * Changes are appended to segment files named after the changenumber they
+ * start with (retrocl.<changenumber>.log).  A segment is an 8 byte header
+ * (magic and version) followed by records:
+ *
+ *     uint32 length | uint32 checksum | uint64 changenumber | int64 changetime | LDIF
+ *
+ * integers being big endian and the LDIF the changelog entry as produced by
+ * slapi_entry2str().  Only the last segment is written to.  It is rolled when
+ * it grows past nsslapd-changelog-segment-size or, if a maximum age is set,
+ * once its first change is older than a quarter of that age, so trimming is
+ * a matter of unlinking whole segments.
+ *
+ * Each segment keeps a sparse changenumber -> offset index in memory, one
+ * slot every RETROCL_LOG_INDEX_STEP records, rebuilt at startup by walking
+ * the record headers.  The records of the last segment are verified at that
+ * point and a torn tail left by a crash is truncated.
+ *
+ * Bytes below the published size of a segment never change: readers only
+ * take the lock to look a segment up and read the file without it.  A record
+ * is synced to disk before it is published, so a change returned to a reader
+ * survives an OS crash or a power loss.
+ */
+
+#include "retrocl.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define RETROCL_LOG_MAGIC        "RCL\001"
+#define RETROCL_LOG_VERSION      1
+#define RETROCL_LOG_HDR_LEN      8
+#define RETROCL_LOG_REC_HDR_LEN  24
+#define RETROCL_LOG_MAX_RECORD   (256 * 1024 * 1024)
+#define RETROCL_LOG_INDEX_STEP   64
+#define RETROCL_LOG_READ_BUFSIZE (64 * 1024)
+#define RETROCL_LOG_PREFIX       "retrocl."
+#define RETROCL_LOG_SUFFIX       ".log"
+
+typedef struct _retrocl_log_slot
+{
+    changeNumber ls_cnum;
+    PRUint64 ls_offset;
+} retrocl_log_slot;
+
+typedef struct _retrocl_segment
+{
+    char *sg_path;
+    changeNumber sg_first_cn; /* 0 while the segment is empty */
+    changeNumber sg_last_cn;
+    time_t sg_first_time;
+    time_t sg_last_time;
+    PRUint64 sg_size;         /* bytes of complete records, header included */
+    PRUint64 sg_nrecords;
+    retrocl_log_slot *sg_index;
+    size_t sg_nindex;
+    size_t sg_maxindex;
+} retrocl_segment;
+
+static struct
+{
+    Slapi_RWLock *rl_lock;
+    char *rl_dir;
+    PRUint64 rl_segment_size;
+    time_t rl_max_age;
+    retrocl_segment **rl_segs;
+    size_t rl_nsegs;
+    size_t rl_maxsegs;
+    int rl_fd; /* the last segment, opened for writing */
+} rlog = {0};
+
+struct _retrocl_log_cursor
+{
+    changeNumber lc_next;  /* next changenumber to return */
+    changeNumber lc_to;    /* last changenumber to return */
+    changeNumber lc_seg;   /* first changenumber of the open segment */
+    int lc_done;
+    int lc_fd;
+    PRUint64 lc_offset;    /* file offset of the next record */
+    PRUint64 lc_limit;     /* published size of the open segment */
+    char *lc_buf;
+    size_t lc_bufsize;
+    size_t lc_buflen;
+    PRUint64 lc_bufoff;    /* file offset of lc_buf[0] */
+};
+
+static void
+put32(unsigned char *p, PRUint32 v)
+{
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+
+static void
+put64(unsigned char *p, PRUint64 v)
+{
+    put32(p, (PRUint32)(v >> 32));
+    put32(p + 4, (PRUint32)v);
+}
+
+static PRUint32
+get32(const unsigned char *p)
+{
+    return ((PRUint32)p[0] << 24) | ((PRUint32)p[1] << 16) | ((PRUint32)p[2] << 8) | (PRUint32)p[3];
+}
+
+static PRUint64
+get64(const unsigned char *p)
+{
+    return ((PRUint64)get32(p) << 32) | (PRUint64)get32(p + 4);
+}
+
+/* FNV-1a, enough to tell a torn record from a complete one */
+static PRUint32
+retrocl_log_checksum(const char *data, size_t len)
+{
+    PRUint32 h = 2166136261U;
+
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)data[i];
+        h *= 16777619U;
+    }
+    return h;
+}
+
+static int
+retrocl_log_pread(int fd, void *buf, size_t len, PRUint64 offset)
+{
+    size_t done = 0;
+
+    while (done < len) {
+        ssize_t rc = pread(fd, (char *)buf + done, len - done, (off_t)(offset + done));
+        if (rc < 0 && errno == EINTR) {
+            continue;
+        }
+        if (rc <= 0) {
+            return -1;
+        }
+        done += rc;
+    }
+    return 0;
+}
+
+static int
+retrocl_log_pwrite(int fd, const void *buf, size_t len, PRUint64 offset)
+{
+    size_t done = 0;
+
+    while (done < len) {
+        ssize_t rc = pwrite(fd, (const char *)buf + done, len - done, (off_t)(offset + done));
+        if (rc < 0 && errno == EINTR) {
+            continue;
+        }
+        if (rc <= 0) {
+            return -1;
+        }
+        done += rc;
+    }
+    return 0;
+}
+
+static retrocl_segment *
+retrocl_segment_new(const char *path)
+{
+    retrocl_segment *seg = (retrocl_segment *)slapi_ch_calloc(1, sizeof(retrocl_segment));
+
+    seg->sg_path = slapi_ch_strdup(path);
+    seg->sg_size = RETROCL_LOG_HDR_LEN;
+    return seg;
+}
+
+static void
+retrocl_segment_free(retrocl_segment **seg)
+{
+    if (seg && *seg) {
+        slapi_ch_free_string(&(*seg)->sg_path);
+        slapi_ch_free((void **)&(*seg)->sg_index);
+        slapi_ch_free((void **)seg);
+    }
+}
+
+/* Account for a record of reclen bytes written at offset */
+static void
+retrocl_segment_note_record(retrocl_segment *seg, changeNumber cnum, time_t changetime, PRUint64 offset, PRUint64 reclen)
+{
+    if (seg->sg_nrecords % RETROCL_LOG_INDEX_STEP == 0) {
+        if (seg->sg_nindex == seg->sg_maxindex) {
+            seg->sg_maxindex = seg->sg_maxindex ? seg->sg_maxindex * 2 : 16;
+            seg->sg_index = (retrocl_log_slot *)slapi_ch_realloc((char *)seg->sg_index,
+                                                                 seg->sg_maxindex * sizeof(retrocl_log_slot));
+        }
+        seg->sg_index[seg->sg_nindex].ls_cnum = cnum;
+        seg->sg_index[seg->sg_nindex].ls_offset = offset;
+        seg->sg_nindex++;
+    }
+    if (seg->sg_nrecords == 0) {
+        seg->sg_first_cn = cnum;
+        seg->sg_first_time = changetime;
+    }
+    seg->sg_last_cn = cnum;
+    seg->sg_last_time = changetime;
+    seg->sg_size = offset + reclen;
+    seg->sg_nrecords++;
+}
+
+/* Offset of the last indexed record at or before cnum */
+static PRUint64
+retrocl_segment_lookup(retrocl_segment *seg, changeNumber cnum)
+{
+    size_t lo = 0, hi = seg->sg_nindex;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (seg->sg_index[mid].ls_cnum <= cnum) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo ? seg->sg_index[lo - 1].ls_offset : RETROCL_LOG_HDR_LEN;
+}
+
+/*
+ * Index of the first non empty segment holding changes at or after cnum,
+ * -1 if there is none.  The lock must be held.
+ */
+static ssize_t
+retrocl_log_find_segment(changeNumber cnum)
+{
+    size_t lo = 0, hi = rlog.rl_nsegs;
+
+    /* first segment whose last changenumber is >= cnum */
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (rlog.rl_segs[mid]->sg_nrecords && rlog.rl_segs[mid]->sg_last_cn < cnum) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    while (lo < rlog.rl_nsegs && rlog.rl_segs[lo]->sg_nrecords == 0) {
+        lo++;
+    }
+    return lo < rlog.rl_nsegs ? (ssize_t)lo : -1;
+}
+
+/*
+ * Rebuild the index of a segment by walking its record headers.  Records of
+ * the last segment are checksummed too.  Whatever follows the last valid
+ * record is truncated.
+ */
+static int
+retrocl_segment_scan(retrocl_segment *seg, int verify)
+{
+    unsigned char hdr[RETROCL_LOG_REC_HDR_LEN];
+    char *payload = NULL;
+    size_t payload_size = 0;
+    struct stat st;
+    PRUint64 offset = RETROCL_LOG_HDR_LEN;
+    int fd;
+
+    if ((fd = open(seg->sg_path, O_RDWR)) < 0 || fstat(fd, &st) != 0) {
+        slapi_log_err(SLAPI_LOG_ERR, RETROCL_PLUGIN_NAME,
+                      "retrocl_segment_scan - Unable to open %s (%d)\n", seg->sg_path, errno);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    if (st.st_size < RETROCL_LOG_HDR_LEN ||
+        retrocl_log_pread(fd, hdr, RETROCL_LOG_HDR_LEN, 0) != 0 ||
+        memcmp(hdr, RETROCL_LOG_MAGIC, 4) != 0 ||
+        get32(hdr + 4) != RETROCL_LOG_VERSION) {
+        slapi_log_err(SLAPI_LOG_ERR, RETROCL_PLUGIN_NAME,
+                      "retrocl_segment_scan - %s is not a retro changelog segment\n", seg->sg_path);
+        close(fd);
+        return -1;
+    }
+
+    while (offset + RETROCL_LOG_REC_HDR_LEN <= (PRUint64)st.st_size) {
+        PRUint32 len;
+        changeNumber cnum;
+
+        if (retrocl_log_pread(fd, hdr, RETROCL_LOG_REC_HDR_LEN, offset) != 0) {
+            break;
+        }
+        len = get32(hdr);
+        cnum = (changeNumber)get64(hdr + 8);
+        if (len == 0 || len > RETROCL_LOG_MAX_RECORD ||
+            offset + RETROCL_LOG_REC_HDR_LEN + len > (PRUint64)st.st_size ||
+            (seg->sg_nrecords && cnum <= seg->sg_last_cn)) {
+            break;
+        }
+        if (verify) {
+            if (len > payload_size) {
+                payload_size = len;
+                payload = slapi_ch_realloc(payload, payload_size);
+            }
+            if (retrocl_log_pread(fd, payload, len, offset + RETROCL_LOG_REC_HDR_LEN) != 0 ||
+                retrocl_log_checksum(payload, len) != get32(hdr + 4)) {
+                break;
+            }
+        }
+        retrocl_segment_note_record(seg, cnum, (time_t)get64(hdr + 16), offset,
+                                    RETROCL_LOG_REC_HDR_LEN + len);
+        offset += RETROCL_LOG_REC_HDR_LEN + len;
+    }
+    slapi_ch_free_string(&payload);
+
+    if (offset < (PRUint64)st.st_size) {
+        slapi_log_err(SLAPI_LOG_WARNING, RETROCL_PLUGIN_NAME,
+                      "retrocl_segment_scan - Truncating %s from %" PRIu64 " to %" PRIu64 " bytes "
+                      "(incomplete or damaged record after change %lu)\n",
+                      seg->sg_path, (PRUint64)st.st_size, offset, seg->sg_last_cn);
+        if (ftruncate(fd, (off_t)offset) != 0) {
+            slapi_log_err(SLAPI_LOG_ERR, RETROCL_PLUGIN_NAME,
+                          "retrocl_segment_scan - Unable to truncate %s (%d)\n", seg->sg_path, errno);
+        }
+    }
+    seg->sg_size = offset;
+    close(fd);
+    return 0;
+}
+
+static int
+retrocl_segment_cmp(const void *a, const void *b)
+{
+    const retrocl_segment *sa = *(const retrocl_segment **)a;
+    const retrocl_segment *sb = *(const retrocl_segment **)b;
+
+    /* Until scanned sg_first_cn holds the changenumber from the file name */
+    if (sa->sg_first_cn < sb->sg_first_cn) {
+        return -1;
+    }
+    return sa->sg_first_cn > sb->sg_first_cn;
+}
+
+static void
+retrocl_log_add_segment(retrocl_segment *seg)
+{
+    if (rlog.rl_nsegs == rlog.rl_maxsegs) {
+        rlog.rl_maxsegs = rlog.rl_maxsegs ? rlog.rl_maxsegs * 2 : 16;
+        rlog.rl_segs = (retrocl_segment **)slapi_ch_realloc((char *)rlog.rl_segs,
+                                                             rlog.rl_maxsegs * sizeof(retrocl_segment *));
+    }
+    rlog.rl_segs[rlog.rl_nsegs++] = seg;
+}
+
+/*
+ * Close the active segment and start a new one for changes from cnum on.
+ * The write lock must be held.
+ */
+static int
+retrocl_log_roll(changeNumber cnum)
+{
+    unsigned char hdr[RETROCL_LOG_HDR_LEN];
+    retrocl_segment *seg;
+    char *path;
+    int dirfd;
+    int fd;
+
+    if (rlog.rl_fd >= 0) {
+        fsync(rlog.rl_fd);
+        close(rlog.rl_fd);
+        rlog.rl_fd = -1;
+    }
+
+    path = slapi_ch_smprintf("%s/%s%020lu%s", rlog.rl_dir, RETROCL_LOG_PREFIX, cnum, RETROCL_LOG_SUFFIX);
+    memcpy(hdr, RETROCL_LOG_MAGIC, 4);
+    put32(hdr + 4, RETROCL_LOG_VERSION);
+    if ((fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600)) < 0 ||
+        retrocl_log_pwrite(fd, hdr, RETROCL_LOG_HDR_LEN, 0) != 0) {
+        slapi_log_err(SLAPI_LOG_ERR, RETROCL_PLUGIN_NAME,
+                      "retrocl_log_roll - Unable to create segment %s (%d)\n", path, errno);
+        if (fd >= 0) {
+            close(fd);
+            unlink(path);
+        }
+        slapi_ch_free_string(&path);
+        return -1;
+    }
+
+    /* the records are synced, the new file name must be too */
+    if ((dirfd = open(rlog.rl_dir, O_RDONLY | O_DIRECTORY)) >= 0) {
+        fsync(dirfd);
+        close(dirfd);
+    }
+
+    seg = retrocl_segment_new(path);
+    slapi_ch_free_string(&path);
+    retrocl_log_add_segment(seg);
+    rlog.rl_fd = fd;
+    slapi_log_err(SLAPI_LOG_PLUGIN, RETROCL_PLUGIN_NAME,
+                  "retrocl_log_roll - Started segment %s\n", seg->sg_path);
+    return 0;
+}
+
+/*
+ * Function: retrocl_log_open
+ *
+ * Returns: 0 on success, -1 on failure
+ *
+ * Arguments: directory holding the segments, segment size in bytes
+ *
+ * Description: loads the existing segments, builds their index and opens
+ * the last one for appending.
+ */
+int
+retrocl_log_open(const char *dir, PRUint64 segment_size)
+{
+    PRDir *dirptr = NULL;
+    PRDirEntry *dirent = NULL;
+    retrocl_segment **segs = NULL;
+    size_t nsegs = 0;
+    size_t maxsegs = 0;
+    size_t prefix_len = strlen(RETROCL_LOG_PREFIX);
+    size_t suffix_len = strlen(RETROCL_LOG_SUFFIX);
+
+    if (rlog.rl_lock == NULL && (rlog.rl_lock = slapi_new_rwlock()) == NULL) {
+        return -1;
+    }
+    rlog.rl_dir = slapi_ch_strdup(dir);
+    rlog.rl_segment_size = segment_size;
+    rlog.rl_fd = -1;
+
+    if (mkdir_p(rlog.rl_dir, 0700) != 0) {
+        slapi_log_err(SLAPI_LOG_ERR, RETROCL_PLUGIN_NAME,
+                      "retrocl_log_open - Unable to create directory %s (%d)\n", dir, errno);
+        return -1;
+    }
+    if ((dirptr = PR_OpenDir(dir)) == NULL) {
+        slapi_log_err(SLAPI_LOG_ERR, RETROCL_PLUGIN_NAME,
+                      "retrocl_log_open - Unable to open directory %s\n", dir);
+        return -1;
+    }
+    while ((dirent = PR_ReadDir(dirptr, PR_SKIP_BOTH)) != NULL) {
+        const char *name = dirent->name;
+        size_t len = strlen(name);
+        retrocl_segment *seg;
+        char *path;
+
+        if (len <= prefix_len + suffix_len ||
+            strncmp(name, RETROCL_LOG_PREFIX, prefix_len) != 0 ||
+            strcmp(name + len - suffix_len, RETROCL_LOG_SUFFIX) != 0) {
+            continue;
+        }
+        path = slapi_ch_smprintf("%s/%s", dir, name);
+        seg = retrocl_segment_new(path);
+        slapi_ch_free_string(&path);
+        seg->sg_first_cn = strntoul((char *)name + prefix_len, len - prefix_len - suffix_len, 10);
+        if (nsegs == maxsegs) {
+            maxsegs = maxsegs ? maxsegs * 2 : 16;
+            segs = (retrocl_segment **)slapi_ch_realloc((char *)segs, maxsegs * sizeof(retrocl_segment *));
+        }
+        segs[nsegs++] = seg;
+    }
+    PR_CloseDir(dirptr);
+
+    if (nsegs) {
+        qsort(segs, nsegs, sizeof(retrocl_segment *), retrocl_segment_cmp);
+    }
+    for (size_t i = 0; i < nsegs; i++) {
+        retrocl_segment *seg = segs[i];
+
+        seg->sg_first_cn = 0;
+        if (retrocl_segment_scan(seg, i == nsegs - 1) != 0) {
+            retrocl_segment_free(&seg);
+            continue;
+        }
+        if (seg->sg_nrecords == 0 ||
+            (rlog.rl_nsegs && seg->sg_first_cn <= rlog.rl_segs[rlog.rl_nsegs - 1]->sg_last_cn)) {
+            if (seg->sg_nrecords) {
+                slapi_log_err(SLAPI_LOG_ERR, RETROCL_PLUGIN_NAME,
+                              "retrocl_log_open - Discarding segment %s, its changes overlap "
+                              "the previous segment\n", seg->sg_path);
+            }
+            unlink(seg->sg_path);
+            retrocl_segment_free(&seg);
+            continue;
+        }
+        retrocl_log_add_segment(seg);
+    }
+    slapi_ch_free((void **)&segs);
+
+    if (rlog.rl_nsegs) {
+        retrocl_segment *last = rlog.rl_segs[rlog.rl_nsegs - 1];
+
+        if ((rlog.rl_fd = open(last->sg_path, O_WRONLY)) < 0) {
+            slapi_log_err(SLAPI_LOG_ERR, RETROCL_PLUGIN_NAME,
+                          "retrocl_log_open - Unable to open %s for writing (%d)\n", last->sg_path, errno);
+            return -1;
+        }
+    }
+
+    slapi_log_err(SLAPI_LOG_PLUGIN, RETROCL_PLUGIN_NAME,
+                  "retrocl_log_open - Loaded %lu segment(s) from %s\n", (unsigned long)rlog.rl_nsegs, dir);
+    return 0;
+}
+
+/*
+ * Function: retrocl_log_close
+ *
+ * Description: flushes the active segment and forgets about the log.
+ */
+void
+retrocl_log_close(void)
+{
+    if (rlog.rl_lock == NULL) {
+        return;
+    }
+    slapi_rwlock_wrlock(rlog.rl_lock);
+    if (rlog.rl_fd >= 0) {
+        fsync(rlog.rl_fd);
+        close(rlog.rl_fd);
+        rlog.rl_fd = -1;
+    }
+    for (size_t i = 0; i < rlog.rl_nsegs; i++) {
+        retrocl_segment_free(&rlog.rl_segs[i]);
+    }
+    slapi_ch_free((void **)&rlog.rl_segs);
+    rlog.rl_nsegs = rlog.rl_maxsegs = 0;
+    slapi_ch_free_string(&rlog.rl_dir);
+    slapi_rwlock_unlock(rlog.rl_lock);
+}
+
+void
+retrocl_log_set_max_age(time_t max_age)
+{
+    if (rlog.rl_lock) {
+        slapi_rwlock_wrlock(rlog.rl_lock);
+        rlog.rl_max_age = max_age;
+        slapi_rwlock_unlock(rlog.rl_lock);
+    }
+}
+
+/*
+ * Function: retrocl_log_append
+ *
+ * Returns: LDAP_SUCCESS or LDAP_OPERATIONS_ERROR
+ *
+ * Arguments: changenumber and changetime of the record, changelog entry
+ *
+ * Description: appends the entry to the active segment, rolling it first if
+ * needed, and syncs it.  Changenumbers must be increasing; the caller
+ * serializes appends with retrocl_internal_lock.
+ */
+int
+retrocl_log_append(changeNumber cnum, time_t changetime, Slapi_Entry *e)
+{
+    retrocl_segment *seg = NULL;
+    unsigned char *buf;
+    char *ldif;
+    int len = 0;
+    int rc = LDAP_SUCCESS;
+
+    if ((ldif = slapi_entry2str(e, &len)) == NULL || len <= 0 || len > RETROCL_LOG_MAX_RECORD) {
+        slapi_log_err(SLAPI_LOG_ERR, RETROCL_PLUGIN_NAME,
+                      "retrocl_log_append - Unable to serialize change %lu\n", cnum);
+        slapi_ch_free_string(&ldif);
+        return LDAP_OPERATIONS_ERROR;
+    }
+    buf = (unsigned char *)slapi_ch_malloc(RETROCL_LOG_REC_HDR_LEN + len);
+    put32(buf, (PRUint32)len);
+    put32(buf + 4, retrocl_log_checksum(ldif, len));
+    put64(buf + 8, (PRUint64)cnum);
+    put64(buf + 16, (PRUint64)changetime);
+    memcpy(buf + RETROCL_LOG_REC_HDR_LEN, ldif, len);
+    slapi_ch_free_string(&ldif);
+
+    slapi_rwlock_wrlock(rlog.rl_lock);
+    if (rlog.rl_nsegs) {
+        seg = rlog.rl_segs[rlog.rl_nsegs - 1];
+    }
+    if (seg == NULL || rlog.rl_fd < 0 ||
+        (seg->sg_nrecords &&
+         (seg->sg_size >= rlog.rl_segment_size ||
+          (rlog.rl_max_age > 0 && changetime - seg->sg_first_time >= (rlog.rl_max_age + 3) / 4)))) {
+        if (retrocl_log_roll(cnum) != 0) {
+            rc = LDAP_OPERATIONS_ERROR;
+            goto done;
+        }
+        seg = rlog.rl_segs[rlog.rl_nsegs - 1];
+    }
+
+    if (retrocl_log_pwrite(rlog.rl_fd, buf, RETROCL_LOG_REC_HDR_LEN + len, seg->sg_size) != 0 ||
+        fdatasync(rlog.rl_fd) != 0) {
+        slapi_log_err(SLAPI_LOG_ERR, RETROCL_PLUGIN_NAME,
+                      "retrocl_log_append - Unable to write change %lu to %s (%d)\n",
+                      cnum, seg->sg_path, errno);
+        /* drop whatever made it to the file */
+        if (ftruncate(rlog.rl_fd, (off_t)seg->sg_size) != 0) {
+            slapi_log_err(SLAPI_LOG_ERR, RETROCL_PLUGIN_NAME,
+                          "retrocl_log_append - Unable to truncate %s (%d)\n", seg->sg_path, errno);
+        }
+        rc = LDAP_OPERATIONS_ERROR;
+        goto done;
+    }
+    retrocl_segment_note_record(seg, cnum, changetime, seg->sg_size, RETROCL_LOG_REC_HDR_LEN + len);
+
+done:
+    slapi_rwlock_unlock(rlog.rl_lock);
+    slapi_ch_free((void **)&buf);
+    return rc;
+}
+
+/*
+ * Function: retrocl_log_get_range
+ *
+ * Description: first and last changenumbers in the log, 0 if it is empty.
+ */
+void
+retrocl_log_get_range(changeNumber *first, changeNumber *last)
+{
+    *first = *last = 0;
+    slapi_rwlock_rdlock(rlog.rl_lock);
+    for (size_t i = 0; i < rlog.rl_nsegs; i++) {
+        if (rlog.rl_segs[i]->sg_nrecords) {
+            if (*first == 0) {
+                *first = rlog.rl_segs[i]->sg_first_cn;
+            }
+            *last = rlog.rl_segs[i]->sg_last_cn;
+        }
+    }
+    slapi_rwlock_unlock(rlog.rl_lock);
+}
+
+/*
+ * Function: retrocl_log_get_time
+ *
+ * Returns: changetime of the first or last change, NO_TIME if the log is
+ * empty.
+ *
+ * Arguments: SLAPI_SEQ_FIRST or SLAPI_SEQ_LAST
+ */
+time_t
+retrocl_log_get_time(int type)
+{
+    time_t t = NO_TIME;
+
+    slapi_rwlock_rdlock(rlog.rl_lock);
+    for (size_t i = 0; i < rlog.rl_nsegs; i++) {
+        if (rlog.rl_segs[i]->sg_nrecords) {
+            if (type == SLAPI_SEQ_FIRST) {
+                t = rlog.rl_segs[i]->sg_first_time;
+                break;
+            }
+            t = rlog.rl_segs[i]->sg_last_time;
+        }
+    }
+    slapi_rwlock_unlock(rlog.rl_lock);
+    return t;
+}
+
+/*
+ * Function: retrocl_log_trimmable
+ *
+ * Returns: non-zero if the oldest segment only holds changes older than
+ * max_age.  The active segment is never trimmed.
+ */
+int
+retrocl_log_trimmable(time_t max_age, time_t now)
+{
+    int rc;
+
+    slapi_rwlock_rdlock(rlog.rl_lock);
+    rc = rlog.rl_nsegs > 1 && rlog.rl_segs[0]->sg_last_time + max_age < now;
+    slapi_rwlock_unlock(rlog.rl_lock);
+    return rc;
+}
+
+/*
+ * Function: retrocl_log_trim
+ *
+ * Returns: number of changes removed
+ *
+ * Arguments: max_age, current time, first changenumber left in the log
+ *
+ * Description: drops the segments whose last change is older than max_age.
+ * Files are unlinked once the lock is released; cursors still reading them
+ * keep their descriptor.
+ */
+int
+retrocl_log_trim(time_t max_age, time_t now, changeNumber *first)
+{
+    retrocl_segment **dead = NULL;
+    size_t ndead = 0;
+    int removed = 0;
+
+    slapi_rwlock_wrlock(rlog.rl_lock);
+    while (ndead + 1 < rlog.rl_nsegs &&
+           rlog.rl_segs[ndead]->sg_last_time + max_age < now) {
+        removed += (int)rlog.rl_segs[ndead]->sg_nrecords;
+        ndead++;
+    }
+    if (ndead) {
+        dead = (retrocl_segment **)slapi_ch_malloc(ndead * sizeof(retrocl_segment *));
+        memcpy(dead, rlog.rl_segs, ndead * sizeof(retrocl_segment *));
+        memmove(rlog.rl_segs, rlog.rl_segs + ndead, (rlog.rl_nsegs - ndead) * sizeof(retrocl_segment *));
+        rlog.rl_nsegs -= ndead;
+    }
+    *first = rlog.rl_nsegs ? rlog.rl_segs[0]->sg_first_cn : 0;
+    slapi_rwlock_unlock(rlog.rl_lock);
+
+    for (size_t i = 0; i < ndead; i++) {
+        slapi_log_err(SLAPI_LOG_PLUGIN, RETROCL_PLUGIN_NAME,
+                      "retrocl_log_trim - Removing segment %s (changes %lu to %lu)\n",
+                      dead[i]->sg_path, dead[i]->sg_first_cn, dead[i]->sg_last_cn);
+        if (unlink(dead[i]->sg_path) != 0) {
+            slapi_log_err(SLAPI_LOG_ERR, RETROCL_PLUGIN_NAME,
+                          "retrocl_log_trim - Unable to remove %s (%d)\n", dead[i]->sg_path, errno);
+        }
+        retrocl_segment_free(&dead[i]);
+    }
+    slapi_ch_free((void **)&dead);
+    return removed;
+}
+
+/*
+ * Function: retrocl_log_cursor_new
+ *
+ * Returns: a cursor over the changes numbered from "from" to "to"
+ *
+ * Description: nothing is read until retrocl_log_cursor_next is called;
+ * changes appended in the meantime are returned if they are in range.
+ */
+retrocl_log_cursor *
+retrocl_log_cursor_new(changeNumber from, changeNumber to)
+{
+    retrocl_log_cursor *cur = (retrocl_log_cursor *)slapi_ch_calloc(1, sizeof(retrocl_log_cursor));
+
+    cur->lc_next = from ? from : 1;
+    cur->lc_to = to;
+    cur->lc_fd = -1;
+    return cur;
+}
+
+void
+retrocl_log_cursor_free(retrocl_log_cursor **cur)
+{
+    if (cur && *cur) {
+        if ((*cur)->lc_fd >= 0) {
+            close((*cur)->lc_fd);
+        }
+        slapi_ch_free_string(&(*cur)->lc_buf);
+        slapi_ch_free((void **)cur);
+    }
+}
+
+/*
+ * Position the cursor on the segment holding lc_next, or pick up what was
+ * appended to the current one since it was last looked at.
+ * Returns -1 when there is nothing more to read.
+ */
+static int
+retrocl_log_cursor_seek(retrocl_log_cursor *cur)
+{
+    char *path = NULL;
+    changeNumber seg_first = 0, seg_last = 0;
+    PRUint64 offset = 0, limit = 0;
+    ssize_t i;
+
+    slapi_rwlock_rdlock(rlog.rl_lock);
+    if ((i = retrocl_log_find_segment(cur->lc_next)) < 0) {
+        slapi_rwlock_unlock(rlog.rl_lock);
+        return -1;
+    }
+    seg_first = rlog.rl_segs[i]->sg_first_cn;
+    seg_last = rlog.rl_segs[i]->sg_last_cn;
+    limit = rlog.rl_segs[i]->sg_size;
+    if (cur->lc_fd >= 0 && cur->lc_seg == seg_first) {
+        slapi_rwlock_unlock(rlog.rl_lock);
+        if (limit <= cur->lc_limit) {
+            /* nothing new although the segment claims to hold lc_next */
+            return -1;
+        }
+        cur->lc_limit = limit;
+        return 0;
+    }
+    offset = retrocl_segment_lookup(rlog.rl_segs[i], cur->lc_next);
+    path = slapi_ch_strdup(rlog.rl_segs[i]->sg_path);
+    slapi_rwlock_unlock(rlog.rl_lock);
+
+    if (cur->lc_fd >= 0) {
+        close(cur->lc_fd);
+    }
+    cur->lc_buflen = 0;
+    cur->lc_seg = seg_first;
+    if ((cur->lc_fd = open(path, O_RDONLY)) < 0) {
+        if (errno == ENOENT) {
+            /* trimmed under our feet, move on to what is left */
+            slapi_ch_free_string(&path);
+            cur->lc_next = seg_last + 1;
+            cur->lc_limit = 0;
+            return 0;
+        }
+        slapi_log_err(SLAPI_LOG_ERR, RETROCL_PLUGIN_NAME,
+                      "retrocl_log_cursor_seek - Unable to open %s (%d)\n", path, errno);
+        slapi_ch_free_string(&path);
+        return -1;
+    }
+    slapi_ch_free_string(&path);
+    cur->lc_offset = offset;
+    cur->lc_limit = limit;
+    return 0;
+}
+
+/* Make len bytes at the cursor offset available in the read buffer */
+static const unsigned char *
+retrocl_log_cursor_read(retrocl_log_cursor *cur, size_t len)
+{
+    size_t want;
+
+    if (cur->lc_offset + len > cur->lc_limit) {
+        return NULL;
+    }
+    if (cur->lc_buflen && cur->lc_offset >= cur->lc_bufoff &&
+        cur->lc_offset + len <= cur->lc_bufoff + cur->lc_buflen) {
+        return (const unsigned char *)cur->lc_buf + (cur->lc_offset - cur->lc_bufoff);
+    }
+    want = len > RETROCL_LOG_READ_BUFSIZE ? len : RETROCL_LOG_READ_BUFSIZE;
+    if (want > cur->lc_limit - cur->lc_offset) {
+        want = cur->lc_limit - cur->lc_offset;
+    }
+    if (want > cur->lc_bufsize) {
+        cur->lc_bufsize = want;
+        cur->lc_buf = slapi_ch_realloc(cur->lc_buf, cur->lc_bufsize);
+    }
+    if (retrocl_log_pread(cur->lc_fd, cur->lc_buf, want, cur->lc_offset) != 0) {
+        cur->lc_buflen = 0;
+        return NULL;
+    }
+    cur->lc_bufoff = cur->lc_offset;
+    cur->lc_buflen = want;
+    return (const unsigned char *)cur->lc_buf;
+}
+
+/*
+ * Function: retrocl_log_cursor_next
+ *
+ * Returns: the next changelog entry in range, which the caller must free,
+ * or NULL at the end.
+ */
+Slapi_Entry *
+retrocl_log_cursor_next(retrocl_log_cursor *cur)
+{
+    while (!cur->lc_done && cur->lc_next <= cur->lc_to) {
+        const unsigned char *rec;
+        Slapi_Entry *e;
+        changeNumber cnum;
+        PRUint32 len;
+        char *ldif;
+
+        if (cur->lc_fd < 0 || (rec = retrocl_log_cursor_read(cur, RETROCL_LOG_REC_HDR_LEN)) == NULL) {
+            if (retrocl_log_cursor_seek(cur) != 0) {
+                break;
+            }
+            continue;
+        }
+        len = get32(rec);
+        cnum = (changeNumber)get64(rec + 8);
+        if ((rec = retrocl_log_cursor_read(cur, RETROCL_LOG_REC_HDR_LEN + len)) == NULL) {
+            /* should not happen below the published size */
+            slapi_log_err(SLAPI_LOG_ERR, RETROCL_PLUGIN_NAME,
+                          "retrocl_log_cursor_next - Unable to read change %lu\n", cnum);
+            break;
+        }
+        cur->lc_offset += RETROCL_LOG_REC_HDR_LEN + len;
+        if (cnum < cur->lc_next) {
+            continue;
+        }
+        if (cnum > cur->lc_to) {
+            break;
+        }
+        cur->lc_next = cnum + 1;
+
+        ldif = slapi_ch_malloc(len + 1);
+        memcpy(ldif, rec + RETROCL_LOG_REC_HDR_LEN, len);
+        ldif[len] = '\0';
+        e = slapi_str2entry(ldif, SLAPI_STR2ENTRY_NO_ENTRYDN);
+        slapi_ch_free_string(&ldif);
+        if (e == NULL) {
+            slapi_log_err(SLAPI_LOG_ERR, RETROCL_PLUGIN_NAME,
+                          "retrocl_log_cursor_next - Unable to parse change %lu\n", cnum);
+            continue;
+        }
+        return e;
+    }
+    cur->lc_done = 1;
+    return NULL;
+}
+
+/*
+ * Function: retrocl_log_get_entry
+ *
+ * Returns: the changelog entry for cnum, to be freed by the caller, or NULL.
+ */
+Slapi_Entry *
+retrocl_log_get_entry(changeNumber cnum)
+{
+    retrocl_log_cursor *cur = retrocl_log_cursor_new(cnum, cnum);
+    Slapi_Entry *e = retrocl_log_cursor_next(cur);
+
+    retrocl_log_cursor_free(&cur);
+    return e;
+}
@@ -362,8 +362,20 @@ write_replog_db(
         err = SLAPI_PLUGIN_FAILURE;
     }
 
-    /* Call the repl backend to add this entry */
-    if (0 == err) {
+    /* Append the change to the log, or call the repl backend to add this entry */
+    if (0 == err && retrocl_use_log) {
+        ret = retrocl_log_append(changenum, curtime, e);
+        slapi_entry_free(e);
+        if (0 != ret) {
+            slapi_log_err(SLAPI_LOG_ERR, RETROCL_PLUGIN_NAME,
+                          "write_replog_db - An error occurred while appending change "
+                          "number %lu, dn = %s: %s. \n",
+                          changenum, edn, ldap_err2string(ret));
+            retrocl_release_changenumber();
+        } else {
+            retrocl_commit_changenumber();
+        }
+    } else if (0 == err) {
         newPb = slapi_pblock_new();
         slapi_add_entry_internal_set_pb(newPb, e, NULL /* controls */,
                                         g_plg_identity[PLUGIN_RETROCL],
@@ -259,6 +259,18 @@ trim_changelog(void)
          */
         done = 0;
         now_maxage = slapi_current_utc_time(); /* real time for trim candidates */
+        if (retrocl_use_log) {
+            /* The log is trimmed a whole segment at a time */
+            if (max_age > 0L && retrocl_trimming == 1 && !slapi_is_shutting_down()) {
+                changeNumber first = 0;
+
+                num_deleted = retrocl_log_trim(max_age, now_maxage, &first);
+                if (first) {
+                    retrocl_set_first_changenumber(first);
+                }
+            }
+            done = 1;
+        }
         while (!done && retrocl_trimming == 1 && !slapi_is_shutting_down()) {
             int did_delete;
 
@@ -386,7 +398,10 @@ retrocl_housekeeping(time_t cur_time, void *noarg __attribute__((unused)))
             slapi_log_err(SLAPI_LOG_PLUGIN, RETROCL_PLUGIN_NAME,
                           "cltrim: ldrc=%d, first_time=%ld, cur_time=%ld\n",
                           ldrc, first_time, cur_time);
-            if (LDAP_SUCCESS == ldrc && first_time > (time_t)0L &&
+            if (retrocl_use_log) {
+                /* only worth a thread if a whole segment has expired */
+                must_trim = ts.ts_c_max_age > 0 && retrocl_log_trimmable(ts.ts_c_max_age, now_maxage);
+            } else if (LDAP_SUCCESS == ldrc && first_time > (time_t)0L &&
                 first_time + ts.ts_c_max_age < now_maxage)
             {
                 must_trim = 1;
@@ -470,6 +485,9 @@ retrocl_init_trimming(void)
     }
 
     ts.ts_c_max_age = ageval;
+    if (retrocl_use_log) {
+        retrocl_log_set_max_age(ageval);
+    }
     ts.ts_c_trim_interval = trim_interval;
     ts.ts_s_last_trim = (time_t)0L;
     ts.ts_s_trimming = 0;
@@ -32,6 +32,7 @@
 #define SYNC_ALLOW_OPENLDAP_COMPAT "syncrepl-allow-openldap"
 #define SYNC_CFG_MAX_CONCURRENT "syncrepl-max-concurrent"
 #define SYNC_CFG_QUEUE_MAX_SIZE "syncrepl-queue-max-size"
+#define SYNC_CFG_CHANGE_INDEX_SIZE "syncrepl-change-index-size"
 
 #define OP_FLAG_SYNC_PERSIST 0x01
 
@@ -63,6 +64,19 @@ typedef struct sync_update
     Slapi_Entry *upd_e;
 } Sync_UpdateNode;
 
+/* The part of a retro changelog record used by the sync plugin */
+typedef struct sync_change
+{
+    unsigned long chg_nr;
+    int chg_req; /* LDAP_REQ_xxx, -1 if unknown */
+    char *chg_uuid;
+    char *chg_euuid;
+    char *chg_dn;
+    char *chg_newsuperior;
+} Sync_ChangeRecord;
+
+typedef int (*sync_change_fn)(Sync_ChangeRecord *rec, void *arg);
+
 #define SYNC_CALLBACK_PREINIT (-1)
 
 typedef struct sync_callback
@@ -72,6 +86,7 @@ typedef struct sync_callback
     unsigned long change_start;
     int cb_err;
     Sync_UpdateNode *cb_updates;
+    PLHashTable *cb_uuid_ht; /* uniqueid -> slot in cb_updates */
     PRBool openldap_compat;
 } Sync_CallBackData;
 
@@ -158,6 +173,12 @@ int sync_send_entry_from_changelog(Slapi_PBlock *pb, int chg_req, char *uniqueid
 void sync_send_deleted_entries(Slapi_PBlock *pb, Sync_UpdateNode *upd, int chg_count, Sync_Cookie *session_cookie);
 void sync_send_modified_entries(Slapi_PBlock *pb, Sync_UpdateNode *upd, int chg_count, Sync_Cookie *session_cookie);
 
+int sync_str2chgreq(const char *chgtype);
+int sync_change_index_init(size_t size);
+void sync_change_index_close(void);
+int sync_change_index_replay(unsigned long from, unsigned long to, sync_change_fn fn, void *arg);
+unsigned long sync_change_index_next_change(unsigned long after, const char *uniqueid);
+
 int sync_persist_initialize(int argc, char **argv, Slapi_Entry *config_entry);
 PRThread *sync_persist_add(Slapi_PBlock *pb);
 int sync_persist_startup(PRThread *tid, Sync_Cookie *session_cookie);
@@ -179,9 +200,20 @@ Slapi_ComponentId *plugin_get_default_component_id(void);
  *
  * will be created in post op plugins
  */
+/*
+ * A change is queued on every matching request. The requests share one
+ * copy of the entry, freed when the last of them has sent it.
+ */
+typedef struct sync_shared_entry
+{
+    Slapi_Entry *se_entry;
+    uint64_t se_refcnt;
+} SyncSharedEntry;
+
 typedef struct sync_queue_node
 {
-    Slapi_Entry *sync_entry;
+    Slapi_Entry *sync_entry;  /* se_entry of sync_shared */
+    SyncSharedEntry *sync_shared;
     LDAPControl *pe_ctrls[2]; /* XXX ?? XXX */
     struct sync_queue_node *sync_next;
     int sync_chgtype;
@@ -198,6 +230,7 @@ typedef struct sync_request
     Slapi_PBlock *req_pblock;
     Slapi_Operation *req_orig_op;
     PRLock *req_lock;
+    pthread_cond_t req_cvar; /* signaled when a change is queued, uses sync_req_cvarlock */
     PRThread *req_tid;
     char *req_orig_base;
     Slapi_Filter *req_filter;
@@ -218,12 +251,13 @@ typedef struct sync_request
  */
 #define SYNC_DEFAULT_MAX_CONCURRENT 10
 #define SYNC_DEFAULT_QUEUE_MAX_SIZE 10000
+#define SYNC_DEFAULT_CHANGE_INDEX_SIZE 100000
 typedef struct sync_request_list
 {
     Slapi_RWLock *sync_req_rwlock; /* R/W lock struct to serialize access */
     SyncRequest *sync_req_head;    /* Head of list */
-    pthread_mutex_t sync_req_cvarlock;    /* Lock for cvar */
-    pthread_cond_t sync_req_cvar;         /* ps threads sleep on this */
+    pthread_mutex_t sync_req_cvarlock;    /* Lock for the req_cvar of the requests */
+    pthread_condattr_t sync_req_condattr; /* attributes of the req_cvar of the requests */
     int sync_req_max_persist;
     int sync_req_cur_persist;
     int sync_req_queue_max_size;  /* default max queue size per persistent search */
@@ -0,0 +1,381 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#include "sync.h"
+
+/*
+ * Shared change index
+ *
+ * Every refresh with a cookie and every entry sent in the persist phase
+ * used to run its own internal search on the retro changelog. With many
+ * clients this means the same changelog records are read and parsed over
+ * and over. The change index keeps the few attributes the sync plugin
+ * needs (change number, change type, unique ids, target dn, new superior)
+ * of the most recent changes in memory, ordered by change number.
+ *
+ * The index is loaded incrementally: a loader searches the changelog only
+ * for the change numbers above the highest one already indexed, so each
+ * changelog record is read once whatever the number of clients. Readers
+ * range-scan the index. When a request falls outside of what the index
+ * covers (an old cookie, the index being disabled, ...) the caller falls
+ * back to the changelog searches.
+ *
+ * The index holds all the changes in [si_low, si_high]. If a hole is seen
+ * while loading (a change committed out of change number order), si_low is
+ * moved past it so that the index never claims to cover a missing change.
+ */
+
+typedef struct sync_change_index
+{
+    Slapi_RWLock *si_lock;       /* protects the ring and the bounds */
+    PRLock *si_load_lock;        /* serializes the loaders */
+    Sync_ChangeRecord *si_ring;  /* circular array of si_size records */
+    size_t si_size;
+    size_t si_head;              /* position of the oldest record */
+    size_t si_count;
+    unsigned long si_low;        /* lowest change number covered */
+    unsigned long si_high;       /* highest change number covered */
+    PRBool si_loaded;            /* si_low/si_high are meaningful */
+} Sync_ChangeIndex;
+
+typedef struct sync_index_load
+{
+    Sync_ChangeRecord *sl_recs;
+    size_t sl_count;
+    size_t sl_size;
+} Sync_IndexLoad;
+
+static Sync_ChangeIndex *sync_index = NULL;
+
+static char *sync_index_attrs[] = {CL_ATTR_CHANGENUMBER, CL_ATTR_CHGTYPE,
+                                   CL_ATTR_UNIQUEID, CL_ATTR_ENTRYUUID,
+                                   CL_ATTR_ENTRYDN, CL_ATTR_NEWSUPERIOR, NULL};
+
+#define SYNC_INDEX_AT(idx, i) (&(idx)->si_ring[((idx)->si_head + (i)) % (idx)->si_size])
+
+static void
+sync_change_record_done(Sync_ChangeRecord *rec)
+{
+    slapi_ch_free_string(&rec->chg_uuid);
+    slapi_ch_free_string(&rec->chg_euuid);
+    slapi_ch_free_string(&rec->chg_dn);
+    slapi_ch_free_string(&rec->chg_newsuperior);
+}
+
+int
+sync_str2chgreq(const char *chgtype)
+{
+    if (chgtype == NULL) {
+        return (-1);
+    }
+    if (strcasecmp(chgtype, "add") == 0) {
+        return (LDAP_REQ_ADD);
+    } else if (strcasecmp(chgtype, "modify") == 0) {
+        return (LDAP_REQ_MODIFY);
+    } else if (strcasecmp(chgtype, "modrdn") == 0) {
+        return (LDAP_REQ_MODRDN);
+    } else if (strcasecmp(chgtype, "delete") == 0) {
+        return (LDAP_REQ_DELETE);
+    } else {
+        return (-1);
+    }
+}
+
+static char *
+sync_index_get_value(Slapi_Entry *cl_entry, const char *attrtype)
+{
+    const char *value = slapi_entry_attr_get_ref(cl_entry, attrtype);
+
+    if (value && *value) {
+        return slapi_ch_strdup(value);
+    }
+    return NULL;
+}
+
+/*
+ * Position of the first record whose change number is > after,
+ * si_count if there is none. Caller holds si_lock.
+ */
+static size_t
+sync_index_find(Sync_ChangeIndex *idx, unsigned long after)
+{
+    size_t lo = 0;
+    size_t hi = idx->si_count;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (SYNC_INDEX_AT(idx, mid)->chg_nr <= after) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static int
+sync_index_load_entry(Slapi_Entry *cl_entry, void *cb_data)
+{
+    Sync_IndexLoad *load = (Sync_IndexLoad *)cb_data;
+    Sync_ChangeRecord *rec;
+    const char *chgnr;
+    unsigned long chgnum;
+
+    chgnr = slapi_entry_attr_get_ref(cl_entry, CL_ATTR_CHANGENUMBER);
+    chgnum = chgnr ? sync_number2ulong((char *)chgnr) : SYNC_INVALID_CHANGENUM;
+    if (SYNC_INVALID_CHANGENUM == chgnum) {
+        return (0);
+    }
+    if (load->sl_count == load->sl_size) {
+        load->sl_size = load->sl_size ? load->sl_size * 2 : 64;
+        load->sl_recs = (Sync_ChangeRecord *)slapi_ch_realloc((char *)load->sl_recs,
+                                                              load->sl_size * sizeof(Sync_ChangeRecord));
+    }
+    rec = &load->sl_recs[load->sl_count++];
+    rec->chg_nr = chgnum;
+    rec->chg_req = sync_str2chgreq(slapi_entry_attr_get_ref(cl_entry, CL_ATTR_CHGTYPE));
+    rec->chg_uuid = sync_index_get_value(cl_entry, CL_ATTR_UNIQUEID);
+    rec->chg_euuid = sync_index_get_value(cl_entry, CL_ATTR_ENTRYUUID);
+    rec->chg_dn = sync_index_get_value(cl_entry, CL_ATTR_ENTRYDN);
+    rec->chg_newsuperior = sync_index_get_value(cl_entry, CL_ATTR_NEWSUPERIOR);
+
+    return (0);
+}
+
+static int
+sync_index_cmp_record(const void *a, const void *b)
+{
+    const Sync_ChangeRecord *ra = (const Sync_ChangeRecord *)a;
+    const Sync_ChangeRecord *rb = (const Sync_ChangeRecord *)b;
+
+    if (ra->chg_nr < rb->chg_nr) {
+        return -1;
+    }
+    return (ra->chg_nr > rb->chg_nr) ? 1 : 0;
+}
+
+/*
+ * Bring the index up to date with the retro changelog. If upto is not 0 the
+ * caller knows the last change number and the index is loaded up to it,
+ * otherwise every change above si_high is loaded. An empty index is only
+ * primed when upto is known, to bound the first load to the index size.
+ */
+static void
+sync_index_catch_up(Sync_ChangeIndex *idx, unsigned long upto)
+{
+    Slapi_PBlock *seq_pb;
+    Sync_IndexLoad load = {0};
+    unsigned long start;
+    char *filter;
+    size_t i;
+
+    PR_Lock(idx->si_load_lock);
+
+    slapi_rwlock_rdlock(idx->si_lock);
+    if (!idx->si_loaded) {
+        start = (upto > idx->si_size) ? upto - idx->si_size + 1 : 1;
+    } else {
+        start = idx->si_high + 1;
+    }
+    slapi_rwlock_unlock(idx->si_lock);
+
+    if ((upto && start > upto) || (!upto && !idx->si_loaded)) {
+        PR_Unlock(idx->si_load_lock);
+        return;
+    }
+
+    if (upto) {
+        filter = slapi_ch_smprintf("(&(changenumber>=%lu)(changenumber<=%lu))", start, upto);
+    } else {
+        filter = slapi_ch_smprintf("(changenumber>=%lu)", start);
+    }
+    seq_pb = slapi_pblock_new();
+    slapi_search_internal_set_pb(seq_pb, CL_SRCH_BASE, LDAP_SCOPE_ONE, filter,
+                                 sync_index_attrs, 0, NULL, NULL,
+                                 plugin_get_default_component_id(), 0);
+    slapi_search_internal_callback_pb(seq_pb, &load, NULL, sync_index_load_entry, NULL);
+    slapi_pblock_destroy(seq_pb);
+    slapi_ch_free_string(&filter);
+
+    /* the changelog returns the changes in id order, which is change number
+     * order, but do not rely on it */
+    if (load.sl_count > 1) {
+        qsort(load.sl_recs, load.sl_count, sizeof(Sync_ChangeRecord), sync_index_cmp_record);
+    }
+
+    slapi_rwlock_wrlock(idx->si_lock);
+    if (!idx->si_loaded) {
+        idx->si_low = start;
+        idx->si_high = start - 1;
+        idx->si_loaded = PR_TRUE;
+    }
+    for (i = 0; i < load.sl_count; i++) {
+        Sync_ChangeRecord *rec = &load.sl_recs[i];
+
+        if (rec->chg_nr <= idx->si_high) {
+            sync_change_record_done(rec);
+            continue;
+        }
+        if (rec->chg_nr != idx->si_high + 1) {
+            /* a hole: the missing changes may still show up later */
+            slapi_log_err(SLAPI_LOG_PLUGIN, SYNC_PLUGIN_SUBSYSTEM,
+                          "sync_index_catch_up - Change numbers %lu to %lu are missing, index now starts at %lu\n",
+                          idx->si_high + 1, rec->chg_nr - 1, rec->chg_nr);
+            while (idx->si_count) {
+                sync_change_record_done(SYNC_INDEX_AT(idx, 0));
+                idx->si_head = (idx->si_head + 1) % idx->si_size;
+                idx->si_count--;
+            }
+            idx->si_low = rec->chg_nr;
+        }
+        if (idx->si_count == idx->si_size) {
+            /* evict the oldest change */
+            Sync_ChangeRecord *old = SYNC_INDEX_AT(idx, 0);
+            idx->si_low = old->chg_nr + 1;
+            sync_change_record_done(old);
+            idx->si_head = (idx->si_head + 1) % idx->si_size;
+            idx->si_count--;
+        }
+        *SYNC_INDEX_AT(idx, idx->si_count) = *rec;
+        idx->si_count++;
+        idx->si_high = rec->chg_nr;
+    }
+    if (upto > idx->si_high && load.sl_count == 0 && idx->si_count == 0) {
+        /* nothing in the changelog up to upto (e.g. trimmed) */
+        idx->si_low = upto + 1;
+        idx->si_high = upto;
+    }
+    slapi_rwlock_unlock(idx->si_lock);
+
+    slapi_ch_free((void **)&load.sl_recs);
+    PR_Unlock(idx->si_load_lock);
+}
+
+int
+sync_change_index_init(size_t size)
+{
+    Sync_ChangeIndex *idx;
+
+    if (sync_index || size == 0) {
+        return (0);
+    }
+    idx = (Sync_ChangeIndex *)slapi_ch_calloc(1, sizeof(Sync_ChangeIndex));
+    if ((idx->si_lock = slapi_new_rwlock()) == NULL ||
+        (idx->si_load_lock = PR_NewLock()) == NULL) {
+        slapi_log_err(SLAPI_LOG_ERR, SYNC_PLUGIN_SUBSYSTEM,
+                      "sync_change_index_init - Cannot initialize lock structure.\n");
+        if (idx->si_lock) {
+            slapi_destroy_rwlock(idx->si_lock);
+        }
+        slapi_ch_free((void **)&idx);
+        return (-1);
+    }
+    idx->si_size = size;
+    idx->si_ring = (Sync_ChangeRecord *)slapi_ch_calloc(size, sizeof(Sync_ChangeRecord));
+    sync_index = idx;
+    slapi_log_err(SLAPI_LOG_PLUGIN, SYNC_PLUGIN_SUBSYSTEM,
+                  "sync_change_index_init - Change index holds up to %lu changes\n", (unsigned long)size);
+    return (0);
+}
+
+void
+sync_change_index_close(void)
+{
+    Sync_ChangeIndex *idx = sync_index;
+    size_t i;
+
+    if (idx == NULL) {
+        return;
+    }
+    sync_index = NULL;
+    for (i = 0; i < idx->si_count; i++) {
+        sync_change_record_done(SYNC_INDEX_AT(idx, i));
+    }
+    slapi_ch_free((void **)&idx->si_ring);
+    slapi_destroy_rwlock(idx->si_lock);
+    PR_DestroyLock(idx->si_load_lock);
+    slapi_ch_free((void **)&idx);
+}
+
+/*
+ * Call fn for every indexed change in ]from, to], in change number order.
+ * Returns -1, without calling fn, if the index does not cover the range.
+ */
+int
+sync_change_index_replay(unsigned long from, unsigned long to, sync_change_fn fn, void *arg)
+{
+    Sync_ChangeIndex *idx = sync_index;
+    size_t i;
+
+    if (idx == NULL || from >= to) {
+        return (-1);
+    }
+    sync_index_catch_up(idx, to);
+
+    slapi_rwlock_rdlock(idx->si_lock);
+    if (!idx->si_loaded || from + 1 < idx->si_low || to > idx->si_high) {
+        slapi_rwlock_unlock(idx->si_lock);
+        return (-1);
+    }
+    for (i = sync_index_find(idx, from); i < idx->si_count; i++) {
+        Sync_ChangeRecord *rec = SYNC_INDEX_AT(idx, i);
+        if (rec->chg_nr > to) {
+            break;
+        }
+        if (fn(rec, arg)) {
+            break;
+        }
+    }
+    slapi_rwlock_unlock(idx->si_lock);
+    return (0);
+}
+
+static unsigned long
+sync_index_lookup(Sync_ChangeIndex *idx, unsigned long after, const char *uniqueid, PRBool *covered)
+{
+    unsigned long chgnum = SYNC_INVALID_CHANGENUM;
+    size_t i;
+
+    slapi_rwlock_rdlock(idx->si_lock);
+    *covered = idx->si_loaded && after + 1 >= idx->si_low;
+    if (*covered) {
+        for (i = sync_index_find(idx, after); i < idx->si_count; i++) {
+            Sync_ChangeRecord *rec = SYNC_INDEX_AT(idx, i);
+            if (rec->chg_uuid && strcmp(rec->chg_uuid, uniqueid) == 0) {
+                chgnum = rec->chg_nr;
+                break;
+            }
+        }
+    }
+    slapi_rwlock_unlock(idx->si_lock);
+    return chgnum;
+}
+
+/*
+ * Change number of the first change above after on the entry uniqueid.
+ * SYNC_INVALID_CHANGENUM when the index can not tell.
+ */
+unsigned long
+sync_change_index_next_change(unsigned long after, const char *uniqueid)
+{
+    Sync_ChangeIndex *idx = sync_index;
+    unsigned long chgnum;
+    PRBool covered = PR_FALSE;
+
+    if (idx == NULL || uniqueid == NULL) {
+        return SYNC_INVALID_CHANGENUM;
+    }
+    chgnum = sync_index_lookup(idx, after, uniqueid, &covered);
+    if (chgnum == SYNC_INVALID_CHANGENUM && covered) {
+        /* the change may not be loaded yet, every client waiting on the
+         * same change finds it once one of them loaded it */
+        sync_index_catch_up(idx, 0);
+        chgnum = sync_index_lookup(idx, after, uniqueid, &covered);
+    }
+    return chgnum;
+}
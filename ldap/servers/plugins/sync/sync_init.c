@@ -194,6 +194,7 @@ sync_start(Slapi_PBlock *pb)
     char **argv;
     Slapi_Entry *e = NULL;
     PRBool allow_openldap_compat = PR_FALSE;
+    int index_size = SYNC_DEFAULT_CHANGE_INDEX_SIZE;
 
     slapi_register_supported_control(LDAP_CONTROL_SYNC,
                                      SLAPI_OPERATION_SEARCH);
@@ -222,6 +223,20 @@ sync_start(Slapi_PBlock *pb)
 
     sync_register_allow_openldap_compat(allow_openldap_compat);
 
+    if (e) {
+        /* Number of recent changes kept in memory for refresh, 0 disables the index */
+        const char *value = slapi_entry_attr_get_ref(e, SYNC_CFG_CHANGE_INDEX_SIZE);
+        if (value) {
+            index_size = sync_number2int((char *)value);
+            if (index_size < 0) {
+                slapi_log_err(SLAPI_LOG_ERR, SYNC_PLUGIN_SUBSYSTEM,
+                              "sync_start - Invalid %s value \"%s\", using default %d\n",
+                              SYNC_CFG_CHANGE_INDEX_SIZE, value, SYNC_DEFAULT_CHANGE_INDEX_SIZE);
+                index_size = SYNC_DEFAULT_CHANGE_INDEX_SIZE;
+            }
+        }
+    }
+
     if (slapi_pblock_get(pb, SLAPI_PLUGIN_ARGC, &argc) != 0 ||
         slapi_pblock_get(pb, SLAPI_PLUGIN_ARGV, &argv) != 0) {
         slapi_log_err(SLAPI_LOG_ERR, SYNC_PLUGIN_SUBSYSTEM,
@@ -235,6 +250,7 @@ sync_start(Slapi_PBlock *pb)
      */
     PR_NewThreadPrivateIndex(&thread_primary_op, sync_thread_primary_op_destructor);
     sync_persist_initialize(argc, argv, e);
+    sync_change_index_init((size_t)index_size);
 
     return (0);
 }
@@ -248,6 +264,7 @@ static int
 sync_close(Slapi_PBlock *pb __attribute__((unused)))
 {
     sync_persist_terminate_all();
+    sync_change_index_close();
     sync_unregister_operation_entension();
 
     return (0);
@@ -36,7 +36,10 @@ static SyncRequest *sync_request_alloc(void);
 void sync_queue_change(OPERATION_PL_CTX_T *operation);
 static void sync_send_results(void *arg);
 static void sync_request_wakeup_all(void);
+static void sync_request_wakeup(SyncRequest *req);
 static void sync_node_free(SyncQueueNode **node);
+static SyncSharedEntry *sync_shared_entry_new(Slapi_Entry *e);
+static void sync_shared_entry_release(SyncSharedEntry **sharedp);
 
 static int sync_acquire_connection(Slapi_Connection *conn);
 static int sync_release_connection(Slapi_PBlock *pb, Slapi_Connection *conn, Slapi_Operation *op, int release);
@@ -99,6 +102,7 @@ sync_request_free(SyncRequest **reqp)
     if (req->req_lock) {
         PR_DestroyLock(req->req_lock);
         req->req_lock = NULL;
+        pthread_cond_destroy(&req->req_cvar);
     }
 
     slapi_ch_free((void **)reqp);
@@ -508,6 +512,8 @@ sync_queue_change(OPERATION_PL_CTX_T *operation)
 {
     SyncRequest *req = NULL;
     SyncQueueNode *node = NULL;
+    SyncSharedEntry *shared_e = NULL;
+    SyncSharedEntry *shared_eprev = NULL;
     int matched = 0;
     int prev_match = 0;
     int cur_match = 0;
@@ -587,12 +593,21 @@ sync_queue_change(OPERATION_PL_CTX_T *operation)
             } else {
                 node->sync_chgtype = chgtype;
             }
+            /* The entry is copied once for all the matching requests */
             if (node->sync_chgtype == LDAP_REQ_DELETE && chgtype == LDAP_REQ_MODIFY) {
                 /* use previous entry to pass the filter test in sync_send_results */
-                node->sync_entry = slapi_entry_dup(eprev);
+                if (shared_eprev == NULL) {
+                    shared_eprev = sync_shared_entry_new(eprev);
+                }
+                node->sync_shared = shared_eprev;
             } else {
-                node->sync_entry = slapi_entry_dup(e);
+                if (shared_e == NULL) {
+                    shared_e = sync_shared_entry_new(e);
+                }
+                node->sync_shared = shared_e;
             }
+            slapi_atomic_incr_64(&node->sync_shared->se_refcnt, __ATOMIC_RELAXED);
+            node->sync_entry = node->sync_shared->se_entry;
             /* Put it on the end of the list for this sync search */
             PR_Lock(req->req_lock);
             /* check if the queue max size is reached */
@@ -614,6 +629,9 @@ sync_queue_change(OPERATION_PL_CTX_T *operation)
                                                               "\"%s\" \n",
                       slapi_entry_get_dn_const(node->sync_entry));
             PR_Unlock(req->req_lock);
+
+            /* Only wake up the requests that have something to send */
+            sync_request_wakeup(req);
         }
     }
     /* Were there any matches? */
@@ -628,11 +646,9 @@ sync_queue_change(OPERATION_PL_CTX_T *operation)
     }
     SYNC_UNLOCK_READ();
 
-    /* Were there any matches? */
-    if (matched) {
-        /* Notify update threads */
-        sync_request_wakeup_all();
-    }
+    /* drop the references taken while queuing */
+    sync_shared_entry_release(&shared_e);
+    sync_shared_entry_release(&shared_eprev);
 }
 /*
  * Initialize the list structure which contains the list
@@ -642,7 +658,6 @@ int
 sync_persist_initialize(int argc, char **argv, Slapi_Entry *config_entry)
 {
     if (!SYNC_IS_INITIALIZED()) {
-        pthread_condattr_t sync_req_condAttr; /* cond var attribute */
         int rc = 0;
 
         sync_request_list = (SyncRequestList *)slapi_ch_calloc(1, sizeof(SyncRequestList));
@@ -656,25 +671,18 @@ sync_persist_initialize(int argc, char **argv, Slapi_Entry *config_entry)
                           rc, strerror(rc));
             return (-1);
         }
-        if ((rc = pthread_condattr_init(&sync_req_condAttr)) != 0) {
+        if ((rc = pthread_condattr_init(&(sync_request_list->sync_req_condattr))) != 0) {
             slapi_log_err(SLAPI_LOG_ERR, "sync_persist_initialize",
                           "Failed to create new condition attribute variable. error %d (%s)\n",
                           rc, strerror(rc));
             return (-1);
         }
-        if ((rc = pthread_condattr_setclock(&sync_req_condAttr, CLOCK_MONOTONIC)) != 0) {
+        if ((rc = pthread_condattr_setclock(&(sync_request_list->sync_req_condattr), CLOCK_MONOTONIC)) != 0) {
             slapi_log_err(SLAPI_LOG_ERR, "sync_persist_initialize",
                           "Cannot set condition attr clock. error %d (%s)\n",
                           rc, strerror(rc));
             return (-1);
         }
-        if ((rc = pthread_cond_init(&(sync_request_list->sync_req_cvar), &sync_req_condAttr)) != 0) {
-            slapi_log_err(SLAPI_LOG_ERR, "sync_persist_initialize",
-                          "Failed to create new condition variable. error %d (%s)\n",
-                          rc, strerror(rc));
-            return (-1);
-        }
-        pthread_condattr_destroy(&sync_req_condAttr); /* no longer needed */
 
         sync_request_list->sync_req_head = NULL;
         sync_request_list->sync_req_cur_persist = 0;
@@ -847,7 +855,7 @@ sync_persist_terminate_all()
 
         slapi_destroy_rwlock(sync_request_list->sync_req_rwlock);
         pthread_mutex_destroy(&(sync_request_list->sync_req_cvarlock));
-		pthread_cond_destroy(&(sync_request_list->sync_req_cvar));
+        pthread_condattr_destroy(&(sync_request_list->sync_req_condattr));
 
         /* it frees the structures, just in case it remained connected sync_repl client */
         for (req = sync_request_list->sync_req_head; NULL != req; req = next) {
@@ -876,6 +884,12 @@ sync_request_alloc(void)
         slapi_ch_free((void **)&req);
         return (NULL);
     }
+    if (pthread_cond_init(&req->req_cvar, &(sync_request_list->sync_req_condattr)) != 0) {
+        slapi_log_err(SLAPI_LOG_ERR, SYNC_PLUGIN_SUBSYSTEM, "sync_request_alloc - Cannot initialize condition variable.\n");
+        PR_DestroyLock(req->req_lock);
+        slapi_ch_free((void **)&req);
+        return (NULL);
+    }
     req->req_tid = (PRThread *)NULL;
     req->req_complete = 0;
     req->req_cookie = NULL;
@@ -950,13 +964,25 @@ sync_remove_request(SyncRequest *req)
     }
 }
 
+static void
+sync_request_wakeup(SyncRequest *req)
+{
+    pthread_mutex_lock(&(sync_request_list->sync_req_cvarlock));
+    pthread_cond_signal(&req->req_cvar);
+    pthread_mutex_unlock(&(sync_request_list->sync_req_cvarlock));
+}
+
 static void
 sync_request_wakeup_all(void)
 {
+    SyncRequest *req;
+
     if (SYNC_IS_INITIALIZED()) {
-        pthread_mutex_lock(&(sync_request_list->sync_req_cvarlock));
-        pthread_cond_broadcast(&(sync_request_list->sync_req_cvar));
-        pthread_mutex_unlock(&(sync_request_list->sync_req_cvarlock));
+        SYNC_LOCK_READ();
+        for (req = sync_request_list->sync_req_head; NULL != req; req = req->req_next) {
+            sync_request_wakeup(req);
+        }
+        SYNC_UNLOCK_READ();
     }
 }
 
@@ -1064,7 +1090,7 @@ sync_send_results(void *arg)
             struct timespec current_time = {0};
             clock_gettime(CLOCK_MONOTONIC, &current_time);
             current_time.tv_sec += 1;
-            pthread_cond_timedwait(&(sync_request_list->sync_req_cvar),
+            pthread_cond_timedwait(&req->req_cvar,
                                    &(sync_request_list->sync_req_cvarlock),
                                    &current_time);
         } else {
@@ -1171,10 +1197,37 @@ static void
 sync_node_free(SyncQueueNode **node)
 {
     if (node != NULL && *node != NULL) {
-        if ((*node)->sync_entry != NULL) {
-            slapi_entry_free((*node)->sync_entry);
-            (*node)->sync_entry = NULL;
-        }
+        (*node)->sync_entry = NULL;
+        sync_shared_entry_release(&(*node)->sync_shared);
         slapi_ch_free((void **)node);
     }
 }
+
+/*
+ * Copy of a changed entry, shared by the queues of all the requests
+ * it matched. The caller owns the first reference.
+ */
+static SyncSharedEntry *
+sync_shared_entry_new(Slapi_Entry *e)
+{
+    SyncSharedEntry *shared = (SyncSharedEntry *)slapi_ch_calloc(1, sizeof(SyncSharedEntry));
+
+    shared->se_entry = slapi_entry_dup(e);
+    shared->se_refcnt = 1;
+    return shared;
+}
+
+static void
+sync_shared_entry_release(SyncSharedEntry **sharedp)
+{
+    SyncSharedEntry *shared = *sharedp;
+
+    if (shared == NULL) {
+        return;
+    }
+    *sharedp = NULL;
+    if (slapi_atomic_decr_64(&shared->se_refcnt, __ATOMIC_ACQ_REL) == 0) {
+        slapi_entry_free(shared->se_entry);
+        slapi_ch_free((void **)&shared);
+    }
+}
@@ -16,9 +16,10 @@ static PRBool allow_openldap_compat;
 
 static SyncOpInfo *sync_get_operation_extension(Slapi_PBlock *pb);
 static void sync_set_operation_extension(Slapi_PBlock *pb, SyncOpInfo *spec);
-static int sync_find_ref_by_uuid(Sync_UpdateNode *updates, int stop, char *uniqueid);
+static int sync_find_ref_by_uuid(Sync_CallBackData *cb, const char *uniqueid);
 static void sync_free_update_nodes(Sync_UpdateNode **updates, int count);
-Slapi_Entry *sync_deleted_entry_from_changelog(Slapi_Entry *cl_entry);
+static Slapi_Entry *sync_deleted_entry(const char *entrydn, const char *uniqueid);
+static int sync_refresh_add_change(Sync_ChangeRecord *rec, void *cb_data);
 static int sync_feature_allowed(Slapi_PBlock *pb);
 
 static int
@@ -329,7 +330,7 @@ sync_refresh_update_content(Slapi_PBlock *pb, Sync_Cookie *client_cookie, Sync_C
 {
     Slapi_PBlock *seq_pb;
     char *filter;
-    Sync_CallBackData cb_data;
+    Sync_CallBackData cb_data = {0};
     int rc = LDAP_SUCCESS;
     PR_ASSERT(client_cookie);
 
@@ -347,14 +348,22 @@ sync_refresh_update_content(Slapi_PBlock *pb, Sync_Cookie *client_cookie, Sync_C
     PR_ASSERT(chg_count > 0);
 
     cb_data.cb_updates = (Sync_UpdateNode *)slapi_ch_calloc(chg_count, sizeof(Sync_UpdateNode));
-
-    seq_pb = slapi_pblock_new();
-    slapi_pblock_init(seq_pb);
+    cb_data.cb_uuid_ht = PL_NewHashTable(0, PL_HashString, PL_CompareStrings, PL_CompareValues, NULL, NULL);
 
     cb_data.orig_pb = pb;
     cb_data.change_start = client_cookie->cookie_change_info;
     cb_data.openldap_compat = server_cookie->openldap_compat;
 
+    /*
+     * The shared change index holds the recent changes. Most refreshes
+     * are served from it, only old cookies need to search the changelog.
+     */
+    if (sync_change_index_replay(client_cookie->cookie_change_info,
+                                 server_cookie->cookie_change_info,
+                                 sync_refresh_add_change, &cb_data) == 0) {
+        goto send;
+    }
+
     /*
      * The client has already seen up to AND including change_info, so this should
      * should reflect that. originally was:
@@ -372,6 +381,8 @@ sync_refresh_update_content(Slapi_PBlock *pb, Sync_Cookie *client_cookie, Sync_C
      * for me in the tests, but the sync repl tests now correctly work and reflect the behaviour
      * expected.
      */
+    seq_pb = slapi_pblock_new();
+    slapi_pblock_init(seq_pb);
     if (server_cookie->openldap_compat) {
         /* In openldap compat we only want items that have an entryuuid, else we can't sync them */
         filter = slapi_ch_smprintf("(&(changenumber>=%lu)(changenumber<=%lu)(" CL_ATTR_ENTRYUUID "=*))",
@@ -396,15 +407,17 @@ sync_refresh_update_content(Slapi_PBlock *pb, Sync_Cookie *client_cookie, Sync_C
     rc = slapi_search_internal_callback_pb(
         seq_pb, &cb_data, NULL, sync_read_entry_from_changelog, NULL);
     slapi_pblock_destroy(seq_pb);
+    slapi_ch_free((void **)&filter);
 
+send:
     /* Now send the deleted entries in a sync info message
      * and the modified entries as single entries
      */
     sync_send_deleted_entries(pb, cb_data.cb_updates, chg_count, server_cookie);
     sync_send_modified_entries(pb, cb_data.cb_updates, chg_count, server_cookie);
 
+    PL_HashTableDestroy(cb_data.cb_uuid_ht);
     sync_free_update_nodes(&cb_data.cb_updates, chg_count);
-    slapi_ch_free((void **)&filter);
     return (rc);
 }
 
@@ -464,25 +477,6 @@ sync_refresh_initial_content(Slapi_PBlock *pb, int sync_persist, PRThread *tid,
     return (0);
 }
 
-static int
-sync_str2chgreq(char *chgtype)
-{
-    if (chgtype == NULL) {
-        return (-1);
-    }
-    if (strcasecmp(chgtype, "add") == 0) {
-        return (LDAP_REQ_ADD);
-    } else if (strcasecmp(chgtype, "modify") == 0) {
-        return (LDAP_REQ_MODIFY);
-    } else if (strcasecmp(chgtype, "modrdn") == 0) {
-        return (LDAP_REQ_MODRDN);
-    } else if (strcasecmp(chgtype, "delete") == 0) {
-        return (LDAP_REQ_DELETE);
-    } else {
-        return (-1);
-    }
-}
-
 static char *
 sync_get_attr_value_from_entry(Slapi_Entry *cl_entry, char *attrtype)
 {
@@ -507,18 +501,37 @@ sync_get_attr_value_from_entry(Slapi_Entry *cl_entry, char *attrtype)
     return (strvalue);
 }
 
+/*
+ * Slot of the pending update for uniqueid, -1 if there is none.
+ * The table maps a uniqueid to the first slot holding it, it is kept in
+ * sync with the slots by sync_set_ref_by_uuid/sync_clear_ref_by_uuid.
+ */
 static int
-sync_find_ref_by_uuid(Sync_UpdateNode *updates, int stop, char *uniqueid)
+sync_find_ref_by_uuid(Sync_CallBackData *cb, const char *uniqueid)
 {
-    int rc = -1;
-    int i;
-    for (i = 0; i < stop; i++) {
-        if (updates[i].upd_uuid && (0 == strcmp(uniqueid, updates[i].upd_uuid))) {
-            rc = i;
-            break;
-        }
+    void *slot = PL_HashTableLookupConst(cb->cb_uuid_ht, uniqueid);
+
+    return slot ? (int)((uintptr_t)slot - 1) : -1;
+}
+
+static void
+sync_set_ref_by_uuid(Sync_CallBackData *cb, int index)
+{
+    const char *uniqueid = cb->cb_updates[index].upd_uuid;
+
+    if (PL_HashTableLookupConst(cb->cb_uuid_ht, uniqueid) == NULL) {
+        /* the key is owned by the slot */
+        PL_HashTableAdd(cb->cb_uuid_ht, uniqueid, (void *)((uintptr_t)index + 1));
     }
-    return (rc);
+}
+
+static void
+sync_clear_ref_by_uuid(Sync_CallBackData *cb, int index)
+{
+    PL_HashTableRemove(cb->cb_uuid_ht, cb->cb_updates[index].upd_uuid);
+    slapi_ch_free_string(&cb->cb_updates[index].upd_uuid);
+    slapi_ch_free_string(&cb->cb_updates[index].upd_euuid);
+    cb->cb_updates[index].upd_chgtype = 0;
 }
 
 static int
@@ -535,24 +548,18 @@ sync_is_entry_in_scope(Slapi_PBlock *pb, Slapi_Entry *db_entry)
     }
 }
 
-Slapi_Entry *
-sync_deleted_entry_from_changelog(Slapi_Entry *cl_entry)
+static Slapi_Entry *
+sync_deleted_entry(const char *entrydn, const char *uniqueid)
 {
     Slapi_Entry *db_entry = NULL;
-    char *entrydn = NULL;
-    char *uniqueid = NULL;
-
-    entrydn = sync_get_attr_value_from_entry(cl_entry, CL_ATTR_ENTRYDN);
-    uniqueid = sync_get_attr_value_from_entry(cl_entry, CL_ATTR_UNIQUEID);
 
     /* when the Retro CL can provide the deleted entry
      * the entry will be taken from th RCL.
      * For now. just create an entry to holde the nsuniqueid
      */
     db_entry = slapi_entry_alloc();
-    slapi_entry_init(db_entry, entrydn, NULL);
+    slapi_entry_init(db_entry, slapi_ch_strdup(entrydn), NULL);
     slapi_entry_add_string(db_entry, "nsuniqueid", uniqueid);
-    slapi_ch_free((void **)&uniqueid);
 
     return (db_entry);
 }
@@ -560,22 +567,56 @@ sync_deleted_entry_from_changelog(Slapi_Entry *cl_entry)
 int
 sync_read_entry_from_changelog(Slapi_Entry *cl_entry, void *cb_data)
 {
-    char *uniqueid = NULL;
-    char *entryuuid = NULL;
+    Sync_ChangeRecord rec = {0};
     char *chgtype = NULL;
     char *chgnr = NULL;
-    int chg_req;
+    int rc;
+
+    chgnr = sync_get_attr_value_from_entry(cl_entry, CL_ATTR_CHANGENUMBER);
+    rec.chg_nr = sync_number2ulong(chgnr);
+    if (SYNC_INVALID_CHANGENUM == rec.chg_nr) {
+        slapi_log_err(SLAPI_LOG_ERR, SYNC_PLUGIN_SUBSYSTEM,
+                      "sync_read_entry_from_changelog - Change number provided by Retro Changelog is invalid: %s\n", chgnr);
+        slapi_ch_free_string(&chgnr);
+        return (1);
+    }
+    chgtype = sync_get_attr_value_from_entry(cl_entry, CL_ATTR_CHGTYPE);
+    rec.chg_req = sync_str2chgreq(chgtype);
+    rec.chg_uuid = sync_get_attr_value_from_entry(cl_entry, CL_ATTR_UNIQUEID);
+    rec.chg_euuid = sync_get_attr_value_from_entry(cl_entry, CL_ATTR_ENTRYUUID);
+    rec.chg_dn = sync_get_attr_value_from_entry(cl_entry, CL_ATTR_ENTRYDN);
+    rec.chg_newsuperior = sync_get_attr_value_from_entry(cl_entry, CL_ATTR_NEWSUPERIOR);
+
+    rc = sync_refresh_add_change(&rec, cb_data);
+
+    slapi_ch_free_string(&rec.chg_uuid);
+    slapi_ch_free_string(&rec.chg_euuid);
+    slapi_ch_free_string(&rec.chg_dn);
+    slapi_ch_free_string(&rec.chg_newsuperior);
+    slapi_ch_free_string(&chgtype);
+    slapi_ch_free_string(&chgnr);
+
+    return (rc);
+}
+
+/*
+ * Merge one changelog record into the list of updates to send.
+ * The record is not modified, the update nodes get their own copies.
+ */
+static int
+sync_refresh_add_change(Sync_ChangeRecord *rec, void *cb_data)
+{
+    char *uniqueid = NULL;
+    char *entryuuid = NULL;
     int prev = 0;
     int index = 0;
-    unsigned long chgnum = 0;
     Sync_CallBackData *cb = (Sync_CallBackData *)cb_data;
 
     if (cb == NULL) {
         return (1);
     }
 
-    uniqueid = sync_get_attr_value_from_entry(cl_entry, CL_ATTR_UNIQUEID);
-    if (uniqueid == NULL) {
+    if (rec->chg_uuid == NULL) {
         slapi_log_err(SLAPI_LOG_ERR, SYNC_PLUGIN_SUBSYSTEM,
                       "sync_read_entry_from_changelog - Retro Changelog does not provide nsuniquedid."
                       "Check 'cn=Retro Changelog Plugin,cn=plugins,cn=config' contains 'nsslapd-attribute: nsuniqueid:targetUniqueId'\n");
@@ -583,93 +624,76 @@ sync_read_entry_from_changelog(Slapi_Entry *cl_entry, void *cb_data)
     }
 
     /* If we were requested to do openldap mode, get the targetEntryUuid too */
-    if (cb->openldap_compat == PR_TRUE) {
-        entryuuid = sync_get_attr_value_from_entry(cl_entry, CL_ATTR_ENTRYUUID);
-        if (entryuuid == NULL) {
-            slapi_log_err(SLAPI_LOG_ERR, SYNC_PLUGIN_SUBSYSTEM,
-                          "sync_read_entry_from_changelog - Retro Changelog does not provide entryuuid."
-                          "Check 'cn=Retro Changelog Plugin,cn=plugins,cn=config' contains 'nsslapd-attribute: entryuuid:targetEntryUUID'\n");
-            return (1);
-        }
+    if (cb->openldap_compat == PR_TRUE && rec->chg_euuid == NULL) {
+        /* changes without entryuuid can't be synced, the changelog
+         * search filters them out, so skip them quietly when they
+         * come from the change index */
+        slapi_log_err(SLAPI_LOG_PLUGIN, SYNC_PLUGIN_SUBSYSTEM,
+                      "sync_read_entry_from_changelog - Change %lu has no entryuuid, skipped\n", rec->chg_nr);
+        return (0);
     }
 
-    chgnr = sync_get_attr_value_from_entry(cl_entry, CL_ATTR_CHANGENUMBER);
-    chgnum = sync_number2ulong(chgnr);
-    if (SYNC_INVALID_CHANGENUM == chgnum) {
-        slapi_log_err(SLAPI_LOG_ERR, SYNC_PLUGIN_SUBSYSTEM,
-                      "sync_read_entry_from_changelog - Change number provided by Retro Changelog is invalid: %s\n", chgnr);
-        slapi_ch_free_string(&chgnr);
-        slapi_ch_free_string(&uniqueid);
-        slapi_ch_free_string(&entryuuid);
-        return (1);
-    }
-    if (chgnum < cb->change_start) {
+    if (rec->chg_nr < cb->change_start) {
         slapi_log_err(SLAPI_LOG_ERR, SYNC_PLUGIN_SUBSYSTEM,
                       "sync_read_entry_from_changelog - "
-                      "Change number provided by Retro Changelog %s is less than the initial number %lu\n",
-                      chgnr, cb->change_start);
-        slapi_ch_free_string(&chgnr);
-        slapi_ch_free_string(&uniqueid);
-        slapi_ch_free_string(&entryuuid);
+                      "Change number provided by Retro Changelog %lu is less than the initial number %lu\n",
+                      rec->chg_nr, cb->change_start);
         return (1);
     }
-    index = chgnum - cb->change_start;
-    chgtype = sync_get_attr_value_from_entry(cl_entry, CL_ATTR_CHGTYPE);
-    chg_req = sync_str2chgreq(chgtype);
-    switch (chg_req) {
+    index = rec->chg_nr - cb->change_start;
+    uniqueid = slapi_ch_strdup(rec->chg_uuid);
+    if (cb->openldap_compat == PR_TRUE) {
+        entryuuid = slapi_ch_strdup(rec->chg_euuid);
+    }
+    switch (rec->chg_req) {
     case LDAP_REQ_ADD:
         slapi_log_err(SLAPI_LOG_PLUGIN, SYNC_PLUGIN_SUBSYSTEM, "sync_read_entry_from_changelog - %s LDAP_REQ_ADD\n", uniqueid);
         /* nsuniqueid cannot exist, just add reference */
         cb->cb_updates[index].upd_chgtype = LDAP_REQ_ADD;
         cb->cb_updates[index].upd_uuid = uniqueid;
         cb->cb_updates[index].upd_euuid = entryuuid;
+        sync_set_ref_by_uuid(cb, index);
         break;
     case LDAP_REQ_MODIFY:
         /* check if we have seen this uuid already */
-        prev = sync_find_ref_by_uuid(cb->cb_updates, index, uniqueid);
+        prev = sync_find_ref_by_uuid(cb, uniqueid);
         if (prev == -1) {
             slapi_log_err(SLAPI_LOG_PLUGIN, SYNC_PLUGIN_SUBSYSTEM, "sync_read_entry_from_changelog - %s LDAP_REQ_MODIFY\n", uniqueid);
             cb->cb_updates[index].upd_chgtype = LDAP_REQ_MODIFY;
             cb->cb_updates[index].upd_uuid = uniqueid;
             cb->cb_updates[index].upd_euuid = entryuuid;
+            sync_set_ref_by_uuid(cb, index);
         } else {
             /* was add or mod, keep it */
             slapi_log_err(SLAPI_LOG_PLUGIN, SYNC_PLUGIN_SUBSYSTEM, "sync_read_entry_from_changelog - %s LDAP_REQ_MODIFY (already queued)\n", uniqueid);
-            cb->cb_updates[index].upd_uuid = NULL;
-            cb->cb_updates[index].upd_euuid = NULL;
-            cb->cb_updates[index].upd_chgtype = 0;
             slapi_ch_free_string(&uniqueid);
             slapi_ch_free_string(&entryuuid);
         }
         break;
     case LDAP_REQ_MODRDN: {
         /* if it is a modrdn, we finally need to decide if this will
-                 * trigger a present or delete state, keep the info that
-                 * the entry was subject to a modrdn
-                 */
+         * trigger a present or delete state, keep the info that
+         * the entry was subject to a modrdn
+         */
         int new_scope = 0;
         int old_scope = 0;
         Slapi_DN *original_dn;
-        char *newsuperior = sync_get_attr_value_from_entry(cl_entry, CL_ATTR_NEWSUPERIOR);
-        char *entrydn = sync_get_attr_value_from_entry(cl_entry, CL_ATTR_ENTRYDN);
         /* if newsuperior is set we need to checkif the entry has been moved into
-             * or moved out of the scope of the synchronization request
-             */
-        original_dn = slapi_sdn_new_dn_byref(entrydn);
+         * or moved out of the scope of the synchronization request
+         */
+        original_dn = slapi_sdn_new_dn_byref(rec->chg_dn);
         old_scope = sync_is_active_scope(original_dn, cb->orig_pb);
         slapi_sdn_free(&original_dn);
-        slapi_ch_free_string(&entrydn);
-        if (newsuperior) {
+        if (rec->chg_newsuperior) {
             Slapi_DN *newbase;
-            newbase = slapi_sdn_new_dn_byref(newsuperior);
+            newbase = slapi_sdn_new_dn_byref(rec->chg_newsuperior);
             new_scope = sync_is_active_scope(newbase, cb->orig_pb);
-            slapi_ch_free_string(&newsuperior);
             slapi_sdn_free(&newbase);
         } else {
             /* scope didn't change */
             new_scope = old_scope;
         }
-        prev = sync_find_ref_by_uuid(cb->cb_updates, index, uniqueid);
+        prev = sync_find_ref_by_uuid(cb, uniqueid);
         if (old_scope && new_scope) {
             /* nothing changed, it's just a MOD */
             if (prev == -1) {
@@ -677,11 +701,9 @@ sync_read_entry_from_changelog(Slapi_Entry *cl_entry, void *cb_data)
                 cb->cb_updates[index].upd_chgtype = LDAP_REQ_MODIFY;
                 cb->cb_updates[index].upd_uuid = uniqueid;
                 cb->cb_updates[index].upd_euuid = entryuuid;
+                sync_set_ref_by_uuid(cb, index);
             } else {
                 slapi_log_err(SLAPI_LOG_PLUGIN, SYNC_PLUGIN_SUBSYSTEM, "sync_read_entry_from_changelog - %s LDAP_REQ_MODRDN (already queued)\n", uniqueid);
-                cb->cb_updates[index].upd_uuid = NULL;
-                cb->cb_updates[index].upd_euuid = NULL;
-                cb->cb_updates[index].upd_chgtype = 0;
                 slapi_ch_free_string(&uniqueid);
                 slapi_ch_free_string(&entryuuid);
             }
@@ -692,11 +714,13 @@ sync_read_entry_from_changelog(Slapi_Entry *cl_entry, void *cb_data)
                 cb->cb_updates[index].upd_chgtype = LDAP_REQ_DELETE;
                 cb->cb_updates[index].upd_uuid = uniqueid;
                 cb->cb_updates[index].upd_euuid = entryuuid;
-                cb->cb_updates[index].upd_e = sync_deleted_entry_from_changelog(cl_entry);
+                cb->cb_updates[index].upd_e = sync_deleted_entry(rec->chg_dn, uniqueid);
+                sync_set_ref_by_uuid(cb, index);
             } else {
                 slapi_log_err(SLAPI_LOG_PLUGIN, SYNC_PLUGIN_SUBSYSTEM, "sync_read_entry_from_changelog - %s LDAP_REQ_MODRDN -> LDAP_REQ_DELETE (already queued)\n", uniqueid);
                 cb->cb_updates[prev].upd_chgtype = LDAP_REQ_DELETE;
-                cb->cb_updates[prev].upd_e = sync_deleted_entry_from_changelog(cl_entry);
+                slapi_entry_free(cb->cb_updates[prev].upd_e);
+                cb->cb_updates[prev].upd_e = sync_deleted_entry(rec->chg_dn, uniqueid);
                 slapi_ch_free_string(&uniqueid);
                 slapi_ch_free_string(&entryuuid);
             }
@@ -706,40 +730,36 @@ sync_read_entry_from_changelog(Slapi_Entry *cl_entry, void *cb_data)
             cb->cb_updates[index].upd_chgtype = LDAP_REQ_ADD;
             cb->cb_updates[index].upd_uuid = uniqueid;
             cb->cb_updates[index].upd_euuid = entryuuid;
+            sync_set_ref_by_uuid(cb, index);
         } else {
             /* nothing to do */
             slapi_ch_free_string(&uniqueid);
             slapi_ch_free_string(&entryuuid);
         }
-        slapi_sdn_free(&original_dn);
         break;
     }
     case LDAP_REQ_DELETE:
         /* check if we have seen this uuid already */
-        prev = sync_find_ref_by_uuid(cb->cb_updates, index, uniqueid);
+        prev = sync_find_ref_by_uuid(cb, uniqueid);
         if (prev == -1) {
             slapi_log_err(SLAPI_LOG_PLUGIN, SYNC_PLUGIN_SUBSYSTEM, "sync_read_entry_from_changelog - %s LDAP_REQ_DELETE\n", uniqueid);
             cb->cb_updates[index].upd_chgtype = LDAP_REQ_DELETE;
             cb->cb_updates[index].upd_uuid = uniqueid;
             cb->cb_updates[index].upd_euuid = entryuuid;
-            cb->cb_updates[index].upd_e = sync_deleted_entry_from_changelog(cl_entry);
+            cb->cb_updates[index].upd_e = sync_deleted_entry(rec->chg_dn, uniqueid);
+            sync_set_ref_by_uuid(cb, index);
         } else {
             /* if it was added since last cookie state, we
              * can ignore it */
             if (cb->cb_updates[prev].upd_chgtype == LDAP_REQ_ADD) {
                 slapi_log_err(SLAPI_LOG_PLUGIN, SYNC_PLUGIN_SUBSYSTEM, "sync_read_entry_from_changelog - %s LDAP_REQ_DELETE -> NO-OP\n", uniqueid);
-                slapi_ch_free_string(&(cb->cb_updates[prev].upd_uuid));
-                cb->cb_updates[prev].upd_uuid = NULL;
-                cb->cb_updates[prev].upd_euuid = NULL;
-                cb->cb_updates[index].upd_uuid = NULL;
-                cb->cb_updates[index].upd_euuid = NULL;
+                sync_clear_ref_by_uuid(cb, prev);
             } else {
                 /* ignore previous mod */
                 slapi_log_err(SLAPI_LOG_PLUGIN, SYNC_PLUGIN_SUBSYSTEM, "sync_read_entry_from_changelog - %s LDAP_REQ_DELETE (already queued, updating)\n", uniqueid);
-                cb->cb_updates[index].upd_uuid = NULL;
-                cb->cb_updates[index].upd_euuid = NULL;
                 cb->cb_updates[prev].upd_chgtype = LDAP_REQ_DELETE;
-                cb->cb_updates[prev].upd_e = sync_deleted_entry_from_changelog(cl_entry);
+                slapi_entry_free(cb->cb_updates[prev].upd_e);
+                cb->cb_updates[prev].upd_e = sync_deleted_entry(rec->chg_dn, uniqueid);
             }
             slapi_ch_free_string(&uniqueid);
             slapi_ch_free_string(&entryuuid);
@@ -749,8 +769,6 @@ sync_read_entry_from_changelog(Slapi_Entry *cl_entry, void *cb_data)
         slapi_ch_free_string(&uniqueid);
         slapi_ch_free_string(&entryuuid);
     }
-    slapi_ch_free_string(&chgtype);
-    slapi_ch_free_string(&chgnr);
 
     return (0);
 }
@@ -655,6 +655,7 @@ void
 sync_cookie_update(Sync_Cookie *sc, Slapi_Entry *ec)
 {
     const char *uniqueid = NULL;
+    unsigned long newnr;
     Slapi_Attr *attr;
     Slapi_Value *val;
 
@@ -662,7 +663,13 @@ sync_cookie_update(Sync_Cookie *sc, Slapi_Entry *ec)
     slapi_attr_first_value(attr, &val);
     uniqueid = slapi_value_get_string(val);
 
-    sc->cookie_change_info = sync_cookie_get_change_number(sc->cookie_change_info, uniqueid);
+    /* all the persistent requests sent this entry look for the same change,
+     * the change index resolves it without a changelog search per request */
+    newnr = sync_change_index_next_change(sc->cookie_change_info, uniqueid);
+    if (newnr == SYNC_INVALID_CHANGENUM) {
+        newnr = sync_cookie_get_change_number(sc->cookie_change_info, uniqueid);
+    }
+    sc->cookie_change_info = newnr;
 }
 
 Sync_Cookie *
@@ -186,21 +186,75 @@ string_filter_approx(struct berval *bvfilter, Slapi_Value **bvals, Slapi_Value *
     return (rc);
 }
 
+/*
+ * Build the matcher of a substring assertion. The components are
+ * normalized according to the syntax, unless the filter already was.
+ */
+static Slapi_SubstrMatcher *
+string_substr_matcher_new(char *initial, char **any, char * final, int syntax, int filter_normalized)
+{
+    Slapi_SubstrMatcher *sm = NULL;
+    char *ninitial = NULL;
+    char **nany = NULL;
+    char *nfinal = NULL;
+    char *alt = NULL;
+    int i;
+
+    if (filter_normalized) {
+        return slapi_substr_matcher_new(initial, any, final, 0);
+    }
+    if (initial != NULL) {
+        /* 3rd arg: 1 - trim leading blanks */
+        ninitial = slapi_ch_strdup(initial);
+        value_normalize_ext(ninitial, syntax, 1, &alt);
+        if (alt) {
+            slapi_ch_free_string(&ninitial);
+            ninitial = alt;
+            alt = NULL;
+        }
+    }
+    for (i = 0; any && any[i]; i++) {
+        /* 3rd arg: 0 - DO NOT trim leading blanks */
+        char *nval = slapi_ch_strdup(any[i]);
+        value_normalize_ext(nval, syntax, 0, &alt);
+        if (alt) {
+            slapi_ch_free_string(&nval);
+            nval = alt;
+            alt = NULL;
+        }
+        charray_add(&nany, nval);
+    }
+    if (final != NULL) {
+        /* 3rd arg: 0 - DO NOT trim leading blanks */
+        nfinal = slapi_ch_strdup(final);
+        value_normalize_ext(nfinal, syntax, 0, &alt);
+        if (alt) {
+            slapi_ch_free_string(&nfinal);
+            nfinal = alt;
+            alt = NULL;
+        }
+    }
+    sm = slapi_substr_matcher_new(ninitial, nany, nfinal, syntax);
+    slapi_ch_free_string(&ninitial);
+    charray_free(nany);
+    slapi_ch_free_string(&nfinal);
+    return sm;
+}
+
 int
 string_filter_sub(Slapi_PBlock *pb, char *initial, char **any, char * final, Slapi_Value **bvals, int syntax)
 {
-    int i, j, rc, size = 0;
-    char *p, *end, *realval, *tmpbuf = NULL, *bigpat = NULL;
+    int j, rc;
+    char *realval, *tmpbuf = NULL;
     size_t tmpbufsize;
-    char pat[BUFSIZ];
     char buf[BUFSIZ];
     struct timespec expire_time = {0};
     Operation *op = NULL;
-    Slapi_Regex *re = NULL;
-    char *re_result = NULL;
+    Slapi_SubstrMatcher *sm = NULL;
     char *alt = NULL;
     int filter_normalized = 0;
-    int free_re = 1;
+    int free_sm = 1;
+    int key;
     struct subfilt *sf = NULL;
 
     slapi_log_err(SLAPI_LOG_TRACE, SYNTAX_PLUGIN_SUBSYSTEM, "=> string_filter_sub\n");
@@ -216,110 +270,36 @@ string_filter_sub(Slapi_PBlock *pb, char *initial, char **any, char * final, Sla
         slapi_pblock_get(pb, SLAPI_PLUGIN_SYNTAX_FILTER_NORMALIZED, &filter_normalized);
         slapi_pblock_get(pb, SLAPI_PLUGIN_SYNTAX_FILTER_DATA, &sf);
     }
+    key = filter_normalized ? 0 : syntax;
+
+    /*
+     * The matcher is built once and kept on the filter, for the next
+     * entries to test. A filter may be tested by several threads at
+     * once (acl targetfilters), the first one to set it wins.
+     * A matcher built from the components as they are (key 0) comes
+     * from a normalized filter, see ldbm_search_compile_filter().
+     */
     if (sf) {
-        re = (Slapi_Regex *)sf->sf_private;
-        if (re) {
-            free_re = 0;
+        sm = __atomic_load_n((Slapi_SubstrMatcher **)&sf->sf_private, __ATOMIC_ACQUIRE);
+        if (sm && (slapi_substr_matcher_get_key(sm) == 0 || slapi_substr_matcher_get_key(sm) == key)) {
+            free_sm = 0;
+        } else {
+            sm = NULL;
         }
     }
 
-    if (!re) {
-        /*
-         * construct a regular expression corresponding to the
-         * filter and let regex do the work for each value
-         * XXX should do this once and save it somewhere XXX
-         */
-        pat[0] = '\0';
-        p = pat;
-        end = pat + sizeof(pat) - 2; /* leave room for null */
-
-        if (initial != NULL) {
-            size = strlen(initial) + 1; /* add 1 for "^" */
-        }
-
-        if (any != NULL) {
-            i = 0;
-            while (any[i]) {
-                size += strlen(any[i++]) + 2; /* add 2 for ".*" */
-            }
-        }
-
-        if (final != NULL) {
-            size += strlen(final) + 3; /* add 3 for ".*" and "$" */
-        }
-
-        size *= 2; /* doubled in case all filter chars need escaping */
-        size++;    /* add 1 for null */
-
-        if (p + size > end) {
-            bigpat = slapi_ch_malloc(size);
-            p = bigpat;
-        }
-
-        if (initial != NULL) {
-            /* 3rd arg: 1 - trim leading blanks */
-            if (!filter_normalized) {
-                value_normalize_ext(initial, syntax, 1, &alt);
-            }
-            *p++ = '^';
-            if (alt) {
-                filter_strcpy_special_ext(p, alt, FILTER_STRCPY_ESCAPE_RECHARS);
-                slapi_ch_free_string(&alt);
-            } else {
-                filter_strcpy_special_ext(p, initial, FILTER_STRCPY_ESCAPE_RECHARS);
-            }
-            p = strchr(p, '\0');
-        }
-        if (any != NULL) {
-            for (i = 0; any[i] != NULL; i++) {
-                /* 3rd arg: 0 - DO NOT trim leading blanks */
-                if (!filter_normalized) {
-                    value_normalize_ext(any[i], syntax, 0, &alt);
-                }
-                /* ".*" + value */
-                *p++ = '.';
-                *p++ = '*';
-                if (alt) {
-                    filter_strcpy_special_ext(p, alt, FILTER_STRCPY_ESCAPE_RECHARS);
-                    slapi_ch_free_string(&alt);
-                } else {
-                    filter_strcpy_special_ext(p, any[i], FILTER_STRCPY_ESCAPE_RECHARS);
-                }
-                p = strchr(p, '\0');
+    if (!sm) {
+        sm = string_substr_matcher_new(initial, any, final, syntax, filter_normalized);
+        if (sf) {
+            Slapi_SubstrMatcher *expected = NULL;
+            if (__atomic_compare_exchange_n((Slapi_SubstrMatcher **)&sf->sf_private, &expected, sm,
+                                            0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                free_sm = 0;
             }
         }
-        if (final != NULL) {
-            /* 3rd arg: 0 - DO NOT trim leading blanks */
-            if (!filter_normalized) {
-                value_normalize_ext(final, syntax, 0, &alt);
-            }
-            /* ".*" + value */
-            *p++ = '.';
-            *p++ = '*';
-            if (alt) {
-                filter_strcpy_special_ext(p, alt, FILTER_STRCPY_ESCAPE_RECHARS);
-                slapi_ch_free_string(&alt);
-            } else {
-                filter_strcpy_special_ext(p, final, FILTER_STRCPY_ESCAPE_RECHARS);
-            }
-            strcat(p, "$");
-        }
-
-        /* compile the regex */
-        p = (bigpat) ? bigpat : pat;
-        tmpbuf = NULL;
-        re = slapi_re_comp(p, &re_result);
-        if (NULL == re) {
-            slapi_log_err(SLAPI_LOG_ERR, SYNTAX_PLUGIN_SUBSYSTEM,
-                          "string_filter_sub - re_comp (%s) failed (%s): %s\n",
-                          pat, p, re_result ? re_result : "unknown");
-            slapi_ch_free_string(&re_result);
-            rc = LDAP_OPERATIONS_ERROR;
-            goto bailout;
-        } else if (slapi_is_loglevel_set(SLAPI_LOG_TRACE)) {
-            char ebuf[BUFSIZ];
+        if (slapi_is_loglevel_set(SLAPI_LOG_TRACE)) {
             slapi_log_err(SLAPI_LOG_TRACE, SYNTAX_PLUGIN_SUBSYSTEM,
-                          "string_filter_sub - re_comp (%s)\n", escape_string(p, ebuf));
+                          "string_filter_sub - new matcher (%s)\n", free_sm ? "not cached" : "cached");
         }
     }
 
@@ -330,7 +310,7 @@ string_filter_sub(Slapi_PBlock *pb, char *initial, char **any, char * final, Sla
     }
 
     /*
-     * test the regex against each value
+     * test the matcher against each value
      */
     rc = -1;
     tmpbuf = NULL;
@@ -361,43 +341,34 @@ string_filter_sub(Slapi_PBlock *pb, char *initial, char **any, char * final, Sla
         } else if (syntax & SYNTAX_DN) {
             slapi_dn_ignore_case(realval);
         }
+        if (slapi_timespec_expire_check(&expire_time) == TIMER_EXPIRED) {
+            slapi_log_err(SLAPI_LOG_TRACE, SYNTAX_PLUGIN_SUBSYSTEM, "LDAP_TIMELIMIT_EXCEEDED\n");
+            rc = LDAP_TIMELIMIT_EXCEEDED;
+            goto bailout;
+        }
         if (alt) {
-            if (slapi_timespec_expire_check(&expire_time) == TIMER_EXPIRED) {
-                slapi_log_err(SLAPI_LOG_TRACE, SYNTAX_PLUGIN_SUBSYSTEM, "LDAP_TIMELIMIT_EXCEEDED\n");
-                rc = LDAP_TIMELIMIT_EXCEEDED;
-                goto bailout;
-            }
-            tmprc = slapi_re_exec_nt(re, alt);
+            tmprc = slapi_substr_matcher_exec(sm, alt, strlen(alt));
             slapi_ch_free_string(&alt);
         } else {
-            if (slapi_timespec_expire_check(&expire_time) == TIMER_EXPIRED) {
-                slapi_log_err(SLAPI_LOG_TRACE, SYNTAX_PLUGIN_SUBSYSTEM, "LDAP_TIMELIMIT_EXCEEDED\n");
-                rc = LDAP_TIMELIMIT_EXCEEDED;
-                goto bailout;
-            }
-            tmprc = slapi_re_exec_nt(re, realval);
+            tmprc = slapi_substr_matcher_exec(sm, realval, strlen(realval));
         }
 
         if (slapi_is_loglevel_set(SLAPI_LOG_TRACE)) {
             char ebuf[BUFSIZ];
-            slapi_log_err(SLAPI_LOG_TRACE, SYNTAX_PLUGIN_SUBSYSTEM, "re_exec (%s) %i\n",
+            slapi_log_err(SLAPI_LOG_TRACE, SYNTAX_PLUGIN_SUBSYSTEM, "substr_matcher_exec (%s) %i\n",
                           escape_string(realval, ebuf), tmprc);
         }
         if (tmprc == 1) {
             rc = 0;
             break;
-        } else if (tmprc != 0) {
-            rc = tmprc;
-            break;
         }
     }
 bailout:
-    if (free_re) {
-        slapi_re_free(re);
+    if (free_sm) {
+        slapi_substr_matcher_free(&sm);
     }
     slapi_ch_free_string(&alt);
     slapi_ch_free((void **)&tmpbuf); /* NULL is fine */
-    slapi_ch_free((void **)&bigpat); /* NULL is fine */
 
     slapi_log_err(SLAPI_LOG_TRACE, SYNTAX_PLUGIN_SUBSYSTEM, "<= string_filter_sub %d\n", rc);
     return (rc);
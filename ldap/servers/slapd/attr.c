@@ -314,6 +314,7 @@ slapi_attr_init_locking_optional(Slapi_Attr *a, const char *type, PRBool use_loc
             }
             asi = attr_syntax_get_by_name_locking_optional(basetype, use_lock, 0);
         }
+        a->a_id = asi ? asi->asi_id : 0;
         if (NULL == asi) {
             a->a_type = attr_syntax_normalize_no_lookup(type);
             /*
@@ -380,6 +381,7 @@ slapi_attr_init_nosyntax(Slapi_Attr *a, const char *type)
 {
 
     a->a_type = slapi_ch_strdup(type);
+    a->a_id = 0;
     slapi_valueset_init(&a->a_present_values);
     slapi_valueset_init(&a->a_deleted_values);
     a->a_listtofree = NULL;
@@ -394,8 +396,9 @@ slapi_attr_dup(const Slapi_Attr *attr)
 {
     Slapi_Attr *newattr = slapi_attr_new();
     slapi_attr_init(newattr, attr->a_type);
-    slapi_valueset_set_valueset(&newattr->a_deleted_values, &attr->a_deleted_values);
-    slapi_valueset_set_valueset(&newattr->a_present_values, &attr->a_present_values);
+    /* the values are copied when one of the attributes is modified */
+    valueset_share(&newattr->a_deleted_values, &attr->a_deleted_values);
+    valueset_share(&newattr->a_present_values, &attr->a_present_values);
     newattr->a_deletioncsn = csn_dup(attr->a_deletioncsn);
     return newattr;
 }
@@ -753,6 +756,10 @@ attr_value_find_wsi(Slapi_Attr *a, const struct berval *bval, Slapi_Value **valu
     PR_ASSERT(a != NULL);
     PR_ASSERT(value != NULL);
 
+    /* the caller may update the csnset of the value it finds */
+    valueset_unshare(&a->a_present_values);
+    valueset_unshare(&a->a_deleted_values);
+
     /*
      * we will first search the present values, and then, if
      * necessary, the deleted values.
@@ -796,6 +803,7 @@ slapi_attr_set_type(Slapi_Attr *a, const char *type)
     } else {
         slapi_ch_free_string(&a->a_type);
         a->a_type = slapi_ch_strdup(type);
+        a->a_id = 0;
     }
     return rc;
 }
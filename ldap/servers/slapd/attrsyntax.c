@@ -70,6 +70,16 @@ static int asi_locking = 1;
 
 static struct asyntaxinfo *default_asi = NULL;
 
+/*
+ * Attribute type names are interned: each primary name gets a small integer
+ * id, starting at 1, which is never reused nor released. The id of a name
+ * survives the deletion of the type and schema reloads, so an id can be
+ * kept in a Slapi_Attr and in the objectclass bitsets (see schema.c).
+ */
+static PLHashTable *name2id = NULL;
+static uint32_t attr_id_count = 0;
+static pthread_mutex_t name2id_lock = PTHREAD_MUTEX_INITIALIZER;
+
 static void *attr_syntax_get_plugin_by_name_with_default(const char *type);
 static void attr_syntax_delete_no_lock(struct asyntaxinfo *asip,
                                        PRBool remove_from_oid_table,
@@ -90,6 +100,57 @@ attr_syntax_get_global_at()
     return global_at;
 }
 
+/*
+ * Return the interned id of an attribute type name, allocating it if
+ * this is the first time the name is seen.
+ */
+static uint32_t
+attr_syntax_intern_id(const char *name)
+{
+    uint32_t id;
+
+    pthread_mutex_lock(&name2id_lock);
+    if (name2id == NULL) {
+        name2id = PL_NewHashTable(2047, hashNocaseString, hashNocaseCompare,
+                                  PL_CompareValues, 0, 0);
+    }
+    id = (uint32_t)(uintptr_t)PL_HashTableLookupConst(name2id, name);
+    if (id == 0) {
+        id = attr_id_count + 1;
+        PL_HashTableAdd(name2id, slapi_ch_strdup(name), (void *)(uintptr_t)id);
+        slapi_atomic_store_32((int32_t *)&attr_id_count, (int32_t)id, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&name2id_lock);
+    return id;
+}
+
+/*
+ * Number of interned attribute type ids: all the ids are lower or equal.
+ */
+uint32_t
+attr_syntax_id_count(void)
+{
+    return (uint32_t)slapi_atomic_load_32((int32_t *)&attr_id_count, __ATOMIC_ACQUIRE);
+}
+
+/*
+ * Return the interned id of a name, or 0 if no attribute type was ever
+ * defined with that primary name. Aliases are not resolved: two names have
+ * the same id only if they compare equal, ignoring case.
+ */
+uint32_t
+attr_syntax_lookup_id(const char *name)
+{
+    uint32_t id = 0;
+
+    pthread_mutex_lock(&name2id_lock);
+    if (name2id) {
+        id = (uint32_t)(uintptr_t)PL_HashTableLookupConst(name2id, name);
+    }
+    pthread_mutex_unlock(&name2id_lock);
+    return id;
+}
+
 void
 attr_syntax_read_lock(void)
 {
@@ -225,6 +286,7 @@ attr_syntax_add_by_oid(const char *oid, struct asyntaxinfo *a, PRUint32 schema_f
     if (0 != attr_syntax_init())
         return;
 
+    a->asi_id = attr_syntax_intern_id(a->asi_name);
     if (schema_flags & DSE_SCHEMA_LOCKED) {
         if (0 != attr_syntax_init_tmp())
             return;
@@ -825,6 +887,7 @@ attr_syntax_dup(struct asyntaxinfo *a)
     newas->asi_mr_ord_plugin = a->asi_mr_ord_plugin;
     newas->asi_mr_sub_plugin = a->asi_mr_sub_plugin;
     newas->asi_syntax_oid = slapi_ch_strdup(a->asi_syntax_oid);
+    newas->asi_id = a->asi_id;
     newas->asi_next = NULL;
     newas->asi_prev = NULL;
 
@@ -270,9 +270,12 @@ ldbm_back_ldbm2archive(Slapi_PBlock *pb)
     struct ldbminfo *li;
     char *rawdirectory = NULL; /* -a <directory> */
     char *directory = NULL;    /* normalized */
+    char *rawbase = NULL;      /* -b <directory> */
+    char *base = NULL;         /* normalized */
     char *dir_bak = NULL;
     int return_value = -1;
     int task_flags = 0;
+    int archive_flags = 0;
     int run_from_cmdline = 0;
     Slapi_Task *task;
     struct stat sbuf;
@@ -280,6 +283,8 @@ ldbm_back_ldbm2archive(Slapi_PBlock *pb)
 
     slapi_pblock_get(pb, SLAPI_PLUGIN_PRIVATE, &li);
     slapi_pblock_get(pb, SLAPI_SEQ_VAL, &rawdirectory);
+    slapi_pblock_get(pb, SLAPI_DB2ARCHIVE_BASE, &rawbase);
+    slapi_pblock_get(pb, SLAPI_DB2ARCHIVE_FLAGS, &archive_flags);
     slapi_pblock_get(pb, SLAPI_TASK_FLAGS, &task_flags);
     li->li_flags = run_from_cmdline = (task_flags & SLAPI_TASK_RUNNING_FROM_COMMANDLINE);
 
@@ -322,6 +327,37 @@ ldbm_back_ldbm2archive(Slapi_PBlock *pb)
     } else {
         directory = slapi_ch_strdup(rawdirectory);
     }
+    if (rawbase && *rawbase) {
+        if (!is_abspath(rawbase)) {
+            char *bakdir = config_get_bakdir();
+            base = slapi_ch_smprintf("%s/%s", bakdir, rawbase);
+            slapi_ch_free_string(&bakdir);
+        } else {
+            base = slapi_ch_strdup(rawbase);
+        }
+        /* the destination is renamed or removed below */
+        if (slapd_comp_path(directory, base) == 0) {
+            slapi_log_err(SLAPI_LOG_ERR,
+                          "ldbm_back_ldbm2archive", "An incremental backup cannot replace its base backup.\n");
+            if (task) {
+                slapi_task_log_notice(task,
+                                      "An incremental backup cannot replace its base backup.");
+            }
+            return_value = -1;
+            goto out;
+        }
+        /* the header of an incremental backup is rewritten once it is done */
+        if (archive_flags & SLAPI_DB2ARCHIVE_COMPRESS) {
+            slapi_log_err(SLAPI_LOG_ERR,
+                          "ldbm_back_ldbm2archive", "An incremental backup can not be compressed.\n");
+            if (task) {
+                slapi_task_log_notice(task,
+                                      "An incremental backup can not be compressed.");
+            }
+            return_value = -1;
+            goto out;
+        }
+    }
 
     if (stat(directory, &sbuf) == 0) {
         if (slapd_comp_path(directory, li->li_directory) == 0) {
@@ -418,7 +454,7 @@ ldbm_back_ldbm2archive(Slapi_PBlock *pb)
     }
 
     /* tell it to archive */
-    return_value = dblayer_backup(li, directory, task);
+    return_value = dblayer_backup(li, directory, base, archive_flags, task);
     if (return_value) {
         slapi_log_err(SLAPI_LOG_BACKLDBM,
                       "ldbm_back_ldbm2archive", "dblayer_backup failed (%d).\n", return_value);
@@ -494,6 +530,7 @@ out:
 
     slapi_ch_free_string(&dir_bak);
     slapi_ch_free_string(&directory);
+    slapi_ch_free_string(&base);
     return return_value;
 }
 
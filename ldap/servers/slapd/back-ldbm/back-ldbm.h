@@ -103,6 +103,7 @@ typedef unsigned short u_int16_t;
  * Starting from DS7.2
  */
 #define BE_CHANGELOG_FILE     "replication_changelog"
+#define BE_EXTVALUES_FILE     "extvalues"
 
 #define INDEX_KEY_LENGTH(lenval,lenprefix)  (lenval+lenprefix+2)
 
@@ -148,6 +149,13 @@ typedef unsigned short u_int16_t;
 #define DEFAULT_CACHE_SIZE_STR   "0"
 #define DEFAULT_CACHE_ENTRIES    -1 /* no limit */
 #define DEFAULT_CACHE_PINNED_ENTRIES_STR "0"
+#define DEFAULT_EXTVALUES_THRESHOLD_STR "0"
+#define DEFAULT_SEARCH_READAHEAD_STR "32"
+#define DEFAULT_CACHE_AUTOTUNE_INTERVAL_STR "60"
+#define DEFAULT_CACHE_WARMUP_INTERVAL_STR "600"
+#define DEFAULT_CACHE_WARMUP_THREADS_STR "2"
+#define DEFAULT_CACHE_WARMUP_RATE_STR "20000"
+#define DEFAULT_EXTVALUES_ATTRS "member uniquemember"
 #define DEFAULT_DNCACHE_SIZE     (uint64_t)16777216
 #define DEFAULT_DNCACHE_SIZE_STR "16777216"
 #define DEFAULT_DNCACHE_MAXCOUNT -1 /* no limit */
@@ -366,6 +374,9 @@ struct backentry
     char *ep_dn_hash_ndn;           /* saved NDN from tentative add, used to
                                      * remove stale hash entry if the DN was
                                      * changed in-place */
+    char **ep_extvalues;            /* types stored in the extvalues file */
+    int ep_extvalues_known;         /* ep_extvalues matches the file: the
+                                     * entry was read or written by id2entry */
 };
 
 /* From ep_type through ep_create_time MUST be identical to backcommon */
@@ -398,6 +409,7 @@ struct cache_stats
                                * microseconds needed to load an entry
                                * in the cache
                                */
+    uint64_t ghosthits;       /* misses on recently evicted entries */
 };
 
 /* for the in-core cache of entries */
@@ -415,8 +427,17 @@ struct cache
     int64_t c_config_maxentries;  /* manually configured value */
     PRLock *c_emutexalloc_mutex;
     struct cache_stats c_stats;
+    Slapi_Counter *c_hits;        /* c_stats.hits and tries: updated by */
+    Slapi_Counter *c_tries;       /* every lookup, sharded, not locked */
     struct ldbm_instance *c_inst;
     struct pinned_ctx  *c_pinned_ctx; /* Pinned entries handler context */
+    ID *c_ghosts;                 /* recently evicted IDs (cache autotuning) */
+    uint32_t c_ghostmask;         /* c_ghosts slots - 1 */
+    uint64_t c_tune_tries;        /* stats at the last autotuning sample */
+    uint64_t c_tune_hits;
+    uint64_t c_tune_ghosthits;
+    uint64_t c_tune_wss;          /* estimated working set size in bytes */
+    int64_t c_tune_delta;         /* last size change made by the autotuning */
 };
 
 #define CACHE_ADD(cache, p, a) cache_add((cache), (void *)(p), (void **)(a))
@@ -671,6 +692,15 @@ struct ldbminfo
     int li_reslimit_pagedallids_handle; /* allids aka idlistscan */
     int li_rangelookthroughlimit;
     int li_reslimit_rangelookthrough_handle;
+    int li_search_readahead; /* number of candidates read ahead by the search loop */
+    int li_cache_autotune_interval;              /* seconds between two cache rebalancings (0 = off) */
+    struct cache_autotune *li_cache_autotune;    /* online cache autotuning state */
+    int li_cache_warmup;                         /* persist the hot entry IDs, reload them at startup */
+    int li_cache_warmup_interval;                /* seconds between two snapshots (0 = at shutdown only) */
+    int li_cache_warmup_threads;                 /* loader threads per instance */
+    int li_cache_warmup_rate;                    /* entries loaded per second per instance (0 = no limit) */
+    Slapi_Eq_Context li_cache_warmup_ctx;        /* periodic snapshots */
+    PRLock *li_cache_warmup_lock;
     int li_idl_update;
     int li_old_idl_maxids;
     int li_online_import_encrypt; /* toggle attribute encryption during bdb_ldbm_back_wire_import */
@@ -812,6 +842,7 @@ typedef struct ldbm_instance
 
     dbi_db_t *inst_id2entry; /* id2entry for this instance. */
     dbi_db_t *inst_changelog; /* changelog for this instance. */
+    dbi_db_t *inst_extvalues; /* values stored out of id2entry. */
 
     perfctrs_private inst_perf_private; /* Private data for the performance counters specific to this instance */
     attrcrypt_state_private *inst_attrcrypt_state_private;
@@ -838,10 +869,15 @@ typedef struct ldbm_instance
     struct cache inst_dncache;       /* The dn cache for this instance. */
     uint32_t inst_page_count;        /* page count used for cache autotuning */
     int cache_pinned_entries;        /* Number of entries to preserve during cache eviction */
+    struct cache_warmup *inst_warmup; /* reload of the entry cache snapshot */
     char *cache_debug_pattern;       /* Entries whose dn matche this pattern are logged as INFO
                                       * when they get added/removed from entry cache
                                       */
     Slapi_Regex *cache_debug_re;     /* Compiled version of cache_debug_pattern */
+    int extvalues_threshold;         /* Number of values from which an attribute of
+                                      * extvalues_attrs is stored out of id2entry (0: never)
+                                      */
+    char **extvalues_attrs;          /* Attributes that may be stored out of id2entry */
 } ldbm_instance;
 
 /*
@@ -853,6 +889,7 @@ typedef struct _back_search_result_set
 {
     IDList *sr_candidates;        /* the search results */
     idl_iterator sr_current;      /* the current position in the search results */
+    idl_iterator sr_readahead;    /* the candidates before this position were read ahead */
     struct backentry *sr_entry;   /* the last entry returned */
     int sr_lookthroughcount;      /* how many have we examined? */
     int sr_lookthroughlimit;      /* how many can we examine? */
@@ -875,8 +912,19 @@ typedef struct _back_search_result_set
 #define BE_INDEX_TOMBSTONE     8                       /* Index entry as a tombstone */
 #define BE_INDEX_DONT_ENCRYPT 16                       /* Disable any encryption if this flag is set */
 #define BE_INDEX_EQUALITY     32                       /* (w/DEL) remove the equality index */
+#define BE_INDEX_VISIT_KEYS   64                       /* (w/ADD) only give the keys to the index_key_visitor_t */
 #define BE_INDEX_NORMALIZED SLAPI_ATTR_FLAG_NORMALIZED /* value already normalized (0x200) */
 
+/*
+ * With BE_INDEX_VISIT_KEYS, index_addordel_values_ext_sv does not update
+ * the index: each key is given to the visitor passed as buffer_handle.
+ */
+typedef struct index_key_visitor
+{
+    int (*ikv_visit)(struct index_key_visitor *ikv, struct attrinfo *ai, const dbi_val_t *key, ID id);
+    void *ikv_arg;
+} index_key_visitor_t;
+
 /* Name of attribute type used for binder-based look through limit */
 #define LDBM_LOOKTHROUGHLIMIT_AT "nsLookThroughLimit"
 /* Name of attribute type used for binder-based look through limit */
@@ -896,6 +944,7 @@ typedef struct _back_search_result_set
 #define LDBM_TOMBSTONE_NUMSUBORDINATES_STR "tombstonenumsubordinates"
 #define LDBM_PARENTID_STR                  SLAPI_ATTR_PARENTID
 #define LDBM_ENTRYID_STR                   "entryid"
+#define LDBM_EXTVALUES_STR                 "extvaluesattr"
 
 /* Name of psuedo attribute used to track default indexes */
 #define LDBM_PSEUDO_ATTR_DEFAULT ".default"
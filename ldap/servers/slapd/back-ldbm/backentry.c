@@ -33,6 +33,7 @@ backentry_free(struct backentry **bep)
         PR_DestroyMonitor(ep->ep_mutexp);
     }
     slapi_ch_free_string(&ep->ep_dn_hash_ndn);
+    charray_free(ep->ep_extvalues);
     slapi_ch_free((void **)&ep);
     *bep = NULL;
 }
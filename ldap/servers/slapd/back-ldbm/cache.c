@@ -791,6 +791,10 @@ cache_init(struct cache *cache, struct ldbm_instance *inst, uint64_t maxsize, in
     cache->c_stats.maxentries = maxentries;
     cache->c_inst = inst;
     cache->c_lruhead = cache->c_lrutail = NULL;
+    cache->c_ghosts = NULL;
+    cache->c_ghostmask = 0;
+    cache->c_hits = slapi_counter_new_sharded();
+    cache->c_tries = slapi_counter_new_sharded();
     cache_make_hashes(cache, type);
     cache->c_pinned_ctx = (struct pinned_ctx*)slapi_ch_calloc(1, sizeof (struct pinned_ctx));
 
@@ -812,6 +816,65 @@ cache_init(struct cache *cache, struct ldbm_instance *inst, uint64_t maxsize, in
 
 #define AV_WEIGHT(cache) ((cache)->c_stats.weight/NOT_0((cache)->c_stats.nehw))
 
+/* The ghost table is a direct-mapped table of the IDs recently evicted
+ * from the LRU, like the ghost lists of ARC. It is only allocated when
+ * the cache autotuning is running (see cache_autotune.c).
+ * A miss on an ID still in the table is a miss that a bigger cache would
+ * have turned into a hit.
+ * you must be holding cache->c_mutex !!
+ */
+#define CACHE_GHOST_SLOT(cache, id) ((((uint32_t)(id)) * 2654435761U) & (cache)->c_ghostmask)
+#define CACHE_GHOST_MAX_SLOTS (1U << 22)
+
+static void
+cache_ghost_add(struct cache *cache, ID id)
+{
+    if (cache->c_ghosts) {
+        cache->c_ghosts[CACHE_GHOST_SLOT(cache, id)] = id;
+    }
+}
+
+static void
+cache_ghost_miss(struct cache *cache, ID id)
+{
+    if (cache->c_ghosts) {
+        ID *slot = &cache->c_ghosts[CACHE_GHOST_SLOT(cache, id)];
+        if (*slot == id) {
+            *slot = 0;
+            cache->c_stats.ghosthits++;
+        }
+    }
+}
+
+/* (re)allocate the ghost table with about nslots slots (0 frees it) */
+void
+cache_ghost_resize(struct cache *cache, uint64_t nslots)
+{
+    ID *ghosts = NULL;
+    ID *old = NULL;
+    uint32_t size = 0;
+
+    if (nslots > 0) {
+        size = 1024;
+        while (size < nslots && size < CACHE_GHOST_MAX_SLOTS) {
+            size <<= 1;
+        }
+        ghosts = (ID *)slapi_ch_calloc(size, sizeof(ID));
+    }
+    cache_lock(cache);
+    if (cache->c_ghosts ? (size && size / 2 <= cache->c_ghostmask + 1 && cache->c_ghostmask + 1 <= 2 * size) : !size) {
+        /* Close enough: keep the history */
+        cache_unlock(cache);
+        slapi_ch_free((void **)&ghosts);
+        return;
+    }
+    old = cache->c_ghosts;
+    cache->c_ghosts = ghosts;
+    cache->c_ghostmask = size ? size - 1 : 0;
+    cache_unlock(cache);
+    slapi_ch_free((void **)&old);
+}
+
 
 /* clear out the cache to make room for new entries
  * you must be holding cache->c_mutex !!
@@ -852,6 +915,7 @@ entrycache_flush(struct cache *cache)
                           "entrycache_flush", "Unable to delete entry\n");
             break;
         }
+        cache_ghost_add(cache, e->ep_id);
         if (e == CACHE_LRU_HEAD(cache, struct backentry *)) {
             break;
         }
@@ -924,6 +988,9 @@ cache_destroy_please(struct cache *cache, int type)
 {
     erase_cache(cache, type);
     slapi_ch_free((void**)&cache->c_pinned_ctx);
+    slapi_ch_free((void **)&cache->c_ghosts);
+    slapi_counter_destroy(&cache->c_hits);
+    slapi_counter_destroy(&cache->c_tries);
     PR_DestroyMonitor(cache->c_mutex);
     PR_DestroyLock(cache->c_emutexalloc_mutex);
 }
@@ -1075,6 +1142,44 @@ cache_get_stats(struct cache *cache, struct cache_stats *stats)
     cache_lock(cache);
     *stats = cache->c_stats;
     cache_unlock(cache);
+    /* hits first: they are counted after the tries */
+    stats->hits = slapi_counter_get_value(cache->c_hits);
+    stats->tries = slapi_counter_get_value(cache->c_tries);
+}
+
+/*
+ * Return the IDs of the cached entries, the most recently used first: the
+ * entries in use or pinned, then the LRU from its head. Only the IDs are
+ * copied under the lock. The caller frees the array.
+ */
+ID *
+cache_get_ids(struct cache *cache, uint64_t *count)
+{
+    Hashtable *ht = NULL;
+    struct backcommon *e = NULL;
+    uint64_t max = 0;
+    uint64_t n = 0;
+    ID *ids = NULL;
+
+    cache_lock(cache);
+    ht = cache->c_idtable;
+    max = cache->c_stats.nentries;
+    ids = (ID *)slapi_ch_malloc((max + 1) * sizeof(ID));
+    for (u_long i = 0; ht && i < ht->size; i++) {
+        for (e = ht->slot[i]; e && n < max; e = HASH_NEXT(ht, e)) {
+            if ((e->ep_state & (ENTRY_STATE_UNAVAILABLE | ENTRY_STATE_LRU)) == 0) {
+                ids[n++] = e->ep_id;
+            }
+        }
+    }
+    for (e = cache->c_lruhead; e && n < max; e = e->ep_lrunext) {
+        if ((e->ep_state & ENTRY_STATE_UNAVAILABLE) == 0) {
+            ids[n++] = e->ep_id;
+        }
+    }
+    cache_unlock(cache);
+    *count = n;
+    return ids;
 }
 
 void
@@ -1704,10 +1809,12 @@ cache_find_dn(struct cache *cache, const char *dn, unsigned long ndnlen)
             lru_delete(cache, (void *)e);
         PR_ASSERT((e->ep_state & ENTRY_STATE_LRU) == 0);
         e->ep_refcnt++;
-        cache->c_stats.hits++;
     }
-    cache->c_stats.tries++;
     cache_unlock(cache);
+    slapi_counter_increment(cache->c_tries);
+    if (e) {
+        slapi_counter_increment(cache->c_hits);
+    }
 
     LOG("<= cache_find_dn - (%sFOUND)\n", e ? "" : "NOT ");
     return e;
@@ -1735,10 +1842,14 @@ cache_find_id(struct cache *cache, ID id)
             lru_delete(cache, (void *)e);
         PR_ASSERT((e->ep_state & ENTRY_STATE_LRU) == 0);
         e->ep_refcnt++;
-        cache->c_stats.hits++;
+    } else {
+        cache_ghost_miss(cache, id);
     }
-    cache->c_stats.tries++;
     cache_unlock(cache);
+    slapi_counter_increment(cache->c_tries);
+    if (e) {
+        slapi_counter_increment(cache->c_hits);
+    }
 
     LOG("<= cache_find_id (%sFOUND)\n", e ? "" : "NOT ");
     return e;
@@ -1766,10 +1877,12 @@ cache_find_uuid(struct cache *cache, const char *uuid)
             lru_delete(cache, (void *)e);
         PR_ASSERT((e->ep_state & ENTRY_STATE_LRU) == 0);
         e->ep_refcnt++;
-        cache->c_stats.hits++;
     }
-    cache->c_stats.tries++;
     cache_unlock(cache);
+    slapi_counter_increment(cache->c_tries);
+    if (e) {
+        slapi_counter_increment(cache->c_hits);
+    }
 
     LOG("<= cache_find_uuid (%sFOUND)\n", e ? "" : "NOT ");
     return e;
@@ -2322,10 +2435,14 @@ dncache_find_id(struct cache *cache, ID id)
             lru_delete(cache, (void *)bdn);
         PR_ASSERT((bdn->ep_state & ENTRY_STATE_LRU) == 0);
         bdn->ep_refcnt++;
-        cache->c_stats.hits++;
+    } else {
+        cache_ghost_miss(cache, id);
     }
-    cache->c_stats.tries++;
     cache_unlock(cache);
+    slapi_counter_increment(cache->c_tries);
+    if (bdn) {
+        slapi_counter_increment(cache->c_hits);
+    }
 
     LOG("<= cache_find_id (%sFOUND)\n", bdn ? "" : "NOT ");
     return bdn;
@@ -2525,6 +2642,7 @@ dncache_flush(struct cache *cache)
             slapi_log_err(SLAPI_LOG_ERR, "dncache_flush", "Unable to delete entry\n");
             break;
         }
+        cache_ghost_add(cache, dn->ep_id);
         if (dn == CACHE_LRU_HEAD(cache, struct backdn *)) {
             break;
         }
@@ -0,0 +1,430 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/* cache_autotune.c - online rebalancing of the entry and dn caches */
+
+/*
+ * The startup autotuning (dblayer_auto_tune_fn) gives each instance a slice
+ * of nsslapd-cache-autosize percent of the memory in proportion to the size
+ * of its database, then the sizes never move. When nsslapd-cache-autosize
+ * is set, this controller samples the entry and dn caches of all the
+ * instances every nsslapd-cache-autotune-interval seconds and moves the
+ * memory to the caches that would use it:
+ *
+ * - The working set of a cache is estimated with its ghost table (the IDs
+ *   it evicted recently, see cache_ghost_resize): a miss on a ghost is a
+ *   miss that more memory would have turned into a hit. A cache that is not
+ *   full and has no ghost hit needs no more than what it holds.
+ * - The caches share the budget they got at startup. When the system runs
+ *   short of available memory, the budget is lowered to give memory back to
+ *   the page cache (the lmdb map or the libdb files). The libdb cache and
+ *   the normalized dn cache cannot be resized online, so they are not part
+ *   of the budget.
+ * - A size moves by at most a quarter per interval and changes of less than
+ *   5% are ignored, so that the caches do not oscillate.
+ */
+
+#include "back-ldbm.h"
+
+#define CACHE_AUTOTUNE_MIN_TRIES 1000 /* below that a sample is not significant */
+#define CACHE_AUTOTUNE_MAX_STEP 4     /* at most size/4 per interval */
+#define CACHE_AUTOTUNE_MIN_STEP 20    /* at least size/20 */
+#define CACHE_AUTOTUNE_LOW_MEMORY 10  /* % of the memory under which the caches shrink */
+
+struct cache_autotune
+{
+    PRLock *lock;
+    Slapi_Eq_Context ctx;
+    uint64_t ncaches;          /* caches in the budget */
+    uint64_t budget;           /* memory shared by the caches */
+    uint64_t effective_budget; /* budget lowered by memory pressure */
+    uint64_t allocated;        /* sum of the cache sizes after the last run */
+    uint64_t runs;
+    uint64_t resizes;
+    char decision[256];        /* the largest change of the last run */
+};
+
+typedef struct
+{
+    Object *inst_obj;   /* reference held during the run (entry cache sample) */
+    ldbm_instance *inst;
+    struct cache *cache;
+    int type;
+    bool tuned;         /* false: fixed size, only accounted */
+    uint64_t size;      /* current max size */
+    uint64_t target;
+    uint64_t ghosthits; /* during the last interval */
+    uint64_t tries;
+    uint64_t hits;
+} cache_sample_t;
+
+static const char *
+cache_autotune_type_name(int type)
+{
+    return (type == CACHE_TYPE_ENTRY) ? "entry" : "dn";
+}
+
+/* Sample one cache and compute the size it would need */
+static void
+cache_autotune_sample(cache_sample_t *s)
+{
+    struct cache *cache = s->cache;
+    struct cache_stats st = {0};
+    uint64_t avg = 0;
+    uint64_t wss = 0;
+
+    cache_get_stats(cache, &st);
+    s->size = st.maxsize;
+    s->tries = st.tries - cache->c_tune_tries;
+    s->hits = st.hits - cache->c_tune_hits;
+    s->ghosthits = st.ghosthits - cache->c_tune_ghosthits;
+    cache->c_tune_tries = st.tries;
+    cache->c_tune_hits = st.hits;
+    cache->c_tune_ghosthits = st.ghosthits;
+
+    /* Entries limited by count are managed by the administrator */
+    s->tuned = (st.maxentries <= 0) && !(s->inst->inst_flags & INST_FLAG_BUSY);
+    if (!s->tuned) {
+        s->target = s->size;
+        return;
+    }
+
+    /* As big as the cache: the ghost hits are the hits of a cache twice as big */
+    cache_ghost_resize(cache, st.nentries);
+
+    if (s->tries < CACHE_AUTOTUNE_MIN_TRIES) {
+        /* Not enough traffic to decide anything */
+        cache->c_tune_wss = st.size;
+        s->target = s->size;
+        return;
+    }
+    avg = st.nentries ? st.size / st.nentries : 0;
+    wss = st.size + s->ghosthits * avg;
+    if (wss > 2 * st.size) {
+        /* the ghost table does not remember more than the cache holds */
+        wss = 2 * st.size;
+    }
+    cache->c_tune_wss = wss;
+    s->target = wss + wss / 8;
+    if (s->target < MINCACHESIZE) {
+        s->target = MINCACHESIZE;
+    }
+}
+
+/*
+ * Share the available memory among the targets: if they do not fit, every
+ * cache gets the same fraction of what it asks above the minimum; if they
+ * fit, what is left goes to the caches that still have ghost hits, the
+ * rest stays with the page cache.
+ */
+static void
+cache_autotune_share(cache_sample_t *samples, size_t n, uint64_t available)
+{
+    uint64_t total = 0;
+    uint64_t mins = 0;
+    uint64_t ghosts = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        if (samples[i].tuned) {
+            total += samples[i].target;
+            mins += MINCACHESIZE;
+            ghosts += samples[i].ghosthits;
+        }
+    }
+    if (total > available) {
+        double ratio = (available > mins) ? (double)(available - mins) / (double)(total - mins) : 0.0;
+        for (size_t i = 0; i < n; i++) {
+            if (samples[i].tuned) {
+                samples[i].target = MINCACHESIZE + (uint64_t)((samples[i].target - MINCACHESIZE) * ratio);
+            }
+        }
+    } else if (ghosts > 0) {
+        uint64_t spare = available - total;
+        for (size_t i = 0; i < n; i++) {
+            if (samples[i].tuned && samples[i].ghosthits) {
+                samples[i].target += (uint64_t)((double)spare * samples[i].ghosthits / ghosts);
+            }
+        }
+    }
+}
+
+/* Damp the change of a cache size, returns the new size */
+static uint64_t
+cache_autotune_step(uint64_t size, uint64_t target)
+{
+    uint64_t step = 0;
+
+    if (target > size) {
+        step = target - size;
+        if (step > size / CACHE_AUTOTUNE_MAX_STEP) {
+            step = size / CACHE_AUTOTUNE_MAX_STEP;
+        }
+    } else {
+        step = size - target;
+        if (step > size / CACHE_AUTOTUNE_MAX_STEP) {
+            step = size / CACHE_AUTOTUNE_MAX_STEP;
+        }
+    }
+    if (step < size / CACHE_AUTOTUNE_MIN_STEP) {
+        return size;
+    }
+    if (step > MEGABYTE) {
+        step -= step % MEGABYTE;
+    }
+    return (target > size) ? size + step : size - step;
+}
+
+static void
+cache_autotune_apply(struct ldbminfo *li, cache_sample_t *s, uint64_t newsize)
+{
+    struct cache_autotune *at = li->li_cache_autotune;
+    char from[10] = {0};
+    char to[10] = {0};
+
+    convert_bytes_to_str((double)s->size, from, 0);
+    convert_bytes_to_str((double)newsize, to, 0);
+    slapi_log_err(SLAPI_LOG_INFO, "cache_autotune",
+                  "%s %s cache: %s -> %s (hit ratio %" PRIu64 "%%, ghost hits %" PRIu64 ")\n",
+                  s->inst->inst_name, cache_autotune_type_name(s->type), from, to,
+                  (uint64_t)(100.0 * s->hits / (s->tries ? s->tries : 1)), s->ghosthits);
+    cache_set_max_size(s->cache, newsize, s->type, true /* autotuned */);
+    s->cache->c_tune_delta = (int64_t)newsize - (int64_t)s->size;
+    at->resizes++;
+}
+
+static void
+cache_autotune_run(time_t when __attribute__((unused)), void *arg)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+    struct cache_autotune *at = li->li_cache_autotune;
+    cache_sample_t *samples = NULL;
+    cache_sample_t *largest = NULL;
+    uint64_t largest_newsize = 0;
+    uint64_t largest_change = 0;
+    uint64_t available = 0;
+    uint64_t allocated = 0;
+    uint64_t fixed = 0;
+    uint64_t total = 0;
+    size_t n = 0;
+    size_t max = 0;
+    Object *inst_obj = NULL;
+
+    PR_Lock(at->lock);
+    if (at->ctx == NULL || li->li_shutdown) {
+        /* cancelled while we were waiting */
+        PR_Unlock(at->lock);
+        return;
+    }
+
+    max = 2 * objset_size(li->li_instance_set);
+    samples = (cache_sample_t *)slapi_ch_calloc(max + 2, sizeof(cache_sample_t));
+    for (inst_obj = objset_first_obj(li->li_instance_set); inst_obj && n < max;
+         inst_obj = objset_next_obj(li->li_instance_set, inst_obj)) {
+        ldbm_instance *inst = (ldbm_instance *)object_get_data(inst_obj);
+        /* objset_next_obj releases inst_obj: keep the instance until the end */
+        object_acquire(inst_obj);
+        samples[n].inst_obj = inst_obj;
+        samples[n].inst = inst;
+        samples[n].cache = &inst->inst_cache;
+        samples[n++].type = CACHE_TYPE_ENTRY;
+        samples[n].inst = inst;
+        samples[n].cache = &inst->inst_dncache;
+        samples[n++].type = CACHE_TYPE_DN;
+    }
+    if (inst_obj) {
+        /* an instance was added meanwhile, it is for the next run */
+        object_release(inst_obj);
+    }
+    for (size_t i = 0; i < n; i++) {
+        cache_autotune_sample(&samples[i]);
+        total += samples[i].size;
+        if (!samples[i].tuned) {
+            fixed += samples[i].size;
+        }
+    }
+
+    /* The budget is what the caches got at startup, or when an instance
+     * was added or removed */
+    if (at->ncaches != n) {
+        at->ncaches = n;
+        at->budget = total;
+    }
+    at->effective_budget = at->budget;
+    slapi_pal_meminfo *mi = spal_meminfo_get();
+    if (mi) {
+        uint64_t low = mi->system_total_bytes / 100 * CACHE_AUTOTUNE_LOW_MEMORY;
+        if (mi->system_available_bytes < low) {
+            uint64_t pressure = low - mi->system_available_bytes;
+            at->effective_budget = (at->budget > pressure) ? at->budget - pressure : 0;
+        }
+        spal_meminfo_destroy(mi);
+    }
+    available = (at->effective_budget > fixed) ? at->effective_budget - fixed : 0;
+    cache_autotune_share(samples, n, available);
+
+    /* Shrink first so that the budget is never exceeded, then grow with
+     * what is left */
+    for (size_t i = 0; i < n; i++) {
+        samples[i].cache->c_tune_delta = 0;
+        if (samples[i].tuned) {
+            uint64_t newsize = cache_autotune_step(samples[i].size, samples[i].target);
+            if (newsize < samples[i].size) {
+                cache_autotune_apply(li, &samples[i], newsize);
+                if (samples[i].size - newsize > largest_change) {
+                    largest = &samples[i];
+                    largest_newsize = newsize;
+                    largest_change = samples[i].size - newsize;
+                }
+                samples[i].size = newsize;
+            }
+        }
+        allocated += samples[i].size;
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (samples[i].tuned) {
+            uint64_t newsize = cache_autotune_step(samples[i].size, samples[i].target);
+            if (newsize > samples[i].size) {
+                uint64_t room = (at->effective_budget > allocated) ? at->effective_budget - allocated : 0;
+                if (newsize - samples[i].size > room) {
+                    newsize = samples[i].size + room;
+                }
+                if (newsize - samples[i].size < samples[i].size / CACHE_AUTOTUNE_MIN_STEP) {
+                    continue;
+                }
+                cache_autotune_apply(li, &samples[i], newsize);
+                allocated += newsize - samples[i].size;
+                if (newsize - samples[i].size > largest_change) {
+                    largest = &samples[i];
+                    largest_newsize = newsize;
+                    largest_change = newsize - samples[i].size;
+                }
+                samples[i].size = newsize;
+            }
+        }
+    }
+    at->allocated = allocated;
+    at->runs++;
+    if (largest) {
+        char to[10] = {0};
+        convert_bytes_to_str((double)largest_newsize, to, 0);
+        PR_snprintf(at->decision, sizeof(at->decision), "%s %s cache resized to %s (%" PRIu64 " ghost hits)",
+                    largest->inst->inst_name, cache_autotune_type_name(largest->type), to, largest->ghosthits);
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (samples[i].inst_obj) {
+            object_release(samples[i].inst_obj);
+        }
+    }
+    slapi_ch_free((void **)&samples);
+    PR_Unlock(at->lock);
+}
+
+/* Schedule the controller if nsslapd-cache-autosize and the interval are set */
+void
+ldbm_cache_autotune_start(struct ldbminfo *li)
+{
+    struct cache_autotune *at = NULL;
+    int interval = li->li_cache_autotune_interval;
+
+    if (li->li_cache_autotune == NULL) {
+        at = (struct cache_autotune *)slapi_ch_calloc(1, sizeof(struct cache_autotune));
+        at->lock = PR_NewLock();
+        PL_strncpyz(at->decision, "none", sizeof(at->decision));
+        li->li_cache_autotune = at;
+    }
+    at = li->li_cache_autotune;
+    if (li->li_cache_autosize <= 0 || interval <= 0) {
+        return;
+    }
+    PR_Lock(at->lock);
+    if (at->ctx == NULL) {
+        at->ctx = slapi_eq_repeat_rel(cache_autotune_run, li,
+                                      slapi_current_rel_time_t() + interval,
+                                      1000 * interval);
+        slapi_log_err(SLAPI_LOG_INFO, "ldbm_cache_autotune_start",
+                      "Rebalancing the entry and dn caches every %d seconds\n", interval);
+    }
+    PR_Unlock(at->lock);
+}
+
+void
+ldbm_cache_autotune_stop(struct ldbminfo *li)
+{
+    struct cache_autotune *at = li->li_cache_autotune;
+    Slapi_Eq_Context ctx = NULL;
+
+    if (at == NULL) {
+        return;
+    }
+    /* Taking the lock waits for a running rebalancing to complete */
+    PR_Lock(at->lock);
+    ctx = at->ctx;
+    at->ctx = NULL;
+    at->ncaches = 0;
+    PR_Unlock(at->lock);
+    if (ctx) {
+        slapi_eq_cancel_rel(ctx);
+    }
+}
+
+/* Free the controller state, once it is stopped */
+void
+ldbm_cache_autotune_destroy(struct ldbminfo *li)
+{
+    struct cache_autotune *at = li->li_cache_autotune;
+
+    if (at == NULL) {
+        return;
+    }
+    ldbm_cache_autotune_stop(li);
+    PR_DestroyLock(at->lock);
+    slapi_ch_free((void **)&li->li_cache_autotune);
+}
+
+/* Add the controller decisions to cn=monitor,cn=ldbm database */
+void
+ldbm_cache_autotune_monitor(struct ldbminfo *li, Slapi_Entry *e)
+{
+    struct cache_autotune *at = li->li_cache_autotune;
+
+    if (at == NULL || at->runs == 0) {
+        return;
+    }
+    PR_Lock(at->lock);
+    slapi_entry_attr_set_ulong(e, "cacheAutotuneRuns", at->runs);
+    slapi_entry_attr_set_ulong(e, "cacheAutotuneResizes", at->resizes);
+    slapi_entry_attr_set_ulong(e, "cacheAutotuneBudget", at->budget);
+    slapi_entry_attr_set_ulong(e, "cacheAutotuneEffectiveBudget", at->effective_budget);
+    slapi_entry_attr_set_ulong(e, "cacheAutotuneAllocated", at->allocated);
+    slapi_entry_attr_set_charptr(e, "cacheAutotuneLastDecision", at->decision);
+    PR_Unlock(at->lock);
+}
+
+/* Add the working set estimates to the monitor entry of an instance */
+void
+ldbm_cache_autotune_monitor_instance(ldbm_instance *inst, Slapi_Entry *e)
+{
+    struct cache_autotune *at = inst->inst_li->li_cache_autotune;
+    struct cache_stats cstats = {0};
+
+    if (at == NULL || at->runs == 0) {
+        return;
+    }
+    cache_get_stats(&inst->inst_cache, &cstats);
+    slapi_entry_attr_set_ulong(e, "entryCacheGhostHits", cstats.ghosthits);
+    slapi_entry_attr_set_ulong(e, "entryCacheWorkingSetEstimate", inst->inst_cache.c_tune_wss);
+    slapi_entry_attr_set_longlong(e, "entryCacheAutotuneDelta", inst->inst_cache.c_tune_delta);
+    cache_get_stats(&inst->inst_dncache, &cstats);
+    slapi_entry_attr_set_ulong(e, "dnCacheGhostHits", cstats.ghosthits);
+    slapi_entry_attr_set_ulong(e, "dnCacheWorkingSetEstimate", inst->inst_dncache.c_tune_wss);
+    slapi_entry_attr_set_longlong(e, "dnCacheAutotuneDelta", inst->inst_dncache.c_tune_delta);
+}
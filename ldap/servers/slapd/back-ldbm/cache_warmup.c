@@ -0,0 +1,497 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/* cache_warmup.c - reload the hot entries of the entry cache after a restart */
+
+/*
+ * When nsslapd-cache-warmup is on (it is off by default), the IDs of the entries of each entry
+ * cache, the most recently used first, are written in
+ * <db directory>/<instance>.cachewarmup every nsslapd-cache-warmup-interval
+ * seconds and at shutdown.
+ *
+ * At startup, nsslapd-cache-warmup-threads threads per instance read the
+ * entries of the snapshot back in the entry cache (and the dn cache) while
+ * the server serves the clients. They run at a low priority, load at most
+ * nsslapd-cache-warmup-rate entries per second and stop when the cache is
+ * almost full, so that the entries of the live traffic are not evicted.
+ * The progress is reported in the monitor entry of the instance.
+ */
+
+#include "back-ldbm.h"
+
+#define CACHE_WARMUP_MAGIC "389WARM1"
+#define CACHE_WARMUP_SUFFIX "cachewarmup"
+#define CACHE_WARMUP_BATCH 256 /* IDs read with a single cursor */
+
+typedef enum {
+    CACHE_WARMUP_NONE,     /* no snapshot to load */
+    CACHE_WARMUP_LOADING,
+    CACHE_WARMUP_DONE,
+    CACHE_WARMUP_CACHEFULL,
+    CACHE_WARMUP_ABORTED,
+} cache_warmup_state_t;
+
+static const char *cache_warmup_state_names[] = {"none", "loading", "done", "cachefull", "aborted"};
+
+struct cache_warmup_header
+{
+    char magic[8];
+    uint64_t nextid; /* inst_nextid when the snapshot was written */
+    uint64_t count;  /* IDs following the header */
+};
+
+struct cache_warmup
+{
+    backend *be;
+    ID *ids;
+    uint64_t nids;
+    uint64_t next;   /* first ID of the next batch */
+    uint64_t loaded;
+    int32_t running; /* loader threads still running */
+    int32_t stop;
+    int32_t state;
+    int rate;
+    struct timespec start;
+    struct timespec end;
+    int nthreads;
+    PRThread **threads;
+};
+
+static char *
+cache_warmup_path(ldbm_instance *inst)
+{
+    return slapi_ch_smprintf("%s/%s.%s", inst->inst_li->li_directory, inst->inst_name, CACHE_WARMUP_SUFFIX);
+}
+
+static ID
+cache_warmup_nextid(ldbm_instance *inst)
+{
+    ID nextid;
+
+    PR_Lock(inst->inst_nextid_mutex);
+    nextid = inst->inst_nextid;
+    PR_Unlock(inst->inst_nextid_mutex);
+    return nextid;
+}
+
+/* Write the IDs of the entry cache in a temporary file then rename it */
+static void
+cache_warmup_snapshot(ldbm_instance *inst)
+{
+    struct cache_warmup *w = inst->inst_warmup;
+    struct cache_warmup_header hdr = {{0}};
+    char *path = NULL;
+    char *tmppath = NULL;
+    uint64_t count = 0;
+    ID *ids = NULL;
+    FILE *fp = NULL;
+    int rc = 0;
+
+    if ((inst->inst_flags & INST_FLAG_BUSY) ||
+        (w && slapi_atomic_load_32(&w->state, __ATOMIC_ACQUIRE) == CACHE_WARMUP_LOADING)) {
+        /* Until the loading is complete, the previous snapshot is better */
+        return;
+    }
+    ids = cache_get_ids(&inst->inst_cache, &count);
+    if (count == 0) {
+        slapi_ch_free((void **)&ids);
+        return;
+    }
+    memcpy(hdr.magic, CACHE_WARMUP_MAGIC, sizeof(hdr.magic));
+    hdr.nextid = cache_warmup_nextid(inst);
+    hdr.count = count;
+
+    path = cache_warmup_path(inst);
+    tmppath = slapi_ch_smprintf("%s.tmp", path);
+    fp = fopen(tmppath, "w");
+    if (fp == NULL) {
+        rc = errno;
+    } else {
+        if (fwrite(&hdr, sizeof(hdr), 1, fp) != 1 ||
+            fwrite(ids, sizeof(ID), count, fp) != count) {
+            rc = errno ? errno : EIO;
+        }
+        if (fclose(fp) && rc == 0) {
+            rc = errno;
+        }
+    }
+    if (rc == 0 && rename(tmppath, path)) {
+        rc = errno;
+    }
+    if (rc) {
+        slapi_log_err(SLAPI_LOG_ERR, "cache_warmup_snapshot",
+                      "Failed to write %s, err=%d: %s\n", path, rc, slapd_system_strerror(rc));
+        unlink(tmppath);
+    } else {
+        slapi_log_err(SLAPI_LOG_CACHE, "cache_warmup_snapshot",
+                      "%s: %" PRIu64 " entry IDs written in %s\n", inst->inst_name, count, path);
+    }
+    slapi_ch_free_string(&tmppath);
+    slapi_ch_free_string(&path);
+    slapi_ch_free((void **)&ids);
+}
+
+/* Read the snapshot of an instance, returns NULL if there is none usable */
+static ID *
+cache_warmup_read(ldbm_instance *inst, uint64_t *count)
+{
+    struct cache_warmup_header hdr = {{0}};
+    char *path = cache_warmup_path(inst);
+    ID *ids = NULL;
+    FILE *fp = NULL;
+
+    *count = 0;
+    fp = fopen(path, "r");
+    if (fp == NULL) {
+        slapi_ch_free_string(&path);
+        return NULL;
+    }
+    if (fread(&hdr, sizeof(hdr), 1, fp) != 1 ||
+        memcmp(hdr.magic, CACHE_WARMUP_MAGIC, sizeof(hdr.magic)) != 0) {
+        slapi_log_err(SLAPI_LOG_WARNING, "cache_warmup_read", "%s is not a cache warmup snapshot\n", path);
+    } else if (hdr.nextid > cache_warmup_nextid(inst)) {
+        /* The database was initialized again since the snapshot */
+        slapi_log_err(SLAPI_LOG_INFO, "cache_warmup_read", "%s is obsolete, ignoring it\n", path);
+    } else if (hdr.count > 0) {
+        ids = (ID *)slapi_ch_malloc(hdr.count * sizeof(ID));
+        *count = fread(ids, sizeof(ID), hdr.count, fp);
+        if (*count == 0) {
+            slapi_ch_free((void **)&ids);
+        }
+    }
+    fclose(fp);
+    slapi_ch_free_string(&path);
+    return ids;
+}
+
+static bool
+cache_warmup_cache_full(ldbm_instance *inst)
+{
+    struct cache_stats st = {0};
+
+    cache_get_stats(&inst->inst_cache, &st);
+    return (st.size >= st.maxsize - st.maxsize / 10) ||
+           (st.maxentries > 0 && st.nentries >= (uint64_t)(st.maxentries - st.maxentries / 10));
+}
+
+/* Wait so that the instance loads no more than rate entries per second */
+static void
+cache_warmup_throttle(struct cache_warmup *w)
+{
+    struct timespec now = {0};
+    struct timespec elapsed = {0};
+    uint64_t elapsed_ms = 0;
+    uint64_t expected_ms = 0;
+
+    if (w->rate <= 0) {
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    slapi_timespec_diff(&now, &w->start, &elapsed);
+    elapsed_ms = elapsed.tv_sec * 1000 + elapsed.tv_nsec / 1000000;
+    expected_ms = slapi_atomic_load_64(&w->loaded, __ATOMIC_ACQUIRE) * 1000 / w->rate;
+    if (expected_ms > elapsed_ms) {
+        uint64_t ms = expected_ms - elapsed_ms;
+        DS_Sleep(PR_MillisecondsToInterval(ms > 1000 ? 1000 : ms));
+    }
+}
+
+static void
+cache_warmup_worker(void *arg)
+{
+    struct cache_warmup *w = (struct cache_warmup *)arg;
+    backend *be = w->be;
+    ldbm_instance *inst = (ldbm_instance *)be->be_instance_info;
+    int32_t state = CACHE_WARMUP_DONE;
+
+    while (1) {
+        back_txn txn = {NULL};
+        uint64_t first = 0;
+        uint64_t n = 0;
+
+        if (slapi_atomic_load_32(&w->stop, __ATOMIC_ACQUIRE) ||
+            (inst->inst_flags & INST_FLAG_BUSY) || be->be_state != BE_STATE_STARTED) {
+            state = CACHE_WARMUP_ABORTED;
+            break;
+        }
+        if (cache_warmup_cache_full(inst)) {
+            state = CACHE_WARMUP_CACHEFULL;
+            break;
+        }
+        first = slapi_atomic_add_64(&w->next, CACHE_WARMUP_BATCH, __ATOMIC_ACQ_REL) - CACHE_WARMUP_BATCH;
+        if (first >= w->nids) {
+            break;
+        }
+        n = (w->nids - first < CACHE_WARMUP_BATCH) ? w->nids - first : CACHE_WARMUP_BATCH;
+
+        /* Like a search, hold the instance so that an import or a restore
+         * waits for the batch, and check again once it is held */
+        slapi_counter_increment(inst->inst_ref_count);
+        if ((inst->inst_flags & INST_FLAG_BUSY) || be->be_state != BE_STATE_STARTED) {
+            slapi_counter_decrement(inst->inst_ref_count);
+            state = CACHE_WARMUP_ABORTED;
+            break;
+        }
+        if (dblayer_snapshot_txn_begin(be, &txn) == 0) {
+            id2entry_prefetch(be, w->ids + first, n, &txn);
+            dblayer_snapshot_txn_commit(be, &txn);
+        }
+        slapi_counter_decrement(inst->inst_ref_count);
+        slapi_atomic_add_64(&w->loaded, n, __ATOMIC_ACQ_REL);
+        cache_warmup_throttle(w);
+    }
+
+    /* The first reason to stop is the one reported */
+    if (state != CACHE_WARMUP_DONE) {
+        int32_t loading = CACHE_WARMUP_LOADING;
+        __atomic_compare_exchange_n(&w->state, &loading, state, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+    }
+    if (slapi_atomic_decr_32(&w->running, __ATOMIC_ACQ_REL) == 0) {
+        int32_t loading = CACHE_WARMUP_LOADING;
+        clock_gettime(CLOCK_MONOTONIC, &w->end);
+        __atomic_compare_exchange_n(&w->state, &loading, CACHE_WARMUP_DONE, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+        slapi_log_err(SLAPI_LOG_INFO, "cache_warmup_worker",
+                      "%s: %" PRIu64 " of %" PRIu64 " entries loaded in %ld seconds (%s)\n",
+                      inst->inst_name, slapi_atomic_load_64(&w->loaded, __ATOMIC_ACQUIRE), w->nids,
+                      (long)(w->end.tv_sec - w->start.tv_sec),
+                      cache_warmup_state_names[slapi_atomic_load_32(&w->state, __ATOMIC_ACQUIRE)]);
+    }
+}
+
+/*
+ * Set the warmup of an instance and return the previous one. The monitor
+ * reads inst_warmup under li_cache_warmup_lock, so it is only changed
+ * under that lock and the previous one is freed once it is detached.
+ */
+static struct cache_warmup *
+cache_warmup_swap(ldbm_instance *inst, struct cache_warmup *w)
+{
+    struct ldbminfo *li = inst->inst_li;
+    struct cache_warmup *old = NULL;
+
+    PR_Lock(li->li_cache_warmup_lock);
+    old = inst->inst_warmup;
+    inst->inst_warmup = w;
+    PR_Unlock(li->li_cache_warmup_lock);
+    return old;
+}
+
+/* Start the loader threads of an instance if it has a snapshot */
+static void
+cache_warmup_load(ldbm_instance *inst)
+{
+    struct ldbminfo *li = inst->inst_li;
+    struct cache_warmup *w = NULL;
+    int nthreads = li->li_cache_warmup_threads > 0 ? li->li_cache_warmup_threads : 1;
+
+    w = (struct cache_warmup *)slapi_ch_calloc(1, sizeof(struct cache_warmup));
+    w->be = inst->inst_be;
+    w->rate = li->li_cache_warmup_rate;
+    w->ids = cache_warmup_read(inst, &w->nids);
+    if (w->ids == NULL) {
+        w->state = CACHE_WARMUP_NONE;
+        (void)cache_warmup_swap(inst, w);
+        return;
+    }
+    slapi_log_err(SLAPI_LOG_INFO, "cache_warmup_load",
+                  "%s: loading %" PRIu64 " entries in the entry cache with %d threads\n",
+                  inst->inst_name, w->nids, nthreads);
+    w->state = CACHE_WARMUP_LOADING;
+    clock_gettime(CLOCK_MONOTONIC, &w->start);
+    w->threads = (PRThread **)slapi_ch_calloc(nthreads, sizeof(PRThread *));
+    for (int i = 0; i < nthreads; i++) {
+        slapi_atomic_incr_32(&w->running, __ATOMIC_ACQ_REL);
+        w->threads[i] = PR_CreateThread(PR_USER_THREAD, cache_warmup_worker, w,
+                                        PR_PRIORITY_LOW, PR_GLOBAL_THREAD,
+                                        PR_JOINABLE_THREAD, SLAPD_DEFAULT_THREAD_STACKSIZE);
+        if (w->threads[i] == NULL) {
+            slapi_log_err(SLAPI_LOG_ERR, "cache_warmup_load",
+                          "%s: failed to create a loader thread\n", inst->inst_name);
+            slapi_atomic_decr_32(&w->running, __ATOMIC_ACQ_REL);
+            break;
+        }
+        w->nthreads++;
+    }
+    if (w->nthreads == 0) {
+        w->state = CACHE_WARMUP_ABORTED;
+    }
+    (void)cache_warmup_swap(inst, w);
+}
+
+/* Stop the loader threads of a warmup, returns its final state */
+static int32_t
+cache_warmup_join(struct cache_warmup *w)
+{
+
+    if (w == NULL) {
+        return CACHE_WARMUP_NONE;
+    }
+    slapi_atomic_store_32(&w->stop, 1, __ATOMIC_RELEASE);
+    for (int i = 0; i < w->nthreads; i++) {
+        (void)PR_JoinThread(w->threads[i]);
+    }
+    w->nthreads = 0;
+    slapi_ch_free((void **)&w->threads);
+    slapi_ch_free((void **)&w->ids);
+    return slapi_atomic_load_32(&w->state, __ATOMIC_ACQUIRE);
+}
+
+static void
+cache_warmup_snapshot_all(time_t when __attribute__((unused)), void *arg)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+    Object *inst_obj = NULL;
+
+    PR_Lock(li->li_cache_warmup_lock);
+    if (li->li_cache_warmup_ctx && !li->li_shutdown) {
+        for (inst_obj = objset_first_obj(li->li_instance_set); inst_obj;
+             inst_obj = objset_next_obj(li->li_instance_set, inst_obj)) {
+            cache_warmup_snapshot((ldbm_instance *)object_get_data(inst_obj));
+        }
+    }
+    PR_Unlock(li->li_cache_warmup_lock);
+}
+
+/* (Re)schedule the periodic snapshots after a configuration change */
+void
+ldbm_cache_warmup_schedule(struct ldbminfo *li)
+{
+    Slapi_Eq_Context ctx = NULL;
+    int interval = li->li_cache_warmup_interval;
+
+    if (li->li_cache_warmup_lock == NULL) {
+        /* not started */
+        return;
+    }
+    PR_Lock(li->li_cache_warmup_lock);
+    ctx = li->li_cache_warmup_ctx;
+    li->li_cache_warmup_ctx = NULL;
+    if (ctx) {
+        slapi_eq_cancel_rel(ctx);
+    }
+    if (li->li_cache_warmup && interval > 0 && !li->li_shutdown) {
+        li->li_cache_warmup_ctx = slapi_eq_repeat_rel(cache_warmup_snapshot_all, li,
+                                                      slapi_current_rel_time_t() + interval,
+                                                      1000 * interval);
+    }
+    PR_Unlock(li->li_cache_warmup_lock);
+}
+
+/* At startup: load the snapshots and schedule the next ones */
+void
+ldbm_cache_warmup_start(struct ldbminfo *li)
+{
+    Object *inst_obj = NULL;
+
+    if (li->li_cache_warmup_lock == NULL) {
+        li->li_cache_warmup_lock = PR_NewLock();
+    }
+    for (inst_obj = objset_first_obj(li->li_instance_set); inst_obj;
+         inst_obj = objset_next_obj(li->li_instance_set, inst_obj)) {
+        ldbm_instance *inst = (ldbm_instance *)object_get_data(inst_obj);
+        if (li->li_cache_warmup && inst->inst_warmup == NULL &&
+            inst->inst_be->be_state == BE_STATE_STARTED) {
+            cache_warmup_load(inst);
+        }
+    }
+    ldbm_cache_warmup_schedule(li);
+}
+
+/* At shutdown: stop the loaders and write the last snapshots */
+void
+ldbm_cache_warmup_stop(struct ldbminfo *li)
+{
+    Slapi_Eq_Context ctx = NULL;
+    Object *inst_obj = NULL;
+
+    if (li->li_cache_warmup_lock == NULL) {
+        return;
+    }
+    PR_Lock(li->li_cache_warmup_lock);
+    ctx = li->li_cache_warmup_ctx;
+    li->li_cache_warmup_ctx = NULL;
+    PR_Unlock(li->li_cache_warmup_lock);
+    if (ctx) {
+        slapi_eq_cancel_rel(ctx);
+    }
+
+    for (inst_obj = objset_first_obj(li->li_instance_set); inst_obj;
+         inst_obj = objset_next_obj(li->li_instance_set, inst_obj)) {
+        ldbm_instance *inst = (ldbm_instance *)object_get_data(inst_obj);
+        struct cache_warmup *w = cache_warmup_swap(inst, NULL);
+        int32_t state = cache_warmup_join(w);
+        slapi_ch_free((void **)&w);
+        if (li->li_cache_warmup && state != CACHE_WARMUP_ABORTED) {
+            cache_warmup_snapshot(inst);
+        }
+    }
+}
+
+/* When an instance is deleted */
+void
+ldbm_cache_warmup_stop_instance(ldbm_instance *inst)
+{
+    struct ldbminfo *li = inst->inst_li;
+    struct cache_warmup *w = NULL;
+    char *path = NULL;
+
+    if (li->li_cache_warmup_lock) {
+        /* waits for a running snapshot */
+        w = cache_warmup_swap(inst, NULL);
+    }
+    cache_warmup_join(w);
+    slapi_ch_free((void **)&w);
+    path = cache_warmup_path(inst);
+    unlink(path);
+    slapi_ch_free_string(&path);
+}
+
+/* Add the warmup progress to the monitor entry of an instance */
+void
+ldbm_cache_warmup_monitor_instance(ldbm_instance *inst, Slapi_Entry *e)
+{
+    struct ldbminfo *li = inst->inst_li;
+    struct cache_warmup *w = NULL;
+    struct timespec now = {0};
+    uint64_t loaded = 0;
+    int32_t state = 0;
+
+    if (li->li_cache_warmup_lock == NULL) {
+        return;
+    }
+    /* The lock keeps the warmup from being freed by a shutdown or a
+     * deletion of the instance */
+    PR_Lock(li->li_cache_warmup_lock);
+    w = inst->inst_warmup;
+    if (w == NULL) {
+        PR_Unlock(li->li_cache_warmup_lock);
+        return;
+    }
+    state = slapi_atomic_load_32(&w->state, __ATOMIC_ACQUIRE);
+    loaded = slapi_atomic_load_64(&w->loaded, __ATOMIC_ACQUIRE);
+    if (loaded > w->nids) {
+        loaded = w->nids;
+    }
+    slapi_entry_attr_set_charptr(e, "cacheWarmupState", cache_warmup_state_names[state]);
+    slapi_entry_attr_set_ulong(e, "cacheWarmupEntries", w->nids);
+    slapi_entry_attr_set_ulong(e, "cacheWarmupLoaded", loaded);
+    slapi_entry_attr_set_ulong(e, "cacheWarmupProgress", w->nids ? 100 * loaded / w->nids : 100);
+    if (state != CACHE_WARMUP_NONE) {
+        if (state == CACHE_WARMUP_LOADING) {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+        } else {
+            now = w->end;
+        }
+        slapi_entry_attr_set_ulong(e, "cacheWarmupElapsedTime", now.tv_sec - w->start.tv_sec);
+    }
+    PR_Unlock(li->li_cache_warmup_lock);
+}
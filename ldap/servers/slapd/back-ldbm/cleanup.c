@@ -70,6 +70,8 @@ ldbm_back_cleanup(Slapi_PBlock *pb)
             priv->dblayer_cleanup_fn(li);
         }
 
+        ldbm_cache_autotune_destroy(li);
+
         ldbm_config_destroy(li);
 
         slapi_pblock_set(pb, SLAPI_PLUGIN_PRIVATE, NULL);
@@ -28,6 +28,9 @@ ldbm_back_close(Slapi_PBlock *pb)
     li->li_shutdown = 1;
     PR_Unlock(li->li_shutdown_mutex);
 
+    ldbm_cache_autotune_stop(li);
+    ldbm_cache_warmup_stop(li);
+
     /* close down all the ldbm instances */
     dblayer_close(li, DBLAYER_NORMAL_MODE);
 
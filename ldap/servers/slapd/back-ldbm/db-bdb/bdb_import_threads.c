@@ -1105,6 +1105,16 @@ bdb_index_producer(void *param)
         slapi_ch_free(&(key.data));
         slapi_ch_free(&(data.data));
 
+        if (e) {
+            rc = id2entry_extvalues_load(be, temp_id, e, NULL);
+            if (rc) {
+                import_log_notice(job, SLAPI_LOG_ERR, "bdb_index_producer",
+                                  "Failed to load the external values of entry %d (err %d: %s)",
+                                  temp_id, rc, dblayer_strerror(rc));
+                slapi_entry_free(e);
+                goto error;
+            }
+        }
         rc = bdb_index_set_entry_to_fifo(info, e, temp_id, &id, curr_entry);
         if (rc) {
             goto error;
@@ -3015,6 +3025,9 @@ bdb_bulk_import_start(Slapi_PBlock *pb)
     /* bdb_instance_start will init the id2entry index. */
     /* it also (finally) fills in inst_dir_name */
     ret = bdb_instance_start(be, DBLAYER_IMPORT_MODE);
+    if (ret != 0)
+        goto fail;
+    ret = bdb_truncate_extvalues(be);
     if (ret != 0)
         goto fail;
 
@@ -4751,6 +4751,30 @@ bdb_delete_instance_dir(backend *be)
     }
 }
 
+/*
+ * Empty the extvalues file of an instance that is being imported:
+ * bdb_delete_instance_dir may leave it behind, and the values it holds
+ * would be attached to whatever entries get the same IDs.
+ */
+int
+bdb_truncate_extvalues(backend *be)
+{
+    dbi_db_t *db = NULL;
+    uint32_t count = 0;
+    int rc;
+
+    rc = dblayer_get_extvalues(be, &db, DBOPEN_CREATE);
+    if (rc == 0) {
+        rc = ((DB *)db)->truncate((DB *)db, NULL, &count, 0);
+    }
+    if (rc) {
+        slapi_log_err(SLAPI_LOG_ERR, "bdb_truncate_extvalues",
+                      "Failed to empty the extvalues file of %s (%d): %s\n",
+                      be->be_name, rc, dblayer_strerror(rc));
+    }
+    return rc;
+}
+
 
 static int
 bdb_delete_database_ex(struct ldbminfo *li, char *cldir)
@@ -5288,7 +5312,7 @@ out:
 
 /* Destination Directory is an absolute pathname */
 int
-bdb_backup(struct ldbminfo *li, char *dest_dir, Slapi_Task *task)
+bdb_backup(struct ldbminfo *li, char *dest_dir, const char *base_dir, int flags, Slapi_Task *task)
 {
     dblayer_private *priv = NULL;
     bdb_config *conf = NULL;
@@ -5319,6 +5343,16 @@ bdb_backup(struct ldbminfo *li, char *dest_dir, Slapi_Task *task)
         return return_value;
     }
 
+    if (base_dir || flags) {
+        /* the bdb backups are copies of the database and log files */
+        slapi_log_err(SLAPI_LOG_ERR, "bdb_backup",
+                      "Incremental, compacted and compressed backups are only supported with lmdb\n");
+        if (task) {
+            slapi_task_log_notice(task, "Incremental, compacted and compressed backups are only supported with lmdb");
+        }
+        return LDAP_UNWILLING_TO_PERFORM;
+    }
+
     /*
      * What are we doing here ?
      * We want to copy into the backup directory:
@@ -106,7 +106,7 @@ int bdb_init(struct ldbminfo *li, config_info *config_array);
 int bdb_close(struct ldbminfo *li, int flags);
 int bdb_start(struct ldbminfo *li, int flags);
 int bdb_instance_start(backend *be, int flags);
-int bdb_backup(struct ldbminfo *li, char *dest_dir, Slapi_Task *task);
+int bdb_backup(struct ldbminfo *li, char *dest_dir, const char *base_dir, int flags, Slapi_Task *task);
 int bdb_verify(Slapi_PBlock *pb);
 int bdb_db2ldif(Slapi_PBlock *pb);
 int bdb_db2index(Slapi_PBlock *pb);
@@ -202,6 +202,7 @@ int bdb_delete_indices(ldbm_instance *inst);
 uint32_t bdb_get_optimal_block_size(struct ldbminfo *li);
 int bdb_copyfile(char *source, char *destination, int overwrite, int mode);
 int bdb_delete_instance_dir(backend *be);
+int bdb_truncate_extvalues(backend *be);
 int bdb_database_size(struct ldbminfo *li, unsigned int *size);
 int bdb_set_batch_transactions(void *arg, void *value, char *errorbuf, int phase, int apply);
 int bdb_set_batch_txn_min_sleep(void *arg, void *value, char *errorbuf, int phase, int apply);
@@ -363,6 +363,10 @@ bdb_ldif2db(Slapi_PBlock *pb)
     if (ret != 0) {
         goto fail;
     }
+    ret = bdb_truncate_extvalues(inst->inst_be);
+    if (ret != 0) {
+        goto fail;
+    }
 
     vlv_init(inst);
 
@@ -1218,6 +1222,17 @@ bdb_db2ldif(Slapi_PBlock *pb)
 
         if ((ep->ep_entry) != NULL) {
             ep->ep_id = temp_id;
+            rc = id2entry_extvalues_load(be, temp_id, ep->ep_entry, NULL);
+            if (rc) {
+                slapi_task_log_notice(task, "Backend %s: Failed to load the external values of entry %lu, err %d\n",
+                        inst->inst_name, (u_long)temp_id, rc);
+                slapi_log_err(SLAPI_LOG_ERR, "bdb_db2ldif",
+                        "db2ldif: Backend %s: failed to load the external values of entry %lu, err %d\n",
+                        inst->inst_name, (u_long)temp_id, rc);
+                backentry_free(&ep);
+                return_value = -1;
+                goto bye;
+            }
         } else {
             slapi_log_err(SLAPI_LOG_WARNING, "bdb_db2ldif",
                           "Skipping badly formatted entry with id %lu\n",
@@ -1813,6 +1828,16 @@ bdb_db2index(Slapi_PBlock *pb)
 
         if (ep->ep_entry != NULL) {
             ep->ep_id = temp_id;
+            rc = id2entry_extvalues_load(be, temp_id, ep->ep_entry, NULL);
+            if (rc) {
+                slapi_task_log_notice(task, "%s: ERROR: failed to load the external values of entry (id %lu) (err %d: %s)",
+                        inst->inst_name, (u_long)temp_id, rc, dblayer_strerror(rc));
+                slapi_log_err(SLAPI_LOG_ERR, "bdb_db2index",
+                              "%s: Failed to load the external values of entry (id %lu) (err %d: %s)\n",
+                              inst->inst_name, (u_long)temp_id, rc, dblayer_strerror(rc));
+                return_value = -2;
+                goto err_out;
+            }
         } else {
             slapi_task_log_notice(task, "%s: WARNING: skipping badly formatted entry (id %lu)",
                     inst->inst_name, (u_long)temp_id);
@@ -2875,6 +2900,16 @@ _get_and_add_parent_rdns(backend *be,
                                            SLAPI_STR2ENTRY_NO_ENTRYDN);
         ep->ep_id = id;
         slapi_ch_free_string(&dn);
+        if (ep->ep_entry) {
+            rc = id2entry_extvalues_load(be, id, ep->ep_entry, NULL);
+            if (rc) {
+                slapi_log_err(SLAPI_LOG_ERR, "_get_and_add_parent_rdns",
+                              "%s: Failed to load the external values of "
+                              "(rdn: %s, ID: %d) (err %d: %s)\n",
+                              inst->inst_name, rdn, id, rc, dblayer_strerror(rc));
+                goto bail;
+            }
+        }
     }
 
     if (index_ext & DB2INDEX_ENTRYRDN) {
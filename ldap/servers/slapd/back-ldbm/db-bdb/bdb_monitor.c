@@ -117,6 +117,8 @@ bdb_monitor_instance_search(Slapi_PBlock *pb __attribute__((unused)),
     MSET("currentDnCacheCount");
     sprintf(buf, "%" PRId64, cstats.maxentries);
     MSET("maxDnCacheCount");
+    ldbm_cache_autotune_monitor_instance(inst, e);
+    ldbm_cache_warmup_monitor_instance(inst, e);
 
 #ifdef DEBUG
     {
@@ -271,6 +273,7 @@ bdb_monitor_search(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_Entry *entryAfter, in
         sprintf(buf, "%" PRIu64, count);
         MSET("currentNormalizedDnCacheCount");
     }
+    ldbm_cache_autotune_monitor(li, e);
 
     slapi_ch_free((void **)&mpstat);
 
@@ -0,0 +1,622 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/* mdb_backup.c - streamed, compressed and incremental backups of the mdb database */
+
+/*
+ * mdb_env_copyfd2 writes the snapshot of a read txn into a pipe, and the
+ * backup thread reads it back one page at a time to write:
+ *  - data.mdb, a plain copy of the database,
+ *  - or data.mdb.gz with SLAPI_DB2ARCHIVE_COMPRESS,
+ *  - or data.mdb.incr for an incremental backup: the pages that changed
+ *    since the base backup, each one preceded by its page number. It is
+ *    not compressed, as its header is written again at the end.
+ *
+ * Unless the copy is compacted (SLAPI_DB2ARCHIVE_COMPACT renumbers the
+ * pages), data.mdb.pages keeps a digest of every page so that the backup
+ * can be the base of an incremental backup. The lmdb pages do not record
+ * the txn that wrote them: the changed pages are the ones whose digest is
+ * not the one in the manifest of the base backup. The whole database is
+ * still read, but only the changed pages are written.
+ *
+ * An incremental backup records the path and the id of its base backup: the
+ * restore rebuilds data.mdb from the full backup at the head of the chain,
+ * then applies the incremental backups in order.
+ */
+
+#include "mdb_layer.h"
+#include <zlib.h>
+#include <pk11func.h>
+
+#define DBMDB_BACKUP_MAGIC "389MDBK1"
+#define DBMDB_BACKUP_MAX_CHAIN 64 /* incremental backups on top of a full backup */
+#define DBMDB_BACKUP_MB (1024 * 1024)
+#define DBMDB_BACKUP_PROGRESS (1024ULL * DBMDB_BACKUP_MB) /* log the progress every GB */
+
+/* Header of data.mdb.pages and of data.mdb.incr */
+typedef struct
+{
+    char bh_magic[8];
+    uint32_t bh_psize;  /* page size */
+    uint32_t bh_baselen; /* length of the base backup path, that follows the header of data.mdb.incr */
+    uint64_t bh_size;   /* size of the database copy */
+    uint64_t bh_txnid;  /* last committed txn when the backup started */
+    uint64_t bh_id;     /* identifies the backup */
+    uint64_t bh_baseid; /* id of the base backup, 0 for a full backup */
+} dbmdb_backup_hdr_t;
+
+typedef struct
+{
+    MDB_env *env;
+    int fd;
+    unsigned int flags;
+    int rc;
+} dbmdb_backup_copy_t;
+
+static void
+dbmdb_backup_copy_thread(void *arg)
+{
+    dbmdb_backup_copy_t *copy = arg;
+
+    copy->rc = mdb_env_copyfd2(copy->env, copy->fd, copy->flags);
+    close(copy->fd);
+}
+
+/* Read up to len bytes, a short count means the end of the stream */
+static ssize_t
+dbmdb_backup_read(int fd, void *buf, size_t len)
+{
+    size_t done = 0;
+
+    while (done < len) {
+        ssize_t n = read(fd, (char *)buf + done, len - done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (n == 0) {
+            break;
+        }
+        done += n;
+    }
+    return done;
+}
+
+static int
+dbmdb_backup_write(int fd, const void *buf, size_t len)
+{
+    size_t done = 0;
+
+    while (done < len) {
+        ssize_t n = write(fd, (const char *)buf + done, len - done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        done += n;
+    }
+    return 0;
+}
+
+/* The first 64 bits of the SHA-256 digest of a page */
+static int
+dbmdb_backup_digest(PK11Context *ctx, const void *page, size_t len, uint64_t *digest)
+{
+    unsigned char buf[32];
+    unsigned int buflen = 0;
+
+    if (PK11_DigestBegin(ctx) != SECSuccess ||
+        PK11_DigestOp(ctx, page, len) != SECSuccess ||
+        PK11_DigestFinal(ctx, buf, &buflen, sizeof(buf)) != SECSuccess) {
+        return -1;
+    }
+    memcpy(digest, buf, sizeof(*digest));
+    return 0;
+}
+
+static int
+dbmdb_backup_read_hdr(int fd, const char *path, dbmdb_backup_hdr_t *hdr)
+{
+    if (dbmdb_backup_read(fd, hdr, sizeof(*hdr)) != sizeof(*hdr) ||
+        memcmp(hdr->bh_magic, DBMDB_BACKUP_MAGIC, sizeof(hdr->bh_magic)) != 0 ||
+        hdr->bh_psize == 0) {
+        slapi_log_err(SLAPI_LOG_ERR, "dbmdb_backup_read_hdr", "%s is not a valid backup file\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+static void
+dbmdb_backup_log(Slapi_Task *task, int level, const char *fmt, ...)
+{
+    char buf[BUFSIZ];
+    va_list ap;
+
+    va_start(ap, fmt);
+    PR_vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    slapi_log_err(level, "dbmdb_backup", "%s\n", buf);
+    if (task) {
+        slapi_task_log_notice(task, "%s", buf);
+    }
+}
+
+/*
+ * Backup the database in dest_dir, an incremental backup relative to
+ * base_dir if it is set.
+ */
+int
+dbmdb_backup_db(struct ldbminfo *li, const char *dest_dir, const char *base_dir, int flags, Slapi_Task *task)
+{
+    dbmdb_ctx_t *ctx = MDB_CONFIG(li);
+    int mode = li->li_mode | 0600;
+    dbmdb_backup_copy_t copy = {0};
+    dbmdb_backup_hdr_t hdr = {0};
+    dbmdb_backup_hdr_t basehdr = {0};
+    PK11Context *digest_ctx = NULL;
+    PRThread *copy_thread = NULL;
+    MDB_envinfo info = {0};
+    MDB_stat st = {0};
+    char *db_path = NULL;
+    char *pages_path = NULL;
+    char *base_pages_path = NULL;
+    char *page = NULL;
+    int pipefd[2] = {-1, -1};
+    int db_fd = -1;
+    int pages_fd = -1;
+    int base_fd = -1;
+    gzFile gz = NULL;
+    FILE *pages = NULL;
+    FILE *base_pages = NULL;
+    uint64_t base_npages = 0;
+    uint64_t npages = 0;
+    uint64_t nchanged = 0;
+    uint64_t size = 0;
+    int rc = -1;
+
+    mdb_env_stat(ctx->env, &st);
+    mdb_env_info(ctx->env, &info);
+    memcpy(hdr.bh_magic, DBMDB_BACKUP_MAGIC, sizeof(hdr.bh_magic));
+    hdr.bh_psize = st.ms_psize;
+    hdr.bh_txnid = info.me_last_txnid;
+    PK11_GenerateRandom((unsigned char *)&hdr.bh_id, sizeof(hdr.bh_id));
+    hdr.bh_id |= 1; /* 0 is the base id of the full backups */
+
+    if (base_dir && (flags & SLAPI_DB2ARCHIVE_COMPACT)) {
+        dbmdb_backup_log(task, SLAPI_LOG_ERR, "An incremental backup can not be a compacting copy");
+        goto out;
+    }
+    if (base_dir && (flags & SLAPI_DB2ARCHIVE_COMPRESS)) {
+        dbmdb_backup_log(task, SLAPI_LOG_ERR, "An incremental backup can not be compressed");
+        goto out;
+    }
+    if (base_dir) {
+        base_pages_path = slapi_ch_smprintf("%s/%s", base_dir, DBMAPFILE_PAGES);
+        base_fd = open(base_pages_path, O_RDONLY);
+        if (base_fd < 0) {
+            dbmdb_backup_log(task, SLAPI_LOG_ERR,
+                             "%s has no page manifest (%s), it can not be the base of an incremental backup",
+                             base_dir, strerror(errno));
+            goto out;
+        }
+        if (dbmdb_backup_read_hdr(base_fd, base_pages_path, &basehdr)) {
+            goto out;
+        }
+        if (basehdr.bh_psize != hdr.bh_psize) {
+            dbmdb_backup_log(task, SLAPI_LOG_ERR, "The page size of %s is not the page size of the database", base_dir);
+            goto out;
+        }
+        base_pages = fdopen(base_fd, "r");
+        if (base_pages == NULL) {
+            dbmdb_backup_log(task, SLAPI_LOG_ERR, "Failed to read %s (%s)", base_pages_path, strerror(errno));
+            goto out;
+        }
+        base_fd = -1;
+        base_npages = (basehdr.bh_size + basehdr.bh_psize - 1) / basehdr.bh_psize;
+        hdr.bh_baseid = basehdr.bh_id;
+        hdr.bh_baselen = strlen(base_dir);
+    }
+
+    if (base_dir) {
+        db_path = slapi_ch_smprintf("%s/%s", dest_dir, DBMAPFILE_INCR);
+    } else if (flags & SLAPI_DB2ARCHIVE_COMPRESS) {
+        db_path = slapi_ch_smprintf("%s/%s", dest_dir, DBMAPFILE_GZ);
+    } else {
+        db_path = slapi_ch_smprintf("%s/%s", dest_dir, DBMAPFILE);
+    }
+    /* like compress_log_file, create the file with the right mode before gzdopen */
+    db_fd = open(db_path, O_CREAT | O_WRONLY | O_TRUNC, mode);
+    if (db_fd < 0) {
+        dbmdb_backup_log(task, SLAPI_LOG_ERR, "Failed to create %s (%s)", db_path, strerror(errno));
+        goto out;
+    }
+    if (base_dir) {
+        /* the header is written again once the size is known */
+        if (dbmdb_backup_write(db_fd, &hdr, sizeof(hdr)) ||
+            dbmdb_backup_write(db_fd, base_dir, hdr.bh_baselen)) {
+            dbmdb_backup_log(task, SLAPI_LOG_ERR, "Failed to write %s (%s)", db_path, strerror(errno));
+            goto out;
+        }
+    } else if (flags & SLAPI_DB2ARCHIVE_COMPRESS) {
+        gz = gzdopen(db_fd, "wb");
+        if (gz == NULL) {
+            dbmdb_backup_log(task, SLAPI_LOG_ERR, "Failed to open %s for compression", db_path);
+            goto out;
+        }
+        db_fd = -1; /* closed by gzclose */
+    }
+
+    if (!(flags & SLAPI_DB2ARCHIVE_COMPACT)) {
+        pages_path = slapi_ch_smprintf("%s/%s", dest_dir, DBMAPFILE_PAGES);
+        pages_fd = open(pages_path, O_CREAT | O_WRONLY | O_TRUNC, mode);
+        if (pages_fd < 0 || (pages = fdopen(pages_fd, "w")) == NULL) {
+            dbmdb_backup_log(task, SLAPI_LOG_ERR, "Failed to create %s (%s)", pages_path, strerror(errno));
+            goto out;
+        }
+        pages_fd = -1;
+        if (fwrite(&hdr, sizeof(hdr), 1, pages) != 1) {
+            dbmdb_backup_log(task, SLAPI_LOG_ERR, "Failed to write %s (%s)", pages_path, strerror(errno));
+            goto out;
+        }
+        digest_ctx = PK11_CreateDigestContext(SEC_OID_SHA256);
+        if (digest_ctx == NULL) {
+            dbmdb_backup_log(task, SLAPI_LOG_ERR, "Failed to create a digest context");
+            goto out;
+        }
+    }
+
+    if (pipe(pipefd)) {
+        dbmdb_backup_log(task, SLAPI_LOG_ERR, "Failed to create a pipe (%s)", strerror(errno));
+        goto out;
+    }
+    copy.env = ctx->env;
+    copy.fd = pipefd[1];
+    copy.flags = (flags & SLAPI_DB2ARCHIVE_COMPACT) ? MDB_CP_COMPACT : 0;
+    copy_thread = PR_CreateThread(PR_USER_THREAD, dbmdb_backup_copy_thread, &copy,
+                                  PR_PRIORITY_NORMAL, PR_GLOBAL_THREAD, PR_JOINABLE_THREAD,
+                                  SLAPD_DEFAULT_THREAD_STACKSIZE);
+    if (copy_thread == NULL) {
+        dbmdb_backup_log(task, SLAPI_LOG_ERR, "Failed to create the database copy thread");
+        close(pipefd[1]);
+        goto out;
+    }
+
+    dbmdb_backup_log(task, SLAPI_LOG_INFO, "Backing up the database to %s%s%s", db_path,
+                     base_dir ? ", incremental backup relative to " : "", base_dir ? base_dir : "");
+    page = slapi_ch_malloc(hdr.bh_psize);
+    rc = 0;
+    while (1) {
+        ssize_t len = dbmdb_backup_read(pipefd[0], page, hdr.bh_psize);
+        uint64_t digest = 0;
+        uint64_t base_digest = 0;
+        int changed = 1;
+
+        if (len <= 0) {
+            if (len < 0) {
+                dbmdb_backup_log(task, SLAPI_LOG_ERR, "Failed to read the database copy (%s)", strerror(errno));
+                rc = -1;
+            }
+            break;
+        }
+        if (rc) {
+            /* drain the pipe, so the copy thread does not block */
+            continue;
+        }
+        if (digest_ctx) {
+            if (dbmdb_backup_digest(digest_ctx, page, len, &digest) ||
+                fwrite(&digest, sizeof(digest), 1, pages) != 1) {
+                dbmdb_backup_log(task, SLAPI_LOG_ERR, "Failed to write %s (%s)", pages_path, strerror(errno));
+                rc = -1;
+                continue;
+            }
+        }
+        if (base_pages && npages < base_npages) {
+            if (fread(&base_digest, sizeof(base_digest), 1, base_pages) != 1) {
+                dbmdb_backup_log(task, SLAPI_LOG_ERR, "Failed to read %s", base_pages_path);
+                rc = -1;
+                continue;
+            }
+            changed = (base_digest != digest);
+        }
+        if (gz) {
+            if (gzwrite(gz, page, (unsigned)len) != (int)len) {
+                dbmdb_backup_log(task, SLAPI_LOG_ERR, "Failed to write %s", db_path);
+                rc = -1;
+            }
+        } else if (!base_dir) {
+            if (dbmdb_backup_write(db_fd, page, len)) {
+                dbmdb_backup_log(task, SLAPI_LOG_ERR, "Failed to write %s (%s)", db_path, strerror(errno));
+                rc = -1;
+            }
+        } else if (changed) {
+            if (dbmdb_backup_write(db_fd, &npages, sizeof(npages)) ||
+                dbmdb_backup_write(db_fd, page, len)) {
+                dbmdb_backup_log(task, SLAPI_LOG_ERR, "Failed to write %s (%s)", db_path, strerror(errno));
+                rc = -1;
+            }
+            nchanged++;
+        }
+        npages++;
+        size += len;
+        if (size % DBMDB_BACKUP_PROGRESS < (uint64_t)len) {
+            dbmdb_backup_log(task, SLAPI_LOG_INFO, "Backup: %" PRIu64 " MB copied", size / DBMDB_BACKUP_MB);
+        }
+    }
+    (void)PR_JoinThread(copy_thread);
+    if (rc == 0 && copy.rc) {
+        dbmdb_backup_log(task, SLAPI_LOG_ERR, "Failed to copy the database: %d (%s)", copy.rc, mdb_strerror(copy.rc));
+        rc = copy.rc;
+    }
+    if (rc) {
+        goto out;
+    }
+
+    /* now that the size is known, finish the headers */
+    hdr.bh_size = size;
+    if (pages) {
+        if (fseek(pages, 0, SEEK_SET) || fwrite(&hdr, sizeof(hdr), 1, pages) != 1 ||
+            fflush(pages) || fsync(fileno(pages))) {
+            dbmdb_backup_log(task, SLAPI_LOG_ERR, "Failed to write %s (%s)", pages_path, strerror(errno));
+            rc = -1;
+            goto out;
+        }
+    }
+    if (base_dir && (pwrite(db_fd, &hdr, sizeof(hdr), 0) != sizeof(hdr))) {
+        dbmdb_backup_log(task, SLAPI_LOG_ERR, "Failed to write %s (%s)", db_path, strerror(errno));
+        rc = -1;
+        goto out;
+    }
+    if (db_fd >= 0 && fsync(db_fd)) {
+        dbmdb_backup_log(task, SLAPI_LOG_ERR, "Failed to write %s (%s)", db_path, strerror(errno));
+        rc = -1;
+        goto out;
+    }
+    if (base_dir) {
+        dbmdb_backup_log(task, SLAPI_LOG_INFO, "Backup: %" PRIu64 " pages of %" PRIu64 " changed since %s",
+                         nchanged, npages, base_dir);
+    } else {
+        dbmdb_backup_log(task, SLAPI_LOG_INFO, "Backup: %" PRIu64 " MB copied", size / DBMDB_BACKUP_MB);
+    }
+
+out:
+    if (pipefd[0] >= 0) {
+        close(pipefd[0]);
+    }
+    if (gz && gzclose(gz) != Z_OK && rc == 0) {
+        dbmdb_backup_log(task, SLAPI_LOG_ERR, "Failed to write %s", db_path);
+        rc = -1;
+    }
+    if (db_fd >= 0) {
+        close(db_fd);
+    }
+    if (pages_fd >= 0) {
+        close(pages_fd);
+    }
+    if (pages) {
+        fclose(pages);
+    }
+    if (base_fd >= 0) {
+        close(base_fd);
+    }
+    if (base_pages) {
+        fclose(base_pages);
+    }
+    if (digest_ctx) {
+        PK11_DestroyContext(digest_ctx, PR_TRUE);
+    }
+    slapi_ch_free_string(&page);
+    slapi_ch_free_string(&db_path);
+    slapi_ch_free_string(&pages_path);
+    slapi_ch_free_string(&base_pages_path);
+    return rc;
+}
+
+/* The database file of a backup: data.mdb, data.mdb.gz or data.mdb.incr */
+const char *
+dbmdb_backup_db_file(const char *src_dir)
+{
+    static const char *dbfiles[] = { DBMAPFILE, DBMAPFILE_GZ, DBMAPFILE_INCR, NULL };
+    struct stat sbuf;
+
+    for (const char **pt = dbfiles; *pt; pt++) {
+        char *path = slapi_ch_smprintf("%s/%s", src_dir, *pt);
+        int found = (stat(path, &sbuf) == 0 && sbuf.st_size > 0);
+
+        slapi_ch_free_string(&path);
+        if (found) {
+            return *pt;
+        }
+    }
+    return NULL;
+}
+
+/* The id of a full backup, 0 if it has no manifest (compacted backup) */
+static uint64_t
+dbmdb_backup_id(const char *src_dir)
+{
+    char *path = slapi_ch_smprintf("%s/%s", src_dir, DBMAPFILE_PAGES);
+    dbmdb_backup_hdr_t hdr = {0};
+    int fd = open(path, O_RDONLY);
+
+    if (fd >= 0) {
+        if (dbmdb_backup_read_hdr(fd, path, &hdr)) {
+            hdr.bh_id = 0;
+        }
+        close(fd);
+    }
+    slapi_ch_free_string(&path);
+    return hdr.bh_id;
+}
+
+static int
+dbmdb_restore_gz(const char *src, const char *dest, int mode, Slapi_Task *task)
+{
+    char *buf = slapi_ch_malloc(64 * 1024);
+    gzFile gz = gzopen(src, "rb");
+    int fd = open(dest, O_CREAT | O_WRONLY | O_TRUNC, mode);
+    int rc = -1;
+
+    if (gz == NULL || fd < 0) {
+        dbmdb_backup_log(task, SLAPI_LOG_ERR, "Restore: failed to open %s or %s", src, dest);
+        goto out;
+    }
+    dbmdb_backup_log(task, SLAPI_LOG_INFO, "Restore: uncompressing %s to %s", src, dest);
+    while (1) {
+        int len = gzread(gz, buf, 64 * 1024);
+        if (len < 0) {
+            dbmdb_backup_log(task, SLAPI_LOG_ERR, "Restore: failed to uncompress %s", src);
+            goto out;
+        }
+        if (len == 0) {
+            break;
+        }
+        if (dbmdb_backup_write(fd, buf, len)) {
+            dbmdb_backup_log(task, SLAPI_LOG_ERR, "Restore: failed to write %s (%s)", dest, strerror(errno));
+            goto out;
+        }
+    }
+    rc = 0;
+out:
+    if (gz) {
+        gzclose(gz);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    slapi_ch_free_string(&buf);
+    return rc;
+}
+
+/*
+ * Rebuild dest from the backup in src_dir, following its chain of base
+ * backups. *id is set to the id of the backup.
+ */
+static int
+dbmdb_restore_chain(struct ldbminfo *li, const char *src_dir, const char *dest, int depth, uint64_t *id, Slapi_Task *task)
+{
+    const char *dbfile = dbmdb_backup_db_file(src_dir);
+    dbmdb_backup_hdr_t hdr = {0};
+    char *path = NULL;
+    char *base_dir = NULL;
+    char *page = NULL;
+    uint64_t base_id = 0;
+    uint64_t pgno = 0;
+    int fd = -1;
+    int dest_fd = -1;
+    int rc = -1;
+
+    if (dbfile == NULL) {
+        dbmdb_backup_log(task, SLAPI_LOG_ERR, "Restore: %s does not contain a database backup", src_dir);
+        return -1;
+    }
+    path = slapi_ch_smprintf("%s/%s", src_dir, dbfile);
+    if (strcmp(dbfile, DBMAPFILE) == 0) {
+        rc = dbmdb_copyfile(path, (char *)dest, PR_TRUE, li->li_mode, task);
+        *id = dbmdb_backup_id(src_dir);
+        goto out;
+    }
+    if (strcmp(dbfile, DBMAPFILE_GZ) == 0) {
+        rc = dbmdb_restore_gz(path, dest, li->li_mode, task);
+        *id = dbmdb_backup_id(src_dir);
+        goto out;
+    }
+
+    /* incremental backup: restore its base then apply the changed pages */
+    fd = open(path, O_RDONLY);
+    if (fd < 0 || dbmdb_backup_read_hdr(fd, path, &hdr)) {
+        dbmdb_backup_log(task, SLAPI_LOG_ERR, "Restore: failed to read %s", path);
+        goto out;
+    }
+    if (depth >= DBMDB_BACKUP_MAX_CHAIN) {
+        dbmdb_backup_log(task, SLAPI_LOG_ERR, "Restore: more than %d incremental backups are chained to %s",
+                         DBMDB_BACKUP_MAX_CHAIN, src_dir);
+        goto out;
+    }
+    base_dir = slapi_ch_calloc(1, hdr.bh_baselen + 1);
+    if (dbmdb_backup_read(fd, base_dir, hdr.bh_baselen) != hdr.bh_baselen) {
+        dbmdb_backup_log(task, SLAPI_LOG_ERR, "Restore: failed to read %s", path);
+        goto out;
+    }
+    if (dbmdb_restore_chain(li, base_dir, dest, depth + 1, &base_id, task)) {
+        goto out;
+    }
+    if (base_id != hdr.bh_baseid) {
+        dbmdb_backup_log(task, SLAPI_LOG_ERR, "Restore: %s is not the base backup of %s", base_dir, src_dir);
+        goto out;
+    }
+    dest_fd = open(dest, O_WRONLY);
+    if (dest_fd < 0) {
+        dbmdb_backup_log(task, SLAPI_LOG_ERR, "Restore: failed to open %s (%s)", dest, strerror(errno));
+        goto out;
+    }
+    dbmdb_backup_log(task, SLAPI_LOG_INFO, "Restore: applying incremental backup %s", src_dir);
+    page = slapi_ch_malloc(hdr.bh_psize);
+    while (1) {
+        ssize_t len = dbmdb_backup_read(fd, &pgno, sizeof(pgno));
+        off_t offset = (off_t)pgno * hdr.bh_psize;
+        size_t plen;
+
+        if (len == 0) {
+            break;
+        }
+        if (len != sizeof(pgno) || offset >= hdr.bh_size) {
+            dbmdb_backup_log(task, SLAPI_LOG_ERR, "Restore: %s is truncated or corrupted", path);
+            goto out;
+        }
+        plen = hdr.bh_size - offset < hdr.bh_psize ? hdr.bh_size - offset : hdr.bh_psize;
+        if (dbmdb_backup_read(fd, page, plen) != plen) {
+            dbmdb_backup_log(task, SLAPI_LOG_ERR, "Restore: %s is truncated or corrupted", path);
+            goto out;
+        }
+        if (pwrite(dest_fd, page, plen, offset) != plen) {
+            dbmdb_backup_log(task, SLAPI_LOG_ERR, "Restore: failed to write %s (%s)", dest, strerror(errno));
+            goto out;
+        }
+    }
+    if (ftruncate(dest_fd, hdr.bh_size) || fsync(dest_fd)) {
+        dbmdb_backup_log(task, SLAPI_LOG_ERR, "Restore: failed to write %s (%s)", dest, strerror(errno));
+        goto out;
+    }
+    *id = hdr.bh_id;
+    rc = 0;
+
+out:
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (dest_fd >= 0) {
+        close(dest_fd);
+    }
+    slapi_ch_free_string(&page);
+    slapi_ch_free_string(&base_dir);
+    slapi_ch_free_string(&path);
+    return rc;
+}
+
+/* Rebuild the database file from the backup in src_dir */
+int
+dbmdb_restore_db(struct ldbminfo *li, const char *src_dir, Slapi_Task *task)
+{
+    char *dest = slapi_ch_smprintf("%s/%s", MDB_CONFIG(li)->home, DBMAPFILE);
+    uint64_t id = 0;
+    int rc = dbmdb_restore_chain(li, src_dir, dest, 0, &id, task);
+
+    if (rc) {
+        unlink(dest);
+    }
+    slapi_ch_free_string(&dest);
+    return rc;
+}
@@ -232,6 +232,7 @@ int mdb_init(struct ldbminfo *li, config_info *config_array)
     priv->dblayer_dbi_db_remove_fn = &dbmdb_public_delete_db;
     priv->dblayer_idl_new_fetch_fn = &dbmdb_idl_new_fetch;
     priv->dblayer_cursor_iterate_fn = &dbmdb_dblayer_cursor_iterate;
+    priv->dblayer_read_txn_renew_fn = &dbmdb_public_read_txn_renew;
 
     dbmdb_fake_priv = *priv; /* Copy the callbaks for dbmdb_be() */
     return 0;
@@ -521,6 +522,85 @@ dbmdb_ctx_t_db_online_import_nosync_set(void *arg, void *value, char *errorbuf _
     return retval;
 }
 
+static void *
+dbmdb_ctx_t_db_ephemeral_dir_get(void *arg)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+
+    return (void *)slapi_ch_strdup(MDB_CONFIG(li)->dsecfg.ephemeral_dir);
+}
+
+static int
+dbmdb_ctx_t_db_ephemeral_dir_set(void *arg, void *value, char *errorbuf, int phase __attribute__((unused)), int apply)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+    char *val = (char *)value;
+
+    if (val && *val && *val != '/') {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE,
+                              "Error: %s must be an absolute path.", CONFIG_MDB_EPHEMERAL_DIR);
+        return LDAP_UNWILLING_TO_PERFORM;
+    }
+    if (val && strlen(val) >= MAXPATHLEN) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE,
+                              "Error: %s is too long.", CONFIG_MDB_EPHEMERAL_DIR);
+        return LDAP_UNWILLING_TO_PERFORM;
+    }
+    if (apply) {
+        PL_strncpyz(MDB_CONFIG(li)->dsecfg.ephemeral_dir, val ? val : "", MAXPATHLEN);
+    }
+
+    return LDAP_SUCCESS;
+}
+
+static void *
+dbmdb_ctx_t_db_ephemeral_snapshot_get(void *arg)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+
+    return (void *)((uintptr_t)(MDB_CONFIG(li)->dsecfg.ephemeral_snapshot));
+}
+
+static int
+dbmdb_ctx_t_db_ephemeral_snapshot_set(void *arg, void *value, char *errorbuf __attribute__((unused)), int phase __attribute__((unused)), int apply)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+    int retval = LDAP_SUCCESS;
+    int val = (int)((uintptr_t)value);
+
+    if (apply) {
+        MDB_CONFIG(li)->dsecfg.ephemeral_snapshot = val;
+    }
+
+    return retval;
+}
+
+static void *
+dbmdb_ctx_t_db_max_txn_age_get(void *arg)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+
+    return (void *)((uintptr_t)(MDB_CONFIG(li)->dsecfg.max_txn_age));
+}
+
+static int
+dbmdb_ctx_t_db_max_txn_age_set(void *arg, void *value, char *errorbuf, int phase __attribute__((unused)), int apply)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+    int val = (int)((uintptr_t)value);
+
+    if (val < 0) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE,
+                              "Error: %s must be a positive number of seconds (or 0).", CONFIG_MDB_MAX_TXN_AGE);
+        return LDAP_UNWILLING_TO_PERFORM;
+    }
+    if (apply) {
+        MDB_CONFIG(li)->dsecfg.max_txn_age = val;
+    }
+
+    return LDAP_SUCCESS;
+}
+
 static int
 dbmdb_ctx_t_set_bypass_filter_test(void *arg,
                                    void *value,
@@ -635,6 +715,9 @@ static config_info dbmdb_ctx_t_param[] = {
     {CONFIG_DB_DURABLE_TRANSACTIONS, CONFIG_TYPE_ONOFF, "on", &dbmdb_ctx_t_db_durable_transactions_get, &dbmdb_ctx_t_db_durable_transactions_set, CONFIG_FLAG_ALWAYS_SHOW},
     {CONFIG_MDB_IMPORT_STATS, CONFIG_TYPE_ONOFF, "off", &dbmdb_ctx_t_db_import_stats_get, &dbmdb_ctx_t_db_import_stats_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
     {CONFIG_MDB_ONLINE_IMPORT_NOSYNC, CONFIG_TYPE_ONOFF, "off", &dbmdb_ctx_t_db_online_import_nosync_get, &dbmdb_ctx_t_db_online_import_nosync_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
+    {CONFIG_MDB_EPHEMERAL_DIR, CONFIG_TYPE_STRING, "", &dbmdb_ctx_t_db_ephemeral_dir_get, &dbmdb_ctx_t_db_ephemeral_dir_set, CONFIG_FLAG_ALWAYS_SHOW},
+    {CONFIG_MDB_EPHEMERAL_SNAPSHOT, CONFIG_TYPE_ONOFF, "on", &dbmdb_ctx_t_db_ephemeral_snapshot_get, &dbmdb_ctx_t_db_ephemeral_snapshot_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
+    {CONFIG_MDB_MAX_TXN_AGE, CONFIG_TYPE_INT, "10", &dbmdb_ctx_t_db_max_txn_age_get, &dbmdb_ctx_t_db_max_txn_age_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
     {CONFIG_BYPASS_FILTER_TEST, CONFIG_TYPE_STRING, "on", &dbmdb_ctx_t_get_bypass_filter_test, &dbmdb_ctx_t_set_bypass_filter_test, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
     {CONFIG_SERIAL_LOCK, CONFIG_TYPE_ONOFF, "on", &dbmdb_ctx_t_serial_lock_get, &dbmdb_ctx_t_serial_lock_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
     {CONFIG_CACHE_AUTOSIZE, CONFIG_TYPE_INT, "25", &mdb_config_cache_autosize_get, &mdb_config_cache_autosize_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
@@ -1569,6 +1569,9 @@ dbmdb_bulk_import_start(Slapi_PBlock *pb)
     /* dbmdb_instance_start will init the id2entry index and the vlv search list. */
     /* it also (finally) fills in inst_dir_name */
     ret = dbmdb_instance_start(be, DBLAYER_IMPORT_MODE);
+    if (ret != 0)
+        goto fail;
+    ret = dbmdb_reset_extvalues(be);
     if (ret != 0)
         goto fail;
 
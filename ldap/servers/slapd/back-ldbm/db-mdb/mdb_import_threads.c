@@ -1910,6 +1910,17 @@ dbmdb_import_index_prepare_worker_entry(WorkerQueueData_t *wqelmnt)
         slapi_log_err(SLAPI_LOG_ERR, "dbmdb_import_index_prepare_worker_entry",
                 "Invalid entry (Conversion failed) in database for id %d entry: %s\n",
                 id, entry_str);
+    } else {
+        int rc = id2entry_extvalues_load(wqelmnt->winfo.job->inst->inst_be, id, e, NULL);
+        if (rc) {
+            slapi_log_err(SLAPI_LOG_ERR, "dbmdb_import_index_prepare_worker_entry",
+                    "Failed to load the external values of entry %d (err %d: %s)\n",
+                    id, rc, dblayer_strerror(rc));
+            slapi_ch_free(&wqelmnt->data);
+            slapi_entry_free(e);
+            thread_abort(info);
+            return NULL;
+        }
     }
     slapi_ch_free(&wqelmnt->data);
     ep = dbmdb_import_make_backentry(e, id);
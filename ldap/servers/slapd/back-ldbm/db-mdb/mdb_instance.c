@@ -386,7 +386,7 @@ dbmdb_open_all_files(dbmdb_ctx_t *ctx, backend *be)
     dbi_txn_t *txn = NULL;
     MDB_val data = {0};
     MDB_val key = {0};
-    char *special_names[] = { ID2ENTRY, LDBM_PARENTID_STR, LDBM_ENTRYRDN_STR, LDBM_ANCESTORID_STR, BE_CHANGELOG_FILE, NULL };
+    char *special_names[] = { ID2ENTRY, LDBM_PARENTID_STR, LDBM_ENTRYRDN_STR, LDBM_ANCESTORID_STR, BE_CHANGELOG_FILE, BE_EXTVALUES_FILE, NULL };
     dbmdb_dbi_t *sn_dbis[(sizeof special_names) / sizeof special_names[0]] = {0};
     ldbm_instance *inst = be ? ((ldbm_instance *)be->be_instance_info) : NULL;
     int *valid_slots = NULL;
@@ -723,6 +723,12 @@ int dbmdb_make_env(dbmdb_ctx_t *ctx, int readOnly, mdb_mode_t mode)
                       "nsslapd-db-durable-transactions is off, "
                       "MDB_NOSYNC enabled.\n");
     }
+    if (ctx->ephemeral) {
+        /* The db is in memory and rebuilt from the suppliers if lost: never sync it */
+        flags |= MDB_NOSYNC | MDB_NOMETASYNC;
+        slapi_log_err(SLAPI_LOG_INFO, "dbmdb_make_env",
+                      "Using ephemeral database in %s, MDB_NOSYNC enabled.\n", ctx->home);
+    }
 
     rc = mdb_env_create(&env);
     ctx->env = env;
@@ -1380,6 +1386,26 @@ int dbmdb_open_cursor(dbmdb_cursor_t *dbicur, dbmdb_ctx_t *ctx, dbmdb_dbi_t *dbi
     return rc;
 }
 
+/*
+ * Renew the read txn of a cursor when it gets too old (see dbmdb_renew_txn)
+ * Returns 1 if renewed (the cursor must be positioned again), 0 if not,
+ * or an mdb error.
+ */
+int dbmdb_renew_cursor(dbmdb_cursor_t *dbicur)
+{
+    int rc = dbmdb_renew_txn(dbicur->txn);
+
+    if (rc == 1) {
+        int rc2 = MDB_CURSOR_RENEW(TXN(dbicur->txn), dbicur->cur);
+        if (rc2) {
+            slapi_log_err(SLAPI_LOG_ERR, "dbmdb_renew_cursor",
+                    "Failed to renew a cursor err=%d: %s\n", rc2, mdb_strerror(rc2));
+            rc = rc2;
+        }
+    }
+    return rc;
+}
+
 int dbmdb_close_cursor(dbmdb_cursor_t *dbicur, int rc)
 {
     if (dbicur->cur) {
@@ -1551,6 +1577,31 @@ dbmdb_reset_vlv_file(backend *be, const char *filename)
     return rc;
 }
 
+/*
+ * Empty the extvalues dbi of an instance that is being imported:
+ * dbmdb_delete_instance_dir may leave it behind, and the values it holds
+ * would be attached to whatever entries get the same IDs.
+ */
+int
+dbmdb_reset_extvalues(backend *be)
+{
+    struct ldbminfo *li = (struct ldbminfo *)(be->be_database->plg_private);
+    dbmdb_ctx_t *ctx = MDB_CONFIG(li);
+    dbmdb_dbi_t *dbi = NULL;
+    int rc = 0;
+
+    dbi = dbi_get_by_name(ctx, be, BE_EXTVALUES_FILE);
+    if (dbi) {
+        rc = dbmdb_dbi_reset(ctx, dbi);
+    }
+    if (rc) {
+        slapi_log_err(SLAPI_LOG_ERR, "dbmdb_reset_extvalues",
+                      "Failed to empty the extvalues dbi of %s (%d): %s\n",
+                      be->be_name, rc, dblayer_strerror(rc));
+    }
+    return rc;
+}
+
 dbmdb_dbi_t *
 dbmdb_get_dbi_from_slot(int dbi)
 {
@@ -80,6 +80,8 @@ static int dbmdb_force_checkpoint(struct ldbminfo *li);
 #define FLUSH_REMOTEOFF 0
 
 static const char *backupfilelists[] = { INFOFILE, DBMAPFILE, DSE_INSTANCE, DSE_INDEX, NULL };
+/* DBMAPFILE may be replaced by one of these, see mdb_backup.c */
+static const char *backupdbfilelists[] = { DBMAPFILE_GZ, DBMAPFILE_INCR, DBMAPFILE_PAGES, NULL };
 
 /*
  * if ATTRINFO_DEBUG_DELAY > 0
@@ -172,6 +174,133 @@ dbmdb_open_huge_file(const char *path, int oflag, int mode)
 
 #endif /* DB_USE_64LFS */
 
+/*
+ * Ephemeral database:
+ * When nsslapd-mdb-ephemeral-dir is set, the server opens the db env in that
+ * directory (typically on a tmpfs) without ever syncing it. It is meant for
+ * the read only replicas that are re-initialized from their suppliers: the
+ * db directory (li_directory) only holds the snapshot written at shutdown
+ * (if nsslapd-mdb-ephemeral-snapshot is on), which is also what the
+ * command line tools work on.
+ * At startup, the snapshot is copied in the ephemeral directory if it is
+ * newer than the ephemeral db (first start after a reboot, offline import
+ * or restore) - so the ephemeral db survives a crash but not a reboot.
+ */
+static const char *ephemeralfilelists[] = {DBMAPFILE, INFOFILE, NULL};
+
+static int
+dbmdb_ephemeral_mtime(const char *dir, struct timespec *mtime)
+{
+    char path[MAXPATHLEN];
+    struct stat st = {0};
+
+    PR_snprintf(path, MAXPATHLEN, "%s/%s", dir, DBMAPFILE);
+    if (stat(path, &st)) {
+        return -1;
+    }
+    *mtime = st.st_mtim;
+    return 0;
+}
+
+static int
+dbmdb_ephemeral_start(struct ldbminfo *li)
+{
+    dbmdb_ctx_t *ctx = MDB_CONFIG(li);
+    struct timespec snapmtime = {0};
+    struct timespec dbmtime = {0};
+    char *src = NULL;
+    char *dest = NULL;
+    int rc = 0;
+
+    if (!ctx->dsecfg.ephemeral_dir[0] || (li->li_flags & SLAPI_TASK_RUNNING_FROM_COMMANDLINE)) {
+        return 0;
+    }
+    PL_strncpyz(ctx->home, ctx->dsecfg.ephemeral_dir, MAXPATHLEN);
+    ctx->ephemeral = 1;
+    /* The size limits depends on the ephemeral directory file system */
+    if (dbmdb_compute_limits(li)) {
+        return -1;
+    }
+    if (dbmdb_ephemeral_mtime(li->li_directory, &snapmtime) ||
+        (dbmdb_ephemeral_mtime(ctx->home, &dbmtime) == 0 &&
+         (dbmtime.tv_sec > snapmtime.tv_sec ||
+          (dbmtime.tv_sec == snapmtime.tv_sec && dbmtime.tv_nsec >= snapmtime.tv_nsec)))) {
+        /* No snapshot or the ephemeral db is up to date */
+        return 0;
+    }
+
+    slapi_log_err(SLAPI_LOG_INFO, "dbmdb_ephemeral_start",
+                  "Loading the database snapshot from %s into %s\n", li->li_directory, ctx->home);
+    dbmdb_delete_db(li);
+    for (const char **pt = ephemeralfilelists; rc == 0 && *pt; pt++) {
+        src = slapi_ch_smprintf("%s/%s", li->li_directory, *pt);
+        dest = slapi_ch_smprintf("%s/%s", ctx->home, *pt);
+        rc = dbmdb_copyfile(src, dest, PR_TRUE, li->li_mode, NULL);
+        slapi_ch_free_string(&src);
+        slapi_ch_free_string(&dest);
+    }
+    if (rc) {
+        slapi_log_err(SLAPI_LOG_ERR, "dbmdb_ephemeral_start",
+                      "Failed to load the database snapshot in %s\n", ctx->home);
+        dbmdb_delete_db(li);
+    }
+    return rc;
+}
+
+/*
+ * Write the ephemeral db in the db directory: the compacted copy is written
+ * in a temporary file then renamed, so a crash while writing it keeps the
+ * previous snapshot. Once done, the ephemeral db gets the snapshot mtime,
+ * so the next startup does not copy it back.
+ */
+static int
+dbmdb_ephemeral_snapshot(struct ldbminfo *li, struct timespec *mtime)
+{
+    dbmdb_ctx_t *ctx = MDB_CONFIG(li);
+    char *tmppath = slapi_ch_smprintf("%s/%s.tmp", li->li_directory, DBMAPFILE);
+    char *path = slapi_ch_smprintf("%s/%s", li->li_directory, DBMAPFILE);
+    char *infosrc = slapi_ch_smprintf("%s/%s", ctx->home, INFOFILE);
+    char *infodest = slapi_ch_smprintf("%s/%s", li->li_directory, INFOFILE);
+    struct stat st = {0};
+    int rc = 0;
+    int fd = -1;
+
+    fd = open(tmppath, O_WRONLY | O_CREAT | O_TRUNC, li->li_mode);
+    if (fd < 0) {
+        rc = errno;
+    } else {
+        rc = mdb_env_copyfd2(ctx->env, fd, MDB_CP_COMPACT);
+        if (rc == 0 && fsync(fd)) {
+            rc = errno;
+        }
+        if (close(fd) && rc == 0) {
+            rc = errno;
+        }
+    }
+    if (rc == 0) {
+        rc = dbmdb_copyfile(infosrc, infodest, PR_TRUE, li->li_mode, NULL);
+    }
+    if (rc == 0 && rename(tmppath, path)) {
+        rc = errno;
+    }
+    if (rc == 0 && stat(path, &st) == 0) {
+        *mtime = st.st_mtim;
+        slapi_log_err(SLAPI_LOG_INFO, "dbmdb_ephemeral_snapshot",
+                      "Database snapshot written in %s\n", path);
+    } else {
+        slapi_log_err(SLAPI_LOG_ERR, "dbmdb_ephemeral_snapshot",
+                      "Failed to write the database snapshot in %s, err=%d: %s\n",
+                      path, rc, mdb_strerror(rc));
+        unlink(tmppath);
+        rc = rc ? rc : -1;
+    }
+    slapi_ch_free_string(&tmppath);
+    slapi_ch_free_string(&path);
+    slapi_ch_free_string(&infosrc);
+    slapi_ch_free_string(&infodest);
+    return rc;
+}
+
 /*
  * This function is called after all the config options have been read in,
  * so we can do real initialization work here.
@@ -183,7 +312,10 @@ dbmdb_start(struct ldbminfo *li, int dbmode)
     int readonly = dbmode & (DBLAYER_ARCHIVE_MODE | DBLAYER_EXPORT_MODE | DBLAYER_TEST_MODE);
     int rc;
     dblayer_init_pvt_txn();    /* Initialize thread local storage for handling dblayer txn */
-    rc = dbmdb_make_env(MDB_CONFIG(li), readonly, li->li_mode);
+    rc = dbmdb_ephemeral_start(li);
+    if (rc == 0) {
+        rc = dbmdb_make_env(MDB_CONFIG(li), readonly, li->li_mode);
+    }
     if (rc == 0) {
         /* As indexes are DUPSORT db, index key + index data are limited
          * to mdb_env_get_maxkeysize(env) and indexes data are IDs
@@ -286,6 +418,7 @@ int
 dbmdb_post_close(struct ldbminfo *li, int dbmode)
 {
     dbmdb_ctx_t *conf = 0;
+    struct timespec snapmtime = {0};
     int return_value = 0;
     PR_ASSERT(NULL != li);
     dblayer_private *priv = li->li_dblayer_private;
@@ -300,8 +433,19 @@ dbmdb_post_close(struct ldbminfo *li, int dbmode)
         dbmdb_perfctrs_terminate(conf);
     }
 
-    /* Now release the db environment */
-    dbmdb_ctx_close(conf);
+    if ((DBLAYER_NORMAL_MODE & dbmode) && conf->ephemeral && conf->dsecfg.ephemeral_snapshot &&
+        dbmdb_ephemeral_snapshot(li, &snapmtime) == 0) {
+        char path[MAXPATHLEN];
+        struct timespec times[2] = {snapmtime, snapmtime};
+
+        /* Now release the db environment before aligning its mtime on the snapshot */
+        dbmdb_ctx_close(conf);
+        PR_snprintf(path, MAXPATHLEN, "%s/%s", conf->home, DBMAPFILE);
+        (void)utimensat(AT_FDCWD, path, times, 0);
+    } else {
+        /* Now release the db environment */
+        dbmdb_ctx_close(conf);
+    }
     priv->dblayer_env = NULL;
 
     return return_value;
@@ -582,7 +726,9 @@ dbmdb_txn_begin(struct ldbminfo *li, back_txnid parent_txn, back_txn *txn, PRBoo
                 parent_txn = par_txn_txn->back_txn_txn;
             }
         }
-        return_value = START_TXN(&new_txn_back_txn_txn, parent_txn, 0);
+        /* A read txn within a snapshot txn (see dblayer_snapshot_txn_begin) reuses it */
+        return_value = START_TXN(&new_txn_back_txn_txn, parent_txn,
+                                 (!use_lock && dbmdb_is_read_only_txn_thread()) ? TXNFL_RDONLY : 0);
         return_value = dbmdb_map_error(__FUNCTION__, return_value);
         if (0 != return_value) {
             if (use_lock)
@@ -905,7 +1051,7 @@ error:
 
 /* Destination Directory is an absolute pathname */
 int
-dbmdb_backup(struct ldbminfo *li, char *dest_dir, Slapi_Task *task)
+dbmdb_backup(struct ldbminfo *li, char *dest_dir, const char *base_dir, int flags, Slapi_Task *task)
 {
     int return_value = LDAP_UNWILLING_TO_PERFORM;
     PRDirEntry *direntry = NULL;
@@ -933,7 +1079,7 @@ dbmdb_backup(struct ldbminfo *li, char *dest_dir, Slapi_Task *task)
      * What are we doing here ?
      * check that destinantion is OK
      * We want to copy into the backup directory:
-     * The mdb database
+     * The mdb database (see mdb_backup.c)
      * The info file
      */
 
@@ -963,7 +1109,7 @@ dbmdb_backup(struct ldbminfo *li, char *dest_dir, Slapi_Task *task)
         goto error_out;
     }
     /* Copy the mdb database */
-    return_value = mdb_env_copy(conf->env, dest_dir);
+    return_value = dbmdb_backup_db(li, dest_dir, base_dir, flags, task);
     if (return_value) {
         slapi_log_err(SLAPI_LOG_ERR, "dbmdb_backup", "Failed to backup mdb database to %s.\n", dest_dir);
         if (task) {
@@ -1023,6 +1169,11 @@ error_out:
         unlink(pathname2);
         slapi_ch_free_string(&pathname2);
     }
+    for (pt=backupdbfilelists; *pt; pt++) {
+        pathname2 = slapi_ch_smprintf("%s/%s", dest_dir, *pt);
+        unlink(pathname2);
+        slapi_ch_free_string(&pathname2);
+    }
     rmdir(dest_dir);
     return_value = LDAP_UNWILLING_TO_PERFORM;
 bail:
@@ -1069,6 +1220,8 @@ dbmdb_restore(struct ldbminfo *li, char *src_dir, Slapi_Task *task)
     struct stat sbuf;
     const char **pt;
     char *pathname;
+    char ephemeral_dir[MAXPATHLEN];
+    int ephemeral_snapshot = 0;
 
     PR_ASSERT(NULL != li);
     PR_ASSERT(NULL != li->li_dblayer_private);
@@ -1100,6 +1253,11 @@ dbmdb_restore(struct ldbminfo *li, char *src_dir, Slapi_Task *task)
     /* Check that all files are present and not empty */
     for (pt=backupfilelists; *pt; pt++) {
         pathname = slapi_ch_smprintf("%s/%s", src_dir, *pt);
+        if (strcmp(*pt, DBMAPFILE) == 0 && dbmdb_backup_db_file(src_dir)) {
+            /* data.mdb, data.mdb.gz or data.mdb.incr */
+            slapi_ch_free_string(&pathname);
+            continue;
+        }
         if (stat(pathname, &sbuf) < 0 || sbuf.st_size == 0) {
             slapi_log_err(SLAPI_LOG_ERR, "dbmdb_restore",
                 "Backup directory %s does not contain a complete backup.\n", src_dir);
@@ -1131,15 +1289,19 @@ dbmdb_restore(struct ldbminfo *li, char *src_dir, Slapi_Task *task)
     dbmdb_delete_db(li);
 
     /* Copy db and info files */
-    if (dbmdb_restore_file(li, task, src_dir, DBMAPFILE) ||
+    if (dbmdb_restore_db(li, src_dir, task) ||
         dbmdb_restore_file(li, task, src_dir, INFOFILE)) {
         return_value = -1;
         goto error_out;
     }
 
-    /* restart the db */
+    /* restart the db (in the ephemeral directory if the db was there) */
+    PL_strncpyz(ephemeral_dir, MDB_CONFIG(li)->ephemeral ? MDB_CONFIG(li)->dsecfg.ephemeral_dir : "", MAXPATHLEN);
+    ephemeral_snapshot = MDB_CONFIG(li)->dsecfg.ephemeral_snapshot;
     slapi_ch_free(&li->li_dblayer_config);  /* mdb_init will recreate it */
     mdb_init(li, NULL);
+    PL_strncpyz(MDB_CONFIG(li)->dsecfg.ephemeral_dir, ephemeral_dir, MAXPATHLEN);
+    MDB_CONFIG(li)->dsecfg.ephemeral_snapshot = ephemeral_snapshot;
     tmp_rval = dbmdb_start(li, dbmode);
     if (0 != tmp_rval) {
         slapi_log_err(SLAPI_LOG_ERR,
@@ -2673,6 +2835,14 @@ dbmdb_dbi_txn_abort(dbi_txn_t *txn)
     return 0;
 }
 
+/* Renew a snapshot txn (see dblayer_snapshot_txn_renew) */
+int
+dbmdb_public_read_txn_renew(backend *be __attribute__((unused)), back_txn *txn)
+{
+    int rc = dbmdb_renew_txn(txn->back_txn_txn);
+    return (rc < 0 || rc > 1) ? dbmdb_map_error(__FUNCTION__, rc) : rc;
+}
+
 int
 dbmdb_get_entries_count(dbi_db_t *db, dbi_txn_t *txn, int *count)
 {
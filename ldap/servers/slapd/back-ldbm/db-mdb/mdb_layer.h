@@ -43,6 +43,9 @@
 #define CONFIG_MDB_MAX_DBS               "nsslapd-mdb-max-dbs"
 #define CONFIG_MDB_IMPORT_STATS          "nsslapd-mdb-import-stats"
 #define CONFIG_MDB_ONLINE_IMPORT_NOSYNC  "nsslapd-mdb-online-import-nosync"
+#define CONFIG_MDB_EPHEMERAL_DIR         "nsslapd-mdb-ephemeral-dir"
+#define CONFIG_MDB_EPHEMERAL_SNAPSHOT    "nsslapd-mdb-ephemeral-snapshot"
+#define CONFIG_MDB_MAX_TXN_AGE           "nsslapd-mdb-max-txn-age"
 
 #define DBMDB_DB_MINSIZE             ( 4LL * MEGABYTE )
 #define DBMDB_DISK_RESERVE(disksize) ((disksize)*2ULL/1000ULL)
@@ -64,6 +67,9 @@
 #define DSE_INSTANCE        "dse_instance.ldif"     /* dse file in backup */
 #define DSE_INDEX           "dse_index.ldif"        /* dse file in backup */
 #define DBMAPFILE           "data.mdb"
+#define DBMAPFILE_GZ        DBMAPFILE ".gz"         /* compressed database in backup */
+#define DBMAPFILE_INCR      DBMAPFILE ".incr"       /* incremental backup */
+#define DBMAPFILE_PAGES     DBMAPFILE ".pages"      /* page digests, base of an incremental backup */
 #define INFOFILE            "INFO.mdb"
 #define DBNAMES             "__DBNAMES"
 #define CHANGELOG_PATTERN   "changelog"   /* pattern in changelog dbi name */
@@ -80,6 +86,9 @@ typedef struct
     uint64_t max_size;
     int import_stats;
     int online_import_nosync;
+    char ephemeral_dir[MAXPATHLEN];  /* memory backed db home (i.e: on tmpfs) */
+    int ephemeral_snapshot;          /* copy the ephemeral db in the db directory at shutdown */
+    int max_txn_age;                 /* seconds before renewing a long read txn (0: never) */
 } dbmdb_cfg_t;
 
 /* config parameters limits */
@@ -156,6 +165,7 @@ typedef struct {
     uint64_t nbactive;
     uint64_t nbabort;
     uint64_t nbcommit;
+    uint64_t nbrenew;
     cumuled_time_t granttime;
     cumuled_time_t lifetime;
 } dbmdb_perfctrs_txn_t;
@@ -177,6 +187,7 @@ typedef struct dbmdb_ctx_t
     MDB_dbi dbinames_dbi;          /* __DBNAMES database handler */
     MDB_env *env;
     int readonly;                  /* Tells that env is open in readonly mode */
+    int ephemeral;                 /* Tells that home is dsecfg.ephemeral_dir */
     pthread_rwlock_t dbmdb_env_lock; /* txn global lock */
     perfctrs_private *perf_private;  /* Performance counter data (shared memory) */
     dbmdb_perfctrs_txn_t perf_rotxn; /* Read Only Txn Performance counter */
@@ -290,7 +301,7 @@ int mdb_init(struct ldbminfo *li, config_info *config_array);
 int dbmdb_close(struct ldbminfo *li, int flags);
 int dbmdb_start(struct ldbminfo *li, int flags);
 int dbmdb_instance_start(backend *be, int flags);
-int dbmdb_backup(struct ldbminfo *li, char *dest_dir, Slapi_Task *task);
+int dbmdb_backup(struct ldbminfo *li, char *dest_dir, const char *base_dir, int flags, Slapi_Task *task);
 int dbmdb_verify(Slapi_PBlock *pb);
 int dbmdb_db2ldif(Slapi_PBlock *pb);
 int dbmdb_db2index(Slapi_PBlock *pb);
@@ -340,6 +351,7 @@ dblayer_private_open_fn_t dbmdb_public_private_open;
 dblayer_private_close_fn_t dbmdb_public_private_close;
 dblayer_compact_fn_t dbmdb_public_dblayer_compact;
 dblayer_clear_vlv_cache_fn_t dbmdb_public_clear_vlv_cache;
+dblayer_read_txn_renew_fn_t dbmdb_public_read_txn_renew;
 dblayer_idl_new_fetch_fn_t dbmdb_idl_new_fetch;
 
 
@@ -384,6 +396,10 @@ int dbmdb_idl_new_compare_dups(dbmdb_dbi_t * db __attribute__((unused)), const M
 int dbmdb_delete_indices(ldbm_instance *inst);
 uint32_t dbmdb_get_optimal_block_size(struct ldbminfo *li);
 int dbmdb_copyfile(char *source, char *destination, int overwrite, int mode, Slapi_Task *task);
+int dbmdb_compute_limits(struct ldbminfo *li);
+int dbmdb_backup_db(struct ldbminfo *li, const char *dest_dir, const char *base_dir, int flags, Slapi_Task *task);
+const char *dbmdb_backup_db_file(const char *src_dir);
+int dbmdb_restore_db(struct ldbminfo *li, const char *src_dir, Slapi_Task *task);
 int dbmdb_delete_instance_dir(backend *be);
 uint64_t dbmdb_database_size(struct ldbminfo *li);
 
@@ -490,6 +506,7 @@ int dbmdb_open_dbi_from_filename(dbmdb_dbi_t **dbi, backend *be, const char *fil
 int dbmdb_open_all_files(dbmdb_ctx_t *ctx, backend *be);
 dbmdb_dbi_t **dbmdb_list_dbis(dbmdb_ctx_t *ctx, backend *be, char *fname, int islocked, int *size);
 int dbmdb_open_cursor(dbmdb_cursor_t *dbicur, dbmdb_ctx_t *ctx, dbmdb_dbi_t *dbi, int flags);
+int dbmdb_renew_cursor(dbmdb_cursor_t *dbicur);
 int dbmdb_close_cursor(dbmdb_cursor_t *dbicur, int rc);
 int dbmdb_make_env(dbmdb_ctx_t *ctx, int readOnly, mdb_mode_t mode);
 void dbmdb_ctx_close(dbmdb_ctx_t *ctx);
@@ -507,6 +524,7 @@ int dbmdb_cmp_vals(MDB_val *v1, MDB_val *v2);
 dbmdb_stats_t *dbdmd_gather_stats(dbmdb_ctx_t *conf, backend *be);
 void dbmdb_free_stats(dbmdb_stats_t **stats);
 int dbmdb_reset_vlv_file(backend *be, const char *filename);
+int dbmdb_reset_extvalues(backend *be);
 bool dbmdb_is_env_open(void);
 
 /* mdb_txn.c */
@@ -515,6 +533,8 @@ int dbmdb_start_txn(const char *funcname, dbi_txn_t *parent_txn, int flags, dbi_
 int dbmdb_end_txn(const char *funcname, int rc, dbi_txn_t **txn);
 void init_mdbtxn(dbmdb_ctx_t *ctx);
 MDB_txn *dbmdb_txn(dbi_txn_t *txn);
+int dbmdb_renew_txn(dbi_txn_t *txn);
+void dbmdb_get_readers_age(dbmdb_ctx_t *ctx, uint64_t *nbreaders, uint64_t *oldest, uint64_t *nbold);
 int dbmdb_is_read_only_txn_thread(void);
 int dbmdb_has_a_txn(void);
 
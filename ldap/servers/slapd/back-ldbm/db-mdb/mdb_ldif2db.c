@@ -255,6 +255,10 @@ dbmdb_ldif2db(Slapi_PBlock *pb)
     if (ret != 0) {
         goto fail;
     }
+    ret = dbmdb_reset_extvalues(inst->inst_be);
+    if (ret != 0) {
+        goto fail;
+    }
 
     /***** done init lmdb and dblayer *****/
 
@@ -577,6 +581,8 @@ dbmdb_db2ldif(Slapi_PBlock *pb)
     int options = 0;
     int keepgoing = 1;
     int isfirst = 1;
+    int resume = 0;
+    ID resume_id;
     int appendmode = 0;
     int appendmode_1 = 0;
     int noversion = 0;
@@ -880,6 +886,17 @@ dbmdb_db2ldif(Slapi_PBlock *pb)
          * operation should just be retried).
          */
 
+        /* Do not pin an old snapshot of the db during a long online export */
+        return_value = dbmdb_renew_cursor(&cur);
+        if (return_value == 1) {
+            resume = !isfirst;
+        } else if (return_value != 0) {
+            slapi_task_log_notice(task, "Backend %s: Failed to renew the read txn, err %d\n",
+                                  inst->inst_name, return_value);
+            return_value = -1;
+            break;
+        }
+
         if (idl) {
             /* exporting from an ID list */
             if (idindex >= idl->b_nids)
@@ -907,6 +924,13 @@ dbmdb_db2ldif(Slapi_PBlock *pb)
             if (isfirst) {
                 return_value = MDB_CURSOR_GET(cur.cur,  &key, &data, MDB_FIRST);
                 isfirst = 0;
+            } else if (resume) {
+                /* The txn has been renewed: go on after the last read entry */
+                id_internal_to_stored(temp_id + 1, (char *)&resume_id);
+                key.mv_data = (char *)&resume_id;
+                key.mv_size = sizeof(resume_id);
+                return_value = MDB_CURSOR_GET(cur.cur,  &key, &data, MDB_SET_RANGE);
+                resume = 0;
             } else {
                 return_value = MDB_CURSOR_GET(cur.cur,  &key, &data, MDB_NEXT);
             }
@@ -1102,6 +1126,17 @@ dbmdb_db2ldif(Slapi_PBlock *pb)
 
         if ((ep->ep_entry) != NULL) {
             ep->ep_id = temp_id;
+            rc = id2entry_extvalues_load(be, temp_id, ep->ep_entry, NULL);
+            if (rc) {
+                slapi_task_log_notice(task, "Backend %s: Failed to load the external values of entry %lu, err %d\n",
+                        inst->inst_name, (u_long)temp_id, rc);
+                slapi_log_err(SLAPI_LOG_ERR, "dbmdb_db2ldif",
+                        "db2ldif: Backend %s: failed to load the external values of entry %lu, err %d\n",
+                        inst->inst_name, (u_long)temp_id, rc);
+                backentry_free(&ep);
+                return_value = -1;
+                goto bye;
+            }
         } else {
             slapi_log_err(SLAPI_LOG_WARNING, "dbmdb_db2ldif",
                           "Skipping badly formatted entry with id %lu\n",
@@ -1476,6 +1511,16 @@ _get_and_add_parent_rdns(backend *be,
                                            SLAPI_STR2ENTRY_NO_ENTRYDN);
         ep->ep_id = id;
         slapi_ch_free_string(&dn);
+        if (ep->ep_entry) {
+            rc = id2entry_extvalues_load(be, id, ep->ep_entry, NULL);
+            if (rc) {
+                slapi_log_err(SLAPI_LOG_ERR, "_get_and_add_parent_rdns",
+                              "%s: Failed to load the external values of "
+                              "(rdn: %s, ID: %d) (err %d: %s)\n",
+                              inst->inst_name, rdn, id, rc, dblayer_strerror(rc));
+                goto bail;
+            }
+        }
     }
 
     if (index_ext & DB2INDEX_ENTRYRDN) {
@@ -123,6 +123,8 @@ dbmdb_monitor_instance_search(Slapi_PBlock *pb __attribute__((unused)),
     MSET("currentDnCacheCount");
     sprintf(buf, "%" PRId64, cstats.maxentries);
     MSET("maxDnCacheCount");
+    ldbm_cache_autotune_monitor_instance(inst, e);
+    ldbm_cache_warmup_monitor_instance(inst, e);
 
 #ifdef DEBUG
     {
@@ -240,6 +242,7 @@ dbmdb_monitor_search(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_Entry *entryAfter,
         sprintf(buf, "%" PRIu64, count);
         MSET("currentNormalizedDnCacheCount");
     }
+    ldbm_cache_autotune_monitor(li, e);
 
     *returncode = LDAP_SUCCESS;
     return SLAPI_DSE_CALLBACK_OK;
@@ -262,6 +265,7 @@ dbmdb_dbmonitor_search(Slapi_PBlock *pb __attribute__((unused)),
     char buf[BUFSIZ];
     struct stat mapstat = {0};
     dbmdb_ctx_t *ctx;
+    uint64_t nbreaders, oldest, nbold;
 
     PR_ASSERT(NULL != arg);
     li = (struct ldbminfo *)arg;
@@ -328,6 +332,15 @@ dbmdb_dbmonitor_search(Slapi_PBlock *pb __attribute__((unused)),
     MSET("grantTimeROtxn");
     PR_snprintf(buf, sizeof(buf), "%lu", ctx->perf_rotxn.lifetime.ns/ctx->perf_rotxn.lifetime.nbsamples);
     MSET("lifeTimeROtxn");
+    PR_snprintf(buf, sizeof(buf), "%lu", ctx->perf_rotxn.nbrenew);
+    MSET("renewROtxn");
+
+    /* The read txns prevent the reuse of the pages freed after they began */
+    dbmdb_get_readers_age(ctx, &nbreaders, &oldest, &nbold);
+    PR_snprintf(buf, sizeof(buf), "%" PRIu64, oldest);
+    MSET("oldestROtxnAge");
+    PR_snprintf(buf, sizeof(buf), "%" PRIu64, nbold);
+    MSET("oldROtxn");
 
     dbmdb_free_stats(&stats);
 
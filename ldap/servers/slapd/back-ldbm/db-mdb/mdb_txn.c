@@ -27,11 +27,42 @@ typedef struct dbmdb_txn_t {
     int flags;
     struct dbmdb_txn_t *parent;
     struct timespec hr_time_start;
+    struct timespec start_time;   /* When a read txn was started or renewed (CLOCK_MONOTONIC) */
+    struct dbmdb_txn_t *rprev;    /* Active read txns list (protected by perf_lock) */
+    struct dbmdb_txn_t *rnext;
 } dbmdb_txn_t;
 
 
 static PRUintn thread_private_mdb_txn_stack;
 static dbmdb_ctx_t *g_ctx;  /* Global dbmdb context */
+static dbmdb_txn_t *g_readers;  /* Active read txns (protected by perf_lock) */
+
+/* Must be called with perf_lock held */
+static void
+link_reader(dbmdb_txn_t *txn)
+{
+    txn->rprev = NULL;
+    txn->rnext = g_readers;
+    if (g_readers) {
+        g_readers->rprev = txn;
+    }
+    g_readers = txn;
+}
+
+/* Must be called with perf_lock held */
+static void
+unlink_reader(dbmdb_txn_t *txn)
+{
+    if (txn->rprev) {
+        txn->rprev->rnext = txn->rnext;
+    } else if (g_readers == txn) {
+        g_readers = txn->rnext;
+    }
+    if (txn->rnext) {
+        txn->rnext->rprev = txn->rprev;
+    }
+    txn->rprev = txn->rnext = NULL;
+}
 
 static void
 cleanup_mdbtxn_stack(void *arg)
@@ -47,6 +78,11 @@ cleanup_mdbtxn_stack(void *arg)
     slapi_ch_free((void**)&anchor);
     while (txn) {
         txn2 = txn->parent;
+        if (txn->flags & TXNFL_RDONLY) {
+            PERF_LOCK();
+            unlink_reader(txn);
+            PERF_UNLOCK();
+        }
         if (dbmdb_is_env_open()) {
             TXN_ABORT(TXN(txn));
         }
@@ -196,6 +232,12 @@ int dbmdb_start_txn(const char *funcname, dbi_txn_t *parent_txn, int flags, dbi_
         ltxn->flags = flags;
         ltxn->parent = parent_txn;
         ltxn->hr_time_start = hr_time_now;
+        if (flags & TXNFL_RDONLY) {
+            clock_gettime(CLOCK_MONOTONIC, &ltxn->start_time);
+            PERF_LOCK();
+            link_reader(ltxn);
+            PERF_UNLOCK();
+        }
         push_mdbtxn(ltxn);
         *txn = (dbi_txn_t*)ltxn;
         dbg_log(__FILE__,__LINE__,__FUNCTION__, DBGMDB_LEVEL_TXN, "%s: dbi_txn_t=%p mdb_txn=%p\n", funcname, ltxn, mtxn);
@@ -228,6 +270,9 @@ int dbmdb_end_txn(const char *funcname, int rc, dbi_txn_t **txn)
         GET_HRTIME(&hr_time_now);
         slapi_timespec_diff(&hr_time_now, &ltxn->hr_time_start, &hr_elapsed);
         PERF_LOCK();
+        if (ltxn->flags & TXNFL_RDONLY) {
+            unlink_reader(ltxn);
+        }
         perf->nbactive--;
         if (rc || (ltxn->flags & (TXNFL_DBI|TXNFL_RDONLY)) == TXNFL_RDONLY) {
             perf->nbabort++;
@@ -244,6 +289,68 @@ int dbmdb_end_txn(const char *funcname, int rc, dbi_txn_t **txn)
     return rc;
 }
 
+/*
+ * Renew a read txn older than nsslapd-mdb-max-txn-age: it keeps its reader
+ * slot but sees the last committed data, so the pages freed since it began
+ * may be reused. The caller must be at a point where nothing read in the
+ * txn is still used (and renew the cursors opened in it).
+ * Only a txn that is not shared with a caller may be renewed.
+ * Returns 1 if the txn was renewed, 0 if not, or an mdb error (then the txn
+ * can only be ended).
+ */
+int dbmdb_renew_txn(dbi_txn_t *txn)
+{
+    dbmdb_txn_t *ltxn = (dbmdb_txn_t*)txn;
+    int max_age = g_ctx->dsecfg.max_txn_age;
+    struct timespec now;
+    int rc;
+
+    if (!ltxn || max_age <= 0 || !(ltxn->flags & TXNFL_RDONLY) || ltxn->refcnt > 1) {
+        return 0;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (now.tv_sec - ltxn->start_time.tv_sec < max_age) {
+        return 0;
+    }
+    TXN_RESET(ltxn->txn);
+    rc = TXN_RENEW(ltxn->txn);
+    if (rc) {
+        slapi_log_err(SLAPI_LOG_ERR, "dbmdb_renew_txn",
+                      "Failed to renew a read txn. err=%d %s\n", rc, mdb_strerror(rc));
+        return rc;
+    }
+    PERF_LOCK();
+    ltxn->start_time = now;
+    g_ctx->perf_rotxn.nbrenew++;
+    PERF_UNLOCK();
+    return 1;
+}
+
+/*
+ * Get the number of active read txns, the age (in seconds) of the oldest
+ * one and how many are older than nsslapd-mdb-max-txn-age.
+ */
+void dbmdb_get_readers_age(dbmdb_ctx_t *ctx, uint64_t *nbreaders, uint64_t *oldest, uint64_t *nbold)
+{
+    int max_age = ctx->dsecfg.max_txn_age;
+    struct timespec now;
+
+    *nbreaders = *oldest = *nbold = 0;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    pthread_mutex_lock(&ctx->perf_lock);
+    for (dbmdb_txn_t *txn = g_readers; txn; txn = txn->rnext) {
+        uint64_t age = now.tv_sec - txn->start_time.tv_sec;
+        (*nbreaders)++;
+        if (age > *oldest) {
+            *oldest = age;
+        }
+        if (max_age > 0 && age >= max_age) {
+            (*nbold)++;
+        }
+    }
+    pthread_mutex_unlock(&ctx->perf_lock);
+}
+
 /* Convert dbi_txn_t to MDB_txn */
 MDB_txn *dbmdb_txn(dbi_txn_t *txn)
 {
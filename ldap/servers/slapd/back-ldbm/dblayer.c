@@ -410,6 +410,19 @@ dblayer_close_changelog(backend *be)
     return return_value;
 }
 
+int
+dblayer_close_extvalues(backend *be)
+{
+    ldbm_instance *inst = (ldbm_instance *) be->be_instance_info;
+    int return_value = 0;
+
+    if (inst->inst_extvalues) {
+        return_value = dblayer_db_op(be, inst->inst_extvalues, NULL, DBI_OP_CLOSE, NULL, NULL);
+        inst->inst_extvalues = NULL;
+    }
+    return return_value;
+}
+
 int
 dblayer_erase_changelog_file(backend *be, struct attrinfo *a, PRBool use_lock, int no_force_chkpt)
 {
@@ -490,6 +503,7 @@ dblayer_instance_close(backend *be)
 
     return_value = dblayer_close_indexes(be);
     return_value |= dblayer_close_changelog(be);
+    return_value |= dblayer_close_extvalues(be);
 
     /* Now close id2entry if it's open */
     pDB = inst->inst_id2entry;
@@ -680,6 +694,42 @@ int dblayer_get_changelog(backend *be, dbi_db_t ** ppDB, int open_flags)
     return return_value;
 }
 
+/*
+ * The values of the large attributes that id2entry_add_ext stores out of
+ * the entry (see nsslapd-extvalues-threshold). Opened like the changelog.
+ */
+int
+dblayer_get_extvalues(backend *be, dbi_db_t **ppDB, int open_flags)
+{
+    ldbm_instance *inst = (ldbm_instance *) be->be_instance_info;
+    int return_value = -1;
+    dbi_db_t *pDB = NULL;
+
+    *ppDB = NULL;
+
+    if (inst->inst_extvalues) {
+        *ppDB = inst->inst_extvalues;
+        return 0;
+    }
+
+    PR_Lock(inst->inst_handle_list_mutex);
+    if (inst->inst_extvalues) {
+        /* another thread set the handle while we were waiting on the lock */
+        *ppDB = inst->inst_extvalues;
+        PR_Unlock(inst->inst_handle_list_mutex);
+        return 0;
+    }
+
+    return_value = dblayer_open_file(be, BE_EXTVALUES_FILE, open_flags, NULL, &pDB);
+    if (0 == return_value) {
+        inst->inst_extvalues = pDB;
+        *ppDB = pDB;
+    }
+    PR_Unlock(inst->inst_handle_list_mutex);
+
+    return return_value;
+}
+
 /*
  * Unlock the db lib mutex here if we need to.
  */
@@ -861,6 +911,57 @@ dblayer_txn_abort(backend *be, back_txn *txn)
     return rc;
 }
 
+/*
+ * A snapshot txn only reads: on db implementations whose txns can be
+ * renewed (lmdb), it is a real read-only txn that does not block the
+ * writers and that a long reader renews at the points where it holds no
+ * data from the db, so that it does not prevent the reuse of the freed
+ * pages. Elsewhere, it is a read txn.
+ */
+int
+dblayer_snapshot_txn_begin(backend *be, back_txn *txn)
+{
+    struct ldbminfo *li = (struct ldbminfo *)be->be_database->plg_private;
+    dblayer_private *priv = (dblayer_private *)li->li_dblayer_private;
+
+    if (priv->dblayer_read_txn_renew_fn) {
+        txn->back_txn_txn = NULL;
+        return priv->dblayer_dbi_txn_begin_fn(NULL, PR_TRUE, NULL, &txn->back_txn_txn);
+    }
+    return dblayer_read_txn_begin(be, NULL, txn);
+}
+
+int
+dblayer_snapshot_txn_commit(backend *be, back_txn *txn)
+{
+    struct ldbminfo *li = (struct ldbminfo *)be->be_database->plg_private;
+    dblayer_private *priv = (dblayer_private *)li->li_dblayer_private;
+    int rc;
+
+    if (priv->dblayer_read_txn_renew_fn) {
+        rc = priv->dblayer_dbi_txn_commit_fn(txn->back_txn_txn);
+        txn->back_txn_txn = NULL;
+        return rc;
+    }
+    return dblayer_read_txn_commit(be, txn);
+}
+
+/*
+ * Let the snapshot txn see the last committed data if it is too old.
+ * Returns 1 if renewed, 0 if not, or an error (then the txn must be committed).
+ */
+int
+dblayer_snapshot_txn_renew(backend *be, back_txn *txn)
+{
+    struct ldbminfo *li = (struct ldbminfo *)be->be_database->plg_private;
+    dblayer_private *priv = (dblayer_private *)li->li_dblayer_private;
+
+    if (priv->dblayer_read_txn_renew_fn && txn->back_txn_txn) {
+        return priv->dblayer_read_txn_renew_fn(be, txn);
+    }
+    return 0;
+}
+
 int
 dblayer_txn_begin_all(struct ldbminfo *li, back_txnid parent_txn, back_txn *txn)
 {
@@ -1230,11 +1331,11 @@ dblayer_plugin_abort(Slapi_PBlock *pb)
 
 /* Destination Directory is an absolute pathname */
 int
-dblayer_backup(struct ldbminfo *li, char *dest_dir, Slapi_Task *task)
+dblayer_backup(struct ldbminfo *li, char *dest_dir, const char *base_dir, int flags, Slapi_Task *task)
 {
     dblayer_private *priv = (dblayer_private *)li->li_dblayer_private;
 
-    return priv->dblayer_backup_fn(li, dest_dir, task);
+    return priv->dblayer_backup_fn(li, dest_dir, base_dir, flags, task);
 }
 
 
@@ -62,7 +62,7 @@
 typedef int dblayer_start_fn_t(struct ldbminfo *li, int flags);
 typedef int dblayer_close_fn_t(struct ldbminfo *li, int flags);
 typedef int dblayer_instance_start_fn_t(backend *be, int flags);
-typedef int dblayer_backup_fn_t(struct ldbminfo *li, char *dest_dir, Slapi_Task *task);
+typedef int dblayer_backup_fn_t(struct ldbminfo *li, char *dest_dir, const char *base_dir, int flags, Slapi_Task *task);
 typedef int dblayer_verify_fn_t(Slapi_PBlock *pb);
 typedef int dblayer_db_size_fn_t(Slapi_PBlock *pb);
 typedef int dblayer_ldif2db_fn_t(Slapi_PBlock *pb);
@@ -123,6 +123,7 @@ typedef int dblayer_show_stat_fn_t(const char *dbhome, FILE *fout, FILE *ferr);
 typedef int dblayer_in_import_fn_t(ldbm_instance *inst);
 typedef const char *dblayer_get_db_suffix_fn_t(void);
 typedef int dblayer_clear_vlv_cache_fn_t(backend *be, dbi_txn_t *txn, dbi_db_t *db);
+typedef int dblayer_read_txn_renew_fn_t(backend *be, back_txn *txn);
 typedef int dblayer_dbi_db_remove_fn_t(backend *be, dbi_db_t *db);
 typedef IDList *dblayer_idl_new_fetch_fn_t(backend *be, dbi_db_t *db, dbi_val_t *inkey, dbi_txn_t *txn,
                                   struct attrinfo *a, int *flag_err, int allidslimit);
@@ -212,6 +213,7 @@ struct dblayer_private
     dblayer_dbi_db_remove_fn_t *dblayer_dbi_db_remove_fn;
     dblayer_idl_new_fetch_fn_t *dblayer_idl_new_fetch_fn;
     dblayer_cursor_iterate_fn_t *dblayer_cursor_iterate_fn;
+    dblayer_read_txn_renew_fn_t *dblayer_read_txn_renew_fn; /* NULL if snapshot txns cannot be renewed */
 };
 
 #define DBLAYER_PRIV_SET_DATA_DIR 0x1
@@ -15,10 +15,807 @@
 #include "back-ldbm.h"
 #include "dblayer.h"
 
+/*
+ * Online verification (dbverify task)
+ *
+ * The offline dbverify checks the structure of the db files. The online one
+ * checks that the indexes match the entries, and fixes the differences
+ * without a full db2index when nsRepair is set:
+ *  - First the workers check the entries, by chunks of ids: each index key
+ *    generated from an entry (as when it is added) must have its id, the dn
+ *    of the entry must give its id in entryrdn and each of its ancestors must
+ *    have its id in ancestorid.
+ *  - Then the workers count the ids of the indexes, one index at a time. An
+ *    index having more ids than those found by the first pass is scanned
+ *    again: each id of a key must be an entry generating that key.
+ *
+ * Each chunk of ids and each batch of keys is read in its own snapshot txn,
+ * so the verification does not pin the db while it runs. The entries are
+ * decoded from the id2entry records without going through the entry cache,
+ * which a full scan would otherwise flush. A difference is only
+ * reported once checked again in a new txn (the write txn of the repair with
+ * nsRepair), so the entries updated meanwhile are not reported.
+ * The tombstones are not verified: they are only partially indexed.
+ *
+ * The differences are written in the report file as json lines, followed by
+ * a summary line per index.
+ */
+
+#define DBVERIFY_CHUNK_SIZE 1000   /* entries checked in a read txn */
+#define DBVERIFY_KEYS_BATCH 1000   /* index keys read in a read txn */
+#define DBVERIFY_MAX_DEPTH  10000  /* stop following parentid loops */
+#define DBVERIFY_MAX_THREADS 8
+
+typedef struct dbverify_index
+{
+    const char *name;
+    struct attrinfo *ai;   /* NULL for entryrdn */
+    uint64_t found;        /* ids found by the entry pass, except in ALLIDS keys */
+    uint64_t missing;
+    uint64_t extra;
+    uint64_t repaired;
+} dbverify_index_t;
+
+typedef struct dbverify_ctx
+{
+    backend *be;
+    ldbm_instance *inst;
+    Slapi_Task *task;
+    int repair;
+    char **only;           /* the indexes to verify, all if NULL */
+    dbverify_index_t *indexes;
+    size_t nbindexes;
+    dbverify_index_t *ancestorid;
+    dbverify_index_t *entryrdn;
+    ID nextid;
+    uint64_t next_chunk;   /* first id of the next chunk of the entry pass */
+    uint64_t next_index;   /* next index of the index pass */
+    uint64_t nbentries;
+    uint64_t errors;
+    pthread_mutex_t report_lock;
+    FILE *report;
+} dbverify_ctx_t;
+
+/* An index key generated from an entry */
+typedef struct dbverify_key
+{
+    dbverify_index_t *vi;
+    struct berval key;
+    ID id;
+} dbverify_key_t;
+
+/* The index keys of an entry, or the keys to check again */
+typedef struct dbverify_keys
+{
+    index_key_visitor_t ikv;
+    dbverify_ctx_t *ctx;
+    dbverify_index_t *only;  /* only keep the keys of this index */
+    dbverify_key_t *keys;
+    size_t nbkeys;
+    size_t maxkeys;
+} dbverify_keys_t;
+
+static void
+dbverify_keys_add(dbverify_keys_t *keys, dbverify_index_t *vi, const void *key, size_t len, ID id)
+{
+    dbverify_key_t *k;
+
+    if (keys->nbkeys == keys->maxkeys) {
+        keys->maxkeys = keys->maxkeys ? 2 * keys->maxkeys : 32;
+        keys->keys = (dbverify_key_t *)slapi_ch_realloc((char *)keys->keys, keys->maxkeys * sizeof(dbverify_key_t));
+    }
+    k = &keys->keys[keys->nbkeys++];
+    k->vi = vi;
+    k->id = id;
+    k->key.bv_len = len;
+    k->key.bv_val = slapi_ch_malloc(len ? len : 1);
+    memcpy(k->key.bv_val, key, len);
+}
+
+static void
+dbverify_keys_clear(dbverify_keys_t *keys)
+{
+    for (size_t i = 0; i < keys->nbkeys; i++) {
+        slapi_ch_free_string(&keys->keys[i].key.bv_val);
+    }
+    keys->nbkeys = 0;
+}
+
+static void
+dbverify_keys_done(dbverify_keys_t *keys)
+{
+    dbverify_keys_clear(keys);
+    slapi_ch_free((void **)&keys->keys);
+    keys->maxkeys = 0;
+}
+
+static int
+dbverify_key_cmp(const void *v1, const void *v2)
+{
+    const dbverify_key_t *k1 = (const dbverify_key_t *)v1;
+    const dbverify_key_t *k2 = (const dbverify_key_t *)v2;
+
+    if (k1->vi != k2->vi) {
+        return k1->vi < k2->vi ? -1 : 1;
+    }
+    if (k1->key.bv_len != k2->key.bv_len) {
+        return k1->key.bv_len < k2->key.bv_len ? -1 : 1;
+    }
+    return memcmp(k1->key.bv_val, k2->key.bv_val, k1->key.bv_len);
+}
+
+static dbverify_index_t *
+dbverify_get_index(dbverify_ctx_t *ctx, struct attrinfo *ai)
+{
+    for (size_t i = 0; i < ctx->nbindexes; i++) {
+        if (ctx->indexes[i].ai == ai) {
+            return &ctx->indexes[i];
+        }
+    }
+    return NULL;
+}
+
+static int
+dbverify_visit_key(index_key_visitor_t *ikv, struct attrinfo *ai, const dbi_val_t *key, ID id)
+{
+    dbverify_keys_t *keys = (dbverify_keys_t *)ikv->ikv_arg;
+    dbverify_index_t *vi = dbverify_get_index(keys->ctx, ai);
+
+    if (vi && (keys->only == NULL || keys->only == vi)) {
+        dbverify_keys_add(keys, vi, key->data, key->size, id);
+    }
+    return 0;
+}
+
+static int
+dbverify_is_tombstone(struct backentry *e)
+{
+    return slapi_entry_flag_is_set(e->ep_entry, SLAPI_ENTRY_FLAG_TOMBSTONE);
+}
+
+/*
+ * Compute the sorted index keys of an entry (in keys->only if it is set)
+ * with the indexing code, and the ancestorid keys from the parentids.
+ */
+static void
+dbverify_entry_keys(dbverify_keys_t *keys, struct backentry *e, back_txn *txn)
+{
+    dbverify_ctx_t *ctx = keys->ctx;
+    Slapi_Attr *attr = NULL;
+    char *type = NULL;
+    size_t i, j;
+    int rc;
+
+    dbverify_keys_clear(keys);
+    for (rc = slapi_entry_first_attr(e->ep_entry, &attr); rc == 0;
+         rc = slapi_entry_next_attr(e->ep_entry, attr, &attr)) {
+        slapi_attr_get_type(attr, &type);
+        if (strcasecmp(type, LDBM_ENTRYDN_STR) == 0) {
+            /* indexed in entryrdn */
+            continue;
+        }
+        (void)index_addordel_values_ext_sv(ctx->be, type, attr_get_present_values(attr), NULL, e->ep_id,
+                                           BE_INDEX_ADD | BE_INDEX_VISIT_KEYS, txn, NULL, &keys->ikv);
+    }
+
+    if (ctx->ancestorid && (keys->only == NULL || keys->only == ctx->ancestorid)) {
+        ID pid = (ID)slapi_entry_attr_get_ulong(e->ep_entry, LDBM_PARENTID_STR);
+
+        for (int depth = 0; pid != 0 && depth < DBVERIFY_MAX_DEPTH; depth++) {
+            struct backentry *parent;
+            char keybuf[24];
+            int err = 0;
+
+            dbverify_keys_add(keys, ctx->ancestorid, keybuf,
+                              PR_snprintf(keybuf, sizeof(keybuf), "%c%lu", EQ_PREFIX, (u_long)pid) + 1, e->ep_id);
+            parent = id2entry_nocache(ctx->be, pid, txn, &err);
+            if (parent == NULL) {
+                break;
+            }
+            pid = (ID)slapi_entry_attr_get_ulong(parent->ep_entry, LDBM_PARENTID_STR);
+            backentry_free(&parent);
+        }
+    }
+
+    /* the same key may be generated by several values or subtypes */
+    qsort(keys->keys, keys->nbkeys, sizeof(dbverify_key_t), dbverify_key_cmp);
+    for (i = 0, j = 0; i < keys->nbkeys; i++) {
+        if (j > 0 && dbverify_key_cmp(&keys->keys[j - 1], &keys->keys[i]) == 0) {
+            slapi_ch_free_string(&keys->keys[i].key.bv_val);
+        } else {
+            keys->keys[j++] = keys->keys[i];
+        }
+    }
+    keys->nbkeys = j;
+}
+
+/* Tells whether the entry generates the key of the index vi */
+static int
+dbverify_entry_has_key(dbverify_keys_t *keys, struct backentry *e, back_txn *txn, dbverify_index_t *vi, struct berval *key)
+{
+    dbverify_key_t k = {vi, *key, e->ep_id};
+    int found;
+
+    keys->only = vi;
+    dbverify_entry_keys(keys, e, txn);
+    keys->only = NULL;
+    found = (bsearch(&k, keys->keys, keys->nbkeys, sizeof(dbverify_key_t), dbverify_key_cmp) != NULL);
+    dbverify_keys_clear(keys);
+    return found;
+}
+
+/*
+ * Tells whether the key of the index has the id: returns 1 if it has it,
+ * 0 if it has not and -1 on error. *allids is set if the key is ALLIDS.
+ */
+static int
+dbverify_key_has_id(backend *be, struct attrinfo *ai, struct berval *bkey, ID id, back_txn *txn, int *allids)
+{
+    dbi_db_t *db = NULL;
+    dbi_val_t key = {0};
+    IDList *idl = NULL;
+    int err = 0;
+    int rc;
+
+    *allids = 0;
+    if (dblayer_get_index_file(be, ai, &db, DBOPEN_CREATE) != 0) {
+        return -1;
+    }
+    dblayer_value_set_buffer(be, &key, bkey->bv_val, bkey->bv_len);
+    idl = idl_fetch(be, db, &key, txn->back_txn_txn, ai, &err);
+    if (err != 0 && err != DBI_RC_NOTFOUND) {
+        rc = -1;
+    } else if (idl && ALLIDS(idl)) {
+        *allids = 1;
+        rc = 1;
+    } else {
+        rc = idl_id_is_in_idlist(idl, id);
+    }
+    idl_free(&idl);
+    dblayer_release_index_file(be, ai, db);
+    return rc;
+}
+
+static void
+dbverify_json_string(FILE *fp, const char *val, size_t len)
+{
+    fputc('"', fp);
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)val[i];
+
+        if (c == '"' || c == '\\') {
+            fprintf(fp, "\\%c", c);
+        } else if (c < 0x20 || c >= 0x7f) {
+            fprintf(fp, "\\u%04x", c);
+        } else {
+            fputc(c, fp);
+        }
+    }
+    fputc('"', fp);
+}
+
+static void
+dbverify_report(dbverify_ctx_t *ctx, dbverify_index_t *vi, struct berval *key, const char *dn, ID id, const char *status, int repaired)
+{
+    pthread_mutex_lock(&ctx->report_lock);
+    if (ctx->report) {
+        fprintf(ctx->report, "{\"backend\": ");
+        dbverify_json_string(ctx->report, ctx->inst->inst_name, strlen(ctx->inst->inst_name));
+        fprintf(ctx->report, ", \"index\": ");
+        dbverify_json_string(ctx->report, vi->name, strlen(vi->name));
+        if (key) {
+            /* the trailing \0 is not a part of the value */
+            size_t len = key->bv_len;
+            if (len > 0 && key->bv_val[len - 1] == '\0') {
+                len--;
+            }
+            fprintf(ctx->report, ", \"key\": ");
+            dbverify_json_string(ctx->report, key->bv_val, len);
+        }
+        if (dn) {
+            fprintf(ctx->report, ", \"dn\": ");
+            dbverify_json_string(ctx->report, dn, strlen(dn));
+        }
+        fprintf(ctx->report, ", \"id\": %lu, \"status\": \"%s\", \"repaired\": %s}\n",
+                (u_long)id, status, repaired ? "true" : "false");
+    }
+    pthread_mutex_unlock(&ctx->report_lock);
+}
+
+static int
+dbverify_txn_begin(dbverify_ctx_t *ctx, back_txn *txn)
+{
+    memset(txn, 0, sizeof(*txn));
+    if (ctx->repair) {
+        return dblayer_txn_begin(ctx->be, NULL, txn);
+    }
+    return dblayer_snapshot_txn_begin(ctx->be, txn);
+}
+
+static void
+dbverify_txn_end(dbverify_ctx_t *ctx, back_txn *txn, int commit)
+{
+    if (!ctx->repair) {
+        dblayer_snapshot_txn_commit(ctx->be, txn);
+    } else if (commit) {
+        dblayer_txn_commit(ctx->be, txn);
+    } else {
+        dblayer_txn_abort(ctx->be, txn);
+    }
+}
+
+/*
+ * Check again a key missing in (or extra in) an index, in a new txn, and
+ * repair it if requested.
+ */
+static void
+dbverify_confirm_key(dbverify_ctx_t *ctx, dbverify_keys_t *keys, dbverify_key_t *k, int missing)
+{
+    struct backentry *e = NULL;
+    back_txn txn;
+    int expected = 0;
+    int allids = 0;
+    int repaired = 0;
+    int has_id;
+    int err = 0;
+    int rc;
+
+    if (dbverify_txn_begin(ctx, &txn)) {
+        slapi_atomic_incr_64(&ctx->errors, __ATOMIC_RELAXED);
+        return;
+    }
+    e = id2entry_nocache(ctx->be, k->id, &txn, &err);
+    if (e && dbverify_is_tombstone(e)) {
+        backentry_free(&e);
+        dbverify_txn_end(ctx, &txn, 0);
+        return;
+    }
+    if (e) {
+        expected = dbverify_entry_has_key(keys, e, &txn, k->vi, &k->key);
+        backentry_free(&e);
+    }
+    has_id = dbverify_key_has_id(ctx->be, k->vi->ai, &k->key, k->id, &txn, &allids);
+    if (has_id < 0 || allids || has_id == expected || expected != missing) {
+        /* not a difference any more */
+        dbverify_txn_end(ctx, &txn, 0);
+        return;
+    }
+
+    if (ctx->repair) {
+        dbi_db_t *db = NULL;
+        dbi_val_t key = {0};
+
+        rc = dblayer_get_index_file(ctx->be, k->vi->ai, &db, DBOPEN_CREATE);
+        if (rc == 0) {
+            dblayer_value_set_buffer(ctx->be, &key, k->key.bv_val, k->key.bv_len);
+            if (missing) {
+                rc = idl_insert_key(ctx->be, db, &key, k->id, &txn, k->vi->ai, NULL);
+            } else {
+                rc = idl_delete_key(ctx->be, db, &key, k->id, &txn, k->vi->ai);
+            }
+            dblayer_release_index_file(ctx->be, k->vi->ai, db);
+        }
+        repaired = (rc == 0);
+        if (repaired) {
+            slapi_atomic_incr_64(&k->vi->repaired, __ATOMIC_RELAXED);
+            if (missing) {
+                slapi_atomic_incr_64(&k->vi->found, __ATOMIC_RELAXED);
+            }
+        }
+    }
+    dbverify_txn_end(ctx, &txn, repaired);
+    slapi_atomic_incr_64(missing ? &k->vi->missing : &k->vi->extra, __ATOMIC_RELAXED);
+    dbverify_report(ctx, k->vi, &k->key, NULL, k->id, missing ? "missing" : "extra", repaired);
+}
+
+/* Check again an entry whose dn does not give its id in entryrdn */
+static void
+dbverify_confirm_entryrdn(dbverify_ctx_t *ctx, ID id)
+{
+    struct backentry *e = NULL;
+    back_txn txn;
+    ID rid = NOID;
+    int repaired = 0;
+    int err = 0;
+
+    if (dbverify_txn_begin(ctx, &txn)) {
+        slapi_atomic_incr_64(&ctx->errors, __ATOMIC_RELAXED);
+        return;
+    }
+    e = id2entry_nocache(ctx->be, id, &txn, &err);
+    if (e == NULL || dbverify_is_tombstone(e) ||
+        (entryrdn_index_read(ctx->be, slapi_entry_get_sdn_const(e->ep_entry), &rid, &txn) == 0 && rid == id)) {
+        if (e) {
+            backentry_free(&e);
+        }
+        dbverify_txn_end(ctx, &txn, 0);
+        return;
+    }
+    if (ctx->repair && entryrdn_index_entry(ctx->be, e, BE_INDEX_ADD, &txn) == 0) {
+        repaired = 1;
+        slapi_atomic_incr_64(&ctx->entryrdn->repaired, __ATOMIC_RELAXED);
+    }
+    dbverify_txn_end(ctx, &txn, repaired);
+    slapi_atomic_incr_64(&ctx->entryrdn->missing, __ATOMIC_RELAXED);
+    dbverify_report(ctx, ctx->entryrdn, NULL, slapi_entry_get_dn_const(e->ep_entry), id, "missing", repaired);
+    backentry_free(&e);
+}
+
+/* Entry pass: the keys of each entry must have its id */
+static void
+dbverify_entries_worker(void *arg)
+{
+    dbverify_ctx_t *ctx = (dbverify_ctx_t *)arg;
+    dbverify_keys_t keys = {{dbverify_visit_key, &keys}, ctx, NULL, NULL, 0, 0};
+    dbverify_keys_t suspects = {{dbverify_visit_key, &suspects}, ctx, NULL, NULL, 0, 0};
+    ID *badrdns = NULL;
+    size_t nbbadrdns = 0;
+    uint64_t first;
+
+    while ((first = slapi_atomic_add_64(&ctx->next_chunk, DBVERIFY_CHUNK_SIZE, __ATOMIC_RELAXED) - DBVERIFY_CHUNK_SIZE) < ctx->nextid &&
+           !slapi_is_shutting_down()) {
+        ID last = (first + DBVERIFY_CHUNK_SIZE < ctx->nextid) ? first + DBVERIFY_CHUNK_SIZE : ctx->nextid;
+        back_txn txn = {0};
+
+        if (dblayer_snapshot_txn_begin(ctx->be, &txn)) {
+            slapi_atomic_incr_64(&ctx->errors, __ATOMIC_RELAXED);
+            continue;
+        }
+        for (ID id = first ? first : 1; id < last; id++) {
+            struct backentry *e;
+            int err = 0;
+
+            e = id2entry_nocache(ctx->be, id, &txn, &err);
+            if (e == NULL) {
+                continue;
+            }
+            if (dbverify_is_tombstone(e)) {
+                backentry_free(&e);
+                continue;
+            }
+            slapi_atomic_incr_64(&ctx->nbentries, __ATOMIC_RELAXED);
+            dbverify_entry_keys(&keys, e, &txn);
+            for (size_t i = 0; i < keys.nbkeys; i++) {
+                dbverify_key_t *k = &keys.keys[i];
+                int allids = 0;
+                int rc = dbverify_key_has_id(ctx->be, k->vi->ai, &k->key, id, &txn, &allids);
+
+                if (rc < 0) {
+                    slapi_atomic_incr_64(&ctx->errors, __ATOMIC_RELAXED);
+                } else if (rc == 0) {
+                    dbverify_keys_add(&suspects, k->vi, k->key.bv_val, k->key.bv_len, id);
+                } else if (!allids) {
+                    slapi_atomic_incr_64(&k->vi->found, __ATOMIC_RELAXED);
+                }
+            }
+            dbverify_keys_clear(&keys);
+            if (ctx->entryrdn) {
+                ID rid = NOID;
+
+                if (entryrdn_index_read(ctx->be, slapi_entry_get_sdn_const(e->ep_entry), &rid, &txn) || rid != id) {
+                    badrdns = (ID *)slapi_ch_realloc((char *)badrdns, (nbbadrdns + 1) * sizeof(ID));
+                    badrdns[nbbadrdns++] = id;
+                }
+            }
+            backentry_free(&e);
+        }
+        dblayer_snapshot_txn_commit(ctx->be, &txn);
+
+        for (size_t i = 0; i < suspects.nbkeys; i++) {
+            dbverify_confirm_key(ctx, &keys, &suspects.keys[i], 1);
+        }
+        dbverify_keys_clear(&suspects);
+        for (size_t i = 0; i < nbbadrdns; i++) {
+            dbverify_confirm_entryrdn(ctx, badrdns[i]);
+        }
+        nbbadrdns = 0;
+    }
+    slapi_ch_free((void **)&badrdns);
+    dbverify_keys_done(&keys);
+    dbverify_keys_done(&suspects);
+}
+
+/*
+ * Read the keys of an index, by batches in their own read txn. Returns the
+ * number of ids of the index (except in ALLIDS keys). If check is set, the
+ * ids whose entry does not generate the key are checked again.
+ */
+static uint64_t
+dbverify_scan_index(dbverify_ctx_t *ctx, dbverify_index_t *vi, int check)
+{
+    dbverify_keys_t keys = {{dbverify_visit_key, &keys}, ctx, NULL, NULL, 0, 0};
+    dbverify_keys_t suspects = {{dbverify_visit_key, &suspects}, ctx, NULL, NULL, 0, 0};
+    struct berval lastkey = {0};
+    uint64_t nbids = 0;
+    dbi_db_t *db = NULL;
+    int rc = 0;
+
+    if (dblayer_get_index_file(ctx->be, vi->ai, &db, DBOPEN_CREATE) != 0) {
+        slapi_atomic_incr_64(&ctx->errors, __ATOMIC_RELAXED);
+        return 0;
+    }
+    while (rc == 0 && !slapi_is_shutting_down()) {
+        back_txn txn = {0};
+        dbi_cursor_t cursor = {0};
+        dbi_val_t key = {0};
+        dbi_val_t data = {0};
+
+        if (dblayer_snapshot_txn_begin(ctx->be, &txn) ||
+            dblayer_new_cursor(ctx->be, db, txn.back_txn_txn, &cursor)) {
+            slapi_atomic_incr_64(&ctx->errors, __ATOMIC_RELAXED);
+            if (txn.back_txn_txn) {
+                dblayer_snapshot_txn_commit(ctx->be, &txn);
+            }
+            break;
+        }
+        dblayer_value_init(ctx->be, &key);
+        dblayer_value_init(ctx->be, &data);
+        if (lastkey.bv_val) {
+            /* resume after the last key of the previous batch */
+            char *buf = slapi_ch_malloc(lastkey.bv_len);
+            memcpy(buf, lastkey.bv_val, lastkey.bv_len);
+            dblayer_value_set(ctx->be, &key, buf, lastkey.bv_len);
+            rc = dblayer_cursor_op(&cursor, DBI_OP_MOVE_NEAR_KEY, &key, &data);
+            if (rc == 0 && key.size == lastkey.bv_len && memcmp(key.data, lastkey.bv_val, key.size) == 0) {
+                rc = dblayer_cursor_op(&cursor, DBI_OP_NEXT_KEY, &key, &data);
+            }
+        } else {
+            rc = dblayer_cursor_op(&cursor, DBI_OP_MOVE_TO_FIRST, &key, &data);
+        }
+        for (size_t n = 0; rc == 0 && n < DBVERIFY_KEYS_BATCH; n++) {
+            slapi_ch_free_string(&lastkey.bv_val);
+            lastkey.bv_len = key.size;
+            lastkey.bv_val = slapi_ch_malloc(key.size ? key.size : 1);
+            memcpy(lastkey.bv_val, key.data, key.size);
+
+            if (key.size > 0 && *(char *)key.data != CONT_PREFIX) {
+                dbi_val_t idlkey = {0};
+                IDList *idl = NULL;
+                int err = 0;
+
+                dblayer_value_set_buffer(ctx->be, &idlkey, lastkey.bv_val, lastkey.bv_len);
+                idl = idl_fetch(ctx->be, db, &idlkey, txn.back_txn_txn, vi->ai, &err);
+                if (err != 0 && err != DBI_RC_NOTFOUND) {
+                    slapi_atomic_incr_64(&ctx->errors, __ATOMIC_RELAXED);
+                } else if (idl && !ALLIDS(idl)) {
+                    nbids += idl->b_nids;
+                    for (NIDS i = 0; check && i < idl->b_nids; i++) {
+                        struct backentry *e = id2entry_nocache(ctx->be, idl->b_ids[i], &txn, &err);
+
+                        if (e == NULL || (!dbverify_is_tombstone(e) &&
+                                          !dbverify_entry_has_key(&keys, e, &txn, vi, &lastkey))) {
+                            dbverify_keys_add(&suspects, vi, lastkey.bv_val, lastkey.bv_len, idl->b_ids[i]);
+                        }
+                        if (e) {
+                            backentry_free(&e);
+                        }
+                    }
+                }
+                idl_free(&idl);
+            }
+            rc = dblayer_cursor_op(&cursor, DBI_OP_NEXT_KEY, &key, &data);
+        }
+        dblayer_cursor_op(&cursor, DBI_OP_CLOSE, NULL, NULL);
+        dblayer_value_free(ctx->be, &key);
+        dblayer_value_free(ctx->be, &data);
+        dblayer_snapshot_txn_commit(ctx->be, &txn);
+
+        for (size_t i = 0; i < suspects.nbkeys; i++) {
+            dbverify_confirm_key(ctx, &keys, &suspects.keys[i], 0);
+        }
+        dbverify_keys_clear(&suspects);
+    }
+    if (rc != 0 && rc != DBI_RC_NOTFOUND) {
+        slapi_atomic_incr_64(&ctx->errors, __ATOMIC_RELAXED);
+    }
+    slapi_ch_free_string(&lastkey.bv_val);
+    dblayer_release_index_file(ctx->be, vi->ai, db);
+    dbverify_keys_done(&keys);
+    dbverify_keys_done(&suspects);
+    return nbids;
+}
+
+/* Index pass: the ids of each key must be entries generating that key */
+static void
+dbverify_indexes_worker(void *arg)
+{
+    dbverify_ctx_t *ctx = (dbverify_ctx_t *)arg;
+    uint64_t i;
+
+    while ((i = slapi_atomic_incr_64(&ctx->next_index, __ATOMIC_RELAXED) - 1) < ctx->nbindexes &&
+           !slapi_is_shutting_down()) {
+        dbverify_index_t *vi = &ctx->indexes[i];
+
+        if (vi->ai == NULL) {
+            /* entryrdn is only checked by the entry pass */
+            continue;
+        }
+        if (dbverify_scan_index(ctx, vi, 0) > slapi_atomic_load_64(&vi->found, __ATOMIC_RELAXED)) {
+            slapi_log_err(SLAPI_LOG_INFO, "dbverify_indexes_worker",
+                          "%s: index %s has more ids than expected, checking its keys\n",
+                          ctx->inst->inst_name, vi->name);
+            dbverify_scan_index(ctx, vi, 1);
+        }
+    }
+}
+
+/* Count (while ctx->indexes is NULL), then set the attribute indexes to verify */
+static int
+dbverify_add_index(caddr_t node, caddr_t arg)
+{
+    struct attrinfo *ai = (struct attrinfo *)node;
+    dbverify_ctx_t *ctx = (dbverify_ctx_t *)arg;
+
+    if (!IS_INDEXED(ai->ai_indexmask) || (ai->ai_indexmask & INDEX_OFFLINE) ||
+        (ai->ai_indexmask & INDEX_ANY) == INDEX_VLV ||
+        strcasecmp(ai->ai_type, LDBM_ENTRYDN_STR) == 0 ||
+        strcasecmp(ai->ai_type, LDBM_ENTRYRDN_STR) == 0 ||
+        (ctx->only && !charray_inlist(ctx->only, ai->ai_type))) {
+        return 0;
+    }
+    if (ctx->indexes) {
+        dbverify_index_t *vi = &ctx->indexes[ctx->nbindexes];
+
+        vi->name = ai->ai_type;
+        vi->ai = ai;
+        if (strcasecmp(ai->ai_type, LDBM_ANCESTORID_STR) == 0) {
+            ctx->ancestorid = vi;
+        }
+    }
+    ctx->nbindexes++;
+    return 0;
+}
+
+static void
+dbverify_run_workers(dbverify_ctx_t *ctx, void (*worker)(void *), int nbthreads)
+{
+    PRThread **threads = (PRThread **)slapi_ch_calloc(nbthreads, sizeof(PRThread *));
+
+    for (int i = 0; i < nbthreads; i++) {
+        threads[i] = PR_CreateThread(PR_USER_THREAD, worker, ctx, PR_PRIORITY_NORMAL,
+                                     PR_GLOBAL_THREAD, PR_JOINABLE_THREAD, SLAPD_DEFAULT_THREAD_STACKSIZE);
+        if (threads[i] == NULL) {
+            slapi_log_err(SLAPI_LOG_WARNING, "dbverify_run_workers",
+                          "Unable to create a dbverify thread, running with %d threads\n", i);
+            break;
+        }
+    }
+    if (threads[0] == NULL) {
+        worker(ctx);
+    }
+    for (int i = 0; i < nbthreads && threads[i]; i++) {
+        PR_JoinThread(threads[i]);
+    }
+    slapi_ch_free((void **)&threads);
+}
+
+/* Verify the indexes against the entries while the server is running */
+static int
+ldbm_back_dbverify_online(Slapi_PBlock *pb)
+{
+    dbverify_ctx_t ctx = {0};
+    backend *be = NULL;
+    char *report = NULL;
+    char *reportfile = NULL;
+    int dbverify_flags = 0;
+    uint64_t missing = 0;
+    uint64_t extra = 0;
+    uint64_t repaired = 0;
+    int nbthreads;
+    int rc = 0;
+
+    slapi_pblock_get(pb, SLAPI_BACKEND, &be);
+    slapi_pblock_get(pb, SLAPI_BACKEND_TASK, &ctx.task);
+    slapi_pblock_get(pb, SLAPI_DB2INDEX_ATTRS, &ctx.only);
+    slapi_pblock_get(pb, SLAPI_DBVERIFY_FLAGS, &dbverify_flags);
+    slapi_pblock_get(pb, SLAPI_SEQ_VAL, &report);
+    if (be == NULL) {
+        slapi_task_log_notice(ctx.task, "No backend to verify");
+        return -1;
+    }
+    ctx.be = be;
+    ctx.inst = (ldbm_instance *)be->be_instance_info;
+    ctx.repair = (dbverify_flags & SLAPI_DBVERIFY_REPAIR);
+
+    if (instance_set_busy(ctx.inst) != 0) {
+        slapi_task_log_notice(ctx.task, "Backend %s is busy with another task", ctx.inst->inst_name);
+        slapi_log_err(SLAPI_LOG_ERR, "ldbm_back_dbverify_online",
+                      "Backend %s is busy with another task\n", ctx.inst->inst_name);
+        return -1;
+    }
+
+    if (report && *report) {
+        reportfile = slapi_ch_strdup(report);
+    } else {
+        char *ldifdir = config_get_ldifdir();
+        reportfile = slapi_ch_smprintf("%s/%s-dbverify-%ld.json", ldifdir ? ldifdir : ".",
+                                       ctx.inst->inst_name, (long)slapi_current_utc_time());
+        slapi_ch_free_string(&ldifdir);
+    }
+    ctx.report = fopen(reportfile, "w");
+    if (ctx.report == NULL) {
+        slapi_task_log_notice(ctx.task, "Unable to open the report file %s: %s", reportfile, strerror(errno));
+        slapi_log_err(SLAPI_LOG_ERR, "ldbm_back_dbverify_online",
+                      "Unable to open the report file %s: %s\n", reportfile, strerror(errno));
+        slapi_ch_free_string(&reportfile);
+        instance_set_not_busy(ctx.inst);
+        return -1;
+    }
+    pthread_mutex_init(&ctx.report_lock, NULL);
+
+    /* entryrdn first, then the attribute indexes */
+    avl_apply(ctx.inst->inst_attrs, dbverify_add_index, (caddr_t)&ctx, -1, AVL_INORDER);
+    ctx.indexes = (dbverify_index_t *)slapi_ch_calloc(ctx.nbindexes + 1, sizeof(dbverify_index_t));
+    ctx.nbindexes = 0;
+    if (ctx.only == NULL || charray_inlist(ctx.only, LDBM_ENTRYRDN_STR)) {
+        ctx.entryrdn = &ctx.indexes[ctx.nbindexes++];
+        ctx.entryrdn->name = LDBM_ENTRYRDN_STR;
+    }
+    avl_apply(ctx.inst->inst_attrs, dbverify_add_index, (caddr_t)&ctx, -1, AVL_INORDER);
+    PR_Lock(ctx.inst->inst_nextid_mutex);
+    ctx.nextid = ctx.inst->inst_nextid;
+    PR_Unlock(ctx.inst->inst_nextid_mutex);
+
+    nbthreads = util_get_capped_hardware_threads(1, DBVERIFY_MAX_THREADS);
+    slapi_task_log_notice(ctx.task, "%s: verifying %lu indexes with %d threads%s",
+                          ctx.inst->inst_name, (u_long)ctx.nbindexes, nbthreads,
+                          ctx.repair ? " (repair mode)" : "");
+    slapi_log_err(SLAPI_LOG_INFO, "ldbm_back_dbverify_online", "%s: verifying %lu indexes with %d threads%s\n",
+                  ctx.inst->inst_name, (u_long)ctx.nbindexes, nbthreads, ctx.repair ? " (repair mode)" : "");
+
+    dbverify_run_workers(&ctx, dbverify_entries_worker, nbthreads);
+    slapi_task_log_notice(ctx.task, "%s: %lu entries verified, verifying the index keys",
+                          ctx.inst->inst_name, (u_long)ctx.nbentries);
+    dbverify_run_workers(&ctx, dbverify_indexes_worker, nbthreads);
+
+    for (size_t i = 0; i < ctx.nbindexes; i++) {
+        dbverify_index_t *vi = &ctx.indexes[i];
+
+        fprintf(ctx.report, "{\"backend\": ");
+        dbverify_json_string(ctx.report, ctx.inst->inst_name, strlen(ctx.inst->inst_name));
+        fprintf(ctx.report, ", \"index\": ");
+        dbverify_json_string(ctx.report, vi->name, strlen(vi->name));
+        fprintf(ctx.report, ", \"summary\": {\"missing\": %" PRIu64 ", \"extra\": %" PRIu64 ", \"repaired\": %" PRIu64 "}}\n",
+                vi->missing, vi->extra, vi->repaired);
+        missing += vi->missing;
+        extra += vi->extra;
+        repaired += vi->repaired;
+    }
+    fclose(ctx.report);
+    pthread_mutex_destroy(&ctx.report_lock);
+
+    if (slapi_is_shutting_down()) {
+        slapi_task_log_notice(ctx.task, "%s: verification interrupted by the shutdown", ctx.inst->inst_name);
+        rc = -1;
+    } else if (ctx.errors || missing + extra > repaired) {
+        rc = -1;
+    }
+    slapi_task_log_notice(ctx.task, "%s: %lu entries verified, %" PRIu64 " missing and %" PRIu64 " extra index ids "
+                                    "(%" PRIu64 " repaired), %" PRIu64 " errors. Report written in %s",
+                          ctx.inst->inst_name, (u_long)ctx.nbentries, missing, extra, repaired, ctx.errors, reportfile);
+    slapi_log_err(rc ? SLAPI_LOG_WARNING : SLAPI_LOG_INFO, "ldbm_back_dbverify_online",
+                  "%s: %lu entries verified, %" PRIu64 " missing and %" PRIu64 " extra index ids "
+                  "(%" PRIu64 " repaired), %" PRIu64 " errors. Report written in %s\n",
+                  ctx.inst->inst_name, (u_long)ctx.nbentries, missing, extra, repaired, ctx.errors, reportfile);
+
+    slapi_ch_free((void **)&ctx.indexes);
+    slapi_ch_free_string(&reportfile);
+    instance_set_not_busy(ctx.inst);
+    return rc;
+}
+
 int
 ldbm_back_dbverify(Slapi_PBlock *pb)
 {
     struct ldbminfo *li = NULL;
+    int task_flags = 0;
+
+    slapi_pblock_get(pb, SLAPI_TASK_FLAGS, &task_flags);
+    if (task_flags & SLAPI_TASK_RUNNING_AS_TASK) {
+        /* the server is running: verify the indexes against the entries */
+        return ldbm_back_dbverify_online(pb);
+    }
+
     slapi_pblock_get(pb, SLAPI_PLUGIN_PRIVATE, &li);
     dblayer_setup(li);
     dblayer_private *priv = (dblayer_private *)li->li_dblayer_private;
@@ -17,13 +17,542 @@
 
 #define ID2ENTRY "id2entry"
 
+/*
+ * External valuesets
+ *
+ * The present values of an attribute listed in nsslapd-extvalues-attrs,
+ * when it has at least nsslapd-extvalues-threshold of them, are not kept
+ * in the id2entry record but in the extvalues file, one record per value:
+ *
+ *     key:  stored ID | lowercase type | '\0' | normalized value
+ *     data: csnset of the value (";vucsn-...") | '\0' | value
+ *
+ * The id2entry record names the attribute in an LDBM_EXTVALUES_STR value
+ * and id2entry_extvalues_load() puts the values back. Rewriting the entry
+ * only writes the records of the values that were added or changed, and
+ * deletes those of the values that are gone. They are found by comparing
+ * the entry with the one it replaces, whose external types are kept in
+ * ep_extvalues, or else by reading the records of the entry.
+ *
+ * Only the attributes without deleted values nor deletion csn are stored
+ * that way, their state is then entirely carried by their values.
+ */
+typedef struct extvalue
+{
+    char *key;
+    size_t keylen;
+    char *data;
+    size_t datalen;
+    int stored; /* the same record is already in the file */
+} extvalue_t;
+
+typedef struct extvalues
+{
+    extvalue_t *vals;
+    size_t num;
+    size_t max;
+} extvalues_t;
+
+#define EXTVALUE_CSN_SIZE (1 + LDIF_CSNPREFIX_MAXLENGTH + _CSN_VALIDCSN_STRLEN)
+
+static int
+extvalue_cmp(const void *v1, const void *v2)
+{
+    const extvalue_t *e1 = (const extvalue_t *)v1;
+    const extvalue_t *e2 = (const extvalue_t *)v2;
+    int rc = memcmp(e1->key, e2->key, e1->keylen < e2->keylen ? e1->keylen : e2->keylen);
+
+    if (rc == 0) {
+        rc = (e1->keylen > e2->keylen) - (e1->keylen < e2->keylen);
+    }
+    return rc;
+}
+
+/* compare a key read from the file with an extvalue_t key */
+static int
+extvalue_cmp_key(const dbi_val_t *key, const extvalue_t *ev)
+{
+    extvalue_t k = {.key = key->data, .keylen = key->size};
+
+    return extvalue_cmp(&k, ev);
+}
+
+static char *
+extvalue_dup(const void *p, size_t len)
+{
+    return memcpy(slapi_ch_malloc(len), p, len);
+}
+
+static void
+extvalues_free(extvalues_t *evs)
+{
+    for (size_t i = 0; i < evs->num; i++) {
+        slapi_ch_free_string(&evs->vals[i].key);
+        slapi_ch_free_string(&evs->vals[i].data);
+    }
+    slapi_ch_free((void **)&evs->vals);
+    evs->num = evs->max = 0;
+}
+
+/* stored ID | lowercase type | '\0', the prefix of the keys of an attribute */
+static char *
+extvalues_prefix(ID id, const char *type, size_t *prefixlen)
+{
+    size_t typelen = strlen(type);
+    char *prefix = slapi_ch_malloc(sizeof(ID) + typelen + 1);
+
+    id_internal_to_stored(id, prefix);
+    for (size_t i = 0; i <= typelen; i++) {
+        prefix[sizeof(ID) + i] = tolower(type[i]);
+    }
+    *prefixlen = sizeof(ID) + typelen + 1;
+    return prefix;
+}
+
+static int
+extvalues_wanted(ldbm_instance *inst, backend *be, Slapi_Attr *a)
+{
+    struct attrinfo *ai = NULL;
+    int listed = 0;
+
+    for (size_t i = 0; inst->extvalues_attrs && inst->extvalues_attrs[i]; i++) {
+        if (slapi_attr_type_cmp(inst->extvalues_attrs[i], a->a_type, SLAPI_TYPE_CMP_EXACT) == 0) {
+            listed = 1;
+            break;
+        }
+    }
+    if (!listed || slapi_valueset_count(&a->a_present_values) < inst->extvalues_threshold) {
+        return 0;
+    }
+    if (!valueset_isempty(&a->a_deleted_values) || a->a_deletioncsn) {
+        return 0;
+    }
+    /* the encrypted attributes stay in the entry */
+    ainfo_get(be, a->a_type, &ai);
+    return (ai == NULL || ai->ai_attrcrypt == NULL);
+}
+
+/*
+ * Add the records of the present values of a to evs. Returns -1, and adds
+ * nothing, if a value is too long for a key or if two values have the same
+ * normalized value: the attribute then stays in the entry.
+ */
+static int
+extvalues_add_attr(backend *be, ID id, Slapi_Attr *a, extvalues_t *evs)
+{
+    struct ldbminfo *li = (struct ldbminfo *)be->be_database->plg_private;
+    size_t first = evs->num;
+    size_t count = slapi_valueset_count(&a->a_present_values);
+    Slapi_Value *v = NULL;
+    size_t prefixlen;
+    char *prefix = extvalues_prefix(id, a->a_type, &prefixlen);
+    int rc = 0;
+
+    if (evs->num + count > evs->max) {
+        evs->max = evs->num + count;
+        evs->vals = (extvalue_t *)slapi_ch_realloc((char *)evs->vals, evs->max * sizeof(extvalue_t));
+    }
+    for (int i = slapi_attr_first_value(a, &v); i != -1; i = slapi_attr_next_value(a, i, &v)) {
+        const struct berval *bv = slapi_value_get_berval(v);
+        CSNSet *csnset = (CSNSet *)value_get_csnset(v);
+        size_t csnlen = csnset_string_size(csnset);
+        extvalue_t *ev = &evs->vals[evs->num++];
+        char *norm = NULL;
+        char *val = slapi_ch_malloc(bv->bv_len + 1);
+        size_t vallen = bv->bv_len;
+
+        memcpy(val, bv->bv_val, bv->bv_len);
+        val[bv->bv_len] = '\0';
+        if (memchr(val, '\0', bv->bv_len) == NULL) {
+            slapi_attr_value_normalize(NULL, a, NULL, val, 1, &norm);
+            if (norm) {
+                slapi_ch_free_string(&val);
+                val = norm;
+            }
+            vallen = strlen(val);
+        }
+        ev->keylen = prefixlen + vallen;
+        ev->key = slapi_ch_malloc(ev->keylen);
+        memcpy(ev->key, prefix, prefixlen);
+        memcpy(ev->key + prefixlen, val, vallen);
+        slapi_ch_free_string(&val);
+
+        ev->datalen = csnlen + 1 + bv->bv_len;
+        ev->data = slapi_ch_malloc(ev->datalen + 1);
+        ev->data[0] = '\0';
+        if (csnlen) {
+            csnset_as_string(csnset, ev->data);
+        }
+        memcpy(ev->data + csnlen + 1, bv->bv_val, bv->bv_len);
+        ev->stored = 0;
+
+        if (ev->keylen > li->li_max_key_len) {
+            rc = -1;
+        }
+    }
+    slapi_ch_free_string(&prefix);
+
+    if (rc == 0) {
+        qsort(evs->vals + first, evs->num - first, sizeof(extvalue_t), extvalue_cmp);
+        for (size_t i = first + 1; i < evs->num; i++) {
+            if (extvalue_cmp(&evs->vals[i - 1], &evs->vals[i]) == 0) {
+                rc = -1;
+                break;
+            }
+        }
+    }
+    if (rc) {
+        for (size_t i = first; i < evs->num; i++) {
+            slapi_ch_free_string(&evs->vals[i].key);
+            slapi_ch_free_string(&evs->vals[i].data);
+        }
+        evs->num = first;
+    }
+    return rc;
+}
+
+/*
+ * Add to evs the records that the entry olde of ID id has in the extvalues
+ * file. Returns -1 if they are not known: olde was not read from id2entry
+ * nor written by id2entry_add_ext.
+ */
+static int
+extvalues_add_entry(backend *be, ID id, struct backentry *olde, extvalues_t *evs)
+{
+    Slapi_Attr *a = NULL;
+
+    if (olde == NULL || olde->ep_id != id || !olde->ep_extvalues_known) {
+        return -1;
+    }
+    for (size_t i = 0; olde->ep_extvalues && olde->ep_extvalues[i]; i++) {
+        if (slapi_entry_attr_find(olde->ep_entry, olde->ep_extvalues[i], &a) ||
+            extvalues_add_attr(be, id, a, evs)) {
+            extvalues_free(evs);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* Add a copy of a key to the list of the records to delete */
+static void
+extvalues_add_deleted(char ***deleted, size_t **deletedlen, size_t *ndeleted, const void *key, size_t keylen)
+{
+    *deleted = (char **)slapi_ch_realloc((char *)*deleted, (*ndeleted + 1) * sizeof(char *));
+    *deletedlen = (size_t *)slapi_ch_realloc((char *)*deletedlen, (*ndeleted + 1) * sizeof(size_t));
+    (*deleted)[*ndeleted] = extvalue_dup(key, keylen);
+    (*deletedlen)[(*ndeleted)++] = keylen;
+}
+
+/*
+ * Make the records of ID id in the extvalues file match evs, and only
+ * write the changed ones. The records in the file are the ones of olde
+ * when they are known, they are read with a cursor otherwise.
+ */
+static int
+extvalues_store(backend *be, ID id, struct backentry *olde, extvalues_t *evs, dbi_txn_t *db_txn)
+{
+    dbi_db_t *db = NULL;
+    dbi_cursor_t cursor = {0};
+    dbi_val_t key = {0};
+    dbi_val_t data = {0};
+    char stored_id[sizeof(ID)];
+    extvalues_t old = {0};
+    char **deleted = NULL;
+    size_t *deletedlen = NULL;
+    size_t ndeleted = 0;
+    size_t j = 0;
+    int rc;
+
+    rc = dblayer_get_extvalues(be, &db, DBOPEN_CREATE);
+    if (rc) {
+        slapi_log_err(SLAPI_LOG_ERR, "extvalues_store",
+                      "Could not open/create " BE_EXTVALUES_FILE " err %d\n", rc);
+        return rc;
+    }
+    qsort(evs->vals, evs->num, sizeof(extvalue_t), extvalue_cmp);
+
+    if (extvalues_add_entry(be, id, olde, &old) == 0) {
+        /* Merge the records of the old entry with the new ones */
+        qsort(old.vals, old.num, sizeof(extvalue_t), extvalue_cmp);
+        for (size_t i = 0; i < old.num; i++) {
+            extvalue_t *ov = &old.vals[i];
+            int cmp = 1;
+
+            while (j < evs->num && (cmp = extvalue_cmp(ov, &evs->vals[j])) > 0) {
+                j++;
+            }
+            if (cmp == 0) {
+                extvalue_t *ev = &evs->vals[j++];
+                ev->stored = (ov->datalen == ev->datalen && memcmp(ov->data, ev->data, ov->datalen) == 0);
+            } else {
+                /* this value is gone */
+                extvalues_add_deleted(&deleted, &deletedlen, &ndeleted, ov->key, ov->keylen);
+            }
+        }
+        extvalues_free(&old);
+    } else {
+        rc = dblayer_new_cursor(be, db, db_txn, &cursor);
+        if (rc) {
+            return rc;
+        }
+        id_internal_to_stored(id, stored_id);
+        dblayer_value_set(be, &key, extvalue_dup(stored_id, sizeof(ID)), sizeof(ID));
+        dblayer_value_init(be, &data);
+        for (rc = dblayer_cursor_op(&cursor, DBI_OP_MOVE_NEAR_KEY, &key, &data);
+             rc == 0 && key.size >= sizeof(ID) && memcmp(key.data, stored_id, sizeof(ID)) == 0;
+             rc = dblayer_cursor_op(&cursor, DBI_OP_NEXT, &key, &data)) {
+            int cmp = 1;
+
+            while (j < evs->num && (cmp = extvalue_cmp_key(&key, &evs->vals[j])) > 0) {
+                j++;
+            }
+            if (cmp == 0) {
+                extvalue_t *ev = &evs->vals[j++];
+                ev->stored = (data.size == ev->datalen && memcmp(data.data, ev->data, data.size) == 0);
+            } else {
+                /* this value is gone */
+                extvalues_add_deleted(&deleted, &deletedlen, &ndeleted, key.data, key.size);
+            }
+        }
+        if (rc == DBI_RC_NOTFOUND) {
+            rc = 0;
+        }
+        dblayer_cursor_op(&cursor, DBI_OP_CLOSE, NULL, NULL);
+        dblayer_value_free(be, &key);
+        dblayer_value_free(be, &data);
+    }
+
+    for (size_t i = 0; rc == 0 && i < ndeleted; i++) {
+        dblayer_value_set_buffer(be, &key, deleted[i], deletedlen[i]);
+        rc = dblayer_db_op(be, db, db_txn, DBI_OP_DEL, &key, NULL);
+    }
+    for (size_t i = 0; rc == 0 && i < evs->num; i++) {
+        if (!evs->vals[i].stored) {
+            dblayer_value_set_buffer(be, &key, evs->vals[i].key, evs->vals[i].keylen);
+            dblayer_value_set_buffer(be, &data, evs->vals[i].data, evs->vals[i].datalen);
+            rc = dblayer_db_op(be, db, db_txn, DBI_OP_PUT, &key, &data);
+        }
+    }
+    if (rc && rc != DBI_RC_RETRY) {
+        slapi_log_err(SLAPI_LOG_ERR, "extvalues_store",
+                      "Failed to update the values of entry %lu, err %d (%s)\n",
+                      (u_long)id, rc, dblayer_strerror(rc));
+    }
+    for (size_t i = 0; i < ndeleted; i++) {
+        slapi_ch_free_string(&deleted[i]);
+    }
+    slapi_ch_free((void **)&deleted);
+    slapi_ch_free((void **)&deletedlen);
+    return rc;
+}
+
+static CSNType
+extvalue_csn_type(const char *p)
+{
+    if (p[1] == 'v' && p[2] == 'u') {
+        return CSN_TYPE_VALUE_UPDATED;
+    } else if (p[1] == 'v' && p[2] == 'd') {
+        return CSN_TYPE_VALUE_DELETED;
+    } else if (p[1] == 'm' && p[2] == 'd') {
+        return CSN_TYPE_VALUE_DISTINGUISHED;
+    } else if (p[1] == 'x' && p[2] == '2') {
+        return CSN_TYPE_NONE;
+    }
+    return CSN_TYPE_UNKNOWN;
+}
+
+static Slapi_Value *
+extvalue_decode(Slapi_Entry *e, const dbi_val_t *data)
+{
+    const char *p = data->data;
+    const char *sep = memchr(p, '\0', data->size);
+    struct berval bv;
+    Slapi_Value *v;
+
+    if (sep == NULL) {
+        return NULL;
+    }
+    bv.bv_val = (char *)sep + 1;
+    bv.bv_len = (const char *)data->data + data->size - bv.bv_val;
+    v = slapi_value_new_berval(&bv);
+    while (p + EXTVALUE_CSN_SIZE <= sep && *p == ';') {
+        char csnstr[CSN_STRSIZE];
+        CSN csn;
+
+        memcpy(csnstr, p + 1 + LDIF_CSNPREFIX_MAXLENGTH, _CSN_VALIDCSN_STRLEN);
+        csnstr[_CSN_VALIDCSN_STRLEN] = '\0';
+        csn_init_by_string(&csn, csnstr);
+        value_add_csn(v, extvalue_csn_type(p), &csn);
+        entry_set_maxcsn(e, &csn);
+        p += EXTVALUE_CSN_SIZE;
+    }
+    return v;
+}
+
+static int
+extvalues_load_attr(backend *be, dbi_db_t *db, ID id, Slapi_Entry *e, const char *type, dbi_txn_t *db_txn)
+{
+    dbi_cursor_t cursor = {0};
+    dbi_val_t key = {0};
+    dbi_val_t data = {0};
+    Slapi_Value **va = NULL;
+    size_t nva = 0;
+    size_t maxva = 0;
+    size_t prefixlen;
+    char *prefix = extvalues_prefix(id, type, &prefixlen);
+    int rc;
+
+    rc = dblayer_new_cursor(be, db, db_txn, &cursor);
+    if (rc) {
+        slapi_ch_free_string(&prefix);
+        return rc;
+    }
+    dblayer_value_set(be, &key, extvalue_dup(prefix, prefixlen), prefixlen);
+    dblayer_value_init(be, &data);
+    for (rc = dblayer_cursor_op(&cursor, DBI_OP_MOVE_NEAR_KEY, &key, &data);
+         rc == 0 && key.size >= prefixlen && memcmp(key.data, prefix, prefixlen) == 0;
+         rc = dblayer_cursor_op(&cursor, DBI_OP_NEXT, &key, &data)) {
+        Slapi_Value *v = extvalue_decode(e, &data);
+
+        if (v == NULL) {
+            slapi_log_err(SLAPI_LOG_ERR, ID2ENTRY,
+                          "Skipping invalid %s value of entry %lu in " BE_EXTVALUES_FILE "\n",
+                          type, (u_long)id);
+            continue;
+        }
+        if (nva + 1 >= maxva) {
+            maxva = maxva ? maxva * 2 : 64;
+            va = (Slapi_Value **)slapi_ch_realloc((char *)va, maxva * sizeof(Slapi_Value *));
+        }
+        va[nva++] = v;
+    }
+    if (rc == DBI_RC_NOTFOUND) {
+        rc = 0;
+    }
+    dblayer_cursor_op(&cursor, DBI_OP_CLOSE, NULL, NULL);
+    dblayer_value_free(be, &key);
+    dblayer_value_free(be, &data);
+    slapi_ch_free_string(&prefix);
+
+    if (rc == 0 && nva > 0) {
+        Slapi_Attr **a = NULL;
+
+        va[nva] = NULL;
+        attrlist_find_or_create(&e->e_attrs, type, &a);
+        slapi_valueset_add_attr_valuearray_ext(*a, &(*a)->a_present_values, va, nva, SLAPI_VALUE_FLAG_PASSIN, NULL);
+    } else {
+        for (size_t i = 0; i < nva; i++) {
+            slapi_value_free(&va[i]);
+        }
+    }
+    slapi_ch_free((void **)&va);
+    return rc;
+}
+
+/*
+ * Unlink from the attribute list of e the attributes to store out of
+ * id2entry, after adding the records of their values to evs and their
+ * types to *types. Returns the original list, for extvalues_relink(),
+ * or NULL when every attribute stays in the entry.
+ */
+static Slapi_Attr **
+extvalues_unlink(backend *be, ID id, Slapi_Entry *e, extvalues_t *evs, char ***types)
+{
+    ldbm_instance *inst = (ldbm_instance *)be->be_instance_info;
+    Slapi_Attr **attrs = NULL;
+    Slapi_Attr **next = &e->e_attrs;
+    size_t nattrs = 0;
+    size_t i = 0;
+
+    for (Slapi_Attr *a = e->e_attrs; a; a = a->a_next) {
+        nattrs++;
+    }
+    attrs = (Slapi_Attr **)slapi_ch_malloc((nattrs + 1) * sizeof(Slapi_Attr *));
+    for (Slapi_Attr *a = e->e_attrs; a; a = a->a_next) {
+        attrs[i++] = a;
+    }
+    attrs[nattrs] = NULL;
+
+    for (i = 0; i < nattrs; i++) {
+        if (extvalues_wanted(inst, be, attrs[i]) && extvalues_add_attr(be, id, attrs[i], evs) == 0) {
+            charray_add(types, slapi_ch_strdup(attrs[i]->a_type));
+        } else {
+            *next = attrs[i];
+            next = &attrs[i]->a_next;
+        }
+    }
+    *next = NULL;
+    if (*types == NULL) {
+        /* nothing was unlinked, the list is unchanged */
+        slapi_ch_free((void **)&attrs);
+    }
+    return attrs;
+}
+
+static void
+extvalues_relink(Slapi_Entry *e, Slapi_Attr **attrs)
+{
+    e->e_attrs = attrs[0];
+    for (size_t i = 0; attrs[i]; i++) {
+        attrs[i]->a_next = attrs[i + 1];
+    }
+    slapi_ch_free((void **)&attrs);
+}
+
+/* The types named by the LDBM_EXTVALUES_STR values of e */
+static char **
+extvalues_types(Slapi_Entry *e)
+{
+    Slapi_Attr *marker = NULL;
+    Slapi_Value *v = NULL;
+    char **types = NULL;
+
+    if (slapi_entry_attr_find(e, LDBM_EXTVALUES_STR, &marker) == 0) {
+        for (int i = slapi_attr_first_value(marker, &v); i != -1; i = slapi_attr_next_value(marker, i, &v)) {
+            charray_add(&types, slapi_ch_strdup(slapi_value_get_string(v)));
+        }
+    }
+    return types;
+}
+
+/*
+ * Put back in e, just read from id2entry, the values stored in the
+ * extvalues file. The caller MUST check for DBI_RC_RETRY.
+ */
+int
+id2entry_extvalues_load(backend *be, ID id, Slapi_Entry *e, back_txn *txn)
+{
+    Slapi_Attr *marker = NULL;
+    Slapi_Value *v = NULL;
+    dbi_db_t *db = NULL;
+    int rc;
+
+    if (slapi_entry_attr_find(e, LDBM_EXTVALUES_STR, &marker)) {
+        return 0;
+    }
+    rc = dblayer_get_extvalues(be, &db, DBOPEN_CREATE);
+    for (int i = slapi_attr_first_value(marker, &v); rc == 0 && i != -1; i = slapi_attr_next_value(marker, i, &v)) {
+        rc = extvalues_load_attr(be, db, id, e, slapi_value_get_string(v), txn ? txn->back_txn_txn : NULL);
+    }
+    attrlist_delete(&e->e_attrs, LDBM_EXTVALUES_STR);
+    if (rc && rc != DBI_RC_RETRY) {
+        slapi_log_err(SLAPI_LOG_ERR, ID2ENTRY,
+                      "Could not load the external values of entry %lu err %d (%s)\n",
+                      (u_long)id, rc, dblayer_strerror(rc));
+    }
+    return rc;
+}
+
 /*
  * The caller MUST check for DBI_RC_RETRY and DBI_RC_RUNRECOVERY returned
  * If cache_res is not NULL, it stores the result of CACHE_ADD of the
  * entry cache.
+ * olde, if not NULL, is the entry with the same ID that e replaces: only
+ * the external values that differ between them are then written.
  */
 int
-id2entry_add_ext(backend *be, struct backentry *e, back_txn *txn, int encrypt, int *cache_res)
+id2entry_replace_ext(backend *be, struct backentry *olde, struct backentry *e, back_txn *txn, int encrypt, int *cache_res)
 {
     ldbm_instance *inst = (ldbm_instance *)be->be_instance_info;
     dbi_db_t *db = NULL;
@@ -35,6 +564,9 @@ id2entry_add_ext(backend *be, struct backentry *e, back_txn *txn, int encrypt, i
     struct backentry *encrypted_entry = NULL;
     char *entrydn = NULL;
     uint32_t esize;
+    extvalues_t evs = {0};
+    char **types = NULL;
+    int use_extvalues = 0;
 
     slapi_log_err(SLAPI_LOG_TRACE, "id2entry_add_ext", "=> ( %lu, \"%s\" )\n",
                   (u_long)e->ep_id, backentry_get_ndn(e));
@@ -97,7 +629,25 @@ id2entry_add_ext(backend *be, struct backentry *e, back_txn *txn, int encrypt, i
                       "id2entry_add_ext", "(dncache) ( %lu, \"%s\" )\n",
                       (u_long)e->ep_id, slapi_entry_get_dn_const(entry_to_use));
 
-        data.dptr = slapi_entry2str_with_options(entry_to_use, &len, options);
+        /* The import txn callback only knows about id2entry: no extvalues there */
+        use_extvalues = (inst->extvalues_threshold > 0 || inst->inst_extvalues) &&
+                        !(txn && txn->back_special_handling_fn);
+        if (use_extvalues && inst->extvalues_threshold > 0) {
+            Slapi_Attr **attrs = extvalues_unlink(be, e->ep_id, entry_to_use, &evs, &types);
+
+            data.dptr = slapi_entry2str_with_options(entry_to_use, &len, options);
+            if (attrs) {
+                extvalues_relink(entry_to_use, attrs);
+            }
+            for (size_t i = 0; types && types[i]; i++) {
+                size_t linelen = strlen(LDBM_EXTVALUES_STR) + strlen(types[i]) + 3;
+
+                data.dptr = slapi_ch_realloc(data.dptr, len + linelen + 1);
+                len += sprintf((char *)data.dptr + len, "%s: %s\n", LDBM_EXTVALUES_STR, types[i]);
+            }
+        } else {
+            data.dptr = slapi_entry2str_with_options(entry_to_use, &len, options);
+        }
         data.dsize = len + 1;
     }
 
@@ -105,6 +655,20 @@ id2entry_add_ext(backend *be, struct backentry *e, back_txn *txn, int encrypt, i
         db_txn = txn->back_txn_txn;
     }
 
+    /*
+     * Write the changed external values first, an empty evs removes those
+     * of an entry that no longer has any.
+     */
+    if (use_extvalues) {
+        rc = extvalues_store(be, e->ep_id, olde, &evs, db_txn);
+        extvalues_free(&evs);
+        if (rc) {
+            slapi_ch_free(&(data.dptr));
+            dblayer_release_id2entry(be, db);
+            goto done;
+        }
+    }
+
     /* call pre-entry-store plugin */
     esize = (uint32_t)data.dsize;
     plugin_call_entrystore_plugins((char **)&data.dptr, &esize);
@@ -123,6 +687,13 @@ id2entry_add_ext(backend *be, struct backentry *e, back_txn *txn, int encrypt, i
 
     if (0 == rc) {
         int cache_rc = 0;
+
+        /* Remember the external types of e for the next rewrite */
+        charray_free(e->ep_extvalues);
+        e->ep_extvalues = types;
+        e->ep_extvalues_known = use_extvalues;
+        types = NULL;
+
         /* Putting the entry into the entry cache.
          * We don't use the encrypted entry here. */
 
@@ -200,11 +771,18 @@ done:
     if (encrypted_entry) {
         backentry_free(&encrypted_entry);
     }
+    charray_free(types);
 
     slapi_log_err(SLAPI_LOG_TRACE, "id2entry_add_ext", "<= %d\n", rc);
     return (rc);
 }
 
+int
+id2entry_add_ext(backend *be, struct backentry *e, back_txn *txn, int encrypt, int *cache_res)
+{
+    return id2entry_replace_ext(be, NULL, e, txn, encrypt, cache_res);
+}
+
 int
 id2entry_add(backend *be, struct backentry *e, back_txn *txn)
 {
@@ -242,6 +820,16 @@ id2entry_delete(backend *be, struct backentry *e, back_txn *txn)
     }
 
     ldbm_instance *inst = (ldbm_instance *)be->be_instance_info;
+    if (inst->extvalues_threshold > 0 || inst->inst_extvalues) {
+        extvalues_t evs = {0};
+
+        rc = extvalues_store(be, e->ep_id, e, &evs, db_txn);
+        if (rc) {
+            dblayer_release_id2entry(be, db);
+            return rc;
+        }
+    }
+
     struct backdn *bdn = dncache_find_id(&inst->inst_dncache, e->ep_id);
     if (bdn) {
         slapi_log_err(SLAPI_LOG_CACHE, ID2ENTRY,
@@ -258,92 +846,33 @@ id2entry_delete(backend *be, struct backentry *e, back_txn *txn)
     return (rc);
 }
 
-struct backentry *
-id2entry(backend *be, ID id, back_txn *txn, int *err)
+/*
+ * Build the entry of a record read from id2entry and, if cache is set, add
+ * it to the entry cache. Returns the entry (referenced if it is cached) or
+ * NULL.
+ */
+static struct backentry *
+id2entry_decode(backend *be, ID id, dbi_val_t *data, back_txn *txn, BackEntryWeightData *t1, int cache, int *err)
 {
     ldbm_instance *inst = (ldbm_instance *)be->be_instance_info;
-    dbi_db_t *db = NULL;
-    dbi_txn_t *db_txn = NULL;
-    dbi_val_t key = {0};
-    dbi_val_t data = {0};
     struct backentry *e = NULL;
     Slapi_Entry *ee;
-    char temp_id[sizeof(ID)];
+    char **types = NULL;
     uint32_t esize;
-    BackEntryWeightData t1 = {0};
-
-    slapi_log_err(SLAPI_LOG_TRACE, ID2ENTRY,
-                  "=> id2entry(%lu)\n", (u_long)id);
-
-    if ((e = cache_find_id(&inst->inst_cache, id)) != NULL) {
-        slapi_log_err(SLAPI_LOG_TRACE, ID2ENTRY,
-                      "<= id2entry %p, dn \"%s\" (cache)\n",
-                      e, backentry_get_ndn(e));
-        goto bail;
-    }
-
-    *err = dblayer_get_id2entry(be, &db);
-    if ((*err != 0) || (NULL == db)) {
-        slapi_log_err(SLAPI_LOG_ERR, ID2ENTRY,
-                      "Could not open id2entry err %d\n", *err);
-        return (NULL);
-    }
-
-
-    backentry_init_weight(&t1);
-    id_internal_to_stored(id, temp_id);
-
-    dblayer_value_set_buffer(be, &key, temp_id,  sizeof(temp_id));
-    dblayer_value_init(be, &data);
-
-    if (NULL != txn) {
-        db_txn = txn->back_txn_txn;
-    }
-    do {
-        *err = dblayer_db_op(be, db, db_txn, DBI_OP_GET, &key, &data);
-        if ((0 != *err) &&
-            (DBI_RC_NOTFOUND != *err) && (DBI_RC_RETRY != *err)) {
-            slapi_log_err(SLAPI_LOG_ERR, ID2ENTRY, "db error %d (%s)\n",
-                          *err, dblayer_strerror(*err));
-        }
-    } while ((DBI_RC_RETRY == *err) && (txn == NULL));
-
-    if ((0 != *err) && (DBI_RC_NOTFOUND != *err) && (DBI_RC_RETRY != *err)) {
-        if ((DBI_RC_BUFFER_SMALL == *err) && (data.dptr == NULL)) {
-            /*
-             * Now we are setting slapi_ch_malloc and its friends to libdb
-             * by ENV->set_alloc in dblayer.c.  As long as the functions are
-             * used by libdb, it won't reach here.
-             */
-            slapi_log_err(SLAPI_LOG_CRIT, ID2ENTRY,
-                          "Malloc failed in libdb; "
-                          "terminating the server; OS error %d (%s)\n",
-                          *err, slapd_system_strerror(*err));
-            exit(1);
-        }
-        dblayer_release_id2entry(be, db);
-        return (NULL);
-    }
-
-    if (data.dptr == NULL) {
-        slapi_log_err(SLAPI_LOG_TRACE, ID2ENTRY,
-                      "<= id2entry( %lu ) not found\n", (u_long)id);
-        goto bail;
-    }
 
     /* call post-entry plugin */
-    esize = (uint32_t)data.dsize;
-    plugin_call_entryfetch_plugins((char **)&data.dptr, &esize);
-    data.dsize = esize;
+    esize = (uint32_t)data->dsize;
+    plugin_call_entryfetch_plugins((char **)&data->dptr, &esize);
+    data->dsize = esize;
 
     char *rdn = NULL;
     int rc = 0;
 
     /* rdn is allocated in get_value_from_string */
-    rc = get_value_from_string((const char *)data.dptr, "rdn", &rdn);
+    rc = get_value_from_string((const char *)data->dptr, "rdn", &rdn);
     if (rc) {
-        /* data.dptr may not include rdn: ..., try "dn: ..." */
-        ee = slapi_str2entry(data.dptr, SLAPI_STR2ENTRY_NO_ENTRYDN);
+        /* data->dptr may not include rdn: ..., try "dn: ..." */
+        ee = slapi_str2entry(data->dptr, SLAPI_STR2ENTRY_NO_ENTRYDN);
     } else {
         char *normdn = NULL;
         Slapi_RDN *srdn = NULL;
@@ -354,9 +883,8 @@ id2entry(backend *be, ID id, back_txn *txn, int *err)
                           "dncache_find_id returned: %s\n", normdn);
             CACHE_RETURN(&inst->inst_dncache, &bdn);
         } else {
-            Slapi_DN *sdn = NULL;
             if (config_get_return_orig_dn() &&
-                !get_value_from_string((const char *)data.dptr, SLAPI_ATTR_DS_ENTRYDN, &normdn))
+                !get_value_from_string((const char *)data->dptr, SLAPI_ATTR_DS_ENTRYDN, &normdn))
             {
                 srdn = slapi_rdn_new_all_dn(normdn);
             } else {
@@ -373,31 +901,44 @@ id2entry(backend *be, ID id, back_txn *txn, int *err)
                                   "id2entry( %lu ) entryrdn_lookup_dn returned NULL. "
                                   "Index file may be deleted or corrupted.\n",
                                   (u_long)id);
-                    goto bail;
+                    goto done;
                 }
             }
 
-            sdn = slapi_sdn_new_normdn_byval((const char *)normdn);
-            bdn = backdn_init(sdn, id, 0);
-            if (CACHE_ADD(&inst->inst_dncache, bdn, NULL)) {
-                backdn_free(&bdn);
-                slapi_log_err(SLAPI_LOG_CACHE, ID2ENTRY,
-                              "%s is already in the dn cache\n", normdn);
-            } else {
-                CACHE_RETURN(&inst->inst_dncache, &bdn);
-                slapi_log_err(SLAPI_LOG_CACHE, ID2ENTRY,
-                              "entryrdn_lookup_dn returned: %s, "
-                              "and set to dn cache (id %d)\n",
-                              normdn, id);
+            if (cache) {
+                Slapi_DN *sdn = slapi_sdn_new_normdn_byval((const char *)normdn);
+                bdn = backdn_init(sdn, id, 0);
+                if (CACHE_ADD(&inst->inst_dncache, bdn, NULL)) {
+                    backdn_free(&bdn);
+                    slapi_log_err(SLAPI_LOG_CACHE, ID2ENTRY,
+                                  "%s is already in the dn cache\n", normdn);
+                } else {
+                    CACHE_RETURN(&inst->inst_dncache, &bdn);
+                    slapi_log_err(SLAPI_LOG_CACHE, ID2ENTRY,
+                                  "entryrdn_lookup_dn returned: %s, "
+                                  "and set to dn cache (id %d)\n",
+                                  normdn, id);
+                }
             }
         }
-        ee = slapi_str2entry_ext((const char *)normdn, (const Slapi_RDN *)srdn, data.dptr,
+        ee = slapi_str2entry_ext((const char *)normdn, (const Slapi_RDN *)srdn, data->dptr,
                                  SLAPI_STR2ENTRY_NO_ENTRYDN);
         slapi_ch_free_string(&rdn);
         slapi_ch_free_string(&normdn);
         slapi_rdn_free(&srdn);
     }
 
+    if (ee != NULL) {
+        types = extvalues_types(ee);
+        *err = id2entry_extvalues_load(be, id, ee, txn);
+        if (*err) {
+            slapi_entry_free(ee);
+            charray_free(types);
+            ee = NULL;
+            goto done;
+        }
+    }
+
     if (ee != NULL) {
         int retval = 0;
         struct backentry *imposter = NULL;
@@ -408,9 +949,11 @@ id2entry(backend *be, ID id, back_txn *txn, int *err)
         /* ownership of the entry is passed into the backentry */
         e = backentry_init(ee);
         e->ep_id = id;
+        e->ep_extvalues = types;
+        e->ep_extvalues_known = 1;
         slapi_log_err(SLAPI_LOG_TRACE, ID2ENTRY,
-                      "id2entry id: %d, dn \"%s\" -- adding it to cache\n",
-                      id, backentry_get_ndn(e));
+                      "id2entry id: %d, dn \"%s\"%s\n",
+                      id, backentry_get_ndn(e), cache ? " -- adding it to cache" : "");
 
         /* Decrypt any encrypted attributes in this entry,
          * before adding it to the cache */
@@ -443,7 +986,10 @@ id2entry(backend *be, ID id, back_txn *txn, int *err)
             slapi_ch_free_string(&entrydn);
         }
 
-        backentry_compute_weight(e, &t1);
+        if (!cache) {
+            goto done;
+        }
+        backentry_compute_weight(e, t1);
         retval = CACHE_ADD(&inst->inst_cache, e, &imposter);
         if (1 == retval) {
             /* This means that someone else put the entry in the cache
@@ -465,10 +1011,87 @@ id2entry(backend *be, ID id, back_txn *txn, int *err)
     } else {
         slapi_log_err(SLAPI_LOG_ERR, ID2ENTRY,
                       "str2entry returned NULL for id %lu, string=\"%s\"\n",
-                      (u_long)id, (char *)data.data);
+                      (u_long)id, (char *)data->data);
         e = NULL;
     }
 
+done:
+    return (e);
+}
+
+static struct backentry *
+id2entry_fetch(backend *be, ID id, back_txn *txn, int cache, int *err)
+{
+    ldbm_instance *inst = (ldbm_instance *)be->be_instance_info;
+    dbi_db_t *db = NULL;
+    dbi_txn_t *db_txn = NULL;
+    dbi_val_t key = {0};
+    dbi_val_t data = {0};
+    struct backentry *e = NULL;
+    char temp_id[sizeof(ID)];
+    BackEntryWeightData t1 = {0};
+
+    slapi_log_err(SLAPI_LOG_TRACE, ID2ENTRY,
+                  "=> id2entry(%lu)\n", (u_long)id);
+
+    if (cache && (e = cache_find_id(&inst->inst_cache, id)) != NULL) {
+        slapi_log_err(SLAPI_LOG_TRACE, ID2ENTRY,
+                      "<= id2entry %p, dn \"%s\" (cache)\n",
+                      e, backentry_get_ndn(e));
+        goto bail;
+    }
+
+    *err = dblayer_get_id2entry(be, &db);
+    if ((*err != 0) || (NULL == db)) {
+        slapi_log_err(SLAPI_LOG_ERR, ID2ENTRY,
+                      "Could not open id2entry err %d\n", *err);
+        return (NULL);
+    }
+
+
+    backentry_init_weight(&t1);
+    id_internal_to_stored(id, temp_id);
+
+    dblayer_value_set_buffer(be, &key, temp_id,  sizeof(temp_id));
+    dblayer_value_init(be, &data);
+
+    if (NULL != txn) {
+        db_txn = txn->back_txn_txn;
+    }
+    do {
+        *err = dblayer_db_op(be, db, db_txn, DBI_OP_GET, &key, &data);
+        if ((0 != *err) &&
+            (DBI_RC_NOTFOUND != *err) && (DBI_RC_RETRY != *err)) {
+            slapi_log_err(SLAPI_LOG_ERR, ID2ENTRY, "db error %d (%s)\n",
+                          *err, dblayer_strerror(*err));
+        }
+    } while ((DBI_RC_RETRY == *err) && (txn == NULL));
+
+    if ((0 != *err) && (DBI_RC_NOTFOUND != *err) && (DBI_RC_RETRY != *err)) {
+        if ((DBI_RC_BUFFER_SMALL == *err) && (data.dptr == NULL)) {
+            /*
+             * Now we are setting slapi_ch_malloc and its friends to libdb
+             * by ENV->set_alloc in dblayer.c.  As long as the functions are
+             * used by libdb, it won't reach here.
+             */
+            slapi_log_err(SLAPI_LOG_CRIT, ID2ENTRY,
+                          "Malloc failed in libdb; "
+                          "terminating the server; OS error %d (%s)\n",
+                          *err, slapd_system_strerror(*err));
+            exit(1);
+        }
+        dblayer_release_id2entry(be, db);
+        return (NULL);
+    }
+
+    if (data.dptr == NULL) {
+        slapi_log_err(SLAPI_LOG_TRACE, ID2ENTRY,
+                      "<= id2entry( %lu ) not found\n", (u_long)id);
+        goto bail;
+    }
+
+    e = id2entry_decode(be, id, &data, txn, &t1, cache, err);
+
 bail:
     dblayer_value_free(be, &data);
     dblayer_release_id2entry(be, db);
@@ -477,3 +1100,93 @@ bail:
                   "<= id2entry( %lu ) %p (disk)\n", (u_long)id, e);
     return (e);
 }
+
+struct backentry *
+id2entry(backend *be, ID id, back_txn *txn, int *err)
+{
+    return id2entry_fetch(be, id, txn, 1, err);
+}
+
+/*
+ * Read an entry from id2entry without looking it up in (nor adding it to)
+ * the entry and dn caches, for the tasks scanning the whole database. The
+ * entry is private to the caller, who frees it with backentry_free.
+ */
+struct backentry *
+id2entry_nocache(backend *be, ID id, back_txn *txn, int *err)
+{
+    return id2entry_fetch(be, id, txn, 0, err);
+}
+
+static int
+id2entry_id_cmp(const void *v1, const void *v2)
+{
+    ID id1 = *(const ID *)v1;
+    ID id2 = *(const ID *)v2;
+
+    return (id1 > id2) - (id1 < id2);
+}
+
+/*
+ * Read ahead for the search result loop: put in the entry cache the
+ * entries of ids that are not there yet, left unreferenced. The missing
+ * entries are read in ID order with a single cursor, instead of a lookup
+ * from the root of id2entry per entry. Errors are ignored: id2entry()
+ * reports them when the search loop gets to the entry.
+ */
+void
+id2entry_prefetch(backend *be, const ID *ids, size_t nids, back_txn *txn)
+{
+    ldbm_instance *inst = (ldbm_instance *)be->be_instance_info;
+    dbi_db_t *db = NULL;
+    dbi_cursor_t cursor = {0};
+    dbi_val_t key = {0};
+    dbi_val_t data = {0};
+    ID *missing = NULL;
+    size_t nmissing = 0;
+    int err = 0;
+
+    missing = (ID *)slapi_ch_malloc(nids * sizeof(ID));
+    for (size_t i = 0; i < nids; i++) {
+        struct backentry *e = cache_find_id(&inst->inst_cache, ids[i]);
+
+        if (e) {
+            CACHE_RETURN(&inst->inst_cache, &e);
+        } else {
+            missing[nmissing++] = ids[i];
+        }
+    }
+    if (nmissing == 0 || dblayer_get_id2entry(be, &db) != 0 || db == NULL) {
+        slapi_ch_free((void **)&missing);
+        return;
+    }
+    qsort(missing, nmissing, sizeof(ID), id2entry_id_cmp);
+
+    if (dblayer_new_cursor(be, db, txn ? txn->back_txn_txn : NULL, &cursor) == 0) {
+        dblayer_value_init(be, &data);
+        for (size_t i = 0; i < nmissing; i++) {
+            BackEntryWeightData t1 = {0};
+            char temp_id[sizeof(ID)];
+            struct backentry *e = NULL;
+
+            backentry_init_weight(&t1);
+            id_internal_to_stored(missing[i], temp_id);
+            dblayer_value_set_buffer(be, &key, temp_id, sizeof(temp_id));
+            err = dblayer_cursor_op(&cursor, DBI_OP_MOVE_TO_KEY, &key, &data);
+            if (err == DBI_RC_NOTFOUND) {
+                continue;
+            } else if (err) {
+                break;
+            }
+            e = id2entry_decode(be, missing[i], &data, txn, &t1, 1, &err);
+            CACHE_RETURN(&inst->inst_cache, &e);
+            /* the entryfetch plugins may have replaced the buffer */
+            dblayer_value_free(be, &data);
+            dblayer_value_init(be, &data);
+        }
+        dblayer_cursor_op(&cursor, DBI_OP_CLOSE, NULL, NULL);
+        dblayer_value_free(be, &data);
+    }
+    dblayer_release_id2entry(be, db);
+    slapi_ch_free((void **)&missing);
+}
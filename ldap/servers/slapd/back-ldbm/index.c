@@ -1988,7 +1988,10 @@ addordel_values_sv(
             db_txn = txn->back_txn_txn;
         }
 
-        if (flags & BE_INDEX_ADD) {
+        if (flags & BE_INDEX_VISIT_KEYS) {
+            index_key_visitor_t *ikv = (index_key_visitor_t *)buffer_handle;
+            rc = ikv->ikv_visit(ikv, a, &key, id);
+        } else if (flags & BE_INDEX_ADD) {
             rc = idl_insert_key(be, db, &key, id, txn, a, idl_disposition);
         } else {
             rc = idl_delete_key(be, db, &key, id, txn, a);
@@ -2028,7 +2031,10 @@ addordel_values_sv(
             db_txn = txn->back_txn_txn;
         }
 
-        if (flags & BE_INDEX_ADD) {
+        if (flags & BE_INDEX_VISIT_KEYS) {
+            index_key_visitor_t *ikv = (index_key_visitor_t *)buffer_handle;
+            rc = ikv->ikv_visit(ikv, a, &key, id);
+        } else if (flags & BE_INDEX_ADD) {
             if (buffer_handle) {
                 rc = index_buffer_insert(buffer_handle, &key, id, be, db_txn, a);
                 if (rc == -2) {
@@ -2110,6 +2116,7 @@ index_addordel_values_ext_sv(
     Slapi_Value **ivals;
     char buf[SLAPD_TYPICAL_ATTRIBUTE_NAME_MAX_LENGTH];
     char *basetmp, *basetype;
+    void *visitor = (flags & BE_INDEX_VISIT_KEYS) ? buffer_handle : NULL;
 
     slapi_log_err(SLAPI_LOG_TRACE,
                   "index_addordel_values_ext_sv", "( \"%s\", %lu )\n", type, (u_long)id);
@@ -2146,7 +2153,7 @@ index_addordel_values_ext_sv(
          * BE_INDEX_PRESENCE flag is set.
          */
         err = addordel_values_sv(be, db, basetype, indextype_PRESENCE,
-                                 NULL, id, flags, txn, ai, idl_disposition, NULL);
+                                 NULL, id, flags, txn, ai, idl_disposition, visitor);
         if (err != 0) {
             ldbm_nasty("index_addordel_values_ext_sv", errmsg, 1220, err);
             goto bad;
@@ -2164,7 +2171,7 @@ index_addordel_values_ext_sv(
         slapi_attr_values2keys_sv(&ai->ai_sattr, vals, &ivals, LDAP_FILTER_EQUALITY);
 
         err = addordel_values_sv(be, db, basetype, indextype_EQUALITY,
-                                 ivals != NULL ? ivals : vals, id, flags, txn, ai, idl_disposition, NULL);
+                                 ivals != NULL ? ivals : vals, id, flags, txn, ai, idl_disposition, visitor);
         if (ivals != NULL) {
             valuearray_free(&ivals);
         }
@@ -2182,7 +2189,7 @@ index_addordel_values_ext_sv(
 
         if (ivals != NULL) {
             err = addordel_values_sv(be, db, basetype,
-                                     indextype_APPROX, ivals, id, flags, txn, ai, idl_disposition, NULL);
+                                     indextype_APPROX, ivals, id, flags, txn, ai, idl_disposition, visitor);
             valuearray_free(&ivals);
             if (err != 0) {
                 ldbm_nasty("index_addordel_values_ext_sv", errmsg, 1240, err);
@@ -2248,7 +2255,7 @@ index_addordel_values_ext_sv(
                     /* the matching rule indexer owns keys now */
                     if (keys != NULL && keys[0] != NULL) {
                         /* we've computed keys */
-                        err = addordel_values_sv(be, db, basetype, officialOID, keys, id, flags, txn, ai, idl_disposition, NULL);
+                        err = addordel_values_sv(be, db, basetype, officialOID, keys, id, flags, txn, ai, idl_disposition, visitor);
                         if (err != 0) {
                             ldbm_nasty("index_addordel_values_ext_sv", errmsg, 1260, err);
                         }
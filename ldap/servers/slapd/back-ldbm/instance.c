@@ -661,6 +661,7 @@ ldbm_instance_destructor(void **arg)
     slapi_ch_free_string(&inst->cache_debug_pattern);
     slapi_re_free(inst->cache_debug_re);
     inst->cache_debug_re = NULL;
+    charray_free(inst->extvalues_attrs);
 
     /* cache has already been destroyed */
 
@@ -245,6 +245,172 @@ ldbm_config_pagedlookthroughlimit_set(void *arg, void *value, char *errorbuf __a
     return retval;
 }
 
+static void *
+ldbm_config_search_readahead_get(void *arg)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+
+    return (void *)((uintptr_t)(li->li_search_readahead));
+}
+
+static int
+ldbm_config_search_readahead_set(void *arg, void *value, char *errorbuf, int phase __attribute__((unused)), int apply)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+    int val = (int)((uintptr_t)value);
+
+    if (val < 0) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE,
+                              "Error: Invalid value for %s (%d). The value must not be negative\n",
+                              CONFIG_SEARCH_READAHEAD, val);
+        return LDAP_UNWILLING_TO_PERFORM;
+    }
+    if (apply) {
+        li->li_search_readahead = val;
+    }
+
+    return LDAP_SUCCESS;
+}
+
+static void *
+ldbm_config_cache_autotune_interval_get(void *arg)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+
+    return (void *)((uintptr_t)(li->li_cache_autotune_interval));
+}
+
+static int
+ldbm_config_cache_autotune_interval_set(void *arg, void *value, char *errorbuf, int phase, int apply)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+    int val = (int)((uintptr_t)value);
+
+    if (val < 0) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE,
+                              "Error: Invalid value for %s (%d). The value must not be negative\n",
+                              CONFIG_CACHE_AUTOTUNE_INTERVAL, val);
+        return LDAP_UNWILLING_TO_PERFORM;
+    }
+    if (apply) {
+        li->li_cache_autotune_interval = val;
+        if (CONFIG_PHASE_RUNNING == phase) {
+            /* reschedule the controller with the new interval */
+            ldbm_cache_autotune_stop(li);
+            ldbm_cache_autotune_start(li);
+        }
+    }
+
+    return LDAP_SUCCESS;
+}
+
+static void *
+ldbm_config_cache_warmup_get(void *arg)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+
+    return (void *)((uintptr_t)(li->li_cache_warmup));
+}
+
+static int
+ldbm_config_cache_warmup_set(void *arg, void *value, char *errorbuf __attribute__((unused)), int phase, int apply)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+
+    if (apply) {
+        li->li_cache_warmup = (int)((uintptr_t)value);
+        if (CONFIG_PHASE_RUNNING == phase) {
+            ldbm_cache_warmup_schedule(li);
+        }
+    }
+
+    return LDAP_SUCCESS;
+}
+
+static void *
+ldbm_config_cache_warmup_interval_get(void *arg)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+
+    return (void *)((uintptr_t)(li->li_cache_warmup_interval));
+}
+
+static int
+ldbm_config_cache_warmup_interval_set(void *arg, void *value, char *errorbuf, int phase, int apply)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+    int val = (int)((uintptr_t)value);
+
+    if (val < 0) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE,
+                              "Error: Invalid value for %s (%d). The value must not be negative\n",
+                              CONFIG_CACHE_WARMUP_INTERVAL, val);
+        return LDAP_UNWILLING_TO_PERFORM;
+    }
+    if (apply) {
+        li->li_cache_warmup_interval = val;
+        if (CONFIG_PHASE_RUNNING == phase) {
+            ldbm_cache_warmup_schedule(li);
+        }
+    }
+
+    return LDAP_SUCCESS;
+}
+
+static void *
+ldbm_config_cache_warmup_threads_get(void *arg)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+
+    return (void *)((uintptr_t)(li->li_cache_warmup_threads));
+}
+
+static int
+ldbm_config_cache_warmup_threads_set(void *arg, void *value, char *errorbuf, int phase __attribute__((unused)), int apply)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+    int val = (int)((uintptr_t)value);
+
+    if (val < 1 || val > 64) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE,
+                              "Error: Invalid value for %s (%d). The value must be between 1 and 64\n",
+                              CONFIG_CACHE_WARMUP_THREADS, val);
+        return LDAP_UNWILLING_TO_PERFORM;
+    }
+    if (apply) {
+        li->li_cache_warmup_threads = val;
+    }
+
+    return LDAP_SUCCESS;
+}
+
+static void *
+ldbm_config_cache_warmup_rate_get(void *arg)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+
+    return (void *)((uintptr_t)(li->li_cache_warmup_rate));
+}
+
+static int
+ldbm_config_cache_warmup_rate_set(void *arg, void *value, char *errorbuf, int phase __attribute__((unused)), int apply)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+    int val = (int)((uintptr_t)value);
+
+    if (val < 0) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE,
+                              "Error: Invalid value for %s (%d). The value must not be negative\n",
+                              CONFIG_CACHE_WARMUP_RATE, val);
+        return LDAP_UNWILLING_TO_PERFORM;
+    }
+    if (apply) {
+        li->li_cache_warmup_rate = val;
+    }
+
+    return LDAP_SUCCESS;
+}
+
 static void *
 ldbm_config_rangelookthroughlimit_get(void *arg)
 {
@@ -1081,6 +1247,12 @@ static config_info ldbm_config[] = {
     {CONFIG_SERIAL_LOCK, CONFIG_TYPE_ONOFF, "on", &ldbm_config_serial_lock_get, &ldbm_config_serial_lock_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
     {CONFIG_USE_LEGACY_ERRORCODE, CONFIG_TYPE_ONOFF, "off", &ldbm_config_legacy_errcode_get, &ldbm_config_legacy_errcode_set, 0},
     {CONFIG_PAGEDLOOKTHROUGHLIMIT, CONFIG_TYPE_INT, "0", &ldbm_config_pagedlookthroughlimit_get, &ldbm_config_pagedlookthroughlimit_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
+    {CONFIG_SEARCH_READAHEAD, CONFIG_TYPE_INT, DEFAULT_SEARCH_READAHEAD_STR, &ldbm_config_search_readahead_get, &ldbm_config_search_readahead_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
+    {CONFIG_CACHE_AUTOTUNE_INTERVAL, CONFIG_TYPE_INT, DEFAULT_CACHE_AUTOTUNE_INTERVAL_STR, &ldbm_config_cache_autotune_interval_get, &ldbm_config_cache_autotune_interval_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
+    {CONFIG_CACHE_WARMUP, CONFIG_TYPE_ONOFF, "off", &ldbm_config_cache_warmup_get, &ldbm_config_cache_warmup_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
+    {CONFIG_CACHE_WARMUP_INTERVAL, CONFIG_TYPE_INT, DEFAULT_CACHE_WARMUP_INTERVAL_STR, &ldbm_config_cache_warmup_interval_get, &ldbm_config_cache_warmup_interval_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
+    {CONFIG_CACHE_WARMUP_THREADS, CONFIG_TYPE_INT, DEFAULT_CACHE_WARMUP_THREADS_STR, &ldbm_config_cache_warmup_threads_get, &ldbm_config_cache_warmup_threads_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
+    {CONFIG_CACHE_WARMUP_RATE, CONFIG_TYPE_INT, DEFAULT_CACHE_WARMUP_RATE_STR, &ldbm_config_cache_warmup_rate_get, &ldbm_config_cache_warmup_rate_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
     {CONFIG_PAGEDIDLISTSCANLIMIT, CONFIG_TYPE_INT, "0", &ldbm_config_pagedallidsthreshold_get, &ldbm_config_pagedallidsthreshold_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
     {CONFIG_RANGELOOKTHROUGHLIMIT, CONFIG_TYPE_INT, "5000", &ldbm_config_rangelookthroughlimit_get, &ldbm_config_rangelookthroughlimit_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
     {CONFIG_BACKEND_OPT_LEVEL, CONFIG_TYPE_INT, "1", &ldbm_config_backend_opt_level_get, &ldbm_config_backend_opt_level_set, CONFIG_FLAG_ALWAYS_SHOW},
@@ -59,6 +59,7 @@ struct config_info
 #define CONFIG_LOOKTHROUGHLIMIT "nsslapd-lookthroughlimit"
 #define CONFIG_RANGELOOKTHROUGHLIMIT "nsslapd-rangelookthroughlimit"
 #define CONFIG_PAGEDLOOKTHROUGHLIMIT "nsslapd-pagedlookthroughlimit"
+#define CONFIG_SEARCH_READAHEAD "nsslapd-search-readahead"
 #define CONFIG_IDLISTSCANLIMIT "nsslapd-idlistscanlimit"
 #define CONFIG_PAGEDIDLISTSCANLIMIT "nsslapd-pagedidlistscanlimit"
 #define CONFIG_DIRECTORY "nsslapd-directory"
@@ -69,6 +70,11 @@ struct config_info
 #define CONFIG_IMPORT_CACHE_AUTOSIZE "nsslapd-import-cache-autosize"
 #define CONFIG_CACHE_AUTOSIZE "nsslapd-cache-autosize"
 #define CONFIG_CACHE_AUTOSIZE_SPLIT "nsslapd-cache-autosize-split"
+#define CONFIG_CACHE_AUTOTUNE_INTERVAL "nsslapd-cache-autotune-interval"
+#define CONFIG_CACHE_WARMUP "nsslapd-cache-warmup"
+#define CONFIG_CACHE_WARMUP_INTERVAL "nsslapd-cache-warmup-interval"
+#define CONFIG_CACHE_WARMUP_THREADS "nsslapd-cache-warmup-threads"
+#define CONFIG_CACHE_WARMUP_RATE "nsslapd-cache-warmup-rate"
 #define CONFIG_IMPORT_CACHESIZE "nsslapd-import-cachesize"
 #define CONFIG_INDEX_BUFFER_SIZE "nsslapd-index-buffer-size"
 #define CONFIG_EXCLUDE_FROM_EXPORT "nsslapd-exclude-from-export"
@@ -132,6 +138,8 @@ struct config_info
 #define CONFIG_INSTANCE_CACHEMEMSIZE "nsslapd-cachememsize"
 #define CONFIG_INSTANCE_CACHE_PINNED_ENTRIES "nsslapd-cache-pinned-entries"
 #define CONFIG_INSTANCE_CACHE_DEBUG_PATTERN "nsslapd-cache-debug-pattern"
+#define CONFIG_INSTANCE_EXTVALUES_THRESHOLD "nsslapd-extvalues-threshold"
+#define CONFIG_INSTANCE_EXTVALUES_ATTRS "nsslapd-extvalues-attrs"
 #define CONFIG_INSTANCE_DNCACHEMEMSIZE "nsslapd-dncachememsize"
 #define CONFIG_INSTANCE_SUFFIX "nsslapd-suffix"
 #define CONFIG_INSTANCE_READONLY "nsslapd-readonly"
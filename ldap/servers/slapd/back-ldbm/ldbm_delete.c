@@ -783,7 +783,7 @@ replace_entry:
                               LDAP_OPERATIONS_ERROR, retry_count);
                 goto error_return;
             }
-            retval = id2entry_add(be, tombstone, &txn);
+            retval = id2entry_replace_ext(be, e, tombstone, &txn, 1, NULL);
             if (DBI_RC_RETRY == retval) {
                 slapi_log_err(SLAPI_LOG_BACKLDBM, "ldbm_back_delete", "delete 1 DBI_RC_RETRY\n");
                 /* Abort and re-try */
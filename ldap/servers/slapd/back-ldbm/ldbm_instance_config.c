@@ -416,6 +416,84 @@ ldbm_config_cache_debug_pattern_set(void *arg,
     return LDAP_SUCCESS;
 }
 
+static void *
+ldbm_config_extvalues_threshold_get(void *arg)
+{
+    struct ldbm_instance *inst = (struct ldbm_instance *)arg;
+
+    return (void *)((uintptr_t)(inst->extvalues_threshold));
+}
+
+static int
+ldbm_config_extvalues_threshold_set(void *arg,
+                                    void *value,
+                                    char *errorbuf,
+                                    int phase __attribute__((unused)),
+                                    int apply)
+{
+    struct ldbm_instance *inst = (struct ldbm_instance *)arg;
+
+    int64_t val = (int64_t)((uintptr_t)value);
+    if (val < 0) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE,
+                              "Error: Invalid value for %s (%ld). The value must not be negative\n",
+                              CONFIG_INSTANCE_EXTVALUES_THRESHOLD, val);
+        slapi_log_err(SLAPI_LOG_ERR, "ldbm_config_extvalues_threshold_set",
+                      "Invalid value for %s (%ld). The value must not be negative\n",
+                      CONFIG_INSTANCE_EXTVALUES_THRESHOLD, val);
+        return LDAP_UNWILLING_TO_PERFORM;
+    }
+    if (apply) {
+        inst->extvalues_threshold = val;
+    }
+    return LDAP_SUCCESS;
+}
+
+static void *
+ldbm_config_extvalues_attrs_get(void *arg)
+{
+    struct ldbm_instance *inst = (struct ldbm_instance *)arg;
+    char *p, *retstr = NULL;
+    size_t len = 0;
+
+    if (NULL == inst->extvalues_attrs || NULL == inst->extvalues_attrs[0]) {
+        return slapi_ch_strdup("");
+    }
+    for (size_t i = 0; inst->extvalues_attrs[i] != NULL; ++i) {
+        len += strlen(inst->extvalues_attrs[i]) + 1;
+    }
+    p = retstr = slapi_ch_malloc(len);
+    for (size_t i = 0; inst->extvalues_attrs[i] != NULL; ++i) {
+        if (i > 0) {
+            *p++ = ' ';
+        }
+        strcpy(p, inst->extvalues_attrs[i]);
+        p += strlen(p);
+    }
+    return retstr;
+}
+
+static int
+ldbm_config_extvalues_attrs_set(void *arg,
+                                void *value,
+                                char *errorbuf __attribute__((unused)),
+                                int phase __attribute__((unused)),
+                                int apply)
+{
+    struct ldbm_instance *inst = (struct ldbm_instance *)arg;
+
+    if (apply) {
+        charray_free(inst->extvalues_attrs);
+        inst->extvalues_attrs = NULL;
+        if (NULL != value && *(char *)value) {
+            char *dupvalue = slapi_ch_strdup(value);
+            inst->extvalues_attrs = slapi_str2charray(dupvalue, " ");
+            slapi_ch_free_string(&dupvalue);
+        }
+    }
+    return LDAP_SUCCESS;
+}
+
 
 /*------------------------------------------------------------------------
  * ldbm instance configuration array
@@ -429,6 +507,8 @@ static config_info ldbm_instance_config[] = {
     {CONFIG_INSTANCE_DNCACHEMEMSIZE, CONFIG_TYPE_UINT64, DEFAULT_DNCACHE_SIZE_STR, &ldbm_instance_config_dncachememsize_get, &ldbm_instance_config_dncachememsize_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
     {CONFIG_INSTANCE_CACHE_PINNED_ENTRIES, CONFIG_TYPE_INT, DEFAULT_CACHE_PINNED_ENTRIES_STR, &ldbm_config_cache_pinned_entries_get, &ldbm_config_cache_pinned_entries_set, CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
     {CONFIG_INSTANCE_CACHE_DEBUG_PATTERN, CONFIG_TYPE_STRING, NULL, &ldbm_config_cache_debug_pattern_get, &ldbm_config_cache_debug_pattern_set, CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
+    {CONFIG_INSTANCE_EXTVALUES_THRESHOLD, CONFIG_TYPE_INT, DEFAULT_EXTVALUES_THRESHOLD_STR, &ldbm_config_extvalues_threshold_get, &ldbm_config_extvalues_threshold_set, CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
+    {CONFIG_INSTANCE_EXTVALUES_ATTRS, CONFIG_TYPE_STRING, DEFAULT_EXTVALUES_ATTRS, &ldbm_config_extvalues_attrs_get, &ldbm_config_extvalues_attrs_set, CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
     {NULL, 0, NULL, NULL, NULL, 0}};
 
 void
@@ -1250,6 +1330,7 @@ ldbm_instance_post_delete_instance_entry_callback(Slapi_PBlock *pb __attribute__
     slapi_log_err(SLAPI_LOG_INFO, "ldbm_instance_post_delete_instance_entry_callback",
                   "Removing '%s'.\n", instance_name);
 
+    ldbm_cache_warmup_stop_instance(inst);
     cache_destroy_please(&inst->inst_cache, CACHE_TYPE_ENTRY);
     cache_destroy_please(&inst->inst_dncache, CACHE_TYPE_DN);
 
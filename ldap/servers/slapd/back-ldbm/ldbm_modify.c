@@ -187,7 +187,7 @@ modify_update_all(backend *be, Slapi_PBlock *pb, modify_context *mc, back_txn *t
      * Update the ID to Entry index.
      * Note that id2entry_add replaces the entry, so the Entry ID stays the same.
      */
-    retval = id2entry_add_ext(be, mc->new_entry, txn, mc->attr_encrypt, NULL);
+    retval = id2entry_replace_ext(be, mc->old_entry, mc->new_entry, txn, mc->attr_encrypt, NULL);
     if (0 != retval) {
         if (DBI_RC_RETRY != retval) {
             ldbm_nasty(function_name, "", 66, retval);
@@ -869,7 +869,7 @@ ldbm_back_modify(Slapi_PBlock *pb)
          * Note that id2entry_add replaces the entry, so the Entry ID
          * stays the same.
          */
-        retval = id2entry_add_ext(be, ec, &txn, 1, &cache_rc);
+        retval = id2entry_replace_ext(be, e, ec, &txn, 1, &cache_rc);
         if (DBI_RC_RETRY == retval) {
             /* Abort and re-try */
             continue;
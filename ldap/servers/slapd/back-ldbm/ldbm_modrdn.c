@@ -1664,7 +1664,7 @@ dsentrydn_modrdn_update(
     ec = backentry_dup(e);
     slapi_entry_attr_set_charptr(ec->ep_entry, SLAPI_ATTR_DS_ENTRYDN, newdn);
     slapi_entry_set_dn(ec->ep_entry, (char *)newdn);
-    ret = id2entry_add_ext(be, ec, txn, 1, &cache_rc);
+    ret = id2entry_replace_ext(be, e, ec, txn, 1, &cache_rc);
     if (cache_rc) {
         slapi_log_err(SLAPI_LOG_CACHE,
                       "dsentrydn_modrdn_update",
@@ -1956,7 +1956,7 @@ modrdn_rename_entry_update_indexes(back_txn *ptxn, Slapi_PBlock *pb, struct ldbm
      * Update the ID to Entry index.
      * Note that id2entry_add replaces the entry, so the Entry ID stays the same.
      */
-    retval = id2entry_add_ext(be, *ec, ptxn, 1, &cache_rc);
+    retval = id2entry_replace_ext(be, e, *ec, ptxn, 1, &cache_rc);
     if (cache_rc) {
         slapi_log_err(SLAPI_LOG_CACHE,
                       "modrdn_rename_entry_update_indexes",
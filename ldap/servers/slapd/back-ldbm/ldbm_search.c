@@ -360,71 +360,13 @@ ldbm_search_compile_filter(Slapi_Filter *f, void *arg __attribute__((unused)))
 {
     int rc = SLAPI_FILTER_SCAN_CONTINUE;
     if (f->f_choice == LDAP_FILTER_SUBSTRINGS) {
-        char pat[BUFSIZ];
-        char *p, *end, *bigpat = NULL;
-        size_t size = 0;
-        Slapi_Regex *re = NULL;
-        char *re_result = NULL;
-        int i = 0;
-
-        PR_ASSERT(NULL == f->f_un.f_un_sub.sf_private);
         /*
-         * construct a regular expression corresponding to the filter
+         * The filter is normalized: build the matcher used by
+         * string_filter_sub from the components as they are
          */
-        pat[0] = '\0';
-        p = pat;
-        end = pat + sizeof(pat) - 2; /* leave room for null */
-
-        if (f->f_sub_initial != NULL) {
-            size = strlen(f->f_sub_initial) + 1; /* add 1 for "^" */
-        }
-
-        while (f->f_sub_any && f->f_sub_any[i]) {
-            size += strlen(f->f_sub_any[i++]) + 2; /* add 2 for ".*" */
-        }
-
-        if (f->f_sub_final != NULL) {
-            size += strlen(f->f_sub_final) + 3; /* add 3 for ".*" and "$" */
-        }
-
-        size *= 2; /* doubled in case all filter chars need escaping (regex special chars) */
-        size++;    /* add 1 for null */
-
-        if (p + size > end) {
-            bigpat = slapi_ch_malloc(size);
-            p = bigpat;
-        }
-        if (f->f_sub_initial != NULL) {
-            *p++ = '^';
-            p = filter_strcpy_special_ext(p, f->f_sub_initial, FILTER_STRCPY_ESCAPE_RECHARS);
-        }
-        for (i = 0; f->f_sub_any && f->f_sub_any[i]; i++) {
-            /* ".*" + value */
-            *p++ = '.';
-            *p++ = '*';
-            p = filter_strcpy_special_ext(p, f->f_sub_any[i], FILTER_STRCPY_ESCAPE_RECHARS);
-        }
-        if (f->f_sub_final != NULL) {
-            /* ".*" + value */
-            *p++ = '.';
-            *p++ = '*';
-            p = filter_strcpy_special_ext(p, f->f_sub_final, FILTER_STRCPY_ESCAPE_RECHARS);
-            strcat(p, "$");
-        }
-
-        /* compile the regex */
-        p = bigpat ? bigpat : pat;
-        re = slapi_re_comp(p, &re_result);
-        if (NULL == re) {
-            slapi_log_err(SLAPI_LOG_ERR, "ldbm_search_compile_filter", "re_comp (%s) failed (%s): %s\n",
-                          pat, p, re_result ? re_result : "unknown");
-            slapi_ch_free_string(&re_result);
-            rc = SLAPI_FILTER_SCAN_ERROR;
-        } else {
-            char ebuf[BUFSIZ];
-            slapi_log_err(SLAPI_LOG_TRACE, "ldbm_search_compile_filter", "re_comp (%s)\n",
-                          escape_string(p, ebuf));
-            f->f_un.f_un_sub.sf_private = (void *)re;
+        if (NULL == f->f_un.f_un_sub.sf_private) {
+            f->f_un.f_un_sub.sf_private = (void *)slapi_substr_matcher_new(f->f_sub_initial, f->f_sub_any,
+                                                                           f->f_sub_final, 0);
         }
     } else if (f->f_choice == LDAP_FILTER_EQUALITY) {
         /* store the flags in the ava_private - should be ok - points
@@ -440,8 +382,7 @@ ldbm_search_free_compiled_filter(Slapi_Filter *f, void *arg __attribute__((unuse
     int rc = SLAPI_FILTER_SCAN_CONTINUE;
     if ((f->f_choice == LDAP_FILTER_SUBSTRINGS) &&
         (f->f_un.f_un_sub.sf_private)) {
-        slapi_re_free((Slapi_Regex *)f->f_un.f_un_sub.sf_private);
-        f->f_un.f_un_sub.sf_private = NULL;
+        slapi_substr_matcher_free((Slapi_SubstrMatcher **)&f->f_un.f_un_sub.sf_private);
     } else if (f->f_choice == LDAP_FILTER_EQUALITY) {
         /* clear the flags in the ava_private */
         f->f_un.f_un_ava.ava_private = NULL;
@@ -808,8 +749,10 @@ ldbm_back_search(Slapi_PBlock *pb)
             }
         }
         if (candidates == NULL) {
+            uint64_t build_start = latency_stats_now();
             int rc = build_candidate_list(pb, be, e, base, scope,
                                           &lookup_returned_allids, &candidates);
+            latency_stats_record(LATENCY_PHASE_CANDIDATES, build_start);
             if (rc) {
                 /* Error result sent by build_candidate_list */
                 if (virtual_list_view) {
@@ -1150,6 +1093,10 @@ ldbm_back_search(Slapi_PBlock *pb)
         /* step 2 - pre-compile the substr regex and the equality flags */
         rc = slapi_filter_apply(sr->sr_norm_filter, ldbm_search_compile_filter,
                                 NULL, &filt_errs);
+        /* step 3 - compile the filter tested against the candidates */
+        if (rc == SLAPI_FILTER_SCAN_NOMORE) {
+            slapi_filter_compile(sr->sr_norm_filter);
+        }
 
         if (rc == SLAPI_FILTER_SCAN_NOMORE && filter_intent) {
             slapi_filter_free(sr->sr_norm_filter_intent, 1);
@@ -1708,6 +1655,37 @@ non_target_cache_return(Slapi_Operation *op, struct cache *cache, struct backent
     }
 }
 
+/*
+ * Read ahead the candidates from the current one (the one just taken from
+ * the iterator), at most count of them and not past the lookthrough limit:
+ * id2entry_prefetch() reads those that are not cached with a single cursor.
+ */
+static void
+search_readahead(backend *be, back_search_result_set *sr, int count, back_txn *txn)
+{
+    ID *ids = NULL;
+    size_t nids = 0;
+    idl_iterator it = sr->sr_current - 1;
+
+    if (sr->sr_lookthroughlimit != -1 && sr->sr_lookthroughlimit - sr->sr_lookthroughcount + 1 < count) {
+        count = sr->sr_lookthroughlimit - sr->sr_lookthroughcount + 1;
+    }
+    if (count <= 1) {
+        return;
+    }
+    ids = (ID *)slapi_ch_malloc(count * sizeof(ID));
+    for (; nids < (size_t)count; nids++) {
+        ID id = idl_iterator_dereference(it + nids, sr->sr_candidates);
+        if (id == NOID) {
+            break;
+        }
+        ids[nids] = id;
+    }
+    sr->sr_readahead = it + nids;
+    id2entry_prefetch(be, ids, nids, txn);
+    slapi_ch_free((void **)&ids);
+}
+
 /*
  * Return the next entry in the result set.  The entry is returned
  * in the pblock.
@@ -1746,6 +1724,7 @@ ldbm_back_next_search_entry(Slapi_PBlock *pb)
     Slapi_Operation *op;
     int reverse_list = 0;
     int32_t internal_op = 0;
+    int snapshot = 0;
 
     slapi_pblock_get(pb, SLAPI_SEARCH_TARGET_SDN, &basesdn);
     if (NULL == basesdn) {
@@ -1791,6 +1770,15 @@ ldbm_back_next_search_entry(Slapi_PBlock *pb)
         dblayer_txn_init(li, &txn);
         slapi_pblock_set(pb, SLAPI_TXN, txn.back_txn_txn);
     }
+    if (!txn.back_txn_txn && dblayer_is_lmdb(be) && dblayer_snapshot_txn_begin(be, &txn) == 0) {
+        /*
+         * Rather than a txn per entry, read the candidates in a snapshot txn
+         * renewed between two candidates when it gets old: a long search
+         * then resumes from the next candidate id without preventing the
+         * reuse of the db pages freed meanwhile.
+         */
+        snapshot = 1;
+    }
 
     if (sr->sr_norm_filter) {
         filter = sr->sr_norm_filter;
@@ -1845,6 +1833,11 @@ ldbm_back_next_search_entry(Slapi_PBlock *pb)
 
     /* Find the next candidate entry and return it. */
     while (1) {
+        if (snapshot && dblayer_snapshot_txn_renew(be, &txn) < 0) {
+            /* go on with a txn per entry */
+            dblayer_snapshot_txn_commit(be, &txn);
+            snapshot = 0;
+        }
         if (li->li_dblock_monitoring &&
             slapi_atomic_load_32((int32_t *)&(li->li_dblock_threshold_reached), __ATOMIC_RELAXED)) {
             slapi_log_err(SLAPI_LOG_CRIT, "ldbm_back_next_search_entry",
@@ -1944,7 +1937,20 @@ ldbm_back_next_search_entry(Slapi_PBlock *pb)
             /* if the entry is not the target_entry (base search)
              * we need to fetch it from the entry cache (it was not
              * referenced in the operation) */
-            e = id2entry(be, id, &txn, &err);
+            uint64_t fetch_start = latency_stats_now();
+
+            e = NULL;
+            if (!reverse_list && li->li_search_readahead > 1 && sr->sr_current > sr->sr_readahead) {
+                /* past the entries read ahead: read the next ones if this one is not cached */
+                e = cache_find_id(&inst->inst_cache, id);
+                if (e == NULL) {
+                    search_readahead(be, sr, li->li_search_readahead, &txn);
+                }
+            }
+            if (e == NULL) {
+                e = id2entry(be, id, &txn, &err);
+            }
+            latency_stats_record(LATENCY_PHASE_FETCH, fetch_start);
         }
         if (e == NULL) {
             if (err != 0 && err != DBI_RC_NOTFOUND) {
@@ -2171,6 +2177,9 @@ ldbm_back_next_search_entry(Slapi_PBlock *pb)
     }
 
 bail:
+    if (snapshot) {
+        dblayer_snapshot_txn_commit(be, &txn);
+    }
     if (rc && op) {
         op->o_reverse_search_state = 0;
     }
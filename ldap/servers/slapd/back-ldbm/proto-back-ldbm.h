@@ -45,6 +45,8 @@ void cache_set_max_entries(struct cache *cache, int64_t entries, bool autotuned)
 uint64_t cache_get_max_size(struct cache *cache);
 int64_t cache_get_max_entries(struct cache *cache);
 void cache_get_stats(struct cache *cache, struct cache_stats *stats);
+void cache_ghost_resize(struct cache *cache, uint64_t nslots);
+ID *cache_get_ids(struct cache *cache, uint64_t *count);
 void cache_debug_hash(struct cache *cache, char **out);
 int cache_remove(struct cache *cache, void *e);
 void cache_return(struct cache *cache, void **bep);
@@ -75,6 +77,24 @@ int remove_hash(Hashtable *ht, const void *key, uint32_t keylen);
 
 struct backdn *dncache_find_id(struct cache *cache, ID id);
 
+/*
+ * cache_autotune.c
+ */
+void ldbm_cache_autotune_start(struct ldbminfo *li);
+void ldbm_cache_autotune_stop(struct ldbminfo *li);
+void ldbm_cache_autotune_destroy(struct ldbminfo *li);
+void ldbm_cache_autotune_monitor(struct ldbminfo *li, Slapi_Entry *e);
+void ldbm_cache_autotune_monitor_instance(ldbm_instance *inst, Slapi_Entry *e);
+
+/*
+ * cache_warmup.c
+ */
+void ldbm_cache_warmup_start(struct ldbminfo *li);
+void ldbm_cache_warmup_stop(struct ldbminfo *li);
+void ldbm_cache_warmup_schedule(struct ldbminfo *li);
+void ldbm_cache_warmup_stop_instance(ldbm_instance *inst);
+void ldbm_cache_warmup_monitor_instance(ldbm_instance *inst, Slapi_Entry *e);
+
 /*
  * dblayer.c
  */
@@ -88,6 +108,7 @@ int dblayer_release_index_file(backend *be, struct attrinfo *a, dbi_db_t *pDB);
 int dblayer_erase_index_file(backend *be, struct attrinfo *a, PRBool use_lock, int no_force_chkpt);
 int dblayer_get_id2entry(backend *be, dbi_db_t **ppDB);
 int dblayer_get_changelog(backend *be, dbi_db_t ** ppDB, int create);
+int dblayer_get_extvalues(backend *be, dbi_db_t **ppDB, int create);
 int dblayer_release_id2entry(backend *be, dbi_db_t *pDB);
 void dblayer_destroy_txn_stack(void);
 int dblayer_txn_init(struct ldbminfo *li, back_txn *txn);
@@ -100,6 +121,9 @@ int dblayer_txn_abort_ext(struct ldbminfo *li, back_txn *txn, PRBool use_lock);
 int dblayer_read_txn_abort(backend *be, back_txn *txn);
 int dblayer_read_txn_begin(backend *be, back_txnid parent_txn, back_txn *txn);
 int dblayer_read_txn_commit(backend *be, back_txn *txn);
+int dblayer_snapshot_txn_begin(backend *be, back_txn *txn);
+int dblayer_snapshot_txn_commit(backend *be, back_txn *txn);
+int dblayer_snapshot_txn_renew(backend *be, back_txn *txn);
 int dblayer_txn_begin_all(struct ldbminfo *li, back_txnid parent_txn, back_txn *txn);
 int dblayer_txn_commit_all(struct ldbminfo *li, back_txn *txn);
 int dblayer_txn_abort_all(struct ldbminfo *li, back_txn *txn);
@@ -108,7 +132,7 @@ void dblayer_lock_backend(backend *be);
 int dblayer_plugin_begin(Slapi_PBlock *pb);
 int dblayer_plugin_commit(Slapi_PBlock *pb);
 int dblayer_plugin_abort(Slapi_PBlock *pb);
-int dblayer_backup(struct ldbminfo *li, char *destination_directory, Slapi_Task *task);
+int dblayer_backup(struct ldbminfo *li, char *destination_directory, const char *base_dir, int flags, Slapi_Task *task);
 int dblayer_restore(struct ldbminfo *li, char *source_directory, Slapi_Task *task);
 int dblayer_delete_database(struct ldbminfo *li);
 int dblayer_close_indexes(backend *be);
@@ -183,8 +207,12 @@ int has_children(struct ldbminfo *li, struct backentry *p, back_txn *txn, int *e
  */
 int id2entry_add(backend *be, struct backentry *e, back_txn *txn);
 int id2entry_add_ext(backend *be, struct backentry *e, back_txn *txn, int encrypt, int *cache_res);
+int id2entry_replace_ext(backend *be, struct backentry *olde, struct backentry *e, back_txn *txn, int encrypt, int *cache_res);
 int id2entry_delete(backend *be, struct backentry *e, back_txn *txn);
 struct backentry *id2entry(backend *be, ID id, back_txn *txn, int *err);
+struct backentry *id2entry_nocache(backend *be, ID id, back_txn *txn, int *err);
+int id2entry_extvalues_load(backend *be, ID id, Slapi_Entry *e, back_txn *txn);
+void id2entry_prefetch(backend *be, const ID *ids, size_t nids, back_txn *txn);
 
 /*
  * idl.c
@@ -169,6 +169,12 @@ ldbm_back_start(Slapi_PBlock *pb)
     /* initialize the USN counter */
     ldbm_usn_init(li);
 
+    /* rebalance the caches online when they are autosized */
+    ldbm_cache_autotune_start(li);
+
+    /* reload the entries that were hot before the restart */
+    ldbm_cache_warmup_start(li);
+
     slapi_log_err(SLAPI_LOG_TRACE, "ldbm_back_start", "ldbm backend done starting\n");
 
     return (0);
@@ -86,6 +86,7 @@ static int32_t current_busy_workers = 0;   /* workers currently processing ops *
 static int32_t max_busy_workers = 0;       /* high water mark of busy workers */
 
 #define LDAP_SOCKET_IO_BUFFER_SIZE 512 /* Size of the buffer we give to the I/O system for reads */
+#define LDAP_SOCKET_IO_BUFFER_MAX 65536 /* Largest size the adaptive buffer grows to */
 
 static struct Slapi_work_q *
 create_work_q(void)
@@ -473,6 +474,7 @@ init_op_threads(int32_t threadnumber)
     op_stack = PR_CreateStack("connection_operation");
     alloc_per_thread_snmp_vars(max_threads);
     init_thread_private_snmp_vars();
+    latency_stats_init(max_threads);
 
     threads_indexes = (int32_t *) slapi_ch_calloc(max_threads, sizeof(int32_t));
     for (size_t i = 0; i < max_threads; i++) {
@@ -571,6 +573,7 @@ connection_dispatch_operation(Connection *conn, Operation *op, Slapi_PBlock *pb)
     int32_t minssf = conn->c_minssf;
     int32_t minssf_exclude_rootdse = conn->c_minssf_exclude_rootdse;
     int32_t log_format = config_get_accesslog_log_format();
+    struct timespec wq_time;
 
 #ifdef TCP_CORK
     int32_t enable_nagle = conn->c_enable_nagle;
@@ -594,6 +597,9 @@ connection_dispatch_operation(Connection *conn, Operation *op, Slapi_PBlock *pb)
 
     /* Set the start time */
     slapi_operation_set_time_started(op);
+    slapi_operation_workq_time_elapsed(op, &wq_time);
+    latency_stats_record_ns(LATENCY_PHASE_QUEUE,
+                            (uint64_t)wq_time.tv_sec * 1000000000ULL + (uint64_t)wq_time.tv_nsec);
 
     /* difficult to detect false asynch operations
      * Indeed because of scheduling of threads a previous
@@ -1198,14 +1204,19 @@ connection_read_ldap_data(Connection *conn, PRInt32 *err)
     if (ret < 0) {
         *err = PR_GetError();
     } else if (CONNECTION_BUFFER_ADAPT == conn->c_private->use_buffer) {
-        if ((ret == conn->c_private->c_buffer_size) && (conn->c_private->c_buffer_size < BUFSIZ)) {
+        if ((ret == conn->c_private->c_buffer_size) && (conn->c_private->c_buffer_size < LDAP_SOCKET_IO_BUFFER_MAX)) {
             /* we read exactly what we requested - there could be more that we could have read */
             /* so increase the buffer size */
             conn->c_private->c_buffer_size *= 2;
-            if (conn->c_private->c_buffer_size > BUFSIZ) {
-                conn->c_private->c_buffer_size = BUFSIZ;
+            if (conn->c_private->c_buffer_size > LDAP_SOCKET_IO_BUFFER_MAX) {
+                conn->c_private->c_buffer_size = LDAP_SOCKET_IO_BUFFER_MAX;
             }
             conn->c_private->c_buffer = slapi_ch_realloc(conn->c_private->c_buffer, conn->c_private->c_buffer_size);
+        } else if ((ret < conn->c_private->c_buffer_size / 8) && (conn->c_private->c_buffer_size > BUFSIZ)) {
+            /* the burst is over, give back the memory of the idle connections
+             * (the data read fits in the smaller buffer) */
+            conn->c_private->c_buffer_size /= 2;
+            conn->c_private->c_buffer = slapi_ch_realloc(conn->c_private->c_buffer, conn->c_private->c_buffer_size);
         }
     }
     return ret;
@@ -1224,6 +1235,19 @@ conn_buffered_data_avail_nolock(Connection *conn, int *conn_closed)
     }
 }
 
+/*
+ * Is there data to process without waiting for the socket: in the
+ * connection buffer, or kept by the SASL I/O layer ?
+ */
+static int
+conn_pending_data_nolock(Connection *conn, int *conn_closed)
+{
+    if (conn_buffered_data_avail_nolock(conn, conn_closed)) {
+        return 1;
+    }
+    return !*conn_closed && conn->c_sasl_ssf && sasl_io_has_buffered_data(conn);
+}
+
 /* Function to convert a PRNetAddr to a normalized IPv4 string and keep original address string. */
 static void
 normalize_IPv4(const PRNetAddr *addr, char *normalizedAddr, size_t normalizedAddrSize, char *originalAddr, size_t originalAddrSize)
@@ -1533,7 +1557,7 @@ connection_read_operation(Connection *conn, Operation *op, ber_tag_t *tag, int *
         }
     }
     /* If there is remaining buffered data, set the flag to tell the caller */
-    if (conn_buffered_data_avail_nolock(conn, &conn_closed)) {
+    if (conn_pending_data_nolock(conn, &conn_closed)) {
         *remaining_data = 1;
     } else if (conn_closed) {
         /* connection closed */
@@ -2184,7 +2208,7 @@ connection_threadmain(void *arg)
                 more_data = 0;
             } else {
                 /* normal connection or already established replication connection */
-                more_data = conn_buffered_data_avail_nolock(conn, &conn_closed) ? 1 : 0;
+                more_data = conn_pending_data_nolock(conn, &conn_closed);
             }
             if (!more_data) {
                 if (!thread_turbo_flag) {
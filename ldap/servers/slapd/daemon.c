@@ -1411,6 +1411,9 @@ slapd_daemon(daemon_ports_t *ports)
 
     ct_thread_cleanup();
     op_thread_cleanup();
+    pw_verify_cache_stop(); /* no bind can be running anymore */
+    search_fanout_stop();   /* nor any search */
+    writebehind_stop();     /* before the backends are closed */
     housekeeping_stop(); /* Run this after op_thread_cleanup() logged sth */
     disk_monitoring_stop();
     slapi_referral_check_stop();
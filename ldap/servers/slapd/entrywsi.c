@@ -927,6 +927,9 @@ entry_apply_mod_wsi(Slapi_Entry *e, const LDAPMod *mod, const CSN *csn, int urp)
 
             /* remove the attribute from the attr list */
             a = attrlist_remove(&e->e_attrs, mod->mod_type);
+            if (a) {
+                valueset_unshare(&a->a_present_values);
+            }
             if (a && a->a_present_values.va) {
                 /* a->a_present_values.va is consumed if successful. */
                 int rc = slapi_pw_set_entry_ext(e, a->a_present_values.va,
@@ -1467,6 +1470,10 @@ resolve_attribute_state_single_valued(Slapi_Entry *e, Slapi_Attr *a, int attribu
     int32_t nbval, i;
     Slapi_Value *current_value = NULL;
 
+    /* the values found below are moved between the present and deleted values */
+    valueset_unshare(&a->a_present_values);
+    valueset_unshare(&a->a_deleted_values);
+
     /* retrieve the current value(s) */
     slapi_attr_get_numvalues(a, &nbval);
     i = slapi_attr_first_value(a, &current_value);
@@ -25,6 +25,24 @@ There is also an initialization point which must be
 called by the server to initialize the event queue system:
 eq_start_rel(), and an entry point used to shut down the system:
 eq_stop_rel().
+
+The pending events are kept in a hierarchical timer wheel with
+a one second tick: EQ_WHEEL_LEVELS wheels of EQ_WHEEL_SIZE slots,
+each slot of a level spanning a whole turn of the level below.
+An event is put in the slot of its second in the lowest level
+which reaches it, and moved down a level when the wheel above
+turns to its slot. Scheduling and cancelling an event do not
+depend on the number of events.
+
+The due events are called by a pool of nsslapd-eventq-executors
+threads (4 by default), so that a slow callback only delays the
+events behind it in the pool. The events of a same function are
+called one at a time, in their order, so a callback needs no
+lock for the state it keeps between its calls. The state it
+shares with other callbacks is also used by the operations,
+which run concurrently anyway. A repeating event is scheduled
+again when its callback returns. How late the callbacks are
+called is kept in a histogram shown in cn=monitor.
 *********************************************************** */
 
 #include "slap.h"
@@ -32,6 +50,20 @@ eq_stop_rel().
 #include "prcvar.h"
 #include "prinit.h"
 
+#define EQ_WHEEL_BITS 6
+#define EQ_WHEEL_SIZE (1 << EQ_WHEEL_BITS)
+#define EQ_WHEEL_MASK (EQ_WHEEL_SIZE - 1)
+#define EQ_WHEEL_LEVELS 4
+/* about 194 days, the events further away wait in the top level */
+#define EQ_WHEEL_SPAN ((time_t)1 << (EQ_WHEEL_BITS * EQ_WHEEL_LEVELS))
+#define EQ_MAX_EXECUTORS 64
+#define EQ_LATENESS_BUCKETS 6
+
+#define EQ_EVENT_PENDING 0   /* in the wheel */
+#define EQ_EVENT_DUE 1       /* waiting for an executor */
+#define EQ_EVENT_RUNNING 2   /* the callback is being called */
+#define EQ_EVENT_CANCELLED 3 /* cancelled while its callback was called */
+
 /*
  * Private definition of slapi_eq_context. Only this
  * module (eventq.c) should know about the layout of
@@ -45,6 +77,8 @@ typedef struct _slapi_eq_context
     void *ec_arg;
     Slapi_Eq_Context ec_id;
     struct _slapi_eq_context *ec_next;
+    struct _slapi_eq_context **ec_prevp; /* link to this event in its slot, NULL when unlinked */
+    int ec_state;
 } slapi_eq_context;
 
 /*
@@ -54,9 +88,23 @@ typedef struct _event_queue
 {
     pthread_mutex_t eq_lock;
     pthread_cond_t eq_cv;
-    slapi_eq_context *eq_queue;
+    slapi_eq_context *eq_wheel[EQ_WHEEL_LEVELS][EQ_WHEEL_SIZE];
+    slapi_eq_context *eq_due; /* expired events, waiting for an executor */
+    slapi_eq_context **eq_due_tail;
+    time_t eq_tick;      /* next second of the wheel to expire */
+    uint64_t eq_count;   /* events in the wheel */
+    PLHashTable *eq_events; /* Slapi_Eq_Context -> pending or running event */
+    uint64_t eq_lateness[EQ_LATENESS_BUCKETS];
+    uint64_t eq_max_lateness;
 } event_queue;
 
+/*
+ * Upper bounds, in milliseconds, of the lateness histogram buckets.
+ * The last bucket has no bound.
+ */
+static const uint64_t eq_lateness_bounds[EQ_LATENESS_BUCKETS - 1] = {10, 100, 1000, 10000, 60000};
+static const char *eq_lateness_names[EQ_LATENESS_BUCKETS] = {"10ms", "100ms", "1s", "10s", "60s", "inf"};
+
 /*
  * The event queue itself.
  */
@@ -64,9 +112,16 @@ static event_queue eqs_rel = {0};
 static event_queue *eq_rel = &eqs_rel;
 
 /*
- * Thread ID of the main thread loop
+ * Thread IDs of the executors
  */
-static PRThread *eq_loop_rel_tid = NULL;
+static PRThread *eq_loop_rel_tid[EQ_MAX_EXECUTORS] = {0};
+static int32_t eq_executors = 0;
+
+/*
+ * Function being called by each executor, NULL when idle.
+ * Protected by eq_lock.
+ */
+static slapi_eq_fn_t eq_running_fn[EQ_MAX_EXECUTORS] = {0};
 
 /*
  * Flags used to control startup/shutdown of the event queue
@@ -74,14 +129,13 @@ static PRThread *eq_loop_rel_tid = NULL;
 static int eq_rel_running = 0;
 static int eq_rel_stopped = 0;
 static int eq_rel_initialized = 0;
-static pthread_mutex_t ss_rel_lock;
-static pthread_cond_t ss_rel_cv;
 PRCallOnceType init_once_rel = {0};
 
 /* Forward declarations */
 static slapi_eq_context *eq_new_rel(slapi_eq_fn_t fn, void *arg, time_t when, unsigned long interval);
 static void eq_enqueue_rel(slapi_eq_context *newec);
-static slapi_eq_context *eq_dequeue_rel(time_t now);
+static void eq_unlink(slapi_eq_context *ec);
+static void eq_wheel_insert(slapi_eq_context *ec);
 static PRStatus eq_create_rel(void);
 
 
@@ -144,14 +198,17 @@ Slapi_Eq_Context
 slapi_eq_repeat_rel(slapi_eq_fn_t fn, void *arg, time_t when, unsigned long interval)
 {
     slapi_eq_context *tmp;
+    Slapi_Eq_Context id;
+
     PR_ASSERT(eq_rel_initialized);
     if (!eq_rel_stopped) {
         tmp = eq_new_rel(fn, arg, when, interval);
+        id = tmp->ec_id;
         eq_enqueue_rel(tmp);
         slapi_log_err(SLAPI_LOG_HOUSE, NULL,
                       "added repeating event id %p at time %ld, interval %lu\n",
-                      tmp->ec_id, when, interval);
-        return (tmp->ec_id);
+                      id, when, interval);
+        return (id);
     }
     return NULL; /* JCM - Not sure if this should be 0 or something else. */
 }
@@ -161,26 +218,31 @@ slapi_eq_repeat_rel(slapi_eq_fn_t fn, void *arg, time_t when, unsigned long inte
  * slapi_eq_cancel_rel: cancel a pending event.
  * Arguments:
  *  ctx: the context of the event which should be de-scheduled
+ * Returns 1 if the event was pending. An event whose callback
+ * is running is not found, but a repeating one is not called
+ * again.
  */
 int
 slapi_eq_cancel_rel(Slapi_Eq_Context ctx)
 {
-    slapi_eq_context **p, *tmp = NULL;
+    slapi_eq_context *p;
     int found = 0;
 
     PR_ASSERT(eq_rel_initialized);
     if (!eq_rel_stopped) {
         pthread_mutex_lock(&(eq_rel->eq_lock));
-        p = &(eq_rel->eq_queue);
-        while (!found && *p != NULL) {
-            if ((*p)->ec_id == ctx) {
-                tmp = *p;
-                *p = (*p)->ec_next;
-                slapi_ch_free((void **)&tmp);
-                found = 1;
-            } else {
-                p = &((*p)->ec_next);
+        p = (slapi_eq_context *)PL_HashTableLookup(eq_rel->eq_events, ctx);
+        if (p && (p->ec_state == EQ_EVENT_RUNNING || p->ec_state == EQ_EVENT_CANCELLED)) {
+            /* freed by its executor when the callback returns */
+            p->ec_state = EQ_EVENT_CANCELLED;
+        } else if (p) {
+            if (p->ec_state == EQ_EVENT_PENDING) {
+                eq_rel->eq_count--;
             }
+            eq_unlink(p);
+            PL_HashTableRemove(eq_rel->eq_events, ctx);
+            slapi_ch_free((void **)&p);
+            found = 1;
         }
         pthread_mutex_unlock(&(eq_rel->eq_lock));
     }
@@ -215,120 +277,291 @@ eq_new_rel(slapi_eq_fn_t fn, void *arg, time_t when, unsigned long interval)
 
 
 /*
- * Add a new event to the event queue.
+ * The contexts are the addresses of the events
+ */
+static PLHashNumber
+eq_hash_ctx(const void *key)
+{
+    return (PLHashNumber)((uintptr_t)key >> 4);
+}
+
+
+/*
+ * Remove an event from its slot or from the due list.
  */
 static void
-eq_enqueue_rel(slapi_eq_context *newec)
+eq_unlink(slapi_eq_context *ec)
 {
-    slapi_eq_context **p;
+    if (ec->ec_prevp == NULL) {
+        return;
+    }
+    if (eq_rel->eq_due_tail == &(ec->ec_next)) {
+        eq_rel->eq_due_tail = ec->ec_prevp;
+    }
+    *(ec->ec_prevp) = ec->ec_next;
+    if (ec->ec_next) {
+        ec->ec_next->ec_prevp = ec->ec_prevp;
+    }
+    ec->ec_next = NULL;
+    ec->ec_prevp = NULL;
+}
 
-    PR_ASSERT(NULL != newec);
-    pthread_mutex_lock(&(eq_rel->eq_lock));
-    /* Insert <newec> in order (sorted by start time) in the list */
-    for (p = &(eq_rel->eq_queue); *p != NULL; p = &((*p)->ec_next)) {
-        if ((*p)->ec_when > newec->ec_when) {
-            break;
+
+/*
+ * Append an expired event to the due list, and wake up
+ * an executor for it.
+ */
+static void
+eq_due_append(slapi_eq_context *ec)
+{
+    ec->ec_state = EQ_EVENT_DUE;
+    ec->ec_next = NULL;
+    ec->ec_prevp = eq_rel->eq_due_tail;
+    *(eq_rel->eq_due_tail) = ec;
+    eq_rel->eq_due_tail = &(ec->ec_next);
+    pthread_cond_signal(&(eq_rel->eq_cv));
+}
+
+
+/*
+ * Put an event in the wheel, in the lowest level reaching its
+ * second, or in the due list if it has expired. The lock must
+ * be held.
+ */
+static void
+eq_wheel_insert(slapi_eq_context *ec)
+{
+    slapi_eq_context **slot;
+    time_t delta;
+    time_t when = ec->ec_when;
+    int level = 0;
+
+    if (when < eq_rel->eq_tick) {
+        eq_due_append(ec);
+        return;
+    }
+    delta = when - eq_rel->eq_tick;
+    if (delta >= EQ_WHEEL_SPAN) {
+        /* park it in the top level, it will be put back from there */
+        delta = EQ_WHEEL_SPAN - 1;
+        when = eq_rel->eq_tick + delta;
+    }
+    while (delta >= ((time_t)1 << (EQ_WHEEL_BITS * (level + 1)))) {
+        level++;
+    }
+    slot = &(eq_rel->eq_wheel[level][(when >> (EQ_WHEEL_BITS * level)) & EQ_WHEEL_MASK]);
+
+    ec->ec_state = EQ_EVENT_PENDING;
+    ec->ec_next = *slot;
+    if (ec->ec_next) {
+        ec->ec_next->ec_prevp = &(ec->ec_next);
+    }
+    ec->ec_prevp = slot;
+    *slot = ec;
+    eq_rel->eq_count++;
+}
+
+
+/*
+ * Move the events of a slot of an upper level to the levels below.
+ */
+static void
+eq_wheel_cascade(int level, int index)
+{
+    slapi_eq_context *ec = eq_rel->eq_wheel[level][index];
+
+    eq_rel->eq_wheel[level][index] = NULL;
+    while (ec) {
+        slapi_eq_context *next = ec->ec_next;
+
+        eq_rel->eq_count--;
+        ec->ec_next = NULL;
+        ec->ec_prevp = NULL;
+        eq_wheel_insert(ec);
+        ec = next;
+    }
+}
+
+
+/*
+ * Turn the wheel up to the second <now>, moving the expired
+ * events to the due list. The lock must be held.
+ */
+static void
+eq_wheel_advance(time_t now)
+{
+    if (eq_rel->eq_count == 0) {
+        /* nothing to expire on the way */
+        if (eq_rel->eq_tick <= now) {
+            eq_rel->eq_tick = now + 1;
         }
+        return;
     }
-    if (NULL != *p) {
-        newec->ec_next = *p;
-    } else {
-        newec->ec_next = NULL;
+    while (eq_rel->eq_tick <= now) {
+        time_t t = eq_rel->eq_tick;
+        slapi_eq_context *ec;
+        int top = 0;
+
+        /* the upper levels turning at this second, the highest first */
+        while (top + 1 < EQ_WHEEL_LEVELS &&
+               (t & (((time_t)1 << (EQ_WHEEL_BITS * (top + 1))) - 1)) == 0) {
+            top++;
+        }
+        for (int level = top; level > 0; level--) {
+            eq_wheel_cascade(level, (t >> (EQ_WHEEL_BITS * level)) & EQ_WHEEL_MASK);
+        }
+
+        ec = eq_rel->eq_wheel[0][t & EQ_WHEEL_MASK];
+        eq_rel->eq_wheel[0][t & EQ_WHEEL_MASK] = NULL;
+        while (ec) {
+            slapi_eq_context *next = ec->ec_next;
+
+            eq_rel->eq_count--;
+            eq_due_append(ec);
+            ec = next;
+        }
+        eq_rel->eq_tick = t + 1;
     }
-    *p = newec;
-    pthread_cond_signal(&(eq_rel->eq_cv)); /* wake up scheduler thread */
-    pthread_mutex_unlock(&(eq_rel->eq_lock));
 }
 
 
 /*
- * If there is an event in the queue scheduled at time
- * <now> or before, dequeue it and return a pointer
- * to it. Otherwise, return NULL.
+ * The next second the wheel has to be turned at: the first
+ * event of the lowest level, or the next turn of the level above.
  */
-static slapi_eq_context *
-eq_dequeue_rel(time_t now)
+static time_t
+eq_wheel_next(void)
 {
-    slapi_eq_context *retptr = NULL;
+    time_t end = (eq_rel->eq_tick | EQ_WHEEL_MASK) + 1;
 
-    pthread_mutex_lock(&(eq_rel->eq_lock));
-    if (NULL != eq_rel->eq_queue && eq_rel->eq_queue->ec_when <= now) {
-        retptr = eq_rel->eq_queue;
-        eq_rel->eq_queue = retptr->ec_next;
+    for (time_t t = eq_rel->eq_tick; t < end; t++) {
+        if (eq_rel->eq_wheel[0][t & EQ_WHEEL_MASK]) {
+            return t;
+        }
     }
+    return end;
+}
+
+
+/*
+ * Add an event to the event queue.
+ */
+static void
+eq_enqueue_rel(slapi_eq_context *newec)
+{
+    PR_ASSERT(NULL != newec);
+    pthread_mutex_lock(&(eq_rel->eq_lock));
+    PL_HashTableAdd(eq_rel->eq_events, newec->ec_id, newec);
+    eq_wheel_insert(newec);
+    pthread_cond_signal(&(eq_rel->eq_cv)); /* wake up an executor, to compute its timeout */
     pthread_mutex_unlock(&(eq_rel->eq_lock));
-    return retptr;
 }
 
 
 /*
- * Call all events which are due to run.
- * Note that if we've missed a schedule
- * opportunity, we don't try to catch up
- * by calling the function repeatedly.
+ * Account how late an event is called. The lock must be held.
  */
 static void
-eq_call_all_rel(void)
+eq_record_lateness(time_t when)
 {
-    slapi_eq_context *p;
-    time_t curtime = slapi_current_rel_time_t();
+    struct timespec now = slapi_current_rel_time_hr();
+    uint64_t lateness = 0;
+    int i;
 
-    while ((p = eq_dequeue_rel(curtime)) != NULL) {
-        /* Call the scheduled function */
-        p->ec_fn(p->ec_when, p->ec_arg);
-        slapi_log_err(SLAPI_LOG_HOUSE, NULL,
-                      "Event id %p called at %ld (scheduled for %ld)\n",
-                      p->ec_id, curtime, p->ec_when);
-        if (0UL != p->ec_interval) {
-            /* This is a repeating event. Requeue it. */
-            do {
-                p->ec_when += p->ec_interval;
-            } while (p->ec_when < curtime);
-            eq_enqueue_rel(p);
-        } else {
-            slapi_ch_free((void **)&p);
+    if (now.tv_sec >= when) {
+        lateness = (uint64_t)(now.tv_sec - when) * 1000 + now.tv_nsec / 1000000;
+    }
+    for (i = 0; i < EQ_LATENESS_BUCKETS - 1; i++) {
+        if (lateness <= eq_lateness_bounds[i]) {
+            break;
         }
     }
+    eq_rel->eq_lateness[i]++;
+    if (lateness > eq_rel->eq_max_lateness) {
+        eq_rel->eq_max_lateness = lateness;
+    }
 }
 
 
 /*
- * The main event queue loop.
+ * The first due event whose function is not being called by
+ * another executor. The lock must be held.
+ */
+static slapi_eq_context *
+eq_next_due(void)
+{
+    for (slapi_eq_context *p = eq_rel->eq_due; p; p = p->ec_next) {
+        int32_t i;
+
+        for (i = 0; i < eq_executors && eq_running_fn[i] != p->ec_fn; i++)
+            ;
+        if (i == eq_executors) {
+            return p;
+        }
+    }
+    /* the executors calling them will pick them up when they are done */
+    return NULL;
+}
+
+
+/*
+ * An executor. Note that if we've missed a schedule
+ * opportunity, we don't try to catch up by calling
+ * the function repeatedly.
  */
 static void
-eq_loop_rel(void *arg __attribute__((unused)))
+eq_loop_rel(void *arg)
 {
+    int32_t self = (int32_t)(intptr_t)arg;
+
     slapi_set_thread_name("event-q");
+    pthread_mutex_lock(&(eq_rel->eq_lock));
     while (eq_rel_running) {
         time_t curtime = slapi_current_rel_time_t();
-        int until;
-
-        pthread_mutex_lock(&(eq_rel->eq_lock));
-        while (!((NULL != eq_rel->eq_queue) && (eq_rel->eq_queue->ec_when <= curtime))) {
-            if (!eq_rel_running) {
-                pthread_mutex_unlock(&(eq_rel->eq_lock));
-                goto bye;
-            }
-            /* Compute new timeout */
-            if (NULL != eq_rel->eq_queue) {
-                struct timespec current_time = slapi_current_rel_time_hr();
-                until = eq_rel->eq_queue->ec_when - curtime;
-                current_time.tv_sec += until;
-                pthread_cond_timedwait(&eq_rel->eq_cv, &eq_rel->eq_lock, &current_time);
+        slapi_eq_context *p;
+
+        eq_wheel_advance(curtime);
+        if ((p = eq_next_due()) == NULL) {
+            if (eq_rel->eq_count) {
+                /* the wheel turns at the start of the seconds */
+                struct timespec deadline = {0};
+                deadline.tv_sec = eq_wheel_next();
+                pthread_cond_timedwait(&eq_rel->eq_cv, &eq_rel->eq_lock, &deadline);
             } else {
                 pthread_cond_wait(&eq_rel->eq_cv, &eq_rel->eq_lock);
             }
-            curtime = slapi_current_rel_time_t();
+            continue;
         }
-        /* There is some work to do */
+        eq_unlink(p);
+        if (eq_rel->eq_due) {
+            /* more work for the other executors */
+            pthread_cond_signal(&(eq_rel->eq_cv));
+        }
+        p->ec_state = EQ_EVENT_RUNNING;
+        eq_running_fn[self] = p->ec_fn;
+        eq_record_lateness(p->ec_when);
         pthread_mutex_unlock(&(eq_rel->eq_lock));
-        eq_call_all_rel();
+
+        /* Call the scheduled function */
+        p->ec_fn(p->ec_when, p->ec_arg);
+        slapi_log_err(SLAPI_LOG_HOUSE, NULL,
+                      "Event id %p called at %ld (scheduled for %ld)\n",
+                      p->ec_id, curtime, p->ec_when);
+
+        pthread_mutex_lock(&(eq_rel->eq_lock));
+        eq_running_fn[self] = NULL;
+        if (0UL != p->ec_interval && p->ec_state == EQ_EVENT_RUNNING) {
+            /* This is a repeating event. Requeue it. */
+            do {
+                p->ec_when += p->ec_interval;
+            } while (p->ec_when < curtime);
+            eq_wheel_insert(p);
+        } else {
+            PL_HashTableRemove(eq_rel->eq_events, p->ec_id);
+            slapi_ch_free((void **)&p);
+        }
     }
-bye:
-    eq_rel_stopped = 1;
-    pthread_mutex_lock(&ss_rel_lock);
-    pthread_cond_broadcast(&ss_rel_cv);
-    pthread_mutex_unlock(&ss_rel_lock);
+    pthread_mutex_unlock(&(eq_rel->eq_lock));
 }
 
 
@@ -366,23 +599,12 @@ eq_create_rel(void)
                       rc, strerror(rc));
         exit(1);
     }
-
-    /* Init the "ss" mutex and condition var */
-    if (pthread_mutex_init(&ss_rel_lock, NULL) != 0) {
-        slapi_log_err(SLAPI_LOG_ERR, "eq_create_rel",
-                      "Failed to create ss lock: error %d (%s)\n",
-                      rc, strerror(rc));
-        exit(1);
-    }
-    if ((rc = pthread_cond_init(&ss_rel_cv, &condAttr)) != 0) {
-        slapi_log_err(SLAPI_LOG_ERR, "eq_create_rel",
-                      "Failed to create new ss condition variable. error %d (%s)\n",
-                      rc, strerror(rc));
-        exit(1);
-    }
     pthread_condattr_destroy(&condAttr); /* no longer needed */
 
-    eq_rel->eq_queue = NULL;
+    eq_rel->eq_events = PL_NewHashTable(64, eq_hash_ctx, PL_CompareValues, PL_CompareValues, NULL, NULL);
+    eq_rel->eq_due = NULL;
+    eq_rel->eq_due_tail = &(eq_rel->eq_due);
+    eq_rel->eq_tick = slapi_current_rel_time_t();
     eq_rel_initialized = 1;
     return PR_SUCCESS;
 }
@@ -391,19 +613,25 @@ eq_create_rel(void)
 /*
  * eq_start_rel: start the event queue system.
  *
- * This should be called exactly once. It will start a
- * thread which wakes up periodically and schedules events.
+ * This should be called exactly once. It will start the
+ * threads which wake up when events are due and call them.
  */
 void
 eq_start_rel()
 {
     PR_ASSERT(eq_rel_initialized);
     eq_rel_running = 1;
-    if ((eq_loop_rel_tid = PR_CreateThread(PR_USER_THREAD, (VFP)eq_loop_rel,
-                                       NULL, PR_PRIORITY_NORMAL, PR_GLOBAL_THREAD, PR_JOINABLE_THREAD,
-                                       SLAPD_DEFAULT_THREAD_STACKSIZE)) == NULL) {
-        slapi_log_err(SLAPI_LOG_ERR, "eq_start_rel", "eq_loop_rel PR_CreateThread failed\n");
-        exit(1);
+    eq_executors = config_get_eventq_executors();
+    if (eq_executors < 1 || eq_executors > EQ_MAX_EXECUTORS) {
+        eq_executors = 1;
+    }
+    for (int32_t i = 0; i < eq_executors; i++) {
+        if ((eq_loop_rel_tid[i] = PR_CreateThread(PR_USER_THREAD, (VFP)eq_loop_rel,
+                                                  (void *)(intptr_t)i, PR_PRIORITY_NORMAL, PR_GLOBAL_THREAD, PR_JOINABLE_THREAD,
+                                                  SLAPD_DEFAULT_THREAD_STACKSIZE)) == NULL) {
+            slapi_log_err(SLAPI_LOG_ERR, "eq_start_rel", "eq_loop_rel PR_CreateThread failed\n");
+            exit(1);
+        }
     }
     slapi_log_err(SLAPI_LOG_HOUSE, NULL, "event queue services have started\n");
 }
@@ -430,48 +658,44 @@ eq_init_rel()
 }
 
 
+static PRIntn
+eq_free_event(PLHashEntry *he, PRIntn i __attribute__((unused)), void *arg __attribute__((unused)))
+{
+    slapi_eq_context *p = (slapi_eq_context *)he->value;
+
+    /* Some ec_arg could get leaked here in shutdown (e.g., replica_name)
+     * This can be fixed by specifying a flag when the context is queued.
+     * [After 6.2]
+     */
+    slapi_ch_free((void **)&p);
+    return HT_ENUMERATE_REMOVE;
+}
+
+
 /*
  * eq_stop_rel: shut down the event queue system.
  * Does not return until event queue is fully
- * shut down.
+ * shut down: the running callbacks have returned.
  */
 void
 eq_stop_rel()
 {
-    slapi_eq_context *p, *q;
-
-    if (NULL == eq_rel) { /* never started */
+    if (!eq_rel_initialized) { /* never started */
         eq_rel_stopped = 1;
         return;
     }
 
-    eq_rel_stopped = 0;
+    pthread_mutex_lock(&(eq_rel->eq_lock));
     eq_rel_running = 0;
-    /*
-     * Signal the eq thread function to stop, and wait until
-     * it acknowledges by setting eq_rel_stopped.
-     */
-    while (!eq_rel_stopped) {
-        struct timespec current_time = {0};
-
-        pthread_mutex_lock(&(eq_rel->eq_lock));
-        pthread_cond_broadcast(&(eq_rel->eq_cv));
-        pthread_mutex_unlock(&(eq_rel->eq_lock));
-
-        pthread_mutex_lock(&ss_rel_lock);
-        clock_gettime(CLOCK_MONOTONIC, &current_time);
-        if (current_time.tv_nsec + 100000000 > 1000000000) {
-            /* nanoseconds will overflow, adjust the seconds and nanoseconds */
-            current_time.tv_sec++;
-            /* Add the remainder to nanoseconds */
-            current_time.tv_nsec = (current_time.tv_nsec + 100000000) - 1000000000;
-        } else {
-            current_time.tv_nsec += 100000000; /* 100 ms */
+    pthread_cond_broadcast(&(eq_rel->eq_cv));
+    pthread_mutex_unlock(&(eq_rel->eq_lock));
+    for (int32_t i = 0; i < eq_executors; i++) {
+        if (eq_loop_rel_tid[i]) {
+            (void)PR_JoinThread(eq_loop_rel_tid[i]);
+            eq_loop_rel_tid[i] = NULL;
         }
-        pthread_cond_timedwait(&ss_rel_cv, &ss_rel_lock, &current_time);
-        pthread_mutex_unlock(&ss_rel_lock);
     }
-    (void)PR_JoinThread(eq_loop_rel_tid);
+    eq_rel_stopped = 1;
     /*
      * XXXggood we don't free the actual event queue data structures.
      * This is intentional, to allow enqueueing/cancellation of events
@@ -480,16 +704,11 @@ eq_stop_rel()
      * easily.
      */
     pthread_mutex_lock(&(eq_rel->eq_lock));
-    p = eq_rel->eq_queue;
-    while (p != NULL) {
-        q = p->ec_next;
-        slapi_ch_free((void **)&p);
-        /* Some ec_arg could get leaked here in shutdown (e.g., replica_name)
-         * This can be fixed by specifying a flag when the context is queued.
-         * [After 6.2]
-         */
-        p = q;
-    }
+    PL_HashTableEnumerateEntries(eq_rel->eq_events, eq_free_event, NULL);
+    memset(eq_rel->eq_wheel, 0, sizeof(eq_rel->eq_wheel));
+    eq_rel->eq_due = NULL;
+    eq_rel->eq_due_tail = &(eq_rel->eq_due);
+    eq_rel->eq_count = 0;
     pthread_mutex_unlock(&(eq_rel->eq_lock));
     slapi_log_err(SLAPI_LOG_HOUSE, NULL, "event queue services have shut down\n");
 }
@@ -500,21 +719,61 @@ eq_stop_rel()
 void *
 slapi_eq_get_arg_rel(Slapi_Eq_Context ctx)
 {
-    slapi_eq_context **p;
+    slapi_eq_context *p;
+    void *arg = NULL;
 
     PR_ASSERT(eq_rel_initialized);
     if (eq_rel && !eq_rel_stopped) {
         pthread_mutex_lock(&(eq_rel->eq_lock));
-        p = &(eq_rel->eq_queue);
-        while (p && *p != NULL) {
-            if ((*p)->ec_id == ctx) {
-                pthread_mutex_unlock(&(eq_rel->eq_lock));
-                return (*p)->ec_arg;
-            } else {
-                p = &((*p)->ec_next);
-            }
+        p = (slapi_eq_context *)PL_HashTableLookup(eq_rel->eq_events, ctx);
+        if (p && (p->ec_state == EQ_EVENT_PENDING || p->ec_state == EQ_EVENT_DUE)) {
+            arg = p->ec_arg;
         }
         pthread_mutex_unlock(&(eq_rel->eq_lock));
     }
-    return NULL;
+    return arg;
+}
+
+/*
+ * Add the event queue statistics to the cn=monitor entry:
+ * the number of scheduled events and the histogram of how
+ * late their callbacks were called.
+ */
+void
+eq_stats_as_entry(Slapi_Entry *e)
+{
+    uint64_t lateness[EQ_LATENESS_BUCKETS];
+    uint64_t max_lateness;
+    uint64_t pending = 0;
+    char buf[128];
+    struct berval val;
+    struct berval *vals[2];
+
+    vals[0] = &val;
+    vals[1] = NULL;
+    val.bv_val = buf;
+
+    if (eq_rel_initialized) {
+        pthread_mutex_lock(&(eq_rel->eq_lock));
+        memcpy(lateness, eq_rel->eq_lateness, sizeof(lateness));
+        max_lateness = eq_rel->eq_max_lateness;
+        pending = eq_rel->eq_events->nentries;
+        pthread_mutex_unlock(&(eq_rel->eq_lock));
+    } else {
+        memset(lateness, 0, sizeof(lateness));
+        max_lateness = 0;
+    }
+
+    val.bv_len = snprintf(buf, sizeof(buf), "%" PRIu64, pending);
+    attrlist_replace(&e->e_attrs, "eventqevents", vals);
+
+    attrlist_delete(&e->e_attrs, "eventqlateness");
+    for (size_t i = 0; i < EQ_LATENESS_BUCKETS; i++) {
+        val.bv_len = snprintf(buf, sizeof(buf), "le=%s events=%" PRIu64,
+                              eq_lateness_names[i], lateness[i]);
+        attrlist_merge(&e->e_attrs, "eventqlateness", vals);
+    }
+
+    val.bv_len = snprintf(buf, sizeof(buf), "%" PRIu64, max_lateness);
+    attrlist_replace(&e->e_attrs, "eventqmaxlatenessms", vals);
 }
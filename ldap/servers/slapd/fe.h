@@ -138,6 +138,7 @@ int configure_pr_socket(PRFileDesc **pr_socket, int secure, int local);
  */
 int sasl_io_enable(Connection *c, void *data);
 int sasl_io_cleanup(Connection *c, void *data);
+int sasl_io_has_buffered_data(Connection *c);
 
 /*
  * sasl_map.c
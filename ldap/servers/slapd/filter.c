@@ -758,6 +758,7 @@ slapi_filter_free(struct slapi_filter *f, int recurse)
     }
 
     slapi_log_err(SLAPI_LOG_FILTER, "slapi_filter_free", "type 0x%lX\n", f->f_choice);
+    filter_prog_free(&f->f_prog);
     switch (f->f_choice) {
     case LDAP_FILTER_EQUALITY:
     case LDAP_FILTER_GE:
@@ -771,6 +772,7 @@ slapi_filter_free(struct slapi_filter *f, int recurse)
         slapi_ch_free((void **)&f->f_sub_initial);
         charray_free(f->f_sub_any);
         slapi_ch_free((void **)&f->f_sub_final);
+        slapi_substr_matcher_free((Slapi_SubstrMatcher **)&f->f_un.f_un_sub.sf_private);
         break;
 
     case LDAP_FILTER_PRESENT:
@@ -1071,6 +1073,7 @@ void
 slapi_filter_free_bits(Slapi_Filter *f)
 {
     /* We need to free: */
+    filter_prog_free(&f->f_prog);
     switch (f->f_choice) {
     case LDAP_FILTER_EQUALITY:
     case LDAP_FILTER_GE:
@@ -1147,6 +1150,8 @@ filter_normalize_subfilt(struct slapi_filter *f, PRBool norm_values)
     }
 
     sf = &f->f_sub;
+    /* the components are about to change */
+    slapi_substr_matcher_free((Slapi_SubstrMatcher **)&sf->sf_private);
     char *tmp = sf->sf_type;
     sf->sf_type = slapi_attr_syntax_normalize(tmp);
     slapi_ch_free((void **)&tmp);
@@ -1257,6 +1262,10 @@ filter_normalize(struct slapi_filter *f)
 void
 slapi_filter_normalize(struct slapi_filter *f, PRBool norm_values)
 {
+    if (f) {
+        /* the compiled filter refers to the values about to change */
+        filter_prog_free(&f->f_prog);
+    }
     filter_normalize_ext(f, norm_values);
 }
 
@@ -1824,6 +1833,9 @@ slapi_filter_optimise_inner(Slapi_Filter *f, uint16_t limit)
 void
 slapi_filter_optimise(Slapi_Filter *f)
 {
+    if (f) {
+        filter_prog_free(&f->f_prog);
+    }
     slapi_filter_optimise_inner(f, FILTER_OPTIMISE_DEPTH_LIMIT);
 }
 
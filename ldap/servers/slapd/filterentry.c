@@ -832,6 +832,11 @@ slapi_vattr_filter_test_ext(
     }
     PR_ASSERT(only_check_access == 0);
 
+    if (f && f->f_prog && !verify_access) {
+        /* compiled filter, see filterprog.c */
+        return filter_prog_test(pb, e, f->f_prog);
+    }
+
     /* Fix for ticket 48275
      * If we want to handle or components which can contain nonmatching components without access propoerly
      * always filter verification and access check have to be done together for each component
@@ -841,6 +846,18 @@ slapi_vattr_filter_test_ext(
     return rc;
 }
 
+/*
+ * Evaluate a filter component with the tree walker, without access check.
+ * Used by compiled filters for the components they don't handle.
+ */
+int
+vattr_filter_test_tree(Slapi_PBlock *pb, Slapi_Entry *e, struct slapi_filter *f)
+{
+    int access_check_done = 0;
+
+    return slapi_vattr_filter_test_ext_internal(pb, e, f, 0, 0, &access_check_done);
+}
+
 static int
 slapi_vattr_filter_test_ext_internal(
     Slapi_PBlock *pb,
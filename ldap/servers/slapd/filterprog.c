@@ -0,0 +1,414 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * filterprog.c - compiled filters
+ *
+ * A filter tested against many entries (search candidates, acl
+ * targetfilters, plugin scopes, persistent searches) can be compiled into
+ * a flat array of instructions. The work that does not depend on the entry
+ * is done once at compile time:
+ *  - whether a virtual attribute provider may serve the attribute type,
+ *    instead of a backend selection and a map lookup per component and entry
+ *  - whether an equality is on a DN syntax attribute
+ *  - the normalization of the assertion values
+ * AND and OR components are ordered by their estimated cost, so the cheap
+ * ones short circuit the expensive ones.
+ *
+ * A compiled filter is evaluated by slapi_vattr_filter_test_ext() when no
+ * access check is requested, with the same result as the tree walker in
+ * filterentry.c. A filter must not be changed once compiled, it is freed
+ * with its program.
+ */
+
+#include "slap.h"
+
+typedef enum _fp_opcode {
+    FP_AND,
+    FP_OR,
+    FP_NOT,
+    FP_AVA,  /* equality, greater or equal, less or equal, approx */
+    FP_SUB,  /* substrings */
+    FP_PRES, /* presence */
+    FP_TREE  /* anything else, handed to the tree walker */
+} fp_opcode;
+
+typedef struct _fp_insn
+{
+    fp_opcode fi_op;
+    uint32_t fi_end;      /* index of the instruction after this one and its operands */
+    Slapi_Filter *fi_f;   /* the filter component */
+    char *fi_type;        /* attribute type of a simple component */
+    int32_t fi_virtual;   /* the type may be served by a virtual attribute provider */
+    int fi_dn_eq;         /* equality on a DN syntax attribute */
+    int fi_ava_flags;     /* ava_private of fi_ava */
+    struct ava fi_ava;    /* the assertion, with the value normalized */
+} FPInsn;
+
+struct slapi_filter_prog
+{
+    uint64_t fp_vattr_gen; /* vattr map generation of the fi_virtual flags */
+    uint32_t fp_count;
+    FPInsn *fp_insns;
+};
+
+/* Estimated cost of a filter component */
+static uint32_t
+fp_cost(Slapi_Filter *f)
+{
+    uint32_t cost = 1;
+    Slapi_Filter *fl;
+
+    switch (f->f_choice) {
+    case LDAP_FILTER_PRESENT:
+        return 1;
+    case LDAP_FILTER_EQUALITY:
+        return 2;
+    case LDAP_FILTER_GE:
+    case LDAP_FILTER_LE:
+    case LDAP_FILTER_APPROX:
+        return 3;
+    case LDAP_FILTER_SUBSTRINGS:
+        return 4;
+    case LDAP_FILTER_AND:
+    case LDAP_FILTER_OR:
+    case LDAP_FILTER_NOT:
+        for (fl = f->f_list; fl; fl = fl->f_next) {
+            cost += fp_cost(fl);
+            if (f->f_choice == LDAP_FILTER_NOT) {
+                break;
+            }
+        }
+        return cost;
+    default:
+        return 8;
+    }
+}
+
+static uint32_t
+fp_count(Slapi_Filter *f)
+{
+    uint32_t count = 1;
+    Slapi_Filter *fl;
+
+    if (f->f_choice == LDAP_FILTER_AND || f->f_choice == LDAP_FILTER_OR) {
+        for (fl = f->f_list; fl; fl = fl->f_next) {
+            count += fp_count(fl);
+        }
+    } else if (f->f_choice == LDAP_FILTER_NOT && f->f_not) {
+        count += fp_count(f->f_not);
+    }
+    return count;
+}
+
+typedef struct _fp_component
+{
+    Slapi_Filter *fc_f;
+    uint32_t fc_cost;
+    uint32_t fc_pos;
+} FPComponent;
+
+static int
+fp_component_cmp(const void *a, const void *b)
+{
+    const FPComponent *ca = (const FPComponent *)a;
+    const FPComponent *cb = (const FPComponent *)b;
+
+    if (ca->fc_cost != cb->fc_cost) {
+        return ca->fc_cost < cb->fc_cost ? -1 : 1;
+    }
+    /* keep the order of the filter for the same cost */
+    return ca->fc_pos < cb->fc_pos ? -1 : 1;
+}
+
+static void
+fp_emit_ava(FPInsn *in, Slapi_Filter *f)
+{
+    char *val;
+    char *newval = NULL;
+
+    in->fi_op = FP_AVA;
+    in->fi_type = f->f_ava.ava_type;
+    in->fi_dn_eq = (f->f_choice == LDAP_FILTER_EQUALITY) && slapi_attr_is_dn_syntax_type(in->fi_type);
+
+    /* same as filter_normalize_ava(), on our own copy of the value */
+    val = slapi_ch_malloc(f->f_ava.ava_value.bv_len + 1);
+    memcpy(val, f->f_ava.ava_value.bv_val, f->f_ava.ava_value.bv_len);
+    val[f->f_ava.ava_value.bv_len] = '\0';
+    slapi_attr_value_normalize_ext(NULL, NULL, in->fi_type, val, 1, &newval, f->f_choice);
+    if (newval && (newval != val)) {
+        slapi_ch_free_string(&val);
+        val = newval;
+    }
+    in->fi_ava.ava_type = in->fi_type;
+    in->fi_ava.ava_value.bv_val = val;
+    in->fi_ava.ava_value.bv_len = strlen(val);
+    in->fi_ava_flags = f->f_flags | SLAPI_FILTER_NORMALIZED_VALUE;
+    in->fi_ava.ava_private = &in->fi_ava_flags;
+}
+
+static void
+fp_emit(Slapi_FilterProg *prog, Slapi_Filter *f)
+{
+    uint32_t idx = prog->fp_count++;
+    FPInsn *in = &prog->fp_insns[idx];
+    Slapi_Filter *fl;
+
+    in->fi_f = f;
+    switch (f->f_choice) {
+    case LDAP_FILTER_AND:
+    case LDAP_FILTER_OR: {
+        FPComponent *comps;
+        uint32_t n = 0;
+
+        in->fi_op = (f->f_choice == LDAP_FILTER_AND) ? FP_AND : FP_OR;
+        for (fl = f->f_list; fl; fl = fl->f_next) {
+            n++;
+        }
+        comps = (FPComponent *)slapi_ch_calloc(n ? n : 1, sizeof(FPComponent));
+        n = 0;
+        for (fl = f->f_list; fl; fl = fl->f_next) {
+            comps[n].fc_f = fl;
+            comps[n].fc_cost = fp_cost(fl);
+            comps[n].fc_pos = n;
+            n++;
+        }
+        if ((f->f_flags & SLAPI_FILTER_TOMBSTONE) == 0) {
+            /* leave tombstone filters alone, like slapi_filter_optimise() */
+            qsort(comps, n, sizeof(FPComponent), fp_component_cmp);
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            fp_emit(prog, comps[i].fc_f);
+        }
+        slapi_ch_free((void **)&comps);
+        break;
+    }
+    case LDAP_FILTER_NOT:
+        if (f->f_not) {
+            in->fi_op = FP_NOT;
+            fp_emit(prog, f->f_not);
+        } else {
+            in->fi_op = FP_TREE;
+        }
+        break;
+    case LDAP_FILTER_EQUALITY:
+    case LDAP_FILTER_GE:
+    case LDAP_FILTER_LE:
+    case LDAP_FILTER_APPROX:
+        fp_emit_ava(in, f);
+        break;
+    case LDAP_FILTER_SUBSTRINGS:
+        in->fi_op = FP_SUB;
+        in->fi_type = f->f_sub_type;
+        break;
+    case LDAP_FILTER_PRESENT:
+        in->fi_op = FP_PRES;
+        in->fi_type = f->f_type;
+        break;
+    default:
+        in->fi_op = FP_TREE;
+        break;
+    }
+    in->fi_end = prog->fp_count;
+}
+
+/*
+ * Refresh the virtual attribute flags of the program if types were
+ * registered by the virtual attribute providers since they were set.
+ * Types are never unregistered, so a flag can only be turned on: a thread
+ * reading the previous value sees the state the map had a moment ago.
+ */
+static void
+fp_refresh_virtual(Slapi_FilterProg *prog)
+{
+    uint64_t gen = vattr_map_generation();
+
+    if (gen == slapi_atomic_load_64(&(prog->fp_vattr_gen), __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    for (uint32_t i = 0; i < prog->fp_count; i++) {
+        FPInsn *in = &prog->fp_insns[i];
+        if (in->fi_type) {
+            slapi_atomic_store_32(&(in->fi_virtual), vattr_map_type_may_be_virtual(in->fi_type), __ATOMIC_RELEASE);
+        }
+    }
+    slapi_atomic_store_64(&(prog->fp_vattr_gen), gen, __ATOMIC_RELEASE);
+}
+
+/*
+ * Same as test_ava_filter() without access check, using the normalized
+ * assertion value and the precomputed DN syntax flag.
+ */
+static int
+fp_test_ava(Slapi_Entry *e, FPInsn *in)
+{
+    Slapi_Attr *a;
+    int rc = -1;
+
+    for (a = e->e_attrs; a != NULL; a = a->a_next) {
+        if (slapi_attr_type_cmp(in->fi_type, a->a_type, SLAPI_TYPE_CMP_SUBTYPE) != 0) {
+            continue;
+        }
+        if (in->fi_dn_eq) {
+            /* use the sorted valueset, see test_ava_filter() */
+            Slapi_Value *sval = slapi_value_new_berval(&in->fi_f->f_ava.ava_value);
+            if (slapi_valueset_find((const Slapi_Attr *)a, &a->a_present_values, sval)) {
+                rc = 0;
+            }
+            slapi_value_free(&sval);
+        } else {
+            rc = plugin_call_syntax_filter_ava(a, in->fi_f->f_choice, &in->fi_ava);
+        }
+        if (rc == 0) {
+            break;
+        }
+    }
+    return rc;
+}
+
+static int
+fp_exec(Slapi_FilterProg *prog, uint32_t i, Slapi_PBlock *pb, Slapi_Entry *e)
+{
+    FPInsn *in = &prog->fp_insns[i];
+    int access_check_done = 0;
+    uint32_t j;
+    int rc;
+
+    switch (in->fi_op) {
+    case FP_AND: {
+        /* see vattr_test_filter_list_and() */
+        int undefined = 0;
+        int nomatch = -1;
+
+        for (j = i + 1; j < in->fi_end; j = prog->fp_insns[j].fi_end) {
+            rc = fp_exec(prog, j, pb, e);
+            if (rc < 0) {
+                return -1;
+            } else if (rc > 0) {
+                undefined = rc;
+            } else {
+                nomatch = 0;
+            }
+        }
+        return undefined ? undefined : nomatch;
+    }
+    case FP_OR: {
+        /* see vattr_test_filter_list_or() */
+        int nomatch = 1;
+        int undefined = 0;
+
+        for (j = i + 1; j < in->fi_end; j = prog->fp_insns[j].fi_end) {
+            rc = fp_exec(prog, j, pb, e);
+            if (rc == 0) {
+                return 0;
+            } else if (rc > 0) {
+                undefined = rc;
+            } else {
+                nomatch = -1;
+            }
+        }
+        return (nomatch == 1) ? undefined : nomatch;
+    }
+    case FP_NOT:
+        rc = fp_exec(prog, i + 1, pb, e);
+        if (rc > 0) {
+            /* an error occurred, don't negate */
+            return rc;
+        }
+        return (rc == 0) ? -1 : 0;
+    case FP_AVA:
+        if (slapi_atomic_load_32(&(in->fi_virtual), __ATOMIC_ACQUIRE)) {
+            return vattr_test_filter(pb, e, in->fi_f, FILTER_TYPE_AVA, in->fi_type);
+        }
+        return fp_test_ava(e, in);
+    case FP_SUB:
+        if (slapi_atomic_load_32(&(in->fi_virtual), __ATOMIC_ACQUIRE)) {
+            return vattr_test_filter(pb, e, in->fi_f, FILTER_TYPE_SUBSTRING, in->fi_type);
+        }
+        return test_substring_filter(pb, e, in->fi_f, 0 /* no access check */,
+                                     0 /* do test filter */, &access_check_done);
+    case FP_PRES:
+        if (slapi_atomic_load_32(&(in->fi_virtual), __ATOMIC_ACQUIRE)) {
+            return vattr_test_filter(pb, e, in->fi_f, FILTER_TYPE_PRES, in->fi_type);
+        }
+        return test_presence_filter(NULL, e, in->fi_type, 0 /* no access check */,
+                                    0 /* do test filter */, &access_check_done);
+    case FP_TREE:
+    default:
+        return vattr_filter_test_tree(pb, e, in->fi_f);
+    }
+}
+
+/*
+ * Test a compiled filter against an entry, without access check.
+ * Returns like slapi_vattr_filter_test().
+ */
+int
+filter_prog_test(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_FilterProg *prog)
+{
+    fp_refresh_virtual(prog);
+    return fp_exec(prog, 0, pb, e);
+}
+
+void
+filter_prog_free(Slapi_FilterProg **progp)
+{
+    Slapi_FilterProg *prog;
+
+    if (progp == NULL || *progp == NULL) {
+        return;
+    }
+    prog = *progp;
+    for (uint32_t i = 0; i < prog->fp_count; i++) {
+        if (prog->fp_insns[i].fi_op == FP_AVA) {
+            slapi_ch_free_string(&prog->fp_insns[i].fi_ava.ava_value.bv_val);
+        }
+    }
+    slapi_ch_free((void **)&prog->fp_insns);
+    slapi_ch_free((void **)progp);
+}
+
+/*
+ * Compile a filter. Any previous program of the filter is replaced, so
+ * this must not be called while the filter is being tested by another
+ * thread.
+ */
+int
+slapi_filter_compile(Slapi_Filter *f)
+{
+    Slapi_FilterProg *prog;
+
+    if (f == NULL) {
+        return -1;
+    }
+    filter_prog_free((Slapi_FilterProg **)&f->f_prog);
+
+    prog = (Slapi_FilterProg *)slapi_ch_calloc(1, sizeof(Slapi_FilterProg));
+    prog->fp_insns = (FPInsn *)slapi_ch_calloc(fp_count(f), sizeof(FPInsn));
+    fp_emit(prog, f);
+    if (prog->fp_insns[0].fi_op == FP_TREE) {
+        /* nothing to gain */
+        filter_prog_free(&prog);
+        return 0;
+    }
+    /* force the first refresh of the virtual attribute flags */
+    prog->fp_vattr_gen = vattr_map_generation() - 1;
+    fp_refresh_virtual(prog);
+
+    if (slapi_is_loglevel_set(SLAPI_LOG_FILTER)) {
+        char buf[BUFSIZ];
+        slapi_log_err(SLAPI_LOG_FILTER, "slapi_filter_compile", "%s compiled to %u instructions\n",
+                      slapi_filter_to_string(f, buf, sizeof(buf)), prog->fp_count);
+    }
+    f->f_prog = prog;
+    return 0;
+}
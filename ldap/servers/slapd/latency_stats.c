@@ -0,0 +1,201 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * latency_stats.c - latency histograms of the operation phases
+ *
+ * The access log gives the etime, wtime and optime of each operation, but
+ * not where the time goes inside it. Each phase of slapd_latency_phase_t is
+ * timed where it runs, and the time is added to a histogram: the histograms
+ * are aggregated when they are read, for cn=monitor (phaselatency) and for
+ * the thread-pool status file, refreshed with its heartbeat.
+ *
+ * Like the snmp counters, every worker thread has its own set of histograms,
+ * the other threads share the first one: the counters are only incremented
+ * with relaxed atomics, nothing is locked and the workers do not share cache
+ * lines. The buckets are those of tp_latency_hist_t: two per power of two,
+ * from 256ns up to about 14 minutes.
+ *
+ * When built with --enable-usdt, every value is also given to the
+ * phase__latency USDT probe, see profiling/bpftrace/probe_phase_latency.bt.
+ */
+
+#include "slap.h"
+#ifdef USDT
+#include <sys/sdt.h>
+#endif
+#include "threadpool_stats.h"
+
+_Static_assert(LATENCY_PHASE_MAX == TP_STATS_LATENCY_PHASES,
+               "the latency phases must match the thread-pool status file");
+
+typedef struct __attribute__((aligned(64))) latency_set {
+    tp_latency_hist_t ls_hists[LATENCY_PHASE_MAX];
+} latency_set_t;
+
+static latency_set_t *latency_sets = NULL; /* slot 0 is shared by the non worker threads */
+static int32_t latency_nsets = 0;
+
+static const char *latency_phase_names[LATENCY_PHASE_MAX] = {
+    "queue", "preop", "candidates", "fetch", "acl", "encode", "flush"};
+
+/*
+ * Allocate a set of histograms per worker thread. Like
+ * alloc_per_thread_snmp_vars(), must complete before the
+ * workers start.
+ */
+void
+latency_stats_init(int32_t maxthread)
+{
+    if (latency_sets == NULL) {
+        latency_sets = (latency_set_t *)slapi_ch_memalign((maxthread + 1) * sizeof(latency_set_t), sizeof(latency_set_t));
+        memset(latency_sets, 0, (maxthread + 1) * sizeof(latency_set_t));
+        latency_nsets = maxthread + 1;
+    }
+}
+
+/* Monotonic time in nanoseconds, to start timing a phase */
+uint64_t
+latency_stats_now(void)
+{
+    struct timespec ts = slapi_current_rel_time_hr();
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t
+latency_bucket(uint64_t ns)
+{
+    uint32_t e;
+    uint32_t idx;
+
+    if (ns < (1ULL << TP_STATS_LATENCY_MIN_SHIFT)) {
+        return 0;
+    }
+    e = 63 - __builtin_clzll(ns);
+    idx = 1 + (e - TP_STATS_LATENCY_MIN_SHIFT) * 2 + ((ns >> (e - 1)) & 1);
+    return idx < TP_STATS_LATENCY_BUCKETS ? idx : TP_STATS_LATENCY_BUCKETS - 1;
+}
+
+/* The upper bound of a bucket, the value reported for its percentiles */
+static uint64_t
+latency_bucket_bound(uint32_t idx)
+{
+    uint32_t e;
+
+    if (idx == 0) {
+        return 1ULL << TP_STATS_LATENCY_MIN_SHIFT;
+    }
+    e = TP_STATS_LATENCY_MIN_SHIFT + (idx - 1) / 2;
+    return (uint64_t)(3 + (idx - 1) % 2) << (e - 1);
+}
+
+void
+latency_stats_record_ns(slapd_latency_phase_t phase, uint64_t elapsed_ns)
+{
+    latency_set_t *set;
+    int32_t idx;
+
+#ifdef USDT
+    STAP_PROBE2(ns-slapd, phase__latency, (int)phase, elapsed_ns);
+#endif
+    if (latency_sets == NULL) {
+        return;
+    }
+    idx = thread_private_snmp_vars_get_idx();
+    if (idx < 0 || idx >= latency_nsets) {
+        idx = 0;
+    }
+    set = &latency_sets[idx];
+    slapi_atomic_incr_64(&set->ls_hists[phase].buckets[latency_bucket(elapsed_ns)], __ATOMIC_RELAXED);
+    slapi_atomic_add_64(&set->ls_hists[phase].sum_ns, elapsed_ns, __ATOMIC_RELAXED);
+}
+
+/* Record the time elapsed since start_ns, from latency_stats_now() */
+void
+latency_stats_record(slapd_latency_phase_t phase, uint64_t start_ns)
+{
+    uint64_t now = latency_stats_now();
+
+    latency_stats_record_ns(phase, now > start_ns ? now - start_ns : 0);
+}
+
+/* Sum the histograms of all the threads in hists[LATENCY_PHASE_MAX] */
+void
+latency_stats_collect(tp_latency_hist_t *hists)
+{
+    memset(hists, 0, LATENCY_PHASE_MAX * sizeof(tp_latency_hist_t));
+    for (int32_t i = 0; i < latency_nsets; i++) {
+        for (size_t p = 0; p < LATENCY_PHASE_MAX; p++) {
+            tp_latency_hist_t *h = &latency_sets[i].ls_hists[p];
+
+            hists[p].sum_ns += slapi_atomic_load_64(&h->sum_ns, __ATOMIC_RELAXED);
+            for (size_t b = 0; b < TP_STATS_LATENCY_BUCKETS; b++) {
+                hists[p].buckets[b] += slapi_atomic_load_64(&h->buckets[b], __ATOMIC_RELAXED);
+            }
+        }
+    }
+}
+
+static uint64_t
+latency_percentile(tp_latency_hist_t *h, uint64_t count, uint32_t percent)
+{
+    uint64_t rank = (count * percent + 99) / 100;
+    uint64_t seen = 0;
+
+    for (uint32_t b = 0; b < TP_STATS_LATENCY_BUCKETS; b++) {
+        seen += h->buckets[b];
+        if (seen >= rank) {
+            return latency_bucket_bound(b);
+        }
+    }
+    return latency_bucket_bound(TP_STATS_LATENCY_BUCKETS - 1);
+}
+
+/*
+ * Add a phaselatency value per phase to the cn=monitor entry. The
+ * percentiles are the upper bounds of their buckets.
+ */
+void
+latency_stats_as_entry(Slapi_Entry *e)
+{
+    tp_latency_hist_t hists[LATENCY_PHASE_MAX];
+    struct berval val;
+    struct berval *vals[2];
+    char buf[256];
+
+    vals[0] = &val;
+    vals[1] = NULL;
+    attrlist_delete(&e->e_attrs, "phaselatency");
+
+    latency_stats_collect(hists);
+    for (size_t p = 0; p < LATENCY_PHASE_MAX; p++) {
+        tp_latency_hist_t *h = &hists[p];
+        uint64_t count = 0;
+
+        for (size_t b = 0; b < TP_STATS_LATENCY_BUCKETS; b++) {
+            count += h->buckets[b];
+        }
+        if (count == 0) {
+            val.bv_len = snprintf(buf, sizeof(buf), "phase=%s count=0", latency_phase_names[p]);
+        } else {
+            val.bv_len = snprintf(buf, sizeof(buf),
+                                  "phase=%s count=%" PRIu64 " mean_ns=%" PRIu64
+                                  " p50_ns=%" PRIu64 " p90_ns=%" PRIu64 " p99_ns=%" PRIu64,
+                                  latency_phase_names[p], count, h->sum_ns / count,
+                                  latency_percentile(h, count, 50),
+                                  latency_percentile(h, count, 90),
+                                  latency_percentile(h, count, 99));
+        }
+        val.bv_val = buf;
+        attrlist_merge(&e->e_attrs, "phaselatency", vals);
+    }
+}
@@ -275,6 +275,7 @@ slapi_special_filter_verify_t init_verify_filter_schema;
 slapi_onoff_t init_enable_ldapssotoken;
 slapi_onoff_t init_return_orig_dn;
 slapi_onoff_t init_pw_admin_skip_info;
+slapi_onoff_t init_pw_verify_cache;
 
 
 static int
@@ -1513,7 +1514,42 @@ static struct config_get_and_set
      config_set_ignored_criticality_list, NULL, 0,
      (void **)&global_slapdFrontendConfig.ignored_criticality_list,
      CONFIG_CHARRAY, (ConfigGetFunc)config_get_ignored_criticality_list,
-     (void*)ALLOW_ATTRIBUTE_DELETION, NULL}
+     (void*)ALLOW_ATTRIBUTE_DELETION, NULL},
+    {CONFIG_PW_VERIFY_CACHE_ATTRIBUTE, config_set_pw_verify_cache,
+     NULL, 0,
+     (void **)&global_slapdFrontendConfig.pw_verify_cache,
+     CONFIG_ON_OFF, (ConfigGetFunc)config_get_pw_verify_cache,
+     &init_pw_verify_cache, NULL},
+    {CONFIG_PW_VERIFY_CACHE_SIZE_ATTRIBUTE, config_set_pw_verify_cache_size,
+     NULL, 0,
+     (void **)&global_slapdFrontendConfig.pw_verify_cache_size,
+     CONFIG_INT, (ConfigGetFunc)config_get_pw_verify_cache_size,
+     SLAPD_DEFAULT_PW_VERIFY_CACHE_SIZE_STR, NULL},
+    {CONFIG_PW_VERIFY_CACHE_TTL_ATTRIBUTE, config_set_pw_verify_cache_ttl,
+     NULL, 0,
+     (void **)&global_slapdFrontendConfig.pw_verify_cache_ttl,
+     CONFIG_INT, (ConfigGetFunc)config_get_pw_verify_cache_ttl,
+     SLAPD_DEFAULT_PW_VERIFY_CACHE_TTL_STR, NULL},
+    {CONFIG_PW_VERIFY_THREADS_ATTRIBUTE, config_set_pw_verify_threads,
+     NULL, 0,
+     (void **)&global_slapdFrontendConfig.pw_verify_threads,
+     CONFIG_INT, (ConfigGetFunc)config_get_pw_verify_threads,
+     SLAPD_DEFAULT_PW_VERIFY_THREADS_STR, NULL},
+    {CONFIG_WRITEBEHIND_INTERVAL_ATTRIBUTE, config_set_writebehind_interval,
+     NULL, 0,
+     (void **)&global_slapdFrontendConfig.writebehind_interval,
+     CONFIG_INT, (ConfigGetFunc)config_get_writebehind_interval,
+     SLAPD_DEFAULT_WRITEBEHIND_INTERVAL_STR, NULL},
+    {CONFIG_SEARCH_FANOUT_THREADS_ATTRIBUTE, config_set_search_fanout_threads,
+     NULL, 0,
+     (void **)&global_slapdFrontendConfig.search_fanout_threads,
+     CONFIG_INT, (ConfigGetFunc)config_get_search_fanout_threads,
+     SLAPD_DEFAULT_SEARCH_FANOUT_THREADS_STR, NULL},
+    {CONFIG_EVENTQ_EXECUTORS_ATTRIBUTE, config_set_eventq_executors,
+     NULL, 0,
+     (void **)&global_slapdFrontendConfig.eventq_executors,
+     CONFIG_INT, (ConfigGetFunc)config_get_eventq_executors,
+     SLAPD_DEFAULT_EVENTQ_EXECUTORS_STR, NULL}
     /* End config */
     };
 
@@ -2109,6 +2145,13 @@ FrontendConfig_init(void)
     init_extract_pem = cfg->extract_pem = LDAP_ON;
     cfg->referral_check_period = SLAPD_DEFAULT_REFERRAL_CHECK_PERIOD;
     init_return_orig_dn = cfg->return_orig_dn = LDAP_ON;
+    init_pw_verify_cache = cfg->pw_verify_cache = LDAP_OFF;
+    cfg->pw_verify_cache_size = SLAPD_DEFAULT_PW_VERIFY_CACHE_SIZE;
+    cfg->pw_verify_cache_ttl = SLAPD_DEFAULT_PW_VERIFY_CACHE_TTL;
+    cfg->pw_verify_threads = SLAPD_DEFAULT_PW_VERIFY_THREADS;
+    cfg->writebehind_interval = SLAPD_DEFAULT_WRITEBEHIND_INTERVAL;
+    cfg->search_fanout_threads = SLAPD_DEFAULT_SEARCH_FANOUT_THREADS;
+    cfg->eventq_executors = SLAPD_DEFAULT_EVENTQ_EXECUTORS;
     /*
      * Default upgrade hash to on - this is an important security step, meaning that old
      * or legacy hashes are upgraded on bind. It means we are proactive in securing accounts
@@ -10687,6 +10730,142 @@ config_set_ignored_criticality_list(const char *attrname, char *value, char *err
     return retVal;
 }
 
+int32_t
+config_get_pw_verify_cache(void)
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    return slapi_atomic_load_32(&(slapdFrontendConfig->pw_verify_cache), __ATOMIC_ACQUIRE);
+}
+
+int32_t
+config_set_pw_verify_cache(const char *attrname, char *value, char *errorbuf, int apply)
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+
+    return config_set_onoff(attrname, value, &(slapdFrontendConfig->pw_verify_cache), errorbuf, apply);
+}
+
+static int32_t
+config_set_int_range(const char *attrname, char *value, int32_t *target, int32_t min, int32_t max, char *errorbuf, int apply)
+{
+    int32_t val;
+    char *endp = NULL;
+
+    if (config_value_is_null(attrname, value, errorbuf, 0)) {
+        return LDAP_OPERATIONS_ERROR;
+    }
+
+    errno = 0;
+    val = strtol(value, &endp, 10);
+    if ((*endp != '\0') || (errno == ERANGE) || (val < min) || (val > max)) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE, "limit \"%s\" is invalid, %s must range from %d to %d",
+                              value, attrname, min, max);
+        return LDAP_OPERATIONS_ERROR;
+    }
+    if (apply) {
+        slapi_atomic_store_32(target, val, __ATOMIC_RELEASE);
+    }
+    return LDAP_SUCCESS;
+}
+
+int32_t
+config_get_pw_verify_cache_size(void)
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    return slapi_atomic_load_32(&(slapdFrontendConfig->pw_verify_cache_size), __ATOMIC_ACQUIRE);
+}
+
+int32_t
+config_set_pw_verify_cache_size(const char *attrname, char *value, char *errorbuf, int apply)
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+
+    return config_set_int_range(attrname, value, &(slapdFrontendConfig->pw_verify_cache_size),
+                                1, 10000000, errorbuf, apply);
+}
+
+int32_t
+config_get_pw_verify_cache_ttl(void)
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    return slapi_atomic_load_32(&(slapdFrontendConfig->pw_verify_cache_ttl), __ATOMIC_ACQUIRE);
+}
+
+int32_t
+config_set_pw_verify_cache_ttl(const char *attrname, char *value, char *errorbuf, int apply)
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+
+    return config_set_int_range(attrname, value, &(slapdFrontendConfig->pw_verify_cache_ttl),
+                                1, 86400, errorbuf, apply);
+}
+
+int32_t
+config_get_pw_verify_threads(void)
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    return slapi_atomic_load_32(&(slapdFrontendConfig->pw_verify_threads), __ATOMIC_ACQUIRE);
+}
+
+/* The threads are started with the first cache miss: a change needs a restart */
+int32_t
+config_set_pw_verify_threads(const char *attrname, char *value, char *errorbuf, int apply)
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+
+    return config_set_int_range(attrname, value, &(slapdFrontendConfig->pw_verify_threads),
+                                0, 256, errorbuf, apply);
+}
+
+int32_t
+config_get_writebehind_interval(void)
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    return slapi_atomic_load_32(&(slapdFrontendConfig->writebehind_interval), __ATOMIC_ACQUIRE);
+}
+
+int32_t
+config_set_writebehind_interval(const char *attrname, char *value, char *errorbuf, int apply)
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+
+    return config_set_int_range(attrname, value, &(slapdFrontendConfig->writebehind_interval),
+                                0, 3600, errorbuf, apply);
+}
+
+int32_t
+config_get_search_fanout_threads(void)
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    return slapi_atomic_load_32(&(slapdFrontendConfig->search_fanout_threads), __ATOMIC_ACQUIRE);
+}
+
+int32_t
+config_set_search_fanout_threads(const char *attrname, char *value, char *errorbuf, int apply)
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+
+    return config_set_int_range(attrname, value, &(slapdFrontendConfig->search_fanout_threads),
+                                0, 256, errorbuf, apply);
+}
+
+int32_t
+config_get_eventq_executors(void)
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    return slapi_atomic_load_32(&(slapdFrontendConfig->eventq_executors), __ATOMIC_ACQUIRE);
+}
+
+/* The executors are started with the event queue: a change needs a restart */
+int32_t
+config_set_eventq_executors(const char *attrname, char *value, char *errorbuf, int apply)
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+
+    return config_set_int_range(attrname, value, &(slapdFrontendConfig->eventq_executors),
+                                1, 64, errorbuf, apply);
+}
+
 bool
 config_is_control_criticality_ignored(const char *oid)
 {
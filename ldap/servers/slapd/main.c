@@ -108,6 +108,8 @@ struct main_config
     int backuptools_verbose;
     int dbverify_verbose;
     char *dbverify_dbdir;
+    char *archive_base;
+    int archive_flags;
 };
 /* dbverify options */
 
@@ -358,7 +360,7 @@ usage(char *name, char *extraname, int slapd_exemode)
                    "Note: either \"-n backend_instance_name\" or \"-s includesuffix\" is required.\n";
         break;
     case SLAPD_EXEMODE_DB2ARCHIVE:
-        usagestr = "usage: %s %s%s-D configdir [-q] [-d debuglevel] -a archivedir\n";
+        usagestr = "usage: %s %s%s-D configdir [-q] [-d debuglevel] [-b basearchivedir] [-k] [-z] -a archivedir\n";
         break;
     case SLAPD_EXEMODE_ARCHIVE2DB:
         usagestr = "usage: %s %s%s-D configdir [-q] [-d debuglevel] -a archivedir\n";
@@ -1265,12 +1267,15 @@ process_command_line(int argc, char **argv, struct main_config *mcfg)
         {0, 0, 0}};
 
 
-    char *opts_db2archive = "vd:i:a:SD:qV";
+    char *opts_db2archive = "vd:i:a:b:kzSD:qV";
     struct opt_ext long_options_db2archive[] = {
         {"version", ArgNone, 'v'},
         {"debug", ArgRequired, 'd'},
         {"pidfile", ArgRequired, 'i'},
         {"archive", ArgRequired, 'a'},
+        {"incrementalBase", ArgRequired, 'b'},
+        {"compact", ArgNone, 'k'},
+        {"compress", ArgNone, 'z'},
         {"allowMultipleProcesses", ArgNone, 'S'},
         {"configDir", ArgRequired, 'D'},
         {"quiet", ArgNone, 'q'},
@@ -1686,6 +1691,18 @@ process_command_line(int argc, char **argv, struct main_config *mcfg)
             }
             break;
 
+        case 'b': /* db2archive: incremental backup relative to this archive */
+            mcfg->archive_base = optarg_ext;
+            break;
+
+        case 'k': /* db2archive: compacting copy */
+            mcfg->archive_flags |= SLAPI_DB2ARCHIVE_COMPACT;
+            break;
+
+        case 'z': /* db2archive: compress the database */
+            mcfg->archive_flags |= SLAPI_DB2ARCHIVE_COMPRESS;
+            break;
+
         case 'Z':
             if (mcfg->slapd_exemode == SLAPD_EXEMODE_LDIF2DB) {
                 break;
@@ -2456,6 +2473,8 @@ slapd_exemode_db2archive(struct main_config *mcfg)
     slapi_pblock_set(pb, SLAPI_BACKEND, NULL);
     slapi_pblock_set(pb, SLAPI_PLUGIN, backend_plugin);
     slapi_pblock_set(pb, SLAPI_SEQ_VAL, mcfg->archive_name);
+    slapi_pblock_set(pb, SLAPI_DB2ARCHIVE_BASE, mcfg->archive_base);
+    slapi_pblock_set(pb, SLAPI_DB2ARCHIVE_FLAGS, &mcfg->archive_flags);
     int32_t task_flags = SLAPI_TASK_RUNNING_FROM_COMMANDLINE;
     slapi_pblock_set(pb, SLAPI_TASK_FLAGS, &task_flags);
     return_value = (backend_plugin->plg_db2archive)(pb);
@@ -146,6 +146,50 @@ static void dump_mapping_tree(mapping_tree_node *parent, int depth);
 #endif
 #endif
 
+/*
+ * Suffix index
+ *
+ * Resolving a dn to its mapping tree node used to walk the tree from the
+ * root, comparing the dn with every child at each level. The index maps the
+ * normalized suffix of each node to the node, so that the best match is
+ * found by probing the suffixes of the dn: one probe per rdn.
+ *
+ * The index is immutable. It is tagged with the generation of the tree it
+ * was built from; any change of the tree shape bumps the generation, and the
+ * next lookup builds a new index and swaps it in. Swapped out indexes are
+ * kept for a grace period, as a lookup may still be probing them.
+ */
+typedef struct mtn_index_slot
+{
+    const char *mis_ndn; /* owned by the node */
+    size_t mis_len;
+    uint64_t mis_hash;
+    mapping_tree_node *mis_node;
+} mtn_index_slot;
+
+typedef struct mtn_index
+{
+    uint64_t mi_gen;
+    int mi_usable; /* 0 if the tree cannot be resolved through the index */
+    size_t mi_mask;
+    mtn_index_slot *mi_slots;
+    time_t mi_retired;
+    struct mtn_index *mi_next;
+} mtn_index;
+
+#define MTN_INDEX_GRACE 10 /* seconds */
+
+static mtn_index *mtn_index_current = NULL;
+static uint64_t mtn_index_gen = 1;
+static int32_t mtn_index_enabled = 0;
+static mtn_index *mtn_index_retired = NULL;
+static pthread_mutex_t mtn_index_retire_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void mtn_index_tree_changed(void);
+static void mtn_index_free_all(void);
+static mtn_index *mtn_index_get(void);
+static mapping_tree_node *mtn_index_find(const mtn_index *idx, const char *ndn, size_t len, int proper, int exact);
+
 /* structure and static local variable used to store the
  * list of plugins that have registered to a callback when backend state
  * change
@@ -333,6 +377,7 @@ mapping_tree_node_add_child(mapping_tree_node *parent, mapping_tree_node *child)
 {
     child->mtn_brother = parent->mtn_children;
     parent->mtn_children = child;
+    mtn_index_tree_changed();
 #ifdef DEBUG
 #ifdef USE_DUMP_MAPPING_TREE
     dump_mapping_tree(mapping_tree_root, 0);
@@ -1060,8 +1105,8 @@ mapping_tree_entry_modify_callback(Slapi_PBlock *pb,
                  * moving it to the new one
                  */
                 mtn_remove_node(node);
-                mapping_tree_node_add_child(parent_node, node);
                 node->mtn_parent = parent_node;
+                mapping_tree_node_add_child(parent_node, node);
                 mtn_unlock();
             } else if ((strcasecmp(mods[i]->mod_type, "cn") == 0) &&
                        SLAPI_IS_MOD_ADD(mods[i]->mod_op)) {
@@ -1441,6 +1486,7 @@ mtn_remove_node(mapping_tree_node *node)
             tmp_node->mtn_brother = node->mtn_brother;
     }
     node->mtn_brother = NULL;
+    mtn_index_tree_changed();
 }
 
 int
@@ -1710,6 +1756,9 @@ mapping_tree_init()
     mtn_create_extension(mapping_tree_root);
     slapi_rwlock_unlock(myLock);
 
+    /* The tree is built, lookups can go through the suffix index */
+    slapi_atomic_store_32(&mtn_index_enabled, 1, __ATOMIC_RELEASE);
+
     /* setup the dse callback functions for the ldbm instance config entry */
     {
         slapi_config_register_callback(SLAPI_OPERATION_MODIFY,
@@ -1778,6 +1827,8 @@ mapping_tree_free()
      * - unregister all those callbacks
      */
     slapi_unregister_backend_state_change_all();
+    slapi_atomic_store_32(&mtn_index_enabled, 0, __ATOMIC_RELEASE);
+    mtn_index_free_all();
     /* recursively free tree nodes */
     mtn_free_node(&mapping_tree_root);
     slapi_atomic_store_32(&mapping_tree_freed, 1, __ATOMIC_RELAXED);
@@ -2811,6 +2862,253 @@ best_matching_child(mapping_tree_node *parent,
 }
 
 
+/*
+ * The hash of a suffix is computed from its last character backward, so
+ * that a single right to left pass over a dn yields the hash of each of
+ * its suffixes. Case is ignored, as slapi_sdn_issuffix does.
+ */
+#define MTN_INDEX_HASH_INIT 0xcbf29ce484222325ULL
+#define MTN_INDEX_HASH_STEP(h, c) (((h) ^ (uint64_t)tolower((unsigned char)(c))) * 0x100000001b3ULL)
+#define MTN_INDEX_SEPARATOR(c) (((c) == ',') || ((c) == ';')) /* as in dn.c */
+
+static mapping_tree_node *
+mtn_index_probe(const mtn_index *idx, const char *ndn, size_t len, uint64_t hash)
+{
+    for (size_t i = hash & idx->mi_mask;; i = (i + 1) & idx->mi_mask) {
+        const mtn_index_slot *slot = &idx->mi_slots[i];
+
+        if (slot->mis_node == NULL) {
+            return NULL;
+        }
+        if (slot->mis_hash == hash && slot->mis_len == len &&
+            strncasecmp(slot->mis_ndn, ndn, len) == 0) {
+            return slot->mis_node;
+        }
+    }
+}
+
+/*
+ * Find the node of the longest suffix of ndn, or of ndn itself if exact is
+ * set. A suffix starts after a dn separator, as for slapi_sdn_issuffix.
+ * If proper is set, ndn itself is not considered.
+ */
+static mapping_tree_node *
+mtn_index_find(const mtn_index *idx, const char *ndn, size_t len, int proper, int exact)
+{
+    mapping_tree_node *found = NULL;
+    uint64_t hash = MTN_INDEX_HASH_INIT;
+
+    for (size_t i = len; i-- > 0;) {
+        hash = MTN_INDEX_HASH_STEP(hash, ndn[i]);
+        if (i == 0) {
+            if (!proper) {
+                mapping_tree_node *node = mtn_index_probe(idx, ndn, len, hash);
+                if (node) {
+                    found = node;
+                }
+            }
+        } else if (!exact && MTN_INDEX_SEPARATOR(ndn[i - 1])) {
+            mapping_tree_node *node = mtn_index_probe(idx, ndn + i, len - i, hash);
+            if (node) {
+                found = node;
+            }
+        }
+    }
+    return found;
+}
+
+static size_t
+mtn_index_count(mapping_tree_node *node)
+{
+    size_t count = 0;
+
+    for (mapping_tree_node *child = node->mtn_children; child; child = child->mtn_brother) {
+        count += 1 + mtn_index_count(child);
+    }
+    return count;
+}
+
+static int
+mtn_index_insert(mtn_index *idx, mapping_tree_node *node)
+{
+    const char *ndn = slapi_sdn_get_ndn(node->mtn_subtree);
+    size_t len = ndn ? strlen(ndn) : 0;
+    uint64_t hash = MTN_INDEX_HASH_INIT;
+    size_t i;
+
+    if (len == 0) {
+        /* only the root can hold the null suffix */
+        return -1;
+    }
+    for (i = len; i-- > 0;) {
+        hash = MTN_INDEX_HASH_STEP(hash, ndn[i]);
+    }
+    if (mtn_index_probe(idx, ndn, len, hash)) {
+        return -1;
+    }
+    for (i = hash & idx->mi_mask; idx->mi_slots[i].mis_node; i = (i + 1) & idx->mi_mask)
+        ;
+    idx->mi_slots[i].mis_ndn = ndn;
+    idx->mi_slots[i].mis_len = len;
+    idx->mi_slots[i].mis_hash = hash;
+    idx->mi_slots[i].mis_node = node;
+    return 0;
+}
+
+static int
+mtn_index_insert_subtree(mtn_index *idx, mapping_tree_node *node)
+{
+    for (mapping_tree_node *child = node->mtn_children; child; child = child->mtn_brother) {
+        if (mtn_index_insert(idx, child) || mtn_index_insert_subtree(idx, child)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * The longest suffix match is the node best_matching_child() ends on when
+ * walking down the tree, provided that the parent of every node is the node
+ * of its longest proper suffix. The configuration does not enforce it
+ * (orphan nodes, parent-suffix not being a suffix, ...): such trees are
+ * still resolved by walking them.
+ */
+static int
+mtn_index_check(const mtn_index *idx)
+{
+    for (size_t i = 0; i <= idx->mi_mask; i++) {
+        const mtn_index_slot *slot = &idx->mi_slots[i];
+        mapping_tree_node *parent;
+
+        if (slot->mis_node == NULL) {
+            continue;
+        }
+        parent = mtn_index_find(idx, slot->mis_ndn, slot->mis_len, 1, 0);
+        if (parent == NULL) {
+            parent = mapping_tree_root;
+        }
+        if (slot->mis_node->mtn_parent != parent) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static mtn_index *
+mtn_index_build(uint64_t gen)
+{
+    mtn_index *idx = (mtn_index *)slapi_ch_calloc(1, sizeof(mtn_index));
+    size_t count = mtn_index_count(mapping_tree_root);
+    size_t size = 16;
+
+    while (size < 2 * count) {
+        size <<= 1;
+    }
+    idx->mi_gen = gen;
+    idx->mi_mask = size - 1;
+    idx->mi_slots = (mtn_index_slot *)slapi_ch_calloc(size, sizeof(mtn_index_slot));
+    idx->mi_usable = (mtn_index_insert_subtree(idx, mapping_tree_root) == 0 &&
+                      mtn_index_check(idx) == 0);
+    if (!idx->mi_usable) {
+        slapi_log_err(SLAPI_LOG_TRACE, "mtn_index_build",
+                      "The mapping tree is not ordered by suffix, it will be walked for each lookup\n");
+    }
+    return idx;
+}
+
+static void
+mtn_index_free(mtn_index **idx)
+{
+    slapi_ch_free((void **)&(*idx)->mi_slots);
+    slapi_ch_free((void **)idx);
+}
+
+static void
+mtn_index_retire(mtn_index *old)
+{
+    time_t now = slapi_current_rel_time_t();
+    mtn_index **prev;
+
+    pthread_mutex_lock(&mtn_index_retire_lock);
+    /* the oldest indexes are at the tail of the list */
+    for (prev = &mtn_index_retired; *prev; prev = &(*prev)->mi_next) {
+        if (now - (*prev)->mi_retired > MTN_INDEX_GRACE) {
+            mtn_index *tofree = *prev;
+            *prev = NULL;
+            while (tofree) {
+                mtn_index *next = tofree->mi_next;
+                mtn_index_free(&tofree);
+                tofree = next;
+            }
+            break;
+        }
+    }
+    old->mi_retired = now;
+    old->mi_next = mtn_index_retired;
+    mtn_index_retired = old;
+    pthread_mutex_unlock(&mtn_index_retire_lock);
+}
+
+/* Called once the shape of the tree has changed */
+static void
+mtn_index_tree_changed(void)
+{
+    slapi_atomic_incr_64(&mtn_index_gen, __ATOMIC_RELEASE);
+}
+
+/* Called at shutdown, no lookup can run anymore */
+static void
+mtn_index_free_all(void)
+{
+    mtn_index *idx = __atomic_exchange_n(&mtn_index_current, NULL, __ATOMIC_ACQ_REL);
+
+    if (idx) {
+        mtn_index_free(&idx);
+    }
+    pthread_mutex_lock(&mtn_index_retire_lock);
+    while (mtn_index_retired) {
+        idx = mtn_index_retired;
+        mtn_index_retired = idx->mi_next;
+        mtn_index_free(&idx);
+    }
+    pthread_mutex_unlock(&mtn_index_retire_lock);
+}
+
+/*
+ * Return the index of the current tree, building it if needed, or NULL if
+ * the tree has to be walked.
+ */
+static mtn_index *
+mtn_index_get(void)
+{
+    mtn_index *idx;
+    mtn_index *new_idx;
+    uint64_t gen;
+
+    if (!slapi_atomic_load_32(&mtn_index_enabled, __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+    /* read the generation first: an index built from a tree that changes
+     * meanwhile is tagged with a stale generation and is never used */
+    gen = slapi_atomic_load_64(&mtn_index_gen, __ATOMIC_ACQUIRE);
+    idx = __atomic_load_n(&mtn_index_current, __ATOMIC_ACQUIRE);
+    if (idx && idx->mi_gen == gen) {
+        return idx->mi_usable ? idx : NULL;
+    }
+
+    new_idx = mtn_index_build(gen);
+    if (!__atomic_compare_exchange_n(&mtn_index_current, &idx, new_idx, 0,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        /* an other thread swapped its own index in, walk the tree this time */
+        mtn_index_free(&new_idx);
+        return NULL;
+    }
+    if (idx) {
+        mtn_index_retire(idx);
+    }
+    return new_idx->mi_usable ? new_idx : NULL;
+}
+
 /*
  * look for the exact mapping tree node corresponding to a given entry dn
  */
@@ -2829,6 +3127,15 @@ mtn_get_mapping_tree_node_by_entry(mapping_tree_node *node, const Slapi_DN *dn)
         return NULL;
     }
 
+    if (node == mapping_tree_root) {
+        mtn_index *idx = mtn_index_get();
+        const char *ndn = slapi_sdn_get_ndn(dn);
+
+        if (idx && ndn && *ndn) {
+            return mtn_index_find(idx, ndn, slapi_sdn_get_ndn_len(dn), 0, 1);
+        }
+    }
+
     if (slapi_sdn_compare(node->mtn_subtree, dn) == 0) {
         return node;
     }
@@ -2861,6 +3168,8 @@ slapi_get_mapping_tree_node_by_dn(const Slapi_DN *dn)
 {
     mapping_tree_node *current_best_match = mapping_tree_root;
     mapping_tree_node *next_best_match = mapping_tree_root;
+    mtn_index *idx;
+    const char *ndn;
 
     if (slapi_atomic_load_32(&mapping_tree_freed, __ATOMIC_RELAXED)) {
         /* shutdown detected */
@@ -2876,6 +3185,12 @@ slapi_get_mapping_tree_node_by_dn(const Slapi_DN *dn)
         return (mapping_tree_root);
     }
 
+    idx = mtn_index_get();
+    if (idx && (ndn = slapi_sdn_get_ndn(dn))) {
+        /* the node of the longest suffix, or NULL if none */
+        return mtn_index_find(idx, ndn, slapi_sdn_get_ndn_len(dn), 0, 0);
+    }
+
     /* Start at the root and walk down the tree to find the best match. */
     while (next_best_match) {
         current_best_match = next_best_match;
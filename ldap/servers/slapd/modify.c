@@ -642,6 +642,7 @@ op_shared_modify(Slapi_PBlock *pb, int pw_change, char *old_pw)
     char *errtext = NULL;
     int32_t log_format = config_get_accesslog_log_format();
     slapd_log_pblock logpb = {0};
+    char *wb_held = NULL;
 
     slapi_pblock_get(pb, SLAPI_ORIGINAL_TARGET, &dn);
     slapi_pblock_get(pb, SLAPI_MODIFY_TARGET_SDN, &sdn);
@@ -1098,6 +1099,10 @@ op_shared_modify(Slapi_PBlock *pb, int pw_change, char *old_pw)
 
         slapi_pblock_set(pb, SLAPI_PLUGIN, be->be_database);
         set_db_default_result_handlers(pb);
+        if (!operation_is_flag_set(operation, OP_FLAG_WRITEBEHIND)) {
+            /* the buffered values must not be applied over this modify */
+            wb_held = writebehind_hold(sdn);
+        }
         if (be->be_modify != NULL) {
             if ((rc = (*be->be_modify)(pb)) == 0) {
                 /* acl is not used for internal operations */
@@ -1115,6 +1120,13 @@ op_shared_modify(Slapi_PBlock *pb, int pw_change, char *old_pw)
                     update_pw_info(pb, old_pw);
                 }
 
+                if (wb_held) {
+                    /* the buffered values of these attributes are superseded */
+                    LDAPMod **applied_mods = NULL;
+                    slapi_pblock_get(pb, SLAPI_MODIFY_MODS, &applied_mods);
+                    writebehind_release(&wb_held, applied_mods);
+                }
+
                 slapi_pblock_get(pb, SLAPI_ENTRY_POST_OP, &pse);
                 do_ps_service(pse, NULL, LDAP_CHANGETYPE_MODIFY, 0);
             } else {
@@ -1154,6 +1166,7 @@ free_and_return : {
     slapi_entry_free(epre);
     slapi_entry_free(epost);
 }
+    writebehind_release(&wb_held, NULL);
     slapi_search_get_entry_done(&entry_pb);
 
     if (be)
@@ -646,6 +646,8 @@ op_shared_rename(Slapi_PBlock *pb, int passin_args)
      */
     if (plugin_call_plugins(pb, internal_op ? SLAPI_PLUGIN_INTERNAL_PRE_MODRDN_FN : SLAPI_PLUGIN_PRE_MODRDN_FN) == SLAPI_PLUGIN_SUCCESS) {
         int rc = LDAP_OPERATIONS_ERROR;
+        /* the buffered updates are keyed by the current dn */
+        writebehind_flush_dn(sdn);
         slapi_pblock_set(pb, SLAPI_PLUGIN, be->be_database);
         set_db_default_result_handlers(pb);
         if (be->be_modrdn != NULL) {
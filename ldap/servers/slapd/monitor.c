@@ -63,6 +63,8 @@ monitor_info(Slapi_PBlock *pb __attribute__((unused)),
 
     connection_table_as_entry(the_connection_table, e);
     tp_stats_as_entry(e);
+    latency_stats_as_entry(e);
+    eq_stats_as_entry(e);
 
     val.bv_len = snprintf(buf, sizeof(buf), "%" PRIu64, g_get_num_ops_initiated());
     val.bv_val = buf;
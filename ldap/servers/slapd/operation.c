@@ -24,6 +24,9 @@ int
 slapi_is_operation_abandoned(Slapi_Operation *op)
 {
     if (op != NULL) {
+        if (op->o_flags & OP_FLAG_SEARCH_FANOUT) {
+            return search_fanout_op_abandoned(op);
+        }
         return (op->o_status == SLAPI_OP_STATUS_ABANDONED);
     }
     return 0;
@@ -274,6 +274,7 @@ op_shared_search(Slapi_PBlock *pb, int send_result)
     pthread_mutex_t *pagedresults_mutex = NULL;
     int32_t log_format = config_get_accesslog_log_format();
     slapd_log_pblock logpb = {0};
+    struct search_fanout *fanout = NULL;
 
     be_list[0] = NULL;
     referral_list[0] = NULL;
@@ -693,6 +694,11 @@ op_shared_search(Slapi_PBlock *pb, int send_result)
     STAP_PROBE(ns-slapd, op_shared_search__prepared);
 #endif
 
+    /* build the candidates of the next backends in parallel */
+    if (be_list[0] != NULL && send_result && !op_is_pagedresults(operation)) {
+        fanout = search_fanout_start(pb, be_list, index + 1, basesdn, scope);
+    }
+
     nentries = 0;
     rc = -1; /* zero backends would mean failure */
     while (be) {
@@ -865,7 +871,9 @@ op_shared_search(Slapi_PBlock *pb, int send_result)
             slapi_pblock_set(pb, SLAPI_SEARCH_RESULT_SET, NULL);
 
             /* ONREPL - we need to be able to tell the backend not to send results directly */
-            rc = (*be->be_search)(pb);
+            if (!search_fanout_take(fanout, pb, be, &rc)) {
+                rc = (*be->be_search)(pb);
+            }
             switch (rc) {
             case 1:
                 /* if the backend returned LDAP_NO_SUCH_OBJECT for a SEARCH request,
@@ -1087,6 +1095,8 @@ op_shared_search(Slapi_PBlock *pb, int send_result)
     }
 
 free_and_return:
+    /* before the backends are unlocked */
+    search_fanout_done(&fanout);
     if ((be_list[0] != NULL) || (referral_list[0] != NULL)) {
         slapi_mapping_tree_free_all(be_list, referral_list);
     } else if (be_single) {
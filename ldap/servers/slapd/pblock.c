@@ -2869,6 +2869,28 @@ slapi_pblock_get_seq_val(Slapi_PBlock *pblock, void *value)
     return 0;
 }
 
+static int32_t
+slapi_pblock_get_db2archive_flags(Slapi_PBlock *pblock, void *value)
+{
+    if (pblock->pb_task != NULL) {
+        (*(int *)value) = pblock->pb_task->archive_flags;
+    } else {
+        (*(int *)value) = 0;
+    }
+    return 0;
+}
+
+static int32_t
+slapi_pblock_get_db2archive_base(Slapi_PBlock *pblock, void *value)
+{
+    if (pblock->pb_task != NULL) {
+        (*(char **)value) = pblock->pb_task->archive_base;
+    } else {
+        (*(char **)value) = NULL;
+    }
+    return 0;
+}
+
 static int32_t
 slapi_pblock_get_ldif2db_file(Slapi_PBlock *pblock, void *value)
 {
@@ -3089,6 +3111,17 @@ slapi_pblock_get_dbverify_dbdir(Slapi_PBlock *pblock, void *value)
     return 0;
 }
 
+static int32_t
+slapi_pblock_get_dbverify_flags(Slapi_PBlock *pblock, void *value)
+{
+    if (pblock->pb_task != NULL) {
+        (*(int *)value) = pblock->pb_task->dbverify_flags;
+    } else {
+        (*(int *)value) = 0;
+    }
+    return 0;
+}
+
 static int32_t
 slapi_pblock_get_parent_txn(Slapi_PBlock *pblock, void *value)
 {
@@ -5964,6 +5997,22 @@ slapi_pblock_set_seq_val(Slapi_PBlock *pblock, void *value)
     return 0;
 }
 
+static int32_t
+slapi_pblock_set_db2archive_flags(Slapi_PBlock *pblock, void *value)
+{
+    _pblock_assert_pb_task(pblock);
+    pblock->pb_task->archive_flags = *((int *)value);
+    return 0;
+}
+
+static int32_t
+slapi_pblock_set_db2archive_base(Slapi_PBlock *pblock, void *value)
+{
+    _pblock_assert_pb_task(pblock);
+    pblock->pb_task->archive_base = (char *)value;
+    return 0;
+}
+
 static int32_t
 slapi_pblock_set_ldif2db_file(Slapi_PBlock *pblock, void *value)
 {
@@ -6124,6 +6173,14 @@ slapi_pblock_set_dbverify_dbdir(Slapi_PBlock *pblock, void *value)
     return 0;
 }
 
+static int32_t
+slapi_pblock_set_dbverify_flags(Slapi_PBlock *pblock, void *value)
+{
+    _pblock_assert_pb_task(pblock);
+    pblock->pb_task->dbverify_flags = *((int *)value);
+    return 0;
+}
+
 static int32_t
 slapi_pblock_set_parent_txn(Slapi_PBlock *pblock, void *value)
 {
@@ -7040,9 +7097,9 @@ static int32_t (*get_cbtable[])(Slapi_PBlock *, void *) = {
     NULL, /* slot 154 available */
     slapi_pblock_get_skip_modified_attrs,
     slapi_pblock_get_requestor_ndn,
-    NULL, /* slot 157 available */
-    NULL, /* slot 158 available */
-    NULL, /* slot 159 available */
+    slapi_pblock_get_db2archive_flags,
+    slapi_pblock_get_db2archive_base,
+    slapi_pblock_get_dbverify_flags,
     slapi_pblock_get_ext_op_req_oid,
     slapi_pblock_get_ext_op_req_value,
     slapi_pblock_get_ext_op_ret_oid,
@@ -9015,9 +9072,9 @@ static int32_t (*set_cbtable[])(Slapi_PBlock *, void *) = {
     NULL, /* slot 154 available */
     slapi_pblock_set_skip_modified_attrs,
     NULL, /* "set" function not implemented for SLAPI_REQUESTOR_NDN (156) */
-    NULL, /* slot 157 available */
-    NULL, /* slot 158 available */
-    NULL, /* slot 159 available */
+    slapi_pblock_set_db2archive_flags,
+    slapi_pblock_set_db2archive_base,
+    slapi_pblock_set_dbverify_flags,
     slapi_pblock_set_ext_op_req_oid,
     slapi_pblock_set_ext_op_req_value,
     slapi_pblock_set_ext_op_ret_oid,
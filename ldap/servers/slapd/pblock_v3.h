@@ -46,6 +46,8 @@ typedef struct _slapi_pblock_task
     char *seq_attrname;
     char *seq_val;
     char *dbverify_dbdir;
+    int dbverify_flags; /* dbverify: SLAPI_DBVERIFY_REPAIR */
+    char *archive_base; /* db2archive: the backup an incremental backup is based on */
     char *ldif_file;
     char **db2index_attrs;
 
@@ -68,6 +70,7 @@ typedef struct _slapi_pblock_task
     int ldif2db_noattrindexes;
     int ldif_printkey;
     int task_flags;
+    int archive_flags; /* db2archive: SLAPI_DB2ARCHIVE_COMPACT|SLAPI_DB2ARCHIVE_COMPRESS */
     int32_t task_warning;
     int import_state;
 
@@ -410,8 +410,19 @@ plugin_call_plugins(Slapi_PBlock *pb, int whichfunction)
         }
 
         slapi_pblock_get(pb, SLAPI_PLUGIN, &p);
-        /* Call the operation on the Global Plugins */
-        rc = plugin_call_list(global_plugin_list[plugin_list_number], whichfunction, pb);
+        /* Time the pre-operation plugins, not those called for every entry or result sent */
+        if (plugin_list_number == PLUGIN_LIST_PREOPERATION &&
+            whichfunction != SLAPI_PLUGIN_PRE_ENTRY_FN &&
+            whichfunction != SLAPI_PLUGIN_PRE_REFERRAL_FN &&
+            whichfunction != SLAPI_PLUGIN_PRE_RESULT_FN) {
+            uint64_t start = latency_stats_now();
+
+            rc = plugin_call_list(global_plugin_list[plugin_list_number], whichfunction, pb);
+            latency_stats_record(LATENCY_PHASE_PREOP, start);
+        } else {
+            /* Call the operation on the Global Plugins */
+            rc = plugin_call_list(global_plugin_list[plugin_list_number], whichfunction, pb);
+        }
         slapi_pblock_set(pb, SLAPI_PLUGIN, p);
 
         if (!locked) {
@@ -47,6 +47,7 @@ plugin_call_acl_plugin(Slapi_PBlock *pb, Slapi_Entry *e, char **attrs, struct be
     int rc = LDAP_INSUFFICIENT_ACCESS;
     int aclplugin_initialized = 0;
     Operation *operation;
+    uint64_t start;
 
     slapi_pblock_get(pb, SLAPI_OPERATION, &operation);
 
@@ -54,6 +55,7 @@ plugin_call_acl_plugin(Slapi_PBlock *pb, Slapi_Entry *e, char **attrs, struct be
     if (operation_is_flag_set(operation, SLAPI_OP_FLAG_NO_ACCESS_CHECK | OP_FLAG_INTERNAL | OP_FLAG_REPLICATED))
         return LDAP_SUCCESS;
 
+    start = latency_stats_now();
     /* call the global plugins first and then the backend specific */
     for (p = get_plugin_list(PLUGIN_LIST_ACL); p != NULL; p = p->plg_next) {
         if (plugin_invoke_plugin_sdn(p, SLAPI_PLUGIN_ACL_ALLOW_ACCESS, pb,
@@ -68,6 +70,7 @@ plugin_call_acl_plugin(Slapi_PBlock *pb, Slapi_Entry *e, char **attrs, struct be
     if (!aclplugin_initialized) {
         rc = acl_default_access(pb, e, access);
     }
+    latency_stats_record(LATENCY_PHASE_ACL, start);
     return rc;
 }
 
@@ -79,6 +82,7 @@ plugin_call_acl_mods_access(Slapi_PBlock *pb, Slapi_Entry *e, LDAPMod **mods, ch
     int aclplugin_initialized = 0;
     int rc = LDAP_INSUFFICIENT_ACCESS;
     Operation *operation;
+    uint64_t start;
 
     slapi_pblock_get(pb, SLAPI_OPERATION, &operation);
 
@@ -86,6 +90,7 @@ plugin_call_acl_mods_access(Slapi_PBlock *pb, Slapi_Entry *e, LDAPMod **mods, ch
     if (operation_is_flag_set(operation, SLAPI_OP_FLAG_NO_ACCESS_CHECK | OP_FLAG_INTERNAL | OP_FLAG_REPLICATED))
         return LDAP_SUCCESS;
 
+    start = latency_stats_now();
     /* call the global plugins first and then the backend specific */
     for (p = get_plugin_list(PLUGIN_LIST_ACL); p != NULL; p = p->plg_next) {
         if (plugin_invoke_plugin_sdn(p, SLAPI_PLUGIN_ACL_MODS_ALLOWED, pb,
@@ -99,6 +104,7 @@ plugin_call_acl_mods_access(Slapi_PBlock *pb, Slapi_Entry *e, LDAPMod **mods, ch
     if (!aclplugin_initialized) {
         rc = acl_default_access(pb, e, SLAPI_ACL_WRITE);
     }
+    latency_stats_record(LATENCY_PHASE_ACL, start);
     return rc;
 }
 
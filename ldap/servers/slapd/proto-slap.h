@@ -106,6 +106,8 @@ struct asyntaxinfo *attr_syntax_get_by_name(const char *name, PRUint32 schema_fl
 struct asyntaxinfo *attr_syntax_get_by_name_with_default(const char *name);
 struct asyntaxinfo *attr_syntax_get_by_name_locking_optional(const char *name, PRBool use_lock, PRUint32 schema_flags);
 struct asyntaxinfo *attr_syntax_get_global_at(void);
+uint32_t attr_syntax_id_count(void);
+uint32_t attr_syntax_lookup_id(const char *name);
 struct asyntaxinfo *attr_syntax_find(struct asyntaxinfo *at1, struct asyntaxinfo *at2);
 void attr_syntax_swap_ht(void);
 int attr_syntax_init_tmp(void);
@@ -160,6 +162,8 @@ void valueset_update_csn(Slapi_ValueSet *vs, CSNType t, const CSN *csn);
 int valueset_intersectswith_valuearray(Slapi_ValueSet *vs, const Slapi_Attr *a, Slapi_Value **values, int *duplicate_index);
 void valueset_set_valueset(Slapi_ValueSet *vs1, const Slapi_ValueSet *vs2);
 Slapi_ValueSet *valueset_dup(const Slapi_ValueSet *dupee);
+void valueset_share(Slapi_ValueSet *vs1, const Slapi_ValueSet *vs2);
+void valueset_unshare(Slapi_ValueSet *vs);
 void valueset_remove_string(const Slapi_Attr *a, Slapi_ValueSet *vs, const char *s);
 int valueset_replace_valuearray(Slapi_Attr *a, Slapi_ValueSet *vs, Slapi_Value **vals);
 int valueset_replace_valuearray_ext(Slapi_Attr *a, Slapi_ValueSet *vs, Slapi_Value **vals, int dupcheck);
@@ -672,6 +676,20 @@ char * config_get_fgot(void);
 
 int config_set_ignored_criticality_list(const char *attrname, char *value, char *errorbuf, int apply);
 char **config_get_ignored_criticality_list(void);
+int32_t config_get_pw_verify_cache(void);
+int32_t config_set_pw_verify_cache(const char *attrname, char *value, char *errorbuf, int apply);
+int32_t config_get_pw_verify_cache_size(void);
+int32_t config_set_pw_verify_cache_size(const char *attrname, char *value, char *errorbuf, int apply);
+int32_t config_get_pw_verify_cache_ttl(void);
+int32_t config_set_pw_verify_cache_ttl(const char *attrname, char *value, char *errorbuf, int apply);
+int32_t config_get_pw_verify_threads(void);
+int32_t config_set_pw_verify_threads(const char *attrname, char *value, char *errorbuf, int apply);
+int32_t config_get_writebehind_interval(void);
+int32_t config_set_writebehind_interval(const char *attrname, char *value, char *errorbuf, int apply);
+int32_t config_get_search_fanout_threads(void);
+int32_t config_set_search_fanout_threads(const char *attrname, char *value, char *errorbuf, int apply);
+int32_t config_get_eventq_executors(void);
+int32_t config_set_eventq_executors(const char *attrname, char *value, char *errorbuf, int apply);
 bool config_is_control_criticality_ignored(const char *oid);
 
 int is_abspath(const char *);
@@ -766,6 +784,7 @@ void set_hash_filters(int i);
 char *filter_strcpy_special(char *d, char *s);
 #define FILTER_STRCPY_ESCAPE_RECHARS 0x01
 char *filter_strcpy_special_ext(char *d, char *s, int flags);
+int vattr_filter_test_tree(Slapi_PBlock *pb, Slapi_Entry *e, struct slapi_filter *f);
 
 
 /*
@@ -1099,6 +1118,30 @@ void pw_apply_mods(const Slapi_DN *sdn, Slapi_Mods *mods);
 void pw_set_componentID(struct slapi_componentid *cid);
 struct slapi_componentid *pw_get_componentID(void);
 
+/*
+ * pw_verify_cache.c
+ */
+void pw_verify_cache_stop(void);
+
+/*
+ * search_fanout.c
+ */
+struct search_fanout *search_fanout_start(Slapi_PBlock *pb, Slapi_Backend **be_list, int nbe, const Slapi_DN *basesdn, int scope);
+int search_fanout_take(struct search_fanout *sf, Slapi_PBlock *pb, Slapi_Backend *be, int *rc);
+void search_fanout_done(struct search_fanout **sfp);
+int search_fanout_op_abandoned(Slapi_Operation *op);
+void search_fanout_stop(void);
+
+/*
+ * writebehind.c
+ */
+int writebehind_overlay(const Slapi_Entry *e, Slapi_Entry **copy);
+void writebehind_drop(const Slapi_DN *sdn);
+char *writebehind_hold(const Slapi_DN *sdn);
+void writebehind_release(char **ndnp, LDAPMod **mods);
+void writebehind_flush_dn(const Slapi_DN *sdn);
+void writebehind_stop(void);
+
 /*
  * referral.c
  */
@@ -1158,6 +1201,8 @@ int read_schema_dse(Slapi_PBlock *pb, Slapi_Entry *entryBefore, Slapi_Entry *ent
 void oc_lock_read(void);
 void oc_lock_write(void);
 void oc_unlock(void);
+PRBool oc_lock_is_write_held(void);
+void oc_index_invalidate_nolock(void);
 /* Note: callers of g_get_global_oc_nolock(void) must hold a read or write lock */
 struct objclass *g_get_global_oc_nolock(void);
 /* Note: callers of g_set_global_oc_nolock(void) must hold a write lock */
@@ -1351,6 +1396,7 @@ struct snmp_vars_t *g_get_global_snmp_vars(void);
 void alloc_global_snmp_vars(void);
 void alloc_per_thread_snmp_vars(int32_t maxthread);
 void thread_private_snmp_vars_set_idx(int32_t idx);
+int thread_private_snmp_vars_get_idx(void);
 struct snmp_vars_t *g_get_per_thread_snmp_vars(void);
 struct snmp_vars_t *g_get_first_thread_snmp_vars(int *cookie);
 struct snmp_vars_t *g_get_next_thread_snmp_vars(int *cookie);
@@ -1433,12 +1479,22 @@ void write_auditfail_log_entry(Slapi_PBlock *pb);
 void auditfaillog_hide_unhashed_pw(void);
 void auditfaillog_expose_unhashed_pw(void);
 
+/*
+ * latency_stats.c
+ */
+void latency_stats_init(int32_t maxthread);
+uint64_t latency_stats_now(void);
+void latency_stats_record(slapd_latency_phase_t phase, uint64_t start_ns);
+void latency_stats_record_ns(slapd_latency_phase_t phase, uint64_t elapsed_ns);
+void latency_stats_as_entry(Slapi_Entry *e);
+
 /*
  * eventq.c
  */
 void eq_init_rel(void);
 void eq_start_rel(void);
 void eq_stop_rel(void);
+void eq_stats_as_entry(Slapi_Entry *e);
 /* Deprecated eventq that uses REALTIME clock instead of MONOTONIC */
 void eq_init(void);
 void eq_start(void);
@@ -1556,6 +1612,8 @@ void subentry_create_filter(Slapi_Filter **filter);
 void vattr_init(void);
 void vattr_cleanup(void);
 void vattr_check(void);
+uint64_t vattr_map_generation(void);
+int32_t vattr_map_type_may_be_virtual(const char *type);
 
 /*
  * slapd_plhash.c - supplement to NSPR plhash
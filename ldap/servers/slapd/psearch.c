@@ -16,29 +16,59 @@
  * psearch.c - persistent search
  * August 1997, ggood@netscape.com
  *
- * Open issues:
- *  - we increment and decrement active_threads in here.  Are there
- *    conditions under which this can prevent a server shutdown?
+ * Persistent searches asking for the same thing (base, scope, filter,
+ * change types, attributes) on behalf of the same identity are put in a
+ * group. A change is matched once per group and the access check is done
+ * once per group, then the change is queued on every member. The results
+ * are sent by a small pool of sender threads that serve the persistent
+ * searches having something to do, rather than by one thread per
+ * persistent search.
  */
 
 #include <assert.h>
 #include "slap.h"
 #include "fe.h"
 
+/*
+ * A change, shared by all the persistent searches it is queued on.
+ * The ctrl is an "Entry Modify Notification" control which we may
+ * send back with the entry.
+ */
+typedef struct _ps_change
+{
+    Slapi_Entry *pc_entry;
+    LDAPControl *pc_ctrl;
+    uint64_t pc_refcnt;
+} PSChange;
+
+/*
+ * A change matching a group. The access check result is the same for
+ * all the members of the group, the first member to send the change
+ * does it.
+ */
+#define PS_ACCESS_UNKNOWN 0
+#define PS_ACCESS_ALLOWED 1
+#define PS_ACCESS_DENIED 2
+typedef struct _ps_group_change
+{
+    PSChange *pg_change;
+    int32_t pg_access;
+    uint64_t pg_refcnt;
+} PSGroupChange;
+
 /*
  * A structure used to create a linked list
  * of entries being sent by a particular persistent
- * search result thread.
- * The ctrl is an "Entry Modify Notification" control
- * which we may send back with entries.
+ * search.
  */
 typedef struct _ps_entry_queue_node
 {
-    Slapi_Entry *pe_entry;
-    LDAPControl *pe_ctrls[2];
+    PSGroupChange *pe_change;
     struct _ps_entry_queue_node *pe_next;
 } PSEQNode;
 
+struct _psearch_group;
+
 /*
  * Information about a single persistent search
  */
@@ -52,9 +82,31 @@ typedef struct _psearch
     time_t ps_lasttime;
     ber_int_t ps_changetypes;
     int ps_send_entchg_controls;
+    int ps_conn_acq_flag;              /* 0 if we hold a reference on the connection */
+    int ps_scheduled;                  /* on the ready list or being served (pl_cvarlock) */
+    int ps_busy;                       /* being served by a sender (pl_cvarlock) */
+    int ps_rerun;                      /* scheduled while being served (pl_cvarlock) */
+    struct _psearch_group *ps_group;
+    struct _psearch *ps_group_next;    /* next member of the group */
+    struct _psearch *ps_ready_next;    /* next on the ready list */
     struct _psearch *ps_next;
 } PSearch;
 
+/*
+ * Persistent searches with the same key
+ */
+typedef struct _psearch_group
+{
+    char *pg_key;
+    Slapi_DN *pg_base;
+    int pg_scope;
+    Slapi_Filter *pg_filter;
+    Slapi_PBlock *pg_pblock; /* pblock of a member, used to match the changes */
+    ber_int_t pg_changetypes;
+    PSearch *pg_members;
+    struct _psearch_group *pg_next;
+} PSearch_Group;
+
 /*
  * A list of outstanding persistent searches.
  */
@@ -62,10 +114,20 @@ typedef struct _psearch_list
 {
     Slapi_RWLock *pl_rwlock;     /* R/W lock struct to serialize access */
     PSearch *pl_head;            /* Head of list */
-    pthread_mutex_t pl_cvarlock; /* Lock for cvar */
-    pthread_cond_t pl_cvar;      /* ps threads sleep on this */
+    PSearch_Group *pl_groups;    /* groups of the persistent searches in the list */
+    pthread_mutex_t pl_cvarlock; /* Lock for cvar and the ready list */
+    pthread_cond_t pl_cvar;      /* sender threads sleep on this */
+    PSearch *pl_ready_head;      /* persistent searches with work to do */
+    PSearch *pl_ready_tail;
+    int pl_nsenders;             /* number of sender threads started */
+    int pl_stopping;
 } PSearch_List;
 
+/* Max number of changes sent to a client before serving the next one */
+#define PS_SEND_BATCH 64
+#define PS_MIN_SENDERS 2
+#define PS_MAX_SENDERS 64
+
 /*
  * Convenience macros for locking the list of persistent searches
  */
@@ -85,11 +147,18 @@ typedef struct _psearch_list
 static PSearch_List *psearch_list = NULL;
 
 /* Forward declarations */
-static void ps_send_results(void *arg);
+static void ps_sender(void *arg);
+static int ps_serve(PSearch *ps);
+static void ps_end(PSearch *ps);
+static void ps_start_senders(void);
+static void ps_schedule_nolock(PSearch *ps);
 static PSearch *psearch_alloc(void);
 static void ps_add_ps(PSearch *ps);
 static void ps_remove(PSearch *dps);
+static char *ps_group_key(Slapi_PBlock *pb, ber_int_t changetypes, int send_entchg_controls);
 static void pe_ch_free(PSEQNode **pe);
+static void ps_change_release(PSChange **pcp);
+static void ps_group_change_release(PSGroupChange **pgcp);
 static int create_entrychange_control(ber_int_t chgtype, ber_int_t chgnum, const char *prevdn, LDAPControl **ctrlp);
 
 
@@ -143,20 +212,24 @@ ps_stop_psearch_system()
             slapi_atomic_incr_64(&(ps->ps_complete), __ATOMIC_RELEASE);
         }
         PSL_UNLOCK_WRITE();
+        pthread_mutex_lock(&(psearch_list->pl_cvarlock));
+        psearch_list->pl_stopping = 1;
+        pthread_mutex_unlock(&(psearch_list->pl_cvarlock));
         ps_wakeup_all();
     }
 }
 
 /*
  * Add the given pblock to the list of outstanding persistent searches.
- * Then, start a thread to send the results to the client as they
+ * The results are sent to the client by the sender threads as they
  * are dispatched by add, modify, and modrdn operations.
  */
 void
 ps_add(Slapi_PBlock *pb, ber_int_t changetypes, int send_entchg_controls)
 {
     PSearch *ps;
-    PRThread *ps_tid;
+    Connection *pb_conn = NULL;
+    Operation *pb_op = NULL;
 
     if (PS_IS_INITIALIZED() && NULL != pb) {
         /* Create the new node */
@@ -168,39 +241,157 @@ ps_add(Slapi_PBlock *pb, ber_int_t changetypes, int send_entchg_controls)
         ps->ps_changetypes = changetypes;
         ps->ps_send_entchg_controls = send_entchg_controls;
 
+        slapi_pblock_get(ps->ps_pblock, SLAPI_CONNECTION, &pb_conn);
+        slapi_pblock_get(ps->ps_pblock, SLAPI_OPERATION, &pb_op);
+        if (pb_conn == NULL) {
+            slapi_log_err(SLAPI_LOG_ERR, "ps_add", "pb_conn is NULL\n");
+            PR_DestroyLock(ps->ps_lock);
+            slapi_ch_free((void **)&ps->ps_pblock);
+            slapi_ch_free((void **)&ps);
+            return;
+        }
+
+        /* need to acquire a reference to this connection so that it will not
+           be released or cleaned up out from under us */
+        pthread_mutex_lock(&(pb_conn->c_mutex));
+        ps->ps_conn_acq_flag = connection_acquire_nolock(pb_conn);
+        pthread_mutex_unlock(&(pb_conn->c_mutex));
+
+        if (ps->ps_conn_acq_flag) {
+            slapi_log_err(SLAPI_LOG_CONNS, "ps_add",
+                          "conn=%" PRIu64 " op=%d Could not acquire the connection - psearch aborted\n",
+                          pb_conn->c_connid, pb_op ? pb_op->o_opid : -1);
+            slapi_atomic_store_64(&(ps->ps_complete), 1, __ATOMIC_RELEASE);
+        }
+
         /* Add it to the head of the list of persistent searches */
         ps_add_ps(ps);
+        ps_start_senders();
 
-        /* Start a thread to send the results */
-        ps_tid = PR_CreateThread(PR_USER_THREAD, ps_send_results,
-                                 (void *)ps, PR_PRIORITY_NORMAL, PR_GLOBAL_THREAD,
-                                 PR_UNJOINABLE_THREAD, SLAPD_DEFAULT_THREAD_STACKSIZE);
+        if (ps->ps_conn_acq_flag) {
+            /* let a sender clean it up */
+            pthread_mutex_lock(&(psearch_list->pl_cvarlock));
+            ps_schedule_nolock(ps);
+            pthread_mutex_unlock(&(psearch_list->pl_cvarlock));
+        }
+    }
+}
 
-        /* Checking if the thread is succesfully created and
-         * if the thread is not created succesfully.... we send
-         * error messages to the Log file
-         */
-        if (NULL == ps_tid) {
-            int prerr;
-            prerr = PR_GetError();
-            slapi_log_err(SLAPI_LOG_ERR, "ps_add", "PR_CreateThread()failed in the "
-                                                   "ps_add function: " SLAPI_COMPONENT_NAME_NSPR " error %d (%s)\n",
-                          prerr, slapd_pr_strerror(prerr));
+/*
+ * Start the sender threads, the first time a persistent search is added.
+ * They are sized on the worker threads, a sender may block on a slow
+ * client for up to the ioblocktimeout.
+ */
+static void
+ps_start_senders(void)
+{
+    int nsenders;
+    int i;
 
-            /* Now remove the ps from the list so call the function ps_remove */
-            ps_remove(ps);
-            PR_DestroyLock(ps->ps_lock);
-            ps->ps_lock = NULL;
-            slapi_ch_free((void **)&ps->ps_pblock);
-            slapi_ch_free((void **)&ps);
+    pthread_mutex_lock(&(psearch_list->pl_cvarlock));
+    if (psearch_list->pl_nsenders > 0 || psearch_list->pl_stopping) {
+        pthread_mutex_unlock(&(psearch_list->pl_cvarlock));
+        return;
+    }
+    nsenders = config_get_threadnumber() / 4;
+    if (nsenders < PS_MIN_SENDERS) {
+        nsenders = PS_MIN_SENDERS;
+    } else if (nsenders > PS_MAX_SENDERS) {
+        nsenders = PS_MAX_SENDERS;
+    }
+    for (i = 0; i < nsenders; i++) {
+        PRThread *tid = PR_CreateThread(PR_USER_THREAD, ps_sender, NULL,
+                                        PR_PRIORITY_NORMAL, PR_GLOBAL_THREAD,
+                                        PR_UNJOINABLE_THREAD, SLAPD_DEFAULT_THREAD_STACKSIZE);
+        if (NULL == tid) {
+            int prerr = PR_GetError();
+            slapi_log_err(SLAPI_LOG_ERR, "ps_start_senders", "PR_CreateThread() failed: "
+                          SLAPI_COMPONENT_NAME_NSPR " error %d (%s)\n",
+                          prerr, slapd_pr_strerror(prerr));
+            break;
         }
+        psearch_list->pl_nsenders++;
+    }
+    if (psearch_list->pl_nsenders == 0) {
+        /* nothing can send the results, do not leave the clients hanging */
+        slapi_log_err(SLAPI_LOG_ERR, "ps_start_senders",
+                      "No persistent search sender thread could be started\n");
+    } else {
+        slapi_log_err(SLAPI_LOG_CONNS, "ps_start_senders",
+                      "Started %d persistent search sender threads\n", psearch_list->pl_nsenders);
     }
+    pthread_mutex_unlock(&(psearch_list->pl_cvarlock));
 }
 
+/*
+ * Build the key of the group of a persistent search: what is searched
+ * and who searches it. The client address and the security of the
+ * connection are part of the identity as access control may depend on
+ * them.
+ */
+static char *
+ps_group_key(Slapi_PBlock *pb, ber_int_t changetypes, int send_entchg_controls)
+{
+    Slapi_DN *base = NULL;
+    char *origbase = NULL;
+    char *fstr = NULL;
+    char *ndn = NULL;
+    char **attrs = NULL;
+    char *attrstr = NULL;
+    Connection *pb_conn = NULL;
+    int scope = 0;
+    int attrsonly = 0;
+    int isroot = 0;
+    int ssf = 0;
+    char *authtype = NULL;
+    char *ipaddr = NULL;
+    char *key;
+
+    slapi_pblock_get(pb, SLAPI_SEARCH_TARGET_SDN, &base);
+    slapi_pblock_get(pb, SLAPI_ORIGINAL_TARGET_DN, &origbase);
+    slapi_pblock_get(pb, SLAPI_SEARCH_SCOPE, &scope);
+    slapi_pblock_get(pb, SLAPI_SEARCH_STRFILTER, &fstr);
+    slapi_pblock_get(pb, SLAPI_SEARCH_ATTRS, &attrs);
+    slapi_pblock_get(pb, SLAPI_SEARCH_ATTRSONLY, &attrsonly);
+    slapi_pblock_get(pb, SLAPI_REQUESTOR_NDN, &ndn);
+    slapi_pblock_get(pb, SLAPI_REQUESTOR_ISROOT, &isroot);
+    slapi_pblock_get(pb, SLAPI_CONNECTION, &pb_conn);
+
+    for (size_t i = 0; attrs && attrs[i]; i++) {
+        attrstr = slapi_ch_smprintf("%s%s%s", attrstr ? attrstr : "", attrstr ? "," : "", attrs[i]);
+    }
+    if (attrstr) {
+        slapi_dn_ignore_case(attrstr);
+    }
+    if (pb_conn) {
+        pthread_mutex_lock(&(pb_conn->c_mutex));
+        ssf = pb_conn->c_ssl_ssf;
+        if (pb_conn->c_sasl_ssf > ssf) {
+            ssf = pb_conn->c_sasl_ssf;
+        }
+        if (pb_conn->c_local_ssf > ssf) {
+            ssf = pb_conn->c_local_ssf;
+        }
+        authtype = slapi_ch_strdup(pb_conn->c_authtype);
+        ipaddr = slapi_ch_strdup(pb_conn->c_ipaddr);
+        pthread_mutex_unlock(&(pb_conn->c_mutex));
+    }
+
+    key = slapi_ch_smprintf("%s|%d|%s|%d|%d|%d|%s|%s|%d|%s|%d|%s",
+                            base ? slapi_sdn_get_ndn(base) : (origbase ? origbase : ""),
+                            scope, fstr ? fstr : "", changetypes, send_entchg_controls,
+                            attrsonly, attrstr ? attrstr : "*",
+                            ndn ? ndn : "", isroot, authtype ? authtype : "", ssf,
+                            ipaddr ? ipaddr : "");
+    slapi_ch_free_string(&attrstr);
+    slapi_ch_free_string(&authtype);
+    slapi_ch_free_string(&ipaddr);
+    return key;
+}
 
 /*
  * Remove the given PSearch from the list of outstanding persistent
- * searches and delete its resources.
+ * searches and from its group.
  */
 static void
 ps_remove(PSearch *dps)
@@ -224,6 +415,35 @@ ps_remove(PSearch *dps)
                 }
             }
         }
+        if (dps->ps_group) {
+            PSearch_Group *pg = dps->ps_group;
+            PSearch **psp;
+
+            for (psp = &pg->pg_members; *psp; psp = &(*psp)->ps_group_next) {
+                if (*psp == dps) {
+                    *psp = dps->ps_group_next;
+                    break;
+                }
+            }
+            dps->ps_group = NULL;
+            if (pg->pg_members) {
+                /* the pblock of the leaving member is about to be freed */
+                pg->pg_pblock = pg->pg_members->ps_pblock;
+            } else {
+                PSearch_Group **pgp;
+
+                for (pgp = &psearch_list->pl_groups; *pgp; pgp = &(*pgp)->pg_next) {
+                    if (*pgp == pg) {
+                        *pgp = pg->pg_next;
+                        break;
+                    }
+                }
+                slapi_ch_free_string(&pg->pg_key);
+                slapi_sdn_free(&pg->pg_base);
+                slapi_filter_free(pg->pg_filter, 1);
+                slapi_ch_free((void **)&pg);
+            }
+        }
         PSL_UNLOCK_WRITE();
     }
 }
@@ -235,147 +455,263 @@ static void
 pe_ch_free(PSEQNode **pe)
 {
     if (pe != NULL && *pe != NULL) {
-        if ((*pe)->pe_entry != NULL) {
-            slapi_entry_free((*pe)->pe_entry);
-            (*pe)->pe_entry = NULL;
-        }
+        ps_group_change_release(&(*pe)->pe_change);
+        slapi_ch_free((void **)pe);
+    }
+}
+
+static void
+ps_change_release(PSChange **pcp)
+{
+    PSChange *pc = *pcp;
 
-        if ((*pe)->pe_ctrls[0] != NULL) {
-            ldap_control_free((*pe)->pe_ctrls[0]);
-            (*pe)->pe_ctrls[0] = NULL;
+    if (pc == NULL) {
+        return;
+    }
+    *pcp = NULL;
+    if (slapi_atomic_decr_64(&(pc->pc_refcnt), __ATOMIC_ACQ_REL) == 0) {
+        slapi_entry_free(pc->pc_entry);
+        if (pc->pc_ctrl) {
+            ldap_control_free(pc->pc_ctrl);
         }
+        slapi_ch_free((void **)&pc);
+    }
+}
 
-        slapi_ch_free((void **)pe);
+static void
+ps_group_change_release(PSGroupChange **pgcp)
+{
+    PSGroupChange *pgc = *pgcp;
+
+    if (pgc == NULL) {
+        return;
+    }
+    *pgcp = NULL;
+    if (slapi_atomic_decr_64(&(pgc->pg_refcnt), __ATOMIC_ACQ_REL) == 0) {
+        ps_change_release(&pgc->pg_change);
+        slapi_ch_free((void **)&pgc);
     }
 }
 
+/*
+ * Put a persistent search on the ready list, unless it is already there.
+ * If a sender is serving it, the sender will serve it again when done.
+ * Caller holds pl_cvarlock.
+ */
+static void
+ps_schedule_nolock(PSearch *ps)
+{
+    if (ps->ps_busy) {
+        ps->ps_rerun = 1;
+        return;
+    }
+    if (ps->ps_scheduled) {
+        return;
+    }
+    ps->ps_scheduled = 1;
+    ps->ps_ready_next = NULL;
+    if (psearch_list->pl_ready_tail) {
+        psearch_list->pl_ready_tail->ps_ready_next = ps;
+    } else {
+        psearch_list->pl_ready_head = ps;
+    }
+    psearch_list->pl_ready_tail = ps;
+    pthread_cond_signal(&(psearch_list->pl_cvar));
+}
+
 
 /*
- * Thread routine for sending search results to a client
- * which is persistently waiting for them.
- *
- * This routine will terminate when either (a) the ps_complete
- * flag is set, or (b) the associated operation is abandoned.
- * In any case, the thread won't notice until it wakes from
- * sleeping on the ps_list condition variable, so it needs
- * to be awakened.
+ * Sender thread routine. Serves the persistent searches on the ready list,
+ * in turn, until the server shuts down and all the persistent searches
+ * are closed.
  */
 static void
-ps_send_results(void *arg)
+ps_sender(void *arg __attribute__((unused)))
 {
     slapi_set_thread_name("ps-send");
-    PSearch *ps = (PSearch *)arg;
-    PSEQNode *peq, *peqnext;
-    struct slapi_filter *filter = 0;
-    char *base = NULL;
-    Slapi_DN *sdn = NULL;
-    char *fstr = NULL;
-    char **pbattrs = NULL;
-    int conn_acq_flag = 0;
-    Slapi_Connection *conn = NULL;
-    Connection *pb_conn = NULL;
-    Operation *pb_op = NULL;
 
     g_incr_active_threadcnt();
 
-    slapi_pblock_get(ps->ps_pblock, SLAPI_CONNECTION, &pb_conn);
-    slapi_pblock_get(ps->ps_pblock, SLAPI_OPERATION, &pb_op);
+    pthread_mutex_lock(&(psearch_list->pl_cvarlock));
+    while (1) {
+        PSearch *ps = psearch_list->pl_ready_head;
+        int ended;
 
-    if (pb_conn == NULL) {
-        slapi_log_err(SLAPI_LOG_ERR, "ps_send_results", "pb_conn is NULL\n");
-        return;
-    }
+        if (NULL == ps) {
+            if (psearch_list->pl_stopping && psearch_list->pl_head == NULL) {
+                break;
+            } else {
+                /* Nothing to do. The abandon and connection close code
+                 * wake us up, but check the list every second anyway */
+                struct timespec current_time = {0};
+                clock_gettime(CLOCK_REALTIME, &current_time);
+                current_time.tv_sec += 1;
+                pthread_cond_timedwait(&(psearch_list->pl_cvar),
+                                       &(psearch_list->pl_cvarlock),
+                                       &current_time);
+            }
+            continue;
+        }
+        psearch_list->pl_ready_head = ps->ps_ready_next;
+        if (NULL == psearch_list->pl_ready_head) {
+            psearch_list->pl_ready_tail = NULL;
+        }
+        ps->ps_ready_next = NULL;
+        ps->ps_busy = 1;
+        ps->ps_rerun = 0;
 
-    /* need to acquire a reference to this connection so that it will not
-       be released or cleaned up out from under us */
-    pthread_mutex_lock(&(pb_conn->c_mutex));
-    conn_acq_flag = connection_acquire_nolock(pb_conn);
-    pthread_mutex_unlock(&(pb_conn->c_mutex));
+        /*
+         * Send the results.  Since send_ldap_search_entry can block for
+         * up to 30 minutes, we relinquish all locks before calling it.
+         */
+        pthread_mutex_unlock(&(psearch_list->pl_cvarlock));
+        ended = ps_serve(ps);
+        if (ended) {
+            /* no one else can reach it anymore */
+            ps_end(ps);
+        }
+        pthread_mutex_lock(&(psearch_list->pl_cvarlock));
+
+        if (!ended) {
+            int more;
 
-    if (conn_acq_flag) {
-        slapi_log_err(SLAPI_LOG_CONNS, "ps_send_results",
-                      "conn=%" PRIu64 " op=%d Could not acquire the connection - psearch aborted\n",
-                      pb_conn->c_connid, pb_op ? pb_op->o_opid : -1);
+            PR_Lock(ps->ps_lock);
+            more = (ps->ps_eq_head != NULL);
+            PR_Unlock(ps->ps_lock);
+            ps->ps_busy = 0;
+            ps->ps_scheduled = 0;
+            if (more || ps->ps_rerun) {
+                ps_schedule_nolock(ps);
+            }
+        }
     }
+    /* let the other senders notice they can stop too */
+    pthread_cond_broadcast(&(psearch_list->pl_cvar));
+    pthread_mutex_unlock(&(psearch_list->pl_cvarlock));
 
-    pthread_mutex_lock(&(psearch_list->pl_cvarlock));
+    g_decr_active_threadcnt();
+}
+
+/*
+ * Send up to PS_SEND_BATCH queued changes to the client of a persistent
+ * search. Returns 1 if the persistent search is over: it has been removed
+ * from the list and from its group, the caller must call ps_end().
+ */
+static int
+ps_serve(PSearch *ps)
+{
+    PSEQNode *peq;
+    Connection *pb_conn = NULL;
+    Operation *pb_op = NULL;
+    int sent = 0;
 
-    while ((conn_acq_flag == 0) && slapi_atomic_load_64(&(ps->ps_complete), __ATOMIC_ACQUIRE) == 0) {
+    slapi_pblock_get(ps->ps_pblock, SLAPI_CONNECTION, &pb_conn);
+    slapi_pblock_get(ps->ps_pblock, SLAPI_OPERATION, &pb_op);
+
+    while (sent < PS_SEND_BATCH) {
+        int attrsonly;
+        char **attrs;
+        LDAPControl *ectrls[2] = {NULL, NULL};
+        PSGroupChange *pgc;
+        Slapi_Entry *ec;
+        Slapi_Filter *f = NULL;
+
+        if (slapi_atomic_load_64(&(ps->ps_complete), __ATOMIC_ACQUIRE) != 0) {
+            break;
+        }
         /* Check for an abandoned operation */
         if (pb_op == NULL || slapi_op_abandoned(ps->ps_pblock)) {
-            slapi_log_err(SLAPI_LOG_CONNS, "ps_send_results",
+            slapi_log_err(SLAPI_LOG_CONNS, "ps_serve",
                           "conn=%" PRIu64 " op=%d The operation has been abandoned\n",
                           pb_conn->c_connid, pb_op ? pb_op->o_opid : -1);
             break;
         }
-        if (NULL == ps->ps_eq_head) {
-            /* Nothing to do */
-            pthread_cond_wait(&(psearch_list->pl_cvar), &(psearch_list->pl_cvarlock));
-        } else {
-            /* dequeue the item */
-            int attrsonly;
-            char **attrs;
-            LDAPControl **ectrls;
-            Slapi_Entry *ec;
-            Slapi_Filter *f = NULL;
 
-            PR_Lock(ps->ps_lock);
-
-            peq = ps->ps_eq_head;
+        /* dequeue the item */
+        PR_Lock(ps->ps_lock);
+        peq = ps->ps_eq_head;
+        if (peq) {
             ps->ps_eq_head = peq->pe_next;
             if (NULL == ps->ps_eq_head) {
                 ps->ps_eq_tail = NULL;
             }
+        }
+        PR_Unlock(ps->ps_lock);
+        if (NULL == peq) {
+            return 0;
+        }
 
-            PR_Unlock(ps->ps_lock);
-
-            /* Get all the information we need to send the result */
-            ec = peq->pe_entry;
-            slapi_pblock_get(ps->ps_pblock, SLAPI_SEARCH_ATTRS, &attrs);
-            slapi_pblock_get(ps->ps_pblock, SLAPI_SEARCH_ATTRSONLY, &attrsonly);
-            if (!ps->ps_send_entchg_controls || peq->pe_ctrls[0] == NULL) {
-                ectrls = NULL;
-            } else {
-                ectrls = peq->pe_ctrls;
-            }
-
-            /*
-             * Send the result.  Since send_ldap_search_entry can block for
-             * up to 30 minutes, we relinquish all locks before calling it.
-             */
-            pthread_mutex_unlock(&(psearch_list->pl_cvarlock));
+        /* Get all the information we need to send the result */
+        pgc = peq->pe_change;
+        ec = pgc->pg_change->pc_entry;
+        slapi_pblock_get(ps->ps_pblock, SLAPI_SEARCH_ATTRS, &attrs);
+        slapi_pblock_get(ps->ps_pblock, SLAPI_SEARCH_ATTRSONLY, &attrsonly);
+        if (ps->ps_send_entchg_controls) {
+            ectrls[0] = pgc->pg_change->pc_ctrl;
+        }
 
-            /*
-             * The entry is in the right scope and matches the filter
-             * but we need to redo the filter test here to check access
-             * controls. See the comments at the slapi_filter_test()
-             * call in ps_service_persistent_searches().
-            */
+        /*
+         * The entry is in the right scope and matches the filter
+         * but we need to redo the filter test here to check access
+         * controls. See the comments at the slapi_filter_test()
+         * call in ps_service_persistent_searches().
+         * The members of a group share the identity, so the
+         * result is computed once for the group.
+         */
+        if (slapi_atomic_load_32(&(pgc->pg_access), __ATOMIC_ACQUIRE) == PS_ACCESS_UNKNOWN) {
             slapi_pblock_get(ps->ps_pblock, SLAPI_SEARCH_FILTER, &f);
+            slapi_atomic_store_32(&(pgc->pg_access),
+                                  (slapi_vattr_filter_test(ps->ps_pblock, ec, f, 1 /* verify_access */) == 0) ?
+                                  PS_ACCESS_ALLOWED : PS_ACCESS_DENIED,
+                                  __ATOMIC_RELEASE);
+        }
 
-            /* See if the entry meets the filter and ACL criteria */
-            if (slapi_vattr_filter_test(ps->ps_pblock, ec, f,
-                                        1 /* verify_access */) == 0) {
-                int rc = 0;
-                slapi_pblock_set(ps->ps_pblock, SLAPI_SEARCH_RESULT_ENTRY, ec);
-                rc = send_ldap_search_entry(ps->ps_pblock, ec,
-                                            ectrls, attrs, attrsonly);
-                if (rc) {
-                    slapi_log_err(SLAPI_LOG_CONNS, "ps_send_results",
-                                  "conn=%" PRIu64 " op=%d Error %d sending entry %s with op status %d\n",
-                                  pb_conn->c_connid, pb_op ? pb_op->o_opid: -1,
-                                  rc, slapi_entry_get_dn_const(ec), pb_op ? pb_op->o_status : -1);
-                }
+        /* See if the entry meets the filter and ACL criteria */
+        if (slapi_atomic_load_32(&(pgc->pg_access), __ATOMIC_ACQUIRE) == PS_ACCESS_ALLOWED) {
+            int rc = 0;
+            slapi_pblock_set(ps->ps_pblock, SLAPI_SEARCH_RESULT_ENTRY, ec);
+            rc = send_ldap_search_entry(ps->ps_pblock, ec,
+                                        ectrls[0] ? ectrls : NULL, attrs, attrsonly);
+            if (rc) {
+                slapi_log_err(SLAPI_LOG_CONNS, "ps_serve",
+                              "conn=%" PRIu64 " op=%d Error %d sending entry %s with op status %d\n",
+                              pb_conn->c_connid, pb_op ? pb_op->o_opid: -1,
+                              rc, slapi_entry_get_dn_const(ec), pb_op ? pb_op->o_status : -1);
             }
-
-            pthread_mutex_lock(&(psearch_list->pl_cvarlock));
-
-            /* Deallocate our wrapper for this entry */
-            pe_ch_free(&peq);
         }
+
+        /* Deallocate our wrapper for this entry */
+        pe_ch_free(&peq);
+        sent++;
     }
-    pthread_mutex_unlock(&(psearch_list->pl_cvarlock));
+    if (sent == PS_SEND_BATCH) {
+        /* give the other clients a chance */
+        return 0;
+    }
+
+    /* complete or abandoned */
     ps_remove(ps);
+    return 1;
+}
+
+/*
+ * Terminate a persistent search removed from the list and free it.
+ */
+static void
+ps_end(PSearch *ps)
+{
+    PSEQNode *peq, *peqnext;
+    struct slapi_filter *filter = 0;
+    char *base = NULL;
+    Slapi_DN *sdn = NULL;
+    char *fstr = NULL;
+    char **pbattrs = NULL;
+    Slapi_Connection *conn = NULL;
+    Connection *pb_conn = NULL;
+    Operation *pb_op = NULL;
+
+    slapi_pblock_get(ps->ps_pblock, SLAPI_CONNECTION, &pb_conn);
+    slapi_pblock_get(ps->ps_pblock, SLAPI_OPERATION, &pb_op);
 
     /* indicate the end of search */
     plugin_call_plugins(ps->ps_pblock, SLAPI_PLUGIN_POST_SEARCH_FN);
@@ -409,14 +745,14 @@ ps_send_results(void *arg)
     /* Clean up the connection structure */
     pthread_mutex_lock(&(conn->c_mutex));
 
-    slapi_log_err(SLAPI_LOG_CONNS, "ps_send_results",
+    slapi_log_err(SLAPI_LOG_CONNS, "ps_end",
                   "conn=%" PRIu64 " op=%d Releasing the connection and operation\n",
                   conn->c_connid, pb_op ? pb_op->o_opid : -1);
     /* Delete this op from the connection's list */
     connection_remove_operation_ext(ps->ps_pblock, conn, pb_op);
 
     /* Decrement the connection refcnt */
-    if (conn_acq_flag == 0) { /* we acquired it, so release it */
+    if (ps->ps_conn_acq_flag == 0) { /* we acquired it, so release it */
         connection_release_nolock(conn);
     }
     pthread_mutex_unlock(&(conn->c_mutex));
@@ -431,7 +767,6 @@ ps_send_results(void *arg)
         pe_ch_free(&peq);
     }
     slapi_ch_free((void **)&ps);
-    g_decr_active_threadcnt();
 }
 
 
@@ -462,31 +797,73 @@ psearch_alloc(void)
 
 /*
  * Add the given persistent search to the
- * head of the list of persistent searches.
+ * head of the list of persistent searches,
+ * and to the group of the identical ones.
  */
 static void
 ps_add_ps(PSearch *ps)
 {
     if (PS_IS_INITIALIZED() && NULL != ps) {
+        char *key = ps_group_key(ps->ps_pblock, ps->ps_changetypes, ps->ps_send_entchg_controls);
+        PSearch_Group *pg;
+
         PSL_LOCK_WRITE();
         ps->ps_next = psearch_list->pl_head;
         psearch_list->pl_head = ps;
+
+        for (pg = psearch_list->pl_groups; pg; pg = pg->pg_next) {
+            if (strcmp(pg->pg_key, key) == 0) {
+                break;
+            }
+        }
+        if (pg == NULL) {
+            Slapi_DN *base = NULL;
+            char *origbase = NULL;
+            Slapi_Filter *f = NULL;
+
+            pg = (PSearch_Group *)slapi_ch_calloc(1, sizeof(PSearch_Group));
+            pg->pg_key = key;
+            key = NULL;
+            slapi_pblock_get(ps->ps_pblock, SLAPI_SEARCH_TARGET_SDN, &base);
+            slapi_pblock_get(ps->ps_pblock, SLAPI_ORIGINAL_TARGET_DN, &origbase);
+            slapi_pblock_get(ps->ps_pblock, SLAPI_SEARCH_SCOPE, &(pg->pg_scope));
+            slapi_pblock_get(ps->ps_pblock, SLAPI_SEARCH_FILTER, &f);
+            pg->pg_base = base ? slapi_sdn_dup(base) : slapi_sdn_new_dn_byval(origbase);
+            pg->pg_filter = slapi_filter_dup(f);
+            /* tested against every change */
+            slapi_filter_compile(pg->pg_filter);
+            pg->pg_pblock = ps->ps_pblock;
+            pg->pg_changetypes = ps->ps_changetypes;
+            pg->pg_next = psearch_list->pl_groups;
+            psearch_list->pl_groups = pg;
+        }
+        ps->ps_group = pg;
+        ps->ps_group_next = pg->pg_members;
+        pg->pg_members = ps;
         PSL_UNLOCK_WRITE();
+        slapi_ch_free_string(&key);
     }
 }
 
 
 /*
- * Wake up all threads sleeping on
- * the psearch_list condition variable.
+ * Put all the persistent searches on the ready list, so that the
+ * senders check whether they were abandoned or completed.
  */
 void
 ps_wakeup_all()
 {
     if (PS_IS_INITIALIZED()) {
+        PSearch *ps;
+
+        PSL_LOCK_READ();
         pthread_mutex_lock(&(psearch_list->pl_cvarlock));
+        for (ps = psearch_list->pl_head; NULL != ps; ps = ps->ps_next) {
+            ps_schedule_nolock(ps);
+        }
         pthread_cond_broadcast(&(psearch_list->pl_cvar));
         pthread_mutex_unlock(&(psearch_list->pl_cvarlock));
+        PSL_UNLOCK_READ();
     }
 }
 
@@ -499,6 +876,9 @@ ps_wakeup_all()
  * If so, then enqueue the entry on that persistent search's
  * ps_entryqueue and signal it to wake up and send the entry.
  *
+ * This is done once per group of identical persistent searches,
+ * and the entry and the control are shared by all the queues.
+ *
  * Note that if eprev is NULL we assume that the entry's DN
  * was not changed by the op. that called this function.  If
  * chgnum is 0 it is unknown so we won't ever send it to a
@@ -507,9 +887,8 @@ ps_wakeup_all()
 void
 ps_service_persistent_searches(Slapi_Entry *e, Slapi_Entry *eprev, ber_int_t chgtype, ber_int_t chgnum)
 {
-    LDAPControl *ctrl = NULL;
-    PSearch *ps = NULL;
-    PSEQNode *pe = NULL;
+    PSChange *pc = NULL;
+    PSearch_Group *pg = NULL;
     int matched = 0;
     const char *edn;
 
@@ -527,83 +906,75 @@ ps_service_persistent_searches(Slapi_Entry *e, Slapi_Entry *eprev, ber_int_t chg
     PSL_LOCK_READ();
     edn = slapi_entry_get_dn_const(e);
 
-    for (ps = psearch_list ? psearch_list->pl_head : NULL; NULL != ps; ps = ps->ps_next) {
-        char *origbase = NULL;
-        Slapi_DN *base = NULL;
-        Slapi_Filter *f;
-        int scope;
-        Connection *pb_conn = NULL;
-        Operation *pb_op = NULL;
+    for (pg = psearch_list ? psearch_list->pl_groups : NULL; NULL != pg; pg = pg->pg_next) {
+        PSGroupChange *pgc = NULL;
+        PSearch *ps;
 
-        slapi_pblock_get(ps->ps_pblock, SLAPI_OPERATION, &pb_op);
-        slapi_pblock_get(ps->ps_pblock, SLAPI_CONNECTION, &pb_conn);
-
-        /* Skip the node that doesn't meet the changetype,
-         * or is unable to use the change in ps_send_results()
-         */
-        if ((ps->ps_changetypes & chgtype) == 0 || pb_op == NULL ||
-            slapi_op_abandoned(ps->ps_pblock)) {
+        /* Skip the group that doesn't meet the changetype */
+        if ((pg->pg_changetypes & chgtype) == 0) {
             continue;
         }
 
         slapi_log_err(SLAPI_LOG_CONNS, "ps_service_persistent_searches",
-                      "conn=%" PRIu64 " op=%d entry %s with chgtype %d "
-                      "matches the ps changetype %d\n",
-                      pb_conn ? pb_conn->c_connid : -1,
-                      pb_op->o_opid,
-                      edn, chgtype, ps->ps_changetypes);
-
-        slapi_pblock_get(ps->ps_pblock, SLAPI_SEARCH_FILTER, &f);
-        slapi_pblock_get(ps->ps_pblock, SLAPI_ORIGINAL_TARGET_DN, &origbase);
-        slapi_pblock_get(ps->ps_pblock, SLAPI_SEARCH_TARGET_SDN, &base);
-        slapi_pblock_get(ps->ps_pblock, SLAPI_SEARCH_SCOPE, &scope);
-        if (NULL == base) {
-            base = slapi_sdn_new_dn_byref(origbase);
-            slapi_pblock_set(ps->ps_pblock, SLAPI_SEARCH_TARGET_SDN, base);
-        }
+                      "entry %s with chgtype %d matches the ps changetype %d\n",
+                      edn, chgtype, pg->pg_changetypes);
 
         /*
          * See if the entry meets the scope and filter criteria.
          * We cannot do the acl check here as this thread
-         * would then potentially clash with the ps_send_results()
-         * thread on the aclpb in ps->ps_pblock.
+         * would then potentially clash with the sender thread
+         * on the aclpb in ps->ps_pblock.
          * By avoiding the acl check in this thread, and leaving all the acl
-         * checking to the ps_send_results() thread we avoid
+         * checking to the sender thread we avoid
          * the ps_pblock contention problem.
          * The lesson here is "Do not give multiple threads arbitary access
          * to the same pblock" this kind of muti-threaded access
          * to the same pblock must be done carefully--there is currently no
          * generic satisfactory way to do this.
         */
-        if (slapi_sdn_scope_test(slapi_entry_get_sdn_const(e), base, scope) &&
-            slapi_vattr_filter_test(ps->ps_pblock, e, f, 0 /* verify_access */) == 0) {
-            PSEQNode *pOldtail;
+        if (!slapi_sdn_scope_test(slapi_entry_get_sdn_const(e), pg->pg_base, pg->pg_scope) ||
+            slapi_vattr_filter_test(pg->pg_pblock, e, pg->pg_filter, 0 /* verify_access */) != 0) {
+            continue;
+        }
 
-            /* The scope and the filter match - enqueue it */
+        /* The scope and the filter match - enqueue it */
+        if (pc == NULL) {
+            pc = (PSChange *)slapi_ch_calloc(1, sizeof(PSChange));
+            pc->pc_entry = slapi_entry_dup(e);
+            pc->pc_refcnt = 1; /* released at the end */
+        }
+        if (pg->pg_members && pg->pg_members->ps_send_entchg_controls && pc->pc_ctrl == NULL) {
+            int rc;
+            rc = create_entrychange_control(chgtype, chgnum,
+                                            eprev ? slapi_entry_get_dn_const(eprev) : NULL,
+                                            &(pc->pc_ctrl));
+            if (rc != LDAP_SUCCESS) {
+                slapi_log_err(SLAPI_LOG_ERR, "ps_service_persistent_searches",
+                              "Unable to create EntryChangeNotification control for"
+                              " entry \"%s\" -- control won't be sent.\n",
+                              slapi_entry_get_dn_const(e));
+            }
+        }
+        pgc = (PSGroupChange *)slapi_ch_calloc(1, sizeof(PSGroupChange));
+        pgc->pg_change = pc;
+        pgc->pg_access = PS_ACCESS_UNKNOWN;
+        pgc->pg_refcnt = 1; /* released after the members loop */
+        slapi_atomic_incr_64(&(pc->pc_refcnt), __ATOMIC_RELAXED);
+
+        for (ps = pg->pg_members; ps; ps = ps->ps_group_next) {
+            PSEQNode *pe, *pOldtail;
+            Operation *pb_op = NULL;
+
+            /* Skip the node that is unable to use the change */
+            slapi_pblock_get(ps->ps_pblock, SLAPI_OPERATION, &pb_op);
+            if (pb_op == NULL || slapi_op_abandoned(ps->ps_pblock)) {
+                continue;
+            }
 
             matched++;
             pe = (PSEQNode *)slapi_ch_calloc(1, sizeof(PSEQNode));
-            pe->pe_entry = slapi_entry_dup(e);
-            if (ps->ps_send_entchg_controls) {
-                /* create_entrychange_control() is more
-                 * expensive than slapi_dup_control()
-                 */
-                if (ctrl == NULL) {
-                    int rc;
-                    rc = create_entrychange_control(chgtype, chgnum,
-                                                    eprev ? slapi_entry_get_dn_const(eprev) : NULL,
-                                                    &ctrl);
-                    if (rc != LDAP_SUCCESS) {
-                        slapi_log_err(SLAPI_LOG_ERR, "ps_service_persistent_searches",
-                                      "Unable to create EntryChangeNotification control for"
-                                      " entry \"%s\" -- control won't be sent.\n",
-                                      slapi_entry_get_dn_const(e));
-                    }
-                }
-                if (ctrl) {
-                    pe->pe_ctrls[0] = slapi_dup_control(ctrl);
-                }
-            }
+            pe->pe_change = pgc;
+            slapi_atomic_incr_64(&(pgc->pg_refcnt), __ATOMIC_RELAXED);
 
             /* Put it on the end of the list for this pers search */
             PR_Lock(ps->ps_lock);
@@ -616,15 +987,24 @@ ps_service_persistent_searches(Slapi_Entry *e, Slapi_Entry *eprev, ber_int_t chg
             }
             PR_Unlock(ps->ps_lock);
         }
+
+        /* Turn 'em loose */
+        pthread_mutex_lock(&(psearch_list->pl_cvarlock));
+        for (ps = pg->pg_members; ps; ps = ps->ps_group_next) {
+            if (ps->ps_eq_head) {
+                ps_schedule_nolock(ps);
+            }
+        }
+        pthread_mutex_unlock(&(psearch_list->pl_cvarlock));
+        ps_group_change_release(&pgc);
     }
 
     PSL_UNLOCK_READ();
 
+    ps_change_release(&pc);
+
     /* Were there any matches? */
     if (matched) {
-        ldap_control_free(ctrl);
-        /* Turn 'em loose */
-        ps_wakeup_all();
         slapi_log_err(SLAPI_LOG_TRACE, "ps_service_persistent_searches", "Enqueued entry "
                       "\"%s\" on %d persistent search lists\n",
                       slapi_entry_get_dn_const(e), matched);
@@ -662,6 +662,9 @@ update_pw_info(Slapi_PBlock *pb, char *old_pw)
         return -1;
     }
 
+    /* the password changed, a cached check of the old one must not be used */
+    slapi_pw_verify_cache_invalidate(sdn);
+
     /* If we have been requested to skip updating this data, check now */
     if (slapi_operation_is_flag_set(operation, OP_FLAG_ACTION_SKIP_PWDPOLICY)) {
         /* No action required! */
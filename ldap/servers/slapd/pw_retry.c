@@ -24,6 +24,7 @@
 static int set_retry_cnt(Slapi_PBlock *pb, int count);
 static int set_retry_cnt_and_time(Slapi_PBlock *pb, int count, time_t cur_time);
 static int set_tpr_usecount(Slapi_PBlock *pb, int count);
+static void pw_apply_retry_mods(const Slapi_DN *sdn, Slapi_Mods *mods, int locking);
 
 /*
  * update_pw_retry() is called when bind operation fails with
@@ -151,7 +152,7 @@ set_retry_cnt_and_time(Slapi_PBlock *pb, int count, time_t cur_time)
 
     rc = set_retry_cnt_mods(pb, &smods, count);
 
-    pw_apply_mods(sdn, &smods);
+    pw_apply_retry_mods(sdn, &smods, rc == LDAP_CONSTRAINT_VIOLATION);
     slapi_mods_done(&smods);
 
     return rc;
@@ -239,6 +240,7 @@ set_retry_cnt_mods(Slapi_PBlock *pb, Slapi_Mods *smods, int count)
             timestr = format_genTime(unlock_time);
             slapi_mods_add_string(smods, LDAP_MOD_REPLACE, "accountUnlockTime", timestr);
             slapi_ch_free((void **)&timestr);
+            slapi_pw_verify_cache_invalidate(sdn);
             rc = LDAP_CONSTRAINT_VIOLATION;
         }
     }
@@ -255,7 +257,7 @@ set_retry_cnt(Slapi_PBlock *pb, int count)
     slapi_pblock_get(pb, SLAPI_TARGET_SDN, &sdn);
     slapi_mods_init(&smods, 0);
     rc = set_retry_cnt_mods(pb, &smods, count);
-    pw_apply_mods(sdn, &smods);
+    pw_apply_retry_mods(sdn, &smods, rc == LDAP_CONSTRAINT_VIOLATION);
     slapi_mods_done(&smods);
     return rc;
 }
@@ -357,6 +359,29 @@ pw_apply_mods(const Slapi_DN *sdn, Slapi_Mods *mods)
     return;
 }
 
+/*
+ * The retry counters are written on each failed bind: they may go through
+ * the write-behind buffer, get_entry() sees the buffered values. The mods
+ * locking the account are always applied right away.
+ */
+static void
+pw_apply_retry_mods(const Slapi_DN *sdn, Slapi_Mods *mods, int locking)
+{
+    int res;
+
+    if (locking) {
+        pw_apply_mods(sdn, mods);
+    } else if (mods && (slapi_mods_get_num_mods(mods) > 0)) {
+        res = slapi_writebehind_modify(sdn, slapi_mods_get_ldapmods_byref(mods),
+                                       pw_get_componentID(), OP_FLAG_SKIP_MODIFIED_ATTRS);
+        if (res != LDAP_SUCCESS) {
+            slapi_log_err(SLAPI_LOG_WARNING,
+                          "pw_apply_retry_mods", "Modify error %d on entry '%s'\n",
+                          res, slapi_sdn_get_dn(sdn));
+        }
+    }
+}
+
 /* Handle the component ID for the password policy */
 
 static struct slapi_componentid *pw_componentid = NULL;
@@ -0,0 +1,455 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * pw_verify_cache.c - cache of the successful simple bind password checks
+ *
+ * The password storage schemes are deliberately slow. Accounts binding over
+ * and over with the same password pay for it each time. When
+ * nsslapd-pwverify-cache is on, a successful check is remembered as
+ * (bind dn, digest of the password, digest of the stored password values)
+ * for nsslapd-pwverify-cache-ttl seconds. The next bind with the same
+ * password is accepted on a digest comparison, as long as the stored values
+ * did not change. The digests are SHA-256, salted with a random value drawn
+ * at startup, and are only kept in memory.
+ *
+ * Failed checks are never cached. The checks that miss the cache run on a
+ * pool of nsslapd-pwverify-threads threads, so that at most that many cores
+ * are busy hashing passwords while the worker threads serve the searches.
+ *
+ * The cache is bounded to nsslapd-pwverify-cache-size entries, the least
+ * recently used ones are evicted first. The entry of a dn is dropped when
+ * its password is changed or the account gets locked.
+ */
+
+#include "slap.h"
+#include <pk11func.h>
+#include "sechash.h"
+
+#define PWVC_DIGEST_LEN 32 /* SHA-256 */
+#define PWVC_SALT_LEN 16
+
+typedef struct pwvc_entry
+{
+    char *pe_ndn;
+    unsigned char pe_cred[PWVC_DIGEST_LEN];   /* digest of the password */
+    unsigned char pe_stored[PWVC_DIGEST_LEN]; /* digest of the stored values */
+    time_t pe_expire;
+    struct pwvc_entry *pe_prev; /* toward the most recently used */
+    struct pwvc_entry *pe_next; /* toward the least recently used */
+} pwvc_entry;
+
+typedef struct pwvc_job
+{
+    Slapi_Value **pj_vals;
+    const Slapi_Value *pj_cred;
+    int pj_result;
+    int pj_done;
+    pthread_cond_t pj_cv;
+    struct pwvc_job *pj_next;
+} pwvc_job;
+
+static struct
+{
+    pthread_mutex_t pc_lock;
+    PLHashTable *pc_table; /* ndn -> pwvc_entry */
+    pwvc_entry *pc_head;   /* most recently used */
+    pwvc_entry *pc_tail;   /* least recently used */
+    int32_t pc_count;
+    unsigned char pc_salt[PWVC_SALT_LEN];
+    int pc_salted;
+} pw_cache = {PTHREAD_MUTEX_INITIALIZER, NULL, NULL, NULL, 0, {0}, 0};
+
+static struct
+{
+    pthread_mutex_t pp_lock;
+    pthread_cond_t pp_cv; /* the threads wait on it for jobs */
+    pwvc_job *pp_head;
+    pwvc_job *pp_tail;
+    PRThread **pp_threads;
+    int pp_nthreads;
+    int pp_started;
+    int pp_stopping;
+} pw_pool = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, NULL, NULL, 0, 0, 0};
+
+/*
+ * Digests
+ */
+
+static PK11Context *
+pwvc_digest_begin(void)
+{
+    PK11Context *ctx = PK11_CreateDigestContext(SEC_OID_SHA256);
+
+    if (ctx == NULL) {
+        return NULL;
+    }
+    if (PK11_DigestBegin(ctx) != SECSuccess ||
+        PK11_DigestOp(ctx, pw_cache.pc_salt, PWVC_SALT_LEN) != SECSuccess) {
+        PK11_DestroyContext(ctx, PR_TRUE);
+        return NULL;
+    }
+    return ctx;
+}
+
+static int
+pwvc_digest_end(PK11Context *ctx, unsigned char *digest)
+{
+    unsigned int len = 0;
+    int rc = PK11_DigestFinal(ctx, digest, &len, PWVC_DIGEST_LEN);
+
+    PK11_DestroyContext(ctx, PR_TRUE);
+    return (rc == SECSuccess && len == PWVC_DIGEST_LEN) ? 0 : -1;
+}
+
+static int
+pwvc_digest_cred(const Slapi_Value *cred, unsigned char *digest)
+{
+    const struct berval *bv = slapi_value_get_berval(cred);
+    PK11Context *ctx = pwvc_digest_begin();
+
+    if (ctx == NULL) {
+        return -1;
+    }
+    if (bv->bv_len && PK11_DigestOp(ctx, (unsigned char *)bv->bv_val, bv->bv_len) != SECSuccess) {
+        PK11_DestroyContext(ctx, PR_TRUE);
+        return -1;
+    }
+    return pwvc_digest_end(ctx, digest);
+}
+
+/* The values are length prefixed, so that their boundaries are hashed too */
+static int
+pwvc_digest_stored(Slapi_Value **vals, unsigned char *digest)
+{
+    PK11Context *ctx = pwvc_digest_begin();
+
+    if (ctx == NULL) {
+        return -1;
+    }
+    for (size_t i = 0; vals && vals[i]; i++) {
+        const struct berval *bv = slapi_value_get_berval(vals[i]);
+        uint32_t len = htonl((uint32_t)bv->bv_len);
+
+        if (PK11_DigestOp(ctx, (unsigned char *)&len, sizeof(len)) != SECSuccess ||
+            (bv->bv_len && PK11_DigestOp(ctx, (unsigned char *)bv->bv_val, bv->bv_len) != SECSuccess)) {
+            PK11_DestroyContext(ctx, PR_TRUE);
+            return -1;
+        }
+    }
+    return pwvc_digest_end(ctx, digest);
+}
+
+/*
+ * Cache, the list and _nolock functions are called with pc_lock held
+ */
+
+static void
+pwvc_unlink(pwvc_entry *pe)
+{
+    if (pe->pe_prev) {
+        pe->pe_prev->pe_next = pe->pe_next;
+    } else {
+        pw_cache.pc_head = pe->pe_next;
+    }
+    if (pe->pe_next) {
+        pe->pe_next->pe_prev = pe->pe_prev;
+    } else {
+        pw_cache.pc_tail = pe->pe_prev;
+    }
+    pe->pe_prev = pe->pe_next = NULL;
+}
+
+static void
+pwvc_link_head(pwvc_entry *pe)
+{
+    pe->pe_prev = NULL;
+    pe->pe_next = pw_cache.pc_head;
+    if (pw_cache.pc_head) {
+        pw_cache.pc_head->pe_prev = pe;
+    } else {
+        pw_cache.pc_tail = pe;
+    }
+    pw_cache.pc_head = pe;
+}
+
+static void
+pwvc_remove_nolock(pwvc_entry *pe)
+{
+    PL_HashTableRemove(pw_cache.pc_table, pe->pe_ndn);
+    pwvc_unlink(pe);
+    slapi_atomic_decr_32(&pw_cache.pc_count, __ATOMIC_RELEASE);
+    /* do not leave the digests around in freed memory */
+    memset(pe->pe_cred, 0, PWVC_DIGEST_LEN);
+    memset(pe->pe_stored, 0, PWVC_DIGEST_LEN);
+    slapi_ch_free_string(&pe->pe_ndn);
+    slapi_ch_free((void **)&pe);
+}
+
+static void
+pwvc_purge_nolock(void)
+{
+    while (pw_cache.pc_head) {
+        pwvc_remove_nolock(pw_cache.pc_head);
+    }
+}
+
+static int
+pwvc_init_nolock(void)
+{
+    if (pw_cache.pc_table) {
+        return 0;
+    }
+    if (!pw_cache.pc_salted) {
+        slapi_rand_array(pw_cache.pc_salt, PWVC_SALT_LEN);
+        pw_cache.pc_salted = 1;
+    }
+    pw_cache.pc_table = PL_NewHashTable(64, PL_HashString, PL_CompareStrings,
+                                        PL_CompareValues, NULL, NULL);
+    return pw_cache.pc_table ? 0 : -1;
+}
+
+static int
+pwvc_lookup(const char *ndn, const unsigned char *cred, const unsigned char *stored)
+{
+    pwvc_entry *pe;
+    int found = 0;
+
+    pthread_mutex_lock(&pw_cache.pc_lock);
+    if (pw_cache.pc_table &&
+        (pe = (pwvc_entry *)PL_HashTableLookup(pw_cache.pc_table, ndn)) != NULL) {
+        if (pe->pe_expire <= slapi_current_rel_time_t()) {
+            pwvc_remove_nolock(pe);
+        } else if ((slapi_ct_memcmp(pe->pe_cred, cred, PWVC_DIGEST_LEN) |
+                    slapi_ct_memcmp(pe->pe_stored, stored, PWVC_DIGEST_LEN)) == 0) {
+            pwvc_unlink(pe);
+            pwvc_link_head(pe);
+            found = 1;
+        }
+    }
+    pthread_mutex_unlock(&pw_cache.pc_lock);
+    return found;
+}
+
+static void
+pwvc_add(const char *ndn, const unsigned char *cred, const unsigned char *stored)
+{
+    int32_t max = config_get_pw_verify_cache_size();
+    pwvc_entry *pe;
+
+    pthread_mutex_lock(&pw_cache.pc_lock);
+    if (pwvc_init_nolock()) {
+        pthread_mutex_unlock(&pw_cache.pc_lock);
+        return;
+    }
+    pe = (pwvc_entry *)PL_HashTableLookup(pw_cache.pc_table, ndn);
+    if (pe) {
+        pwvc_unlink(pe);
+    } else {
+        while (pw_cache.pc_count >= max && pw_cache.pc_tail) {
+            pwvc_remove_nolock(pw_cache.pc_tail);
+        }
+        pe = (pwvc_entry *)slapi_ch_calloc(1, sizeof(pwvc_entry));
+        pe->pe_ndn = slapi_ch_strdup(ndn);
+        PL_HashTableAdd(pw_cache.pc_table, pe->pe_ndn, pe);
+        slapi_atomic_incr_32(&pw_cache.pc_count, __ATOMIC_RELEASE);
+    }
+    memcpy(pe->pe_cred, cred, PWVC_DIGEST_LEN);
+    memcpy(pe->pe_stored, stored, PWVC_DIGEST_LEN);
+    pe->pe_expire = slapi_current_rel_time_t() + config_get_pw_verify_cache_ttl();
+    pwvc_link_head(pe);
+    pthread_mutex_unlock(&pw_cache.pc_lock);
+}
+
+/*
+ * Hashing pool
+ */
+
+static void
+pw_verify_thread(void *arg __attribute__((unused)))
+{
+    slapi_set_thread_name("pw-verify");
+
+    pthread_mutex_lock(&pw_pool.pp_lock);
+    while (1) {
+        pwvc_job *job = pw_pool.pp_head;
+
+        if (job == NULL) {
+            if (pw_pool.pp_stopping) {
+                break;
+            }
+            pthread_cond_wait(&pw_pool.pp_cv, &pw_pool.pp_lock);
+            continue;
+        }
+        pw_pool.pp_head = job->pj_next;
+        if (pw_pool.pp_head == NULL) {
+            pw_pool.pp_tail = NULL;
+        }
+        pthread_mutex_unlock(&pw_pool.pp_lock);
+
+        job->pj_result = slapi_pw_find_sv(job->pj_vals, job->pj_cred);
+
+        pthread_mutex_lock(&pw_pool.pp_lock);
+        job->pj_done = 1;
+        pthread_cond_signal(&job->pj_cv);
+    }
+    pthread_mutex_unlock(&pw_pool.pp_lock);
+}
+
+/* Called with pp_lock held */
+static void
+pw_verify_start_threads_nolock(void)
+{
+    int nthreads = config_get_pw_verify_threads();
+
+    pw_pool.pp_started = 1;
+    if (nthreads <= 0) {
+        return;
+    }
+    pw_pool.pp_threads = (PRThread **)slapi_ch_calloc(nthreads, sizeof(PRThread *));
+    for (int i = 0; i < nthreads; i++) {
+        PRThread *tid = PR_CreateThread(PR_USER_THREAD, pw_verify_thread, NULL,
+                                        PR_PRIORITY_NORMAL, PR_GLOBAL_THREAD,
+                                        PR_JOINABLE_THREAD, SLAPD_DEFAULT_THREAD_STACKSIZE);
+        if (NULL == tid) {
+            int prerr = PR_GetError();
+            slapi_log_err(SLAPI_LOG_ERR, "pw_verify_start_threads", "PR_CreateThread() failed: "
+                          SLAPI_COMPONENT_NAME_NSPR " error %d (%s)\n",
+                          prerr, slapd_pr_strerror(prerr));
+            break;
+        }
+        pw_pool.pp_threads[pw_pool.pp_nthreads++] = tid;
+    }
+    slapi_log_err(SLAPI_LOG_INFO, "pw_verify_start_threads",
+                  "Started %d password verification threads\n", pw_pool.pp_nthreads);
+}
+
+/* Check the password on a pool thread, or on this one if there is no pool */
+static int
+pw_verify_in_pool(Slapi_Value **vals, const Slapi_Value *cred)
+{
+    pwvc_job job = {0};
+
+    pthread_mutex_lock(&pw_pool.pp_lock);
+    if (!pw_pool.pp_started && !pw_pool.pp_stopping) {
+        pw_verify_start_threads_nolock();
+    }
+    if (pw_pool.pp_nthreads == 0 || pw_pool.pp_stopping) {
+        pthread_mutex_unlock(&pw_pool.pp_lock);
+        return slapi_pw_find_sv(vals, cred);
+    }
+    job.pj_vals = vals;
+    job.pj_cred = cred;
+    pthread_cond_init(&job.pj_cv, NULL);
+    if (pw_pool.pp_tail) {
+        pw_pool.pp_tail->pj_next = &job;
+    } else {
+        pw_pool.pp_head = &job;
+    }
+    pw_pool.pp_tail = &job;
+    pthread_cond_signal(&pw_pool.pp_cv);
+    while (!job.pj_done) {
+        pthread_cond_wait(&job.pj_cv, &pw_pool.pp_lock);
+    }
+    pthread_mutex_unlock(&pw_pool.pp_lock);
+    pthread_cond_destroy(&job.pj_cv);
+
+    return job.pj_result;
+}
+
+/*
+ * Called at shutdown once the worker threads are gone: let the pool
+ * threads finish the queued checks and exit, and drop the cache.
+ */
+void
+pw_verify_cache_stop(void)
+{
+    pthread_mutex_lock(&pw_pool.pp_lock);
+    pw_pool.pp_stopping = 1;
+    pthread_cond_broadcast(&pw_pool.pp_cv);
+    pthread_mutex_unlock(&pw_pool.pp_lock);
+
+    for (int i = 0; i < pw_pool.pp_nthreads; i++) {
+        PR_JoinThread(pw_pool.pp_threads[i]);
+    }
+    slapi_ch_free((void **)&pw_pool.pp_threads);
+    pw_pool.pp_nthreads = 0;
+
+    pthread_mutex_lock(&pw_cache.pc_lock);
+    pwvc_purge_nolock();
+    if (pw_cache.pc_table) {
+        PL_HashTableDestroy(pw_cache.pc_table);
+        pw_cache.pc_table = NULL;
+    }
+    pthread_mutex_unlock(&pw_cache.pc_lock);
+}
+
+/*
+ * Like slapi_pw_find_sv, for the password of the entry sdn: returns 0 if
+ * cred matches one of the stored values vals, non-zero otherwise.
+ */
+int
+slapi_pw_verify_cached(const Slapi_DN *sdn, Slapi_Value **vals, const Slapi_Value *cred)
+{
+    unsigned char cred_digest[PWVC_DIGEST_LEN];
+    unsigned char stored_digest[PWVC_DIGEST_LEN];
+    const char *ndn = slapi_sdn_get_ndn(sdn);
+    int rc;
+
+    if (!config_get_pw_verify_cache() || ndn == NULL) {
+        if (slapi_atomic_load_32(&pw_cache.pc_count, __ATOMIC_ACQUIRE)) {
+            /* the cache was turned off, forget what it holds */
+            pthread_mutex_lock(&pw_cache.pc_lock);
+            pwvc_purge_nolock();
+            pthread_mutex_unlock(&pw_cache.pc_lock);
+        }
+        return slapi_pw_find_sv(vals, cred);
+    }
+
+    pthread_mutex_lock(&pw_cache.pc_lock);
+    rc = pwvc_init_nolock();
+    pthread_mutex_unlock(&pw_cache.pc_lock);
+    if (rc || pwvc_digest_cred(cred, cred_digest) || pwvc_digest_stored(vals, stored_digest)) {
+        return pw_verify_in_pool(vals, cred);
+    }
+
+    if (pwvc_lookup(ndn, cred_digest, stored_digest)) {
+        slapi_log_err(SLAPI_LOG_TRACE, "slapi_pw_verify_cached", "Cached password check for %s\n", ndn);
+        rc = 0;
+    } else {
+        rc = pw_verify_in_pool(vals, cred);
+        if (rc == 0) {
+            pwvc_add(ndn, cred_digest, stored_digest);
+        }
+    }
+    memset(cred_digest, 0, sizeof(cred_digest));
+    memset(stored_digest, 0, sizeof(stored_digest));
+    return rc;
+}
+
+/* Forget the password check of sdn: its password changed, or it is locked */
+void
+slapi_pw_verify_cache_invalidate(const Slapi_DN *sdn)
+{
+    const char *ndn = slapi_sdn_get_ndn(sdn);
+    pwvc_entry *pe;
+
+    if (ndn == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&pw_cache.pc_lock);
+    if (pw_cache.pc_table &&
+        (pe = (pwvc_entry *)PL_HashTableLookup(pw_cache.pc_table, ndn)) != NULL) {
+        pwvc_remove_nolock(pe);
+    }
+    pthread_mutex_unlock(&pw_cache.pc_lock);
+}
@@ -568,7 +568,7 @@ send_ldap_result_ext(
     }
 
     internal_op = operation_is_flag_set(operation, OP_FLAG_INTERNAL);
-    if ((conn == NULL) || (internal_op)) {
+    if ((conn == NULL) || (internal_op) || operation_is_flag_set(operation, OP_FLAG_SEARCH_FANOUT)) {
         if (operation->o_result_handler != NULL) {
             operation->o_result_handler(conn, operation, err,
                                         matched, text, nentries, urls);
@@ -1626,6 +1626,7 @@ send_ldap_search_entry_ext(
     Slapi_Entry *gerentry = NULL;
     Slapi_Entry *ecopy = NULL;
     LDAPControl **searchctrlp = NULL;
+    uint64_t encode_start;
 
 
     slapi_pblock_get(pb, SLAPI_CONNECTION, &conn);
@@ -1649,6 +1650,10 @@ send_ldap_search_entry_ext(
     }
 
     slapi_pblock_get(pb, SLAPI_SEARCH_ENTRY_COPY, &ecopy);
+    if (e && writebehind_overlay(e, &ecopy)) {
+        /* the login tracking values not written yet */
+        slapi_pblock_set(pb, SLAPI_SEARCH_ENTRY_COPY, ecopy);
+    }
     if (ecopy) {
         e = ecopy; /* send back the altered entry */
     }
@@ -1684,6 +1689,8 @@ send_ldap_search_entry_ext(
         goto cleanup;
     }
 
+    /* includes the access checks of the attributes */
+    encode_start = latency_stats_now();
     if ((ber = der_alloc()) == NULL) {
         slapi_log_err(SLAPI_LOG_ERR, "send_ldap_search_entry_ext", "ber_alloc failed\n");
         send_ldap_result(pb, LDAP_OPERATIONS_ERROR, NULL,
@@ -1819,6 +1826,7 @@ send_ldap_search_entry_ext(
                          "ber_printf entry end", 0, NULL);
         goto cleanup;
     }
+    latency_stats_record(LATENCY_PHASE_ENCODE, encode_start);
 
     if (send_result) {
         send_ldap_result_ext(pb, LDAP_SUCCESS, NULL, NULL, nentries, urls, ber);
@@ -1895,6 +1903,7 @@ flush_ber(
     int type)
 {
     ber_len_t bytes;
+    uint64_t flush_start;
     int rc = 0;
 
     switch (type) {
@@ -1925,9 +1934,11 @@ flush_ber(
         ber_get_option(ber, LBER_OPT_BYTES_TO_WRITE, &bytes);
 
         fgot_start(op, FGOT_WRITE);
+        flush_start = latency_stats_now();
         PR_Lock(conn->c_pdumutex);
         rc = ber_flush(conn->c_sb, ber, 1);
         PR_Unlock(conn->c_pdumutex);
+        latency_stats_record(LATENCY_PHASE_FLUSH, flush_start);
         fgot_end(op, FGOT_WRITE);
 
         if (rc != 0) {
@@ -35,18 +35,26 @@
  * So when we have that there is no need for the SASL layer
  * to do any fancy buffering with it, we always hand it
  * a full packet.
+ *
+ * Once the security layer is established, the reads fill the encrypted
+ * buffer: the bytes received after the packet being read are kept for
+ * the next one, so that a stream of small packets does not cost two
+ * reads each. The buffer grows to the largest packet received.
+ *
+ * The decrypted data is not copied: it is returned from the output buffer
+ * of sasl_decode, which stays valid until the next sasl_decode call.
  */
 
     struct PRFilePrivate
 {
-    char *decrypted_buffer;
-    uint32_t decrypted_buffer_size;
+    const char *decrypted_data; /* output of sasl_decode, owned by the sasl library */
     uint32_t decrypted_buffer_count;
     uint32_t decrypted_buffer_offset;
     char *encrypted_buffer;
     uint32_t encrypted_buffer_size;
-    uint32_t encrypted_buffer_count;
-    uint32_t encrypted_buffer_offset;
+    uint32_t encrypted_buffer_count;    /* length of the packet being read, 0 until its length is known */
+    uint32_t encrypted_buffer_offset;   /* bytes received in the buffer */
+    uint32_t encrypted_buffer_consumed; /* bytes of the last decoded packet, dropped before the next one */
     Connection *conn;         /* needed for connid and sasl_conn context */
     PRBool send_encrypted;    /* can only send encrypted data after the first read -
                               that is, we cannot send back an encrypted response
@@ -117,8 +125,6 @@ debug_print_layers(PRFileDesc *fd __attribute__((unused)))
 static void
 sasl_io_init_buffers(sasl_io_private *sp)
 {
-    sp->decrypted_buffer = slapi_ch_malloc(SASL_IO_BUFFER_SIZE);
-    sp->decrypted_buffer_size = SASL_IO_BUFFER_SIZE;
     sp->encrypted_buffer = slapi_ch_malloc(SASL_IO_BUFFER_SIZE);
     sp->encrypted_buffer_size = SASL_IO_BUFFER_SIZE;
 }
@@ -133,13 +139,25 @@ sasl_io_resize_encrypted_buffer(sasl_io_private *sp, uint32_t requested_size)
     }
 }
 
+/*
+ * Drop the last decoded packet, moving what was read after it to the start
+ * of the buffer. This is deferred until its decrypted data is returned:
+ * sasl_decode may hand back a pointer inside the encrypted buffer.
+ */
 static void
-sasl_io_resize_decrypted_buffer(sasl_io_private *sp, uint32_t requested_size)
+sasl_io_compact_encrypted_buffer(sasl_io_private *sp)
 {
-    if (requested_size > sp->decrypted_buffer_size) {
-        sp->decrypted_buffer = slapi_ch_realloc(sp->decrypted_buffer, requested_size);
-        sp->decrypted_buffer_size = requested_size;
+    uint32_t left;
+
+    if (sp->encrypted_buffer_consumed == 0) {
+        return;
     }
+    left = sp->encrypted_buffer_offset - sp->encrypted_buffer_consumed;
+    if (left) {
+        memmove(sp->encrypted_buffer, sp->encrypted_buffer + sp->encrypted_buffer_consumed, left);
+    }
+    sp->encrypted_buffer_offset = left;
+    sp->encrypted_buffer_consumed = 0;
 }
 
 static int
@@ -151,7 +169,22 @@ sasl_io_reading_packet(sasl_io_private *sp)
 static int
 sasl_io_finished_packet(sasl_io_private *sp)
 {
-    return (sp->encrypted_buffer_count && (sp->encrypted_buffer_offset == sp->encrypted_buffer_count));
+    return (sp->encrypted_buffer_count && (sp->encrypted_buffer_offset >= sp->encrypted_buffer_count));
+}
+
+/* Does the buffer hold a complete packet that was not decoded yet ? */
+static int
+sasl_io_has_packet(sasl_io_private *sp)
+{
+    uint32_t avail = sp->encrypted_buffer_offset - sp->encrypted_buffer_consumed;
+    uint32_t packet_length;
+
+    if (!sp->send_encrypted || avail < SASL_IO_BUFFER_START_SIZE) {
+        return 0;
+    }
+    memcpy(&packet_length, sp->encrypted_buffer + sp->encrypted_buffer_consumed, sizeof(packet_length));
+    packet_length = ntohl(packet_length);
+    return packet_length <= avail - sizeof(uint32_t);
 }
 
 static PRInt32
@@ -209,10 +242,9 @@ sasl_get_io_private(PRFileDesc *fd)
 static PRInt32
 sasl_io_start_packet(PRFileDesc *fd, PRIntn flags, PRIntervalTime timeout, PRInt32 *err)
 {
-    unsigned char buffer[SASL_IO_BUFFER_START_SIZE];
     sasl_io_private *sp = sasl_get_io_private(fd);
     Connection *c = sp->conn;
-    int32_t amount = sizeof(buffer);
+    int32_t amount;
     int32_t ret = 0;
     uint32_t packet_length = 0;
     int32_t saslio_limit;
@@ -220,9 +252,14 @@ sasl_io_start_packet(PRFileDesc *fd, PRIntn flags, PRIntervalTime timeout, PRInt
     *err = 0;
     debug_print_layers(fd);
     /* First read enough bytes to distinguish an LDAP message from a SASL packet. */
-    if (sp->encrypted_buffer_offset < sizeof(buffer)) {
-            amount = sizeof(buffer) - sp->encrypted_buffer_offset;
-            ret = PR_Recv(fd->lower, buffer, amount, flags, timeout);
+    if (sp->encrypted_buffer_offset < SASL_IO_BUFFER_START_SIZE) {
+            if (sp->send_encrypted) {
+                /* only packets can come now, read ahead */
+                amount = sp->encrypted_buffer_size - sp->encrypted_buffer_offset;
+            } else {
+                amount = SASL_IO_BUFFER_START_SIZE - sp->encrypted_buffer_offset;
+            }
+            ret = PR_Recv(fd->lower, sp->encrypted_buffer + sp->encrypted_buffer_offset, amount, flags, timeout);
             slapi_log_err(SLAPI_LOG_CONNS, "sasl_io_start_packet",
                           "Read sasl packet length returned %d on connection %" PRIu64 "\n",
                           ret, c->c_connid);
@@ -239,14 +276,10 @@ sasl_io_start_packet(PRFileDesc *fd, PRIntn flags, PRIntervalTime timeout, PRInt
                 }
                 return ret;
         }
-        if ((ret + sp->encrypted_buffer_offset) > sp->encrypted_buffer_size) {
-            sasl_io_resize_encrypted_buffer(sp, ret + sp->encrypted_buffer_offset);
-        }
-        memcpy(sp->encrypted_buffer + sp->encrypted_buffer_offset, buffer, ret);
         sp->encrypted_buffer_offset += ret;
     }
 
-    if (sp->encrypted_buffer_offset < sizeof(buffer)) {
+    if (sp->encrypted_buffer_offset < SASL_IO_BUFFER_START_SIZE) {
         slapi_log_err(SLAPI_LOG_CONNS,
                       "sasl_io_start_packet", "Read only %d bytes of sasl packet "
                                               "length on connection %" PRIu64 "\n",
@@ -321,19 +354,14 @@ sasl_io_start_packet(PRFileDesc *fd, PRIntn flags, PRIntervalTime timeout, PRInt
          */
         while (sp->encrypted_buffer_offset < ber_packet_len) {
             uint32_t bytes_to_read = ber_packet_len - sp->encrypted_buffer_offset;
-            unsigned char mybuf[SASL_IO_BUFFER_SIZE];
-
-            if (bytes_to_read > sizeof(mybuf)) {
-                bytes_to_read = sizeof(mybuf);
-            }
 
-            ret = PR_Recv(fd->lower, mybuf, (PRInt32)bytes_to_read, flags, timeout);
+            ret = PR_Recv(fd->lower, sp->encrypted_buffer + sp->encrypted_buffer_offset,
+                          (PRInt32)bytes_to_read, flags, timeout);
             if (ret > 0) {
                 slapi_log_err(SLAPI_LOG_CONNS,
                               "sasl_io_start_packet",
                               "Continued: read sasl packet length returned %d on connection %" PRIu64 "\n",
                               ret, c->c_connid);
-                memcpy(sp->encrypted_buffer + sp->encrypted_buffer_offset, mybuf, ret);
                 sp->encrypted_buffer_offset += ret;
             } else if (ret == 0) {
                 *err = PR_GetError();
@@ -406,7 +434,7 @@ sasl_io_start_packet(PRFileDesc *fd, PRIntn flags, PRIntervalTime timeout, PRInt
         return PR_FAILURE;
     }
 
-    /* At this point, sp->encrypted_buffer_offset == sizeof(buffer) */
+    /* At this point, sp->encrypted_buffer_offset >= SASL_IO_BUFFER_START_SIZE */
     /* Decode the length */
     packet_length = ntohl(*(uint32_t *)sp->encrypted_buffer);
     /* add length itself (for Cyrus SASL library) */
@@ -452,11 +480,13 @@ sasl_io_read_packet(PRFileDesc *fd, PRIntn flags, PRIntervalTime timeout, PRInt3
     sasl_io_private *sp = sasl_get_io_private(fd);
     Connection *c = sp->conn;
     uint32_t bytes_remaining_to_read = sp->encrypted_buffer_count - sp->encrypted_buffer_offset;
+    /* the buffer is at least as large as the packet, fill it */
+    uint32_t bytes_to_read = sp->encrypted_buffer_size - sp->encrypted_buffer_offset;
 
     slapi_log_err(SLAPI_LOG_CONNS,
                   "sasl_io_read_packet", "Reading %" PRIu32" bytes for connection %" PRIu64 "\n",
                   bytes_remaining_to_read, c->c_connid);
-    ret = PR_Recv(fd->lower, sp->encrypted_buffer + sp->encrypted_buffer_offset, bytes_remaining_to_read, flags, timeout);
+    ret = PR_Recv(fd->lower, sp->encrypted_buffer + sp->encrypted_buffer_offset, bytes_to_read, flags, timeout);
     if (ret <= 0) {
         *err = PR_GetError();
         if (ret == 0) {
@@ -496,6 +526,7 @@ sasl_io_recv(PRFileDesc *fd, void *buf, PRInt32 len, PRIntn flags, PRIntervalTim
                   c->c_connid, len, sp->encrypted_buffer_count);
     if (0 == bytes_in_buffer) {
         /* If there wasn't buffered decrypted data, we need to get some... */
+        sasl_io_compact_encrypted_buffer(sp);
         if (!sasl_io_reading_packet(sp)) {
             /* First read the packet length and so on */
             ret = sasl_io_start_packet(fd, flags, timeout, &err);
@@ -512,11 +543,14 @@ sasl_io_recv(PRFileDesc *fd, void *buf, PRInt32 len, PRIntn flags, PRIntervalTim
             }
         }
         /* We now have the packet length
-         * we now must read more data off the wire until we have the complete packet
+         * we now must read more data off the wire until we have the complete packet,
+         * unless it was read ahead
          */
-        ret = sasl_io_read_packet(fd, flags, timeout, &err);
-        if (0 >= ret) {
-            return ret; /* read packet will set pr error */
+        if (!sasl_io_finished_packet(sp)) {
+            ret = sasl_io_read_packet(fd, flags, timeout, &err);
+            if (0 >= ret) {
+                return ret; /* read packet will set pr error */
+            }
         }
         /* If we have not read the packet yet, we cannot return any decrypted data to the
          * caller - so just tell the caller we don't have enough data yet
@@ -543,15 +577,14 @@ sasl_io_recv(PRFileDesc *fd, void *buf, PRInt32 len, PRIntn flags, PRIntervalTim
                           "Finished reading packet for connection %" PRIu64 "\n", c->c_connid);
             /* Now decode it */
             ret = sasl_decode(c->c_sasl_conn, sp->encrypted_buffer, sp->encrypted_buffer_count, &output_buffer, &output_length);
-            /* even if decode fails, need re-initialize the encrypted_buffer */
-            sp->encrypted_buffer_offset = 0;
+            /* even if decode fails, the packet is consumed */
+            sp->encrypted_buffer_consumed = sp->encrypted_buffer_count;
             sp->encrypted_buffer_count = 0;
             if (SASL_OK == ret) {
                 slapi_log_err(SLAPI_LOG_CONNS, "sasl_io_recv",
                               "Decoded packet length %u for connection %" PRIu64 "\n", output_length, c->c_connid);
                 if (output_length) {
-                    sasl_io_resize_decrypted_buffer(sp, output_length);
-                    memcpy(sp->decrypted_buffer, output_buffer, output_length);
+                    sp->decrypted_data = output_buffer;
                     sp->decrypted_buffer_count = output_length;
                     sp->decrypted_buffer_offset = 0;
                     bytes_in_buffer = output_length;
@@ -571,8 +604,11 @@ sasl_io_recv(PRFileDesc *fd, void *buf, PRInt32 len, PRIntn flags, PRIntervalTim
             bytes_to_return = len;
         }
         /* Copy data from the decrypted buffer starting at the offset */
-        memcpy(buf, sp->decrypted_buffer + sp->decrypted_buffer_offset, bytes_to_return);
+        if (bytes_to_return) {
+            memcpy(buf, sp->decrypted_data + sp->decrypted_buffer_offset, bytes_to_return);
+        }
         if (bytes_in_buffer == bytes_to_return) {
+            sp->decrypted_data = NULL;
             sp->decrypted_buffer_offset = 0;
             sp->decrypted_buffer_count = 0;
             slapi_log_err(SLAPI_LOG_CONNS, "sasl_io_recv",
@@ -719,7 +755,6 @@ sasl_pop_IO_layer(PRFileDesc *stack, int doclose)
                       "sasl_pop_IO_layer", "Removing SASL IO layer\n");
         /* Free the buffers */
         slapi_ch_free_string(&sp->encrypted_buffer);
-        slapi_ch_free_string(&sp->decrypted_buffer);
         slapi_ch_free((void **)&sp);
     }
     layer->secret = NULL;
@@ -831,3 +866,26 @@ sasl_io_cleanup(Connection *c, void *data __attribute__((unused)))
 
     return ret;
 }
+
+/*
+ * Is there data the SASL I/O layer of the connection received, and can
+ * return without reading the socket ? The caller must keep reading: the
+ * socket will not be reported readable for it.
+ */
+int
+sasl_io_has_buffered_data(Connection *c)
+{
+    PRFileDesc *layer;
+    sasl_io_private *sp;
+
+    if (!sasl_LayerID || !c->c_prfd || !(layer = PR_GetIdentitiesLayer(c->c_prfd, sasl_LayerID))) {
+        return 0;
+    }
+    sp = sasl_get_io_private(layer);
+    if (sp == NULL) {
+        return 0;
+    }
+    return sp->unencrypted_buffer_ready ||
+           (sp->decrypted_buffer_count > sp->decrypted_buffer_offset) ||
+           sasl_io_has_packet(sp);
+}
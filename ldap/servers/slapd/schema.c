@@ -156,6 +156,10 @@ static int strcpy_count(char *dst, const char *src);
 static int refresh_user_defined_schema(Slapi_PBlock *pb, Slapi_Entry *entryBefore, Slapi_Entry *e, int *returncode, char *returntext, void *arg);
 static int schema_check_oc_attrs(struct objclass *poc, char *errorbuf, size_t errorbufsize, int stripOptions);
 static struct objclass *oc_find_nolock(const char *ocname_or_oid, struct objclass *oc_private, PRBool use_private);
+typedef struct oc_index_entry oc_index_entry;
+typedef struct oc_index oc_index;
+static oc_index *oc_index_get_nolock(void);
+static oc_index_entry *oc_index_find(oc_index *idx, const char *ocname_or_oid);
 static struct objclass *oc_find_oid_nolock(const char *ocoid);
 static void oc_free(struct objclass **ocp);
 static PRBool oc_equal(struct objclass *oc1, struct objclass *oc2);
@@ -517,6 +521,11 @@ slapi_entry_schema_check_ext(Slapi_PBlock *pb, Slapi_Entry *e, int repl_check)
 {
     struct objclass **oclist;
     struct objclass *oc;
+    oc_index *idx = NULL;
+    oc_index_entry **oelist = NULL;
+    uint64_t *present = NULL; /* types of the entry */
+    uint64_t *allowed = NULL; /* types allowed by the exact objectclasses */
+    PRBool may_all = PR_FALSE;
     const char *ocname;
     Slapi_Attr *a, *aoc;
     Slapi_Value *v;
@@ -565,6 +574,7 @@ slapi_entry_schema_check_ext(Slapi_PBlock *pb, Slapi_Entry *e, int repl_check)
     }
 
     oclist = (struct objclass **)slapi_ch_malloc((oc_count + 1) * sizeof(struct objclass *));
+    oelist = (oc_index_entry **)slapi_ch_malloc((oc_count + 1) * sizeof(oc_index_entry *));
 
     /*
      * Need the read lock to create the oc array and while we use it.
@@ -572,6 +582,7 @@ slapi_entry_schema_check_ext(Slapi_PBlock *pb, Slapi_Entry *e, int repl_check)
     if (!(schema_flags & DSE_SCHEMA_LOCKED)) {
         oc_lock_read();
     }
+    idx = oc_index_get_nolock();
 
     oc_count = 0;
     for (i = slapi_attr_first_value(aoc, &v); i != -1; i = slapi_attr_next_value(aoc, i, &v)) {
@@ -600,7 +611,14 @@ slapi_entry_schema_check_ext(Slapi_PBlock *pb, Slapi_Entry *e, int repl_check)
             continue;
         }
 
-        if ((oc = oc_find_nolock(ocname, NULL, PR_FALSE)) != NULL) {
+        if (idx) {
+            oc_index_entry *oe = oc_index_find(idx, ocname);
+            oelist[oc_count] = oe;
+            oc = oe ? oe->oe_oc : NULL;
+        } else {
+            oc = oc_find_nolock(ocname, NULL, PR_FALSE);
+        }
+        if (oc != NULL) {
             oclist[oc_count++] = oc;
         } else {
             /* we don't know about the oc; return an appropriate error message */
@@ -643,10 +661,41 @@ slapi_entry_schema_check_ext(Slapi_PBlock *pb, Slapi_Entry *e, int repl_check)
     * this information to the client as an error message.
     */
 
+    if (idx) {
+        /* the bitset of the types of the entry */
+        present = (uint64_t *)slapi_ch_calloc(idx->oi_nwords, sizeof(uint64_t));
+        allowed = (uint64_t *)slapi_ch_calloc(idx->oi_nwords, sizeof(uint64_t));
+        for (a = e->e_attrs; a != NULL; a = a->a_next) {
+            uint32_t id = schema_attr_get_id(a);
+            if (id && id < idx->oi_nwords * 64) {
+                present[id / 64] |= (uint64_t)1 << (id % 64);
+            }
+        }
+    }
+
     /*
     * check that the entry has required attrs for each oc
     */
     for (i = 0; oclist[i] != NULL; i++) {
+        if (idx) {
+            oc_index_entry *oe = oelist[i];
+            uint32_t w;
+
+            may_all |= oe->oe_may_all;
+            if (oe->oe_exact) {
+                for (w = 0; w < idx->oi_nwords && (oe->oe_must[w] & ~present[w]) == 0; w++) {
+                    ;
+                }
+                if (w == idx->oi_nwords) {
+                    /* all there */
+                    for (w = 0; w < idx->oi_nwords; w++) {
+                        allowed[w] |= oe->oe_may[w];
+                    }
+                    continue;
+                }
+            }
+        }
+        /* check by name, it also reports the missing types */
         if (oc_check_required(pb, e, oclist[i]) != 0) {
             ret = 1;
             goto out;
@@ -662,7 +711,8 @@ slapi_entry_schema_check_ext(Slapi_PBlock *pb, Slapi_Entry *e, int repl_check)
         Slapi_Attr *prevattr;
         i = slapi_entry_first_attr(e, &a);
         while (-1 != i && 0 == ret) {
-            if (is_extensible_object == 0 && unknown_class == 0 && !slapi_attr_flag_is_set(a, SLAPI_ATTR_FLAG_OPATTR)) {
+            if (is_extensible_object == 0 && unknown_class == 0 && !slapi_attr_flag_is_set(a, SLAPI_ATTR_FLAG_OPATTR) &&
+                !may_all && !(idx && oc_index_bit_isset(allowed, idx->oi_nwords, schema_attr_get_id(a)))) {
                 char *attrtype;
                 slapi_attr_get_type(a, &attrtype);
                 if (oc_check_allowed_sv(pb, e, attrtype, oclist) != 0) {
@@ -693,6 +743,9 @@ out:
         oc_unlock();
     }
     slapi_ch_free((void **)&oclist);
+    slapi_ch_free((void **)&oelist);
+    slapi_ch_free((void **)&present);
+    slapi_ch_free((void **)&allowed);
 
     return (ret);
 }
@@ -933,6 +986,378 @@ oc_find_name(const char *name_or_oid)
 }
 
 
+/*
+ * Objectclass index
+ *
+ * The global objectclass list is immutable between two write locks of the
+ * objectclasses. The first reader after a change builds an index of it:
+ *  - a minimal perfect hash of the names and oids of the objectclasses
+ *    (hash and displace: the keys are spread into buckets, and each bucket
+ *    gets a seed mapping its keys to free slots), so a lookup is one hash
+ *    probe instead of a scan of the list
+ *  - for each objectclass, the bitsets of the ids (see attr_syntax_intern_id)
+ *    of its required types, and of its required and allowed types
+ * With the bitsets, checking the types of an entry is an AND of the bitset
+ * of the types the entry holds with the bitsets of its objectclasses.
+ * Only the objectclasses whose types were all interned when the index was
+ * built are "exact": the others are checked by name.
+ *
+ * The index is published with a compare and swap, and released by the
+ * writer when it unlocks the objectclasses (oc_unlock): no reader holds it
+ * at that time.
+ */
+#define OC_INDEX_KEYS_PER_BUCKET 4
+#define OC_INDEX_MAX_SEEDS 65536
+
+struct oc_index_entry
+{
+    struct objclass *oe_oc;
+    uint64_t *oe_must; /* required types */
+    uint64_t *oe_may;  /* required and allowed types */
+    PRBool oe_may_all; /* allows any type ("*") */
+    PRBool oe_exact;   /* all the types have an id */
+};
+
+typedef struct oc_index_key
+{
+    const char *ok_key; /* NULL for an empty slot */
+    size_t ok_len;
+    uint32_t ok_h0;
+    oc_index_entry *ok_entry;
+} oc_index_key;
+
+struct oc_index
+{
+    uint32_t oi_nbuckets; /* power of 2 */
+    uint32_t *oi_seeds;
+    uint32_t oi_nslots; /* power of 2 */
+    oc_index_key *oi_slots;
+    oc_index_entry *oi_entries;
+    uint32_t oi_nwords; /* size of the bitsets in 64 bits words */
+    uint64_t *oi_bits;
+};
+
+static oc_index *oc_global_index = NULL;
+
+static uint32_t
+oc_index_hash(const char *key, size_t len, uint32_t seed)
+{
+    uint32_t h = 2166136261U ^ (seed * 0x9e3779b9U);
+
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)tolower((unsigned char)key[i]);
+        h *= 16777619U;
+    }
+    /* final avalanche so that the low bits depend on all the key */
+    h ^= h >> 16;
+    h *= 0x85ebca6bU;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35U;
+    h ^= h >> 16;
+    return h;
+}
+
+static uint32_t
+oc_index_pow2(uint32_t n)
+{
+    uint32_t p = 1;
+
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+static void
+oc_index_free(oc_index **idxp)
+{
+    oc_index *idx = *idxp;
+
+    if (idx == NULL) {
+        return;
+    }
+    slapi_ch_free((void **)&idx->oi_seeds);
+    slapi_ch_free((void **)&idx->oi_slots);
+    slapi_ch_free((void **)&idx->oi_entries);
+    slapi_ch_free((void **)&idx->oi_bits);
+    slapi_ch_free((void **)idxp);
+}
+
+/*
+ * Set the bits of the types, returns PR_FALSE if one of them has no id.
+ * The types are compared by name by the checks, so are their ids.
+ */
+static PRBool
+oc_index_set_bits(char **types, uint64_t *bits, uint32_t nwords, PRBool *may_all)
+{
+    PRBool exact = PR_TRUE;
+
+    for (size_t i = 0; types && types[i]; i++) {
+        uint32_t id;
+
+        if (may_all && strcmp(types[i], "*") == 0) {
+            *may_all = PR_TRUE;
+            continue;
+        }
+        id = attr_syntax_lookup_id(types[i]);
+        if (id == 0 || id >= nwords * 64) {
+            exact = PR_FALSE;
+            continue;
+        }
+        bits[id / 64] |= (uint64_t)1 << (id % 64);
+    }
+    return exact;
+}
+
+static int
+oc_index_key_cmp(const void *a, const void *b)
+{
+    const oc_index_key *ka = (const oc_index_key *)a;
+    const oc_index_key *kb = (const oc_index_key *)b;
+
+    return (ka->ok_h0 > kb->ok_h0) - (ka->ok_h0 < kb->ok_h0);
+}
+
+typedef struct oc_index_bucket
+{
+    uint32_t ob_id;
+    uint32_t ob_first; /* first key of the bucket */
+    uint32_t ob_count;
+} oc_index_bucket;
+
+static int
+oc_index_bucket_cmp(const void *a, const void *b)
+{
+    const oc_index_bucket *ba = (const oc_index_bucket *)a;
+    const oc_index_bucket *bb = (const oc_index_bucket *)b;
+
+    /* biggest buckets first, they are the hardest to place */
+    return (ba->ob_count < bb->ob_count) - (ba->ob_count > bb->ob_count);
+}
+
+/*
+ * Find the seed placing the keys of a bucket into free and distinct slots.
+ * Returns 0 if there is none.
+ */
+static uint32_t
+oc_index_place_bucket(oc_index *idx, oc_index_key *keys, oc_index_bucket *b, uint32_t *slots)
+{
+    for (uint32_t seed = 1; seed < OC_INDEX_MAX_SEEDS; seed++) {
+        uint32_t i;
+
+        for (i = 0; i < b->ob_count; i++) {
+            oc_index_key *k = &keys[b->ob_first + i];
+            uint32_t s = oc_index_hash(k->ok_key, k->ok_len, seed) & (idx->oi_nslots - 1);
+            uint32_t j;
+
+            if (idx->oi_slots[s].ok_key) {
+                break;
+            }
+            for (j = 0; j < i && slots[j] != s; j++) {
+                ;
+            }
+            if (j < i) {
+                break;
+            }
+            slots[i] = s;
+        }
+        if (i == b->ob_count) {
+            for (i = 0; i < b->ob_count; i++) {
+                idx->oi_slots[slots[i]] = keys[b->ob_first + i];
+            }
+            return seed;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Build the index of an objectclass list. Returns NULL if no perfect hash
+ * was found: the callers then scan the list.
+ */
+static oc_index *
+oc_index_build(struct objclass *oclist)
+{
+    oc_index *idx = (oc_index *)slapi_ch_calloc(1, sizeof(oc_index));
+    PLHashTable *seen = PL_NewHashTable(64, hashNocaseString, hashNocaseCompare, PL_CompareValues, 0, 0);
+    oc_index_key *keys;
+    oc_index_bucket *buckets;
+    uint32_t *slots;
+    uint32_t nocs = 0, nkeys = 0, nbuckets = 0;
+    uint32_t max_count = 0;
+    struct objclass *oc;
+
+    for (oc = oclist; oc != NULL; oc = oc->oc_next) {
+        nocs++;
+    }
+    idx->oi_nwords = attr_syntax_id_count() / 64 + 1;
+    idx->oi_entries = (oc_index_entry *)slapi_ch_calloc(nocs ? nocs : 1, sizeof(oc_index_entry));
+    idx->oi_bits = (uint64_t *)slapi_ch_calloc((nocs ? nocs : 1) * 2 * idx->oi_nwords, sizeof(uint64_t));
+    keys = (oc_index_key *)slapi_ch_calloc((nocs ? nocs : 1) * 2, sizeof(oc_index_key));
+
+    /* the first objectclass of the list wins, like in oc_find_nolock() */
+    nocs = 0;
+    for (oc = oclist; oc != NULL; oc = oc->oc_next) {
+        oc_index_entry *oe = &idx->oi_entries[nocs];
+        const char *names[2] = {oc->oc_name, oc->oc_oid};
+
+        oe->oe_oc = oc;
+        oe->oe_must = idx->oi_bits + (size_t)nocs * 2 * idx->oi_nwords;
+        oe->oe_may = oe->oe_must + idx->oi_nwords;
+        oe->oe_exact = oc_index_set_bits(oc->oc_required, oe->oe_must, idx->oi_nwords, NULL);
+        oe->oe_exact &= oc_index_set_bits(oc->oc_required, oe->oe_may, idx->oi_nwords, NULL);
+        oe->oe_exact &= oc_index_set_bits(oc->oc_allowed, oe->oe_may, idx->oi_nwords, &oe->oe_may_all);
+        nocs++;
+
+        for (size_t i = 0; i < 2; i++) {
+            if (names[i] == NULL || PL_HashTableLookupConst(seen, names[i])) {
+                continue;
+            }
+            PL_HashTableAdd(seen, names[i], oe);
+            keys[nkeys].ok_key = names[i];
+            keys[nkeys].ok_len = strlen(names[i]);
+            keys[nkeys].ok_h0 = oc_index_hash(names[i], keys[nkeys].ok_len, 0);
+            keys[nkeys].ok_entry = oe;
+            nkeys++;
+        }
+    }
+    PL_HashTableDestroy(seen);
+
+    idx->oi_nbuckets = oc_index_pow2(nkeys / OC_INDEX_KEYS_PER_BUCKET + 1);
+    idx->oi_seeds = (uint32_t *)slapi_ch_calloc(idx->oi_nbuckets, sizeof(uint32_t));
+    idx->oi_nslots = oc_index_pow2(nkeys * 2 + 1);
+    idx->oi_slots = (oc_index_key *)slapi_ch_calloc(idx->oi_nslots, sizeof(oc_index_key));
+
+    /* group the keys by bucket */
+    for (uint32_t i = 0; i < nkeys; i++) {
+        keys[i].ok_h0 &= (idx->oi_nbuckets - 1);
+    }
+    qsort(keys, nkeys, sizeof(oc_index_key), oc_index_key_cmp);
+    buckets = (oc_index_bucket *)slapi_ch_calloc(idx->oi_nbuckets, sizeof(oc_index_bucket));
+    for (uint32_t i = 0; i < nkeys; i++) {
+        if (i == 0 || keys[i].ok_h0 != keys[i - 1].ok_h0) {
+            buckets[nbuckets].ob_id = keys[i].ok_h0;
+            buckets[nbuckets].ob_first = i;
+            nbuckets++;
+        }
+        buckets[nbuckets - 1].ob_count++;
+        if (buckets[nbuckets - 1].ob_count > max_count) {
+            max_count = buckets[nbuckets - 1].ob_count;
+        }
+    }
+    qsort(buckets, nbuckets, sizeof(oc_index_bucket), oc_index_bucket_cmp);
+
+    slots = (uint32_t *)slapi_ch_calloc(max_count ? max_count : 1, sizeof(uint32_t));
+    for (uint32_t i = 0; i < nbuckets; i++) {
+        uint32_t seed = oc_index_place_bucket(idx, keys, &buckets[i], slots);
+        if (seed == 0) {
+            slapi_log_err(SLAPI_LOG_WARNING, "oc_index_build",
+                          "Could not index %u objectclass names, using the list\n", nkeys);
+            oc_index_free(&idx);
+            break;
+        }
+        idx->oi_seeds[buckets[i].ob_id] = seed;
+    }
+    slapi_ch_free((void **)&slots);
+    slapi_ch_free((void **)&buckets);
+    slapi_ch_free((void **)&keys);
+    return idx;
+}
+
+/*
+ * Release the index of the objectclasses. The caller must hold the
+ * objectclasses write lock, or be the only thread using them.
+ */
+void
+oc_index_invalidate_nolock(void)
+{
+    oc_index *idx = __atomic_exchange_n(&oc_global_index, NULL, __ATOMIC_ACQ_REL);
+
+    oc_index_free(&idx);
+}
+
+/*
+ * Returns the index of the global objectclasses, building it if needed.
+ * The caller must hold the objectclasses read lock, and must not use the
+ * index while holding the write lock: the objectclasses are changing.
+ * Returns NULL if there is no index.
+ */
+static oc_index *
+oc_index_get_nolock(void)
+{
+    oc_index *idx;
+    oc_index *expected = NULL;
+
+    if (oc_lock_is_write_held()) {
+        return NULL;
+    }
+    idx = __atomic_load_n(&oc_global_index, __ATOMIC_ACQUIRE);
+    if (idx) {
+        return idx;
+    }
+    idx = oc_index_build(g_get_global_oc_nolock());
+    if (idx && !__atomic_compare_exchange_n(&oc_global_index, &expected, idx, 0,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        /* another reader was faster */
+        oc_index_free(&idx);
+        idx = expected;
+    }
+    return idx;
+}
+
+/*
+ * Same as oc_find_nolock() on the global list, with the index.
+ */
+static oc_index_entry *
+oc_index_find(oc_index *idx, const char *ocname_or_oid)
+{
+    oc_index_key *k;
+    size_t len;
+    uint32_t seed;
+
+    if (schema_ignore_trailing_spaces) {
+        for (len = 0; ocname_or_oid[len] != '\0' && ocname_or_oid[len] != ' '; len++) {
+            ;
+        }
+    } else {
+        len = strlen(ocname_or_oid);
+    }
+    seed = idx->oi_seeds[oc_index_hash(ocname_or_oid, len, 0) & (idx->oi_nbuckets - 1)];
+    if (seed == 0) {
+        /* empty bucket */
+        return NULL;
+    }
+    k = &idx->oi_slots[oc_index_hash(ocname_or_oid, len, seed) & (idx->oi_nslots - 1)];
+    if (k->ok_key && k->ok_len == len && strncasecmp(k->ok_key, ocname_or_oid, len) == 0) {
+        return k->ok_entry;
+    }
+    return NULL;
+}
+
+/* Is the bit of the id set ? */
+static inline PRBool
+oc_index_bit_isset(const uint64_t *bits, uint32_t nwords, uint32_t id)
+{
+    return id && id < nwords * 64 && (bits[id / 64] & ((uint64_t)1 << (id % 64)));
+}
+
+/* Interned id of the base type of an attribute */
+static uint32_t
+schema_attr_get_id(Slapi_Attr *a)
+{
+    char buf[SLAPD_TYPICAL_ATTRIBUTE_NAME_MAX_LENGTH];
+    char *tmp;
+    uint32_t id;
+
+    if (a->a_id) {
+        return a->a_id;
+    }
+    tmp = slapi_attr_basetype(a->a_type, buf, sizeof(buf));
+    id = attr_syntax_lookup_id(tmp ? tmp : buf);
+    slapi_ch_free_string(&tmp);
+    return id;
+}
+
 /*
  * oc_find_nolock will return a pointer to the objectclass which has the
  *      same name OR oid.
@@ -942,8 +1367,13 @@ static struct objclass *
 oc_find_nolock(const char *ocname_or_oid, struct objclass *oc_private, PRBool use_private)
 {
     struct objclass *oc;
+    oc_index *idx;
 
     if (NULL != ocname_or_oid) {
+        if (!use_private && (idx = oc_index_get_nolock()) != NULL) {
+            oc_index_entry *oe = oc_index_find(idx, ocname_or_oid);
+            return oe ? oe->oe_oc : NULL;
+        }
         if (!schema_ignore_trailing_spaces) {
             if (use_private) {
                 oc = oc_private;
@@ -1025,6 +1455,7 @@ oc_replace_nolock(const char *ocname, struct objclass *newoc, char *errorbuf, si
     PRBool saw_sup = PR_FALSE;
 
     oc = g_get_global_oc_nolock();
+    oc_index_invalidate_nolock();
 
     if (newoc->oc_superior == NULL) {
         saw_sup = PR_TRUE;
@@ -1075,6 +1506,7 @@ oc_delete_nolock(char *ocname)
     int rc = 0; /* failure */
 
     oc = g_get_global_oc_nolock();
+    oc_index_invalidate_nolock();
 
     /* special case if we're removing the first oc */
     if (strcasecmp(oc->oc_name, ocname) == 0) {
@@ -2336,6 +2768,7 @@ oc_add_nolock(struct objclass *newoc)
     struct objclass *poc;
 
     poc = g_get_global_oc_nolock();
+    oc_index_invalidate_nolock();
 
     if (NULL == poc) {
         g_set_global_oc_nolock(newoc);
@@ -4862,6 +5295,8 @@ schema_expand_objectclasses_ext(Slapi_Entry *e, int lock)
     if (slapi_valueset_isempty(vs)) {
         return; /* no OC values -- nothing to do */
     }
+    /* the loop below walks the values while it adds to them */
+    valueset_unshare(vs);
 
     if (lock)
         oc_lock_read();
@@ -23,6 +23,8 @@
 struct objclass *global_oc;
 CSN *global_schema_csn = NULL; /* Timestamp for last update CSN. NULL = epoch */
 static Slapi_RWLock *oc_lock = NULL;
+/* set while a thread holds oc_lock for writing */
+static PRBool oc_write_held = PR_FALSE;
 
 static int is_duplicate(char *target, char **list, int list_max);
 static void normalize_list(char **list);
@@ -64,6 +66,7 @@ oc_lock_write(void)
     if (NULL != oc_lock ||
         PR_SUCCESS == PR_CallOnce(&oc_init_lock_callonce, oc_init_lock)) {
         slapi_rwlock_wrlock(oc_lock);
+        oc_write_held = PR_TRUE;
     }
 }
 
@@ -72,10 +75,29 @@ void
 oc_unlock(void)
 {
     if (oc_lock != NULL) {
+        /*
+         * Readers can't see oc_write_held set: it is only set while the
+         * writer holds the lock.
+         */
+        if (oc_write_held) {
+            oc_write_held = PR_FALSE;
+            /* the objectclasses may have changed, see oc_index_get_nolock() */
+            oc_index_invalidate_nolock();
+        }
         slapi_rwlock_unlock(oc_lock);
     }
 }
 
+/*
+ * Returns PR_TRUE if the objectclasses are locked for writing. It is only
+ * meaningful for the caller holding the lock.
+ */
+PRBool
+oc_lock_is_write_held(void)
+{
+    return oc_write_held;
+}
+
 
 /*
  * Note: callers of g_get_global_oc_nolock() must hold a read or write lock
@@ -93,6 +115,7 @@ void
 g_set_global_oc_nolock(struct objclass *newglobaloc)
 {
     global_oc = newglobaloc;
+    oc_index_invalidate_nolock();
 }
 
 /*
@@ -0,0 +1,611 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * search_fanout.c - build the candidates of the backends of a search in parallel
+ *
+ * A search based above several suffixes (the root dse, or a suffix with sub
+ * suffixes) is run by op_shared_search() on one backend after the other. When
+ * there are many backends, most of the time goes in building the candidate
+ * lists one by one.
+ *
+ * search_fanout_start() queues the be_search of the backends to a pool of
+ * nsslapd-search-fanout-threads threads (0, the default, disables it). Each
+ * backend search runs with its own pblock and operation, copied from the
+ * search, and the results it would have sent (errors, referrals) are kept.
+ * op_shared_search() still walks the backends in order, and
+ * search_fanout_take() hands it the result set, filters and index statistics
+ * of the backend, so the entries are sent by the operation thread in the same
+ * order as before: the size limit, the abandon checks and the result codes
+ * are unchanged. A backend search still queued when its turn comes is run
+ * by the worker thread itself. Abandoning the search abandons the backend
+ * searches (see search_fanout_op_abandoned()).
+ *
+ * Only the searches of a backend on its own suffix are fanned out, for
+ * regular ldbm-like backends: not the private (dse) or chaining backends,
+ * and not the paged, sorted, vlv, persistent or internal searches.
+ */
+
+#include "slap.h"
+
+#define SEARCH_FANOUT_QUEUED 0
+#define SEARCH_FANOUT_RUNNING 1
+#define SEARCH_FANOUT_DONE 2
+
+/* The operation flags the backend search may look at */
+#define SEARCH_FANOUT_OP_FLAGS (OP_FLAG_GET_EFFECTIVE_RIGHTS | OP_FLAG_NEVER_CACHE |    \
+                                OP_FLAG_REVERSE_CANDIDATE_ORDER | OP_FLAG_SUBENTRIES_FALSE | \
+                                OP_FLAG_SUBENTRIES_TRUE)
+
+typedef struct search_fanout_job
+{
+    Slapi_Backend *sj_be;
+    Slapi_PBlock *sj_pb;
+    Slapi_Operation *sj_op;
+    Slapi_DN *sj_target;
+    Slapi_Operation *sj_parent_op; /* the search, to skip the job if it was abandoned */
+    int sj_state;
+    int sj_rc;      /* be_search return code */
+    int sj_skipped; /* not run, op_shared_search() calls be_search */
+    int sj_sent;    /* the backend sent a result, kept below */
+    int sj_err;
+    char *sj_matched;
+    char *sj_text;
+    struct berval **sj_urls;
+    struct search_fanout *sj_fanout;
+    struct search_fanout_job *sj_prev; /* in the pool queue */
+    struct search_fanout_job *sj_next;
+} search_fanout_job;
+
+struct search_fanout
+{
+    pthread_cond_t sf_cv; /* signaled when a job is done */
+    search_fanout_job *sf_jobs;
+    int sf_njobs;
+};
+
+static struct
+{
+    pthread_mutex_t sp_lock;
+    pthread_cond_t sp_cv; /* the threads wait on it for jobs */
+    search_fanout_job *sp_head;
+    search_fanout_job *sp_tail;
+    PRThread **sp_threads;
+    int sp_nthreads;
+    int sp_started;
+    int sp_stopping;
+} search_pool = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, NULL, NULL, 0, 0, 0};
+
+/* Called with sp_lock held */
+static void
+search_fanout_unlink_nolock(search_fanout_job *job)
+{
+    if (job->sj_prev) {
+        job->sj_prev->sj_next = job->sj_next;
+    } else {
+        search_pool.sp_head = job->sj_next;
+    }
+    if (job->sj_next) {
+        job->sj_next->sj_prev = job->sj_prev;
+    } else {
+        search_pool.sp_tail = job->sj_prev;
+    }
+    job->sj_prev = job->sj_next = NULL;
+}
+
+/*
+ * o_result_handler of the backend searches: keep the result, it is sent by
+ * search_fanout_take() when the search gets to the backend.
+ */
+static void
+search_fanout_result(Connection *conn __attribute__((unused)),
+                     Operation *op,
+                     int err,
+                     char *matched,
+                     char *text,
+                     int nentries __attribute__((unused)),
+                     struct berval **urls)
+{
+    search_fanout_job *job = (search_fanout_job *)op->o_handler_data;
+
+    job->sj_sent = 1;
+    job->sj_err = err;
+    slapi_ch_free_string(&job->sj_matched);
+    slapi_ch_free_string(&job->sj_text);
+    ber_bvecfree(job->sj_urls);
+    job->sj_matched = slapi_ch_strdup(matched);
+    job->sj_text = slapi_ch_strdup(text);
+    job->sj_urls = urls ? slapi_ch_bvecdup(urls) : NULL;
+}
+
+/*
+ * Called by slapi_is_operation_abandoned() for the operation of a backend
+ * search: abandon and connection closure only mark the search itself.
+ */
+int
+search_fanout_op_abandoned(Slapi_Operation *op)
+{
+    search_fanout_job *job = (search_fanout_job *)op->o_handler_data;
+
+    return op->o_status == SLAPI_OP_STATUS_ABANDONED ||
+           job->sj_parent_op->o_status == SLAPI_OP_STATUS_ABANDONED;
+}
+
+static void
+search_fanout_run(search_fanout_job *job)
+{
+    if (job->sj_parent_op->o_status == SLAPI_OP_STATUS_ABANDONED) {
+        job->sj_skipped = 1;
+        return;
+    }
+    job->sj_rc = (*job->sj_be->be_search)(job->sj_pb);
+}
+
+static void
+search_fanout_thread(void *arg __attribute__((unused)))
+{
+    slapi_set_thread_name("search-fanout");
+
+    pthread_mutex_lock(&search_pool.sp_lock);
+    while (1) {
+        search_fanout_job *job = search_pool.sp_head;
+
+        if (job == NULL) {
+            if (search_pool.sp_stopping) {
+                break;
+            }
+            pthread_cond_wait(&search_pool.sp_cv, &search_pool.sp_lock);
+            continue;
+        }
+        search_fanout_unlink_nolock(job);
+        job->sj_state = SEARCH_FANOUT_RUNNING;
+        pthread_mutex_unlock(&search_pool.sp_lock);
+
+        search_fanout_run(job);
+
+        pthread_mutex_lock(&search_pool.sp_lock);
+        job->sj_state = SEARCH_FANOUT_DONE;
+        pthread_cond_broadcast(&job->sj_fanout->sf_cv);
+    }
+    pthread_mutex_unlock(&search_pool.sp_lock);
+}
+
+/* Called with sp_lock held */
+static void
+search_fanout_start_threads_nolock(void)
+{
+    int nthreads = config_get_search_fanout_threads();
+
+    search_pool.sp_started = 1;
+    if (nthreads <= 0) {
+        return;
+    }
+    search_pool.sp_threads = (PRThread **)slapi_ch_calloc(nthreads, sizeof(PRThread *));
+    for (int i = 0; i < nthreads; i++) {
+        PRThread *tid = PR_CreateThread(PR_USER_THREAD, search_fanout_thread, NULL,
+                                        PR_PRIORITY_NORMAL, PR_GLOBAL_THREAD,
+                                        PR_JOINABLE_THREAD, SLAPD_DEFAULT_THREAD_STACKSIZE);
+        if (NULL == tid) {
+            int prerr = PR_GetError();
+            slapi_log_err(SLAPI_LOG_ERR, "search_fanout_start_threads", "PR_CreateThread() failed: "
+                          SLAPI_COMPONENT_NAME_NSPR " error %d (%s)\n",
+                          prerr, slapd_pr_strerror(prerr));
+            break;
+        }
+        search_pool.sp_threads[search_pool.sp_nthreads++] = tid;
+    }
+    slapi_log_err(SLAPI_LOG_INFO, "search_fanout_start_threads",
+                  "Started %d search fan-out threads\n", search_pool.sp_nthreads);
+}
+
+/*
+ * The scope and target of the search on a backend, following the rules
+ * of the backend loop of op_shared_search(). Returns 0 if the backend
+ * searches its own suffix, the only case fanned out: the target entry is
+ * then looked up without access control.
+ */
+static int
+search_fanout_scope(const Slapi_DN *basesdn, int scope, const Slapi_DN *be_suffix, int *be_scope)
+{
+    switch (scope) {
+    case LDAP_SCOPE_SUBTREE:
+        if (slapi_sdn_issuffix(be_suffix, basesdn)) {
+            *be_scope = LDAP_SCOPE_SUBTREE;
+            return 0;
+        }
+        break;
+    case LDAP_SCOPE_ONELEVEL:
+        if (slapi_sdn_isparent(basesdn, be_suffix) || (slapi_sdn_get_ndn_len(basesdn) == 0)) {
+            *be_scope = LDAP_SCOPE_BASE;
+            return 0;
+        }
+        break;
+    }
+    return -1;
+}
+
+static int
+search_fanout_eligible_be(Slapi_Backend *be)
+{
+    return be->be_search != NULL && !slapi_be_private(be) &&
+           !slapi_be_is_flag_set(be, SLAPI_BE_FLAG_REMOTE_DATA) &&
+           slapi_be_getsuffix(be, 0) != NULL;
+}
+
+/* The pblock of the search on a backend, a copy of the search parameters */
+static void
+search_fanout_job_init(search_fanout_job *job, Slapi_PBlock *pb, Slapi_Backend *be, int be_scope)
+{
+    Slapi_Operation *operation = NULL;
+    Connection *pb_conn = NULL;
+    Slapi_Operation *op;
+    Slapi_Filter *filter = NULL;
+    char *strfilter = NULL;
+    char **attrs = NULL;
+    LDAPControl **ctrls = NULL;
+    int attrsonly = 0, deref = 0, sizelimit = 0, timelimit = 0;
+    int isroot = 0, managedsait = 0, be_count = 0;
+    int filter_normalized = 0;
+    int pr_idx = -1;
+
+    slapi_pblock_get(pb, SLAPI_OPERATION, &operation);
+    slapi_pblock_get(pb, SLAPI_CONNECTION, &pb_conn);
+    slapi_pblock_get(pb, SLAPI_SEARCH_FILTER, &filter);
+    slapi_pblock_get(pb, SLAPI_SEARCH_STRFILTER, &strfilter);
+    slapi_pblock_get(pb, SLAPI_PLUGIN_SYNTAX_FILTER_NORMALIZED, &filter_normalized);
+    slapi_pblock_get(pb, SLAPI_SEARCH_ATTRS, &attrs);
+    slapi_pblock_get(pb, SLAPI_SEARCH_ATTRSONLY, &attrsonly);
+    slapi_pblock_get(pb, SLAPI_SEARCH_DEREF, &deref);
+    slapi_pblock_get(pb, SLAPI_SEARCH_SIZELIMIT, &sizelimit);
+    slapi_pblock_get(pb, SLAPI_SEARCH_TIMELIMIT, &timelimit);
+    slapi_pblock_get(pb, SLAPI_REQCONTROLS, &ctrls);
+    slapi_pblock_get(pb, SLAPI_REQUESTOR_ISROOT, &isroot);
+    slapi_pblock_get(pb, SLAPI_MANAGEDSAIT, &managedsait);
+    slapi_pblock_get(pb, SLAPI_BACKEND_COUNT, &be_count);
+
+    /*
+     * Not an internal operation, so that the backend processes it as the
+     * search itself, but its results go to search_fanout_result().
+     */
+    op = operation_new(OP_FLAG_SEARCH_FANOUT | (operation->o_flags & SEARCH_FANOUT_OP_FLAGS));
+    operation_set_type(op, SLAPI_OPERATION_SEARCH);
+    op->o_tag = operation->o_tag;
+    op->o_msgid = operation->o_msgid;
+    op->o_opid = operation->o_opid;
+    op->o_connid = operation->o_connid;
+    op->o_conn_starttime = operation->o_conn_starttime;
+    op->o_isroot = operation->o_isroot;
+    op->o_ssf = operation->o_ssf;
+    op->o_hr_time_rel = operation->o_hr_time_rel;
+    op->o_hr_time_utc = operation->o_hr_time_utc;
+    op->o_hr_time_started_rel = operation->o_hr_time_started_rel;
+    slapi_sdn_copy(&operation->o_sdn, &op->o_sdn);
+    op->o_handler_data = job;
+    op->o_result_handler = search_fanout_result;
+    /* the index lookup statistics (op_stat) are kept in an extension */
+    op->o_extension = factory_create_extension(get_operation_object_type(), op, NULL);
+
+    job->sj_be = be;
+    job->sj_op = op;
+    job->sj_parent_op = operation;
+    job->sj_target = slapi_sdn_dup(slapi_be_getsuffix(be, 0));
+    job->sj_pb = slapi_pblock_new();
+    slapi_pblock_set(job->sj_pb, SLAPI_OPERATION, op);
+    /* for the resource limits of the bound dn, only read */
+    slapi_pblock_set(job->sj_pb, SLAPI_CONNECTION, pb_conn);
+    slapi_pblock_set(job->sj_pb, SLAPI_BACKEND, be);
+    slapi_pblock_set(job->sj_pb, SLAPI_PLUGIN, be->be_database);
+    slapi_pblock_set(job->sj_pb, SLAPI_BACKEND_COUNT, &be_count);
+    slapi_pblock_set(job->sj_pb, SLAPI_REQUESTOR_ISROOT, &isroot);
+    slapi_pblock_set(job->sj_pb, SLAPI_MANAGEDSAIT, &managedsait);
+    slapi_pblock_set(job->sj_pb, SLAPI_PAGED_RESULTS_INDEX, &pr_idx);
+    slapi_pblock_set(job->sj_pb, SLAPI_SEARCH_TARGET_SDN, job->sj_target);
+    slapi_pblock_set(job->sj_pb, SLAPI_SEARCH_SCOPE, &be_scope);
+    slapi_pblock_set(job->sj_pb, SLAPI_SEARCH_DEREF, &deref);
+    slapi_pblock_set(job->sj_pb, SLAPI_SEARCH_SIZELIMIT, &sizelimit);
+    slapi_pblock_set(job->sj_pb, SLAPI_SEARCH_TIMELIMIT, &timelimit);
+    /* the backend optimises and rewrites the filter in place */
+    slapi_pblock_set(job->sj_pb, SLAPI_SEARCH_FILTER, slapi_filter_dup(filter));
+    slapi_pblock_set(job->sj_pb, SLAPI_PLUGIN_SYNTAX_FILTER_NORMALIZED, &filter_normalized);
+    slapi_pblock_set(job->sj_pb, SLAPI_SEARCH_STRFILTER, strfilter);
+    slapi_pblock_set(job->sj_pb, SLAPI_SEARCH_ATTRS, attrs);
+    slapi_pblock_set(job->sj_pb, SLAPI_SEARCH_ATTRSONLY, &attrsonly);
+    slapi_pblock_set(job->sj_pb, SLAPI_REQCONTROLS, ctrls);
+    slapi_pblock_set(job->sj_pb, SLAPI_SEARCH_RESULT_SET, NULL);
+}
+
+static void
+search_fanout_job_done(search_fanout_job *job)
+{
+    Slapi_Filter *filter = NULL;
+    void *sr = NULL;
+
+    /* the result set and target entry of a backend the search did not get to */
+    slapi_pblock_get(job->sj_pb, SLAPI_SEARCH_RESULT_SET, &sr);
+    if (sr && job->sj_be->be_search_results_release) {
+        job->sj_be->be_search_results_release(&sr);
+    }
+    if (operation_get_target_entry(job->sj_op) && job->sj_be->be_entry_release) {
+        (*job->sj_be->be_entry_release)(job->sj_pb, operation_get_target_entry(job->sj_op));
+        operation_set_target_entry(job->sj_op, NULL);
+        operation_set_target_entry_id(job->sj_op, 0);
+    }
+
+    slapi_pblock_get(job->sj_pb, SLAPI_SEARCH_FILTER, &filter);
+    slapi_filter_free(filter, 1);
+    /* shared with the search, the operation would free them */
+    slapi_pblock_set(job->sj_pb, SLAPI_REQCONTROLS, NULL);
+    slapi_pblock_set(job->sj_pb, SLAPI_CONNECTION, NULL);
+    /* frees sj_op */
+    slapi_pblock_destroy(job->sj_pb);
+    job->sj_op = NULL;
+    slapi_sdn_free(&job->sj_target);
+    slapi_ch_free_string(&job->sj_matched);
+    slapi_ch_free_string(&job->sj_text);
+    ber_bvecfree(job->sj_urls);
+}
+
+/*
+ * Queue the backend searches of be_list[0..nbe-1] that can run in parallel.
+ * Returns NULL if the search is not fanned out: the pool is disabled, or
+ * less than two backends qualify.
+ */
+struct search_fanout *
+search_fanout_start(Slapi_PBlock *pb, Slapi_Backend **be_list, int nbe, const Slapi_DN *basesdn, int scope)
+{
+    Slapi_Operation *operation = NULL;
+    LDAPControl **ctrls = NULL;
+    struct search_fanout *sf;
+    Slapi_DN monitorsdn = {0};
+    int be_scope;
+    int nqueued = 0;
+    int under_monitor;
+
+    if (nbe < 2 || (scope != LDAP_SCOPE_SUBTREE && scope != LDAP_SCOPE_ONELEVEL)) {
+        return NULL;
+    }
+    slapi_pblock_get(pb, SLAPI_OPERATION, &operation);
+    slapi_pblock_get(pb, SLAPI_REQCONTROLS, &ctrls);
+    if (operation_is_flag_set(operation, OP_FLAG_INTERNAL | OP_FLAG_PS | OP_FLAG_PS_CHANGESONLY | OP_FLAG_PAGED_RESULTS) ||
+        slapi_control_present(ctrls, LDAP_CONTROL_SORTREQUEST, NULL, NULL) ||
+        slapi_control_present(ctrls, LDAP_CONTROL_VLVREQUEST, NULL, NULL)) {
+        return NULL;
+    }
+    /* cn=monitor subsearches are callbacks of monitor.c */
+    slapi_sdn_init_dn_byref(&monitorsdn, "cn=monitor");
+    under_monitor = slapi_sdn_issuffix(basesdn, &monitorsdn);
+    slapi_sdn_done(&monitorsdn);
+    if (under_monitor) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&search_pool.sp_lock);
+    if (!search_pool.sp_started && !search_pool.sp_stopping) {
+        search_fanout_start_threads_nolock();
+    }
+    pthread_mutex_unlock(&search_pool.sp_lock);
+    if (search_pool.sp_nthreads == 0) {
+        return NULL;
+    }
+
+    for (int i = 0; i < nbe; i++) {
+        if (search_fanout_eligible_be(be_list[i]) &&
+            search_fanout_scope(basesdn, scope, slapi_be_getsuffix(be_list[i], 0), &be_scope) == 0) {
+            nqueued++;
+        }
+    }
+    if (nqueued < 2) {
+        return NULL;
+    }
+
+    sf = (struct search_fanout *)slapi_ch_calloc(1, sizeof(struct search_fanout));
+    pthread_cond_init(&sf->sf_cv, NULL);
+    sf->sf_jobs = (search_fanout_job *)slapi_ch_calloc(nqueued, sizeof(search_fanout_job));
+    /* op_shared_search() walks be_list from the end */
+    for (int i = nbe - 1; i >= 0; i--) {
+        if (search_fanout_eligible_be(be_list[i]) &&
+            search_fanout_scope(basesdn, scope, slapi_be_getsuffix(be_list[i], 0), &be_scope) == 0) {
+            search_fanout_job *job = &sf->sf_jobs[sf->sf_njobs++];
+
+            job->sj_fanout = sf;
+            search_fanout_job_init(job, pb, be_list[i], be_scope);
+        }
+    }
+
+    pthread_mutex_lock(&search_pool.sp_lock);
+    for (int i = 0; i < sf->sf_njobs; i++) {
+        search_fanout_job *job = &sf->sf_jobs[i];
+
+        job->sj_state = SEARCH_FANOUT_QUEUED;
+        job->sj_prev = search_pool.sp_tail;
+        if (search_pool.sp_tail) {
+            search_pool.sp_tail->sj_next = job;
+        } else {
+            search_pool.sp_head = job;
+        }
+        search_pool.sp_tail = job;
+    }
+    pthread_cond_broadcast(&search_pool.sp_cv);
+    pthread_mutex_unlock(&search_pool.sp_lock);
+
+    return sf;
+}
+
+/*
+ * Add the index lookups of the backend search to the statistics of the
+ * search, as if keys2idl() had run with pb.
+ */
+static void
+search_fanout_take_stat(search_fanout_job *job, Slapi_PBlock *pb)
+{
+    Op_stat *op_stat = op_stat_get_operation_extension(pb);
+    Op_stat *job_stat = op_stat_get_operation_extension(job->sj_pb);
+    struct component_keys_lookup **last;
+
+    if (op_stat == NULL || op_stat->search_stat == NULL ||
+        job_stat == NULL || job_stat->search_stat == NULL ||
+        job_stat->search_stat->keys_lookup == NULL) {
+        return;
+    }
+    for (last = &job_stat->search_stat->keys_lookup; *last; last = &(*last)->next)
+        ;
+    *last = op_stat->search_stat->keys_lookup;
+    op_stat->search_stat->keys_lookup = job_stat->search_stat->keys_lookup;
+    op_stat->search_stat->keys_lookup_start = job_stat->search_stat->keys_lookup_start;
+    op_stat->search_stat->keys_lookup_end = job_stat->search_stat->keys_lookup_end;
+    job_stat->search_stat->keys_lookup = NULL;
+}
+
+/*
+ * If the search on be was queued by search_fanout_start(), wait for it, or
+ * run it if no thread took it yet, and move its result set, target entry
+ * and result to pb, as if be_search had been called with pb: *rc is its
+ * return code and 1 is returned. Otherwise returns 0, the caller has to
+ * call be_search.
+ */
+int
+search_fanout_take(struct search_fanout *sf, Slapi_PBlock *pb, Slapi_Backend *be, int *rc)
+{
+    search_fanout_job *job = NULL;
+    Slapi_Operation *operation = NULL;
+    Slapi_Filter *filter = NULL;
+    Slapi_Filter *filter_intent = NULL;
+    Slapi_Filter *old_filter = NULL;
+    void *sr = NULL;
+    int estimate = 0;
+    int err = 0;
+    char *matched = NULL;
+    char *text = NULL;
+
+    if (sf == NULL) {
+        return 0;
+    }
+    for (int i = 0; i < sf->sf_njobs; i++) {
+        if (sf->sf_jobs[i].sj_be == be) {
+            job = &sf->sf_jobs[i];
+            break;
+        }
+    }
+    if (job == NULL) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&search_pool.sp_lock);
+    if (job->sj_state == SEARCH_FANOUT_QUEUED) {
+        search_fanout_unlink_nolock(job);
+        job->sj_state = SEARCH_FANOUT_RUNNING;
+        pthread_mutex_unlock(&search_pool.sp_lock);
+        search_fanout_run(job);
+        pthread_mutex_lock(&search_pool.sp_lock);
+        job->sj_state = SEARCH_FANOUT_DONE;
+    }
+    while (job->sj_state != SEARCH_FANOUT_DONE) {
+        pthread_cond_wait(&sf->sf_cv, &search_pool.sp_lock);
+    }
+    pthread_mutex_unlock(&search_pool.sp_lock);
+
+    if (job->sj_skipped) {
+        return 0;
+    }
+
+    slapi_pblock_get(pb, SLAPI_OPERATION, &operation);
+    slapi_pblock_get(job->sj_pb, SLAPI_SEARCH_RESULT_SET, &sr);
+    slapi_pblock_get(job->sj_pb, SLAPI_SEARCH_RESULT_SET_SIZE_ESTIMATE, &estimate);
+    slapi_pblock_set(job->sj_pb, SLAPI_SEARCH_RESULT_SET, NULL);
+    slapi_pblock_set(pb, SLAPI_SEARCH_RESULT_SET, sr);
+    slapi_pblock_set(pb, SLAPI_SEARCH_RESULT_SET_SIZE_ESTIMATE, &estimate);
+    operation_set_target_entry(operation, operation_get_target_entry(job->sj_op));
+    operation_set_target_entry_id(operation, operation_get_target_entry_id(job->sj_op));
+    operation_set_target_entry(job->sj_op, NULL);
+    operation_set_target_entry_id(job->sj_op, 0);
+    slapi_pblock_set_flag_operation_notes(pb, slapi_pblock_get_operation_notes(job->sj_pb));
+    /*
+     * The backend replaced the filter by the one it executes and kept the
+     * original as the intended one: the next entry function tests them.
+     * The previous filter of pb goes to the job, which frees it.
+     */
+    slapi_pblock_get(pb, SLAPI_SEARCH_FILTER, &old_filter);
+    slapi_pblock_get(job->sj_pb, SLAPI_SEARCH_FILTER, &filter);
+    slapi_pblock_get(job->sj_pb, SLAPI_SEARCH_FILTER_INTENDED, &filter_intent);
+    slapi_pblock_set(job->sj_pb, SLAPI_SEARCH_FILTER, old_filter);
+    slapi_pblock_set(job->sj_pb, SLAPI_SEARCH_FILTER_INTENDED, NULL);
+    slapi_pblock_set(pb, SLAPI_SEARCH_FILTER, filter);
+    slapi_pblock_set(pb, SLAPI_SEARCH_FILTER_INTENDED, filter_intent);
+    search_fanout_take_stat(job, pb);
+
+    *rc = job->sj_rc;
+    if (job->sj_sent) {
+        slapi_pblock_set(pb, SLAPI_RESULT_CODE, &job->sj_err);
+        send_ldap_result(pb, job->sj_err, job->sj_matched, job->sj_text, 0, job->sj_urls);
+    } else if (job->sj_rc != 0) {
+        /* no such object is not sent, it is only set in the pblock */
+        slapi_pblock_get(job->sj_pb, SLAPI_RESULT_CODE, &err);
+        slapi_pblock_get(job->sj_pb, SLAPI_RESULT_MATCHED, &matched);
+        slapi_pblock_get(job->sj_pb, SLAPI_RESULT_TEXT, &text);
+        slapi_set_ldap_result(pb, err, matched, text, 0, NULL);
+    }
+    return 1;
+}
+
+/*
+ * Called by op_shared_search() before unlocking the backends: drop the jobs
+ * no thread took yet, wait for the running ones and release what the search
+ * did not use.
+ */
+void
+search_fanout_done(struct search_fanout **sfp)
+{
+    struct search_fanout *sf = *sfp;
+
+    if (sf == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&search_pool.sp_lock);
+    for (int i = 0; i < sf->sf_njobs; i++) {
+        search_fanout_job *job = &sf->sf_jobs[i];
+
+        if (job->sj_state == SEARCH_FANOUT_QUEUED) {
+            search_fanout_unlink_nolock(job);
+            job->sj_state = SEARCH_FANOUT_DONE;
+        }
+        while (job->sj_state != SEARCH_FANOUT_DONE) {
+            pthread_cond_wait(&sf->sf_cv, &search_pool.sp_lock);
+        }
+    }
+    pthread_mutex_unlock(&search_pool.sp_lock);
+
+    for (int i = 0; i < sf->sf_njobs; i++) {
+        search_fanout_job_done(&sf->sf_jobs[i]);
+    }
+    pthread_cond_destroy(&sf->sf_cv);
+    slapi_ch_free((void **)&sf->sf_jobs);
+    slapi_ch_free((void **)sfp);
+}
+
+/*
+ * Called at shutdown once the worker threads are gone: no search is
+ * running, let the pool threads exit.
+ */
+void
+search_fanout_stop(void)
+{
+    pthread_mutex_lock(&search_pool.sp_lock);
+    search_pool.sp_stopping = 1;
+    pthread_cond_broadcast(&search_pool.sp_cv);
+    pthread_mutex_unlock(&search_pool.sp_lock);
+
+    for (int i = 0; i < search_pool.sp_nthreads; i++) {
+        PR_JoinThread(search_pool.sp_threads[i]);
+    }
+    slapi_ch_free((void **)&search_pool.sp_threads);
+    search_pool.sp_nthreads = 0;
+}
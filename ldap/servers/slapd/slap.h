@@ -306,6 +306,18 @@ typedef void (*VFPV)(); /* takes undefined arguments */
 #define SLAPD_DEFAULT_MAXSIMPLEPAGED_PER_CONN_STR "-1"
 #define SLAPD_DEFAULT_MAXCONTROLS_PER_OP 10
 #define SLAPD_DEFAULT_MAXCONTROLS_PER_OP_STR "10"
+#define SLAPD_DEFAULT_PW_VERIFY_CACHE_SIZE 10000
+#define SLAPD_DEFAULT_PW_VERIFY_CACHE_SIZE_STR "10000"
+#define SLAPD_DEFAULT_PW_VERIFY_CACHE_TTL 300
+#define SLAPD_DEFAULT_PW_VERIFY_CACHE_TTL_STR "300"
+#define SLAPD_DEFAULT_PW_VERIFY_THREADS 4
+#define SLAPD_DEFAULT_PW_VERIFY_THREADS_STR "4"
+#define SLAPD_DEFAULT_WRITEBEHIND_INTERVAL 0
+#define SLAPD_DEFAULT_WRITEBEHIND_INTERVAL_STR "0"
+#define SLAPD_DEFAULT_SEARCH_FANOUT_THREADS 0
+#define SLAPD_DEFAULT_SEARCH_FANOUT_THREADS_STR "0"
+#define SLAPD_DEFAULT_EVENTQ_EXECUTORS 4
+#define SLAPD_DEFAULT_EVENTQ_EXECUTORS_STR "4"
 #define SLAPD_DEFAULT_LDAPSSOTOKEN_TTL 3600
 #define SLAPD_DEFAULT_LDAPSSOTOKEN_TTL_STR "3600"
 
@@ -597,6 +609,7 @@ struct slapi_filter
 #define f_mr_dnAttrs f_un.f_un_extended.mrf_dnAttrs
 
     struct slapi_filter *f_next;
+    struct slapi_filter_prog *f_prog; /* see filterprog.c, only set on the root */
 };
 
 struct csn
@@ -651,6 +664,7 @@ struct slapi_value_set
     size_t max;     /* The number of slots in the array */
     size_t *sorted; /* sorted array of indices, if NULL va is not sorted */
     struct slapi_value **va;
+    uint64_t *shared; /* number of valuesets sharing va, sorted and the values, NULL if not shared */
 };
 
 struct valuearrayfast
@@ -683,6 +697,7 @@ struct slapi_attr
     struct slapdplugin *a_mr_eq_plugin;  /* for the attribute EQUALITY matching rule, if any */
     struct slapdplugin *a_mr_ord_plugin; /* for the attribute ORDERING matching rule, if any */
     struct slapdplugin *a_mr_sub_plugin; /* for the attribute SUBSTRING matching rule, if any */
+    uint32_t a_id;                       /* interned id of the base type, 0 if not known */
 };
 
 typedef struct oid_item
@@ -722,6 +737,7 @@ typedef struct asyntaxinfo
     struct slapdplugin *asi_mr_eq_plugin;  /* EQUALITY matching rule plugin */
     struct slapdplugin *asi_mr_sub_plugin; /* SUBSTR matching rule plugin */
     struct slapdplugin *asi_mr_ord_plugin; /* ORDERING matching rule plugin */
+    uint32_t asi_id;                       /* interned id of asi_name, see attr_syntax_intern_id */
     struct asyntaxinfo *asi_next;
     struct asyntaxinfo *asi_prev;
 } asyntaxinfo;
@@ -2025,6 +2041,18 @@ typedef int (*value_compare_fn_type)(const struct berval *, const struct berval
 /* Definition for plugin syntax validate routine */
 typedef int (*value_validate_fn_type)(const struct berval *);
 
+/* operation phases timed by the latency histograms (latency_stats.c) */
+typedef enum slapd_latency_phase {
+    LATENCY_PHASE_QUEUE,      /* wait in the work queue */
+    LATENCY_PHASE_PREOP,      /* pre-operation plugins */
+    LATENCY_PHASE_CANDIDATES, /* backend candidate list build */
+    LATENCY_PHASE_FETCH,      /* entry fetch from the backend */
+    LATENCY_PHASE_ACL,        /* access control evaluation */
+    LATENCY_PHASE_ENCODE,     /* BER encoding of a search entry */
+    LATENCY_PHASE_FLUSH,      /* write of a PDU to the connection */
+    LATENCY_PHASE_MAX         /* should be the last one */
+} slapd_latency_phase_t;
+
 #include "proto-slap.h"
 LDAPMod **entry2mods(Slapi_Entry *, LDAPMod **, int *, int);
 
@@ -2449,6 +2477,13 @@ typedef struct _slapdEntryPoints
 
 #define CONFIG_MAXSIMPLEPAGED_PER_CONN_ATTRIBUTE "nsslapd-maxsimplepaged-per-conn"
 #define CONFIG_MAXCONTROLS_PER_OP_ATTRIBUTE "nsslapd-maxcontrolsperop"
+#define CONFIG_PW_VERIFY_CACHE_ATTRIBUTE "nsslapd-pwverify-cache"
+#define CONFIG_PW_VERIFY_CACHE_SIZE_ATTRIBUTE "nsslapd-pwverify-cache-size"
+#define CONFIG_PW_VERIFY_CACHE_TTL_ATTRIBUTE "nsslapd-pwverify-cache-ttl"
+#define CONFIG_PW_VERIFY_THREADS_ATTRIBUTE "nsslapd-pwverify-threads"
+#define CONFIG_WRITEBEHIND_INTERVAL_ATTRIBUTE "nsslapd-writebehind-interval"
+#define CONFIG_SEARCH_FANOUT_THREADS_ATTRIBUTE "nsslapd-search-fanout-threads"
+#define CONFIG_EVENTQ_EXECUTORS_ATTRIBUTE "nsslapd-eventq-executors"
 #define CONFIG_LOGGING_BACKEND "nsslapd-logging-backend"
 
 #define CONFIG_EXTRACT_PEM "nsslapd-extract-pemfiles"
@@ -2820,6 +2855,13 @@ typedef struct _slapdFrontendConfig
     char *fgot;
     uint64_t fgot_flags;
     char **ignored_criticality_list;
+    slapi_onoff_t pw_verify_cache;    /* cache the successful simple bind password checks */
+    slapi_int_t pw_verify_cache_size; /* max number of cached checks */
+    slapi_int_t pw_verify_cache_ttl;  /* seconds a cached check is valid */
+    slapi_int_t pw_verify_threads;    /* threads checking the passwords on a cache miss */
+    slapi_int_t writebehind_interval; /* seconds the login tracking updates are buffered, 0: none */
+    slapi_int_t search_fanout_threads; /* threads searching the backends of a multi-backend search */
+    slapi_int_t eventq_executors;      /* threads calling the event queue callbacks */
 } slapdFrontendConfig_t;
 
 /* possible values for slapdFrontendConfig_t.schemareplace */
@@ -5291,6 +5291,21 @@ int slapi_attr_is_last_mod(char *attr);
  */
 void slapi_filter_normalize(Slapi_Filter *f, PRBool norm_values);
 
+/**
+ * Compile a filter for faster evaluation by slapi_vattr_filter_test()
+ * and slapi_filter_test_simple() when no access check is requested.
+ *
+ * Meant for filters tested against many entries. The filter must not be
+ * modified afterwards, except by slapi_filter_normalize() or
+ * slapi_filter_optimise() which drop the compiled form. It is released
+ * with the filter.
+ *
+ * \param f the filter to compile
+ * \return \c 0 on success, or if the filter does not benefit from it.
+ * \return \c -1 if the filter is NULL.
+ */
+int slapi_filter_compile(Slapi_Filter *f);
+
 /**
  * Check whether a given attribute type is defined in schema or not
  *
@@ -6734,6 +6749,7 @@ void slapi_destroy_task(void *arg);
 
 /* Slapi_Counter Interface */
 Slapi_Counter *slapi_counter_new(void);
+Slapi_Counter *slapi_counter_new_sharded(void);
 void slapi_counter_init(Slapi_Counter *counter);
 void slapi_counter_destroy(Slapi_Counter **counter);
 uint64_t slapi_counter_increment(Slapi_Counter *counter);
@@ -7490,6 +7506,15 @@ void slapi_pblock_set_operation_notes(Slapi_PBlock *pb, uint32_t opnotes);
 #define SLAPI_BACKEND_TASK          179
 #define SLAPI_TASK_FLAGS            181
 
+/* db2archive arguments */
+/* SLAPI_DB2ARCHIVE_* flags */
+#define SLAPI_DB2ARCHIVE_FLAGS 157
+/* make an incremental backup, relative to this backup */
+#define SLAPI_DB2ARCHIVE_BASE  158
+/* db2archive flags (these are not pblock args) */
+#define SLAPI_DB2ARCHIVE_COMPACT  0x1 /* compacting copy, cannot be the base of an incremental backup */
+#define SLAPI_DB2ARCHIVE_COMPRESS 0x2 /* gzip the database */
+
 /* bulk import (online wire import) */
 #define SLAPI_BULK_IMPORT_ENTRY 182
 #define SLAPI_BULK_IMPORT_STATE 192
@@ -7560,6 +7585,10 @@ void slapi_pblock_set_operation_notes(Slapi_PBlock *pb, uint32_t opnotes);
 
 /* dbverify */
 #define SLAPI_DBVERIFY_DBDIR 1947
+/* SLAPI_DBVERIFY_* flags */
+#define SLAPI_DBVERIFY_FLAGS 159
+/* dbverify flags (these are not pblock args) */
+#define SLAPI_DBVERIFY_REPAIR 0x1 /* fix the index keys that are found missing or extra */
 
 /* task passed by memberof be_txn_post to the
  * memberof be_post to be pushed in the list
@@ -8453,6 +8482,17 @@ int32_t slapi_atomic_incr_32(int32_t *ptr, int memorder);
  */
 uint64_t slapi_atomic_incr_64(uint64_t *ptr, int memorder);
 
+/**
+ * Add a value to a 64bit integral atomicly
+ *
+ * \param ptr - pointer to integral to add to
+ * \param val - value to add
+ * \param memorder - __ATOMIC_RELAXED, __ATOMIC_CONSUME, __ATOMIC_ACQUIRE,
+ * __ATOMIC_RELEASE, __ATOMIC_ACQ_REL, __ATOMIC_SEQ_CST
+ * \return - new value of ptr
+ */
+uint64_t slapi_atomic_add_64(uint64_t *ptr, uint64_t val, int memorder);
+
 /**
  * Decrement a 32bit integral atomicly
  *
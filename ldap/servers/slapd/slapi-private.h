@@ -397,6 +397,18 @@ char *slapi_filter_to_string(const Slapi_Filter *f, char *buffer, size_t bufsize
 char *slapi_filter_to_string_internal(const struct slapi_filter *f, char *buf, size_t *bufsize);
 void slapi_filter_optimise(Slapi_Filter *f);
 
+/* substrmatch.c */
+typedef struct slapi_substr_matcher Slapi_SubstrMatcher;
+Slapi_SubstrMatcher *slapi_substr_matcher_new(const char *initial, char **any, const char *final, int key);
+void slapi_substr_matcher_free(Slapi_SubstrMatcher **smp);
+int slapi_substr_matcher_get_key(const Slapi_SubstrMatcher *sm);
+int32_t slapi_substr_matcher_exec(const Slapi_SubstrMatcher *sm, const char *val, size_t len);
+
+/* filterprog.c */
+typedef struct slapi_filter_prog Slapi_FilterProg;
+int filter_prog_test(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_FilterProg *prog);
+void filter_prog_free(Slapi_FilterProg **progp);
+
 /* operation.c */
 
 #define OP_FLAG_PS 0x000001
@@ -444,6 +456,9 @@ void slapi_filter_optimise(Slapi_Filter *f);
                                                   * bind rather than a normal password change */
 #define OP_FLAG_SUBENTRIES_FALSE 0x04000000      /* Normal entries are visible and subentries are not */
 #define OP_FLAG_SUBENTRIES_TRUE 0x08000000       /* Subentries are visible and normal entries are not */
+#define OP_FLAG_WRITEBEHIND 0x10000000           /* applies updates buffered by writebehind.c */
+#define OP_FLAG_SEARCH_FANOUT 0x20000000         /* backend part of a search run by search_fanout.c, \
+                                                  * its result is kept for the search */
 
 /* reverse search states */
 #define REV_STARTED 1
@@ -857,6 +872,13 @@ int pw_rever_decode(char *cipher, char **plain, const char *attr_name);
 
 int32_t update_pw_encoding(Slapi_PBlock *orig_pb, Slapi_Entry *e, Slapi_DN *sdn, char *cleartextpassword);
 
+/* pw_verify_cache.c */
+int slapi_pw_verify_cached(const Slapi_DN *sdn, Slapi_Value **vals, const Slapi_Value *cred);
+void slapi_pw_verify_cache_invalidate(const Slapi_DN *sdn);
+
+/* writebehind.c */
+int slapi_writebehind_modify(const Slapi_DN *sdn, LDAPMod **mods, Slapi_ComponentId *identity, int flags);
+
 
 /* config routines */
 
@@ -17,25 +17,68 @@
 
 #include "slap.h"
 
-#ifndef ATOMIC_64BIT_OPERATIONS
 #include <pthread.h>
-#endif
 
 #ifdef HPUX
 #include <machine/sys/inline.h>
 #endif
 
+#ifdef ATOMIC_64BIT_OPERATIONS
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#define SLAPI_COUNTER_MAX_SHARDS 64
+
+/*
+ * A shard of a sharded counter: a cache line of its own, so that the
+ * threads running on different CPUs do not bounce it between them.
+ */
+typedef struct __attribute__((aligned(64))) slapi_counter_shard
+{
+    uint64_t value;
+} slapi_counter_shard;
+
 /*
  * Counter Structure
+ *
+ * A sharded counter has a shard per CPU: add and subtract update the
+ * shard of the CPU the caller runs on, and the value is the sum of
+ * the shards and of the base value, which is what set_value sets.
  */
 typedef struct slapi_counter
 {
     uint64_t value;
+    slapi_counter_shard *shards; /* NULL unless created by slapi_counter_new_sharded() */
 #ifndef ATOMIC_64BIT_OPERATIONS
     pthread_mutex_t _lock;
 #endif
 } slapi_counter;
 
+#ifdef ATOMIC_64BIT_OPERATIONS
+static pthread_once_t counter_shards_once = PTHREAD_ONCE_INIT;
+static uint32_t counter_nshards = 1; /* a power of two */
+
+static void
+counter_shards_init(void)
+{
+    long ncpus = sysconf(_SC_NPROCESSORS_CONF);
+
+    while (counter_nshards < ncpus && counter_nshards < SLAPI_COUNTER_MAX_SHARDS) {
+        counter_nshards <<= 1;
+    }
+}
+
+/* The shard of the CPU the calling thread runs on */
+static inline slapi_counter_shard *
+counter_shard(Slapi_Counter *counter)
+{
+    int cpu = sched_getcpu();
+
+    return &counter->shards[cpu < 0 ? 0 : (uint32_t)cpu & (counter_nshards - 1)];
+}
+#endif
+
 /*
  * slapi_counter_new()
  *
@@ -55,6 +98,42 @@ slapi_counter_new()
     return counter;
 }
 
+/*
+ * slapi_counter_new_sharded()
+ *
+ * Allocates and initializes a new Slapi_Counter that is
+ * split in a shard per CPU. It is meant for the counters
+ * updated by every worker thread: the updates do not share
+ * cache lines, and reading the value sums the shards.
+ *
+ * slapi_counter_add() and the other update functions return
+ * 0 for such a counter, as they do not compute the total: a
+ * counter whose updated value is needed (sequence numbers,
+ * USNs) must be created by slapi_counter_new().
+ *
+ * The shards are summed one by one, not as a snapshot: an
+ * increment and a decrement done on two shards while they
+ * are read can be missed or counted alone.  Only statistics
+ * may be sharded, never a counter waited on to reach a value
+ * (reference or operation counts).
+ */
+Slapi_Counter *
+slapi_counter_new_sharded()
+{
+    Slapi_Counter *counter = slapi_counter_new();
+
+#ifdef ATOMIC_64BIT_OPERATIONS
+    pthread_once(&counter_shards_once, counter_shards_init);
+    if (counter_nshards > 1) {
+        counter->shards = (slapi_counter_shard *)slapi_ch_memalign(counter_nshards * sizeof(slapi_counter_shard),
+                                                                   sizeof(slapi_counter_shard));
+        memset(counter->shards, 0, counter_nshards * sizeof(slapi_counter_shard));
+    }
+#endif
+
+    return counter;
+}
+
 /*
  * slapi_counter_init()
  *
@@ -85,6 +164,7 @@ slapi_counter_destroy(Slapi_Counter **counter)
 #ifndef ATOMIC_64BIT_OPERATIONS
         pthread_mutex_destroy(&((*counter)->_lock));
 #endif
+        slapi_ch_free((void **)&((*counter)->shards));
         slapi_ch_free((void **)counter);
     }
 }
@@ -127,6 +207,10 @@ slapi_counter_add(Slapi_Counter *counter, uint64_t addvalue)
         return newvalue;
     }
 #ifdef ATOMIC_64BIT_OPERATIONS
+    if (counter->shards) {
+        __atomic_add_fetch_8(&(counter_shard(counter)->value), addvalue, __ATOMIC_RELAXED);
+        return newvalue;
+    }
     newvalue = __atomic_add_fetch_8(&(counter->value), addvalue, __ATOMIC_RELAXED);
 #else
 #ifdef HPUX
@@ -181,6 +265,11 @@ slapi_counter_subtract(Slapi_Counter *counter, uint64_t subvalue)
     }
 
 #ifdef ATOMIC_64BIT_OPERATIONS
+    if (counter->shards) {
+        /* a shard may wrap around 0, the sum of the shards does not */
+        __atomic_sub_fetch_8(&(counter_shard(counter)->value), subvalue, __ATOMIC_RELAXED);
+        return newvalue;
+    }
     newvalue = __atomic_sub_fetch_8(&(counter->value), subvalue, __ATOMIC_RELAXED);
 #else
 #ifdef HPUX
@@ -222,7 +311,9 @@ slapi_counter_subtract(Slapi_Counter *counter, uint64_t subvalue)
 /*
  * slapi_counter_set_value()
  *
- * Atomically sets the value of a Slapi_Counter.
+ * Atomically sets the value of a Slapi_Counter. For a
+ * sharded counter, the updates that run concurrently
+ * may be lost.
  */
 uint64_t
 slapi_counter_set_value(Slapi_Counter *counter, uint64_t newvalue)
@@ -234,6 +325,11 @@ slapi_counter_set_value(Slapi_Counter *counter, uint64_t newvalue)
     }
 
 #ifdef ATOMIC_64BIT_OPERATIONS
+    if (counter->shards) {
+        for (uint32_t i = 0; i < counter_nshards; i++) {
+            __atomic_store_8(&(counter->shards[i].value), 0, __ATOMIC_RELAXED);
+        }
+    }
     __atomic_store_8(&(counter->value), newvalue, __ATOMIC_RELAXED);
 #else /* HPUX */
 #ifdef HPUX
@@ -267,6 +363,11 @@ slapi_counter_get_value(Slapi_Counter *counter)
 
 #ifdef ATOMIC_64BIT_OPERATIONS
     value = __atomic_load_8(&(counter->value), __ATOMIC_RELAXED);
+    if (counter->shards) {
+        for (uint32_t i = 0; i < counter_nshards; i++) {
+            value += __atomic_load_8(&(counter->shards[i].value), __ATOMIC_RELAXED);
+        }
+    }
 #else /* HPUX */
 #ifdef HPUX
     do {
@@ -372,6 +473,20 @@ slapi_atomic_incr_64(uint64_t *ptr, int memorder)
 #endif
 }
 
+/*
+ * atomic add function (64bit)
+ */
+uint64_t
+slapi_atomic_add_64(uint64_t *ptr, uint64_t val, int memorder)
+{
+#ifdef ATOMIC_64BIT_OPERATIONS
+    return __atomic_add_fetch_8(ptr, val, memorder);
+#else
+    PRInt32 *pr_ptr = (PRInt32 *)ptr;
+    return PR_AtomicAdd(pr_ptr, (PRInt32)val);
+#endif
+}
+
 /*
  * atomic decrement functions (32bit and 64bit)
  */
@@ -0,0 +1,214 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * substrmatch.c - substring assertion matcher
+ *
+ * A substring filter (attr=initial*any*...*final) used to be turned into the
+ * regex "^initial.*any.*final$" and handed to pcre for each test. The
+ * components are literals, so the matcher below anchors initial and final
+ * and looks for the any components left to right with memchr/memcmp.
+ * It keeps the semantic of the regex it replaces: "." does not match a
+ * newline, and "$" also matches before a trailing newline.
+ */
+
+#include "slap.h"
+
+struct slapi_substr_matcher
+{
+    int sm_key;          /* how the components were prepared, see slapi_substr_matcher_new */
+    char *sm_initial;
+    size_t sm_initial_len;
+    char **sm_any;
+    size_t *sm_any_len;
+    size_t sm_nany;
+    char *sm_final;
+    size_t sm_final_len;
+};
+
+/**
+ * Creates a matcher for a substring assertion.
+ *
+ * \param initial The initial component, or NULL.
+ * \param any The NULL terminated array of any components, or NULL.
+ * \param final The final component, or NULL.
+ * \param key Opaque value telling how the components were normalized, so that
+ * a cached matcher is only reused by callers preparing them the same way.
+ * \return The matcher, to be released by slapi_substr_matcher_free().
+ */
+Slapi_SubstrMatcher *
+slapi_substr_matcher_new(const char *initial, char **any, const char *final, int key)
+{
+    Slapi_SubstrMatcher *sm = (Slapi_SubstrMatcher *)slapi_ch_calloc(1, sizeof(Slapi_SubstrMatcher));
+
+    sm->sm_key = key;
+    if (initial) {
+        sm->sm_initial = slapi_ch_strdup(initial);
+        sm->sm_initial_len = strlen(initial);
+    }
+    if (any) {
+        while (any[sm->sm_nany]) {
+            sm->sm_nany++;
+        }
+        sm->sm_any = (char **)slapi_ch_calloc(sm->sm_nany + 1, sizeof(char *));
+        sm->sm_any_len = (size_t *)slapi_ch_calloc(sm->sm_nany + 1, sizeof(size_t));
+        for (size_t i = 0; i < sm->sm_nany; i++) {
+            sm->sm_any[i] = slapi_ch_strdup(any[i]);
+            sm->sm_any_len[i] = strlen(any[i]);
+        }
+    }
+    if (final) {
+        sm->sm_final = slapi_ch_strdup(final);
+        sm->sm_final_len = strlen(final);
+    }
+    return sm;
+}
+
+void
+slapi_substr_matcher_free(Slapi_SubstrMatcher **smp)
+{
+    Slapi_SubstrMatcher *sm;
+
+    if (smp == NULL || *smp == NULL) {
+        return;
+    }
+    sm = *smp;
+    slapi_ch_free_string(&sm->sm_initial);
+    for (size_t i = 0; i < sm->sm_nany; i++) {
+        slapi_ch_free_string(&sm->sm_any[i]);
+    }
+    slapi_ch_free((void **)&sm->sm_any);
+    slapi_ch_free((void **)&sm->sm_any_len);
+    slapi_ch_free_string(&sm->sm_final);
+    slapi_ch_free((void **)smp);
+}
+
+int
+slapi_substr_matcher_get_key(const Slapi_SubstrMatcher *sm)
+{
+    return sm->sm_key;
+}
+
+/*
+ * Find the first occurrence of pat (of patlen bytes) in s.
+ * memchr is vectorized by the libc, let it find the candidates.
+ */
+static const char *
+substr_find(const char *s, size_t slen, const char *pat, size_t patlen)
+{
+    const char *end;
+
+    if (patlen == 0) {
+        return s;
+    }
+    if (patlen > slen) {
+        return NULL;
+    }
+    end = s + slen - patlen;
+    while (s <= end) {
+        s = memchr(s, pat[0], end - s + 1);
+        if (s == NULL) {
+            return NULL;
+        }
+        if (memcmp(s + 1, pat + 1, patlen - 1) == 0) {
+            return s;
+        }
+        s++;
+    }
+    return NULL;
+}
+
+/* Is there a newline in the gap [from, from + len) ? */
+static int
+substr_gap_has_nl(const char *from, size_t len, int check)
+{
+    return check && len && memchr(from, '\n', len) != NULL;
+}
+
+/* Does final end at end, after pos ? */
+static int
+substr_match_final(const Slapi_SubstrMatcher *sm, const char *val, size_t pos, size_t end, int check)
+{
+    if (end < pos || end - pos < sm->sm_final_len) {
+        return 0;
+    }
+    if (memcmp(val + end - sm->sm_final_len, sm->sm_final, sm->sm_final_len)) {
+        return 0;
+    }
+    return !substr_gap_has_nl(val + pos, end - sm->sm_final_len - pos, check);
+}
+
+/*
+ * Match the any components from the i-th one, and the final component,
+ * after pos. The leftmost occurrence of each any component is the best
+ * candidate: if the gap before it holds a newline, so do the gaps before
+ * the following occurrences.
+ */
+static int
+substr_match_from(const Slapi_SubstrMatcher *sm, const char *val, size_t len, size_t pos, size_t i, int check)
+{
+    for (; i < sm->sm_nany; i++) {
+        const char *p = substr_find(val + pos, len - pos, sm->sm_any[i], sm->sm_any_len[i]);
+
+        if (p == NULL || substr_gap_has_nl(val + pos, p - (val + pos), check)) {
+            return 0;
+        }
+        pos = (p - val) + sm->sm_any_len[i];
+    }
+    if (sm->sm_final) {
+        return substr_match_final(sm, val, pos, len, check) ||
+               (len > 0 && val[len - 1] == '\n' && substr_match_final(sm, val, pos, len - 1, check));
+    }
+    return 1;
+}
+
+/**
+ * Tests a value against the substring assertion.
+ *
+ * \param sm The matcher.
+ * \param val The value, already normalized like the components.
+ * \param len The length of the value.
+ * \return 1 if the value matches, 0 otherwise.
+ */
+int32_t
+slapi_substr_matcher_exec(const Slapi_SubstrMatcher *sm, const char *val, size_t len)
+{
+    /* only values with a newline need the gaps to be checked */
+    int check = (len && memchr(val, '\n', len) != NULL);
+
+    if (sm->sm_initial) {
+        if (len < sm->sm_initial_len || memcmp(val, sm->sm_initial, sm->sm_initial_len)) {
+            return 0;
+        }
+        return substr_match_from(sm, val, len, sm->sm_initial_len, 0, check);
+    }
+    if (sm->sm_nany == 0 || !check) {
+        /* the match can start anywhere */
+        return substr_match_from(sm, val, len, 0, 0, 0);
+    }
+    /*
+     * The match can start anywhere, but it cannot span a newline:
+     * try each occurrence of the first any component.
+     */
+    for (size_t pos = 0; pos < len;) {
+        const char *p = substr_find(val + pos, len - pos, sm->sm_any[0], sm->sm_any_len[0]);
+
+        if (p == NULL) {
+            return 0;
+        }
+        if (substr_match_from(sm, val, len, (p - val) + sm->sm_any_len[0], 1, check)) {
+            return 1;
+        }
+        pos = (p - val) + 1;
+    }
+    return 0;
+}
@@ -1534,8 +1534,11 @@ task_backup_thread(void *arg)
 
     slapi_task_finish(task, rv);
     char *seq_val = NULL;
+    char *archive_base = NULL;
     slapi_pblock_get(pb, SLAPI_SEQ_VAL, &seq_val);
+    slapi_pblock_get(pb, SLAPI_DB2ARCHIVE_BASE, &archive_base);
     slapi_ch_free((void **)&seq_val);
+    slapi_ch_free_string(&archive_base);
     slapi_pblock_destroy(pb);
     g_decr_active_threadcnt();
 }
@@ -1551,10 +1554,12 @@ task_backup_add(Slapi_PBlock *pb __attribute__((unused)),
     Slapi_Backend *be = NULL;
     PRThread *thread = NULL;
     const char *archive_dir = NULL;
+    const char *archive_base = NULL;
     const char *my_database_type = NULL;
     const char *database_type = "ldbm database";
     char *cookie = NULL;
     int rv = SLAPI_DSE_CALLBACK_OK;
+    int archive_flags = 0;
     Slapi_PBlock *mypb = NULL;
     Slapi_Task *task = NULL;
 
@@ -1572,6 +1577,31 @@ task_backup_add(Slapi_PBlock *pb __attribute__((unused)),
         goto out;
     }
 
+    /* backup options: incremental backup, compacting copy, compression */
+    archive_base = slapi_entry_attr_get_ref(e, "nsArchiveIncrementalBase");
+    if (slapi_entry_attr_get_bool(e, "nsArchiveCompact")) {
+        archive_flags |= SLAPI_DB2ARCHIVE_COMPACT;
+    }
+    if (slapi_entry_attr_get_bool(e, "nsArchiveCompress")) {
+        archive_flags |= SLAPI_DB2ARCHIVE_COMPRESS;
+    }
+    if (archive_base && (archive_flags & SLAPI_DB2ARCHIVE_COMPACT)) {
+        PR_snprintf(returntext, SLAPI_DSE_RETURNTEXT_SIZE,
+                "An incremental backup can not be a compacting copy");
+        slapi_log_err(SLAPI_LOG_ERR, "task_backup_add", "Error: %s\n", returntext);
+        *returncode = LDAP_UNWILLING_TO_PERFORM;
+        rv = SLAPI_DSE_CALLBACK_ERROR;
+        goto out;
+    }
+    if (archive_base && (archive_flags & SLAPI_DB2ARCHIVE_COMPRESS)) {
+        PR_snprintf(returntext, SLAPI_DSE_RETURNTEXT_SIZE,
+                "An incremental backup can not be compressed");
+        slapi_log_err(SLAPI_LOG_ERR, "task_backup_add", "Error: %s\n", returntext);
+        *returncode = LDAP_UNWILLING_TO_PERFORM;
+        rv = SLAPI_DSE_CALLBACK_ERROR;
+        goto out;
+    }
+
     /* database type */
     my_database_type = slapi_entry_attr_get_ref(e, "nsDatabaseType");
     if (NULL != my_database_type)
@@ -1622,7 +1652,10 @@ task_backup_add(Slapi_PBlock *pb __attribute__((unused)),
         goto out;
     }
     char *seq_val = slapi_ch_strdup(archive_dir);
+    char *base_val = slapi_ch_strdup(archive_base);
     slapi_pblock_set(mypb, SLAPI_SEQ_VAL, seq_val);
+    slapi_pblock_set(mypb, SLAPI_DB2ARCHIVE_BASE, base_val);
+    slapi_pblock_set(mypb, SLAPI_DB2ARCHIVE_FLAGS, &archive_flags);
     slapi_pblock_set(mypb, SLAPI_PLUGIN, (be->be_database));
     slapi_pblock_set(mypb, SLAPI_BACKEND_TASK, task);
     int32_t task_flags = SLAPI_TASK_RUNNING_AS_TASK;
@@ -1638,6 +1671,7 @@ task_backup_add(Slapi_PBlock *pb __attribute__((unused)),
         *returncode = LDAP_OPERATIONS_ERROR;
         rv = SLAPI_DSE_CALLBACK_ERROR;
         slapi_ch_free((void **)&seq_val);
+        slapi_ch_free_string(&base_val);
         slapi_pblock_destroy(mypb);
         goto out;
     }
@@ -1971,6 +2005,148 @@ out:
     return rv;
 }
 
+static void
+task_dbverify_thread(void *arg)
+{
+    slapi_set_thread_name("dbverify");
+    Slapi_PBlock *pb = (Slapi_PBlock *)arg;
+    char **attrs = NULL;
+    char *report = NULL;
+    Slapi_Task *task = NULL;
+    struct slapdplugin *pb_plugin;
+    int rv;
+
+    slapi_pblock_get(pb, SLAPI_BACKEND_TASK, &task);
+    slapi_pblock_get(pb, SLAPI_PLUGIN, &pb_plugin);
+    slapi_pblock_get(pb, SLAPI_DB2INDEX_ATTRS, &attrs);
+    slapi_pblock_get(pb, SLAPI_SEQ_VAL, &report);
+
+    g_incr_active_threadcnt();
+    slapi_task_begin(task, 1);
+
+    rv = (*pb_plugin->plg_dbverify)(pb);
+    if (rv != 0) {
+        slapi_task_log_notice(task, "Database verification failed (error %d)", rv);
+        slapi_task_log_status(task, "Database verification failed (error %d)", rv);
+        slapi_log_err(SLAPI_LOG_ERR, "task_dbverify_thread", "Database verification failed (error %d)\n", rv);
+    }
+
+    slapi_task_finish(task, rv);
+    charray_free(attrs);
+    slapi_ch_free_string(&report);
+    slapi_pblock_destroy(pb);
+    g_decr_active_threadcnt();
+}
+
+/*
+ * Online index verification: cross-check the entries and the indexes of
+ * a backend, report the differences in nsReportFile and fix them if
+ * nsRepair is set.
+ */
+static int
+task_dbverify_add(Slapi_PBlock *pb __attribute__((unused)),
+                  Slapi_Entry *e,
+                  Slapi_Entry *eAfter __attribute__((unused)),
+                  int *returncode,
+                  char *returntext __attribute__((unused)),
+                  void *arg __attribute__((unused)))
+{
+    const char *instance_name;
+    const char *report;
+    int rv = SLAPI_DSE_CALLBACK_OK;
+    Slapi_Backend *be = NULL;
+    Slapi_Task *task = NULL;
+    Slapi_Attr *attr;
+    Slapi_Value *val = NULL;
+    char **attrs = NULL;
+    int dbverify_flags = 0;
+    int idx;
+    Slapi_PBlock *mypb = NULL;
+    PRThread *thread = NULL;
+
+    *returncode = LDAP_SUCCESS;
+    if (slapi_entry_attr_get_ref(e, "cn") == NULL) {
+        *returncode = LDAP_OBJECT_CLASS_VIOLATION;
+        return SLAPI_DSE_CALLBACK_ERROR;
+    }
+    if ((instance_name = slapi_entry_attr_get_ref(e, "nsInstance")) == NULL) {
+        *returncode = LDAP_OBJECT_CLASS_VIOLATION;
+        return SLAPI_DSE_CALLBACK_ERROR;
+    }
+
+    /* lookup the backend */
+    be = slapi_be_select_by_instance_name(instance_name);
+    if (be == NULL) {
+        slapi_log_err(SLAPI_LOG_ERR, "task_dbverify_add", "Can't verify nonexistent backend %s\n",
+                      instance_name);
+        *returncode = LDAP_NO_SUCH_OBJECT;
+        return SLAPI_DSE_CALLBACK_ERROR;
+    }
+    if (be->be_database->plg_dbverify == NULL) {
+        slapi_log_err(SLAPI_LOG_ERR, "task_dbverify_add", "no dbverify function defined for "
+                                                          "backend %s\n",
+                      be->be_database->plg_name);
+        *returncode = LDAP_UNWILLING_TO_PERFORM;
+        return SLAPI_DSE_CALLBACK_ERROR;
+    }
+
+    /* only verify these indexes (default: all of them) */
+    if (slapi_entry_attr_find(e, "nsIndexAttribute", &attr) == 0) {
+        for (idx = slapi_attr_first_value(attr, &val);
+             idx >= 0; idx = slapi_attr_next_value(attr, idx, &val)) {
+            charray_add(&attrs, slapi_ch_strdup(slapi_value_get_string(val)));
+        }
+    }
+    if (slapi_entry_attr_get_bool(e, "nsRepair")) {
+        dbverify_flags |= SLAPI_DBVERIFY_REPAIR;
+    }
+    report = slapi_entry_attr_get_ref(e, "nsReportFile");
+
+    /* allocate new task now */
+    task = slapi_new_task(slapi_entry_get_ndn(e));
+    if (task == NULL) {
+        slapi_log_err(SLAPI_LOG_ERR, "task_dbverify_add", "Unable to allocate new task!\n");
+        *returncode = LDAP_OPERATIONS_ERROR;
+        rv = SLAPI_DSE_CALLBACK_ERROR;
+        goto out;
+    }
+
+    mypb = slapi_pblock_new();
+    slapi_pblock_set(mypb, SLAPI_BACKEND, be);
+    slapi_pblock_set(mypb, SLAPI_PLUGIN, be->be_database);
+    slapi_pblock_set(mypb, SLAPI_BACKEND_TASK, task);
+    int32_t task_flags = SLAPI_TASK_RUNNING_AS_TASK;
+    slapi_pblock_set(mypb, SLAPI_TASK_FLAGS, &task_flags);
+    slapi_pblock_set(mypb, SLAPI_DB2INDEX_ATTRS, attrs);
+    slapi_pblock_set(mypb, SLAPI_DBVERIFY_FLAGS, &dbverify_flags);
+    slapi_pblock_set(mypb, SLAPI_SEQ_VAL, slapi_ch_strdup(report));
+
+    /* start the verification as a separate thread */
+    thread = PR_CreateThread(PR_USER_THREAD, task_dbverify_thread,
+                             (void *)mypb, PR_PRIORITY_NORMAL, PR_GLOBAL_THREAD,
+                             PR_UNJOINABLE_THREAD, SLAPD_DEFAULT_THREAD_STACKSIZE);
+    if (thread == NULL) {
+        slapi_log_err(SLAPI_LOG_ERR,
+                      "task_dbverify_add", "Unable to create dbverify thread!\n");
+        *returncode = LDAP_OPERATIONS_ERROR;
+        rv = SLAPI_DSE_CALLBACK_ERROR;
+        slapi_pblock_get(mypb, SLAPI_SEQ_VAL, &report);
+        slapi_ch_free_string((char **)&report);
+        slapi_pblock_destroy(mypb);
+        goto out;
+    }
+
+    /* thread successful -- don't free the pb, let the thread do that. */
+    return SLAPI_DSE_CALLBACK_OK;
+
+out:
+    if (task) {
+        destroy_task(1, task);
+    }
+    charray_free(attrs);
+    return rv;
+}
+
 static int
 task_upgradedb_add(Slapi_PBlock *pb __attribute__((unused)),
                    Slapi_Entry *e,
@@ -2866,6 +3042,7 @@ task_init(void)
     slapi_task_register_handler("backup", task_backup_add);
     slapi_task_register_handler("restore", task_restore_add);
     slapi_task_register_handler("index", task_index_add);
+    slapi_task_register_handler("dbverify", task_dbverify_add);
     slapi_task_register_handler("upgradedb", task_upgradedb_add);
     slapi_task_register_handler("sysconfig reload", task_sysconfig_reload_add);
     slapi_task_register_handler("fixup tombstones", task_fixup_tombstones_add);
@@ -402,6 +402,20 @@ tp_stats_publish_gauges(tp_stats_header_t *header, tp_gauges_t *gauges)
     slapi_atomic_store_64(&header->cur_connections, gauges->cur_connections, __ATOMIC_RELAXED);
 }
 
+static void
+tp_stats_publish_latency(tp_stats_header_t *header)
+{
+    tp_latency_hist_t hists[TP_STATS_LATENCY_PHASES];
+
+    latency_stats_collect(hists);
+    for (size_t p = 0; p < TP_STATS_LATENCY_PHASES; p++) {
+        slapi_atomic_store_64(&header->latency[p].sum_ns, hists[p].sum_ns, __ATOMIC_RELAXED);
+        for (size_t b = 0; b < TP_STATS_LATENCY_BUCKETS; b++) {
+            slapi_atomic_store_64(&header->latency[p].buckets[b], hists[p].buckets[b], __ATOMIC_RELAXED);
+        }
+    }
+}
+
 static void
 tp_stats_heartbeat(time_t when __attribute__((unused)), void *arg __attribute__((unused)))
 {
@@ -414,6 +428,7 @@ tp_stats_heartbeat(time_t when __attribute__((unused)), void *arg __attribute__(
 
     tp_collect_gauges(&gauges);
     tp_stats_publish_gauges(header, &gauges);
+    tp_stats_publish_latency(header);
     slapi_atomic_store_64(&header->heartbeat_wall_sec, (uint64_t)slapi_current_utc_time(), __ATOMIC_RELAXED);
     slapi_atomic_store_64(&header->heartbeat_mono_ns, tp_stats_mono_ns(), __ATOMIC_RELEASE);
 }
@@ -557,6 +572,8 @@ tp_stats_init(uint32_t max_workers)
     header->max_workers = max_workers;
     header->server_pid = (uint64_t)getpid();
     header->start_wall_sec = (uint64_t)slapi_current_utc_time();
+    header->latency_phases = TP_STATS_LATENCY_PHASES;
+    header->latency_buckets = TP_STATS_LATENCY_BUCKETS;
 
     tp_stats_header = header;
     tp_stats_fd = fd;
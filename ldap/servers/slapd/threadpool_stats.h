@@ -14,10 +14,13 @@ typedef struct slapi_entry Slapi_Entry;
 
 #define TP_STATS_MAGIC 0x54504f4f4c535431ULL /* "TPOOLST1" */
 #define TP_STATS_VER_MAJOR 1
-#define TP_STATS_VER_MINOR 0
+#define TP_STATS_VER_MINOR 1
 #define TP_STATS_HEADER_SIZE 4096
 #define TP_STATS_WORKER_SLOT_SIZE 64
 #define TP_STATS_ATTR_THREADPOOL_WORKER "threadpoolworker"
+#define TP_STATS_LATENCY_PHASES 7
+#define TP_STATS_LATENCY_BUCKETS 64
+#define TP_STATS_LATENCY_MIN_SHIFT 8
 
 typedef enum {
     TP_WORKER_STATE_UNUSED = 0,
@@ -36,6 +39,20 @@ typedef struct {
     uint64_t cur_connections;
 } tp_gauges_t;
 
+/*
+ * Latency histogram of an operation phase, in nanoseconds (version 1.1).
+ *
+ * Bucket 0 counts the values under 1 << TP_STATS_LATENCY_MIN_SHIFT. Each
+ * power of two above it is split in two buckets: with
+ * e = TP_STATS_LATENCY_MIN_SHIFT + (i - 1) / 2, bucket i > 0 counts the
+ * values from (2 + (i - 1) % 2) << (e - 1) up to, excluded, the start of
+ * bucket i + 1. The last bucket also counts the values above its range.
+ */
+typedef struct tp_latency_hist {
+    uint64_t sum_ns;
+    uint64_t buckets[TP_STATS_LATENCY_BUCKETS];
+} tp_latency_hist_t;
+
 /*
  * Thread-pool status mmap ABI.
  *
@@ -74,7 +91,11 @@ typedef struct tp_stats_header {
     uint64_t ops_initiated;
     uint64_t ops_completed;
     uint64_t cur_connections;
-    uint8_t reserved[3976];
+    /* 1.1: refreshed with the heartbeat, indexed by slapd_latency_phase_t */
+    uint32_t latency_phases;
+    uint32_t latency_buckets;
+    tp_latency_hist_t latency[TP_STATS_LATENCY_PHASES];
+    uint8_t reserved[328];
 } tp_stats_header_t;
 
 _Static_assert(sizeof(tp_worker_slot_t) == TP_STATS_WORKER_SLOT_SIZE,
@@ -92,3 +113,4 @@ void tp_stats_worker_operation_start(uint32_t worker_idx, uint64_t conn_id, uint
 void tp_stats_worker_operation_done(uint32_t worker_idx);
 void tp_stats_worker_exited(uint32_t worker_idx);
 void tp_stats_as_entry(Slapi_Entry *e);
+void latency_stats_collect(tp_latency_hist_t *hists);
@@ -461,6 +461,7 @@ slapi_valueset_init(Slapi_ValueSet *vs)
         vs->sorted = NULL;
         vs->num = 0;
         vs->max = 0;
+        vs->shared = NULL;
     }
 }
 
@@ -469,6 +470,16 @@ slapi_valueset_done(Slapi_ValueSet *vs)
 {
     if (vs != NULL) {
         PR_ASSERT((vs->sorted == NULL) || (vs->num < VALUESET_ARRAY_SORT_THRESHOLD) || ((vs->num >= VALUESET_ARRAY_SORT_THRESHOLD) && (vs->sorted[0] < vs->num)));
+        if (vs->shared != NULL) {
+            if (slapi_atomic_decr_64(vs->shared, __ATOMIC_ACQ_REL) > 0) {
+                /* still used by the other valuesets */
+                vs->va = NULL;
+                vs->sorted = NULL;
+            } else {
+                slapi_ch_free((void **)&vs->shared);
+            }
+            vs->shared = NULL;
+        }
         if (vs->va != NULL) {
             valuearray_free(&vs->va);
             vs->va = NULL;
@@ -542,6 +553,87 @@ slapi_valueset_set_valueset(Slapi_ValueSet *vs1, const Slapi_ValueSet *vs2)
     valueset_set_valueset(vs1, vs2);
 }
 
+/*
+ * Copy-on-write sharing of the values.
+ *
+ * valueset_share() does not copy the values: vs1 shares the value array,
+ * the sorted index and the values of vs2, and vs->shared counts the
+ * valuesets that share them. The functions of this file that modify a
+ * valueset call valueset_unshare() first, which gives it a copy of its
+ * own. slapi_attr_dup() shares the values, so that copying an entry to
+ * modify it, or to keep it as the pre-op or post-op entry, only copies
+ * the attributes that are modified.
+ *
+ * The values reached through the read functions (slapi_valueset_find,
+ * slapi_valueset_first_value, valueset_get_valuearray...) must not be
+ * modified in place, unless valueset_unshare() was called first.
+ */
+
+/* WARNING: like slapi_valueset_set_valueset, vs1 must be new */
+void
+valueset_share(Slapi_ValueSet *vs1, const Slapi_ValueSet *vs2)
+{
+    uint64_t *shared;
+
+    if (vs2->num == 0 || vs2->max == 0) {
+        /* nothing worth sharing, or a valueset that was not created properly */
+        valueset_set_valueset(vs1, vs2);
+        return;
+    }
+
+    /* vs2 may be shared by several threads at once, e.g. a cached entry */
+    shared = __atomic_load_n(&vs2->shared, __ATOMIC_ACQUIRE);
+    if (shared == NULL) {
+        uint64_t *newshared = (uint64_t *)slapi_ch_malloc(sizeof(uint64_t));
+
+        *newshared = 1;
+        if (__atomic_compare_exchange_n(&((Slapi_ValueSet *)vs2)->shared, &shared, newshared, 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            shared = newshared;
+        } else {
+            slapi_ch_free((void **)&newshared);
+        }
+    }
+    slapi_atomic_incr_64(shared, __ATOMIC_ACQ_REL);
+
+    slapi_valueset_done(vs1);
+    vs1->va = vs2->va;
+    vs1->sorted = vs2->sorted;
+    vs1->num = vs2->num;
+    vs1->max = vs2->max;
+    vs1->shared = shared;
+}
+
+/* Make sure that vs owns its values, before it is modified */
+void
+valueset_unshare(Slapi_ValueSet *vs)
+{
+    Slapi_ValueSet copy;
+
+    if (vs == NULL || vs->shared == NULL) {
+        return;
+    }
+    if (slapi_atomic_load_64(vs->shared, __ATOMIC_ACQUIRE) > 1) {
+        slapi_valueset_init(&copy);
+        valueset_set_valueset(&copy, vs);
+        if (slapi_atomic_decr_64(vs->shared, __ATOMIC_ACQ_REL) > 0) {
+            vs->va = copy.va;
+            vs->sorted = copy.sorted;
+            vs->num = copy.num;
+            vs->max = copy.max;
+            vs->shared = NULL;
+            return;
+        }
+        /*
+         * The other valuesets were released meanwhile, keep the originals.
+         * The copy owns its value array and its sorted index, free both.
+         */
+        valuearray_free(&copy.va);
+        slapi_ch_free((void **)&copy.sorted);
+    }
+    slapi_ch_free((void **)&vs->shared);
+}
+
 void
 slapi_valueset_join_attr_valueset(const Slapi_Attr *a, Slapi_ValueSet *vs1, const Slapi_ValueSet *vs2)
 {
@@ -633,6 +725,8 @@ valueset_remove_value_sorted(const Slapi_Attr *a, Slapi_ValueSet *vs, const Slap
     Slapi_Value *r = NULL;
     size_t i = 0;
     size_t position = 0;
+
+    valueset_unshare(vs);
     r = valueset_find_sorted(a, vs, v, &position);
     if (r) {
         /* the value was found, remove from valuearray */
@@ -656,6 +750,8 @@ Slapi_Value *
 valueset_remove_value(const Slapi_Attr *a, Slapi_ValueSet *vs, const Slapi_Value *v)
 {
     Slapi_Value *r = NULL;
+
+    valueset_unshare(vs);
     if (vs->sorted) {
         r = valueset_remove_value_sorted(a, vs, v);
     } else {
@@ -684,6 +780,8 @@ valueset_array_purge(const Slapi_Attr *a, Slapi_ValueSet *vs, const CSN *csn)
     Slapi_Value **va2 = NULL;
     size_t *sorted2 = NULL;
 
+    valueset_unshare(vs);
+
     /* Loop over all the values freeing the old ones. */
     for(i = 0; i < vs->num; i++)
     {
@@ -1116,6 +1214,7 @@ slapi_valueset_add_attr_valuearray_ext(const Slapi_Attr *a, Slapi_ValueSet *vs,
     if (naddvals == 0) {
         return (rc);
     }
+    valueset_unshare(vs);
 
     need = vs->num + naddvals + 1;
     if (need > vs->max) {
@@ -1277,6 +1376,7 @@ valueset_remove_string(const Slapi_Attr *a, Slapi_ValueSet *vs, const char *s)
 void
 valueset_update_csn(Slapi_ValueSet *vs, CSNType t, const CSN *csn)
 {
+    valueset_unshare(vs);
     if (!valuearray_isempty(vs->va)) {
         valuearray_update_csn(vs->va, t, csn);
     }
@@ -1305,6 +1405,8 @@ int
 valueset_remove_valuearray(Slapi_ValueSet *vs, const Slapi_Attr *a, Slapi_Value **valuestodelete, int flags, Slapi_Value ***va_out)
 {
     int rc = LDAP_SUCCESS;
+
+    valueset_unshare(vs);
     if (vs->num > 0) {
         int i;
         struct valuearrayfast vaf_out;
@@ -1451,6 +1553,7 @@ valueset_update_csn_for_valuearray(Slapi_ValueSet *vs, const Slapi_Attr *a, Slap
 void
 valueset_update_csn_for_valuearray_ext(Slapi_ValueSet *vs, const Slapi_Attr *a, Slapi_Value **valuestoupdate, CSNType t, const CSN *csn, Slapi_Value ***valuesupdated, int csnref_updated)
 {
+    valueset_unshare(vs);
     if (!valuearray_isempty(valuestoupdate) &&
         !valuearray_isempty(vs->va)) {
         struct valuearrayfast vaf_valuesupdated;
@@ -114,6 +114,10 @@ struct _vattr_map
 typedef struct _vattr_map vattr_map;
 
 static vattr_map *the_map = NULL;
+/* bumped each time a type is added to the map, see filterprog.c */
+static uint64_t vattr_map_gen = 1;
+/* number of types registered for a split namespace ("suffix::type") */
+static int32_t vattr_map_split_count = 0;
 
 /* Housekeeping Functions, called by server startup/shutdown code */
 
@@ -2124,11 +2128,43 @@ vattr_map_insert(vattr_map_entry *vae)
     /* It's illegal to call this function if the entry is already there */
     PR_ASSERT(NULL == PL_HashTableLookupConst(the_map->hashtable, (void *)vae->type_name));
     PL_HashTableAdd(the_map->hashtable, (void *)vae->type_name, (void *)vae);
+    if (strstr(vae->type_name, "::")) {
+        slapi_atomic_incr_32(&vattr_map_split_count, __ATOMIC_RELEASE);
+    }
+    slapi_atomic_incr_64(&vattr_map_gen, __ATOMIC_RELEASE);
     /* Unlock and we're done */
     slapi_rwlock_unlock(the_map->lock);
     return 0;
 }
 
+/*
+ * Generation of the map, changes each time a type is registered. Types
+ * are never removed from the map.
+ */
+uint64_t
+vattr_map_generation(void)
+{
+    return slapi_atomic_load_64(&vattr_map_gen, __ATOMIC_ACQUIRE);
+}
+
+/*
+ * Returns 0 if no service provider can serve the type with the current
+ * map, whatever the namespace of the entry: vattr_test_filter() would
+ * only look in the entry.
+ */
+int32_t
+vattr_map_type_may_be_virtual(const char *type)
+{
+    vattr_map_entry *result = NULL;
+
+    if (the_map == NULL ||
+        slapi_atomic_load_32(&vattr_map_split_count, __ATOMIC_ACQUIRE) ||
+        vattr_map_lookup(type, &result) == 0) {
+        return 1;
+    }
+    return 0;
+}
+
 /*
     vattr_add_attrval
     -----------------
@@ -0,0 +1,719 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * writebehind.c - write-behind buffer of the login tracking attributes
+ *
+ * Binds update operational attributes of the bind entry: the account policy
+ * plugin records the login time and history, the password policy counts the
+ * failures in passwordRetryCount and retryCountResetTime. Each update was an
+ * internal modify, that is a database transaction and a replicated change,
+ * on nearly every bind.
+ *
+ * When nsslapd-writebehind-interval is not 0, those modifies are kept in a
+ * table instead, keyed by the entry dn and by the component doing them.
+ * Only replacements are buffered, so that a later value of an attribute
+ * supersedes the pending one. Every interval a thread applies the table:
+ * one internal modify per entry and component, carrying all the attributes
+ * changed since the previous flush, replicated as a single update.
+ *
+ * The pending values are visible right away: the entries returned by the
+ * searches, internal ones included, are copies on which the pending values
+ * are laid. The filters are still evaluated against the stored values.
+ *
+ * A modify of the entry drops the pending values of the attributes it
+ * changes, so that they cannot overwrite it later. A delete drops all of
+ * them, a rename applies them first. The updates locking an account are not
+ * buffered by their callers.
+ *
+ * The flush thread builds the modify of a record just before applying it,
+ * and a modify of the entry could commit in between. To keep its values,
+ * such a modify holds a guard on the entry dn from before the backend
+ * modify until its pending values are dropped. The flush waits for the
+ * guards of a dn before building its modify, and a modify starting while
+ * the flush applies the dn waits for the flush.
+ *
+ * The tables are read under a read lock, so that the searches laying the
+ * pending values on the returned entries don't serialize.
+ */
+
+#include "slap.h"
+
+#define WB_MAX_RECORDS 100000 /* beyond, the updates are applied synchronously */
+
+typedef struct wb_attr
+{
+    char *wa_type;
+    struct berval **wa_vals; /* NULL removes the attribute */
+    struct wb_attr *wa_next;
+} wb_attr;
+
+typedef struct wb_guard
+{
+    char *wg_ndn;
+    int wg_holders;  /* modifies of the entry in progress */
+    int wg_flushing; /* the flush thread is applying the entry */
+    pthread_t wg_flusher;
+} wb_guard;
+
+typedef struct wb_record
+{
+    char *wr_ndn;
+    Slapi_ComponentId *wr_identity;
+    int wr_flags;
+    wb_attr *wr_attrs;
+    struct wb_record *wr_next; /* next record of the same dn */
+} wb_record;
+
+/*
+ * wb_lock protects the thread state and the guards, wb_table_lock the
+ * tables and their records. wb_lock is always taken first.
+ */
+static struct
+{
+    pthread_mutex_t wb_lock;
+    pthread_cond_t wb_cv;
+    pthread_cond_t wb_guard_cv;
+    PLHashTable *wb_guards; /* ndn -> wb_guard */
+    pthread_rwlock_t wb_table_lock;
+    PLHashTable *wb_pending;  /* ndn -> wb_record list, the new updates */
+    PLHashTable *wb_flushing; /* ndn -> wb_record list, the batch being applied */
+    uint64_t wb_count;        /* records in wb_pending */
+    uint64_t wb_inflight;     /* records in wb_flushing */
+    PRThread *wb_thread;
+    int wb_started;
+    int wb_stopping;
+} wb = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL,
+        PTHREAD_RWLOCK_INITIALIZER, NULL, NULL, 0, 0, NULL, 0, 0};
+
+static void
+wb_attr_free(wb_attr **wap)
+{
+    wb_attr *wa = *wap;
+
+    if (wa) {
+        slapi_ch_free_string(&wa->wa_type);
+        ber_bvecfree(wa->wa_vals);
+        slapi_ch_free((void **)wap);
+    }
+}
+
+static void
+wb_record_free(wb_record **wrp)
+{
+    wb_record *wr = *wrp;
+
+    if (wr) {
+        while (wr->wr_attrs) {
+            wb_attr *wa = wr->wr_attrs;
+            wr->wr_attrs = wa->wa_next;
+            wb_attr_free(&wa);
+        }
+        slapi_ch_free_string(&wr->wr_ndn);
+        slapi_ch_free((void **)wrp);
+    }
+}
+
+static PRIntn
+wb_table_free_cb(PLHashEntry *he, PRIntn index __attribute__((unused)), void *arg __attribute__((unused)))
+{
+    wb_record *wr = (wb_record *)he->value;
+
+    while (wr) {
+        wb_record *next = wr->wr_next;
+        wb_record_free(&wr);
+        wr = next;
+    }
+    return HT_ENUMERATE_REMOVE;
+}
+
+static void
+wb_table_free(PLHashTable **tablep)
+{
+    if (*tablep) {
+        PL_HashTableEnumerateEntries(*tablep, wb_table_free_cb, NULL);
+        PL_HashTableDestroy(*tablep);
+        *tablep = NULL;
+    }
+}
+
+/* The key is the wr_ndn of the first record of the list */
+static void
+wb_table_set(PLHashTable *table, const char *ndn, wb_record *list)
+{
+    PL_HashTableRemove(table, ndn);
+    if (list) {
+        PL_HashTableAdd(table, list->wr_ndn, list);
+    }
+}
+
+/* Called with wb_lock held */
+static wb_guard *
+wb_guard_get_nolock(const char *ndn)
+{
+    wb_guard *wg;
+
+    if (wb.wb_guards == NULL) {
+        wb.wb_guards = PL_NewHashTable(64, PL_HashString, PL_CompareStrings,
+                                       PL_CompareValues, NULL, NULL);
+    }
+    wg = (wb_guard *)PL_HashTableLookup(wb.wb_guards, ndn);
+    if (wg == NULL) {
+        wg = (wb_guard *)slapi_ch_calloc(1, sizeof(wb_guard));
+        wg->wg_ndn = slapi_ch_strdup(ndn);
+        PL_HashTableAdd(wb.wb_guards, wg->wg_ndn, wg);
+    }
+    return wg;
+}
+
+/* Called with wb_lock held, frees the guard once unused */
+static void
+wb_guard_put_nolock(wb_guard *wg)
+{
+    if (wg->wg_holders == 0 && !wg->wg_flushing) {
+        PL_HashTableRemove(wb.wb_guards, wg->wg_ndn);
+        slapi_ch_free_string(&wg->wg_ndn);
+        slapi_ch_free((void **)&wg);
+    }
+    pthread_cond_broadcast(&wb.wb_guard_cv);
+}
+
+static struct berval **
+wb_mod_values(LDAPMod *mod)
+{
+    struct berval **bvals = NULL;
+    size_t n = 0;
+
+    if (mod->mod_op & LDAP_MOD_BVALUES) {
+        if (mod->mod_bvalues && mod->mod_bvalues[0]) {
+            bvals = slapi_ch_bvecdup(mod->mod_bvalues);
+        }
+        return bvals;
+    }
+    while (mod->mod_values && mod->mod_values[n]) {
+        n++;
+    }
+    if (n) {
+        bvals = (struct berval **)slapi_ch_calloc(n + 1, sizeof(struct berval *));
+        for (size_t i = 0; i < n; i++) {
+            bvals[i] = (struct berval *)slapi_ch_malloc(sizeof(struct berval));
+            bvals[i]->bv_val = slapi_ch_strdup(mod->mod_values[i]);
+            bvals[i]->bv_len = strlen(mod->mod_values[i]);
+        }
+    }
+    return bvals;
+}
+
+/* Only the replacements can be superseded by a later update */
+static int
+wb_mods_bufferable(LDAPMod **mods)
+{
+    if (mods == NULL || mods[0] == NULL) {
+        return 0;
+    }
+    for (size_t i = 0; mods[i]; i++) {
+        if ((mods[i]->mod_op & ~LDAP_MOD_BVALUES) != LDAP_MOD_REPLACE) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int
+wb_apply(const Slapi_DN *sdn, LDAPMod **mods, Slapi_ComponentId *identity, int flags)
+{
+    Slapi_PBlock *pb = slapi_pblock_new();
+    int rc = LDAP_SUCCESS;
+
+    slapi_modify_internal_set_pb_ext(pb, sdn, mods, NULL, NULL, identity, flags);
+    slapi_modify_internal_pb(pb);
+    slapi_pblock_get(pb, SLAPI_PLUGIN_INTOP_RESULT, &rc);
+    slapi_pblock_destroy(pb);
+    return rc;
+}
+
+/* Builds the modify of a record, under wb_table_lock */
+static void
+wb_record_mods(wb_record *wr, Slapi_Mods *smods)
+{
+    slapi_mods_init(smods, 0);
+    for (wb_attr *wa = wr->wr_attrs; wa; wa = wa->wa_next) {
+        slapi_mods_add_modbvps(smods, LDAP_MOD_REPLACE, wa->wa_type, wa->wa_vals);
+    }
+}
+
+static void
+wb_record_apply(wb_record *wr, Slapi_Mods *smods)
+{
+    Slapi_DN sdn;
+    int rc;
+
+    if (slapi_mods_get_num_mods(smods) == 0) {
+        /* all its attributes were modified since */
+        return;
+    }
+    slapi_sdn_init_ndn_byref(&sdn, wr->wr_ndn);
+    rc = wb_apply(&sdn, slapi_mods_get_ldapmods_byref(smods), wr->wr_identity,
+                  wr->wr_flags | OP_FLAG_WRITEBEHIND);
+    if (rc != LDAP_SUCCESS && rc != LDAP_NO_SUCH_OBJECT) {
+        slapi_log_err(SLAPI_LOG_WARNING, "writebehind_flush",
+                      "Modify error %d on entry '%s'\n", rc, wr->wr_ndn);
+    }
+    slapi_sdn_done(&sdn);
+}
+
+typedef struct wb_batch
+{
+    wb_record **records;
+    size_t count;
+} wb_batch;
+
+static PRIntn
+wb_batch_cb(PLHashEntry *he, PRIntn index __attribute__((unused)), void *arg)
+{
+    wb_batch *batch = (wb_batch *)arg;
+
+    for (wb_record *wr = (wb_record *)he->value; wr; wr = wr->wr_next) {
+        batch->records[batch->count++] = wr;
+    }
+    return HT_ENUMERATE_NEXT;
+}
+
+/*
+ * Applies the pending table. It stays visible as wb_flushing until all its
+ * records are applied.
+ */
+static void
+wb_flush(void)
+{
+    wb_batch batch = {0};
+
+    pthread_rwlock_wrlock(&wb.wb_table_lock);
+    if (wb.wb_pending == NULL || wb.wb_count == 0) {
+        pthread_rwlock_unlock(&wb.wb_table_lock);
+        return;
+    }
+    wb.wb_flushing = wb.wb_pending;
+    batch.records = (wb_record **)slapi_ch_calloc(wb.wb_count, sizeof(wb_record *));
+    PL_HashTableEnumerateEntries(wb.wb_flushing, wb_batch_cb, &batch);
+    wb.wb_pending = PL_NewHashTable(64, PL_HashString, PL_CompareStrings,
+                                    PL_CompareValues, NULL, NULL);
+    slapi_atomic_store_64(&wb.wb_inflight, batch.count, __ATOMIC_RELEASE);
+    slapi_atomic_store_64(&wb.wb_count, 0, __ATOMIC_RELEASE);
+    pthread_rwlock_unlock(&wb.wb_table_lock);
+
+    slapi_log_err(SLAPI_LOG_TRACE, "writebehind_flush", "Applying %lu updates\n",
+                  (unsigned long)batch.count);
+    for (size_t i = 0; i < batch.count; i++) {
+        Slapi_Mods smods;
+        wb_guard *wg;
+
+        /* wait for the modifies of the entry, then keep new ones out */
+        pthread_mutex_lock(&wb.wb_lock);
+        /* an unused guard is freed, get it again after waiting */
+        while ((wg = wb_guard_get_nolock(batch.records[i]->wr_ndn))->wg_holders || wg->wg_flushing) {
+            pthread_cond_wait(&wb.wb_guard_cv, &wb.wb_lock);
+        }
+        wg->wg_flushing = 1;
+        wg->wg_flusher = pthread_self();
+        pthread_rwlock_rdlock(&wb.wb_table_lock);
+        wb_record_mods(batch.records[i], &smods);
+        pthread_rwlock_unlock(&wb.wb_table_lock);
+        pthread_mutex_unlock(&wb.wb_lock);
+
+        wb_record_apply(batch.records[i], &smods);
+        slapi_mods_done(&smods);
+
+        pthread_mutex_lock(&wb.wb_lock);
+        wg->wg_flushing = 0;
+        wb_guard_put_nolock(wg);
+        pthread_mutex_unlock(&wb.wb_lock);
+    }
+
+    pthread_rwlock_wrlock(&wb.wb_table_lock);
+    wb_table_free(&wb.wb_flushing);
+    slapi_atomic_store_64(&wb.wb_inflight, 0, __ATOMIC_RELEASE);
+    pthread_rwlock_unlock(&wb.wb_table_lock);
+    slapi_ch_free((void **)&batch.records);
+}
+
+static void
+writebehind_thread(void *arg __attribute__((unused)))
+{
+    slapi_set_thread_name("writebehind");
+
+    pthread_mutex_lock(&wb.wb_lock);
+    while (!wb.wb_stopping) {
+        int32_t interval = config_get_writebehind_interval();
+        struct timespec deadline;
+
+        /* once disabled, what is left is applied within a second */
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += interval ? interval : 1;
+        while (!wb.wb_stopping &&
+               pthread_cond_timedwait(&wb.wb_cv, &wb.wb_lock, &deadline) != ETIMEDOUT) {
+            ;
+        }
+        pthread_mutex_unlock(&wb.wb_lock);
+        wb_flush();
+        pthread_mutex_lock(&wb.wb_lock);
+    }
+    pthread_mutex_unlock(&wb.wb_lock);
+}
+
+/* Called with wb_lock held */
+static int
+wb_start_nolock(void)
+{
+    pthread_condattr_t condAttr;
+
+    if (wb.wb_started) {
+        return wb.wb_thread != NULL;
+    }
+    wb.wb_started = 1;
+    pthread_condattr_init(&condAttr);
+    pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);
+    pthread_cond_init(&wb.wb_cv, &condAttr);
+    pthread_condattr_destroy(&condAttr);
+    pthread_rwlock_wrlock(&wb.wb_table_lock);
+    wb.wb_pending = PL_NewHashTable(64, PL_HashString, PL_CompareStrings,
+                                    PL_CompareValues, NULL, NULL);
+    pthread_rwlock_unlock(&wb.wb_table_lock);
+    wb.wb_thread = PR_CreateThread(PR_USER_THREAD, writebehind_thread, NULL,
+                                   PR_PRIORITY_NORMAL, PR_GLOBAL_THREAD,
+                                   PR_JOINABLE_THREAD, SLAPD_DEFAULT_THREAD_STACKSIZE);
+    if (wb.wb_thread == NULL) {
+        PRErrorCode prerr = PR_GetError();
+        slapi_log_err(SLAPI_LOG_ERR, "writebehind_start", "PR_CreateThread() failed: "
+                      SLAPI_COMPONENT_NAME_NSPR " error %d (%s)\n",
+                      prerr, slapd_pr_strerror(prerr));
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Modifies an entry, possibly later.
+ *
+ * When the write-behind buffer is enabled and all the mods are replacements,
+ * they are recorded and the function returns. They are applied with the
+ * other updates recorded for the entry by the same component, as a single
+ * internal modify, within nsslapd-writebehind-interval seconds. Otherwise
+ * the modify is applied now.
+ *
+ * \param sdn The entry to modify.
+ * \param mods The modifications, left untouched.
+ * \param identity The plugin identity of the internal modify.
+ * \param flags The operation flags of the internal modify.
+ * \return LDAP_SUCCESS once recorded, or the result of the modify.
+ */
+int
+slapi_writebehind_modify(const Slapi_DN *sdn, LDAPMod **mods, Slapi_ComponentId *identity, int flags)
+{
+    const char *ndn = slapi_sdn_get_ndn(sdn);
+    wb_record *list;
+    wb_record *wr;
+
+    if (ndn == NULL || config_get_writebehind_interval() == 0 || !wb_mods_bufferable(mods)) {
+        return wb_apply(sdn, mods, identity, flags);
+    }
+
+    pthread_mutex_lock(&wb.wb_lock);
+    if (wb.wb_stopping || !wb_start_nolock() ||
+        slapi_atomic_load_64(&wb.wb_count, __ATOMIC_ACQUIRE) >= WB_MAX_RECORDS) {
+        pthread_mutex_unlock(&wb.wb_lock);
+        return wb_apply(sdn, mods, identity, flags);
+    }
+    pthread_rwlock_wrlock(&wb.wb_table_lock);
+    list = (wb_record *)PL_HashTableLookup(wb.wb_pending, ndn);
+    for (wr = list; wr; wr = wr->wr_next) {
+        if (wr->wr_identity == identity && wr->wr_flags == flags) {
+            break;
+        }
+    }
+    if (wr == NULL) {
+        wr = (wb_record *)slapi_ch_calloc(1, sizeof(wb_record));
+        wr->wr_ndn = slapi_ch_strdup(ndn);
+        wr->wr_identity = identity;
+        wr->wr_flags = flags;
+        wr->wr_next = list;
+        wb_table_set(wb.wb_pending, ndn, wr);
+        slapi_atomic_incr_64(&wb.wb_count, __ATOMIC_RELEASE);
+    }
+    for (size_t i = 0; mods[i]; i++) {
+        wb_attr *wa;
+
+        for (wa = wr->wr_attrs; wa; wa = wa->wa_next) {
+            if (slapi_attr_type_cmp(wa->wa_type, mods[i]->mod_type, SLAPI_TYPE_CMP_SUBTYPE) == 0) {
+                break;
+            }
+        }
+        if (wa == NULL) {
+            wa = (wb_attr *)slapi_ch_calloc(1, sizeof(wb_attr));
+            wa->wa_type = slapi_ch_strdup(mods[i]->mod_type);
+            wa->wa_next = wr->wr_attrs;
+            wr->wr_attrs = wa;
+        } else {
+            ber_bvecfree(wa->wa_vals);
+        }
+        wa->wa_vals = wb_mod_values(mods[i]);
+    }
+    pthread_rwlock_unlock(&wb.wb_table_lock);
+    pthread_mutex_unlock(&wb.wb_lock);
+
+    return LDAP_SUCCESS;
+}
+
+static int
+wb_has_records(void)
+{
+    return slapi_atomic_load_64(&wb.wb_count, __ATOMIC_ACQUIRE) ||
+           slapi_atomic_load_64(&wb.wb_inflight, __ATOMIC_ACQUIRE);
+}
+
+static void
+wb_overlay_list(wb_record *wr, Slapi_Entry *e)
+{
+    for (; wr; wr = wr->wr_next) {
+        for (wb_attr *wa = wr->wr_attrs; wa; wa = wa->wa_next) {
+            slapi_entry_attr_delete(e, wa->wa_type);
+            if (wa->wa_vals) {
+                slapi_entry_attr_merge(e, wa->wa_type, wa->wa_vals);
+            }
+        }
+    }
+}
+
+/*
+ * Lays the pending values of the entry on *copy, which is set to a copy of
+ * e if it is NULL. Returns 1 if there was something to lay.
+ */
+int
+writebehind_overlay(const Slapi_Entry *e, Slapi_Entry **copy)
+{
+    const char *ndn = slapi_entry_get_ndn((Slapi_Entry *)e);
+    wb_record *flushing = NULL;
+    wb_record *pending = NULL;
+
+    if (!wb_has_records() || ndn == NULL) {
+        return 0;
+    }
+    pthread_rwlock_rdlock(&wb.wb_table_lock);
+    if (wb.wb_flushing) {
+        flushing = (wb_record *)PL_HashTableLookup(wb.wb_flushing, ndn);
+    }
+    if (wb.wb_pending) {
+        pending = (wb_record *)PL_HashTableLookup(wb.wb_pending, ndn);
+    }
+    if (flushing || pending) {
+        if (*copy == NULL) {
+            *copy = slapi_entry_dup(e);
+        }
+        /* the pending values are the most recent */
+        wb_overlay_list(flushing, *copy);
+        wb_overlay_list(pending, *copy);
+    }
+    pthread_rwlock_unlock(&wb.wb_table_lock);
+
+    return (flushing || pending);
+}
+
+/* Removes the attributes of the record set by mods, or all of them if mods is NULL */
+static void
+wb_drop_attrs(wb_record *wr, LDAPMod **mods)
+{
+    wb_attr **wap = &wr->wr_attrs;
+
+    while (*wap) {
+        wb_attr *wa = *wap;
+        int drop = (mods == NULL);
+
+        for (size_t i = 0; !drop && mods[i]; i++) {
+            drop = (slapi_attr_type_cmp(wa->wa_type, mods[i]->mod_type, SLAPI_TYPE_CMP_SUBTYPE) == 0);
+        }
+        if (drop) {
+            *wap = wa->wa_next;
+            wb_attr_free(&wa);
+        } else {
+            wap = &wa->wa_next;
+        }
+    }
+}
+
+/* Called with wb_table_lock write locked */
+static void
+wb_drop_nolock(const char *ndn, LDAPMod **mods)
+{
+    wb_record *list;
+
+    if (wb.wb_flushing) {
+        /* the batch holds pointers on its records, they are only emptied */
+        list = (wb_record *)PL_HashTableLookup(wb.wb_flushing, ndn);
+        for (wb_record *wr = list; wr; wr = wr->wr_next) {
+            wb_drop_attrs(wr, mods);
+        }
+    }
+    if (wb.wb_pending && (list = (wb_record *)PL_HashTableLookup(wb.wb_pending, ndn)) != NULL) {
+        wb_record **wrp = &list;
+
+        /* the key belongs to the first record, which may go away */
+        PL_HashTableRemove(wb.wb_pending, ndn);
+        while (*wrp) {
+            wb_record *wr = *wrp;
+
+            wb_drop_attrs(wr, mods);
+            if (wr->wr_attrs == NULL) {
+                *wrp = wr->wr_next;
+                wb_record_free(&wr);
+                slapi_atomic_decr_64(&wb.wb_count, __ATOMIC_RELEASE);
+            } else {
+                wrp = &wr->wr_next;
+            }
+        }
+        if (list) {
+            PL_HashTableAdd(wb.wb_pending, list->wr_ndn, list);
+        }
+    }
+}
+
+/* The entry is being deleted: forget its pending values */
+void
+writebehind_drop(const Slapi_DN *sdn)
+{
+    const char *ndn = slapi_sdn_get_ndn(sdn);
+
+    if (!wb_has_records() || ndn == NULL) {
+        return;
+    }
+    pthread_rwlock_wrlock(&wb.wb_table_lock);
+    wb_drop_nolock(ndn, NULL);
+    pthread_rwlock_unlock(&wb.wb_table_lock);
+}
+
+/*
+ * The entry is going to be modified: until writebehind_release(), the flush
+ * thread does not apply its pending values. Returns the key of the guard,
+ * or NULL if nothing is pending.
+ */
+char *
+writebehind_hold(const Slapi_DN *sdn)
+{
+    const char *ndn = slapi_sdn_get_ndn(sdn);
+    wb_guard *wg;
+
+    if (!wb_has_records() || ndn == NULL) {
+        return NULL;
+    }
+    pthread_mutex_lock(&wb.wb_lock);
+    /* the plugins called by the modify of the flush don't wait for it */
+    while ((wg = wb_guard_get_nolock(ndn))->wg_flushing &&
+           !pthread_equal(wg->wg_flusher, pthread_self())) {
+        pthread_cond_wait(&wb.wb_guard_cv, &wb.wb_lock);
+    }
+    wg->wg_holders++;
+    pthread_mutex_unlock(&wb.wb_lock);
+
+    return slapi_ch_strdup(ndn);
+}
+
+/*
+ * The modify of the entry is over. If it succeeded (mods), the pending
+ * values of the attributes it changed are superseded and dropped.
+ */
+void
+writebehind_release(char **ndnp, LDAPMod **mods)
+{
+    wb_guard *wg;
+
+    if (*ndnp == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&wb.wb_lock);
+    if (mods) {
+        pthread_rwlock_wrlock(&wb.wb_table_lock);
+        wb_drop_nolock(*ndnp, mods);
+        pthread_rwlock_unlock(&wb.wb_table_lock);
+    }
+    wg = (wb_guard *)PL_HashTableLookup(wb.wb_guards, *ndnp);
+    if (wg) {
+        wg->wg_holders--;
+        wb_guard_put_nolock(wg);
+    }
+    pthread_mutex_unlock(&wb.wb_lock);
+    slapi_ch_free_string(ndnp);
+}
+
+/* The entry is being renamed: apply its pending values first */
+void
+writebehind_flush_dn(const Slapi_DN *sdn)
+{
+    const char *ndn = slapi_sdn_get_ndn(sdn);
+    wb_record *list = NULL;
+    Slapi_Mods *smods = NULL;
+    size_t count = 0;
+    size_t i = 0;
+
+    if (!slapi_atomic_load_64(&wb.wb_count, __ATOMIC_ACQUIRE) || ndn == NULL) {
+        return;
+    }
+    pthread_rwlock_wrlock(&wb.wb_table_lock);
+    if (wb.wb_pending && (list = (wb_record *)PL_HashTableLookup(wb.wb_pending, ndn)) != NULL) {
+        PL_HashTableRemove(wb.wb_pending, ndn);
+        for (wb_record *wr = list; wr; wr = wr->wr_next) {
+            count++;
+        }
+        smods = (Slapi_Mods *)slapi_ch_calloc(count, sizeof(Slapi_Mods));
+        for (wb_record *wr = list; wr; wr = wr->wr_next, i++) {
+            wb_record_mods(wr, &smods[i]);
+            slapi_atomic_decr_64(&wb.wb_count, __ATOMIC_RELEASE);
+        }
+    }
+    pthread_rwlock_unlock(&wb.wb_table_lock);
+
+    i = 0;
+    while (list) {
+        wb_record *next = list->wr_next;
+
+        wb_record_apply(list, &smods[i]);
+        slapi_mods_done(&smods[i++]);
+        wb_record_free(&list);
+        list = next;
+    }
+    slapi_ch_free((void **)&smods);
+}
+
+/* Applies what is left, the updates are made synchronously from now on */
+void
+writebehind_stop(void)
+{
+    pthread_mutex_lock(&wb.wb_lock);
+    wb.wb_stopping = 1;
+    pthread_cond_signal(&wb.wb_cv);
+    pthread_mutex_unlock(&wb.wb_lock);
+
+    if (wb.wb_thread) {
+        (void)PR_JoinThread(wb.wb_thread);
+        wb.wb_thread = NULL;
+    }
+    wb_flush();
+
+    pthread_rwlock_wrlock(&wb.wb_table_lock);
+    wb_table_free(&wb.wb_pending);
+    pthread_rwlock_unlock(&wb.wb_table_lock);
+
+    pthread_mutex_lock(&wb.wb_lock);
+    if (wb.wb_guards && wb.wb_guards->nentries == 0) {
+        PL_HashTableDestroy(wb.wb_guards);
+        wb.wb_guards = NULL;
+    }
+    pthread_mutex_unlock(&wb.wb_lock);
+}
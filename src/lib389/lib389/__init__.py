@@ -2978,11 +2978,16 @@ class DirSrv(SimpleLDAPObject, object):
 
         return True
 
-    def db2bak(self, archive_dir, watch=False):
+    def db2bak(self, archive_dir, watch=False, incremental_base=None, compact=False, compress=False):
         """
         @param archive_dir - The directory to write the backup to
+        @param incremental_base - Only backup the pages changed since this backup (lmdb)
+        @param compact - Compact the database copy (lmdb)
+        @param compress - Compress the database copy (lmdb), not with incremental_base
         @return - True if the backup succeeded
         """
+        if incremental_base and compress:
+            raise ValueError("An incremental backup can not be compressed")
         DirSrvTools.lib389User(user=DEFAULT_USER)
         prog = os.path.join(self.ds_paths.sbin_dir, 'ns-slapd')
 
@@ -3003,6 +3008,12 @@ class DirSrv(SimpleLDAPObject, object):
                    'db2archive',
                    '-a', archive_dir,
                    '-D', self.get_config_dir()]
+            if incremental_base:
+                cmd.extend(['-b', incremental_base])
+            if compact:
+                cmd.append('-k')
+            if compress:
+                cmd.append('-z')
             if watch:
                 cmd.append('-V')
             result = subprocess.check_output(cmd, encoding='utf-8')
@@ -3604,8 +3615,11 @@ class DirSrv(SimpleLDAPObject, object):
             self.log.debug("Delete entry children %s", ent.dn)
             self.delete_ext_s(ent.dn, serverctrls=serverctrls, clientctrls=clientctrls, escapehatch='i am sure')
 
-    def backup_online(self, archive=None, db_type=None):
-        """Creates a backup of the database"""
+    def backup_online(self, archive=None, db_type=None, incremental_base=None, compact=False, compress=False):
+        """Creates a backup of the database, incremental_base, compact and compress are lmdb only"""
+
+        if incremental_base is not None and compress:
+            raise ValueError("An incremental backup can not be compressed")
 
         if archive is None:
             # Use the instance name and date/time as the default backup name
@@ -3623,6 +3637,12 @@ class DirSrv(SimpleLDAPObject, object):
         task_properties = {'nsArchiveDir': archive}
         if db_type is not None:
             task_properties['nsDatabaseType'] = db_type
+        if incremental_base is not None:
+            task_properties['nsArchiveIncrementalBase'] = incremental_base
+        if compact:
+            task_properties['nsArchiveCompact'] = 'on'
+        if compress:
+            task_properties['nsArchiveCompress'] = 'on'
         task.create(properties=task_properties)
 
         return task
@@ -1451,6 +1451,12 @@ class DatabaseConfig(DSLdapObject):
         'nsslapd-pagedlookthroughlimit',
         'nsslapd-pagedidlistscanlimit',
         'nsslapd-rangelookthroughlimit',
+        'nsslapd-search-readahead',
+        'nsslapd-cache-autotune-interval',
+        'nsslapd-cache-warmup',
+        'nsslapd-cache-warmup-interval',
+        'nsslapd-cache-warmup-threads',
+        'nsslapd-cache-warmup-rate',
         'nsslapd-backend-opt-level',
         'nsslapd-backend-implement',
         'nsslapd-db-durable-transaction',
@@ -57,11 +57,17 @@ arg_to_attr = {
         'import_cache_autosize': 'nsslapd-import-cache-autosize',
         'cache_autosize': 'nsslapd-cache-autosize',
         'cache_autosize_split': 'nsslapd-cache-autosize-split',
+        'cache_autotune_interval': 'nsslapd-cache-autotune-interval',
+        'cache_warmup': 'nsslapd-cache-warmup',
+        'cache_warmup_interval': 'nsslapd-cache-warmup-interval',
+        'cache_warmup_threads': 'nsslapd-cache-warmup-threads',
+        'cache_warmup_rate': 'nsslapd-cache-warmup-rate',
         'import_cachesize': 'nsslapd-import-cachesize',
         'exclude_from_export': 'nsslapd-exclude-from-export',
         'pagedlookthroughlimit': 'nsslapd-pagedlookthroughlimit',
         'pagedidlistscanlimit': 'nsslapd-pagedidlistscanlimit',
         'rangelookthroughlimit': 'nsslapd-rangelookthroughlimit',
+        'search_readahead': 'nsslapd-search-readahead',
         'backend_opt_level': 'nsslapd-backend-opt-level',
         'deadlock_policy': 'nsslapd-db-deadlock-policy',
         'db_home_directory': 'nsslapd-db-home-directory',
@@ -1121,6 +1127,17 @@ def create_parser(subparsers):
     set_db_config_parser.add_argument('--rangelookthroughlimit', help='Specifies the maximum number of entries that the server '
                                                                       'will check when examining candidate entries in response to a '
                                                                       'range search request.')
+    set_db_config_parser.add_argument('--cache-autotune-interval', help='Sets the interval in seconds between two rebalancings of the entry and '
+                                                                        'DN caches when nsslapd-cache-autosize is set (0 disables it).')
+    set_db_config_parser.add_argument('--cache-warmup', help='Set to "on" to save the IDs of the cached entries and reload them '
+                                                             'in the entry cache after a restart (default "off")')
+    set_db_config_parser.add_argument('--cache-warmup-interval', help='Sets the interval in seconds between two saves of the cached '
+                                                                      'entry IDs (0 saves them only at shutdown)')
+    set_db_config_parser.add_argument('--cache-warmup-threads', help='Sets the number of threads per backend reloading the entries at startup')
+    set_db_config_parser.add_argument('--cache-warmup-rate', help='Sets the maximum number of entries reloaded per second per backend '
+                                                                  '(0 for no limit)')
+    set_db_config_parser.add_argument('--search-readahead', help='Sets the number of candidate entries that a search reads ahead '
+                                                                 'when it gets to an entry that is not in the entry cache (0 or 1 disables it).')
     set_db_config_parser.add_argument('--backend-opt-level', help='Sets the backend optimization level for write performance (0, 1, 2, or 4). '
                                                                   'WARNING: This parameter can trigger experimental code.')
     set_db_config_parser.add_argument('--deadlock-policy', help='Adjusts the backend database deadlock policy (Advanced setting)')
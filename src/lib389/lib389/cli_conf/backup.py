@@ -25,6 +25,14 @@ def backup_create(inst, basedn, log, args):
 
     if args.db_type is not None:
         task_properties['nsDatabaseType'] = args.db_type
+    if args.incremental is not None:
+        if args.compress:
+            raise ValueError("An incremental backup can not be compressed")
+        task_properties['nsArchiveIncrementalBase'] = args.incremental
+    if args.compact:
+        task_properties['nsArchiveCompact'] = 'on'
+    if args.compress:
+        task_properties['nsArchiveCompress'] = 'on'
 
     backup_task.create(properties=task_properties)
     if args.watch:
@@ -82,6 +90,12 @@ def create_parser(subparsers):
                                            "Default: /var/lib/dirsrv/slapd-instance/bak/ ")
     create_backup_parser.add_argument('-t', '--db-type', default="ldbm database",
                                       help="Sets the database type. Default: ldbm database")
+    create_backup_parser.add_argument('--incremental', metavar='BASE_ARCHIVE', default=None,
+                                      help="Only backs up the pages that changed since the BASE_ARCHIVE backup (lmdb only)")
+    create_backup_parser.add_argument('--compact', action='store_true',
+                                      help="Compacts the database copy, it can not be the base of an incremental backup (lmdb only)")
+    create_backup_parser.add_argument('--compress', action='store_true',
+                                      help="Compresses the database copy, not with --incremental (lmdb only)")
     create_backup_parser.add_argument('--timeout', type=int, default=120,
                                       help="Sets the task timeout.  Default is 120 seconds,")
     create_backup_parser.add_argument('--watch', action='store_true', help='Watch the status of the backup task')
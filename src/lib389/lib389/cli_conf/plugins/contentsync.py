@@ -15,6 +15,7 @@ arg_to_attr = {
     'allow_openldap': 'syncrepl-allow-openldap',
     'queue_max_size': 'syncrepl-queue-max-size',
     'max_concurrent': 'syncrepl-max-concurrent',
+    'change_index_size': 'syncrepl-change-index-size',
 }
 
 def check_queue_size(value):
@@ -43,6 +44,9 @@ def _add_parser_args(parser):
                         help='Limits the number of entries not yet processed (range [100, 100000])')
     parser.add_argument('--max-concurrent', type=str,
                         help='Limits the number of persistent searches running at the same time')
+    parser.add_argument('--change-index-size', type=str,
+                        help='Sets the number of recent changes kept in memory to serve the refresh '
+                             'of the clients, 0 disables the change index')
 
 def create_parser(subparsers):
     contentsync_parser = subparsers.add_parser('contentsync', help='Manage and configure Content Sync Plugin (aka syncrepl)', formatter_class=CustomHelpFormatter)
@@ -18,7 +18,8 @@ arg_to_attr = {
     'exclude_entry_scope': 'nsslapd-pluginExcludeEntryScope',
     'container_scope': 'nsslapd-pluginContainerScope',
     'config_entry': 'nsslapd-pluginConfigArea',
-    'log_file': 'referint-logfile'
+    'log_file': 'referint-logfile',
+    'batch_size': 'referint-batch-size'
 }
 
 
@@ -89,6 +90,9 @@ def _add_parser_args(parser):
     parser.add_argument('--log-file',
                         help='Specifies a path to the Referential integrity logfile.'
                              'For example: /var/log/dirsrv/slapd-YOUR_INSTANCE/referint')
+    parser.add_argument('--batch-size',
+                        help='Sets the maximum number of referencing entries updated in a single '
+                             'backend transaction when the update interval is not 0 (referint-batch-size)')
 
 
 def create_parser(subparsers):
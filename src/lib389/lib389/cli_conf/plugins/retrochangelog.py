@@ -19,6 +19,8 @@ arg_to_attr = {
     'trim_interval': 'nsslapd-changelog-trim-interval',
     'exclude_suffix': 'nsslapd-exclude-suffix',
     'exclude_attrs': 'nsslapd-exclude-attrs',
+    'storage': 'nsslapd-changelog-storage',
+    'segment_size': 'nsslapd-changelog-segment-size',
 }
 
 def retrochangelog_edit(inst, basedn, log, args):
@@ -63,6 +65,12 @@ def _add_parser_args(parser):
     parser.add_argument('--exclude-attrs', nargs='*',
                         help='Specifies the attributes which will be excluded from the scope of the plugin '
                              '(nsslapd-exclude-attrs)')
+    parser.add_argument('--storage', choices=['ldbm', 'log'], type=str.lower,
+                        help='Sets whether the changelog is kept in an LDBM database or in an append-only '
+                             'segmented log. Requires a restart (nsslapd-changelog-storage)')
+    parser.add_argument('--segment-size',
+                        help='Sets the size in bytes at which the segmented log starts a new segment '
+                             '(nsslapd-changelog-segment-size)')
 
 
 def create_parser(subparsers):
@@ -39,7 +39,8 @@ def dbtasks_db2index(inst, log, args):
 def dbtasks_db2bak(inst, log, args):
     # Needs an output name?
     inst.log = log
-    if not inst.db2bak(args.archive, watch=args.watch):
+    if not inst.db2bak(args.archive, watch=args.watch, incremental_base=args.incremental,
+                       compact=args.compact, compress=args.compress):
         log.fatal("db2bak failed")
         return False
     else:
@@ -520,6 +521,11 @@ def create_parser(subcommands):
     db2bak_parser = subcommands.add_parser('db2bak', help="Initialise a BDB backup of the database. The server must be stopped for this to proceed.", formatter_class=CustomHelpFormatter)
     db2bak_parser.add_argument('archive', help="The destination for the archive. This will be created during the db2bak process.",
                                nargs='?', default=None)
+    db2bak_parser.add_argument('--incremental', metavar='BASE_ARCHIVE', default=None,
+                               help="Only backs up the pages that changed since the BASE_ARCHIVE backup (lmdb only)")
+    db2bak_parser.add_argument('--compact', action='store_true',
+                               help="Compacts the database copy, it can not be the base of an incremental backup (lmdb only)")
+    db2bak_parser.add_argument('--compress', action='store_true', help="Compresses the database copy, not with --incremental (lmdb only)")
     db2bak_parser.add_argument('--watch', action='store_true', help='Watch the status of the db2bak task')
     db2bak_parser.set_defaults(func=dbtasks_db2bak)
 
@@ -51,10 +51,21 @@ HEADER_FIELDS = [
     ("ops_initiated", "Q"),
     ("ops_completed", "Q"),
     ("cur_connections", "Q"),
+    # 1.1
+    ("latency_phases", "I"),
+    ("latency_buckets", "I"),
 ]
 HEADER_FORMAT = "@" + "".join(fmt for _, fmt in HEADER_FIELDS)
 HEADER_NAMES = [name for name, _ in HEADER_FIELDS if name]
 
+# Mirror of tp_latency_hist_t: sum_ns then the buckets. The histograms
+# follow latency_buckets in the header, in slapd_latency_phase_t order.
+LATENCY_PHASE_NAMES = ["queue", "preop", "candidates", "fetch", "acl", "encode", "flush"]
+LATENCY_BUCKETS = 64
+LATENCY_MIN_SHIFT = 8
+LATENCY_OFFSET = struct.calcsize(HEADER_FORMAT)
+LATENCY_FORMAT = "@Q" + "Q" * LATENCY_BUCKETS
+
 # Byte-for-byte mirror of tp_worker_slot_t; the slot is padded to
 # TP_STATS_WORKER_SLOT_SIZE by its alignment.
 WORKER_FIELDS = [
@@ -207,6 +218,45 @@ def _unpack_header(mm):
     return header
 
 
+def _latency_bucket_bound(idx):
+    """Upper bound in nanoseconds of a bucket of tp_latency_hist_t"""
+    if idx == 0:
+        return 1 << LATENCY_MIN_SHIFT
+    e = LATENCY_MIN_SHIFT + (idx - 1) // 2
+    return (3 + (idx - 1) % 2) << (e - 1)
+
+
+def _latency_percentile(buckets, count, percent):
+    rank = (count * percent + 99) // 100
+    seen = 0
+    for idx, value in enumerate(buckets):
+        seen += value
+        if seen >= rank:
+            return _latency_bucket_bound(idx)
+    return _latency_bucket_bound(len(buckets) - 1)
+
+
+def _unpack_latency(mm, header):
+    """Phase latency histograms, empty for a version 1.0 file"""
+    latency = {}
+    if (header["ver_minor"] < 1 or
+            header["latency_phases"] != len(LATENCY_PHASE_NAMES) or
+            header["latency_buckets"] != LATENCY_BUCKETS):
+        return latency
+    size = struct.calcsize(LATENCY_FORMAT)
+    for idx, name in enumerate(LATENCY_PHASE_NAMES):
+        values = struct.unpack_from(LATENCY_FORMAT, mm, LATENCY_OFFSET + idx * size)
+        sum_ns, buckets = values[0], values[1:]
+        count = sum(buckets)
+        phase = {"count": count, "sum_ns": sum_ns}
+        if count:
+            phase["mean_ns"] = sum_ns // count
+            for percent in (50, 90, 99):
+                phase[f"p{percent}_ns"] = _latency_percentile(buckets, count, percent)
+        latency[name] = phase
+    return latency
+
+
 def _state_name(state):
     return STATE_NAMES.get(state, f"unknown-{state}")
 
@@ -331,6 +381,7 @@ def _read_threadpool_status(inst, file_path=None):
                 )
 
             workers = _unpack_workers(mm, header, now_ns)
+            latency = _unpack_latency(mm, header)
     finally:
         os.close(fd)
 
@@ -373,6 +424,7 @@ def _read_threadpool_status(inst, file_path=None):
             "cur_connections": header["cur_connections"],
         },
         "workers": workers,
+        "latency": latency,
         "warnings": warnings,
     }
 
@@ -392,6 +444,14 @@ def _format_duration_ns(duration_ns):
     return f"{seconds:.3f}s"
 
 
+def _format_latency_ns(value):
+    if value < 1000:
+        return f"{value}ns"
+    if value < 1000_000:
+        return f"{value / 1000:.1f}us"
+    return _format_duration_ns(value)
+
+
 def _format_optional(value):
     return "-" if value is None else str(value)
 
@@ -425,6 +485,22 @@ def _emit_text(log, status):
         for warning in status["warnings"]:
             log.info(f"  - {warning}")
 
+    if status["latency"]:
+        log.info("")
+        log.info(f"{'PHASE':<12} {'COUNT':>12} {'MEAN':>12} {'P50':>12} {'P90':>12} {'P99':>12}")
+        for name, phase in status["latency"].items():
+            if phase["count"] == 0:
+                log.info(f"{name:<12} {0:>12} {'-':>12} {'-':>12} {'-':>12} {'-':>12}")
+                continue
+            log.info(
+                f"{name:<12} "
+                f"{phase['count']:>12} "
+                f"{_format_latency_ns(phase['mean_ns']):>12} "
+                f"{_format_latency_ns(phase['p50_ns']):>12} "
+                f"{_format_latency_ns(phase['p90_ns']):>12} "
+                f"{_format_latency_ns(phase['p99_ns']):>12}"
+            )
+
     log.info("")
     log.info(f"{'IDX':>5} {'STATE':<8} {'OP':<10} {'CONN':>12} {'OP-ID':>12} {'DURATION':>12}")
     for worker in status["workers"]:
@@ -75,6 +75,23 @@ class Monitor(DSLdapObject):
         """
         return self.get_attr_vals_utf8('threadpoolworker')
 
+    def get_phase_latency(self):
+        """Get the latency histograms summary of the operation phases from cn=monitor
+
+        :returns: Values of phaselatency attribute of cn=monitor
+        """
+        return self.get_attr_vals_utf8('phaselatency')
+
+    def get_event_queue(self):
+        """Get event queue related attributes value for cn=monitor
+
+        :returns: Values of eventqevents, eventqlateness and eventqmaxlatenessms attributes of cn=monitor
+        """
+        eventqevents = self.get_attr_vals_utf8('eventqevents')
+        eventqlateness = self.get_attr_vals_utf8('eventqlateness')
+        eventqmaxlatenessms = self.get_attr_vals_utf8('eventqmaxlatenessms')
+        return (eventqevents, eventqlateness, eventqmaxlatenessms)
+
     def get_backends(self):
         """Get backends related attributes value for cn=monitor
 
@@ -367,6 +384,9 @@ class MonitorDatabase(DSLdapObject):
                 'commitrotxn',
                 'granttimerotxn',
                 'lifetimerotxn',
+                'renewrotxn',
+                'oldestrotxnage',
+                'oldrotxn',
            ]
 
 
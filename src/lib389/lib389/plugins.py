@@ -564,6 +564,21 @@ class ReferentialIntegrityPlugin(Plugin):
 
         self.set('referint-logfile', value)
 
+    def get_batch_size(self):
+        """Get referint-batch-size attribute"""
+
+        return self.get_attr_val_int('referint-batch-size')
+
+    def get_batch_size_formatted(self):
+        """Display referint-batch-size attribute"""
+
+        return self.display_attr('referint-batch-size')
+
+    def set_batch_size(self, value):
+        """Set referint-batch-size attribute"""
+
+        self.set('referint-batch-size', str(value))
+
     def get_membership_attr(self, formatted=False):
         """Get referint-membership-attr attribute"""
 
@@ -300,6 +300,20 @@ class DBCompactTask(Task):
         super(DBCompactTask, self).__init__(instance, dn)
 
 
+class DBVerifyTask(Task):
+    """A single instance of online dbverify task entry
+
+    :param instance: An instance
+    :type instance: lib389.DirSrv
+    """
+
+    def __init__(self, instance, dn=None):
+        self.cn = 'dbverify_' + Task.get_timestamp()
+        dn = "cn=" + self.cn + ",cn=dbverify," + DN_TASKS
+        super(DBVerifyTask, self).__init__(instance, dn)
+        self._must_attributes.extend(['nsInstance'])
+
+
 class SchemaReloadTask(Task):
     """A single instance of schema reload task entry
 
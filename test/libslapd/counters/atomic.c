@@ -7,6 +7,7 @@
  * END COPYRIGHT BLOCK **/
 
 #include "../../test_slapd.h"
+#include <pthread.h>
 
 void
 test_libslapd_counters_atomic_usage(void **state __attribute__((unused)))
@@ -67,3 +68,46 @@ test_libslapd_counters_atomic_overflow(void **state __attribute__((unused)))
 
     slapi_counter_destroy(&tc);
 }
+
+static void *
+counters_sharded_worker(void *arg)
+{
+    Slapi_Counter *tc = arg;
+
+    for (size_t i = 0; i < 10000; i++) {
+        slapi_counter_increment(tc);
+        slapi_counter_add(tc, 2);
+        slapi_counter_decrement(tc);
+    }
+    return NULL;
+}
+
+void
+test_libslapd_counters_sharded_usage(void **state __attribute__((unused)))
+{
+    Slapi_Counter *tc = slapi_counter_new_sharded();
+    pthread_t threads[8];
+    uint64_t value = 0;
+
+    value = slapi_counter_get_value(tc);
+    assert_true(value == 0);
+    /* The threads may run on any cpu, the total is the sum of the shards */
+    for (size_t i = 0; i < 8; i++) {
+        assert_int_equal(pthread_create(&threads[i], NULL, counters_sharded_worker, tc), 0);
+    }
+    for (size_t i = 0; i < 8; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    value = slapi_counter_get_value(tc);
+    assert_true(value == 8 * 10000 * 2);
+    /* set resets the shards */
+    slapi_counter_set_value(tc, 5);
+    value = slapi_counter_get_value(tc);
+    assert_true(value == 5);
+    /* a decrement on another cpu than the increments does not wrap the total */
+    slapi_counter_subtract(tc, 5);
+    value = slapi_counter_get_value(tc);
+    assert_true(value == 0);
+
+    slapi_counter_destroy(&tc);
+}
@@ -0,0 +1,56 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#include "../../test_slapd.h"
+
+/* To access the substring matcher */
+#include <slapi-private.h>
+
+static int32_t
+substr_test(const char *initial, char **any, const char *final, const char *value)
+{
+    Slapi_SubstrMatcher *sm = slapi_substr_matcher_new(initial, any, final, 0);
+    int32_t rc = slapi_substr_matcher_exec(sm, value, strlen(value));
+    slapi_substr_matcher_free(&sm);
+    assert_null(sm);
+    return rc;
+}
+
+void
+test_libslapd_filter_substr(void **state __attribute__((unused)))
+{
+    char *any_b[] = {"b", NULL};
+    char *any_bc[] = {"b", "c", NULL};
+    char *any_re[] = {".*", NULL};
+
+    /* (attr=a*) */
+    assert_int_equal(substr_test("a", NULL, NULL, "abc"), 1);
+    assert_int_equal(substr_test("a", NULL, NULL, "bac"), 0);
+    assert_int_equal(substr_test("abcd", NULL, NULL, "abc"), 0);
+    /* (attr=*c) */
+    assert_int_equal(substr_test(NULL, NULL, "c", "abc"), 1);
+    assert_int_equal(substr_test(NULL, NULL, "c", "acb"), 0);
+    /* (attr=a*c), the components can not overlap */
+    assert_int_equal(substr_test("a", NULL, "c", "ac"), 1);
+    assert_int_equal(substr_test("ab", NULL, "bc", "abc"), 0);
+    /* (attr=*b*c*), in order */
+    assert_int_equal(substr_test(NULL, any_bc, NULL, "abxc"), 1);
+    assert_int_equal(substr_test(NULL, any_bc, NULL, "acxb"), 0);
+    assert_int_equal(substr_test("a", any_b, "c", "abbc"), 1);
+    assert_int_equal(substr_test("a", any_b, "c", "abc"), 1);
+    assert_int_equal(substr_test("a", any_b, "c", "ac"), 0);
+    /* the components are literals */
+    assert_int_equal(substr_test(NULL, any_re, NULL, "a.*b"), 1);
+    assert_int_equal(substr_test(NULL, any_re, NULL, "ab"), 0);
+    /* like the regex it replaces, a match can not span a newline... */
+    assert_int_equal(substr_test("a", NULL, "c", "a\nc"), 0);
+    assert_int_equal(substr_test(NULL, any_bc, NULL, "b\nbc"), 1);
+    assert_int_equal(substr_test(NULL, any_bc, NULL, "b\nc"), 0);
+    /* ... and final may be followed by a newline */
+    assert_int_equal(substr_test(NULL, NULL, "c", "abc\n"), 1);
+}
@@ -0,0 +1,89 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#include "../../test_slapd.h"
+
+#include <slap.h>
+#include <proto-slap.h>
+#include <string.h>
+
+static void
+valueset_add_strings(Slapi_ValueSet *vs, const char **strs)
+{
+    for (size_t i = 0; strs[i]; i++) {
+        Slapi_Value *v = slapi_value_new_string(strs[i]);
+        slapi_valueset_add_value(vs, v);
+        slapi_value_free(&v);
+    }
+}
+
+void
+test_libslapd_valueset_share(void **state __attribute__((unused)))
+{
+    const char *strs[] = {"one", "two", "three", NULL};
+    Slapi_ValueSet *vs1 = slapi_valueset_new();
+    Slapi_ValueSet *vs2 = slapi_valueset_new();
+    Slapi_ValueSet *vs3 = slapi_valueset_new();
+    Slapi_Value *v1 = NULL;
+    Slapi_Value *v2 = NULL;
+    Slapi_Value *four = slapi_value_new_string("four");
+
+    valueset_add_strings(vs1, strs);
+    valueset_share(vs2, vs1);
+    valueset_share(vs3, vs1);
+    /* The values are not copied */
+    assert_ptr_equal(valueset_get_valuearray(vs1), valueset_get_valuearray(vs2));
+    assert_int_equal(slapi_valueset_count(vs2), 3);
+    assert_non_null(vs1->shared);
+    assert_int_equal(*vs1->shared, 3);
+
+    /* Adding a value copies them */
+    slapi_valueset_add_value(vs2, four);
+    assert_ptr_not_equal(valueset_get_valuearray(vs1), valueset_get_valuearray(vs2));
+    assert_null(vs2->shared);
+    assert_int_equal(*vs1->shared, 2);
+    assert_int_equal(slapi_valueset_count(vs1), 3);
+    assert_int_equal(slapi_valueset_count(vs2), 4);
+    slapi_valueset_first_value(vs1, &v1);
+    slapi_valueset_first_value(vs2, &v2);
+    assert_ptr_not_equal(v1, v2);
+    assert_string_equal(slapi_value_get_string(v1), slapi_value_get_string(v2));
+
+    /* The values are kept until the last valueset sharing them is freed */
+    slapi_valueset_free(vs1);
+    assert_int_equal(*vs3->shared, 1);
+    slapi_valueset_first_value(vs3, &v1);
+    assert_string_equal(slapi_value_get_string(v1), "one");
+
+    /* The last one takes them over without a copy */
+    v2 = valueset_get_valuearray(vs3)[0];
+    slapi_valueset_add_value(vs3, four);
+    assert_null(vs3->shared);
+    assert_ptr_equal(valueset_get_valuearray(vs3)[0], v2);
+    assert_int_equal(slapi_valueset_count(vs3), 4);
+
+    slapi_valueset_free(vs2);
+    slapi_valueset_free(vs3);
+    slapi_value_free(&four);
+}
+
+void
+test_libslapd_valueset_share_empty(void **state __attribute__((unused)))
+{
+    Slapi_ValueSet *vs1 = slapi_valueset_new();
+    Slapi_ValueSet *vs2 = slapi_valueset_new();
+
+    /* An empty valueset is not shared */
+    valueset_share(vs2, vs1);
+    assert_null(vs1->shared);
+    assert_null(vs2->shared);
+    assert_true(slapi_valueset_isempty(vs2));
+
+    slapi_valueset_free(vs1);
+    slapi_valueset_free(vs2);
+}
@@ -30,6 +30,9 @@ void test_libslapd_hello(void **state);
 /* libslapd-filter-optimise */
 void test_libslapd_filter_optimise(void **state);
 
+/* libslapd-filter-substr */
+void test_libslapd_filter_substr(void **state);
+
 /* libslapd-pblock-analytics */
 void test_libslapd_pblock_analytics(void **state);
 
@@ -49,6 +52,12 @@ void test_libslapd_operation_v3c_target_spec(void **state);
 
 void test_libslapd_counters_atomic_usage(void **state);
 void test_libslapd_counters_atomic_overflow(void **state);
+void test_libslapd_counters_sharded_usage(void **state);
+
+/* libslapd-valueset-share */
+
+void test_libslapd_valueset_share(void **state);
+void test_libslapd_valueset_share_empty(void **state);
 
 /* libslapd-pal-meminfo */
 